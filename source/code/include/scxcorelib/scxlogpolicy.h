@@ -78,6 +78,16 @@ namespace SCXCoreLib
         {
             return eInfo;
         }
+
+        /**
+            Get the number of log items that may wait to be written by a
+            separate writer thread.
+            \returns Queue size, or 0 to write log items on the logging thread.
+        */
+        virtual size_t GetLogQueueSize() const
+        {
+            return 0;
+        }
     };
 }
 
@@ -0,0 +1,120 @@
+/*--------------------------------------------------------------------------------
+    Copyright (c) Microsoft Corporation. All rights reserved. See license.txt for license information.
+
+*/
+/**
+    \file
+
+    \brief       Defines the public interface for the shared sampling scheduler.
+
+    \date        2026-10-16 09:00:00
+
+*/
+/*----------------------------------------------------------------------------*/
+
+#ifndef SCXSAMPLESCHEDULER_H
+#define SCXSAMPLESCHEDULER_H
+
+#include <scxcorelib/scxcmn.h>
+#include <scxcorelib/scxcondition.h>
+#include <scxcorelib/scxhandle.h>
+#include <scxcorelib/scxlog.h>
+#include <scxcorelib/scxsingleton.h>
+#include <scxcorelib/scxthread.h>
+
+#include <map>
+#include <vector>
+
+namespace SCXCoreLib
+{
+    /*----------------------------------------------------------------------------*/
+    /**
+        Runs periodic sampling callbacks from a single shared thread.
+
+        Rather than have every enumeration own a thread that sleeps between
+        samples, samplers register a callback and a period here. The scheduler
+        keeps the next deadline of each sampler in a min-heap and sleeps until
+        the earliest one. Deadlines are aligned on multiples of the period, so
+        samplers with equal (or dividing) periods are serviced by the same wakeup.
+
+        A callback is run once immediately after registration and then once per
+        period. If a callback sets the terminate flag on its parameter, the
+        sampler is dropped. Exceptions thrown by a callback are logged and do
+        not stop further sampling.
+
+        The worker thread is started with the first registration and exits when
+        the last sampler is unregistered.
+    */
+    class SCXSampleScheduler : public SCXSingleton<SCXSampleScheduler>
+    {
+        friend class SCXSingleton<SCXSampleScheduler>;
+
+    public:
+        /** Identifies a registered sampler; zero is never a valid id. */
+        typedef scxulong SamplerId;
+
+        SCXSampleScheduler();
+        virtual ~SCXSampleScheduler();
+        const std::wstring DumpString() const;
+
+        SamplerId Register(SCXThreadProc proc, SCXThreadParamHandle param, scxulong periodMs);
+        void Unregister(SamplerId id);
+
+        size_t GetSamplerCount() const;
+        scxulong GetWakeupCount() const;
+        scxulong GetSampleCount() const;
+
+    protected:
+        virtual scxulong GetTime() const;
+        void ClockChanged();
+
+    private:
+        // Do not allow copying
+        SCXSampleScheduler(const SCXSampleScheduler &);             //!< Intentionally not implemented
+        SCXSampleScheduler & operator=(const SCXSampleScheduler &); //!< Intentionally not implemented
+
+        /** A registered sampler. */
+        struct Sampler
+        {
+            SCXThreadProc proc;             //!< Callback to run
+            SCXThreadParamHandle param;     //!< Parameter passed to the callback
+            scxulong periodMs;              //!< Time between samples in milliseconds
+        };
+
+        /** Heap entry; ordered so that std::*_heap keeps the earliest deadline first. */
+        struct Deadline
+        {
+            scxulong when;                  //!< Absolute deadline in milliseconds
+            SamplerId id;                   //!< Sampler the deadline belongs to
+
+            bool operator<(const Deadline& other) const
+            {
+                return when > other.when || (when == other.when && id > other.id);
+            }
+        };
+
+        static void SchedulerThreadBody(SCXThreadParamHandle& param);
+        void DoSchedulerThread();
+        void PushDeadline(SamplerId id, scxulong when);
+
+        SCXLogHandle m_log;                         //!< Log handle
+        mutable SCXCondition m_cond;                //!< Protects all members below and drives the sleeps
+        std::map<SamplerId, Sampler> m_samplers;    //!< Registered samplers
+        std::vector<Deadline> m_deadlines;          //!< Min-heap of pending deadlines (may hold stale entries)
+        SCXHandle<SCXThread> m_thread;              //!< The scheduler thread
+        SCXThreadId m_threadId;                     //!< Id of the scheduler thread while it runs
+        SamplerId m_nextId;                         //!< Id handed to the next registration
+        SamplerId m_runningId;                      //!< Sampler whose callback is executing (0 if none)
+        scxulong m_wakeupCount;                     //!< Number of times due samplers were serviced
+        scxulong m_sampleCount;                     //!< Number of callbacks run
+        bool m_isRunning;                           //!< Is the scheduler thread running?
+        bool m_isTerminating;                       //!< Scheduler thread asked to stop?
+    };
+
+    SCXSingleton_Define(SCXSampleScheduler);
+} /* namespace SCXCoreLib */
+
+#include <scxcorelib/scxsingleton-defs.h>
+
+#endif /* SCXSAMPLESCHEDULER_H */
+/*----------------------------E-N-D---O-F---F-I-L-E---------------------------*/
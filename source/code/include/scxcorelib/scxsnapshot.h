@@ -0,0 +1,112 @@
+/*--------------------------------------------------------------------------------
+    Copyright (c) Microsoft Corporation. All rights reserved. See license.txt for license information.
+
+*/
+/**
+    \file
+
+    \brief       Publication of immutable snapshots between a producer and readers.
+
+    \date        2026-10-16 15:00:00
+
+*/
+/*----------------------------------------------------------------------------*/
+#ifndef SCXSNAPSHOT_H
+#define SCXSNAPSHOT_H
+
+#include <scxcorelib/scxcmn.h>
+#include <scxcorelib/scxhandle.h>
+#include <scxcorelib/scxthreadlock.h>
+
+namespace SCXCoreLib
+{
+    /*----------------------------------------------------------------------------*/
+    /**
+        Holds the most recently published snapshot of some data.
+
+        A producer (typically a sampler thread) builds a complete new snapshot
+        without holding any lock and then publishes it. Readers get a handle to
+        the current snapshot and may keep using it for as long as they like; a
+        snapshot is freed when the last handle referring to it goes away.
+
+        The only lock involved is held while the snapshot handle is copied or
+        replaced, so neither side ever waits for the other to read a file or
+        compute values. A plain pointer swap is not enough here since the
+        reference count of SCXHandle is separate from the pointer itself.
+
+        \note T should be a const type (like SCXSnapshot<const MyData>) since a
+              snapshot must never be modified once it has been published.
+    */
+    template<class T>
+    class SCXSnapshot
+    {
+    public:
+        /*----------------------------------------------------------------------------*/
+        /**
+            Default constructor. No snapshot is published.
+        */
+        SCXSnapshot() :
+            m_lock(ThreadLockHandleGet()),
+            m_current(0),
+            m_generation(0)
+        {
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+            Make a new snapshot current.
+
+            \param[in] snapshot New snapshot.
+
+            Any previous snapshot is released after the lock is dropped, so a
+            destructor running on the last reference does not hold up readers.
+        */
+        void Publish(SCXHandle<T> snapshot)
+        {
+            SCXHandle<T> previous(0);
+            {
+                SCXThreadLock lock(m_lock);
+                previous = m_current;
+                m_current = snapshot;
+                ++m_generation;
+            }
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+            Get the current snapshot.
+
+            \returns   Handle to the current snapshot, NULL if nothing is published.
+        */
+        SCXHandle<T> Get() const
+        {
+            SCXThreadLock lock(m_lock);
+            return m_current;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+            Get the number of times a snapshot has been published.
+
+            \returns   Publication count; readers may use it to detect new data.
+        */
+        scxulong GetGeneration() const
+        {
+            SCXThreadLock lock(m_lock);
+            return m_generation;
+        }
+
+    private:
+        //! Prevent copying since the lock handle would be shared.
+        SCXSnapshot(const SCXSnapshot&);
+        //! Prevent assignment since the lock handle would be shared.
+        SCXSnapshot& operator=(const SCXSnapshot&);
+
+        SCXThreadLockHandle m_lock;     //!< Guards the handle below (not the snapshot).
+        SCXHandle<T> m_current;         //!< Current snapshot.
+        scxulong m_generation;          //!< Number of snapshots published.
+    };
+}
+
+#endif /* SCXSNAPSHOT_H */
+/*----------------------------E-N-D---O-F---F-I-L-E---------------------------*/
@@ -19,7 +19,9 @@
 #include <scxcorelib/scxhandle.h>
 #include <scxcorelib/scxlog.h>
 #include <scxcorelib/scxthread.h>
+#include <scxcorelib/scxthreadlock.h>
 
+#include <deque>
 #include <vector>
 
 
@@ -41,11 +43,13 @@ namespace SCXCoreLib
         /**
            Constructor
 
-           \param[in] spTask Safe Pointer to a Task Object to be passed to the thread
+           \param[in] p           Thread pool that the worker thread belongs to
+           \param[in] queueIndex  Worker queue owned by the thread (work stealing mode)
         */
-        SCXThreadPoolThreadParam(SCXThreadPool* p)
+        SCXThreadPoolThreadParam(SCXThreadPool* p, size_t queueIndex = 0)
             : SCXCoreLib::SCXThreadParam(),
-              m_pThreadPool(p)
+              m_pThreadPool(p),
+              m_queueIndex(queueIndex)
         {
         }
 
@@ -58,9 +62,11 @@ namespace SCXCoreLib
         }
 
         SCXThreadPool* GetThreadPool() { return m_pThreadPool; }
+        size_t GetQueueIndex() const { return m_queueIndex; }
 
     private:
         class SCXThreadPool* m_pThreadPool;     //!< Pointer to our thread pool object
+        size_t m_queueIndex;                    //!< Index of the worker queue owned by the thread
     };
 
     /*----------------------------------------------------------------------------*/
@@ -71,16 +77,39 @@ namespace SCXCoreLib
     public:
         SCXThreadPoolTask(SCXThreadProc proc, SCXThreadParamHandle& param)
             : m_proc(proc),
-              m_param(param)
+              m_param(param),
+              m_queuedTime(0)
         {
         }
     private:
         SCXThreadProc m_proc;
         SCXThreadParamHandle m_param;
+        scxulong m_queuedTime;          //!< When the task was queued (microseconds)
 
         friend class SCXThreadPool;
     };
 
+    /*----------------------------------------------------------------------------*/
+    /**
+      Queue statistics of a thread pool
+    */
+    struct SCXThreadPoolStatistics
+    {
+        SCXThreadPoolStatistics()
+            : queueDepth(0), maxQueueDepth(0), tasksQueued(0), tasksStarted(0),
+              tasksStolen(0), totalWaitTime(0), maxWaitTime(0)
+        {
+        }
+
+        scxulong queueDepth;            //!< Tasks currently waiting to run
+        scxulong maxQueueDepth;         //!< Most tasks ever waiting in one queue
+        scxulong tasksQueued;           //!< Tasks queued since start
+        scxulong tasksStarted;          //!< Tasks taken off a queue to run since start
+        scxulong tasksStolen;           //!< Tasks taken from the queue of another worker
+        scxulong totalWaitTime;         //!< Sum of the time tasks waited in a queue (microseconds)
+        scxulong maxWaitTime;           //!< Longest time a task waited in a queue (microseconds)
+    };
+
     /*----------------------------------------------------------------------------*/
     /**
       Dependency class for SCXThreadPool
@@ -107,6 +136,13 @@ namespace SCXCoreLib
     */
     class SCXThreadPool
     {
+    public:
+        /** How queued tasks are handed to worker threads. */
+        enum SchedulerMode {
+            eSharedQueue,       //!< One queue shared by all workers, protected by the pool condition
+            eWorkStealing       //!< One queue per worker; idle workers steal from the others
+        };
+
     private:
         // Do not allow copying
         SCXThreadPool(const SCXThreadPool &);           //!< Intentionally not implemented
@@ -114,23 +150,43 @@ namespace SCXCoreLib
 
         void StartWorkerThread();
 
+        /** A worker queue in work stealing mode. */
+        struct WorkerQueue
+        {
+            WorkerQueue() : m_lock(ThreadLockHandleGet()) {}
+
+            SCXThreadLockHandle m_lock;                     //!< Protects the members below
+            std::deque<SCXThreadPoolTaskHandle> m_tasks;    //!< Tasks waiting to run
+            SCXThreadPoolStatistics m_stats;                //!< Statistics of this queue
+        };
+
     protected:
         SCXHandle<SCXThreadPoolDependencies> m_deps;    //!< Dependency class object
         std::vector<SCXThreadHandle> m_hThreads;        //!< Handles of threads in the pool
-        std::vector<SCXThreadPoolTaskHandle> m_tasks;   //!< Queue of tasks that we need to run
+        std::deque<SCXThreadPoolTaskHandle> m_tasks;    //!< Queue of tasks that we need to run (shared queue mode)
+        SCXThreadPoolStatistics m_stats;                //!< Statistics of m_tasks (shared queue mode)
+        std::vector<SCXHandle<WorkerQueue> > m_queues;  //!< Worker queues (work stealing mode)
 
-        SCXCondition m_cond;                            //!< Queue / worker thread management
+        mutable SCXCondition m_cond;                    //!< Queue / worker thread management
         SCXLogHandle m_logHandle;                       //!< SCX log handle
         SCXThreadAttr m_threadAttr;                     //!< Thread attributes for worker threads
         scx_atomic_t m_threadCount;                     //!< Number of threads currently running
         long m_threadLimit;                             //!< Limit to number of threads allowed
-        long m_threadBusyCount;                         //!< Number of worker threads currently busy
+        scx_atomic_t m_threadBusyCount;                 //!< Number of worker threads currently busy
+        scx_atomic_t m_pendingCount;                    //!< Tasks waiting in worker queues (work stealing mode)
+        scx_atomic_t m_idleCount;                       //!< Workers waiting for tasks (work stealing mode)
+        scx_atomic_t m_nextQueue;                       //!< Worker queue that receives the next task (work stealing mode)
+        SchedulerMode m_mode;                           //!< How tasks are handed to worker threads
         bool m_isRunning;                               //!< Is thread pool running (Start() called)?
         bool m_isTerminating;                           //!< Workers triggered to shut down?
 
     protected:
         static void StartWorkerThreadStub(SCXCoreLib::SCXThreadParamHandle& handle);
         void DoWorkerThread(SCXThreadPoolThreadParam* params);
+        void DoWorkStealingWorkerThread(SCXThreadPoolThreadParam* params);
+        void RunTask(SCXThreadPoolTaskHandle& task);
+        bool TakeTask(size_t queueIndex, SCXThreadPoolTaskHandle& task);
+        void EnqueueWorkStealing(const SCXThreadPoolTaskHandle* tasks, size_t count);
 
     public:
         explicit SCXThreadPool( SCXHandle<SCXThreadPoolDependencies> = SCXHandle<SCXThreadPoolDependencies>(new SCXThreadPoolDependencies()) );
@@ -168,7 +224,19 @@ namespace SCXCoreLib
         bool isRunning() { return m_isRunning && (m_threadCount >= 1); }
 
         void SetThreadLimit(long limit);
+        void SetSchedulerMode(SchedulerMode mode);
+
+        /*-----------------------------------------------------------------------*/
+        /**
+           Get the scheduler mode of the thread pool
+
+           \returns     how queued tasks are handed to worker threads
+        */
+        SchedulerMode GetSchedulerMode() const { return m_mode; }
+
         void QueueTask(SCXThreadPoolTaskHandle task);
+        void QueueTasks(const std::vector<SCXThreadPoolTaskHandle>& tasks);
+        SCXThreadPoolStatistics GetStatistics() const;
 
         void Start();
         void Shutdown();
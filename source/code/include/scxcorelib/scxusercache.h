@@ -0,0 +1,110 @@
+/*--------------------------------------------------------------------------------
+    Copyright (c) Microsoft Corporation. All rights reserved. See license.txt for license information.
+
+*/
+/**
+    \file
+
+    \brief       Defines the public interface for the user and group name cache.
+
+    \date        2026-10-16 16:00:00
+
+*/
+/*----------------------------------------------------------------------------*/
+
+#ifndef SCXUSERCACHE_H
+#define SCXUSERCACHE_H
+
+#include <scxcorelib/scxcmn.h>
+#include <scxcorelib/scxsingleton.h>
+#include <scxcorelib/scxthreadlock.h>
+#include <scxcorelib/scxuser.h>
+
+#include <map>
+#include <string>
+#include <time.h>
+
+namespace SCXCoreLib
+{
+    /** Default number of seconds a resolved name is kept. */
+    const scxulong USERCACHE_DEFAULT_TTL = 300;
+
+    /** Default number of seconds a failed lookup is kept. */
+    const scxulong USERCACHE_DEFAULT_NEGATIVE_TTL = 60;
+
+    /** Number of entries (per map) at which expired entries are pruned. */
+    const size_t USERCACHE_MAX_ENTRIES = 4096;
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Caches the results of user id and group id to name lookups.
+
+        Resolving a name through the passwd or group database may mean talking
+        to a directory service, which is slow compared to the few hundred
+        distinct ids found among the processes of even a large system. Each
+        lookup result is kept for a while; failed lookups are also kept (for a
+        shorter time) so that ids without a name are not looked up over and
+        over.
+
+        Lookups in the databases are done without holding the cache lock, so a
+        slow directory service never holds up callers asking for cached ids.
+    */
+    class SCXUserCache : public SCXSingleton<SCXUserCache>
+    {
+        friend class SCXSingleton<SCXUserCache>;
+
+    public:
+        SCXUserCache();
+        virtual ~SCXUserCache();
+        const std::wstring DumpString() const;
+
+        bool GetUserName(SCXUserID uid, std::wstring& name);
+        bool GetGroupName(SCXGroupID gid, std::wstring& name);
+
+        void SetTimeToLive(scxulong seconds, scxulong negativeSeconds);
+        void Clear();
+
+        scxulong GetHitCount() const;
+        scxulong GetMissCount() const;
+
+    protected:
+        virtual bool LookupUserName(SCXUserID uid, std::wstring& name);
+        virtual bool LookupGroupName(SCXGroupID gid, std::wstring& name);
+        virtual time_t GetTime() const;
+
+    private:
+        // Do not allow copying
+        SCXUserCache(const SCXUserCache &);             //!< Intentionally not implemented
+        SCXUserCache & operator=(const SCXUserCache &); //!< Intentionally not implemented
+
+        /** A cached lookup result. */
+        struct Entry
+        {
+            std::wstring name;      //!< Resolved name (empty if not found)
+            bool found;             //!< Was the id found?
+            time_t fetched;         //!< When the lookup was made
+        };
+
+        /** Cached results, keyed by id. */
+        typedef std::map<scxulong, Entry> EntryMap;
+
+        bool GetName(EntryMap& entries, scxulong id, bool isUser, std::wstring& name);
+        bool IsExpired(const Entry& entry, time_t now) const;
+        void Prune(EntryMap& entries, time_t now);
+
+        SCXThreadLockHandle m_lock;     //!< Protects all members below
+        EntryMap m_users;               //!< Cached user names
+        EntryMap m_groups;              //!< Cached group names
+        scxulong m_ttl;                 //!< Seconds a resolved name is kept
+        scxulong m_negativeTtl;         //!< Seconds a failed lookup is kept
+        scxulong m_hitCount;            //!< Number of requests answered from the cache
+        scxulong m_missCount;           //!< Number of requests that needed a lookup
+    };
+
+    SCXSingleton_Define(SCXUserCache);
+} /* namespace SCXCoreLib */
+
+#include <scxcorelib/scxsingleton-defs.h>
+
+#endif /* SCXUSERCACHE_H */
+/*----------------------------E-N-D---O-F---F-I-L-E---------------------------*/
@@ -0,0 +1,45 @@
+/*--------------------------------------------------------------------------------
+    Copyright (c) Microsoft Corporation. All rights reserved. See license.txt for license information.
+
+*/
+/**
+    \file
+
+    \brief       Buffer based UTF-8 transcoding, with vectorized runs of ASCII
+
+    \date        2026-10-17 03:00:00
+
+*/
+/*----------------------------------------------------------------------------*/
+#ifndef SCXUTF8_H
+#define SCXUTF8_H
+
+#include <string>
+
+namespace SCXCoreLib
+{
+    /*----------------------------------------------------------------------------*/
+    /**
+        Instruction sets that runs of ASCII may be transcoded with.
+
+        The best one the processor supports is picked the first time a string
+        is transcoded. Only x86-64 builds with a compiler that can target
+        AVX2 have anything but eUTF8Scalar.
+    */
+    enum UTF8SimdLevel
+    {
+        eUTF8Scalar = 0,    //!< One character at a time
+        eUTF8SSE2,          //!< 16 characters at a time
+        eUTF8AVX2           //!< 32 characters at a time
+    };
+
+    bool UTF8Decode(const char* data, size_t size, std::wstring& result);
+    bool UTF8Encode(const wchar_t* data, size_t size, std::string& result);
+
+    UTF8SimdLevel GetUTF8SimdLevel();
+    UTF8SimdLevel GetUTF8SupportedSimdLevel();
+    UTF8SimdLevel SetUTF8SimdLevel(UTF8SimdLevel level);
+}
+
+#endif /* SCXUTF8_H */
+/*----------------------------E-N-D---O-F---F-I-L-E---------------------------*/
@@ -0,0 +1,268 @@
+/*--------------------------------------------------------------------------------
+    Copyright (c) Microsoft Corporation. All rights reserved. See license.txt for license information.
+
+*/
+/**
+    \file
+
+    \brief       Tokenizing and number parsing over buffers owned by the caller
+
+    \date        2026-10-17 04:00:00
+
+    StrTokenize() builds a std::wstring for every token. The classes here
+    instead hand out spans, pointer and length pairs into the string being
+    tokenized, so lines can be split and their numbers parsed without
+    allocating. A span is only valid as long as the buffer it points into.
+*/
+/*----------------------------------------------------------------------------*/
+#ifndef STRINGSPAN_H
+#define STRINGSPAN_H
+
+#include <string>
+
+#include <scxcorelib/scxcmn.h>
+
+namespace SCXCoreLib
+{
+    /*----------------------------------------------------------------------------*/
+    /**
+        Characters of a string owned by someone else.
+
+        \tparam C  char or wchar_t.
+    */
+    template <typename C>
+    class BasicStrSpan
+    {
+    public:
+        //! Constructor of an empty span
+        BasicStrSpan() : m_data(NULL), m_size(0) { }
+
+        /**
+            Constructor
+
+            \param[in] data  First character.
+            \param[in] size  Number of characters.
+        */
+        BasicStrSpan(const C* data, size_t size) : m_data(data), m_size(size) { }
+
+        /**
+            Constructor of a span over all of a string.
+
+            \param[in] str  The string; it must outlive the span.
+        */
+        explicit BasicStrSpan(const std::basic_string<C>& str) : m_data(str.data()), m_size(str.size()) { }
+
+        //! \returns First character
+        const C* Data() const { return m_data; }
+
+        //! \returns Number of characters
+        size_t Size() const { return m_size; }
+
+        //! \returns true if the span has no characters
+        bool Empty() const { return 0 == m_size; }
+
+        //! \returns Character at index, which must be less than Size()
+        C operator[](size_t index) const { return m_data[index]; }
+
+        /**
+            Compare with a null terminated string.
+
+            \param[in] str  The string.
+            \returns   true if the span has exactly the characters of str.
+        */
+        bool Equals(const C* str) const
+        {
+            size_t i = 0;
+            for ( ; i < m_size; i++)
+            {
+                if (str[i] != m_data[i] || C() == str[i])
+                {
+                    return false;
+                }
+            }
+            return C() == str[i];
+        }
+
+        /**
+            Look for a character.
+
+            \param[in] c  The character.
+            \returns   true if c is one of the characters of the span.
+        */
+        bool Contains(C c) const
+        {
+            for (size_t i = 0; i < m_size; i++)
+            {
+                if (c == m_data[i])
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        //! \returns The characters as a string
+        std::basic_string<C> ToString() const { return std::basic_string<C>(m_data, m_size); }
+
+    private:
+        const C* m_data;    //!< First character
+        size_t m_size;      //!< Number of characters
+    };
+
+    typedef BasicStrSpan<char> StrSpan;         //!< Span of narrow characters
+    typedef BasicStrSpan<wchar_t> WStrSpan;     //!< Span of wide characters
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Splits a string into spans separated by any of a set of delimiters.
+
+        \tparam C  char or wchar_t.
+
+        Tokens are found as StrTokenize() finds them without keepDelimiters:
+        trimming removes spaces, tabs and newlines at both ends of a token,
+        empty tokens are skipped unless asked for, and with no delimiters the
+        whole string is one token.
+
+        \code
+        WStrSpanTokenizer tokenizer(line, L" \n");
+        WStrSpan token;
+        while (tokenizer.Next(token))
+        {
+            ...
+        }
+        \endcode
+    */
+    template <typename C>
+    class BasicStrSpanTokenizer
+    {
+    public:
+        /**
+            Constructor
+
+            \param[in] data         First character of the string to tokenize.
+            \param[in] size         Number of characters of the string.
+            \param[in] delimiters   Null terminated delimiter characters; must outlive the tokenizer.
+            \param[in] trim         true if tokens should be trimmed.
+            \param[in] emptyTokens  true if empty tokens should be returned.
+        */
+        BasicStrSpanTokenizer(const C* data, size_t size, const C* delimiters, bool trim = true, bool emptyTokens = false)
+            : m_pos(data), m_end(data + size), m_delimiters(delimiters),
+              m_trim(trim), m_emptyTokens(emptyTokens), m_done(false)
+        {
+        }
+
+        /**
+            Constructor
+
+            \param[in] str          String to tokenize; must outlive the tokenizer and its tokens.
+            \param[in] delimiters   Null terminated delimiter characters; must outlive the tokenizer.
+            \param[in] trim         true if tokens should be trimmed.
+            \param[in] emptyTokens  true if empty tokens should be returned.
+        */
+        BasicStrSpanTokenizer(const std::basic_string<C>& str, const C* delimiters, bool trim = true, bool emptyTokens = false)
+            : m_pos(str.data()), m_end(str.data() + str.size()), m_delimiters(delimiters),
+              m_trim(trim), m_emptyTokens(emptyTokens), m_done(false)
+        {
+        }
+
+        /**
+            Find the next token.
+
+            \param[out] token  Receives the token.
+            \returns    false if there are no more tokens.
+        */
+        bool Next(BasicStrSpan<C>& token)
+        {
+            while ( ! m_done)
+            {
+                const C* begin = m_pos;
+                const C* end = begin;
+                while (end < m_end && ! IsDelimiter(*end))
+                {
+                    ++end;
+                }
+                if (end == m_end)
+                {
+                    m_done = true;
+                }
+                else
+                {
+                    m_pos = end + 1;
+                }
+
+                if (m_trim)
+                {
+                    while (begin < end && IsBlank(*begin))
+                    {
+                        ++begin;
+                    }
+                    while (end > begin && IsBlank(end[-1]))
+                    {
+                        --end;
+                    }
+                }
+                if (begin != end || m_emptyTokens)
+                {
+                    token = BasicStrSpan<C>(begin, static_cast<size_t>(end - begin));
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /**
+            Find the next tokens.
+
+            \param[out] tokens  Receives the tokens.
+            \param[in]  count   Most tokens to find.
+            \returns    Number of tokens found; less than count if there are no more.
+        */
+        size_t Next(BasicStrSpan<C>* tokens, size_t count)
+        {
+            size_t found = 0;
+            while (found < count && Next(tokens[found]))
+            {
+                ++found;
+            }
+            return found;
+        }
+
+    private:
+        //! \returns true if c is one of the delimiters
+        bool IsDelimiter(C c) const
+        {
+            for (const C* d = m_delimiters; C() != *d; ++d)
+            {
+                if (c == *d)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        //! \returns true if c is removed by trimming, as by StrTrim()
+        static bool IsBlank(C c)
+        {
+            return C(' ') == c || C('\t') == c || C('\n') == c;
+        }
+
+        const C* m_pos;             //!< Start of the next token
+        const C* m_end;             //!< End of the string
+        const C* m_delimiters;      //!< Delimiter characters
+        bool m_trim;                //!< Should tokens be trimmed?
+        bool m_emptyTokens;         //!< Should empty tokens be returned?
+        bool m_done;                //!< Has the last token been found?
+    };
+
+    typedef BasicStrSpanTokenizer<char> StrSpanTokenizer;        //!< Tokenizer of narrow strings
+    typedef BasicStrSpanTokenizer<wchar_t> WStrSpanTokenizer;    //!< Tokenizer of wide strings
+
+    bool StrSpanToULong(const StrSpan& span, scxulong& value, StrSpan* rest = NULL);
+    bool StrSpanToULong(const WStrSpan& span, scxulong& value, WStrSpan* rest = NULL);
+    bool StrSpanToLong(const StrSpan& span, scxlong& value, StrSpan* rest = NULL);
+    bool StrSpanToLong(const WStrSpan& span, scxlong& value, WStrSpan* rest = NULL);
+}
+
+#endif /* STRINGSPAN_H */
+/*----------------------------E-N-D---O-F---F-I-L-E---------------------------*/
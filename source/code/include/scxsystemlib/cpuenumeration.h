@@ -21,6 +21,8 @@
 #include <scxsystemlib/entityenumeration.h>
 #include <scxsystemlib/cpuinstance.h>
 #include <scxcorelib/scxlog.h>
+#include <scxcorelib/scxsamplescheduler.h>
+#include <scxcorelib/scxsnapshot.h>
 #include <scxcorelib/scxthread.h>
 #include <scxcorelib/scxthreadlock.h>
 
@@ -53,7 +55,7 @@ namespace SCXSystemLib
     class CPUPALDependencies
     {
     public:
-        virtual SCXCoreLib::SCXHandle<std::wistream> OpenStatFile() const;
+        virtual size_t ReadStatFile(std::vector<char>& buffer) const;
         virtual SCXCoreLib::SCXHandle<std::wistream> OpenCpuinfoFile() const;
         virtual long sysconf(int name) const;
 #if defined(sun)
@@ -87,6 +89,71 @@ namespace SCXSystemLib
         virtual ~CPUPALDependencies() {};
     };
 
+#if defined(linux) || defined(WIN32)
+    /*----------------------------------------------------------------------------*/
+    /**
+     Counters from one "cpu" row of the stat file.
+    */
+    struct CPUStatRow
+    {
+        bool isTotal;           //!< Is this the "cpu" row (sum over all CPUs)?
+        unsigned int cpu;       //!< CPU number N of a "cpuN" row, 0 for the total row.
+        scxulong user;          //!< User ticks
+        scxulong nice;          //!< Nice ticks
+        scxulong system;        //!< System ticks
+        scxulong idle;          //!< Idle ticks
+        scxulong iowait;        //!< IO Wait ticks
+        scxulong irq;           //!< IRQ ticks
+        scxulong softirq;       //!< Soft IRQ ticks
+        scxulong total;         //!< Sum of all ticks above
+    };
+
+    /*----------------------------------------------------------------------------*/
+    /**
+     System wide counters from the rows of the stat file that are not "cpu" rows.
+    */
+    struct CPUStatSystemCounters
+    {
+        CPUStatSystemCounters() : contextSwitches(0), interrupts(0), procsRunning(0) {}
+
+        scxulong contextSwitches;   //!< "ctxt": context switches since boot
+        scxulong interrupts;        //!< "intr": interrupts serviced since boot (first column)
+        scxulong procsRunning;      //!< "procs_running": processes currently runnable
+    };
+
+    /*----------------------------------------------------------------------------*/
+    /**
+     All cpu counters read from the stat file in one sample.
+
+     Built by the sampler without holding the enumeration lock and never
+     modified once published.
+    */
+    class CPUStatSnapshot
+    {
+    public:
+        /**
+         Constructor.
+         \param[in,out] rows      Rows read; contents are taken over (rows is left empty).
+         \param[in]     counters  System wide counters read.
+        */
+        CPUStatSnapshot(std::vector<CPUStatRow>& rows, const CPUStatSystemCounters& counters)
+            : m_counters(counters)
+        {
+            m_rows.swap(rows);
+        }
+
+        /** \returns Rows in the order they appear in the stat file. */
+        const std::vector<CPUStatRow>& GetRows() const { return m_rows; }
+
+        /** \returns System wide counters. */
+        const CPUStatSystemCounters& GetSystemCounters() const { return m_counters; }
+
+    private:
+        std::vector<CPUStatRow> m_rows;     //!< Rows read from the stat file.
+        CPUStatSystemCounters m_counters;   //!< System wide counters read from the stat file.
+    };
+#endif
+
     /*----------------------------------------------------------------------------*/
     /**
      Class that represents a colletion of CPU:s.
@@ -103,6 +170,9 @@ namespace SCXSystemLib
         virtual void Update(bool updateInstances=true);
         virtual void CleanUp();
         void SampleData();
+#if defined(linux) || defined(WIN32)
+        SCXCoreLib::SCXHandle<const CPUStatSnapshot> GetStatSnapshot() const;
+#endif
 
         //
         // These would normally be protected, but are here for unit test purposes
@@ -113,6 +183,12 @@ namespace SCXSystemLib
             SCXCoreLib::SCXLogHandle& logH,
             bool fForceComputation = false);
         static size_t ProcessorCountLogical(SCXCoreLib::SCXHandle<CPUPALDependencies> deps);
+#if defined(linux) || defined(WIN32)
+        static SCXCoreLib::SCXHandle<const CPUStatSnapshot> ParseStatFile(
+            const char* data,
+            size_t size,
+            const SCXCoreLib::SCXLogHandle& logH);
+#endif
 
         /**
          Provider access to ProcessorCountPhysical() method
@@ -150,9 +226,16 @@ namespace SCXSystemLib
         time_t m_sampleSecs;			//!< Number of seconds between samples
         size_t m_sampleSize;                    //!< Number of elements stored in sample set
 
-        SCXCoreLib::SCXHandle<SCXCoreLib::SCXThread> m_dataAquisitionThread; //!< Thread pointer.
-        static void DataAquisitionThreadBody(SCXCoreLib::SCXThreadParamHandle& param);
+        SCXCoreLib::SCXSampleScheduler::SamplerId m_samplerId; //!< Registration with the sample scheduler (0 if none).
+        static void DataAquisitionSampleBody(SCXCoreLib::SCXThreadParamHandle& param);
         bool IsCPUEnabled(const int cpuid);
+#if defined(linux) || defined(WIN32)
+        SCXCoreLib::SCXSnapshot<const CPUStatSnapshot> m_statSnapshot; //!< Counters from the latest sample.
+        SCXCoreLib::SCXThreadLockHandle m_statBufferLock; //!< Serializes reads into m_statBuffer.
+        std::vector<char> m_statBuffer;         //!< Contents of the stat file, kept between samples.
+        SCXCoreLib::SCXHandle<const CPUStatSnapshot> ReadStatSnapshot();
+        void ApplyStatSnapshot(const CPUStatSnapshot& snapshot);
+#endif
 #if defined(sun)
         SCXCoreLib::SCXHandle<SCXKstat> m_kstatHandle; //!< Keep a kstat object to avoid expensive kstat_open()
 #endif
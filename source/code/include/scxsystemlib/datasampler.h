@@ -17,119 +17,137 @@
 
 #include <scxcorelib/scxthreadlock.h>
 #include <deque>
+#include <limits>
 
 namespace SCXSystemLib  
 {
-    // Note: This class can only be used with native data types (i.e. not a class or struct)
+    /*----------------------------------------------------------------------------*/
+    /**
+        Fixed capacity ring of samples, newest first.
+
+        Adding a sample when the ring is full overwrites the oldest one, so
+        inserting is O(1) no matter how long the history is.
+
+        \note This class can only be used with native data types (i.e. not a class or struct)
+    */
     template<class T>
-    class FixedSizeVector
+    class SampleRing
     {
     public:
-        typedef T* iterator;
-        typedef const T* const_iterator;
+        /*----------------------------------------------------------------------------*/
+        /**
+            Constructor.
 
-        FixedSizeVector(size_t maxsize) : _maxSize(maxsize), _size(0)
+            \param  capacity  Maximum number of samples kept.
+        */
+        SampleRing(size_t capacity) : m_data(0), m_capacity(capacity), m_head(0), m_size(0)
         {
-            _data = new T[_maxSize];
+            if (m_capacity > 0)
+            {
+                m_data = new T[m_capacity];
+            }
         }
 
-        FixedSizeVector(const FixedSizeVector& x) : _maxSize(x._maxSize), _size(0)
+        /*----------------------------------------------------------------------------*/
+        /**
+            Copy constructor.
+        */
+        SampleRing(const SampleRing& x) : m_data(0), m_capacity(x.m_capacity), m_head(0), m_size(0)
         {
-            _data = new T[_maxSize];
-            for (const_iterator p = x.begin(); p != x.end(); p++)
-                push_back(*p);
+            if (m_capacity > 0)
+            {
+                m_data = new T[m_capacity];
+            }
+            CopySamples(x);
         }
 
-        ~FixedSizeVector()
+        ~SampleRing()
         {
-            clear();
-            delete [] _data;
+            delete [] m_data;
         }
 
-        FixedSizeVector& operator=(const FixedSizeVector& x)
+        /*----------------------------------------------------------------------------*/
+        /**
+            Assignment; keeps the capacity of this ring (the newest samples are kept).
+        */
+        SampleRing& operator=(const SampleRing& x)
         {
             if (this != &x)
             {
-                clear();
-
-                for (const_iterator p = x.begin(); p != x.end(); p++)
-                    push_back(*p);
+                CopySamples(x);
             }
 
             return *this;
         }
 
-        size_t size() const 
+        size_t size() const
         {
-            return _size; 
+            return m_size;
         }
 
-        T& operator[](size_t i) 
+        size_t capacity() const
         {
-            return  _data[i];
+            return m_capacity;
         }
 
-        T operator[](size_t i) const
+        /** \returns Sample i (0 is the newest). i must be less than size(). */
+        T& operator[](size_t i)
         {
-            return _data[i];
+            return m_data[Slot(i)];
         }
 
-        T* begin() 
-        { 
-            return _data;
-        }
-
-        const T* begin() const 
+        /** \returns Sample i (0 is the newest). i must be less than size(). */
+        T operator[](size_t i) const
         {
-            return _data;
-        }
-
-        iterator end() 
-        { 
-            return begin() + _size;
-        }
-
-        const_iterator end() const 
-        { 
-            return begin() + _size;
+            return m_data[Slot(i)];
         }
 
         void clear()
         {
-            _size = 0;
+            m_head = 0;
+            m_size = 0;
         }
 
+        /** Add a new newest sample, overwriting the oldest one if full. */
         void push_front(const T& x)
         {
-            if (_size != _maxSize)
+            if (0 == m_capacity)
             {
-                memmove(begin() + 1, begin(), sizeof(T) * _size);
-                _data[0] = x;
-                _size++;
+                return;
             }
-        }
-
-        void push_back(const T& x)
-        {
-            if (_size != _maxSize)
+            if (0 != m_size)
+            {
+                m_head = (m_head + 1 == m_capacity) ? 0 : m_head + 1;
+            }
+            m_data[m_head] = x;
+            if (m_size != m_capacity)
             {
-                _data[_size] = x;
-                _size++;
+                m_size++;
             }
         }
 
-        void pop_back()
+    private:
+        /** \returns Array index of sample i (0 is the newest). */
+        size_t Slot(size_t i) const
         {
-            _size--;
+            return (i <= m_head) ? m_head - i : m_head + m_capacity - i;
         }
 
-    private:
-        // Data elements.
-        T* _data;                       //!< Data elements
-
-        size_t _maxSize;                //!< Maximum size
-        size_t _size;                   //!< Current size (not to exceed _maxSize)
+        /** Replace the contents with the newest samples of another ring. */
+        void CopySamples(const SampleRing& x)
+        {
+            clear();
+            size_t count = (x.m_size < m_capacity) ? x.m_size : m_capacity;
+            for (size_t i = count; i > 0; i--)
+            {
+                push_front(x[i - 1]);
+            }
+        }
 
+        T* m_data;                      //!< Data elements
+        size_t m_capacity;              //!< Maximum size
+        size_t m_head;                  //!< Index of the newest element
+        size_t m_size;                  //!< Current size (not to exceed m_capacity)
     };
 
     /*----------------------------------------------------------------------------*/
@@ -149,7 +167,7 @@ namespace SCXSystemLib
     template<class T> class DataSampler
     {
     public:
-        typedef FixedSizeVector<T> Samples;
+        typedef SampleRing<T> Samples;
 
         /*----------------------------------------------------------------------------*/
         /**
@@ -157,8 +175,7 @@ namespace SCXSystemLib
             
         */
         DataSampler(size_t numElements) : m_lock(SCXCoreLib::ThreadLockHandleGet()),
-                                          m_samples(numElements),
-                                          m_numElements(numElements)
+                                          m_samples(numElements)
         {
         }
 
@@ -172,10 +189,6 @@ namespace SCXSystemLib
         void AddSample(T sample)
         {
             SCXCoreLib::SCXThreadLock lock(m_lock);
-
-            if ( m_samples.size() == m_numElements)
-                m_samples.pop_back();
-
             m_samples.push_front(sample);
         }
 
@@ -219,10 +232,10 @@ namespace SCXSystemLib
             }
 
             SCXCoreLib::SCXThreadLock lock(m_lock);
-            for (typename Samples::const_iterator it = m_samples.begin(); it != m_samples.end(); ++it) 
+            for (size_t i = 0; i < m_samples.size(); ++i)
             {
-                sum += static_cast<V>(*it);
-            } 
+                sum += static_cast<V>(m_samples[i]);
+            }
             return sum / static_cast<V>(m_samples.size());
         }
 
@@ -350,8 +363,430 @@ namespace SCXSystemLib
     private:
         SCXCoreLib::SCXThreadLockHandle m_lock;  //!< Makes the datasampler thread safe.
         Samples m_samples;                 //!< Contains the samples.
-        size_t m_numElements;              //!< Maximum number of elements
     };
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        A set of counters of the same type that are always sampled together.
+
+        \param T Sample type, with the same requirements as for DataSampler.
+
+        Works like one DataSampler per counter, but all histories share a
+        single allocation (one row of samples per counter), one lock and one
+        insert position, so an instance with several counters pays for one
+        heap block and one lock instead of one per counter.
+    */
+    template<class T> class DataSamplerArray
+    {
+    public:
+        /*----------------------------------------------------------------------------*/
+        /**
+            Constructor.
+
+            \param  counters     Number of counters.
+            \param  numElements  Maximum number of samples kept per counter.
+        */
+        DataSamplerArray(size_t counters, size_t numElements) :
+            m_lock(SCXCoreLib::ThreadLockHandleGet()),
+            m_data(0),
+            m_counters(counters),
+            m_numElements(numElements),
+            m_head(0),
+            m_size(0)
+        {
+            if (m_counters * m_numElements > 0)
+            {
+                m_data = new T[m_counters * m_numElements];
+            }
+        }
+
+        ~DataSamplerArray()
+        {
+            delete [] m_data;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+            Add a new sample to every counter.
+
+            \param  samples  One new sample per counter (GetNumberOfCounters() values).
+        */
+        void AddSamples(const T* samples)
+        {
+            SCXCoreLib::SCXThreadLock lock(m_lock);
+            if (0 == m_numElements)
+            {
+                return;
+            }
+            if (0 != m_size)
+            {
+                m_head = (m_head + 1 == m_numElements) ? 0 : m_head + 1;
+            }
+            for (size_t c = 0; c < m_counters; c++)
+            {
+                m_data[c * m_numElements + m_head] = samples[c];
+            }
+            if (m_size != m_numElements)
+            {
+                m_size++;
+            }
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+            Check if the latest value of a counter is smaller than an earlier value.
+
+            \param  counter  Counter to check.
+            \param  samples  Number of samples to go back.
+            \returns true if smaller, else false
+        */
+        bool HasWrapped(size_t counter, size_t samples) const
+        {
+            SCXCoreLib::SCXThreadLock lock(m_lock);
+            if (m_size < 2 || 0 == samples)
+            {
+                return false;
+            }
+            return At(counter, 0) < At(counter, LastIndex(samples));
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+            Get the average change in value of a counter in the latest samples.
+
+            \param  counter  Counter to use.
+            \param  samples  Number of samples to go back.
+            \returns Average change, see DataSampler::GetAverageDelta().
+        */
+        T GetAverageDelta(size_t counter, size_t samples) const
+        {
+            return GetAverageDeltaFactored(counter, samples, 1);
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+            Get the average change in value of a counter factored by a given factor.
+
+            \param  counter  Counter to use.
+            \param  samples  Number of samples to go back.
+            \param  factor   Factor to increase the average.
+            \returns Average change, see DataSampler::GetAverageDeltaFactored().
+        */
+        T GetAverageDeltaFactored(size_t counter, size_t samples, T factor) const
+        {
+            SCXCoreLib::SCXThreadLock lock(m_lock);
+            if (samples < 2 || m_size < 2 || 0 == factor)
+            {
+                // Too few samples to produce a valid output (or zero factor).
+                return T();
+            }
+            size_t index = LastIndex(samples);
+            return ((At(counter, 0) - At(counter, index))*factor) / static_cast<T>(index);
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+            Get the change in value of a counter in the latest samples.
+
+            \param  counter  Counter to use.
+            \param  samples  Number of samples to go back.
+            \returns Change in value, see DataSampler::GetDelta().
+        */
+        T GetDelta(size_t counter, size_t samples) const
+        {
+            SCXCoreLib::SCXThreadLock lock(m_lock);
+            if (samples < 2 || m_size < 2)
+            {
+                // Too few samples to produce a valid output.
+                return T();
+            }
+            return At(counter, 0) - At(counter, LastIndex(samples));
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+            Get a specific sample value.
+
+            \param  counter  Counter to use.
+            \param  index    Sample index to retrieve (0 is the newest).
+            \returns The sample value at given index.
+            \throws SCXIllegalIndexExceptionUInt if counter or index is out of range.
+        */
+        T GetSample(size_t counter, size_t index) const
+        {
+            SCXCoreLib::SCXThreadLock lock(m_lock);
+            if (counter >= m_counters)
+            {
+                throw SCXCoreLib::SCXIllegalIndexException<size_t>(L"counter", counter, SCXSRCLOCATION);
+            }
+            if (index >= m_size)
+            {
+                throw SCXCoreLib::SCXIllegalIndexException<size_t>(L"index", index, SCXSRCLOCATION);
+            }
+            return At(counter, index);
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+            Erase all samples of all counters.
+        */
+        void Clear()
+        {
+            SCXCoreLib::SCXThreadLock lock(m_lock);
+            m_head = 0;
+            m_size = 0;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+            Retrieve the number of samples (the same for every counter).
+
+            \returns Number of samples saved.
+        */
+        size_t GetNumberOfSamples() const
+        {
+            SCXCoreLib::SCXThreadLock lock(m_lock);
+            return m_size;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+            Retrieve the number of counters.
+
+            \returns Number of counters.
+        */
+        size_t GetNumberOfCounters() const
+        {
+            return m_counters;
+        }
+
+    private:
+        // Do not allow copying
+        DataSamplerArray(const DataSamplerArray&);              //!< Intentionally not implemented
+        DataSamplerArray& operator=(const DataSamplerArray&);   //!< Intentionally not implemented
+
+        /** \returns Sample index to compare the newest sample with; m_size must be at least 1. */
+        size_t LastIndex(size_t samples) const
+        {
+            return (samples > m_size) ? m_size - 1 : samples - 1;
+        }
+
+        /** \returns Sample i (0 is the newest) of a counter; i must be less than m_size. */
+        T At(size_t counter, size_t i) const
+        {
+            size_t slot = (i <= m_head) ? m_head - i : m_head + m_numElements - i;
+            return m_data[counter * m_numElements + slot];
+        }
+
+        SCXCoreLib::SCXThreadLockHandle m_lock;  //!< Makes the sampler thread safe.
+        T* m_data;                               //!< Samples, one row of m_numElements per counter.
+        size_t m_counters;                       //!< Number of counters
+        size_t m_numElements;                    //!< Maximum number of samples per counter
+        size_t m_head;                           //!< Index of the newest sample within a row
+        size_t m_size;                           //!< Current number of samples per counter
+    };
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        A DataSamplerArray whose size is fixed at compile time.
+
+        \param T            Sample type, with the same requirements as for DataSampler.
+        \param Counters     Number of counters.
+        \param NumElements  Maximum number of samples kept per counter (1 to 255).
+
+        The samples are stored in the object itself, so it costs no heap
+        allocation, and there is no lock. It is meant for objects that exist
+        in large numbers and whose owner serializes access to them anyway,
+        such as the process instances of a ProcessEnumeration.
+    */
+    template<class T, size_t Counters, size_t NumElements> class FixedDataSamplerArray
+    {
+    public:
+        /*----------------------------------------------------------------------------*/
+        /**
+            Constructor.
+        */
+        FixedDataSamplerArray() : m_head(0), m_size(0)
+        {
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+            Add a new sample to every counter.
+
+            \param  samples  One new sample per counter (Counters values).
+        */
+        void AddSamples(const T* samples)
+        {
+            if (0 != m_size)
+            {
+                m_head = static_cast<unsigned char>((m_head + 1u == NumElements) ? 0 : m_head + 1u);
+            }
+            for (size_t c = 0; c < Counters; c++)
+            {
+                m_data[m_head][c] = samples[c];
+            }
+            if (m_size != NumElements)
+            {
+                m_size++;
+            }
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+            Get the change in value of a counter in the latest samples.
+
+            \param  counter  Counter to use.
+            \param  samples  Number of samples to go back.
+            \returns Change in value, see DataSampler::GetDelta().
+        */
+        T GetDelta(size_t counter, size_t samples) const
+        {
+            if (samples < 2 || m_size < 2)
+            {
+                // Too few samples to produce a valid output.
+                return T();
+            }
+            return At(counter, 0) - At(counter, (samples > m_size) ? m_size - 1u : samples - 1);
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+            Get a specific sample value.
+
+            \param  counter  Counter to use.
+            \param  index    Sample index to retrieve (0 is the newest).
+            \returns The sample value at given index.
+            \throws SCXIllegalIndexExceptionUInt if counter or index is out of range.
+        */
+        T GetSample(size_t counter, size_t index) const
+        {
+            if (counter >= Counters)
+            {
+                throw SCXCoreLib::SCXIllegalIndexException<size_t>(L"counter", counter, SCXSRCLOCATION);
+            }
+            if (index >= m_size)
+            {
+                throw SCXCoreLib::SCXIllegalIndexException<size_t>(L"index", index, SCXSRCLOCATION);
+            }
+            return At(counter, index);
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+            Erase all samples of all counters.
+        */
+        void Clear()
+        {
+            m_head = 0;
+            m_size = 0;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+            Retrieve the number of samples (the same for every counter).
+
+            \returns Number of samples saved.
+        */
+        size_t GetNumberOfSamples() const
+        {
+            return m_size;
+        }
+
+    private:
+        /** \returns Sample i (0 is the newest) of a counter; i must be less than m_size. */
+        T At(size_t counter, size_t i) const
+        {
+            size_t slot = (i <= m_head) ? m_head - i : m_head + NumElements - i;
+            return m_data[slot][counter];
+        }
+
+        T m_data[NumElements][Counters];        //!< Samples, one row of all counters per sample
+        unsigned char m_head;                   //!< Row of the newest sample
+        unsigned char m_size;                   //!< Current number of samples per counter
+    };
+    /*----------------------------------------------------------------------------*/
+    /**
+        Convert a time split in seconds and a fraction of a second to a count
+        of fractions, so that it can be sampled as a counter.
+
+        \param  seconds    Whole seconds.
+        \param  fraction   Fractions of a second, below perSecond.
+        \param  perSecond  Fractions per second.
+        \returns The time as fractions. A negative time gives 0, and a time
+                 that does not fit in an scxulong gives the largest scxulong.
+    */
+    template<class Seconds, class Fraction>
+    scxulong SplitTimeToCount(Seconds seconds, Fraction fraction, scxulong perSecond)
+    {
+        const scxulong maxCount = std::numeric_limits<scxulong>::max();
+
+        if (seconds < 0 || fraction < 0)
+        {
+            return 0;
+        }
+        scxulong wholeSeconds = static_cast<scxulong>(seconds);
+        scxulong fractions = static_cast<scxulong>(fraction);
+        if (wholeSeconds > (maxCount - fractions) / perSecond)
+        {
+            return maxCount;
+        }
+        return wholeSeconds * perSecond + fractions;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Split a count of fractions of a second in seconds and a fraction.
+
+        \param  count      Time as fractions.
+        \param  perSecond  Fractions per second.
+        \param  seconds    Returns whole seconds.
+        \param  fraction   Returns the fractions left over, below perSecond.
+
+        A count whose seconds do not fit in Seconds gives the largest time
+        that does.
+    */
+    template<class Seconds, class Fraction>
+    void CountToSplitTime(scxulong count, scxulong perSecond, Seconds& seconds, Fraction& fraction)
+    {
+        scxulong wholeSeconds = count / perSecond;
+        if (wholeSeconds > static_cast<scxulong>(std::numeric_limits<Seconds>::max()))
+        {
+            seconds = std::numeric_limits<Seconds>::max();
+            fraction = static_cast<Fraction>(perSecond - 1);
+            return;
+        }
+        seconds = static_cast<Seconds>(wholeSeconds);
+        fraction = static_cast<Fraction>(count % perSecond);
+    }
+
+    /** \returns A struct timeval (or alike, with tv_sec and tv_usec) as microseconds, see SplitTimeToCount() */
+    template<class Timeval> scxulong TimevalToMicroseconds(const Timeval& tv)
+    {
+        return SplitTimeToCount(tv.tv_sec, tv.tv_usec, 1000000);
+    }
+
+    /** \returns Microseconds as a struct timeval (or alike), see CountToSplitTime() */
+    template<class Timeval> Timeval MicrosecondsToTimeval(scxulong microseconds)
+    {
+        Timeval tv;
+        CountToSplitTime(microseconds, 1000000, tv.tv_sec, tv.tv_usec);
+        return tv;
+    }
+
+    /** \returns A struct timespec (or alike, with tv_sec and tv_nsec) as nanoseconds, see SplitTimeToCount() */
+    template<class Timespec> scxulong TimespecToNanoseconds(const Timespec& ts)
+    {
+        return SplitTimeToCount(ts.tv_sec, ts.tv_nsec, 1000000000);
+    }
+
+    /** \returns Nanoseconds as a struct timespec (or alike), see CountToSplitTime() */
+    template<class Timespec> Timespec NanosecondsToTimespec(scxulong nanoseconds)
+    {
+        Timespec ts;
+        CountToSplitTime(nanoseconds, 1000000000, ts.tv_sec, ts.tv_nsec);
+        return ts;
+    }
 }
 
 #endif /* DATASAMPLER_H */
@@ -30,6 +30,7 @@
 #include <scxcorelib/stringaid.h>
 #include <scxcorelib/logsuppressor.h>
 #include <scxsystemlib/scxlvmtab.h>
+#include <scxsystemlib/scxmountwatcher.h>
 #include <scxsystemlib/scxraid.h>
 #include <scxcorelib/scxdirectoryinfo.h>
 #if defined(aix)
@@ -159,6 +160,23 @@ namespace SCXSystemLib
         std::wstring    devAttribute; //!< Device attribute value (or empty if no such attribute).
     };
 
+    /**
+       Represents a single row in /proc/diskstats.
+
+       The numeric columns are stored by column number, as they appear in the
+       file, so that the column enumerations of the statistical disk instances
+       index them directly. The device name column holds 0.
+    */
+    struct ProcDiskStatsRow
+    {
+        /** Maximum number of columns kept; later columns are ignored. */
+        static const size_t MAX_COLUMNS = 24;
+
+        std::string     name;                   //!< Device name (column 3).
+        size_t          columns;                //!< Number of columns on the row.
+        scxulong        counters[MAX_COLUMNS];  //!< Numeric columns, by column number.
+    };
+
     class RefreshMNTTabParam{
          public:
              enum reqType { DEVICE, MOUNTPOINT, NOPARAM};
@@ -219,6 +237,15 @@ namespace SCXSystemLib
         */
         virtual const std::vector<std::wstring>& GetProcDiskStats(const std::wstring& device) = 0;
 
+        /**
+           Get a parsed proc disk stats row.
+
+           \param device The device we want statistics for.
+           \returns The row for the device, or 0 if there is none. Valid until
+                    the next call to RefreshProcDiskStats().
+        */
+        virtual const ProcDiskStatsRow* GetProcDiskStatsRow(const std::wstring& device) = 0;
+
         /**
            Get a list of files in a directory.
 
@@ -249,6 +276,14 @@ namespace SCXSystemLib
         */ 
         virtual void RefreshMNTTab(RefreshMNTTabParam *param=NULL)= 0;
 
+        /**
+           Get the generation of the mount tab.
+
+           \returns a number that changes each time RefreshMNTTab() finds a
+                    changed mount tab, or 0 if changes are not tracked.
+        */
+        virtual scxulong GetMNTTabGeneration() { return 0; }
+
 #if defined(sun)
         /**
            Set the path to dev tab file.
@@ -402,6 +437,19 @@ namespace SCXSystemLib
         */
         virtual ssize_t read(void *pbuf, size_t bytecount) = 0;
 
+        /**
+           Create a dependency object with a device descriptor of its own.
+
+           open(), ioctl(), read() and close() work on a single descriptor kept
+           in this object. A disk instance updated in parallel with others uses
+           an object of its own, created by this method.
+
+           \returns A new object accessing the same system as this one, or NULL
+                    if the device access of this object cannot be duplicated (the
+                    disks are then updated one after another).
+        */
+        virtual SCXCoreLib::SCXHandle<DiskDepend> CreateDeviceDepend() = 0;
+
         /** 
             Wrapper for the system call statvfs.
 
@@ -642,10 +690,12 @@ namespace SCXSystemLib
         virtual const SCXCoreLib::SCXFilePath& LocateProcPartitions();
         virtual void RefreshProcDiskStats();
         virtual const std::vector<std::wstring>& GetProcDiskStats(const std::wstring& device);
+        virtual const ProcDiskStatsRow* GetProcDiskStatsRow(const std::wstring& device);
         virtual void GetFilesInDirectory(const std::wstring& path, std::vector<SCXCoreLib::SCXFilePath>& files);
         virtual const SCXLvmTab& GetLVMTab();
         virtual const std::vector<MntTabEntry>& GetMNTTab();
         virtual void RefreshMNTTab(RefreshMNTTabParam *Param=NULL);
+        virtual scxulong GetMNTTabGeneration();
 #if defined(sun)
         virtual void SetDevTabPath(const std::wstring& newValue); 
         virtual const SCXCoreLib::SCXFilePath& LocateDevTab();
@@ -703,6 +753,14 @@ namespace SCXSystemLib
         */
         virtual ssize_t read(void *pbuf, size_t bytecount);
 
+        /**
+           \copydoc SCXSystemLib::DiskDepend::CreateDeviceDepend
+        */
+        virtual SCXCoreLib::SCXHandle<DiskDepend> CreateDeviceDepend()
+        {
+            return SCXCoreLib::SCXHandle<DiskDepend>(new DiskDependDefault(m_log));
+        }
+
         /**
            \copydoc SCXSystemLib::DiskDepend::statvfs
         */
@@ -884,8 +942,18 @@ namespace SCXSystemLib
         SCXCoreLib::SCXHandle<SCXLvmTab> m_pLvmTab; //!< A parsed lvmtab file object.
         SCXCoreLib::SCXHandle<SCXRaid> m_pRaid; //!< A parsed RAID configuration.
         std::vector<MntTabEntry> m_MntTab; //!< A parsed mnttab object.
+        std::vector<MntTabEntry> m_MntTabAll; //!< All entries of the mount tab, as last parsed.
+        bool m_MntTabAllValid; //!< Does m_MntTabAll hold a successfully parsed mount tab?
+        bool m_MntTabIsAll; //!< Does m_MntTab hold all of m_MntTabAll (no filter applied)?
+        scxulong m_MntTabGeneration; //!< Incremented each time the mount tab is parsed.
+        SCXCoreLib::SCXHandle<SCXMountWatcher> m_MountWatcher; //!< Watches for mount table changes (created when first needed).
         DeviceMapType m_deviceMap; //!< Device path to instance map.
-        std::map<std::wstring, std::vector<std::wstring> > m_ProcDiskStats; //!< parsed /proc/diskstats data.
+        std::vector<ProcDiskStatsRow> m_ProcDiskStatsRows; //!< parsed /proc/diskstats data, in file order.
+        size_t m_ProcDiskStatsRowCount; //!< Number of valid rows in m_ProcDiskStatsRows.
+        std::map<std::string, size_t> m_ProcDiskStatsIndex; //!< Device name to index in m_ProcDiskStatsRows.
+        std::vector<char> m_ProcDiskStatsBuffer; //!< Read buffer for /proc/diskstats, reused between refreshes.
+        std::string m_ProcDiskStatsKey; //!< Lookup key buffer, reused between lookups.
+        std::vector<std::wstring> m_ProcDiskStatsParts; //!< Row returned by GetProcDiskStats().
         std::map<std::wstring, std::wstring> m_fsMap; //!< Used to map filesystem identifiers to names.
 
         static const int CLOSED_DESCRIPTOR = -1;
@@ -895,6 +963,13 @@ namespace SCXSystemLib
         virtual void reopen(void);
 
 
+        void ParseProcDiskStats(const char* buffer, size_t length);
+#if !defined(aix)
+        bool MNTTabChanged();
+        void ParseMNTTab(std::vector<MntTabEntry>& entries);
+        void FilterMNTTab(RefreshMNTTabParam *param);
+#endif
+
         virtual bool FileSystemNoLinkToPhysical(const std::wstring& fs);
 #if defined(sun)
         virtual std::wstring GetVopstatName(const std::wstring & dev_path, const std::wstring & mountpoint);
@@ -0,0 +1,110 @@
+/*--------------------------------------------------------------------------------
+    Copyright (c) Microsoft Corporation. All rights reserved. See license.txt for license information.
+
+*/
+/**
+    \file
+
+    \brief       Memory-mapped parser of the dpkg status file
+
+    \date        2026-10-17 02:00:00
+
+*/
+/*----------------------------------------------------------------------------*/
+#ifndef DPKGSTATUS_H
+#define DPKGSTATUS_H
+
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+#include <scxcorelib/scxcmn.h>
+#include <scxcorelib/scxlog.h>
+
+namespace SCXSystemLib
+{
+    /*----------------------------------------------------------------------------*/
+    /**
+        Installed packages of a dpkg status file.
+
+        The file is mapped into memory and scanned once, stanza by stanza. The
+        fields of a package are kept as views into the mapping; nothing is
+        copied or converted until a caller asks for a field. The file is only
+        mapped and scanned again when its inode, size or modification time
+        change, so refreshing an unchanged inventory costs one stat().
+
+        dpkg replaces the status file by renaming a new one over it, so the
+        mapping of the old file stays valid until it is unmapped.
+
+        As the dpkg tools do, a line starting with a space or a tab continues
+        the field before it; only the first line of a field is kept. Of fields
+        given twice within a stanza, the last is kept, and of packages given
+        twice, the last.
+    */
+    class DPKGStatus
+    {
+    public:
+        /** Part of the mapped file. */
+        struct Field
+        {
+            //! Constructor
+            Field() : data(NULL), size(0) { }
+
+            const char* data;   //!< First byte, NULL if the field is missing
+            size_t size;        //!< Number of bytes
+        };
+
+        /** Fields of an installed package, leading and trailing blanks removed. */
+        struct Package
+        {
+            Field name;         //!< "Package"
+            Field version;      //!< "Version"
+            Field maintainer;   //!< "Maintainer"
+            Field section;      //!< "Section"
+            Field homepage;     //!< "Homepage"
+            Field description;  //!< First line of "Description"
+        };
+
+        DPKGStatus();
+        virtual ~DPKGStatus();
+
+        bool Refresh(const std::string& path);
+
+        const Package* Find(const std::string& name) const;
+
+        //! \returns Installed packages, ordered by name
+        const std::vector<Package>& GetPackages() const { return m_packages; }
+
+        //! \returns Number of times the file was mapped and scanned
+        scxulong GetParseCount() const { return m_parseCount; }
+
+        static std::wstring ToString(const Field& field);
+
+    protected:
+        virtual void* mmap(void* addr, size_t length, int prot, int flags, int fd, off_t offset);
+
+    private:
+        // Do not allow copying
+        DPKGStatus(const DPKGStatus &);               //!< Intentionally not implemented
+        DPKGStatus & operator=(const DPKGStatus &);   //!< Intentionally not implemented
+
+        void Unmap();
+        void Parse();
+
+        void* m_map;                    //!< Mapping of the file, NULL if none
+        size_t m_mapSize;               //!< Size of the mapping
+        bool m_exists;                  //!< Did the file exist when last looked at?
+        dev_t m_dev;                    //!< Device of the file last parsed
+        ino_t m_ino;                    //!< Inode of the file last parsed
+        off_t m_size;                   //!< Size of the file last parsed
+        time_t m_mtime;                 //!< Modification time of the file last parsed
+        long m_mtimeNsec;               //!< Nanoseconds of the modification time
+        std::vector<Package> m_packages;//!< Installed packages, ordered by name
+        scxulong m_parseCount;          //!< Number of parses
+        SCXCoreLib::SCXLogHandle m_log; //!< Log handle
+    };
+}
+
+#endif /* DPKGSTATUS_H */
+/*----------------------------E-N-D---O-F---F-I-L-E---------------------------*/
@@ -18,6 +18,7 @@
 #include <algorithm>
 
 #include <scxsystemlib/entityinstance.h>
+#include <scxsystemlib/entityupdater.h>
 #include <scxcorelib/scxexception.h>
 #include <scxcorelib/scxhandle.h>
 #include <scxcorelib/scxlog.h>
@@ -54,6 +55,12 @@ namespace SCXSystemLib
         caller not to perform any Update on the collection since that might
         invalidate the pointer.
 
+        By default UpdateInstances() updates the instances one after another. An
+        enumeration whose instances may be updated concurrently can opt in to
+        updating them in parallel on a thread pool with SetParallelUpdate().
+        Each parallel update works on a copy of the instance (see EntityCopyUpdate),
+        so Inst must then be copyable.
+
     */
     template <class Inst>
     class EntityEnumeration
@@ -70,6 +77,9 @@ namespace SCXSystemLib
         void         UpdateInstances();
         void         UpdateInstance(const EntityInstanceId& id);
 
+        void         SetParallelUpdate(SCXCoreLib::SCXHandle<SCXCoreLib::SCXThreadPool> pool, scxulong deadlineMs);
+        SCXCoreLib::SCXHandle<EntityUpdater> GetParallelUpdater() const;
+
         size_t       Size() const;
 
         EntityIterator Begin();
@@ -95,6 +105,9 @@ namespace SCXSystemLib
     private:
         std::vector<SCXCoreLib::SCXHandle<Inst> > m_instances; //!< Contains the entity instances.
         SCXCoreLib::SCXHandle<Inst> m_totalInstance; //!< Pointer to the total instance.
+        SCXCoreLib::SCXHandle<EntityUpdater> m_updater; //!< Updates instances in parallel, NULL to update serially.
+        //! Creates the update of an instance for m_updater; set with it, so only enumerations using it need copyable instances.
+        SCXCoreLib::SCXHandle<EntityUpdate> (*m_createUpdate)(SCXCoreLib::SCXHandle<Inst>);
     };
 
     /*----------------------------------------------------------------------------*/
@@ -103,7 +116,7 @@ namespace SCXSystemLib
 
     */
     template<class Inst>
-    EntityEnumeration<Inst>::EntityEnumeration() : m_totalInstance(NULL)
+    EntityEnumeration<Inst>::EntityEnumeration() : m_totalInstance(NULL), m_updater(NULL), m_createUpdate(NULL)
     {
     }
 
@@ -154,27 +167,43 @@ namespace SCXSystemLib
         Run the Update() method on all instances in the colletion, including the
         Total instance if any.
 
+        With parallel update enabled, the instances are updated in parallel and
+        the Total instance (which may depend on the others) after them.
+
     */
     template<class Inst>
     void EntityEnumeration<Inst>::UpdateInstances()
     {
-        for (size_t i=0; i<Size(); i++)
+        if (m_updater != 0 && Size() > 1)
         {
-            try {
-                m_instances[i]->Update();
-                m_instances[i]->ResetUnexpectedException();
-            } catch ( SCXCoreLib::SCXException& e ){
-                static scx_atomic_t s_ExceptionsCounter(0);
-
-                if ( s_ExceptionsCounter < 10 ){
-                    scx_atomic_increment( &s_ExceptionsCounter );
-                    SCX_LOGERROR(
-                        SCXCoreLib::SCXLogHandleFactory::GetLogHandle(
-                            L"scx.core.common.pal.system.enumerationtemplate"),
-                        std::wstring(L"Unexpected exception during instance-update; only first 10 errors are logged; ") +
-                            e.What() + std::wstring(L"; ") + e.Where() );
+            std::vector<SCXCoreLib::SCXHandle<EntityUpdate> > updates;
+            updates.reserve(Size());
+            for (size_t i=0; i<Size(); i++)
+            {
+                updates.push_back(m_createUpdate(m_instances[i]));
+            }
+            m_updater->UpdateInstances(updates);
+        }
+        else
+        {
+            for (size_t i=0; i<Size(); i++)
+            {
+                try {
+                    m_instances[i]->Update();
+                    m_instances[i]->ResetUnexpectedException();
+                } catch ( SCXCoreLib::SCXException& e ){
+                    static scx_atomic_t s_ExceptionsCounter(0);
+
+                    if ( s_ExceptionsCounter < 10 ){
+                        scx_atomic_increment( &s_ExceptionsCounter );
+                        SCX_LOGERROR(
+                            SCXCoreLib::SCXLogHandleFactory::GetLogHandle(
+                                L"scx.core.common.pal.system.enumerationtemplate"),
+                            std::wstring(L"Unexpected exception during instance-update; only first 10 errors are logged; ") +
+                                e.What() + std::wstring(L"; ") + e.Where() );
+                    }
+                    m_instances[i]->SetUnexpectedException( e );
                 }
-                m_instances[i]->SetUnexpectedException( e );
             }
         }
 
@@ -216,6 +245,45 @@ namespace SCXSystemLib
         }
     }
 
+    /*----------------------------------------------------------------------------*/
+    /**
+        Enable or disable parallel update of the instances by UpdateInstances()
+
+        \param  pool        Started thread pool to update the instances on, NULL to
+                            update the instances serially again.
+        \param  deadlineMs  Milliseconds UpdateInstances() waits for each instance
+                            update (0 for no limit); see EntityUpdater.
+
+        Only enable this for enumerations whose instances can be copied, and
+        whose copies can be updated concurrently with each other.
+    */
+    template<class Inst>
+    void EntityEnumeration<Inst>::SetParallelUpdate(SCXCoreLib::SCXHandle<SCXCoreLib::SCXThreadPool> pool, scxulong deadlineMs)
+    {
+        if (pool == 0)
+        {
+            m_updater = 0;
+            m_createUpdate = NULL;
+        }
+        else
+        {
+            m_updater = new EntityUpdater(pool, deadlineMs);
+            m_createUpdate = &EntityCopyUpdate<Inst>::Create;
+        }
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Get the object updating the instances in parallel
+
+        \returns   The updater, NULL if the instances are updated serially.
+    */
+    template<class Inst>
+    SCXCoreLib::SCXHandle<EntityUpdater> EntityEnumeration<Inst>::GetParallelUpdater() const
+    {
+        return m_updater;
+    }
+
     /*----------------------------------------------------------------------------*/
     /**
         Get iterator to the first instance in the collection
@@ -0,0 +1,172 @@
+/*--------------------------------------------------------------------------------
+    Copyright (c) Microsoft Corporation. All rights reserved. See license.txt for license information.
+
+*/
+/**
+    \file
+
+    \brief       Parallel update of entity instances
+
+    \date        2026-10-16 17:00:00
+
+*/
+/*----------------------------------------------------------------------------*/
+#ifndef ENTITYUPDATER_H
+#define ENTITYUPDATER_H
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <scxsystemlib/entityinstance.h>
+#include <scxcorelib/scxhandle.h>
+#include <scxcorelib/scxlog.h>
+#include <scxcorelib/scxthreadlock.h>
+#include <scxcorelib/scxthreadpool.h>
+
+namespace SCXSystemLib
+{
+    class EntityUpdateBatch;
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        One instance update run by EntityUpdater.
+
+        The update works on a private copy of the instance, so an update that
+        is abandoned never touches the instance itself. Only if the update
+        returns in time is the copy published to the instance.
+    */
+    class EntityUpdate
+    {
+    public:
+        /** Virtual destructor */
+        virtual ~EntityUpdate() {}
+
+        /** Get the instance to update.
+            \returns The instance; not touched until Publish(). */
+        virtual const EntityInstance& GetInstance() const = 0;
+
+        /** Get the private copy that is updated.
+            \returns The copy of the instance. */
+        virtual EntityInstance& GetCopy() = 0;
+
+        /** Copy the updated values to the instance. */
+        virtual void Publish() = 0;
+    };
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Update of an instance of type Inst, using the copy constructor and the
+        assignment operator of Inst.
+
+        Inst must be copied so that the copy can be updated while the original
+        is read, and concurrently with the copies of the other instances. An
+        instance that refers to shared state which is not safe for that (an open
+        device, for instance) must give its copy a state of its own.
+    */
+    template <class Inst>
+    class EntityCopyUpdate : public EntityUpdate
+    {
+    public:
+        /*----------------------------------------------------------------------------*/
+        /**
+            Constructor
+
+            \param[in] instance  Instance to update.
+        */
+        explicit EntityCopyUpdate(SCXCoreLib::SCXHandle<Inst> instance)
+            : m_instance(instance),
+              m_copy(new Inst(*instance))
+        {
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+            Create an update of an instance.
+
+            \param[in] instance  Instance to update.
+            \returns   The update.
+        */
+        static SCXCoreLib::SCXHandle<EntityUpdate> Create(SCXCoreLib::SCXHandle<Inst> instance)
+        {
+            return SCXCoreLib::SCXHandle<EntityUpdate>(new EntityCopyUpdate<Inst>(instance));
+        }
+
+        virtual const EntityInstance& GetInstance() const { return *m_instance; }
+        virtual EntityInstance& GetCopy() { return *m_copy; }
+        virtual void Publish() { *m_instance = *m_copy; }
+
+    private:
+        SCXCoreLib::SCXHandle<Inst> m_instance; //!< Instance to update
+        SCXCoreLib::SCXHandle<Inst> m_copy;     //!< Private copy that is updated
+    };
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Runs the Update() method of a number of instances in parallel on the
+        worker threads of a thread pool.
+
+        Instance updates that read devices (ioctl, statvfs, sysfs) may block for
+        a long time on a slow or hung device. Run one after another, a single
+        such device delays every instance after it. With this class each update
+        is a separate thread pool task, and the caller waits at most a deadline
+        for each of them.
+
+        Each task updates a private copy of its instance (see EntityUpdate).
+        When the update returns, the copy is published to the instance under
+        the lock of the batch, unless the caller has given up on it. An update
+        still running when its deadline has passed is abandoned: the caller
+        stops waiting for it, the instance keeps the values it had, and the
+        result of the update is dropped when it finally returns. Until then,
+        the instance is skipped by later calls to UpdateInstances() so that a
+        hung device does not tie up more than one worker thread.
+
+        Since publishing only happens while UpdateInstances() runs, readers of
+        the instances need no other synchronization than for a serial update.
+
+        Enumerations of instances reading devices update them in parallel on
+        GetSharedPool(), waiting c_DefaultDeadlineMs for each.
+    */
+    class EntityUpdater
+    {
+    public:
+        static const scxulong c_DefaultDeadlineMs = 5000; //!< Deadline of the enumerations updating in parallel by default
+
+        static SCXCoreLib::SCXHandle<SCXCoreLib::SCXThreadPool> GetSharedPool();
+
+        EntityUpdater(SCXCoreLib::SCXHandle<SCXCoreLib::SCXThreadPool> pool, scxulong deadlineMs);
+        virtual ~EntityUpdater();
+
+        void UpdateInstances(const std::vector<SCXCoreLib::SCXHandle<EntityUpdate> >& updates);
+
+        /** Get the time (in milliseconds) each instance update is waited for.
+            \returns Deadline in milliseconds. */
+        scxulong GetDeadline() const { return m_deadlineMs; }
+
+        scxulong GetTimeoutCount() const;
+        scxulong GetSkipCount() const;
+
+    private:
+        // Do not allow copying
+        EntityUpdater(const EntityUpdater &);               //!< Intentionally not implemented
+        EntityUpdater & operator=(const EntityUpdater &);   //!< Intentionally not implemented
+
+        /** Abandoned update: the batch it belongs to and its slot in the batch. */
+        typedef std::pair<SCXCoreLib::SCXHandle<EntityUpdateBatch>, size_t> AbandonedUpdate;
+        /** Instances whose abandoned update may still be running. */
+        typedef std::map<const EntityInstance*, AbandonedUpdate> AbandonedMap;
+
+        bool IsStillRunning(const EntityInstance* instance);
+
+        SCXCoreLib::SCXHandle<SCXCoreLib::SCXThreadPool> m_pool;   //!< Runs the updates
+        scxulong m_deadlineMs;                          //!< Time each update is waited for
+        SCXCoreLib::SCXLogHandle m_log;                 //!< Log handle
+        SCXCoreLib::SCXThreadLockHandle m_lock;         //!< Protects the members below
+        AbandonedMap m_abandoned;                       //!< Updates that passed their deadline
+        scxulong m_timeoutCount;                        //!< Updates that passed their deadline
+        scxulong m_skipCount;                           //!< Updates skipped since an earlier one still runs
+    };
+}
+
+#endif /* ENTITYUPDATER_H */
+/*----------------------------E-N-D---O-F---F-I-L-E---------------------------*/
@@ -24,7 +24,11 @@ Copyright (c) Microsoft Corporation. All rights reserved. See license.txt for li
 
 #if defined(linux)
 #include <scxcorelib/scxglob.h>
+#include <scxcorelib/scxthreadlock.h>
+#include <scxsystemlib/dpkgstatus.h>
 #include <dlfcn.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #endif
 
@@ -37,6 +41,31 @@ namespace SCXSystemLib
         {
             return L"/var/lib/dpkg/status";
         }
+
+#if defined(linux)
+        //! \returns Path of the rpm executable
+        virtual std::wstring GetRPMLocation()
+        {
+            return L"/bin/rpm";
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+           Files of the rpm database, by backend (sqlite, ndb, Berkeley DB) and
+           location. The first that exists is watched for changes.
+        */
+        virtual std::vector<std::wstring> GetRPMDatabaseFiles()
+        {
+            std::vector<std::wstring> files;
+            files.push_back(L"/var/lib/rpm/rpmdb.sqlite");
+            files.push_back(L"/var/lib/rpm/Packages.db");
+            files.push_back(L"/var/lib/rpm/Packages");
+            files.push_back(L"/usr/lib/sysimage/rpm/rpmdb.sqlite");
+            files.push_back(L"/usr/lib/sysimage/rpm/Packages.db");
+            files.push_back(L"/usr/lib/sysimage/rpm/Packages");
+            return files;
+        }
+#endif
         
         virtual ~SoftwareDependencies() { };
     };
@@ -190,11 +219,18 @@ namespace SCXSystemLib
     public:
         /*----------------------------------------------------------------------------*/
         /**
-        pass "-qi softwareName" params to RPM cli and retrun the raw data about the software.
-        \param softwareName : the productName or displayName of softwareName
+        Get the raw data about the software from the RPM inventory.
+        \param softwareName : the id of the software, as returned by GetInstalledSoftwareIds()
         \param contents : Software information date retured by RPM cli
         */
         virtual void GetSoftwareInfoRawData(const std::wstring& softwareName, std::vector<std::wstring>& contents);
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        Get the number of times the RPM cli has been run to read the inventory.
+        \returns number of inventory queries
+        */
+        scxulong GetRPMInventoryQueryCount() const { return m_rpmQueryCount; }
 #endif
 
 #if defined(sun)
@@ -353,30 +389,33 @@ namespace SCXSystemLib
         \param result : RPM query result
         \throws SCXErrnoException if popen or pclose fails
         */
-        void GetRPMQueryResult(int argc, char * argv[], std::vector<std::wstring>& result);
+        bool GetRPMQueryResult(int argc, char * argv[], std::vector<std::wstring>& result);
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        Read the RPM inventory again if the rpm database changed since it was read.
+        */
+        void UpdateRPMInventory();
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        Tells if the rpm database is unchanged since the inventory was read.
+        \returns true if the cached inventory is current
+        */
+        bool IsRPMInventoryCurrent();
+
+        SCXCoreLib::SCXThreadLockHandle m_rpmLock;  //!< Protects the RPM inventory
+        bool m_rpmInventoryRead;                    //!< Has the inventory been read?
+        std::wstring m_rpmDatabaseFile;             //!< Database file watched for changes, empty if none
+        struct stat m_rpmDatabaseStat;              //!< Status of the database file when the inventory was read
+        std::vector<std::wstring> m_rpmIds;         //!< Ids of the installed packages, in rpm order
+        std::map<std::wstring, std::vector<std::wstring> > m_rpmPackages; //!< "Key:value" lines of each package, by id
+        scxulong m_rpmQueryCount;                   //!< Number of inventory queries run
 
 #if defined(linux) && defined(PF_DISTRO_ULINUX)
-        // helper struct used with GetDPKGTotal helper function
-        struct PackageInfo
-        {
-            std::wstring Name;
-            std::wstring Version;
-            std::wstring Vendor;
-            std::wstring Release;
-            std::wstring BuildTime;
-            std::wstring InstallTime;
-            std::wstring BuildHost;
-            std::wstring SourceRPM;
-            std::wstring License;
-            std::wstring Packager;
-            std::wstring Group;
-            std::wstring URL;
-            std::wstring Summary;
-        };
-        
         /*----------------------------------------------------------------------------*/
         /**
-        Gets information for searchedPackage in the map of installed DPKGs
+        Gets information for searchedPackage in the installed DPKGs
         \param searchedPackage : the package to get info for 
         \param result : contains the information for this package, if found
         */
@@ -389,8 +428,18 @@ namespace SCXSystemLib
         \param result : contains the list of all installed packages
         */
         void GetDPKGList(std::vector<std::wstring>& result);
-        
-        std::map<std::wstring, PackageInfo> DPKGMap; //!< contains the data of all installed DPKGs and infos
+
+    public:
+        /*----------------------------------------------------------------------------*/
+        /**
+        Get the number of times the dpkg status file has been parsed.
+        \returns number of parses
+        */
+        scxulong GetDPKGParseCount() const { return m_dpkgStatus.GetParseCount(); }
+
+    private:
+        SCXCoreLib::SCXThreadLockHandle m_dpkgLock;  //!< Protects m_dpkgStatus
+        DPKGStatus m_dpkgStatus;                     //!< Installed DPKGs, parsed again when the status file changes
 #endif // defined(PF_DISTRO_ULINUX)
 #endif
 
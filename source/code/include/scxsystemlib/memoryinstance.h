@@ -15,6 +15,7 @@
 #define MEMORYINSTANCE_H
 
 #include <scxcorelib/scxlog.h>
+#include <scxcorelib/scxsamplescheduler.h>
 #include <scxcorelib/scxthread.h>
 #include <scxcorelib/scxhandle.h>
 #include <scxcorelib/scxthreadlock.h>
@@ -152,14 +153,14 @@ namespace SCXSystemLib
         MemoryInstanceDataSampler m_pageWrites;         //!< Data sampler for page writes.
         bool m_reservedMemoryIsSupported;               //!< Is m_reservedMemory a usable number?
 
-        SCXCoreLib::SCXHandle<SCXCoreLib::SCXThread> m_dataAquisitionThread;  //!< Pointer to thread body.
+        SCXCoreLib::SCXSampleScheduler::SamplerId m_samplerId;  //!< Registration with the sample scheduler (0 if none).
 
 #if defined(sun)
         SCXCoreLib::SCXHandle<SCXKstat> m_kstat;         //!< kstat structure used to get data on Solaris
         SCXCoreLib::SCXThreadLockHandle m_kstat_lock_handle; //!< Lock to serialize access to kstat functions
 #endif
 
-        static void DataAquisitionThreadBody(SCXCoreLib::SCXThreadParamHandle& param);
+        static void DataAquisitionSampleBody(SCXCoreLib::SCXThreadParamHandle& param);
 
     protected:
 #if defined(linux)
@@ -20,6 +20,7 @@
 #include <scxcorelib/scxlog.h>
 #include <scxsystemlib/scxdatadef.h>
 #include <algorithm>
+#include <map>
 #include <vector>
 #include <string>
  
@@ -37,6 +38,7 @@
 #elif defined(linux)
 #include <ifaddrs.h>
 #include <unistd.h>
+#include <scxsystemlib/scxnetlinkroute.h>
 #endif
 
 #if (defined(sun) && defined(sparc) && PF_MINOR==10)
@@ -51,7 +53,17 @@ namespace SCXSystemLib {
     {
     public:
         //! Constructor
-        NetworkInterfaceDependencies() { }
+        //! \param[in] useNetlink  Look up the interfaces with netlink where available, rather
+        //!                        than in the dynamic info file and with ioctl() calls
+        explicit NetworkInterfaceDependencies(bool useNetlink = false)
+#if defined(linux)
+            : m_netlinkRoute(useNetlink ? new NetlinkRouteSocket() : 0)
+#endif
+        {
+#if !defined(linux)
+            (void) useNetlink;
+#endif
+        }
                 
         /*----------------------------------------------------------------------------*/
         /**
@@ -79,6 +91,7 @@ namespace SCXSystemLib {
         }
 #if defined(linux)
         virtual SCXCoreLib::SCXFilePath GetDynamicInfoFile() const;
+        virtual SCXCoreLib::SCXHandle<NetlinkRouteSocket> GetNetlinkRouteSocket();
 #if !defined(ppc)
         virtual  SCXCoreLib::SCXFilePath GetVirtualInterfaceDirectory() const;
 #endif
@@ -161,6 +174,10 @@ namespace SCXSystemLib {
     protected:
         //! Prevent copying to avoid slicing
         NetworkInterfaceDependencies(const NetworkInterfaceDependencies &);
+#if defined(linux)
+    private:
+        SCXCoreLib::SCXHandle<NetlinkRouteSocket> m_netlinkRoute;  //!< Kept open between lookups, NULL without netlink
+#endif
     };
     /*----------------------------------------------------------------------------*/
     //!
@@ -229,6 +246,20 @@ namespace SCXSystemLib {
         L"CoWan",                                     //!< 12 (0xC) CoWan                                 
         L"1394"                                       //!< 13 (0xD) 1394
     };
+    /*----------------------------------------------------------------------------*/
+    //! Number of system calls issued while looking up network interfaces
+    struct NetworkInterfaceRefreshCounters
+    {
+        //! Constructor
+        NetworkInterfaceRefreshCounters() : fileReads(0), sockets(0), ioctls(0), addressLookups(0), netlinkDumps(0) { }
+
+        scxulong fileReads;         //!< Reads of the interface statistics file
+        scxulong sockets;           //!< Sockets opened to issue ioctl() calls on
+        scxulong ioctls;            //!< ioctl() calls
+        scxulong addressLookups;    //!< Lookups of all interface addresses (getifaddrs())
+        scxulong netlinkDumps;      //!< Netlink dumps of all links or addresses
+    };
+
     /*----------------------------------------------------------------------------*/
     //! Information about a network interface
     //! \note IPAddress, netmask and broadcast address are only available if the interface 
@@ -253,11 +284,16 @@ namespace SCXSystemLib {
             eAutoSense        = (1 << 13), //!< Represents the attribute "AutoSense"
             eInterfaceIndex   = (1 << 14), //!< represents the attribute "InterfaceIndex"
             eSpeed            = (1 << 15), //!< represents the attribute "Speed"
-            eMTU              = (1 << 16)  //!< represents the attribute "MTU"
+            eMTU              = (1 << 16), //!< represents the attribute "MTU"
+            eDropsReceiving   = (1 << 17), //!< Represents the attribute "drops receiving"
+            eDropsSending     = (1 << 18)  //!< Represents the attribute "drops sending"
          };
 
         static std::vector<NetworkInterfaceInfo> FindAll(SCXCoreLib::SCXHandle<NetworkInterfaceDependencies> deps,
-                                                         bool includeNonRunning = false, std::wstring interface = L"");
+                                                         bool includeNonRunning = false, std::wstring interface = L"",
+                                                         NetworkInterfaceRefreshCounters *counters = NULL);
+        static std::vector<NetworkInterfaceInfo> FindAllStatistics(SCXCoreLib::SCXHandle<NetworkInterfaceDependencies> deps,
+                                                                   NetworkInterfaceRefreshCounters *counters = NULL);
 
         /* The speed values: 10Mb, 100Mb, gigabit, 10Gb. */
         enum 
@@ -371,6 +407,26 @@ namespace SCXSystemLib {
         //! Number of collisons that have occurred on interface
         //! \returns Number of collisions
         scxulong GetCollisions() const {SCXASSERT(IsKnownIfCollisions()); return m_collisions; }
+
+        //! Check if receive drops is known
+        //! \returns true iff receive drops is known
+        bool IsKnownIfReceiveDrops() const {return IsValueKnown(eDropsReceiving); }
+
+        //! Number of packets received on interface but dropped
+        //! \returns    Number of packets
+        scxulong GetDropsReceiving() const {SCXASSERT(IsKnownIfReceiveDrops()); return m_dropsReceiving; }
+
+        //! Check if send drops is known
+        //! \returns true iff send drops is known
+        bool IsKnownIfSendDrops() const {return IsValueKnown(eDropsSending); }
+
+        //! Number of packets to send on interface but dropped
+        //! \returns    Number of packets
+        scxulong GetDropsSending() const {SCXASSERT(IsKnownIfSendDrops()); return m_dropsSending; }
+
+        //! Are the traffic counters 32-bit ones that wrap at 2^32
+        //! \returns true iff the source of the counters only keeps 32 bits
+        bool AreCounters32Bit() const { return m_counters32Bit; }
         
         //! Check if up is known
         //! \returns true iff up is known
@@ -542,7 +598,16 @@ namespace SCXSystemLib {
 
 #if defined(linux) 
         static void FindAllInFile(std::vector<NetworkInterfaceInfo> &interfaces,
-                                  SCXCoreLib::SCXHandle<NetworkInterfaceDependencies> deps, std::wstring interface = L"");
+                                  SCXCoreLib::SCXHandle<NetworkInterfaceDependencies> deps, std::wstring interface,
+                                  NetworkInterfaceRefreshCounters &counters);
+        static bool FindAllUsingNetlink(std::vector<NetworkInterfaceInfo> &interfaces,
+                                        SCXCoreLib::SCXHandle<NetworkInterfaceDependencies> deps, std::wstring interface,
+                                        NetworkInterfaceRefreshCounters &counters, bool withAddresses = true);
+
+        //! IPv6 addresses by interface name
+        typedef std::map<std::wstring, std::vector<std::wstring> > IPv6AddressMap;
+        static void FindAllIPv6Addr(SCXCoreLib::SCXHandle<NetworkInterfaceDependencies> deps,
+                                    IPv6AddressMap &addresses, SCXCoreLib::SCXLogHandle &log);
 #endif
 
 #if defined(aix)
@@ -561,15 +626,26 @@ namespace SCXSystemLib {
         //!
         //! \param fd file descriptor
         //! \param deps dependency
+        //! \param counters counts the ioctl() call
+        //!
+        void ParseHwAddr(int fd, SCXCoreLib::SCXHandle<NetworkInterfaceDependencies> deps,
+                         NetworkInterfaceRefreshCounters &counters);
+        //! set AdapterTypeID, AdapterType, PhysicalAdapter, MACAddress from
+        //! the hardware type and address of the interface.
         //!
-        void ParseHwAddr(int fd, SCXCoreLib::SCXHandle<NetworkInterfaceDependencies> deps);
+        //! \param family ARPHRD_* hardware type
+        //! \param addr first six bytes of the hardware address
+        //!
+        void SetHwAddr(unsigned short family, const unsigned char addr[6]);
         //! parse data get by ioctl(fd, SIOETHTOOL, ), will get attribute
         //! AutoSense, MaxSpeed, Speed
         //!
         //! \param fd file descriptor
         //! \param deps dependency
+        //! \param counters counts the ioctl() call
         //!
-        void ParseEthtool(int fd, SCXCoreLib::SCXHandle<NetworkInterfaceDependencies> deps);
+        void ParseEthtool(int fd, SCXCoreLib::SCXHandle<NetworkInterfaceDependencies> deps,
+                          NetworkInterfaceRefreshCounters &counters);
 #endif
 
 #if defined(hpux)
@@ -637,13 +713,20 @@ namespace SCXSystemLib {
         //!
         //! \param fd file descriptor
         //! \param deps dependency
+        //! \param counters counts the ioctl() call
         //! 
-        void ParseIndex(int fd, SCXCoreLib::SCXHandle<NetworkInterfaceDependencies> deps);
+        void ParseIndex(int fd, SCXCoreLib::SCXHandle<NetworkInterfaceDependencies> deps,
+                        NetworkInterfaceRefreshCounters &counters);
 #endif
         //! Parse IPv6 addresses
         //! \param[in]  deps    What this PAL depends on.
         void ParseIPv6Addr(SCXCoreLib::SCXHandle<NetworkInterfaceDependencies> deps);
 
+        //! Set up, running and the availability and connection status they imply
+        //! \param[in]  up       Is the interface up
+        //! \param[in]  running  Is the interface running
+        void SetUpAndRunning(bool up, bool running);
+
         //! init some private members
         //!
         void init();
@@ -673,6 +756,9 @@ namespace SCXSystemLib {
         scxulong m_errorsSending;    //!< Number of errors that have occurred when sending to interface
         scxulong m_errorsReceiving;  //!< Number of errors that have occurred when receiving from interface
         scxulong m_collisions;       //!< Number of collisons that have occurred on interface
+        scxulong m_dropsReceiving;   //!< Number of packets received on interface but dropped
+        scxulong m_dropsSending;     //!< Number of packets to send on interface but dropped
+        bool m_counters32Bit;        //!< Do the traffic counters wrap at 2^32
         bool m_up;                   //!< Is the interface up
         bool m_running;              //!< Is the interface running
 
@@ -56,7 +56,7 @@ namespace SCXSystemLib
             \param deps - Handle to the dependencies object to be used by this instance.
         */
         NetworkInterfaceConfigurationEnumeration(SCXCoreLib::SCXHandle<NetworkInterfaceDependencies> deps = 
-            SCXCoreLib::SCXHandle<NetworkInterfaceDependencies>(new NetworkInterfaceDependencies));
+            SCXCoreLib::SCXHandle<NetworkInterfaceDependencies>(new NetworkInterfaceDependencies(true)));
         virtual ~NetworkInterfaceConfigurationEnumeration();
         std::vector<NetworkInterfaceConfigurationInstance> FindAll();
         virtual void Init();
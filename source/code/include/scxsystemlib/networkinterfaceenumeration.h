@@ -14,6 +14,7 @@
 #ifndef NETWORKINTERFACEENUMERATION_H
 #define NETWORKINTERFACEENUMERATION_H
 
+#include <scxsystemlib/networkinterface.h>
 #include <scxsystemlib/networkinterfaceinstance.h>
 #include <scxsystemlib/entityenumeration.h>
 #include <scxsystemlib/cpuinstance.h>
@@ -22,8 +23,6 @@
 
 namespace SCXSystemLib
 {
-    class NetworkInterfaceDependencies;
-    
     /*----------------------------------------------------------------------------*/
     /**
         Represents a collection of network interfaces
@@ -37,6 +36,10 @@ namespace SCXSystemLib
         virtual void Init();
         virtual void Update(bool updateInstances=true);
         void UpdateSpecific(wstring interface=L"", size_t *pos=NULL);
+
+        //! System calls issued by the latest update
+        //! \returns Counters of the latest update
+        const NetworkInterfaceRefreshCounters& GetLastUpdateCounters() const { return m_lastUpdateCounters; }
     protected:
         virtual void UpdateInstances();
         virtual void UpdateEnumeration();
@@ -45,6 +48,7 @@ namespace SCXSystemLib
         SCXCoreLib::SCXLogHandle m_log;         //!< Log handle.
         SCXCoreLib::SCXHandle<NetworkInterfaceDependencies> m_deps; //!< Dependencies to rely on
         bool m_includeNonRunning; //!< Return all interfaces (rather than UP and/or RUNNING interfaces only)
+        NetworkInterfaceRefreshCounters m_lastUpdateCounters; //!< System calls issued by the latest update
     };
 }
 
@@ -31,7 +31,9 @@ namespace SCXSystemLib
     {
     public:
         NetworkInterfaceInstance(const NetworkInterfaceInfo &info);
+        NetworkInterfaceInstance(const NetworkInterfaceInstance &source);
         virtual ~NetworkInterfaceInstance();
+        NetworkInterfaceInstance &operator=(const NetworkInterfaceInstance &source);
 
         std::wstring GetName() const;
 
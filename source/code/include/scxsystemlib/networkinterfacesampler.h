@@ -0,0 +1,170 @@
+/*--------------------------------------------------------------------------------
+    Copyright (c) Microsoft Corporation. All rights reserved. See license.txt for license information.
+
+*/
+/**
+    \file
+
+    \brief       Background sampling of network interface traffic rates
+
+    \date        2026-10-16 20:00:00
+
+*/
+/*----------------------------------------------------------------------------*/
+#ifndef NETWORKINTERFACESAMPLER_H
+#define NETWORKINTERFACESAMPLER_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <scxsystemlib/datasampler.h>
+#include <scxsystemlib/networkinterface.h>
+#include <scxcorelib/scxhandle.h>
+#include <scxcorelib/scxlog.h>
+#include <scxcorelib/scxsamplescheduler.h>
+#include <scxcorelib/scxthread.h>
+#include <scxcorelib/scxthreadlock.h>
+
+namespace SCXSystemLib
+{
+    const scxulong NETWORK_MS_PER_SAMPLE = 1000;            //!< Default time between samples
+    const size_t MAX_NETWORK_DATASAMPLER_SAMPLES = 61;      //!< Default history: one minute at one sample a second
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Traffic rates of a network interface over a window of time.
+
+        Counters the platform does not report are sampled as zero, so their
+        rates are zero as well.
+    */
+    struct NetworkInterfaceRates
+    {
+        //! Constructor
+        NetworkInterfaceRates() :
+            windowMs(0),
+            bytesReceivedPerSecond(0), bytesSentPerSecond(0),
+            packetsReceivedPerSecond(0), packetsSentPerSecond(0),
+            errorsReceivingPerSecond(0), errorsSendingPerSecond(0),
+            dropsReceivingPerSecond(0), dropsSendingPerSecond(0)
+        { }
+
+        scxulong windowMs;                  //!< Time actually covered by the samples used
+        double bytesReceivedPerSecond;      //!< Bytes received
+        double bytesSentPerSecond;          //!< Bytes sent
+        double packetsReceivedPerSecond;    //!< Packets received
+        double packetsSentPerSecond;        //!< Packets sent
+        double errorsReceivingPerSecond;    //!< Errors receiving
+        double errorsSendingPerSecond;      //!< Errors sending
+        double dropsReceivingPerSecond;     //!< Received packets dropped
+        double dropsSendingPerSecond;       //!< Packets to send dropped
+    };
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Samples the traffic counters of all network interfaces in the background
+        and computes rates from the history.
+
+        Registers with the sample scheduler when initiated. Each sample is one
+        NetworkInterfaceInfo::FindAllStatistics() lookup, which on Linux is a
+        single netlink dump however many interfaces there are.
+
+        The history of an interface holds running totals rather than the raw
+        counters. A counter that decreases is taken to have wrapped at 32 bits
+        if the source only keeps 32 bits (IFLA_STATS, or /proc/net/dev on old
+        32-bit kernels) and it was in the upper half of that range, and to have
+        been reset otherwise, so rates stay right across both. An interface
+        that disappears, or that comes back with another interface index,
+        starts over with an empty history.
+
+        Samples are time stamped with a monotonic clock where there is one, so
+        setting the time of day does not distort the rates.
+    */
+    class NetworkInterfaceSampler
+    {
+    public:
+        NetworkInterfaceSampler(SCXCoreLib::SCXHandle<NetworkInterfaceDependencies> deps,
+                                scxulong periodMs = NETWORK_MS_PER_SAMPLE,
+                                size_t maxSamples = MAX_NETWORK_DATASAMPLER_SAMPLES);
+        virtual ~NetworkInterfaceSampler();
+
+        void Init();
+        void CleanUp();
+        void Sample();
+        void Sample(scxulong timestampMs);
+
+        bool GetRates(const std::wstring& name, scxulong windowMs, NetworkInterfaceRates& rates) const;
+        std::vector<std::wstring> GetInterfaceNames() const;
+        NetworkInterfaceRefreshCounters GetLastSampleCounters() const;
+
+        //! Get the time between samples
+        //! \returns Milliseconds between samples
+        scxulong GetPeriod() const { return m_periodMs; }
+
+        //! Get the number of samples kept per interface
+        //! \returns Maximum number of samples
+        size_t GetMaxSamples() const { return m_maxSamples; }
+
+        static void InterfaceSampler(SCXCoreLib::SCXThreadParamHandle& param);
+
+    private:
+        // Do not allow copying
+        NetworkInterfaceSampler(const NetworkInterfaceSampler &);               //!< Intentionally not implemented
+        NetworkInterfaceSampler & operator=(const NetworkInterfaceSampler &);   //!< Intentionally not implemented
+
+        //! Counters sampled for each interface, the time stamp last
+        enum SampledCounter
+        {
+            eBytesReceived, eBytesSent, ePacketsReceived, ePacketsSent,
+            eErrorsReceiving, eErrorsSending, eDropsReceiving, eDropsSending,
+            eTimeStamp,
+            eSampledCounterCount
+        };
+
+        /** History of one interface. */
+        struct SampledInterface
+        {
+            SampledInterface(unsigned int interfaceIndex, size_t maxSamples);
+
+            unsigned int index;                             //!< Interface index, 0 if not known
+            scxulong lastSeen;                              //!< Latest sample the interface was in
+            scxulong last[eTimeStamp];                      //!< Counters as last reported
+            scxulong totals[eTimeStamp];                    //!< Running totals, corrected for wraps and resets
+            DataSamplerArray<scxulong> samples;             //!< History of the totals and time stamps
+        };
+        typedef std::map<std::wstring, SCXCoreLib::SCXHandle<SampledInterface> > InterfaceMap;
+
+        static scxulong Advance(scxulong last, scxulong current, bool counter32);
+
+        SCXCoreLib::SCXLogHandle m_log;                         //!< Log handle
+        SCXCoreLib::SCXHandle<NetworkInterfaceDependencies> m_deps; //!< Dependencies to rely on
+        scxulong m_periodMs;                                    //!< Time between samples
+        size_t m_maxSamples;                                    //!< Samples kept per interface
+        SCXCoreLib::SCXSampleScheduler::SamplerId m_samplerId;  //!< Registration with the sample scheduler (0 if none)
+        SCXCoreLib::SCXThreadLockHandle m_lock;                 //!< Protects the members below
+        InterfaceMap m_interfaces;                              //!< Histories by interface name
+        scxulong m_sampleCount;                                 //!< Number of samples taken
+        NetworkInterfaceRefreshCounters m_lastSampleCounters;   //!< System calls issued by the latest sample
+    };
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Parameters for the sampler keeping the network interface histories up to date.
+    */
+    class NetworkInterfaceSamplerParam : public SCXCoreLib::SCXThreadParam
+    {
+    public:
+        /*----------------------------------------------------------------------------*/
+        /**
+           Constructor
+        */
+        NetworkInterfaceSamplerParam()
+            : m_sampler(NULL)
+        {}
+
+        NetworkInterfaceSampler* m_sampler;  //!< Sampler to run
+    };
+}
+
+#endif /* NETWORKINTERFACESAMPLER_H */
+/*----------------------------E-N-D---O-F---F-I-L-E---------------------------*/
@@ -0,0 +1,111 @@
+/*--------------------------------------------------------------------------------
+    Copyright (c) Microsoft Corporation. All rights reserved. See license.txt for license information.
+
+*/
+/**
+    \file
+
+    \brief       Reads of per-process files relative to an open /proc directory
+
+    \date        2026-10-17 00:30:00
+
+*/
+/*----------------------------------------------------------------------------*/
+#ifndef PROCDIRECTORY_H
+#define PROCDIRECTORY_H
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <scxcorelib/scxcmn.h>
+#include <scxcorelib/scxthreadlock.h>
+
+namespace SCXSystemLib
+{
+    /*----------------------------------------------------------------------------*/
+    /**
+        System calls issued by reads of files under /proc.
+    */
+    struct ProcReadCounters
+    {
+        //! Constructor
+        ProcReadCounters() : opens(0), reads(0), closes(0), stats(0) { }
+
+        //! \returns Number of system calls of all kinds
+        scxulong GetTotal() const { return opens + reads + closes + stats; }
+
+        scxulong opens;         //!< openat() calls
+        scxulong reads;         //!< pread() calls
+        scxulong closes;        //!< close() calls
+        scxulong stats;         //!< fstat() and fstatat() calls
+    };
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Holds /proc open and looks up the files of processes relative to it,
+        or relative to a directory of a process that is kept open.
+
+        Files that are read again and again, such as /proc/#/stat, can be kept
+        open: a pread() at offset 0 makes the kernel render the contents anew,
+        so a sample costs one system call instead of three. A descriptor kept
+        open also stays bound to the process it was opened for; once that
+        process is gone, reads fail with ESRCH even if the pid is reused.
+
+        Every descriptor kept open counts against a budget, so that sampling a
+        system with very many processes cannot exhaust the descriptors of the
+        process. The default budget is a quarter of the soft RLIMIT_NOFILE
+        limit. Descriptors are opened close-on-exec, since child processes only
+        close the first few thousand descriptors they inherit.
+
+        The budget may be used from any thread. The counters are not locked;
+        they are only kept right if all counted calls come from one thread at
+        a time, as they do from ProcessEnumeration::SampleData().
+    */
+    class ProcDirectory
+    {
+    public:
+        ProcDirectory();
+        explicit ProcDirectory(size_t maxKeptFiles);
+        ~ProcDirectory();
+
+        int Open(int dirFd, const char* name, int flags = 0);
+        ssize_t Read(int fd, char* buffer, size_t size);
+        void Close(int fd);
+        int Stat(int dirFd, const char* name, struct stat* st);
+
+        bool ReserveKeptFile();
+        void ReleaseKeptFile(int fd);
+
+        //! \returns Number of descriptors kept open against the budget
+        size_t GetKeptFileCount() const { return m_keptFiles; }
+        //! \returns Largest number of descriptors that may be kept open
+        size_t GetMaxKeptFiles() const { return m_maxKeptFiles; }
+        //! Set the largest number of descriptors that may be kept open.
+        //! Descriptors already kept open stay open.
+        //! \param[in] maxKeptFiles  The new budget
+        void SetMaxKeptFiles(size_t maxKeptFiles) { m_maxKeptFiles = maxKeptFiles; }
+
+        //! \returns System calls counted since the counters were reset
+        const ProcReadCounters& GetCounters() const { return m_counters; }
+        //! Reset the system call counters
+        void ResetCounters() { m_counters = ProcReadCounters(); }
+
+        static size_t GetDefaultMaxKeptFiles();
+
+    private:
+        // Do not allow copying
+        ProcDirectory(const ProcDirectory &);               //!< Intentionally not implemented
+        ProcDirectory & operator=(const ProcDirectory &);   //!< Intentionally not implemented
+
+        void OpenProc();
+
+        SCXCoreLib::SCXThreadLockHandle m_lock; //!< Protects the budget
+        int m_fd;                               //!< /proc, -1 if it could not be opened
+        size_t m_maxKeptFiles;                  //!< Budget of descriptors kept open
+        size_t m_keptFiles;                     //!< Descriptors kept open
+        ProcReadCounters m_counters;            //!< System calls counted
+    };
+}
+
+#endif /* PROCDIRECTORY_H */
+/*----------------------------E-N-D---O-F---F-I-L-E---------------------------*/
@@ -0,0 +1,84 @@
+/*--------------------------------------------------------------------------------
+    Copyright (c) Microsoft Corporation. All rights reserved. See license.txt for license information.
+
+*/
+/**
+    \file
+
+    \brief       Shared pool of process command lines
+
+    \date        2026-10-16 23:00:00
+
+*/
+/*----------------------------------------------------------------------------*/
+#ifndef PROCESSCOMMANDLINEPOOL_H
+#define PROCESSCOMMANDLINEPOOL_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <scxcorelib/scxcmn.h>
+#include <scxcorelib/scxsingleton.h>
+#include <scxcorelib/scxthreadlock.h>
+
+namespace SCXSystemLib
+{
+    /*----------------------------------------------------------------------------*/
+    /**
+        Interns process command lines, so that processes started with the same
+        arguments share one copy of them.
+
+        Busy systems run many processes with identical command lines, such as
+        the workers of a web server or of a PHP FastCGI pool. Each distinct
+        command line is kept once, together with the number of users of it;
+        it is removed when the last user releases it.
+
+        The command lines handed out stay valid and unchanged until released.
+        All methods may be called from any thread.
+    */
+    class ProcessCommandLinePool : public SCXCoreLib::SCXSingleton<ProcessCommandLinePool>
+    {
+        friend class SCXCoreLib::SCXSingleton<ProcessCommandLinePool>;
+
+    public:
+        /** The arguments of a command line, argv[0] first. */
+        typedef std::vector<std::string> CommandLine;
+
+        ProcessCommandLinePool();
+        virtual ~ProcessCommandLinePool();
+        const std::wstring DumpString() const;
+
+        const CommandLine* Acquire(const char* data, size_t length);
+        const CommandLine* Acquire(const CommandLine& args);
+        void Release(const CommandLine* cmdLine);
+
+        size_t GetCount() const;
+        size_t GetUserCount() const;
+
+    private:
+        // Do not allow copying
+        ProcessCommandLinePool(const ProcessCommandLinePool &);             //!< Intentionally not implemented
+        ProcessCommandLinePool & operator=(const ProcessCommandLinePool &); //!< Intentionally not implemented
+
+        /**
+            Interned command lines, each with the number of Acquire() calls
+            not yet released. The keys are what Acquire() hands out.
+        */
+        typedef std::map<CommandLine, size_t> EntryMap;
+
+        SCXCoreLib::SCXThreadLockHandle m_lock; //!< Protects all members below
+        EntryMap m_entries;                     //!< Interned command lines
+        size_t m_userCount;                     //!< Sum of the users of all entries
+    };
+}
+
+namespace SCXCoreLib
+{
+    SCXSingleton_Define(SCXSystemLib::ProcessCommandLinePool);
+}
+
+#include <scxcorelib/scxsingleton-defs.h>
+
+#endif /* PROCESSCOMMANDLINEPOOL_H */
+/*----------------------------E-N-D---O-F---F-I-L-E---------------------------*/
@@ -18,6 +18,7 @@
 #include <scxcorelib/scxexception.h>
 #include <scxcorelib/scxhandle.h>
 #include <scxcorelib/scxlog.h>
+#include <scxcorelib/scxsamplescheduler.h>
 #include <scxcorelib/scxthread.h>
 #include <scxsystemlib/entityenumeration.h>
 #include <scxsystemlib/processinstance.h>
@@ -55,6 +56,14 @@ namespace SCXSystemLib
     /** Type of live process map. One pid corresponds to one process. */
     typedef std::map<scxpid_t, SCXCoreLib::SCXHandle<ProcessInstance> > ProcMap;
 
+    /** What ProcessEnumeration::TopN() ranks processes by. */
+    enum ProcessRankKey
+    {
+        eRankByCPUTime,                 //!< CPU time used per second of the sampled interval
+        eRankByUsedMemory,              //!< Resident set size
+        eRankByHardPageFaults           //!< Hard page faults per second of the sampled interval
+    };
+
     /*----------------------------------------------------------------------------*/
     /**
         Class that represents a collection of Process:s.
@@ -81,8 +90,18 @@ namespace SCXSystemLib
         /* This one is public for testing purposes */
         void SampleData();
 
+        void SetIncrementalSampling(bool incremental);
+        bool GetIncrementalSampling() const;
+        void SetIoStatistics(bool sample);
+        bool GetIoStatistics() const;
+#if defined(linux)
+        ProcReadCounters GetLastSampleCounters() const;
+#endif
+
         SCXCoreLib::SCXHandle<ProcessInstance> Find(scxpid_t pid);
         std::vector<SCXCoreLib::SCXHandle<ProcessInstance> > Find(const std::wstring& name);
+        std::vector<SCXCoreLib::SCXHandle<ProcessInstance> > TopN(size_t n, ProcessRankKey key);
+        static bool RanksHigher(const ProcessMetrics& a, const ProcessMetrics& b, ProcessRankKey key);
         static bool SendSignalByName(const std::wstring& name, int sig);
         static bool GetNumberOfProcesses(unsigned int& numberOfProcesses);
 
@@ -90,12 +109,29 @@ namespace SCXSystemLib
         SCXCoreLib::SCXLogHandle m_log;                         //!< Handle to log file 
         SCXCoreLib::SCXThreadLockHandle m_lock; //!< Handles locking in the process enumeration.
 
-        SCXCoreLib::SCXHandle<SCXCoreLib::SCXThread> m_dataAquisitionThread; //!< Thread pointer.
-        static void DataAquisitionThreadBody(SCXCoreLib::SCXThreadParamHandle& param);
+        SCXCoreLib::SCXSampleScheduler::SamplerId m_samplerId; //!< Registration with the sample scheduler (0 if none).
+        static void DataAquisitionSampleBody(SCXCoreLib::SCXThreadParamHandle& param);
 
         /** Map of active processes */
         ProcMap m_procs;
 
+        bool m_incrementalSampling;     //!< Re-read only counters of known processes?
+        bool m_ioStatistics;            //!< Sample I/O and scheduler statistics of processes?
+        scxulong m_staticRefreshCount;  //!< Incremental updates that re-read static attributes
+        scxulong m_replacedCount;       //!< Known pids found to belong to a new process
+#if defined(linux)
+        SCXCoreLib::SCXHandle<ProcDirectory> m_procDir; //!< /proc, shared with the instances
+        ProcReadCounters m_lastSampleCounters;          //!< System calls issued by the latest sample
+#endif
+
+#if defined(linux) || defined(sun)
+        bool UpdateKnownInstance(ProcMap::iterator& pos, const char* handle);
+#elif defined(aix)
+        bool UpdateKnownInstance(ProcMap::iterator& pos, struct procentry64* handle);
+#elif defined(hpux)
+        bool UpdateKnownInstance(ProcMap::iterator& pos, struct pst_status* handle);
+#endif
+
         int m_EnumErrorCount;    //!< Number of consecutive enumeration attempts with errors.
         int m_EnumGoodCount;     //!< Number of consecutive enumeration attempts without errors.
         SCXCoreLib::SCXLogSeverity m_EnumLogLevel;  //!< Log level to use when logging execption during instance update
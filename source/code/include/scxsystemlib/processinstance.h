@@ -26,6 +26,7 @@
 #if defined(linux)
 #include <unistd.h>
 #include <scxsystemlib/procfsreader.h>
+#include <scxsystemlib/procdirectory.h>
 #endif // defined(linux)
 
 #if defined(hpux)
@@ -55,9 +56,14 @@
 
 #include <scxsystemlib/entityinstance.h>
 #include <scxsystemlib/datasampler.h>
+#include <scxsystemlib/processcommandlinepool.h>
 #include <scxcorelib/stringaid.h>
+#include <scxcorelib/scxhandle.h>
 #include <scxcorelib/scxlog.h>
 #include <scxcorelib/scxtime.h>
+#include <scxcorelib/scxthreadlock.h>
+
+class ProcessPAL_Test;
 
 namespace SCXSystemLib
 {
@@ -109,15 +115,8 @@ namespace SCXSystemLib
     private:
         static const int procstat_len = 40; //!< Number of fields not counting dummy
 
-        /** The format string that should be supplied to fscanf() to read procstat_fields */
-        static const char *scanstring;  /* =
-        "%d %s %c %d %d %d %d %d %lu %lu " // 1 to 10
-        "%lu %lu %lu %lu %lu %ld %ld %ld %ld %*ld " // 11 to 20
-        "%ld %lu %lu %ld %lu %lu %lu %lu %lu %lu " // 21 to 30
-        "%lu %lu %lu %lu %lu %lu %lu %d %d %lu %lu"; // 31 to 41
-                                       */
     public:
-        bool ReadStatFile(FILE *filePointer, const char* filename);
+        bool ParseStatBuffer(const char* buffer, size_t length, const char* filename);
     };
 
     /** Holds Linux memory statistics */
@@ -133,10 +132,58 @@ namespace SCXSystemLib
     private:
         static const int procstat_len = 6; //!< Number of fields
 
-        /** The format string that should be supplied to fscanf() to read procstat_fields */
-        static const char *scanstring;  /* = "%lu %lu %lu %lu %lu %lu" */
     public:
-        bool ReadStatMFile(FILE *filePointer, const char* filename);
+        bool ParseStatMBuffer(const char* buffer, size_t length, const char* filename);
+    };
+
+    /** Holds the fields of /proc/#/status that we use */
+    struct LinuxProcStatus {
+        uid_t realUid;          //!< Real user ID (first value on the "Uid:" line)
+
+        bool ParseStatusBuffer(const char* buffer, size_t length);
+    };
+
+    /** Holds the fields of /proc/#/io and /proc/#/schedstat that we use */
+    struct LinuxProcIo {
+        scxulong readCalls;     //!< Read system calls ("syscr")
+        scxulong writeCalls;    //!< Write system calls ("syscw")
+        scxulong readBytes;     //!< Bytes fetched from storage ("read_bytes")
+        scxulong writeBytes;    //!< Bytes sent to storage ("write_bytes")
+        scxulong runDelay;      //!< Nanoseconds spent runnable, waiting for a CPU (second schedstat field)
+
+        bool ParseIoBuffer(const char* buffer, size_t length);
+        bool ParseSchedStatBuffer(const char* buffer, size_t length);
+    };
+
+    /**
+       The fields of /proc/#/stat and /proc/#/statm that a ProcessInstance
+       keeps between samples. The files are parsed into a LinuxProcStat and a
+       LinuxProcStatM on the stack, and only these fields are copied, which
+       takes far less room than keeping the whole structures.
+    */
+    struct LinuxProcInfo {
+        int processId;                           //!< stat: process id
+        char command[sizeof(LinuxProcStat().command)];  //!< stat: command name
+        char state;                              //!< stat: state
+        int parentProcessId;                     //!< stat: parent process id
+        int processGroupId;                      //!< stat: process group id
+        int sessionId;                           //!< stat: session id
+        unsigned long majorFaults;               //!< stat: major page faults
+        unsigned long userTime;                  //!< stat: user time in jiffies
+        unsigned long systemTime;                //!< stat: system time in jiffies
+        long childUserTime;                      //!< stat: user time of waited-for children
+        long childSystemTime;                    //!< stat: system time of waited-for children
+        long priority;                           //!< stat: priority
+        long nice;                               //!< stat: nice value
+        unsigned long startTime;                 //!< stat: start time in jiffies after boot
+        unsigned long virtualMemSizeBytes;       //!< stat: virtual memory size in bytes
+        long residentSetSize;                    //!< stat: resident set size in pages
+        unsigned long share;                     //!< statm: shared pages
+        unsigned long text;                      //!< statm: text (code) pages
+        unsigned long data;                      //!< statm: data/stack pages
+
+        void Assign(const LinuxProcStat& stat);
+        void Assign(const LinuxProcStatM& statm);
     };
 
 #endif /* Linux */
@@ -224,6 +271,12 @@ namespace SCXSystemLib
     /** Number of samples collected in the datasampler for CPU. */
     const size_t MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES = 6;
 
+    /** Number of incremental samples after which static process attributes are re-read even if unchanged. */
+    const unsigned int PROCESS_STATIC_REFRESH_SAMPLES = 10;
+
+    /** Size in bytes of the blocks reported by GetBlockReadsPerSecond() and GetBlockWritesPerSecond() on Linux. */
+    const scxulong PROCESS_IO_BLOCK_SIZE = 512;
+
     /** Datasampler for CPU information. */
     typedef DataSampler<scxulong> ScxULongDataSampler_t;
     /** Datasampler for time stored as a struct timeval */
@@ -233,6 +286,23 @@ namespace SCXSystemLib
     typedef DataSampler<scx_timestruc_t> TsDataSampler_t;
 #endif
 
+    /*----------------------------------------------------------------------------*/
+    /**
+        Compact summary of a process, used to rank processes without going
+        through the full ProcessInstance interface.
+
+        The CPU time and hard page faults are those of the sampled interval,
+        the same samples that GetCPUTime() and GetPagesReadPerSec() use.
+    */
+    struct ProcessMetrics
+    {
+        scxpid_t pid;                   //!< Process ID
+        scxulong cpuTime;               //!< User and system time used in the interval, in microseconds
+        scxulong interval;              //!< Length of the interval in milliseconds, 0 if not sampled twice
+        scxulong usedMemory;            //!< Resident set size, as GetUsedMemory()
+        scxulong hardPageFaults;        //!< Hard page faults in the interval
+    };
+
     /*----------------------------------------------------------------------------*/
 
     /**
@@ -243,36 +313,17 @@ namespace SCXSystemLib
     class ProcessInstance : public EntityInstance
     {
         friend class ProcessEnumeration;
+        friend class ::ProcessPAL_Test;
 
         static const wchar_t *moduleIdentifier;         //!< Shared module string
+        static const SCXCoreLib::SCXLogHandle& GetInstanceLogHandle();
 
     protected:
         // This constructor is added for unit-test purposes (See WI 516119).
         // Never use this for general use; it is solely for unit testing specific issues!
         ProcessInstance(const std::string &cmd, const std::string &params)
 #if defined(linux)
-          : m_RealTime_tics(MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES),
-            m_UserTime_tics(MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES),
-            m_SystemTime_tics(MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES),
-            m_HardPageFaults_tics(MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES)
-#elif defined(sun)
-          : m_RealTime_tics(MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES),
-            m_UserTime_tics(MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES),
-            m_SystemTime_tics(MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES),
-            m_BlockOut_tics(MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES),
-            m_BlockInp_tics(MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES),
-            m_HardPageFaults_tics(MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES)
-#elif defined(hpux)
-          : m_RealTime_tics(MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES),
-            m_UserTime_tics(MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES),
-            m_SystemTime_tics(MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES),
-            m_BlockOut_tics(MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES),
-            m_BlockInp_tics(MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES),
-            m_HardPageFaults_tics(MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES)
-#elif defined(aix)
-          : m_RealTime_tics(MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES),
-            m_UserTime_tics(MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES),
-            m_SystemTime_tics(MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES)
+          : m_cmdLineLock(SCXCoreLib::ThreadLockHandleGet())
 #endif
         {
 #if defined(linux)
@@ -285,10 +336,20 @@ namespace SCXSystemLib
             strncpy(m_pstatus.pst_ucomm, cmd.c_str(), sizeof(m_pstatus.pst_ucomm));
             m_pstatus.pst_ucomm[sizeof(m_pstatus.pst_ucomm)-1]='\0';
 #endif
+#if defined(linux)
+            m_procDirFd = m_statFd = m_statmFd = -1;
+            m_cmdLine = NULL;
+            m_cmdLineRead = true;
+            if (!params.empty())
+            {
+                m_cmdLine = ProcessCommandLinePool::Instance().Acquire(std::vector<std::string>(1, params));
+            }
+#else
             if (!params.empty())
             {
                 m_params.push_back(params);
             }
+#endif
         }
 
 #if defined(sun)
@@ -302,13 +363,38 @@ namespace SCXSystemLib
 #endif // defined(sun)
 
 #if defined(linux)
+    protected:
+        /** Outcome of an incremental update of an instance. */
+        enum IncrementalUpdateResult {
+            eProcessGone,               //!< The process no longer exists
+            eProcessReplaced,           //!< The pid now belongs to another process
+            eCountersUpdated,           //!< Only the counters were re-read
+            eStaticAttributesUpdated    //!< Counters and static attributes were re-read
+        };
+
+        IncrementalUpdateResult UpdateInstanceIncremental(void);
+
     private:
         void SetBootTime(void);
+        bool ReadCounterFiles(void);
+        bool ReadStaticAttributes(void);
+        void InvalidateCommandLine(void);
+        const ProcessCommandLinePool::CommandLine* ReadCommandLine(void) const;
+        void UpdateIoSampler(const struct timeval& realtime, bool enabled);
+        void OpenProcessDirectory(void);
+        void CloseProcessFiles(void);
+        int OpenProcessFile(const char* name, int flags);
+        ssize_t ReadProcessFile(const char* name, int* keptFd, char* buffer, size_t size, bool mayBeDenied = false);
+        int StatProcessFile(const char* name, struct stat* st);
 #endif
 
 #if defined(linux) || defined(sun)
     protected:
+#if defined(linux)
+        ProcessInstance(scxpid_t pid, const char* basename, SCXCoreLib::SCXHandle<ProcDirectory> procDir);
+#else
         ProcessInstance(scxpid_t pid, const char* basename);
+#endif
         bool UpdateInstance(const char* basename, bool initial);
 #endif // defined(linux) || defined(sun)
 
@@ -324,9 +410,11 @@ namespace SCXSystemLib
         bool UpdateInstance(struct pst_status *pstatus, bool initial);
 #endif // defined(hpux)
 
+#if !defined(linux)
     private:
         bool UpdateParameters(void);
         std::vector<std::string> m_params;
+#endif
 
     public:
         /** Gets the process ID which this instance represents. */
@@ -372,6 +460,13 @@ namespace SCXSystemLib
         bool GetPercentUsedMemory(scxulong &) const;
         bool GetPagesReadPerSec(scxulong &prs) const;
 
+        /* I/O and scheduler statistics, sampled if ProcessEnumeration::SetIoStatistics() is selected */
+        bool GetIOReadBytesPerSecond(scxulong &rbs) const;
+        bool GetIOWriteBytesPerSecond(scxulong &wbs) const;
+        bool GetIOReadCallsPerSecond(scxulong &rcs) const;
+        bool GetIOWriteCallsPerSecond(scxulong &wcs) const;
+        bool GetRunDelayPerSecond(scxulong &rds) const;
+
         /* Properties in SCX_UnixProcessStatisticalInformation, Phase 2 */
         bool GetRealText(scxulong &rt) const;
         bool GetRealData(scxulong &rd) const;
@@ -390,11 +485,16 @@ namespace SCXSystemLib
 
         std::wstring DumpString(void);
     private:
+        // Do not allow copying
+        ProcessInstance(const ProcessInstance &);               //!< Intentionally not implemented
+        ProcessInstance & operator=(const ProcessInstance &);   //!< Intentionally not implemented
+
         /** Tests if this instance was detected when scanning live processes. */
         bool WasFound() { bool found = m_found; m_found = false; return found; }
         void UpdateDataSampler(struct timeval& realtime);
         void UpdateTimedValues(void);
         void CheckRootAccess(void) const;
+        void GetMetrics(ProcessMetrics& metrics) const;
 
         SCXCoreLib::SCXLogHandle m_log;         //!< Log handle.
         scxpid_t m_pid;                         //!< Process ID of this instance
@@ -406,20 +506,50 @@ namespace SCXSystemLib
         unsigned int m_scxPriority;             //!< Value of the native priority mapped to windows priority levels.
         template<class t> void PriorityOutOfRangeError(t rawPriority);  // Error handling helper.
 #if defined(linux)
-        char m_procStatName[MAXPATHLEN];        //!< Name of /proc/#/stat file
-        char m_procStatMName[MAXPATHLEN];       //!< Name of /proc/#/statm file
         uid_t     m_uid;                        //!< User ID of owner
         gid_t     m_gid;                        //!< Group ID of owner
-        LinuxProcStat m;                        //!< Linux specific process information
-        LinuxProcStatM n;                       //!< Linux specific process information
+        uid_t     m_procDirUid;                 //!< Owner of /proc/# when static attributes were read
+        gid_t     m_procDirGid;                 //!< Group of /proc/# when static attributes were read
+        unsigned int m_samplesSinceStaticRefresh;       //!< Incremental samples since static attributes were read
+
+        /**
+           Budget permitting, /proc/# is kept open once the process has
+           been sampled, the files of the process are looked up relative to
+           it, and the counter files are kept open and re-read from their
+           start. Otherwise the files are looked up relative to /proc.
+        */
+        SCXCoreLib::SCXHandle<ProcDirectory> m_procDir; //!< /proc, shared with the enumeration
+        int       m_procDirFd;                  //!< /proc/# kept open, -1 if not
+        int       m_statFd;                     //!< /proc/#/stat kept open, -1 if not
+        int       m_statmFd;                    //!< /proc/#/statm kept open, -1 if not
+
+        /**
+           The command line is only read from /proc/#/cmdline when asked for,
+           at most once per update; see InvalidateCommandLine(). Identical
+           command lines share one copy through the ProcessCommandLinePool.
+
+           GetParameters() is const and may be called while the sampler
+           updates the instance, so m_cmdLine and m_cmdLineRead are only
+           touched under m_cmdLineLock.
+        */
+        SCXCoreLib::SCXThreadLockHandle m_cmdLineLock;                  //!< Protects m_cmdLine and m_cmdLineRead
+        mutable const ProcessCommandLinePool::CommandLine* m_cmdLine;   //!< Interned command line, NULL if empty
+        mutable bool m_cmdLineRead;             //!< Is m_cmdLine current?
+        LinuxProcInfo m;                        //!< Linux specific process information
         static SCXCoreLib::SCXCalendarTime m_system_boot; //!< Time of system boot
         unsigned int m_jiffies_per_second;              //!< Time base for PC Linux
         static const unsigned int m_pageSize = 4;       //!< Page size in KB on Linux
 
-        TvDataSampler_t       m_RealTime_tics;          //!< Data sampler for real time.
-        ScxULongDataSampler_t m_UserTime_tics;          //!< Data sampler for user time.
-        ScxULongDataSampler_t m_SystemTime_tics;        //!< Data sampler for system time.
-        ScxULongDataSampler_t m_HardPageFaults_tics;    //!< Data sampler for hard page faults.
+        /** Counters sampled by UpdateDataSampler() */
+        enum SampledCounter {
+            eRealTime,          //!< Microseconds
+            eUserTime,          //!< Jiffies
+            eSystemTime,        //!< Jiffies
+            eHardPageFaults,
+            eSampledCounterCount
+        };
+        /** Sample history, kept in the instance so sampling allocates nothing */
+        FixedDataSamplerArray<scxulong, eSampledCounterCount, MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES> m_samples;
 
         /* These are updated when UpdateTimedValues() is run. */
         struct timeval m_delta_RealTime;                //!< Elapsed real time at update
@@ -427,6 +557,36 @@ namespace SCXSystemLib
         scxulong m_delta_SystemTime;                    //!< Consumed system time at update
         scxulong m_delta_HardPageFaults;                //!< Executed page faults at update
 
+        /**
+           Sampled I/O and scheduler statistics. Only allocated while
+           ProcessEnumeration::SetIoStatistics() is selected, so processes
+           pay nothing for them otherwise.
+        */
+        struct IoSamples {
+            /** Sampled counters, the time stamp last */
+            enum Counter {
+                eReadBytes, eWriteBytes, eReadCalls, eWriteCalls, eRunDelay,
+                eTimeStamp,     //!< Milliseconds
+                eCounterCount
+            };
+
+            IoSamples() : known(0), samples(eCounterCount, MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES)
+            {
+            }
+
+            unsigned int known;                     //!< Counters read, as bits (1 << Counter)
+            DataSamplerArray<scxulong> samples;     //!< History of the counters
+        };
+        /** I/O statistics, NULL unless sampled. Only used under the enumeration
+            lock, by the sampler and UpdateTimedValues(); getters read the copies below. */
+        SCXCoreLib::SCXHandle<IoSamples> m_ioSamples;
+
+        /* These are updated when UpdateTimedValues() is run. */
+        unsigned int m_delta_IoKnown;                   //!< Counters known at update, as bits (1 << Counter)
+        scxulong m_delta_Io[IoSamples::eCounterCount];  //!< Changes of the I/O counters at update
+
+        bool GetIoItemsPerSecond(IoSamples::Counter counter, scxulong& value) const;
+
         scxulong ComputeItemsPerSecond(scxulong delta_item,             // Defined below
                                        const struct timeval& elapsedTime) const;
         unsigned int ComputePercentageOfTime(scxulong consumedTime,     // Defined below
@@ -452,12 +612,18 @@ namespace SCXSystemLib
     private:
         unsigned long m_clocksPerSecond;        //!< System clock ticks per second
 
-        TvDataSampler_t m_RealTime_tics;                //!< Data sampler for real time.
-        TsDataSampler_t m_UserTime_tics;                //!< Data sampler for user time.
-        TsDataSampler_t m_SystemTime_tics;              //!< Data sampler for system time.
-        ScxULongDataSampler_t m_BlockOut_tics;          //!< Data sampler for written blocks.
-        ScxULongDataSampler_t m_BlockInp_tics;          //!< Data sampler for read blocks.
-        ScxULongDataSampler_t m_HardPageFaults_tics;    //!< Data sampler for hard page faults.
+        /** Counters sampled by UpdateDataSampler() */
+        enum SampledCounter {
+            eRealTime,          //!< Microseconds
+            eUserTime,          //!< Nanoseconds
+            eSystemTime,        //!< Nanoseconds
+            eBlockOut,
+            eBlockInp,
+            eHardPageFaults,
+            eSampledCounterCount
+        };
+        /** Sample history, kept in the instance so sampling allocates nothing */
+        FixedDataSamplerArray<scxulong, eSampledCounterCount, MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES> m_samples;
 
         /* These are updated when UpdateTimedValues() is run. */
         struct timeval m_delta_RealTime;                //!< Elapsed real time at update
@@ -492,22 +658,28 @@ namespace SCXSystemLib
         };
 #endif // defined(sun)
 
+#if !defined(linux)
      private:
         inline bool StoreModuleAndArgs(const std::wstring & module, const std::wstring & args);
+#endif
 
 #if defined(hpux)
     private:
         struct pst_status m_pstatus;            //!< HP/UX specific process information
         static const unsigned int m_pageSize = 4; //!< Page size in KB on HP/UX
 
-        TvDataSampler_t       m_RealTime_tics;          //!< Data sampler for real time.
-        ScxULongDataSampler_t m_UserTime_tics;          //!< Data sampler for user time.
-        ScxULongDataSampler_t m_SystemTime_tics;        //!< Data sampler for system time.
-        //ScxULongDataSampler_t m_CPUTime_tics;           //!< Data sampler for cpu time.
-        //ScxULongDataSampler_t m_CPUTime_total_tics;     //!< Data sampler for process life time.
-        ScxULongDataSampler_t m_BlockOut_tics;          //!< Data sampler for written blocks.
-        ScxULongDataSampler_t m_BlockInp_tics;          //!< Data sampler for read blocks.
-        ScxULongDataSampler_t m_HardPageFaults_tics;    //!< Data sampler for hard page faults.
+        /** Counters sampled by UpdateDataSampler() */
+        enum SampledCounter {
+            eRealTime,          //!< Microseconds
+            eUserTime,          //!< Seconds
+            eSystemTime,        //!< Seconds
+            eBlockOut,
+            eBlockInp,
+            eHardPageFaults,
+            eSampledCounterCount
+        };
+        /** Sample history, kept in the instance so sampling allocates nothing */
+        FixedDataSamplerArray<scxulong, eSampledCounterCount, MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES> m_samples;
 
         /* These are updated when UpdateTimedValues() is run. */
         struct timeval m_delta_RealTime;                //!< Elapsed real time at update
@@ -566,9 +738,15 @@ namespace SCXSystemLib
 
         unsigned long m_clocksPerSecond;        //!< System clock ticks per second
 
-        TvDataSampler_t m_RealTime_tics;                //!< Data sampler for real time.
-        TsDataSampler_t m_UserTime_tics;                //!< Data sampler for user time.
-        TsDataSampler_t m_SystemTime_tics;              //!< Data sampler for system time.
+        /** Counters sampled by UpdateDataSampler() */
+        enum SampledCounter {
+            eRealTime,          //!< Microseconds
+            eUserTime,          //!< Nanoseconds
+            eSystemTime,        //!< Nanoseconds
+            eSampledCounterCount
+        };
+        /** Sample history, kept in the instance so sampling allocates nothing */
+        FixedDataSamplerArray<scxulong, eSampledCounterCount, MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES> m_samples;
 
         /* These are updated when UpdateTimedValues() is run. */
         struct timeval m_delta_RealTime;                //!< Elapsed real time at update
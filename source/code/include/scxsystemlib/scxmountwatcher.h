@@ -0,0 +1,52 @@
+/*--------------------------------------------------------------------------------
+  Copyright (c) Microsoft Corporation. All rights reserved. See license.txt for license information.
+
+*/
+/**
+   \file
+
+   \brief       Detects changes to the mount table
+
+   \date        2026-10-16 18:00:00
+
+*/
+/*----------------------------------------------------------------------------*/
+#ifndef SCXMOUNTWATCHER_H
+#define SCXMOUNTWATCHER_H
+
+#include <string>
+
+namespace SCXSystemLib
+{
+    /*----------------------------------------------------------------------------*/
+    /**
+       Tells whether anything has been mounted or unmounted since it was last asked.
+
+       On Linux, the kernel flags an open /proc/self/mountinfo file with
+       POLLPRI | POLLERR when the mount table of the process changes, so a poll()
+       with no timeout is enough to find out whether it must be read again.
+
+       Where that is not available, every call reports a change, so callers
+       simply fall back to reading the mount table every time.
+    */
+    class SCXMountWatcher
+    {
+    public:
+        explicit SCXMountWatcher(const std::string& path = "/proc/self/mountinfo");
+        virtual ~SCXMountWatcher();
+
+        bool HasChanged();
+        bool IsWatching() const;
+
+    private:
+        // Do not allow copying
+        SCXMountWatcher(const SCXMountWatcher &);               //!< Intentionally not implemented
+        SCXMountWatcher & operator=(const SCXMountWatcher &);   //!< Intentionally not implemented
+
+        int m_fd;           //!< Open mountinfo file, -1 if changes cannot be watched.
+        bool m_isFirst;     //!< Has HasChanged() not been called yet?
+    };
+}
+
+#endif /* SCXMOUNTWATCHER_H */
+/*----------------------------E-N-D---O-F---F-I-L-E---------------------------*/
@@ -0,0 +1,73 @@
+/*--------------------------------------------------------------------------------
+    Copyright (c) Microsoft Corporation. All rights reserved. See license.txt for license information.
+
+*/
+/**
+    \file
+
+    \brief       Routing netlink socket kept open between requests
+
+    \date        2026-10-16 19:00:00
+
+*/
+/*----------------------------------------------------------------------------*/
+#ifndef SCXNETLINKROUTE_H
+#define SCXNETLINKROUTE_H
+
+#include <vector>
+#include <sys/types.h>
+
+#include <scxcorelib/scxcmn.h>
+#include <scxcorelib/scxthreadlock.h>
+
+namespace SCXSystemLib
+{
+    /*----------------------------------------------------------------------------*/
+    /**
+        Dumps kernel tables (links, addresses) over a NETLINK_ROUTE socket.
+
+        One dump returns the entries of all network interfaces, however many
+        there are, in a send() and a few recv() calls. The socket is opened on
+        first use and kept open, so sampling does not pay for a socket() and a
+        close() each time. After a failure the socket is closed, and the next
+        dump opens a new one; replies still queued from a failed dump cannot
+        be mistaken for those of a later one.
+
+        A dump the kernel marks as interrupted (the table changed while it was
+        being dumped, so entries may be missing or repeated) is requested again,
+        a few times at most.
+
+        Dumps are serialized, so one instance may be shared between threads.
+
+        \note Only implemented on Linux; elsewhere Dump() always throws.
+    */
+    class NetlinkRouteSocket
+    {
+    public:
+        NetlinkRouteSocket();
+        virtual ~NetlinkRouteSocket();
+
+        virtual void Dump(unsigned short type, unsigned char family, std::vector<char>& messages);
+
+    protected:
+        virtual int socket(int domain, int type, int protocol);
+        virtual ssize_t send(int sockfd, const void *buf, size_t len, int flags);
+        virtual ssize_t recv(int sockfd, void *buf, size_t len, int flags);
+
+    private:
+        // Do not allow copying
+        NetlinkRouteSocket(const NetlinkRouteSocket &);               //!< Intentionally not implemented
+        NetlinkRouteSocket & operator=(const NetlinkRouteSocket &);   //!< Intentionally not implemented
+
+        bool DumpOnce(unsigned short type, unsigned char family, std::vector<char>& messages);
+        void Close();
+
+        SCXCoreLib::SCXThreadLockHandle m_lock; //!< Serializes dumps
+        int m_fd;                               //!< Open socket, -1 if none
+        unsigned int m_seq;                     //!< Sequence number of the latest request
+        std::vector<char> m_buffer;             //!< Receives the replies
+    };
+}
+
+#endif /* SCXNETLINKROUTE_H */
+/*----------------------------E-N-D---O-F---F-I-L-E---------------------------*/
@@ -65,6 +65,8 @@ namespace SCXSystemLib
     protected:
         SCXCoreLib::SCXHandle<DiskDepend> m_deps; //!< Disk dependency object for dependency injection
         SCXCoreLib::SCXLogHandle m_log;         //!< Log handle
+        scxulong m_mntTabGeneration;            //!< Mount tab generation the instances were last updated from
+        size_t m_mntTabSize;                    //!< Number of instances after that update
 
 #if defined(sun)
         std::map<std::wstring, DevTabEntry> m_devTab; //!< A parsed dev tab object. 
@@ -19,6 +19,7 @@
 #include <scxsystemlib/scxdatadef.h>
 #include <scxcorelib/scxlog.h>
 #include <scxcorelib/scxhandle.h>
+#include <scxcorelib/scxatomic.h>
 #include <vector>
 #if defined(aix)
 
@@ -90,7 +91,9 @@ namespace SCXSystemLib
 
     public:
         StaticPhysicalDiskInstance(SCXCoreLib::SCXHandle<DiskDepend> deps);
+        StaticPhysicalDiskInstance(const StaticPhysicalDiskInstance& source);
         virtual ~StaticPhysicalDiskInstance();
+        StaticPhysicalDiskInstance& operator=(const StaticPhysicalDiskInstance& source);
 
         bool GetHealthState(bool& healthy) const;
         bool GetDiskName(std::wstring& value) const;
@@ -142,7 +145,7 @@ namespace SCXSystemLib
         */
         static size_t GetCurrentInstancesCount()
         {
-            return m_currentInstancesCount;
+            return static_cast<size_t>(m_currentInstancesCount);
         }
         /*----------------------------------------------------------------------------*/
         /**
@@ -153,19 +156,20 @@ namespace SCXSystemLib
         */
         static size_t GetInstancesCountSinceModuleStart()
         {
-            return m_instancesCountSinceModuleStart;
+            return static_cast<size_t>(m_instancesCountSinceModuleStart);
         }
     private:
         // For testing purposes we count the number of instances currently in existance.
-        static size_t m_currentInstancesCount;
+        // Copies made for a parallel update may be destroyed on a worker thread, so the counters are atomic.
+        static scx_atomic_t m_currentInstancesCount;
         // For testing purposes we count the number of instances created since the module was started and static varables
         // were initialized.
-        static size_t m_instancesCountSinceModuleStart;
+        static scx_atomic_t m_instancesCountSinceModuleStart;
 
         //! Private constructor (this should never be called!)
         StaticPhysicalDiskInstance();            //!< Default constructor (intentionally not implemented)
-        StaticPhysicalDiskInstance(const StaticPhysicalDiskInstance&); //!< Copy constructor (intentionally not implemented)
         void Clear();
+        void Assign(const StaticPhysicalDiskInstance& source);
 
 #if defined(linux)
 
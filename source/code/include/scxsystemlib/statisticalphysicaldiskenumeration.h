@@ -17,6 +17,7 @@
 #include <scxsystemlib/entityenumeration.h>
 #include <scxsystemlib/statisticalphysicaldiskinstance.h>
 #include <scxcorelib/scxlog.h>
+#include <scxcorelib/scxsamplescheduler.h>
 #include <scxcorelib/scxthread.h>
 #include <scxcorelib/scxhandle.h>
 #include <scxsystemlib/diskdepend.h>
@@ -29,7 +30,7 @@ namespace SCXSystemLib
          Represents a set of discovered physical disks and their statistical data 
          on a system.
     
-         Will start a sample thread to sample disk statistics when initiated.
+         Will register with the sample scheduler to sample disk statistics when initiated.
     */
     class StatisticalPhysicalDiskEnumeration : public EntityEnumeration<StatisticalPhysicalDiskInstance>
     {
@@ -62,7 +63,7 @@ namespace SCXSystemLib
     private:
         SCXCoreLib::SCXLogHandle m_log;         //!< Log handle
         SCXCoreLib::SCXHandle<DiskDepend> m_deps; //!< Dependencies object
-        SCXCoreLib::SCXHandle<SCXCoreLib::SCXThread> m_sampler;       //!< Data sampler.
+        SCXCoreLib::SCXSampleScheduler::SamplerId m_samplerId;        //!< Registration with the sample scheduler (0 if none).
         SCXCoreLib::SCXThreadLockHandle m_lock; //!< Handles locking in the disk enumeration.
         std::map<std::wstring,scxulong> m_pathToRdev; //!< Cache for path to rdev values.
 
@@ -74,7 +75,7 @@ namespace SCXSystemLib
 
     /*----------------------------------------------------------------------------*/
     /**
-        Parameters for the disk sampler thread keeping all DiskInstances up to date.
+        Parameters for the disk sampler keeping all DiskInstances up to date.
     */
     class StatisticalPhysicalDiskSamplerParam : public SCXCoreLib::SCXThreadParam
     {
@@ -87,7 +88,7 @@ namespace SCXSystemLib
             : m_diskEnum(NULL)
         {}
 
-        StatisticalPhysicalDiskEnumeration* m_diskEnum;  //!< Pointer to the disk enumeration associated with the thread.
+        StatisticalPhysicalDiskEnumeration* m_diskEnum;  //!< Pointer to the disk enumeration associated with the sampler.
     };
 
 }
@@ -21,7 +21,6 @@
 #include <map>
 #include <scxcorelib/scxhandle.h>
 #include <scxcorelib/scxexception.h>
-#include <scxcorelib/scxthreadlock.h>
 #include <scxcorelib/stringaid.h>
 #include <util/XMLWriter.h>
 #include <util/XMLReader.h>
@@ -212,11 +211,36 @@ namespace SCX
                        \param [out] element The loaded xml's root element
                        \param [in] Strip namespaces as they are loaded
 
-                       This is a static method and is thread safe. The thread safety might cause the
-                       loading of "large" xml files slow.
+                       This is a static method and is thread safe. The string is parsed as UTF-8
+                       by an XMLStreamReader, which builds the elements as it goes.
                     */
                     static void Load(const Utf8String& xmlString, XElementPtr& element, bool stripNamespaces = true);
-                    
+
+                    /*----------------------------------------------------------------------------*/
+                    /**
+                       Load XML in UTF-8 from a buffer into the XElement
+
+                       \param [in] data First byte of the Xml
+                       \param [in] size Number of bytes of the Xml
+                       \param [out] element The loaded xml's root element
+                       \param [in] Strip namespaces as they are loaded
+
+                       Unlike the Utf8String overload, the Xml is not converted to UTF-16 first.
+                    */
+                    static void Load(const char* data, size_t size, XElementPtr& element, bool stripNamespaces = true);
+
+                    /*----------------------------------------------------------------------------*/
+                    /**
+                       Load XML in UTF-8 read from a file descriptor into the XElement
+
+                       \param [in] fd Descriptor to read the Xml from; it is not closed
+                       \param [out] element The loaded xml's root element
+                       \param [in] Strip namespaces as they are loaded
+
+                       The Xml is read a chunk at a time, so the document is never held whole.
+                    */
+                    static void Load(int fd, XElementPtr& element, bool stripNamespaces = true);
+
                     /*----------------------------------------------------------------------------*/
                     /**
                        Save the XElement as Xml String
@@ -423,8 +447,6 @@ namespace SCX
                     // Faulty XML Component(XML string, name, value, attribute) thats causing the exception
                     Utf8String m_xmlComponent;
                 };
-
-                static SCXCoreLib::SCXThreadLockHandle XElementLoadLock(L"XElement::Load");
         }
     }
 }
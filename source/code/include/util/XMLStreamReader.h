@@ -0,0 +1,212 @@
+/*--------------------------------------------------------------------------------
+    Copyright (c) Microsoft Corporation. All rights reserved. See license.txt for license information.
+
+*/
+/**
+    \file        XMLStreamReader.h
+
+    \brief       Contains the class definition for the event driven XML reader
+
+    \date        2026-10-17 05:00:00
+
+    XMLReader keeps the whole document as a Utf8String, which holds UTF-16,
+    and copies every name and value it finds. XMLStreamReader instead works
+    on the UTF-8 bytes themselves, from a buffer or a file descriptor read
+    in chunks, and hands what it finds to an XMLEventHandler as spans into
+    those bytes.
+
+*/
+/*----------------------------------------------------------------------------*/
+
+#ifndef XMLSTREAMREADER_H
+#define XMLSTREAMREADER_H
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+#include <scxcorelib/stringspan.h>
+
+namespace SCX
+{
+    namespace Util
+    {
+        namespace Xml
+        {
+                /*----------------------------------------------------------------------------*/
+                /**
+                   Receives the events of an XMLStreamReader
+
+                   \date    2026-10-17 05:00:00
+
+                   Every span is UTF-8 and is valid only until the handler returns. Names
+                   are given as they are written, namespace prefix and all. Text and
+                   attribute values have their entity and character references replaced;
+                   text is given exactly as written otherwise, white space included.
+
+                   A start tag is given as OnStartElement(), then OnAttribute() for each
+                   of its attributes; an empty element tag is followed by OnEndElement()
+                   at once. An exception thrown by a handler ends the parse and is passed
+                   on to the caller of XMLStreamReader::Parse().
+                */
+                class XMLEventHandler
+                {
+                public:
+                    /** Destructor */
+                    virtual ~XMLEventHandler() {}
+
+                    /*----------------------------------------------------------------------------*/
+                    /**
+                       An element starts
+
+                       \param [in] name Name of the element
+                    */
+                    virtual void OnStartElement(const SCXCoreLib::StrSpan& name) = 0;
+
+                    /*----------------------------------------------------------------------------*/
+                    /**
+                       An attribute of the element that just started
+
+                       \param [in] name Name of the attribute
+                       \param [in] value Value of the attribute
+                    */
+                    virtual void OnAttribute(const SCXCoreLib::StrSpan& name, const SCXCoreLib::StrSpan& value) = 0;
+
+                    /*----------------------------------------------------------------------------*/
+                    /**
+                       Character data, between two tags or of a CDATA section
+
+                       \param [in] text The characters
+                    */
+                    virtual void OnText(const SCXCoreLib::StrSpan& text) = 0;
+
+                    /*----------------------------------------------------------------------------*/
+                    /**
+                       An element ends
+
+                       \param [in] name Name of the element
+                    */
+                    virtual void OnEndElement(const SCXCoreLib::StrSpan& name) = 0;
+                };
+
+                /*----------------------------------------------------------------------------*/
+                /**
+                   Event driven XML reader over UTF-8
+
+                   \date    2026-10-17 05:00:00
+
+                   The reader checks that tags are well formed and balanced. Comments,
+                   processing instructions and the DOCTYPE are skipped. Parsing stops
+                   at the end of the root element; anything after it is not read.
+
+                   A document parsed from a buffer is never copied. A document read from
+                   a file descriptor is kept a chunk at a time; only a single tag or run
+                   of text longer than a chunk makes the buffer grow.
+                */
+                class XMLStreamReader
+                {
+                public:
+                    /** Deepest nesting of elements allowed, as for XMLReader */
+                    static const size_t MAX_NESTED = 64;
+
+                    /** Bytes read from a file descriptor at a time, unless told otherwise */
+                    static const size_t DEFAULT_CHUNK_SIZE = 65536;
+
+                    /*----------------------------------------------------------------------------*/
+                    /**
+                       Constructor
+
+                       \param [in] handler Receives the events; must outlive the reader
+                    */
+                    explicit XMLStreamReader(XMLEventHandler& handler);
+
+                    /*----------------------------------------------------------------------------*/
+                    /**
+                       Parse a document in a buffer
+
+                       \param [in] data First byte of the document
+                       \param [in] size Number of bytes of the document
+                       \returns    false if the document is not well formed; see GetErrorMessage()
+                    */
+                    bool Parse(const char* data, size_t size);
+
+                    /*----------------------------------------------------------------------------*/
+                    /**
+                       Parse a document read from a file descriptor
+
+                       \param [in] fd Descriptor to read from; it is not closed
+                       \param [in] chunkSize Bytes to read at a time
+                       \returns    false if the document is not well formed or cannot be read;
+                                   see GetErrorMessage()
+                    */
+                    bool Parse(int fd, size_t chunkSize = DEFAULT_CHUNK_SIZE);
+
+                    /*----------------------------------------------------------------------------*/
+                    /**
+                       Get the reason the last parse failed
+
+                       \returns    The message; empty if the last parse succeeded
+                    */
+                    const std::string& GetErrorMessage() const { return m_message; }
+
+                private:
+                    bool Run();
+                    bool Refill();
+                    bool Need(size_t size);
+                    size_t FindChar(size_t from, char c);
+                    size_t FindString(size_t from, const char* str, size_t size);
+                    size_t FindTagEnd(size_t from);
+                    bool ParseText(size_t size);
+                    bool ParseMarkup();
+                    bool ParseStartTag(size_t end);
+                    bool ParseEndTag(size_t end);
+                    bool Decode(const char* data, size_t size, std::string& result);
+                    bool Raise(const std::string& message);
+
+                    /** Receives the events */
+                    XMLEventHandler& m_handler;
+
+                    /** Bytes of the document being looked at */
+                    const char* m_data;
+
+                    /** Offset in m_data of the next byte to parse */
+                    size_t m_pos;
+
+                    /** Offset in m_data of the end of what has been read */
+                    size_t m_end;
+
+                    /** Descriptor being read from, or -1 when parsing a buffer */
+                    int m_fd;
+
+                    /** Bytes to read at a time */
+                    size_t m_chunkSize;
+
+                    /** What has been read from m_fd and not parsed yet */
+                    std::vector<char> m_buffer;
+
+                    /** Names of the elements that are open, one after the other */
+                    std::string m_openNames;
+
+                    /** Offset in m_openNames of each open element's name */
+                    std::vector<size_t> m_openOffsets;
+
+                    /** Has the root element ended? */
+                    bool m_rootDone;
+
+                    /** Text and attribute values with their references replaced */
+                    std::string m_decoded;
+
+                    /** Why the last parse failed */
+                    std::string m_message;
+
+                    /** Hiding the copy constructor */
+                    XMLStreamReader(const XMLStreamReader&);
+
+                    /** Hiding the assignment operator */
+                    XMLStreamReader& operator=(const XMLStreamReader&);
+                };
+        }
+    }
+}
+#endif /* XMLSTREAMREADER_H */
+/*----------------------------E-N-D---O-F---F-I-L-E---------------------------*/
@@ -501,6 +501,66 @@ namespace SCXCoreLib {
 #endif
     }
 
+    /*--------------------------------------------------------------*/
+    /**
+       Reads all of a file into a buffer kept by the caller.
+
+       \param path    Path to file to read.
+       \param buffer  Buffer to read data to; grown until the file fits.
+
+       \returns Number of bytes read and stored in buffer.
+
+       \throws SCXFilePathNotFoundException if the file does not exist.
+       \throws SCXErrnoOpenException if the file cannot be opened.
+       \throws SCXErrnoFileException if a read fails.
+
+       Meant for files under /proc, whose size is not known until they are
+       read and which procfs may return in several chunks. The buffer is
+       doubled whenever it fills up and is never shrunk, so a buffer that is
+       reused for every read of a file stops allocating once it is large
+       enough.
+    */
+#if defined(DISABLE_WIN_UNSUPPORTED)
+    size_t SCXFile::ReadAllBytes(const SCXFilePath& , std::vector<char>& ) {
+        throw SCXNotSupportedException(L"Reads not supported on windows", SCXSRCLOCATION);
+#else
+    size_t SCXFile::ReadAllBytes(const SCXFilePath& path, std::vector<char>& buffer) {
+        int fd = open(SCXFileSystem::EncodePath(path).c_str(), O_RDONLY);
+        if (-1 == fd) {
+            if (ENOENT == errno) {
+                throw SCXFilePathNotFoundException(path, SCXSRCLOCATION);
+            }
+            throw SCXErrnoOpenException(path.Get(), errno, SCXSRCLOCATION);
+        }
+
+        if (buffer.empty()) {
+            buffer.resize(16384);
+        }
+
+        size_t used = 0;
+        for (;;) {
+            if (used == buffer.size()) {
+                buffer.resize(buffer.size() * 2);
+            }
+            ssize_t bytes = read(fd, &buffer[used], buffer.size() - used);
+            if (bytes < 0) {
+                if (EINTR == errno) {
+                    continue;
+                }
+                int eno = errno;
+                close(fd);
+                throw SCXErrnoFileException(L"read", path.Get(), eno, SCXSRCLOCATION);
+            }
+            if (0 == bytes) {
+                break;
+            }
+            used += static_cast<size_t>(bytes);
+        }
+        close(fd);
+        return used;
+#endif
+    }
+
     /*--------------------------------------------------------------*/
     /**
       Opens a device system file and reads specified available bytes.
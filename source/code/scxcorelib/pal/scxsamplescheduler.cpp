@@ -0,0 +1,404 @@
+/*--------------------------------------------------------------------------------
+    Copyright (c) Microsoft Corporation. All rights reserved. See license.txt for license information.
+
+*/
+/**
+    \file
+
+    \brief       Implements the shared sampling scheduler.
+
+    \date        2026-10-16 09:00:00
+
+*/
+/*----------------------------------------------------------------------------*/
+
+#include <scxcorelib/scxcmn.h>
+#include <scxcorelib/scxdumpstring.h>
+#include <scxcorelib/scxexception.h>
+#include <scxcorelib/scxsamplescheduler.h>
+#include <scxcorelib/stringaid.h>
+
+#include <algorithm>
+
+#if defined(SCX_UNIX)
+#include <sys/time.h>
+#elif defined(WIN32)
+#include <windows.h>
+#endif
+
+namespace SCXCoreLib
+{
+    SCXSingleton_Allocate(SCXSampleScheduler);
+
+    /*----------------------------------------------------------------------------*/
+    /**
+       Thread parameters for the scheduler thread.
+    */
+    class SCXSampleSchedulerThreadParam : public SCXThreadParam
+    {
+    public:
+        /*----------------------------------------------------------------------------*/
+        /**
+           Constructor
+
+           \param[in] scheduler  Scheduler that owns the thread
+        */
+        SCXSampleSchedulerThreadParam(SCXSampleScheduler* scheduler)
+            : SCXThreadParam(),
+              m_scheduler(scheduler)
+        {
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+           Retrieves the scheduler that owns the thread
+
+           \returns     Pointer to the scheduler
+        */
+        SCXSampleScheduler* GetScheduler() { return m_scheduler; }
+
+    private:
+        SCXSampleScheduler* m_scheduler;    //!< Scheduler that owns the thread
+    };
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Default constructor.
+
+        Normally the scheduler is used through Instance(); separate instances
+        are allowed for unit tests.
+    */
+    SCXSampleScheduler::SCXSampleScheduler()
+        : m_log(SCXLogHandleFactory::GetLogHandle(L"scx.core.common.pal.samplescheduler")),
+          m_threadId(0),
+          m_nextId(1),
+          m_runningId(0),
+          m_wakeupCount(0),
+          m_sampleCount(0),
+          m_isRunning(false),
+          m_isTerminating(false)
+    {
+        m_cond.SetSleep(0);
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Virtual destructor.
+
+        Stops the scheduler thread if it is still running. Any samplers that
+        are still registered are dropped.
+    */
+    SCXSampleScheduler::~SCXSampleScheduler()
+    {
+        if (NULL != m_thread.GetData())
+        {
+            {
+                SCXConditionHandle h(m_cond);
+                m_isTerminating = true;
+                h.Broadcast();
+            }
+            m_thread->Wait();
+        }
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Dump object as string (for logging).
+
+        \returns   Object represented as string for logging.
+    */
+    const std::wstring SCXSampleScheduler::DumpString() const
+    {
+        SCXConditionHandle h(m_cond);
+        return SCXDumpStringBuilder("SCXSampleScheduler")
+            .Scalar("SamplerCount", m_samplers.size())
+            .Scalar("PendingDeadlines", m_deadlines.size())
+            .Scalar("WakeupCount", m_wakeupCount)
+            .Scalar("SampleCount", m_sampleCount)
+            .Scalar("IsRunning", m_isRunning);
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Registers a periodic sampler.
+
+        The callback is run once as soon as possible and then every periodMs
+        milliseconds, on the millisecond grid defined by the period.
+
+        \param[in]  proc      Callback to run
+        \param[in]  param     Parameter passed to the callback
+        \param[in]  periodMs  Time between samples in milliseconds
+        \returns    Id used to unregister the sampler
+        \throws     SCXInvalidArgumentException if proc is NULL or periodMs is zero
+    */
+    SCXSampleScheduler::SamplerId SCXSampleScheduler::Register(SCXThreadProc proc, SCXThreadParamHandle param, scxulong periodMs)
+    {
+        if (NULL == proc)
+        {
+            throw SCXInvalidArgumentException(L"proc", L"Sampler callback must be set", SCXSRCLOCATION);
+        }
+        if (0 == periodMs)
+        {
+            throw SCXInvalidArgumentException(L"periodMs", L"Sample period must be greater than zero", SCXSRCLOCATION);
+        }
+
+        SCXConditionHandle h(m_cond);
+        if (m_isTerminating)
+        {
+            throw SCXInvalidStateException(L"Sample scheduler is shutting down", SCXSRCLOCATION);
+        }
+
+        SamplerId id = m_nextId++;
+        Sampler sampler;
+        sampler.proc = proc;
+        sampler.param = param;
+        sampler.periodMs = periodMs;
+        m_samplers[id] = sampler;
+        PushDeadline(id, GetTime());
+
+        if (!m_isRunning)
+        {
+            // A previous scheduler thread may still be on its way out; it has released
+            // the lock for good once m_isRunning is false, so joining it here is safe
+            if (NULL != m_thread.GetData())
+            {
+                m_thread->Wait();
+            }
+            m_isRunning = true;
+            m_thread = new SCXThread(SchedulerThreadBody, new SCXSampleSchedulerThreadParam(this));
+        }
+        else
+        {
+            h.Broadcast();
+        }
+
+        SCX_LOGTRACE(m_log, StrAppend(StrAppend(L"Registered sampler ", id), StrAppend(L" with period (ms) ", periodMs)));
+        return id;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Unregisters a sampler.
+
+        If the callback of the sampler is running, waits for it to finish
+        (unless called from the callback itself). Unknown ids are ignored.
+
+        \param[in]  id  Id returned by Register()
+    */
+    void SCXSampleScheduler::Unregister(SamplerId id)
+    {
+        SCXConditionHandle h(m_cond);
+        if (0 == m_samplers.erase(id))
+        {
+            return;
+        }
+        SCX_LOGTRACE(m_log, StrAppend(L"Unregistered sampler ", id));
+
+        // Stale heap entries are skipped by the scheduler thread; wake it so it
+        // can exit if this was the last sampler
+        h.Broadcast();
+
+        bool onSchedulerThread = m_isRunning && SCXThread::GetCurrentThreadID() == m_threadId;
+        while (m_runningId == id && !onSchedulerThread)
+        {
+            m_cond.SetSleep(0);
+            h.Wait();
+        }
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Get the number of registered samplers
+
+        \returns     Number of registered samplers
+    */
+    size_t SCXSampleScheduler::GetSamplerCount() const
+    {
+        SCXConditionHandle h(m_cond);
+        return m_samplers.size();
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Get the number of times the scheduler woke up to run due samplers
+
+        \returns     Number of wakeups
+    */
+    scxulong SCXSampleScheduler::GetWakeupCount() const
+    {
+        SCXConditionHandle h(m_cond);
+        return m_wakeupCount;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Get the number of sampler callbacks run
+
+        \returns     Number of callbacks run
+    */
+    scxulong SCXSampleScheduler::GetSampleCount() const
+    {
+        SCXConditionHandle h(m_cond);
+        return m_sampleCount;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Adds a deadline to the heap. The lock must be held.
+
+        \param[in]  id    Sampler the deadline belongs to
+        \param[in]  when  Absolute deadline in milliseconds
+    */
+    void SCXSampleScheduler::PushDeadline(SamplerId id, scxulong when)
+    {
+        Deadline deadline;
+        deadline.when = when;
+        deadline.id = id;
+        m_deadlines.push_back(deadline);
+        std::push_heap(m_deadlines.begin(), m_deadlines.end());
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Get the current wall clock time in milliseconds.
+
+        Uses the same clock as SCXCondition, which sleeps until absolute times.
+        Unit tests override this to drive the scheduler with a fake clock.
+
+        \returns     Milliseconds since the epoch
+    */
+    scxulong SCXSampleScheduler::GetTime() const
+    {
+#if defined(SCX_UNIX)
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        return static_cast<scxulong>(tv.tv_sec) * 1000 + static_cast<scxulong>(tv.tv_usec) / 1000;
+#elif defined(WIN32)
+        return static_cast<scxulong>(GetTickCount());
+#else
+#error Platform not supported
+#endif
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Tells the scheduler thread that the time given by GetTime() has moved.
+
+        The thread then runs the samplers that became due without waiting for
+        its sleep to end. Only needed when GetTime() is overridden.
+    */
+    void SCXSampleScheduler::ClockChanged()
+    {
+        SCXConditionHandle h(m_cond);
+        h.Broadcast();
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Entry point of the scheduler thread.
+
+        \param[in]  param  Thread parameters, of type SCXSampleSchedulerThreadParam
+    */
+    void SCXSampleScheduler::SchedulerThreadBody(SCXThreadParamHandle& param)
+    {
+        SCXSampleSchedulerThreadParam* p = static_cast<SCXSampleSchedulerThreadParam*>(param.GetData());
+        SCXASSERT(NULL != p);
+        p->GetScheduler()->DoSchedulerThread();
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Scheduler thread loop.
+
+        Sleeps until the earliest deadline, then runs every sampler that is due
+        and computes its next deadline. Exits when terminating or when there are
+        no samplers left.
+    */
+    void SCXSampleScheduler::DoSchedulerThread()
+    {
+        SCXConditionHandle h(m_cond);
+        m_threadId = SCXThread::GetCurrentThreadID();
+
+        while (!m_isTerminating && !m_samplers.empty())
+        {
+            // Drop deadlines of samplers that were unregistered
+            while (!m_deadlines.empty() && m_samplers.find(m_deadlines.front().id) == m_samplers.end())
+            {
+                std::pop_heap(m_deadlines.begin(), m_deadlines.end());
+                m_deadlines.pop_back();
+            }
+            SCXASSERT(!m_deadlines.empty());
+            if (m_deadlines.empty())
+            {
+                break;
+            }
+
+            scxulong now = GetTime();
+            if (m_deadlines.front().when > now)
+            {
+                m_cond.SetSleep(m_deadlines.front().when - now);
+                h.Wait();
+                continue;
+            }
+
+            // Collect everything that is due so it is serviced by this one wakeup
+            ++m_wakeupCount;
+            std::vector<SamplerId> due;
+            while (!m_deadlines.empty() && m_deadlines.front().when <= now)
+            {
+                due.push_back(m_deadlines.front().id);
+                std::pop_heap(m_deadlines.begin(), m_deadlines.end());
+                m_deadlines.pop_back();
+            }
+
+            for (std::vector<SamplerId>::const_iterator it = due.begin(); it != due.end() && !m_isTerminating; ++it)
+            {
+                std::map<SamplerId, Sampler>::iterator found = m_samplers.find(*it);
+                if (found == m_samplers.end())
+                {
+                    continue;
+                }
+                Sampler sampler = found->second;
+
+                m_runningId = *it;
+                h.Unlock();
+                try
+                {
+                    sampler.proc(sampler.param);
+                }
+                catch (const SCXException& e1)
+                {
+                    SCX_LOGERROR(m_log, std::wstring(L"Sampler threw exception - ").append(e1.What()).append(L" - ").append(e1.Where()));
+                }
+                catch (const std::exception& e2)
+                {
+                    SCX_LOGERROR(m_log, std::wstring(L"Sampler threw exception - ").append(StrFromUTF8(e2.what())));
+                }
+                h.Lock();
+                m_runningId = 0;
+                ++m_sampleCount;
+                h.Broadcast();
+
+                if (m_samplers.find(*it) == m_samplers.end())
+                {
+                    continue;
+                }
+                if (sampler.param.GetData() != NULL && sampler.param->GetTerminateFlag())
+                {
+                    SCX_LOGTRACE(m_log, StrAppend(L"Sampler asked to stop: ", *it));
+                    m_samplers.erase(*it);
+                    continue;
+                }
+
+                // Next multiple of the period; missed periods are skipped rather than run back to back
+                scxulong next = (GetTime() / sampler.periodMs + 1) * sampler.periodMs;
+                PushDeadline(*it, next);
+            }
+        }
+
+        m_deadlines.clear();
+        m_isRunning = false;
+    }
+} /* namespace SCXCoreLib */
+
+/*----------------------------E-N-D---O-F---F-I-L-E---------------------------*/
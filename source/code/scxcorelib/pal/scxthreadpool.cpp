@@ -18,8 +18,45 @@
 #include <scxcorelib/scxthreadpool.h>
 #include <scxcorelib/stringaid.h>
 
+#include <algorithm>
+#include <sys/time.h>
 #include <unistd.h>
 
+namespace
+{
+    /*----------------------------------------------------------------------------*/
+    /**
+        Get the current time in microseconds, used to measure queueing latency.
+
+        \returns     Microseconds since the epoch
+    */
+    scxulong GetMicrosecondTimeStamp()
+    {
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        return static_cast<scxulong>(tv.tv_sec) * 1000000 + static_cast<scxulong>(tv.tv_usec);
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Records that a task is taken off a queue to run.
+
+        \param[in,out] stats       Statistics of the queue the task was taken from
+        \param[in]     queuedTime  When the task was queued (microseconds)
+        \param[in]     now         Current time (microseconds)
+    */
+    void RecordTaskStarted(SCXCoreLib::SCXThreadPoolStatistics& stats, scxulong queuedTime, scxulong now)
+    {
+        scxulong wait = now > queuedTime ? now - queuedTime : 0;
+        stats.tasksStarted++;
+        stats.totalWaitTime += wait;
+        if (wait > stats.maxWaitTime)
+        {
+            stats.maxWaitTime = wait;
+        }
+    }
+}
+
 namespace SCXCoreLib
 {
     /*----------------------------------------------------------------------------*/
@@ -32,6 +69,10 @@ namespace SCXCoreLib
           m_threadCount(0),
           m_threadLimit(8),
           m_threadBusyCount(0),
+          m_pendingCount(0),
+          m_idleCount(0),
+          m_nextQueue(0),
+          m_mode(eSharedQueue),
           m_isRunning(false),
           m_isTerminating(false)
     {
@@ -56,13 +97,58 @@ namespace SCXCoreLib
     */
     const std::wstring SCXThreadPool::DumpString() const
     {
+        SCXThreadPoolStatistics stats = GetStatistics();
         return SCXDumpStringBuilder("SCXThreadPool")
             .Scalar("ThreadCount", m_threadCount)
             .Scalar("ThreadLimit", m_threadLimit)
+            .Scalar("Mode", m_mode == eWorkStealing ? "WorkStealing" : "SharedQueue")
+            .Scalar("QueueDepth", stats.queueDepth)
+            .Scalar("MaxQueueDepth", stats.maxQueueDepth)
+            .Scalar("TasksQueued", stats.tasksQueued)
+            .Scalar("TasksStarted", stats.tasksStarted)
+            .Scalar("TasksStolen", stats.tasksStolen)
+            .Scalar("AverageWaitTime", stats.tasksStarted ? stats.totalWaitTime / stats.tasksStarted : 0)
+            .Scalar("MaxWaitTime", stats.maxWaitTime)
             .Scalar("IsRunning", m_isRunning)
             .Scalar("IsTerminating", m_isTerminating);
     }
 
+    /*----------------------------------------------------------------------------*/
+    /**
+        Get the queue statistics of the thread pool.
+
+        In work stealing mode, the statistics of all worker queues are added
+        up; maxQueueDepth is then the most tasks ever waiting in any one queue.
+        Wait times are in microseconds.
+
+        \returns   Statistics since the thread pool was started
+    */
+    SCXThreadPoolStatistics SCXThreadPool::GetStatistics() const
+    {
+        if ( m_mode == eSharedQueue )
+        {
+            SCXConditionHandle h( m_cond );
+            SCXThreadPoolStatistics stats = m_stats;
+            stats.queueDepth = m_tasks.size();
+            return stats;
+        }
+
+        SCXThreadPoolStatistics stats;
+        for (std::vector<SCXHandle<WorkerQueue> >::const_iterator it = m_queues.begin(); it != m_queues.end(); ++it)
+        {
+            SCXThreadLock lock( (*it)->m_lock );
+            const SCXThreadPoolStatistics& qs = (*it)->m_stats;
+            stats.queueDepth += (*it)->m_tasks.size();
+            stats.maxQueueDepth = std::max(stats.maxQueueDepth, qs.maxQueueDepth);
+            stats.tasksQueued += qs.tasksQueued;
+            stats.tasksStarted += qs.tasksStarted;
+            stats.tasksStolen += qs.tasksStolen;
+            stats.totalWaitTime += qs.totalWaitTime;
+            stats.maxWaitTime = std::max(stats.maxWaitTime, qs.maxWaitTime);
+        }
+        return stats;
+    }
+
     /*----------------------------------------------------------------------------*/
     /**
         Starts a new worker thread to run in the thread pool
@@ -78,7 +164,9 @@ namespace SCXCoreLib
         // (Can't do increment in worker thread - delay in thread execution can result in incorrect count)
         scx_atomic_increment( &m_threadCount );
 
-        SCXThreadPoolThreadParam* params = new SCXThreadPoolThreadParam(this);
+        // In work stealing mode, threads are spread over the worker queues
+        size_t queueIndex = m_queues.empty() ? 0 : m_hThreads.size() % m_queues.size();
+        SCXThreadPoolThreadParam* params = new SCXThreadPoolThreadParam(this, queueIndex);
         params->m_cond.SetSleep( 0 );
 
         SCXThreadHandle thread(new SCXCoreLib::SCXThread(StartWorkerThreadStub, params, &m_threadAttr));
@@ -109,8 +197,14 @@ namespace SCXCoreLib
 
        Many instances of this method may run at any one time.  Code accordingly!
     */
-    void SCXThreadPool::DoWorkerThread(SCXThreadPoolThreadParam* /* params */)
+    void SCXThreadPool::DoWorkerThread(SCXThreadPoolThreadParam* params)
     {
+        if ( m_mode == eWorkStealing )
+        {
+            DoWorkStealingWorkerThread( params );
+            return;
+        }
+
         // Wait for the condition (shutdown, or something added to the queue)
         SCXConditionHandle h( m_cond );
         while ( !m_isTerminating )
@@ -145,43 +239,21 @@ namespace SCXCoreLib
             {
                 // Pull the first entry off the queue and dispatch
                 SCXThreadPoolTaskHandle task = m_tasks.front();
-                m_tasks.erase( m_tasks.begin() );
+                m_tasks.pop_front();
+                RecordTaskStarted( m_stats, task->m_queuedTime, GetMicrosecondTimeStamp() );
 
-                // Launch the Worker Thread task (a bit of copied code from SCXThread.cpp)
                 if (task->m_proc != 0)
                 {
                     // Unlock the condition while we call the ThreadProc
                     // NOTE: We can miss broadcasts while ThreadProc is executing ...
-                    m_threadBusyCount++;
+                    scx_atomic_increment( &m_threadBusyCount );
                     h.Unlock();
 
-#if !defined(_DEBUG)
-                    try
-                    {
-                        task->m_proc( task->m_param );
-                    }
-                    catch (const SCXException& e1)
-                    {
-                        SCXASSERTFAIL(std::wstring(L"WorkerThreadStartRoutine() Thread threw unhandled exception - ").
-                                      append(e1.What()).append(L" - ").append(e1.Where()).c_str());
-                    }
-                    catch (const std::exception& e2)
-                    {
-                        SCXASSERTFAIL(std::wstring(L"WorkerThreadStartRoutine() Thread threw unhandled exception - ").
-                                      append(StrFromUTF8(e2.what())).c_str());
-                    }
-#else
-                    task->m_proc( task->m_param );
-#endif
-                    /* We would like to catch (...) as well but it seemes we can't since there is a bug
-                       in gcc. http://gcc.gnu.org/bugzilla/show_bug.cgi?id=28145 */
+                    RunTask( task );
 
                     // Lock the condition now that ThreadProc is finished
                     h.Lock();
-                    if ( m_threadBusyCount >= 1 )
-                    {
-                        m_threadBusyCount--;
-                    }
+                    scx_atomic_decrement_test( &m_threadBusyCount );
                 }
             }
         }
@@ -190,6 +262,145 @@ namespace SCXCoreLib
         scx_atomic_decrement_test( &m_threadCount );
     }
 
+    /*-----------------------------------------------------------------------*/
+    /**
+       Worker Thread Execution in work stealing mode
+
+       The worker runs tasks from its own queue. When that is empty it steals
+       from the queues of the other workers, and only when all queues are empty
+       does it wait on the pool condition. The pool condition is thus only
+       taken when a worker goes idle or exits, and by QueueTask() when it needs
+       to wake an idle worker or start a new one.
+
+       \param[in]  params  Thread parameters, holding the index of the own queue
+    */
+    void SCXThreadPool::DoWorkStealingWorkerThread(SCXThreadPoolThreadParam* params)
+    {
+        size_t queueIndex = params->GetQueueIndex();
+
+        for (;;)
+        {
+            // Shutting down or throttling down; the count is changed under the
+            // condition so that no more threads exit than needed
+            if ( m_isTerminating || m_threadCount > m_threadLimit )
+            {
+                SCXConditionHandle h( m_cond );
+                if ( m_isTerminating || m_threadCount > m_threadLimit )
+                {
+                    scx_atomic_decrement_test( &m_threadCount );
+                    return;
+                }
+            }
+
+            SCXThreadPoolTaskHandle task;
+            if ( !m_deps->IsWorkerTaskExecutionDelayed() && TakeTask(queueIndex, task) )
+            {
+                if (task->m_proc != 0)
+                {
+                    scx_atomic_increment( &m_threadBusyCount );
+                    RunTask( task );
+                    scx_atomic_decrement_test( &m_threadBusyCount );
+                }
+                continue;
+            }
+
+            // Nothing to do. The idle count is raised before the pending count is
+            // checked, and QueueTask() raises the pending count before it checks
+            // the idle count, so either we see the new task or we get signaled.
+            SCXConditionHandle h( m_cond );
+            scx_atomic_increment( &m_idleCount );
+            while ( !m_isTerminating && m_threadCount <= m_threadLimit
+                    && (m_pendingCount <= 0 || m_deps->IsWorkerTaskExecutionDelayed()) )
+            {
+                enum SCXCondition::eConditionResult r = h.Wait();
+                SCX_LOGTRACE(m_logHandle, StrAppend(L"DoWorkStealingWorkerThread(): Awake from condition with result: ", r));
+            }
+            scx_atomic_decrement_test( &m_idleCount );
+        }
+    }
+
+    /*-----------------------------------------------------------------------*/
+    /**
+       Takes a task to run in work stealing mode
+
+       Takes the first task of the own queue. If the own queue is empty, half
+       of the tasks (rounded up) of the first other non-empty queue are moved
+       from its tail; one of them is returned and the rest go to the own queue.
+
+       \param[in]   queueIndex  Index of the queue owned by the calling worker
+       \param[out]  task        The task to run
+       \returns     false if no task was found
+    */
+    bool SCXThreadPool::TakeTask(size_t queueIndex, SCXThreadPoolTaskHandle& task)
+    {
+        WorkerQueue& own = *m_queues[queueIndex];
+        {
+            SCXThreadLock lock( own.m_lock );
+            if ( !own.m_tasks.empty() )
+            {
+                task = own.m_tasks.front();
+                own.m_tasks.pop_front();
+                RecordTaskStarted( own.m_stats, task->m_queuedTime, GetMicrosecondTimeStamp() );
+                scx_atomic_decrement_test( &m_pendingCount );
+                return true;
+            }
+        }
+
+        std::vector<SCXThreadPoolTaskHandle> stolen;
+        for (size_t i = 1; i < m_queues.size() && stolen.empty(); i++)
+        {
+            WorkerQueue& victim = *m_queues[(queueIndex + i) % m_queues.size()];
+            SCXThreadLock lock( victim.m_lock );
+            size_t count = (victim.m_tasks.size() + 1) / 2;
+            stolen.assign( victim.m_tasks.end() - count, victim.m_tasks.end() );
+            victim.m_tasks.erase( victim.m_tasks.end() - count, victim.m_tasks.end() );
+        }
+        if ( stolen.empty() )
+        {
+            return false;
+        }
+
+        SCXThreadLock lock( own.m_lock );
+        task = stolen.front();
+        own.m_tasks.insert( own.m_tasks.end(), stolen.begin() + 1, stolen.end() );
+        own.m_stats.tasksStolen += stolen.size();
+        own.m_stats.maxQueueDepth = std::max( own.m_stats.maxQueueDepth, static_cast<scxulong>(own.m_tasks.size()) );
+        RecordTaskStarted( own.m_stats, task->m_queuedTime, GetMicrosecondTimeStamp() );
+        scx_atomic_decrement_test( &m_pendingCount );
+        return true;
+    }
+
+    /*-----------------------------------------------------------------------*/
+    /**
+       Runs a task taken off a queue. No locks may be held.
+
+       \param[in]  task  The task to run
+    */
+    void SCXThreadPool::RunTask(SCXThreadPoolTaskHandle& task)
+    {
+        // Launch the Worker Thread task (a bit of copied code from SCXThread.cpp)
+#if !defined(_DEBUG)
+        try
+        {
+            task->m_proc( task->m_param );
+        }
+        catch (const SCXException& e1)
+        {
+            SCXASSERTFAIL(std::wstring(L"WorkerThreadStartRoutine() Thread threw unhandled exception - ").
+                          append(e1.What()).append(L" - ").append(e1.Where()).c_str());
+        }
+        catch (const std::exception& e2)
+        {
+            SCXASSERTFAIL(std::wstring(L"WorkerThreadStartRoutine() Thread threw unhandled exception - ").
+                          append(StrFromUTF8(e2.what())).c_str());
+        }
+#else
+        task->m_proc( task->m_param );
+#endif
+        /* We would like to catch (...) as well but it seemes we can't since there is a bug
+           in gcc. http://gcc.gnu.org/bugzilla/show_bug.cgi?id=28145 */
+    }
+
     /*-----------------------------------------------------------------------*/
     /**
        Sets the maximum number of threads allowed to run
@@ -225,6 +436,27 @@ namespace SCXCoreLib
          h.Broadcast();
     }
 
+    /*-----------------------------------------------------------------------*/
+    /**
+       Sets how queued tasks are handed to worker threads
+
+       In work stealing mode, every worker has its own queue (as many queues as
+       the thread limit when the pool is started) with its own lock. Tasks are
+       spread round-robin over the queues, and a worker with an empty queue
+       steals from the others. This keeps workers from contending for a single
+       lock when many tasks are queued.
+
+       \param[in]   mode  Scheduler mode
+       \throws      SCXInvalidStateException if worker threads are already started
+    */
+    void SCXThreadPool::SetSchedulerMode(SchedulerMode mode)
+    {
+        if ( m_isRunning )
+            throw SCXInvalidStateException(L"Scheduler mode can't be set after thread pool is started", SCXSRCLOCATION );
+
+        m_mode = mode;
+    }
+
     /*-----------------------------------------------------------------------*/
     /**
        Queues a new task to run in a worker thread
@@ -236,10 +468,19 @@ namespace SCXCoreLib
         if ( !m_isRunning )
             throw SCXInvalidStateException(L"Worker Thread Pool is not yet started", SCXSRCLOCATION );
 
+        if ( m_mode == eWorkStealing )
+        {
+            EnqueueWorkStealing( &task, 1 );
+            return;
+        }
+
         // Add an element to the queue, and wake a worker to handle it
         {
             SCXConditionHandle h(m_cond);
+            task->m_queuedTime = GetMicrosecondTimeStamp();
             m_tasks.push_back(task);
+            m_stats.tasksQueued++;
+            m_stats.maxQueueDepth = std::max( m_stats.maxQueueDepth, static_cast<scxulong>(m_tasks.size()) );
             h.Signal();
 
             // If we have insufficient worker threads to handle this, add a new one (throttle up)
@@ -251,6 +492,107 @@ namespace SCXCoreLib
         }
     }
 
+    /*-----------------------------------------------------------------------*/
+    /**
+       Queues a batch of tasks to run in worker threads
+
+       The batch is added with one lock per queue, and as many worker threads
+       as needed (up to the thread limit) are started or woken.
+
+       \param[in]   tasks  Tasks to queue
+       \throws      SCXInvalidStateException if worker threads are not started yet
+    */
+    void SCXThreadPool::QueueTasks(const std::vector<SCXThreadPoolTaskHandle>& tasks)
+    {
+        if ( !m_isRunning )
+            throw SCXInvalidStateException(L"Worker Thread Pool is not yet started", SCXSRCLOCATION );
+
+        if ( tasks.empty() )
+            return;
+
+        if ( m_mode == eWorkStealing )
+        {
+            EnqueueWorkStealing( &tasks[0], tasks.size() );
+            return;
+        }
+
+        SCXConditionHandle h(m_cond);
+        scxulong now = GetMicrosecondTimeStamp();
+        for (std::vector<SCXThreadPoolTaskHandle>::const_iterator it = tasks.begin(); it != tasks.end(); ++it)
+        {
+            (*it)->m_queuedTime = now;
+            m_tasks.push_back(*it);
+        }
+        m_stats.tasksQueued += tasks.size();
+        m_stats.maxQueueDepth = std::max( m_stats.maxQueueDepth, static_cast<scxulong>(m_tasks.size()) );
+        h.Broadcast();
+
+        while ( (m_threadBusyCount + static_cast<long>(m_tasks.size())) > m_threadCount
+                && m_threadCount < m_threadLimit )
+        {
+            StartWorkerThread();
+        }
+    }
+
+    /*-----------------------------------------------------------------------*/
+    /**
+       Adds tasks to the worker queues in work stealing mode
+
+       Consecutive tasks are spread evenly over the queues, starting with the
+       next queue in round-robin order. The pool condition is only taken if a
+       worker is idle or another worker thread may be started.
+
+       \param[in]   tasks  Tasks to queue
+       \param[in]   count  Number of tasks
+    */
+    void SCXThreadPool::EnqueueWorkStealing(const SCXThreadPoolTaskHandle* tasks, size_t count)
+    {
+        // See DoWorkStealingWorkerThread(): the pending count must be raised
+        // before the idle count is checked
+        for (size_t i = 0; i < count; i++)
+        {
+            scx_atomic_increment( &m_pendingCount );
+        }
+
+        size_t queues = m_queues.size();
+        size_t perQueue = (count + queues - 1) / queues;
+        size_t queueIndex = static_cast<size_t>(m_nextQueue) % queues;
+        scx_atomic_increment( &m_nextQueue );
+
+        scxulong now = GetMicrosecondTimeStamp();
+        for (size_t i = 0; i < count; queueIndex = (queueIndex + 1) % queues)
+        {
+            size_t n = std::min(perQueue, count - i);
+            WorkerQueue& queue = *m_queues[queueIndex];
+            SCXThreadLock lock( queue.m_lock );
+            for (size_t j = i; j < i + n; j++)
+            {
+                tasks[j]->m_queuedTime = now;
+                queue.m_tasks.push_back( tasks[j] );
+            }
+            queue.m_stats.tasksQueued += n;
+            queue.m_stats.maxQueueDepth = std::max( queue.m_stats.maxQueueDepth, static_cast<scxulong>(queue.m_tasks.size()) );
+            i += n;
+        }
+
+        bool needThread = m_threadCount < m_threadLimit && (m_threadBusyCount + m_pendingCount) > m_threadCount;
+        if ( m_idleCount > 0 || needThread )
+        {
+            SCXConditionHandle h(m_cond);
+            if ( count > 1 )
+                h.Broadcast();
+            else
+                h.Signal();
+
+            // If we have insufficient worker threads to handle this, add new ones (throttle up)
+            while ( !m_isTerminating && (m_threadBusyCount + m_pendingCount) > m_threadCount
+                    && m_threadCount < m_threadLimit )
+            {
+                StartWorkerThread();
+            }
+        }
+    }
+
     /*-----------------------------------------------------------------------*/
     /**
        Starts threads in the thread pool
@@ -264,6 +606,17 @@ namespace SCXCoreLib
 
         SCXASSERT( m_threadCount == 0 );
         SCXASSERT( m_threadLimit > 0 );
+        m_stats = SCXThreadPoolStatistics();
+        m_queues.clear();
+        if ( m_mode == eWorkStealing )
+        {
+            for (long i = 0; i < m_threadLimit; i++)
+            {
+                m_queues.push_back( SCXHandle<WorkerQueue>(new WorkerQueue()) );
+            }
+            m_pendingCount = 0;
+            m_idleCount = 0;
+        }
         StartWorkerThread();
         m_isRunning = true;
     }
@@ -299,6 +652,11 @@ namespace SCXCoreLib
 
         m_hThreads.clear();
         m_tasks.clear();
+        for (std::vector<SCXHandle<WorkerQueue> >::iterator it = m_queues.begin(); it != m_queues.end(); ++it)
+        {
+            (*it)->m_tasks.clear();
+        }
+        m_pendingCount = 0;
         m_isTerminating = false;
     }
 
@@ -14,13 +14,13 @@
 
 #include <scxcorelib/scxcmn.h>
 #include <scxcorelib/scxuser.h>
+#include <scxcorelib/scxusercache.h>
 #include <scxcorelib/scxdumpstring.h>
 #include <scxcorelib/stringaid.h>
 
 #if defined(SCX_UNIX)
 #include <unistd.h>
 #include <sys/types.h>
-#include <pwd.h>
 #else
 #error "Platform not supported"
 #endif
@@ -95,35 +95,7 @@ namespace SCXCoreLib
 */
     void SCXUser::SetName()
     {
-        struct passwd pwd;
-        struct passwd *ppwd = NULL;
-        long bufSize = sysconf(_SC_GETPW_R_SIZE_MAX);
-
-        // Sanity check - all platforms have this, but never hurts to be certain
-
-        if (bufSize < 1024)
-        {
-            bufSize = 1024;
-        }
-
-        std::vector<char> buf(bufSize);
-
-        // Use reentrant form of getpwuid (it's reentrant, and it pacifies purify)
-#if !defined(sun)
-        int rc = getpwuid_r(m_uid, &pwd, &buf[0], buf.size(), &ppwd);
-        if (rc != 0)
-        {
-           ppwd = NULL;
-        }
-#else
-        ppwd = getpwuid_r(m_uid, &pwd, &buf[0], buf.size());
-#endif
-
-        if (ppwd)
-        {
-            m_name = StrFromUTF8(ppwd->pw_name);
-        }
-        else
+        if ( ! SCXUserCache::Instance().GetUserName(m_uid, m_name))
         {
             m_name = StrFrom(m_uid);
         }
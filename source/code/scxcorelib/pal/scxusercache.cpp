@@ -0,0 +1,380 @@
+/*--------------------------------------------------------------------------------
+    Copyright (c) Microsoft Corporation. All rights reserved. See license.txt for license information.
+
+*/
+/**
+    \file
+
+    \brief       Implements the user and group name cache.
+
+    \date        2026-10-16 16:00:00
+
+*/
+/*----------------------------------------------------------------------------*/
+
+#include <scxcorelib/scxcmn.h>
+#include <scxcorelib/scxdumpstring.h>
+#include <scxcorelib/scxusercache.h>
+#include <scxcorelib/stringaid.h>
+
+#include <vector>
+
+#if defined(SCX_UNIX)
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <pwd.h>
+#include <grp.h>
+#else
+#error "Platform not supported"
+#endif
+
+namespace SCXCoreLib
+{
+    SCXSingleton_Allocate(SCXUserCache);
+
+    /** Largest buffer tried for a single passwd or group lookup. */
+    static const size_t c_maxLookupBufferSize = 1024 * 1024;
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Default constructor.
+
+        Normally the cache is used through Instance(); separate instances
+        are allowed for unit tests.
+    */
+    SCXUserCache::SCXUserCache()
+        : m_lock(ThreadLockHandleGet()),
+          m_ttl(USERCACHE_DEFAULT_TTL),
+          m_negativeTtl(USERCACHE_DEFAULT_NEGATIVE_TTL),
+          m_hitCount(0),
+          m_missCount(0)
+    {
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Virtual destructor.
+    */
+    SCXUserCache::~SCXUserCache()
+    {
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Dump object as string (for logging).
+
+        \returns     The object represented as a string suitable for logging.
+    */
+    const std::wstring SCXUserCache::DumpString() const
+    {
+        SCXThreadLock lock(m_lock);
+        return SCXDumpStringBuilder("SCXUserCache")
+            .Scalar("Users", m_users.size())
+            .Scalar("Groups", m_groups.size())
+            .Scalar("HitCount", m_hitCount)
+            .Scalar("MissCount", m_missCount);
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Get the name of a user.
+
+        \param[in]  uid   User id.
+        \param[out] name  User name; unchanged if the user id has no name.
+        \returns    true if the user id has a name.
+    */
+    bool SCXUserCache::GetUserName(SCXUserID uid, std::wstring& name)
+    {
+        return GetName(m_users, static_cast<scxulong>(uid), true, name);
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Get the name of a group.
+
+        \param[in]  gid   Group id.
+        \param[out] name  Group name; unchanged if the group id has no name.
+        \returns    true if the group id has a name.
+    */
+    bool SCXUserCache::GetGroupName(SCXGroupID gid, std::wstring& name)
+    {
+        return GetName(m_groups, static_cast<scxulong>(gid), false, name);
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Set how long lookup results are kept.
+
+        \param[in]  seconds          Seconds a resolved name is kept.
+        \param[in]  negativeSeconds  Seconds a failed lookup is kept.
+
+        Zero means that results of that kind are not kept at all.
+    */
+    void SCXUserCache::SetTimeToLive(scxulong seconds, scxulong negativeSeconds)
+    {
+        SCXThreadLock lock(m_lock);
+        m_ttl = seconds;
+        m_negativeTtl = negativeSeconds;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Remove all cached lookup results.
+    */
+    void SCXUserCache::Clear()
+    {
+        SCXThreadLock lock(m_lock);
+        m_users.clear();
+        m_groups.clear();
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Get the number of requests answered from the cache.
+
+        \returns    Number of cache hits.
+    */
+    scxulong SCXUserCache::GetHitCount() const
+    {
+        SCXThreadLock lock(m_lock);
+        return m_hitCount;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Get the number of requests that needed a lookup.
+
+        \returns    Number of cache misses.
+    */
+    scxulong SCXUserCache::GetMissCount() const
+    {
+        SCXThreadLock lock(m_lock);
+        return m_missCount;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Look up a user name in the passwd database.
+
+        \param[in]  uid   User id.
+        \param[out] name  User name if found.
+        \returns    true if found.
+    */
+    bool SCXUserCache::LookupUserName(SCXUserID uid, std::wstring& name)
+    {
+        struct passwd pwd;
+        struct passwd *ppwd = NULL;
+        long bufSize = sysconf(_SC_GETPW_R_SIZE_MAX);
+
+        // Sanity check - all platforms have this, but never hurts to be certain
+        if (bufSize < 1024)
+        {
+            bufSize = 1024;
+        }
+
+        std::vector<char> buf(bufSize);
+
+        // Use reentrant form of getpwuid (it's reentrant, and it pacifies purify)
+        for (;;)
+        {
+#if !defined(sun)
+            int rc = getpwuid_r(uid, &pwd, &buf[0], buf.size(), &ppwd);
+            if (rc != 0)
+            {
+                ppwd = NULL;
+            }
+#else
+            ppwd = getpwuid_r(uid, &pwd, &buf[0], buf.size());
+            int rc = (NULL == ppwd) ? errno : 0;
+#endif
+            // Entries with many members may not fit the suggested size
+            if (NULL == ppwd && ERANGE == rc && buf.size() < c_maxLookupBufferSize)
+            {
+                buf.resize(buf.size() * 2);
+                continue;
+            }
+            break;
+        }
+
+        if (NULL == ppwd)
+        {
+            return false;
+        }
+
+        name = StrFromUTF8(ppwd->pw_name);
+        return true;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Look up a group name in the group database.
+
+        \param[in]  gid   Group id.
+        \param[out] name  Group name if found.
+        \returns    true if found.
+    */
+    bool SCXUserCache::LookupGroupName(SCXGroupID gid, std::wstring& name)
+    {
+        struct group grp;
+        struct group *pgrp = NULL;
+        long bufSize = sysconf(_SC_GETGR_R_SIZE_MAX);
+
+        // Sanity check - all platforms have this, but never hurts to be certain
+        if (bufSize < 1024)
+        {
+            bufSize = 1024;
+        }
+
+        std::vector<char> buf(bufSize);
+
+        for (;;)
+        {
+#if !defined(sun)
+            int rc = getgrgid_r(gid, &grp, &buf[0], buf.size(), &pgrp);
+            if (rc != 0)
+            {
+                pgrp = NULL;
+            }
+#else
+            pgrp = getgrgid_r(gid, &grp, &buf[0], buf.size());
+            int rc = (NULL == pgrp) ? errno : 0;
+#endif
+            // Groups with many members may not fit the suggested size
+            if (NULL == pgrp && ERANGE == rc && buf.size() < c_maxLookupBufferSize)
+            {
+                buf.resize(buf.size() * 2);
+                continue;
+            }
+            break;
+        }
+
+        if (NULL == pgrp)
+        {
+            return false;
+        }
+
+        name = StrFromUTF8(pgrp->gr_name);
+        return true;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Get the current time.
+
+        \returns    Current time in seconds.
+    */
+    time_t SCXUserCache::GetTime() const
+    {
+        return time(NULL);
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Get a name from the cache, looking it up if needed.
+
+        \param[in]  entries  Map to use (users or groups).
+        \param[in]  id       User or group id.
+        \param[in]  isUser   true if id is a user id, false if it is a group id.
+        \param[out] name     Name; unchanged if the id has no name.
+        \returns    true if the id has a name.
+    */
+    bool SCXUserCache::GetName(EntryMap& entries, scxulong id, bool isUser, std::wstring& name)
+    {
+        time_t now = GetTime();
+
+        {
+            SCXThreadLock lock(m_lock);
+            EntryMap::const_iterator it = entries.find(id);
+            if (it != entries.end() && ! IsExpired(it->second, now))
+            {
+                ++m_hitCount;
+                if (it->second.found)
+                {
+                    name = it->second.name;
+                }
+                return it->second.found;
+            }
+            ++m_missCount;
+        }
+
+        // The lock is not held here; concurrent misses for the same id will
+        // both do the lookup, and the last one to finish is kept
+        Entry entry;
+        entry.fetched = now;
+        if (isUser)
+        {
+            entry.found = LookupUserName(static_cast<SCXUserID>(id), entry.name);
+        }
+        else
+        {
+            entry.found = LookupGroupName(static_cast<SCXGroupID>(id), entry.name);
+        }
+
+        {
+            SCXThreadLock lock(m_lock);
+            if (entries.size() >= USERCACHE_MAX_ENTRIES)
+            {
+                Prune(entries, now);
+            }
+            entries[id] = entry;
+        }
+
+        if (entry.found)
+        {
+            name = entry.name;
+        }
+        return entry.found;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Check if a cached entry is too old to use.
+
+        \param[in]  entry  Cached entry.
+        \param[in]  now    Current time.
+        \returns    true if the entry must be looked up again.
+
+        Must be called with the lock held. An entry fetched "in the future"
+        (the clock was set back) is also considered expired.
+    */
+    bool SCXUserCache::IsExpired(const Entry& entry, time_t now) const
+    {
+        scxulong ttl = entry.found ? m_ttl : m_negativeTtl;
+        if (now < entry.fetched)
+        {
+            return true;
+        }
+        return static_cast<scxulong>(now - entry.fetched) >= ttl;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Remove expired entries; remove all entries if none has expired.
+
+        \param[in]  entries  Map to prune.
+        \param[in]  now      Current time.
+
+        Must be called with the lock held.
+    */
+    void SCXUserCache::Prune(EntryMap& entries, time_t now)
+    {
+        for (EntryMap::iterator it = entries.begin(); it != entries.end(); )
+        {
+            if (IsExpired(it->second, now))
+            {
+                entries.erase(it++);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        if (entries.size() >= USERCACHE_MAX_ENTRIES)
+        {
+            entries.clear();
+        }
+    }
+} /* namespace SCXCoreLib */
+/*----------------------------E-N-D---O-F---F-I-L-E---------------------------*/
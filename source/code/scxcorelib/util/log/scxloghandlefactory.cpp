@@ -16,6 +16,7 @@
 #include <scxcorelib/scxlog.h>
 #include <scxcorelib/scxlogpolicy.h>
 #include "scxlogmediatorsimple.h"
+#include "scxlogmediatorasync.h"
 #include "scxlogfileconfigurator.h"
 #include <signal.h>
 #include <errno.h>
@@ -72,10 +73,19 @@ namespace SCXCoreLib
         m_LogMediator(0),
         m_LogConfigurator(0)
     {
-        SCXHandle<SCXLogMediator> m( new SCXLogMediatorSimple() );
+        SCXHandle<SCXLogPolicy> policy = CustomLogPolicyFactory();
+        SCXHandle<SCXLogMediator> m( 0 );
+        if (policy->GetLogQueueSize() > 0)
+        {
+            m = new SCXLogMediatorAsync(policy->GetLogQueueSize());
+        }
+        else
+        {
+            m = new SCXLogMediatorSimple();
+        }
         m_LogMediator = m;
         m_LogConfigurator =
-            new SCXLogFileConfigurator(m, CustomLogPolicyFactory()->GetConfigFileName());
+            new SCXLogFileConfigurator(m, policy->GetConfigFileName());
 #if !defined(DISABLE_WIN_UNSUPPORTED)  
         InstallLogRotateSupport();
 #endif //!defined(DISABLE_WIN_UNSUPPORTED)  
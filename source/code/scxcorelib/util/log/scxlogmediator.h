@@ -15,6 +15,8 @@
 #define SCXLOGMEDIATOR_H
 
 #include <scxcorelib/scxlog.h>
+#include <scxcorelib/scxhandle.h>
+#include <set>
 
 namespace SCXCoreLib
 {
@@ -49,6 +51,30 @@ namespace SCXCoreLib
         */
         virtual bool DeRegisterConsumer(SCXHandle<SCXLogItemConsumerIf> consumer) = 0;
 
+    protected:
+        /*----------------------------------------------------------------------------*/
+        /**
+            A strict ordering is needed by the set template.
+        */
+        struct HandleCompare
+        {
+            /*----------------------------------------------------------------------------*/
+            /**
+                Compares two scxhandles.
+                It actually compares the addresses of the data that is pointed to by the
+                handles. This is of course random, but the exact order is not important in
+                this implementation. Only that there _is_ a strict order.
+                \param[in] h1 First handle to compare.
+                \param[in] h2 Second handle to compare.
+                \returns true if h1 is less than h2.
+            */
+            bool operator()(const SCXHandle<SCXLogItemConsumerIf> h1, const SCXHandle<SCXLogItemConsumerIf> h2) const
+            {
+                return h1.GetData() < h2.GetData();
+            }
+        };
+
+        typedef std::set<SCXHandle<SCXLogItemConsumerIf>, HandleCompare> ConsumerSet; //!< Defines a set of consumers.
     };
 }
 
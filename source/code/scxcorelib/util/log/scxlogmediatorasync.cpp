@@ -0,0 +1,460 @@
+/*--------------------------------------------------------------------------------
+    Copyright (c) Microsoft Corporation. All rights reserved. See license.txt for license information.
+
+*/
+/**
+    \file
+
+    \brief       Implementation for the asynchronous log mediator class.
+
+    \date        2026-10-16 14:00:00
+
+*/
+/*----------------------------------------------------------------------------*/
+
+#include "scxlogmediatorasync.h"
+#include <scxcorelib/scxlogitem.h>
+#include <scxcorelib/scxdumpstring.h>
+#include <scxcorelib/scxexception.h>
+#include <scxcorelib/stringaid.h>
+
+namespace SCXCoreLib
+{
+    const size_t SCXLogMediatorAsync::DEFAULT_QUEUE_SIZE;
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Thread parameters for the writer thread.
+    */
+    class SCXLogMediatorAsyncThreadParam : public SCXThreadParam
+    {
+    public:
+        /*----------------------------------------------------------------------------*/
+        /**
+            Constructor
+
+            \param[in] mediator  Mediator that owns the thread
+        */
+        SCXLogMediatorAsyncThreadParam(SCXLogMediatorAsync* mediator)
+            : SCXThreadParam(),
+              m_mediator(mediator)
+        {
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+            Retrieves the mediator that owns the thread
+
+            \returns     Pointer to the mediator
+        */
+        SCXLogMediatorAsync* GetMediator() { return m_mediator; }
+
+    private:
+        SCXLogMediatorAsync* m_mediator;    //!< Mediator that owns the thread
+    };
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Constructor.
+
+        The writer thread is started when the first item is logged.
+
+        \param[in] queueSize  Number of log items that may wait to be written
+        \throws    SCXInvalidArgumentException if queueSize is zero
+    */
+    SCXLogMediatorAsync::SCXLogMediatorAsync(size_t queueSize) :
+        m_consumerLock(ThreadLockHandleGet()),
+        m_ring(queueSize, static_cast<SCXLogItem*>(0)),
+        m_head(0),
+        m_count(0),
+        m_dropped(0),
+        m_droppedTotal(0),
+        m_written(0),
+        m_writerPid(0),
+        m_isWriting(false),
+        m_isTerminating(false),
+        m_rotateRequested(0)
+    {
+        if (0 == queueSize)
+        {
+            throw SCXInvalidArgumentException(L"queueSize", L"Log queue size must be greater than zero", SCXSRCLOCATION);
+        }
+
+        // The writer wakes up at least this often to look for log rotations
+        m_cond.SetSleep(1000);
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Destructor.
+
+        Stops the writer thread once it has handed all queued items to the
+        consumers.
+    */
+    SCXLogMediatorAsync::~SCXLogMediatorAsync()
+    {
+        {
+            SCXConditionHandle h(m_cond);
+            m_isTerminating = true;
+            h.Broadcast();
+        }
+
+        if (NULL != m_thread.GetData() && m_writerPid == SCXProcess::GetCurrentProcessID())
+        {
+            m_thread->Wait();
+        }
+
+        // Items left behind belong to a writer in another process (we were forked)
+        for (; m_count > 0; --m_count)
+        {
+            delete m_ring[m_head];
+            m_head = (m_head + 1) % m_ring.size();
+        }
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Log a message. The supplied item is queued for the writer thread, which
+        distributes it to those backends that have registered themselves. This
+        entry point is thread safe.
+
+        \param[in] item Log item to add to the log mediator.
+
+        \note If the queue is full, the item is dropped. In a process forked
+        after the writer thread was started, items are delivered synchronously
+        since the writer thread only exists in the parent.
+    */
+    void SCXLogMediatorAsync::LogThisItem(const SCXLogItem& item)
+    {
+        SCXProcessId pid = SCXProcess::GetCurrentProcessID();
+        SCXLogItem* copy = new SCXLogItem(item);
+        {
+            SCXConditionHandle h(m_cond);
+            if (NULL == m_thread.GetData())
+            {
+                m_writerPid = pid;
+                StartWriterThread();
+            }
+
+            if (m_writerPid == pid && !m_isTerminating)
+            {
+                if (m_count == m_ring.size())
+                {
+                    ++m_dropped;
+                    ++m_droppedTotal;
+                    delete copy;
+                    return;
+                }
+
+                m_ring[(m_head + m_count) % m_ring.size()] = copy;
+                // The writer only waits when the queue is empty
+                if (1 == ++m_count)
+                {
+                    h.Signal();
+                }
+                return;
+            }
+        }
+
+        std::vector<SCXLogItem*> items(1, copy);
+        Deliver(items, 0, false);
+        delete copy;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Register an SCXLogItemConsumerIf as a new receiver of log messages. It will
+        recieve all items that were logged through the LogThisItem interface.
+
+        \param[in] consumer SCXLogItemConsumerIf to register as consumer.
+        \returns False if consumer can't be added.
+    */
+    bool SCXLogMediatorAsync::RegisterConsumer(SCXHandle<SCXLogItemConsumerIf> consumer)
+    {
+        SCXThreadLock lock(m_consumerLock);
+        m_Consumers.insert(consumer);
+        return true;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        A registered consumer that is no longer interested in receiving SCXLogItems
+        can de-register itself through this interface. Waits for the consumer to
+        finish with a batch that is being written.
+
+        \param[in] consumer SCXLogItemConsumerIf to de-register.
+        \returns False if consumer was not previously registered.
+    */
+    bool SCXLogMediatorAsync::DeRegisterConsumer(SCXHandle<SCXLogItemConsumerIf> consumer)
+    {
+        SCXThreadLock lock(m_consumerLock);
+        return m_Consumers.erase(consumer) > 0;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Get the effective severity for a particular log module.
+
+        \param[in] module Log module to retrieve severity for.
+        \returns Effective severity for log module.
+
+    */
+    SCXLogSeverity SCXLogMediatorAsync::GetEffectiveSeverity(const std::wstring& module) const
+    {
+        SCXLogSeverity effectiveSeverity = eSuppress;
+        SCXThreadLock lock(m_consumerLock);
+        for (ConsumerSet::const_iterator i = m_Consumers.begin();
+             i != m_Consumers.end();
+             ++i)
+        {
+            SCXLogSeverity backendSeverity = (*i)->GetEffectiveSeverity(module);
+            if (backendSeverity < effectiveSeverity)
+            {
+                effectiveSeverity = backendSeverity;
+            }
+            if (effectiveSeverity == eHysterical)
+            {
+                return eHysterical;
+            }
+        }
+        return effectiveSeverity;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+       Handle log rotations that have occurred
+
+       Only records the request, since this is called from a signal handler.
+       The writer thread first hands the items queued so far to the consumers
+       and then lets them rotate.
+     */
+    void SCXLogMediatorAsync::HandleLogRotate()
+    {
+        m_rotateRequested = 1;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Waits until all queued items (and any requested log rotation) have been
+        handed to the consumers.
+
+        \note Items still queued when the process exits are lost, so call this
+        before exiting if the last log items matter.
+    */
+    void SCXLogMediatorAsync::Flush()
+    {
+        {
+            SCXConditionHandle h(m_cond);
+            if (NULL != m_thread.GetData() && m_writerPid == SCXProcess::GetCurrentProcessID())
+            {
+                h.Broadcast();
+                while (m_count > 0 || m_dropped > 0 || m_isWriting || 0 != m_rotateRequested)
+                {
+                    h.Wait();
+                }
+                return;
+            }
+        }
+
+        // No writer thread in this process; items were delivered synchronously
+        if (0 != m_rotateRequested)
+        {
+            m_rotateRequested = 0;
+            Deliver(std::vector<SCXLogItem*>(), 0, true);
+        }
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Get the number of log items dropped because the queue was full
+
+        \returns     Number of dropped items since construction
+    */
+    scxulong SCXLogMediatorAsync::GetDroppedCount() const
+    {
+        SCXConditionHandle h(m_cond);
+        return m_droppedTotal;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Get the number of log items handed to the consumers by the writer thread
+
+        \returns     Number of written items since construction
+    */
+    scxulong SCXLogMediatorAsync::GetWrittenCount() const
+    {
+        SCXConditionHandle h(m_cond);
+        return m_written;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Dump object as string (for logging).
+
+        \returns The object represented as a string suitable for logging.
+
+    */
+    const std::wstring SCXLogMediatorAsync::DumpString() const
+    {
+        SCXConditionHandle h(m_cond);
+        return SCXDumpStringBuilder("SCXLogMediatorAsync")
+            .Scalar("QueueSize", m_ring.size())
+            .Scalar("Queued", m_count)
+            .Scalar("Written", m_written)
+            .Scalar("Dropped", m_droppedTotal);
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Starts the writer thread. The condition must be locked.
+    */
+    void SCXLogMediatorAsync::StartWriterThread()
+    {
+        m_thread = new SCXThread(WriterThreadBody, new SCXLogMediatorAsyncThreadParam(this));
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Entry point of the writer thread.
+
+        \param[in]  param  Thread parameters, of type SCXLogMediatorAsyncThreadParam
+    */
+    void SCXLogMediatorAsync::WriterThreadBody(SCXThreadParamHandle& param)
+    {
+        SCXLogMediatorAsyncThreadParam* p = static_cast<SCXLogMediatorAsyncThreadParam*>(param.GetData());
+        SCXASSERT(NULL != p);
+        p->GetMediator()->DoWriterThread();
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Writer thread loop.
+
+        Takes everything that is queued in one go and hands it to the consumers
+        without holding the condition. Exits when asked to once the queue is
+        empty.
+    */
+    void SCXLogMediatorAsync::DoWriterThread()
+    {
+        std::vector<SCXLogItem*> batch;
+        batch.reserve(m_ring.size());
+
+        SCXConditionHandle h(m_cond);
+        for (;;)
+        {
+            if (0 == m_count && 0 == m_dropped && 0 == m_rotateRequested)
+            {
+                if (m_isTerminating)
+                {
+                    break;
+                }
+                h.Wait();
+                continue;
+            }
+
+            batch.clear();
+            for (; m_count > 0; --m_count)
+            {
+                batch.push_back(m_ring[m_head]);
+                m_ring[m_head] = 0;
+                m_head = (m_head + 1) % m_ring.size();
+            }
+            scxulong dropped = m_dropped;
+            m_dropped = 0;
+            bool rotate = 0 != m_rotateRequested;
+            m_rotateRequested = 0;
+            m_isWriting = true;
+            h.Unlock();
+
+            Deliver(batch, dropped, rotate);
+            for (std::vector<SCXLogItem*>::iterator it = batch.begin(); it != batch.end(); ++it)
+            {
+                delete *it;
+            }
+
+            h.Lock();
+            m_written += batch.size();
+            m_isWriting = false;
+            h.Broadcast();
+        }
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Hands log items to the consumers.
+
+        A consumer that throws only loses the rest of the current phase
+        (items, drop report or rotation); the other consumers and the later
+        phases are not affected. In particular, a requested rotation is
+        always passed on.
+
+        \param[in] items    Items to hand over, oldest first
+        \param[in] dropped  Number of items dropped after these were queued
+        \param[in] rotate   Should the consumers rotate their logs afterwards?
+    */
+    void SCXLogMediatorAsync::Deliver(const std::vector<SCXLogItem*>& items, scxulong dropped, bool rotate)
+    {
+        SCXThreadLock lock(m_consumerLock);
+        for (ConsumerSet::iterator i = m_Consumers.begin(); i != m_Consumers.end(); ++i)
+        {
+            try
+            {
+                for (std::vector<SCXLogItem*>::const_iterator it = items.begin(); it != items.end(); ++it)
+                {
+                    (*i)->LogThisItem(**it);
+                }
+            }
+            catch (const SCXException&)
+            {
+                // A failing backend can't be reported anywhere; it loses the rest of the batch
+            }
+            catch (const std::exception&)
+            {
+                // A failing backend can't be reported anywhere; it loses the rest of the batch
+            }
+        }
+
+        if (dropped > 0)
+        {
+            for (ConsumerSet::iterator i = m_Consumers.begin(); i != m_Consumers.end(); ++i)
+            {
+                try
+                {
+                    SCXLogItem item(L"scx.core.common.log", eWarning,
+                                    StrAppend(L"Log queue full; number of log items dropped: ", dropped),
+                                    SCXSRCLOCATION, SCXThread::GetCurrentThreadID());
+                    (*i)->LogThisItem(item);
+                }
+                catch (const SCXException&)
+                {
+                    // A failing backend can't be reported anywhere
+                }
+                catch (const std::exception&)
+                {
+                    // A failing backend can't be reported anywhere
+                }
+            }
+        }
+
+        if (rotate)
+        {
+            for (ConsumerSet::iterator i = m_Consumers.begin(); i != m_Consumers.end(); ++i)
+            {
+                try
+                {
+                    (*i)->HandleLogRotate();
+                }
+                catch (const SCXException&)
+                {
+                    // A failing backend can't be reported anywhere
+                }
+                catch (const std::exception&)
+                {
+                    // A failing backend can't be reported anywhere
+                }
+            }
+        }
+    }
+} /* namespace SCXCoreLib */
+/*----------------------------E-N-D---O-F---F-I-L-E---------------------------*/
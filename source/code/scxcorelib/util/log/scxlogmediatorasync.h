@@ -0,0 +1,101 @@
+/*--------------------------------------------------------------------------------
+    Copyright (c) Microsoft Corporation. All rights reserved. See license.txt for license information.
+
+*/
+/**
+    \file
+
+    \brief       Contains the definition of an asynchronous log mediator class.
+
+    \date        2026-10-16 14:00:00
+
+*/
+/*----------------------------------------------------------------------------*/
+#ifndef SCXLOGMEDIATORASYNC_H
+#define SCXLOGMEDIATORASYNC_H
+
+#include "scxlogmediator.h"
+#include <scxcorelib/scxcondition.h>
+#include <scxcorelib/scxhandle.h>
+#include <scxcorelib/scxprocess.h>
+#include <scxcorelib/scxthread.h>
+
+#include <signal.h>
+#include <vector>
+
+namespace SCXCoreLib
+{
+    /*----------------------------------------------------------------------------*/
+    /**
+        Asynchronous implementation of the log mediator interface.
+
+        Logging threads only copy the log item into a bounded ring buffer; a
+        writer thread takes all queued items at once and hands them to the
+        consumers. Formatting and file I/O are thus done on the writer thread,
+        and logging threads only contend for the short time it takes to store
+        a pointer in the ring.
+
+        When the ring is full, new items are dropped. The number of dropped
+        items is reported to the consumers as a warning before the next batch.
+
+        HandleLogRotate() may be called from a signal handler, so it only sets
+        a flag. The writer thread picks it up within a second, hands all items
+        queued before it to the consumers and then lets them rotate. Flush()
+        waits until that is done.
+
+        A consumer that throws does not keep the other consumers from getting
+        the items, nor any consumer from rotating.
+
+        This mediator is opt-in: SCXLogHandleFactory only uses it when the log
+        policy returns a non-zero SCXLogPolicy::GetLogQueueSize().
+    */
+    class SCXLogMediatorAsync : public SCXLogMediator
+    {
+    public:
+        /** Default number of log items that may wait to be written. */
+        static const size_t DEFAULT_QUEUE_SIZE = 4096;
+
+        explicit SCXLogMediatorAsync(size_t queueSize = DEFAULT_QUEUE_SIZE);
+        virtual ~SCXLogMediatorAsync();
+
+        virtual void LogThisItem(const SCXLogItem& item);
+        virtual SCXLogSeverity GetEffectiveSeverity(const std::wstring& module) const;
+        virtual bool RegisterConsumer(SCXHandle<SCXLogItemConsumerIf> consumer);
+        virtual bool DeRegisterConsumer(SCXHandle<SCXLogItemConsumerIf> consumer);
+        virtual void HandleLogRotate();
+
+        void Flush();
+        scxulong GetDroppedCount() const;
+        scxulong GetWrittenCount() const;
+
+        const std::wstring DumpString() const;
+    private:
+        // Do not allow copying
+        SCXLogMediatorAsync(const SCXLogMediatorAsync &);               //!< Intentionally not implemented
+        SCXLogMediatorAsync & operator=(const SCXLogMediatorAsync &);   //!< Intentionally not implemented
+
+        static void WriterThreadBody(SCXThreadParamHandle& param);
+        void DoWriterThread();
+        void StartWriterThread();
+        void Deliver(const std::vector<SCXLogItem*>& items, scxulong dropped, bool rotate);
+
+        SCXThreadLockHandle m_consumerLock;     //!< Synchronizes access to m_Consumers.
+        ConsumerSet m_Consumers;                //!< Set of currently subscribed consumers.
+
+        mutable SCXCondition m_cond;            //!< Protects the members below and wakes the writer.
+        std::vector<SCXLogItem*> m_ring;        //!< Ring buffer of queued log items.
+        size_t m_head;                          //!< Index of the oldest queued item.
+        size_t m_count;                         //!< Number of queued items.
+        scxulong m_dropped;                     //!< Items dropped since the last report.
+        scxulong m_droppedTotal;                //!< Items dropped since construction.
+        scxulong m_written;                     //!< Items handed to the consumers since construction.
+        SCXHandle<SCXThread> m_thread;          //!< The writer thread.
+        SCXProcessId m_writerPid;               //!< Process the writer thread runs in.
+        bool m_isWriting;                       //!< Is the writer handing items to the consumers?
+        bool m_isTerminating;                   //!< Writer asked to stop?
+        volatile sig_atomic_t m_rotateRequested; //!< Set by HandleLogRotate(); read without lock.
+    };
+}
+
+#endif /* SCXLOGMEDIATORASYNC_H */
+/*----------------------------E-N-D---O-F---F-I-L-E---------------------------*/
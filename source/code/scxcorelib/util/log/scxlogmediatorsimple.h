@@ -17,7 +17,6 @@
 #include "scxlogmediator.h"
 #include "scxlogbackend.h"
 #include <scxcorelib/scxhandle.h>
-#include <set>
 
 namespace SCXCoreLib
 {
@@ -29,31 +28,6 @@ namespace SCXCoreLib
     */
     class SCXLogMediatorSimple : public SCXLogMediator
     {
-    private:
-        /*----------------------------------------------------------------------------*/
-        /**
-            A strict ordering is needed by the set template.
-        */
-        struct HandleCompare
-        {
-            /*----------------------------------------------------------------------------*/
-            /**
-                Compares two scxhandles.
-                It actually compares the addresses of the data that is pointed to by the
-                handles. This is of course random, but the exact order is not important in
-                this implementation. Only that there _is_ a strict order.
-                \param[in] h1 First handle to compare.
-                \param[in] h2 Second handle to compare.
-                \returns true if h1 is less than h2.
-            */
-            bool operator()(const SCXHandle<SCXLogItemConsumerIf> h1, const SCXHandle<SCXLogItemConsumerIf> h2) const
-            {
-                return h1.GetData() < h2.GetData();
-            }
-        };
-
-        typedef std::set<SCXHandle<SCXLogItemConsumerIf>, HandleCompare> ConsumerSet; //!< Defines a set of consumers.
-
     public:
         SCXLogMediatorSimple();
         explicit SCXLogMediatorSimple(const SCXThreadLockHandle& lock);
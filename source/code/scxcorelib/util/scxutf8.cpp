@@ -0,0 +1,399 @@
+/*--------------------------------------------------------------------------------
+    Copyright (c) Microsoft Corporation. All rights reserved. See license.txt for license information.
+
+*/
+/**
+    \file
+
+    \brief       Buffer based UTF-8 transcoding, with vectorized runs of ASCII
+
+    \date        2026-10-17 03:00:00
+
+    Decodes and encodes whole buffers with the same rules as
+    SCXStream::ReadCharAsUTF8() and SCXStream::WriteAsUTF8Basic(), where
+    wchar_t holds the code point. Most strings passed through StrFromUTF8()
+    and StrToUTF8(), such as paths and the contents of /proc, are mostly
+    ASCII; runs of ASCII are transcoded 16 or 32 characters at a time with
+    SSE2 or AVX2, and everything else one character at a time.
+*/
+/*----------------------------------------------------------------------------*/
+
+#include <scxcorelib/scxcmn.h>
+#include <scxcorelib/scxutf8.h>
+
+// AVX2 code is compiled with the target attribute, so that the library
+// itself need not be built for AVX2; it is only run if the processor has it.
+#if defined(__x86_64__) && defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define SCX_UTF8_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    //! Number of UTF-8 extra bytes a wchar_t can hold the bits of, as in scxstream.cpp
+    const int cExtraBytesAllowed = static_cast<int>((sizeof(wchar_t) * 8 - 6) / 5);
+
+    //! Largest code point encoded; larger wchar_t values, and negative ones, are left to SCXStream
+    const unsigned long cMaxEncodedCodePoint = 0x7FFFFFFFUL;
+
+    //! Copies a run of ASCII bytes to wide characters, and returns its length
+    typedef size_t (*WidenFunction)(const unsigned char* src, size_t size, wchar_t* dst);
+
+    //! Copies a run of ASCII wide characters to bytes, and returns its length
+    typedef size_t (*NarrowFunction)(const wchar_t* src, size_t size, unsigned char* dst);
+
+    //! Instruction set in use; -1 until it is first needed
+    volatile int s_simdLevel = -1;
+
+    size_t WidenASCIIScalar(const unsigned char* src, size_t size, wchar_t* dst)
+    {
+        size_t i = 0;
+        while (i < size && src[i] < 0x80)
+        {
+            dst[i] = static_cast<wchar_t>(src[i]);
+            ++i;
+        }
+        return i;
+    }
+
+    size_t NarrowASCIIScalar(const wchar_t* src, size_t size, unsigned char* dst)
+    {
+        size_t i = 0;
+        while (i < size && static_cast<unsigned long>(src[i]) < 0x80)
+        {
+            dst[i] = static_cast<unsigned char>(src[i]);
+            ++i;
+        }
+        return i;
+    }
+
+#if defined(SCX_UTF8_X86_SIMD)
+
+    // SSE2 is part of x86-64, so needs no target attribute
+
+    size_t WidenASCIISSE2(const unsigned char* src, size_t size, wchar_t* dst)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        size_t i = 0;
+        for (; i + 16 <= size; i += 16)
+        {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            if (0 != _mm_movemask_epi8(bytes))
+            {
+                break;
+            }
+            __m128i low = _mm_unpacklo_epi8(bytes, zero);
+            __m128i high = _mm_unpackhi_epi8(bytes, zero);
+            __m128i* out = reinterpret_cast<__m128i*>(dst + i);
+            _mm_storeu_si128(out, _mm_unpacklo_epi16(low, zero));
+            _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(low, zero));
+            _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(high, zero));
+            _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(high, zero));
+        }
+        return i + WidenASCIIScalar(src + i, size - i, dst + i);
+    }
+
+    size_t NarrowASCIISSE2(const wchar_t* src, size_t size, unsigned char* dst)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i nonASCII = _mm_set1_epi32(~0x7F);
+        size_t i = 0;
+        for (; i + 16 <= size; i += 16)
+        {
+            const __m128i* in = reinterpret_cast<const __m128i*>(src + i);
+            __m128i a = _mm_loadu_si128(in);
+            __m128i b = _mm_loadu_si128(in + 1);
+            __m128i c = _mm_loadu_si128(in + 2);
+            __m128i d = _mm_loadu_si128(in + 3);
+            __m128i bits = _mm_and_si128(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d)), nonASCII);
+            if (0xFFFF != _mm_movemask_epi8(_mm_cmpeq_epi32(bits, zero)))
+            {
+                break;
+            }
+            // All values are below 0x80, so the saturating packs do not change them
+            __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), bytes);
+        }
+        return i + NarrowASCIIScalar(src + i, size - i, dst + i);
+    }
+
+    __attribute__((target("avx2")))
+    size_t WidenASCIIAVX2(const unsigned char* src, size_t size, wchar_t* dst)
+    {
+        size_t i = 0;
+        for (; i + 32 <= size; i += 32)
+        {
+            __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+            if (0 != _mm256_movemask_epi8(bytes))
+            {
+                break;
+            }
+            __m256i* out = reinterpret_cast<__m256i*>(dst + i);
+            for (int k = 0; k < 4; k++)
+            {
+                __m128i eight = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i + 8 * k));
+                _mm256_storeu_si256(out + k, _mm256_cvtepu8_epi32(eight));
+            }
+        }
+        // Clear the upper halves before running SSE code; not every compiler
+        // inserts this at every optimization level
+        _mm256_zeroupper();
+        return i + WidenASCIISSE2(src + i, size - i, dst + i);
+    }
+
+    __attribute__((target("avx2")))
+    size_t NarrowASCIIAVX2(const wchar_t* src, size_t size, unsigned char* dst)
+    {
+        const __m256i nonASCII = _mm256_set1_epi32(~0x7F);
+        // The packs work within 128 bit lanes; this puts the 4 byte groups back in order
+        const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+        size_t i = 0;
+        for (; i + 32 <= size; i += 32)
+        {
+            const __m256i* in = reinterpret_cast<const __m256i*>(src + i);
+            __m256i a = _mm256_loadu_si256(in);
+            __m256i b = _mm256_loadu_si256(in + 1);
+            __m256i c = _mm256_loadu_si256(in + 2);
+            __m256i d = _mm256_loadu_si256(in + 3);
+            __m256i all = _mm256_or_si256(_mm256_or_si256(a, b), _mm256_or_si256(c, d));
+            if (!_mm256_testz_si256(all, nonASCII))
+            {
+                break;
+            }
+            __m256i bytes = _mm256_packus_epi16(_mm256_packs_epi32(a, b), _mm256_packs_epi32(c, d));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_permutevar8x32_epi32(bytes, order));
+        }
+        _mm256_zeroupper();
+        return i + NarrowASCIISSE2(src + i, size - i, dst + i);
+    }
+
+#endif /* SCX_UTF8_X86_SIMD */
+
+    //! \returns The best instruction set the processor supports
+    SCXCoreLib::UTF8SimdLevel DetectSimdLevel()
+    {
+#if defined(SCX_UTF8_X86_SIMD)
+        if (sizeof(wchar_t) == sizeof(int))
+        {
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2"))
+            {
+                return SCXCoreLib::eUTF8AVX2;
+            }
+            return SCXCoreLib::eUTF8SSE2;
+        }
+#endif
+        return SCXCoreLib::eUTF8Scalar;
+    }
+
+    //! \returns Widening function of the selected instruction set
+    WidenFunction GetWidenFunction()
+    {
+#if defined(SCX_UTF8_X86_SIMD)
+        SCXCoreLib::UTF8SimdLevel level = SCXCoreLib::GetUTF8SimdLevel();
+        if (SCXCoreLib::eUTF8AVX2 == level)
+        {
+            return WidenASCIIAVX2;
+        }
+        if (SCXCoreLib::eUTF8SSE2 == level)
+        {
+            return WidenASCIISSE2;
+        }
+#endif
+        return WidenASCIIScalar;
+    }
+
+    //! \returns Narrowing function of the selected instruction set
+    NarrowFunction GetNarrowFunction()
+    {
+#if defined(SCX_UTF8_X86_SIMD)
+        SCXCoreLib::UTF8SimdLevel level = SCXCoreLib::GetUTF8SimdLevel();
+        if (SCXCoreLib::eUTF8AVX2 == level)
+        {
+            return NarrowASCIIAVX2;
+        }
+        if (SCXCoreLib::eUTF8SSE2 == level)
+        {
+            return NarrowASCIISSE2;
+        }
+#endif
+        return NarrowASCIIScalar;
+    }
+}
+
+namespace SCXCoreLib
+{
+    /*----------------------------------------------------------------------------*/
+    /**
+        Decode UTF-8.
+
+        \param[in]  data    The UTF-8 bytes.
+        \param[in]  size    Number of bytes.
+        \param[out] result  The decoded characters; unspecified if decoding fails.
+        \returns    false if data is not a sequence of characters that
+                    SCXStream::ReadCharAsUTF8() accepts.
+
+        As with SCXStream::ReadCharAsUTF8(), a lead byte must be followed by
+        as many continuation bytes as it gives, and the character must fit in
+        a wchar_t; overlong forms and surrogates are decoded as they are.
+    */
+    bool UTF8Decode(const char* data, size_t size, std::wstring& result)
+    {
+        result.resize(size);
+        if (0 == size)
+        {
+            return true;
+        }
+
+        WidenFunction widen = GetWidenFunction();
+        const unsigned char* pos = reinterpret_cast<const unsigned char*>(data);
+        const unsigned char* end = pos + size;
+        wchar_t* const outStart = &result[0];
+        wchar_t* out = outStart;
+        while (pos < end)
+        {
+            size_t ascii = widen(pos, static_cast<size_t>(end - pos), out);
+            pos += ascii;
+            out += ascii;
+            if (pos == end)
+            {
+                break;
+            }
+
+            unsigned char first = *pos++;
+            int leadingOnes = 0;
+            for (unsigned char bits = first; (bits & 0x80) != 0; bits = static_cast<unsigned char>(bits << 1))
+            {
+                ++leadingOnes;
+            }
+            const int extraBytes = leadingOnes - 1;
+            if (0 == extraBytes || extraBytes > cExtraBytesAllowed || end - pos < extraBytes)
+            {
+                // A continuation byte, too many extra bytes for a wchar_t, or a truncated character
+                return false;
+            }
+
+            unsigned long codePoint = first & (0xFFu >> leadingOnes);
+            for (int i = 0; i < extraBytes; i++, pos++)
+            {
+                if ((*pos >> 6) != 0x2)
+                {
+                    return false;
+                }
+                codePoint = (codePoint << 6) | (*pos & 0x3Fu);
+            }
+            *out++ = static_cast<wchar_t>(codePoint);
+        }
+        result.resize(static_cast<size_t>(out - outStart));
+        return true;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Encode as UTF-8.
+
+        \param[in]  data    The characters.
+        \param[in]  size    Number of characters.
+        \param[out] result  The UTF-8 bytes; unspecified if encoding fails.
+        \returns    false if a character is negative or above 0x7FFFFFFF,
+                    which SCXStream::WriteAsUTF8Basic() does not encode.
+
+        Characters are encoded as SCXStream::WriteAsUTF8Basic() encodes them,
+        in up to six bytes.
+    */
+    bool UTF8Encode(const wchar_t* data, size_t size, std::string& result)
+    {
+        // Room for all ASCII; grown as other characters need it
+        result.resize(size);
+        if (0 == size)
+        {
+            return true;
+        }
+
+        NarrowFunction narrow = GetNarrowFunction();
+        size_t used = 0;
+        size_t i = 0;
+        while (i < size)
+        {
+            // There is always room for at least one byte per character left
+            size_t ascii = narrow(data + i, size - i, reinterpret_cast<unsigned char*>(&result[used]));
+            i += ascii;
+            used += ascii;
+            if (i == size)
+            {
+                break;
+            }
+
+            unsigned long codePoint = static_cast<unsigned long>(data[i++]);
+            if (codePoint > cMaxEncodedCodePoint)
+            {
+                return false;
+            }
+            int extraBytes = 1;
+            while ((codePoint >> (5 * extraBytes + 6)) != 0)
+            {
+                ++extraBytes;
+            }
+            size_t needed = used + static_cast<size_t>(extraBytes) + 1 + (size - i);
+            if (needed > result.size())
+            {
+                result.resize(needed > 2 * result.size() ? needed : 2 * result.size());
+            }
+            result[used++] = static_cast<char>(static_cast<unsigned char>((0xFFu << (7 - extraBytes)) | (codePoint >> (6 * extraBytes))));
+            for (int shift = 6 * (extraBytes - 1); shift >= 0; shift -= 6)
+            {
+                result[used++] = static_cast<char>(static_cast<unsigned char>(0x80u | ((codePoint >> shift) & 0x3Fu)));
+            }
+        }
+        result.resize(used);
+        return true;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Get the instruction set runs of ASCII are transcoded with.
+
+        \returns    The instruction set in use.
+    */
+    UTF8SimdLevel GetUTF8SimdLevel()
+    {
+        int level = s_simdLevel;
+        if (level < 0)
+        {
+            // Threads racing here all store the same value
+            level = DetectSimdLevel();
+            s_simdLevel = level;
+        }
+        return static_cast<UTF8SimdLevel>(level);
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Get the best instruction set the processor and the build support.
+
+        \returns    The best instruction set.
+    */
+    UTF8SimdLevel GetUTF8SupportedSimdLevel()
+    {
+        return DetectSimdLevel();
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Choose the instruction set runs of ASCII are transcoded with, for
+        unit tests and benchmarks. Not to be called while other threads
+        transcode.
+
+        \param[in]  level   The instruction set wanted.
+        \returns    The instruction set now in use: level, or the best one
+                    supported if level is not.
+    */
+    UTF8SimdLevel SetUTF8SimdLevel(UTF8SimdLevel level)
+    {
+        UTF8SimdLevel supported = DetectSimdLevel();
+        s_simdLevel = level > supported ? supported : level;
+        return static_cast<UTF8SimdLevel>(s_simdLevel);
+    }
+}
+
+/*----------------------------E-N-D---O-F---F-I-L-E---------------------------*/
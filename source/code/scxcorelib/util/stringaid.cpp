@@ -33,6 +33,7 @@
 #include <errno.h>
 
 #include <scxcorelib/scxstream.h>
+#include <scxcorelib/scxutf8.h>
 
 
 using namespace std;
@@ -81,6 +82,16 @@ namespace SCXCoreLib
     */
     wstring StrFromUTF8(const string &utf8_str)
     {
+#if !defined(sun)
+        // Same rules as SCXStream::ReadCharAsUTF8(), on the whole buffer at once
+        wstring result;
+        if (!UTF8Decode(utf8_str.data(), utf8_str.size(), result))
+        {
+            throw SCXStringConversionException(SCXSRCLOCATION);
+        }
+        return result;
+#else
+        // Solaris may decode through iconv
         try
         {
             istringstream utf8source(utf8_str);
@@ -95,6 +106,7 @@ namespace SCXCoreLib
         {
             throw SCXStringConversionException(SCXSRCLOCATION);
         }
+#endif
     }
 
     /*----------------------------------------------------------------------------*/
@@ -107,6 +119,14 @@ namespace SCXCoreLib
     */
     string StrToUTF8(const wstring& str)
     {
+#if !defined(sun)
+        string result;
+        if (UTF8Encode(str.data(), str.size(), result))
+        {
+            return result;
+        }
+        // Characters outside what UTF8Encode() handles are left to SCXStream
+#endif
         ostringstream utf8target;
         SCXStream::WriteAsUTF8(utf8target, str);
         return utf8target.str();
@@ -0,0 +1,180 @@
+/*--------------------------------------------------------------------------------
+    Copyright (c) Microsoft Corporation. All rights reserved. See license.txt for license information.
+
+*/
+/**
+    \file
+
+    \brief       Number parsing over spans of characters
+
+    \date        2026-10-17 04:00:00
+
+*/
+/*----------------------------------------------------------------------------*/
+
+#include <scxcorelib/scxcmn.h>
+#include <scxcorelib/stringspan.h>
+
+namespace
+{
+    /*----------------------------------------------------------------------------*/
+    /**
+        Parse decimal digits.
+
+        \param[in]  pos    First digit.
+        \param[in]  end    End of the digits.
+        \param[in]  limit  Largest value allowed.
+        \param[out] value  Receives the value.
+        \param[out] stop   Receives the position after the last digit; NULL
+                           if there must be nothing but digits.
+        \returns    false if there are no digits, anything but digits where
+                    not allowed, or a value larger than limit.
+    */
+    template <typename C>
+    bool ParseDigits(const C* pos, const C* end, scxulong limit, scxulong& value, const C** stop)
+    {
+        if (pos == end || *pos < C('0') || *pos > C('9'))
+        {
+            return false;
+        }
+        scxulong result = 0;
+        for ( ; pos < end; ++pos)
+        {
+            if (*pos < C('0') || *pos > C('9'))
+            {
+                if (NULL == stop)
+                {
+                    return false;
+                }
+                break;
+            }
+            scxulong digit = static_cast<scxulong>(*pos - C('0'));
+            if (result > (limit - digit) / 10)
+            {
+                return false;
+            }
+            result = result * 10 + digit;
+        }
+        value = result;
+        if (NULL != stop)
+        {
+            *stop = pos;
+        }
+        return true;
+    }
+
+    //! Set the rest of a span, if asked for
+    template <typename C>
+    void SetRest(SCXCoreLib::BasicStrSpan<C>* rest, const C* stop, const SCXCoreLib::BasicStrSpan<C>& span)
+    {
+        if (NULL != rest)
+        {
+            *rest = SCXCoreLib::BasicStrSpan<C>(stop, static_cast<size_t>(span.Data() + span.Size() - stop));
+        }
+    }
+
+    //! Parse an unsigned decimal number; see SCXCoreLib::StrSpanToULong()
+    template <typename C>
+    bool ParseULong(const SCXCoreLib::BasicStrSpan<C>& span, scxulong& value, SCXCoreLib::BasicStrSpan<C>* rest)
+    {
+        const C* pos = span.Data();
+        const C* end = pos + span.Size();
+        if (pos < end && C('+') == *pos)
+        {
+            ++pos;
+        }
+        const C* stop = NULL;
+        if ( ! ParseDigits(pos, end, ~static_cast<scxulong>(0), value, NULL == rest ? NULL : &stop))
+        {
+            return false;
+        }
+        SetRest(rest, stop, span);
+        return true;
+    }
+
+    //! Parse a signed decimal number; see SCXCoreLib::StrSpanToLong()
+    template <typename C>
+    bool ParseLong(const SCXCoreLib::BasicStrSpan<C>& span, scxlong& value, SCXCoreLib::BasicStrSpan<C>* rest)
+    {
+        const C* pos = span.Data();
+        const C* end = pos + span.Size();
+        bool negative = false;
+        if (pos < end && (C('+') == *pos || C('-') == *pos))
+        {
+            negative = C('-') == *pos;
+            ++pos;
+        }
+        // The magnitude of the smallest scxlong is one more than that of the largest
+        const scxulong maxLong = ~static_cast<scxulong>(0) >> 1;
+        scxulong magnitude;
+        const C* stop = NULL;
+        if ( ! ParseDigits(pos, end, negative ? maxLong + 1 : maxLong, magnitude, NULL == rest ? NULL : &stop))
+        {
+            return false;
+        }
+        SetRest(rest, stop, span);
+        value = negative ? static_cast<scxlong>(0 - magnitude) : static_cast<scxlong>(magnitude);
+        return true;
+    }
+}
+
+namespace SCXCoreLib
+{
+    /*----------------------------------------------------------------------------*/
+    /**
+        Parse an unsigned decimal number.
+
+        \param[in]  span   Digits, optionally preceded by '+'; tokens from a
+                           trimming tokenizer have no blanks left to skip.
+        \param[out] value  Receives the number; unchanged if false is returned.
+        \param[out] rest   Receives what follows the digits, such as a unit;
+                           NULL if span must hold nothing but the number.
+        \returns    false if span does not start with a number, holds more
+                    after it when rest is NULL, or holds a number too large
+                    for a scxulong.
+
+        Unlike StrToULong(), no exception is thrown, so a hot parsing loop can
+        skip a bad value cheaply.
+    */
+    bool StrSpanToULong(const StrSpan& span, scxulong& value, StrSpan* rest)
+    {
+        return ParseULong(span, value, rest);
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        \copydoc StrSpanToULong(const StrSpan&, scxulong&, StrSpan*)
+    */
+    bool StrSpanToULong(const WStrSpan& span, scxulong& value, WStrSpan* rest)
+    {
+        return ParseULong(span, value, rest);
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Parse a signed decimal number.
+
+        \param[in]  span   Digits, optionally preceded by '+' or '-'.
+        \param[out] value  Receives the number; unchanged if false is returned.
+        \param[out] rest   Receives what follows the digits; NULL if span
+                           must hold nothing but the number.
+        \returns    false if span does not start with a number, holds more
+                    after it when rest is NULL, or holds a number out of the
+                    range of a scxlong.
+    */
+    bool StrSpanToLong(const StrSpan& span, scxlong& value, StrSpan* rest)
+    {
+        return ParseLong(span, value, rest);
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        \copydoc StrSpanToLong(const StrSpan&, scxlong&, StrSpan*)
+    */
+    bool StrSpanToLong(const WStrSpan& span, scxlong& value, WStrSpan* rest)
+    {
+        return ParseLong(span, value, rest);
+    }
+}
+
+/*----------------------------E-N-D---O-F---F-I-L-E---------------------------*/
@@ -0,0 +1,391 @@
+/*--------------------------------------------------------------------------------
+    Copyright (c) Microsoft Corporation. All rights reserved. See license.txt for license information.
+
+*/
+/**
+    \file
+
+    \brief       Parallel update of entity instances
+
+    \date        2026-10-16 17:00:00
+
+*/
+/*----------------------------------------------------------------------------*/
+
+#include <scxcorelib/scxcmn.h>
+
+#include <scxcorelib/scxcondition.h>
+#include <scxcorelib/scxexception.h>
+#include <scxcorelib/stringaid.h>
+#include <scxsystemlib/entityupdater.h>
+
+#if defined(SCX_UNIX)
+#include <sys/time.h>
+#endif
+
+using namespace SCXCoreLib;
+
+namespace SCXSystemLib
+{
+    /*----------------------------------------------------------------------------*/
+    /**
+        Get a timestamp in milliseconds.
+
+        \returns   Milliseconds since some fixed point in time.
+    */
+    static scxulong GetMillisecondTimeStamp()
+    {
+#if defined(SCX_UNIX)
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        return static_cast<scxulong>(tv.tv_sec) * 1000 + static_cast<scxulong>(tv.tv_usec) / 1000;
+#elif defined(WIN32)
+        return static_cast<scxulong>(GetTickCount());
+#endif
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        State shared between the caller of EntityUpdater::UpdateInstances() and
+        the tasks updating the instances.
+
+        The tasks hold a handle to the batch, so it stays valid for updates that
+        are still running after the caller has stopped waiting for them.
+    */
+    class EntityUpdateBatch
+    {
+    public:
+        /** Progress of one instance update. */
+        struct Slot
+        {
+            Slot() : started(0), done(false), abandoned(false) {}
+
+            scxulong started;   //!< When the update started, 0 while it is still queued
+            bool done;          //!< Has the update returned?
+            bool abandoned;     //!< Has the caller stopped waiting for it?
+        };
+
+        /*----------------------------------------------------------------------------*/
+        /**
+            Constructor
+
+            \param[in] count   Number of instances updated in the batch.
+        */
+        explicit EntityUpdateBatch(size_t count)
+            : m_slots(count),
+              m_waiting(count),
+              m_lastProgress(GetMillisecondTimeStamp())
+        {
+        }
+
+        SCXCondition m_cond;            //!< Protects the members below; signaled when an update returns
+        std::vector<Slot> m_slots;      //!< One slot per instance
+        size_t m_waiting;               //!< Slots neither done nor abandoned
+        scxulong m_lastProgress;        //!< When an update last started or returned
+    };
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Parameters of the task updating one instance.
+    */
+    class EntityUpdateTaskParam : public SCXThreadParam
+    {
+    public:
+        /*----------------------------------------------------------------------------*/
+        /**
+            Constructor
+
+            \param[in] batch     Batch the update belongs to.
+            \param[in] index     Slot of the update in the batch.
+            \param[in] update    Update to run.
+        */
+        EntityUpdateTaskParam(SCXHandle<EntityUpdateBatch> batch, size_t index, SCXHandle<EntityUpdate> update)
+            : SCXThreadParam(),
+              m_batch(batch),
+              m_index(index),
+              m_update(update)
+        {
+        }
+
+        SCXHandle<EntityUpdateBatch> m_batch;   //!< Batch the update belongs to
+        size_t m_index;                         //!< Slot of the update in the batch
+        SCXHandle<EntityUpdate> m_update;       //!< Update to run
+    };
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Update one instance (runs on a thread pool worker).
+
+        The private copy of the instance is updated, and published to the
+        instance only if the caller still waits for it. Since the caller waits
+        on the same condition, the instance is never written once the caller
+        has given up on the update.
+
+        \param[in] param   EntityUpdateTaskParam of the update.
+    */
+    static void EntityUpdateTask(SCXThreadParamHandle& param)
+    {
+        EntityUpdateTaskParam* p = static_cast<EntityUpdateTaskParam*>(param.GetData());
+        SCXASSERT(NULL != p);
+        EntityUpdateBatch& batch = *p->m_batch;
+
+        {
+            SCXConditionHandle h(batch.m_cond);
+            batch.m_lastProgress = batch.m_slots[p->m_index].started = GetMillisecondTimeStamp();
+        }
+
+        EntityInstance& copy = p->m_update->GetCopy();
+        try {
+            copy.Update();
+            copy.ResetUnexpectedException();
+        } catch ( SCXException& e ){
+            static scx_atomic_t s_ExceptionsCounter(0);
+
+            if ( s_ExceptionsCounter < 10 ){
+                scx_atomic_increment( &s_ExceptionsCounter );
+                SCX_LOGERROR(
+                    SCXLogHandleFactory::GetLogHandle(L"scx.core.common.pal.system.entityupdater"),
+                    std::wstring(L"Unexpected exception during instance-update; only first 10 errors are logged; ") +
+                        e.What() + std::wstring(L"; ") + e.Where() );
+            }
+            copy.SetUnexpectedException( e );
+        }
+
+        {
+            SCXConditionHandle h(batch.m_cond);
+            EntityUpdateBatch::Slot& slot = batch.m_slots[p->m_index];
+            slot.done = true;
+            batch.m_lastProgress = GetMillisecondTimeStamp();
+            if ( ! slot.abandoned)
+            {
+                p->m_update->Publish();
+                --batch.m_waiting;
+                h.Signal();
+            }
+        }
+    }
+
+    const scxulong EntityUpdater::c_DefaultDeadlineMs;
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Get the thread pool shared by the enumerations that update their instances
+        in parallel by default.
+
+        \returns   The pool, started on first use.
+
+        The pool is never destroyed: that would wait for its threads, and an
+        abandoned update may be stuck on a device until the process exits.
+    */
+    SCXHandle<SCXThreadPool> EntityUpdater::GetSharedPool()
+    {
+        static SCXHandle<SCXThreadPool>* s_pool = NULL;
+
+        SCXThreadLock lock(ThreadLockHandleGet(L"EntityUpdaterSharedPool"));
+        if (NULL == s_pool)
+        {
+            s_pool = new SCXHandle<SCXThreadPool>(new SCXThreadPool());
+            (*s_pool)->Start();
+        }
+        return *s_pool;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Constructor
+
+        \param[in] pool        Started thread pool to run the updates on.
+        \param[in] deadlineMs  Milliseconds to wait for each instance update, 0 to
+                               wait for as long as it takes.
+
+        An update is waited for from when it starts running. An update still
+        waiting for a worker thread is given up on when no update of the same
+        call has started or returned during the deadline.
+    */
+    EntityUpdater::EntityUpdater(SCXHandle<SCXThreadPool> pool, scxulong deadlineMs)
+        : m_pool(pool),
+          m_deadlineMs(deadlineMs),
+          m_log(SCXLogHandleFactory::GetLogHandle(L"scx.core.common.pal.system.entityupdater")),
+          m_lock(ThreadLockHandleGet()),
+          m_timeoutCount(0),
+          m_skipCount(0)
+    {
+        if (NULL == m_pool)
+        {
+            throw SCXInvalidArgumentException(L"pool", L"Thread pool must not be NULL", SCXSRCLOCATION);
+        }
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Destructor
+
+        Abandoned updates still running keep their batch and instance copy alive
+        on their own, so there is nothing to wait for here.
+    */
+    EntityUpdater::~EntityUpdater()
+    {
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Run the Update() method on a number of instances in parallel.
+
+        \param[in] updates   Updates of the instances.
+
+        Returns when every update has returned or passed its deadline. Exceptions
+        thrown by an update are recorded in the instance, as for a serial update.
+        Instances whose update passed its deadline keep the values they had.
+    */
+    void EntityUpdater::UpdateInstances(const std::vector<SCXHandle<EntityUpdate> >& updates)
+    {
+        std::vector<SCXHandle<EntityUpdate> > toUpdate;
+        toUpdate.reserve(updates.size());
+        for (size_t i = 0; i < updates.size(); i++)
+        {
+            if (IsStillRunning(&updates[i]->GetInstance()))
+            {
+                SCXThreadLock lock(m_lock);
+                ++m_skipCount;
+                continue;
+            }
+            toUpdate.push_back(updates[i]);
+        }
+
+        if (toUpdate.empty())
+        {
+            return;
+        }
+
+        SCXHandle<EntityUpdateBatch> batch(new EntityUpdateBatch(toUpdate.size()));
+        std::vector<SCXThreadPoolTaskHandle> tasks;
+        tasks.reserve(toUpdate.size());
+        for (size_t i = 0; i < toUpdate.size(); i++)
+        {
+            SCXThreadParamHandle param(new EntityUpdateTaskParam(batch, i, toUpdate[i]));
+            tasks.push_back(SCXThreadPoolTaskHandle(new SCXThreadPoolTask(EntityUpdateTask, param)));
+        }
+        m_pool->QueueTasks(tasks);
+
+        std::vector<size_t> abandoned;
+        {
+            SCXConditionHandle h(batch->m_cond);
+            while (batch->m_waiting > 0)
+            {
+                scxulong now = GetMillisecondTimeStamp();
+                scxulong nextDeadline = 0;
+
+                for (size_t i = 0; i < batch->m_slots.size(); i++)
+                {
+                    EntityUpdateBatch::Slot& slot = batch->m_slots[i];
+                    if (slot.done || slot.abandoned)
+                    {
+                        continue;
+                    }
+
+                    if (0 == m_deadlineMs)
+                    {
+                        continue;
+                    }
+
+                    scxulong deadline = (0 != slot.started ? slot.started : batch->m_lastProgress) + m_deadlineMs;
+                    if (now >= deadline)
+                    {
+                        slot.abandoned = true;
+                        --batch->m_waiting;
+                        abandoned.push_back(i);
+                    }
+                    else if (0 == nextDeadline || deadline < nextDeadline)
+                    {
+                        nextDeadline = deadline;
+                    }
+                }
+
+                if (batch->m_waiting > 0)
+                {
+                    // Without a deadline, sleep until an update returns
+                    batch->m_cond.SetSleep(0 != nextDeadline ? nextDeadline - now : 0);
+                    h.Wait();
+                }
+            }
+        }
+
+        if ( ! abandoned.empty())
+        {
+            SCXThreadLock lock(m_lock);
+            for (size_t i = 0; i < abandoned.size(); i++)
+            {
+                const EntityInstance& instance = toUpdate[abandoned[i]]->GetInstance();
+                m_abandoned[&instance] = AbandonedUpdate(batch, abandoned[i]);
+                ++m_timeoutCount;
+                SCX_LOGWARNING(m_log, StrAppend(StrAppend(L"Update of instance ", instance.GetId()),
+                                                StrAppend(L" did not finish within (ms) ", m_deadlineMs)));
+            }
+        }
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Get the number of instance updates that passed their deadline.
+
+        \returns   Number of abandoned updates.
+    */
+    scxulong EntityUpdater::GetTimeoutCount() const
+    {
+        SCXThreadLock lock(m_lock);
+        return m_timeoutCount;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Get the number of instance updates skipped since an abandoned update of
+        the same instance was still running.
+
+        \returns   Number of skipped updates.
+    */
+    scxulong EntityUpdater::GetSkipCount() const
+    {
+        SCXThreadLock lock(m_lock);
+        return m_skipCount;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Check if an abandoned update of an instance is still running.
+
+        \param[in] instance   Instance to check.
+        \returns   true if the instance must not be updated again yet.
+
+        Forgets about the abandoned update once it has returned.
+    */
+    bool EntityUpdater::IsStillRunning(const EntityInstance* instance)
+    {
+        SCXHandle<EntityUpdateBatch> batch(0);
+        size_t index = 0;
+        {
+            SCXThreadLock lock(m_lock);
+            AbandonedMap::iterator it = m_abandoned.find(instance);
+            if (it == m_abandoned.end())
+            {
+                return false;
+            }
+            batch = it->second.first;
+            index = it->second.second;
+        }
+
+        bool done;
+        {
+            SCXConditionHandle h(batch->m_cond);
+            done = batch->m_slots[index].done;
+        }
+
+        if (done)
+        {
+            SCXThreadLock lock(m_lock);
+            m_abandoned.erase(instance);
+        }
+        return ! done;
+    }
+}
+
+/*----------------------------E-N-D---O-F---F-I-L-E---------------------------*/
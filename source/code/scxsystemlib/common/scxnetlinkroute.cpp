@@ -0,0 +1,290 @@
+/*--------------------------------------------------------------------------------
+    Copyright (c) Microsoft Corporation. All rights reserved. See license.txt for license information.
+
+*/
+/**
+    \file
+
+    \brief       Routing netlink socket kept open between requests
+
+    \date        2026-10-16 19:00:00
+
+*/
+/*----------------------------------------------------------------------------*/
+
+#include <scxcorelib/scxcmn.h>
+#include <scxcorelib/scxexception.h>
+#include <scxcorelib/stringaid.h>
+#include <scxsystemlib/scxnetlinkroute.h>
+
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#if defined(linux)
+#include <sys/time.h>
+#include <unistd.h>
+#include <linux/types.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#endif
+
+using namespace SCXCoreLib;
+
+namespace SCXSystemLib
+{
+    //! Initial size of the receive buffer; recent kernels send dump replies of at most 32 kB
+    static const size_t cInitialBufferSize = 32 * 1024;
+    //! Largest receive buffer that is reasonable to ask for
+    static const size_t cMaxBufferSize = 1024 * 1024;
+    //! Seconds to wait for a reply before giving up on a dump
+    static const long cReceiveTimeout = 5;
+    //! Times to request a dump that the kernel reports as interrupted
+    static const unsigned int cDumpAttempts = 3;
+#if defined(linux)
+#if defined(NLM_F_DUMP_INTR)
+    //! Flag of a dump reply whose table changed during the dump
+    static const unsigned short cDumpInterrupted = NLM_F_DUMP_INTR;
+#else
+    //! Flag of a dump reply whose table changed during the dump (Linux 3.1 and later)
+    static const unsigned short cDumpInterrupted = 0x10;
+#endif
+#endif
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Constructor
+
+        No socket is opened until the first dump.
+    */
+    NetlinkRouteSocket::NetlinkRouteSocket()
+        : m_lock(ThreadLockHandleGet()),
+          m_fd(-1),
+          m_seq(0)
+    {
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Destructor
+    */
+    NetlinkRouteSocket::~NetlinkRouteSocket()
+    {
+        Close();
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Dump a kernel table.
+
+        \param[in]  type      Request type, such as RTM_GETLINK or RTM_GETADDR.
+        \param[in]  family    Address family to dump, AF_UNSPEC for all.
+        \param[out] messages  The netlink messages of the reply, one after the
+                              other, without the terminating NLMSG_DONE.
+
+        \throws SCXErrnoException if the socket cannot be opened, the request
+                cannot be sent or the kernel reports an error.
+        \throws SCXInternalErrorException if a reply does not fit in the buffer,
+                or every attempt at the dump was interrupted.
+    */
+    void NetlinkRouteSocket::Dump(unsigned short type, unsigned char family, std::vector<char>& messages)
+    {
+        messages.clear();
+#if defined(linux)
+        SCXThreadLock lock(m_lock);
+
+        for (unsigned int attempt = 1; ! DumpOnce(type, family, messages); attempt++)
+        {
+            if (attempt >= cDumpAttempts)
+            {
+                messages.clear();
+                throw SCXInternalErrorException(StrAppend(L"Netlink dump interrupted by changes to the table, attempts: ",
+                                                          attempt), SCXSRCLOCATION);
+            }
+        }
+#else
+        (void) type;
+        (void) family;
+        throw SCXNotSupportedException(L"Netlink", SCXSRCLOCATION);
+#endif
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Creates an endpoint for communication.
+
+        \param domain   - communications domain, selects the protocol family.
+        \param type     - socket type, specifies the communication semantics.
+        \param protocol - protocol to be used with the socket.
+        \returns          on success a file descriptor of new socket, otherwise returns -1 and sets errno.
+    */
+    int NetlinkRouteSocket::socket(int domain, int type, int protocol)
+    {
+        return ::socket(domain, type, protocol);
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Sends a message to another socket.
+
+        \param sockfd   - sending socket file descriptor.
+        \param buf      - buffer containing the message to be sent.
+        \param len      - length of the message to be sent.
+        \param flags    - flags.
+        \returns          on success returns number of characters sent, otherwise returns -1 and sets errno.
+    */
+    ssize_t NetlinkRouteSocket::send(int sockfd, const void *buf, size_t len, int flags)
+    {
+        return ::send(sockfd, buf, len, flags);
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Receives a message from a socket.
+
+        \param sockfd   - receiving socket file descriptor.
+        \param buf      - buffer to receive the messages.
+        \param len      - length of the buffer.
+        \param flags    - flags.
+        \returns          on success returns number of characters received, otherwise returns -1 and sets errno.
+    */
+    ssize_t NetlinkRouteSocket::recv(int sockfd, void *buf, size_t len, int flags)
+    {
+        return ::recv(sockfd, buf, len, flags);
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Request a dump of a kernel table once and receive the reply.
+
+        \param[in]  type      Request type, see Dump().
+        \param[in]  family    Address family to dump, see Dump().
+        \param[out] messages  The netlink messages of the reply, see Dump().
+        \returns    false if the kernel marked the dump as interrupted.
+
+        \throws     As Dump(). The caller must hold m_lock.
+    */
+    bool NetlinkRouteSocket::DumpOnce(unsigned short type, unsigned char family, std::vector<char>& messages)
+    {
+        messages.clear();
+#if defined(linux)
+        if (m_fd < 0)
+        {
+            m_fd = socket(PF_NETLINK, SOCK_DGRAM, NETLINK_ROUTE);
+            if (m_fd < 0)
+            {
+                throw SCXErrnoException(L"socket(PF_NETLINK)", errno, SCXSRCLOCATION);
+            }
+
+            // A kernel that never answers must not hang the caller
+            struct timeval timeout;
+            timeout.tv_sec = cReceiveTimeout;
+            timeout.tv_usec = 0;
+            setsockopt(m_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        }
+        if (m_buffer.empty())
+        {
+            m_buffer.resize(cInitialBufferSize);
+        }
+
+        char request[NLMSG_SPACE(sizeof(struct rtgenmsg))];
+        memset(request, 0, sizeof(request));
+        struct nlmsghdr* header = reinterpret_cast<struct nlmsghdr*>(request);
+        header->nlmsg_len = NLMSG_LENGTH(sizeof(struct rtgenmsg));
+        header->nlmsg_type = type;
+        header->nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+        header->nlmsg_seq = ++m_seq;
+        static_cast<struct rtgenmsg*>(NLMSG_DATA(header))->rtgen_family = family;
+
+        if (send(m_fd, request, header->nlmsg_len, 0) < 0)
+        {
+            int err = errno;
+            Close();
+            throw SCXErrnoException(L"send(PF_NETLINK)", err, SCXSRCLOCATION);
+        }
+
+        bool interrupted = false;
+        while (true)
+        {
+            // MSG_TRUNC makes recv() return the full length of a reply that does not fit
+            ssize_t length = recv(m_fd, &m_buffer[0], m_buffer.size(), MSG_TRUNC);
+            if (length < 0)
+            {
+                int err = errno;
+                if (EINTR == err)
+                {
+                    continue;
+                }
+                Close();
+                messages.clear();
+                throw SCXErrnoException(L"recv(PF_NETLINK)", err, SCXSRCLOCATION);
+            }
+            if (static_cast<size_t>(length) > m_buffer.size())
+            {
+                // The rest of the reply is lost; the next dump gets a bigger buffer
+                if (m_buffer.size() < cMaxBufferSize)
+                {
+                    m_buffer.resize(m_buffer.size() * 2);
+                }
+                Close();
+                messages.clear();
+                throw SCXInternalErrorException(L"Netlink reply did not fit in the receive buffer", SCXSRCLOCATION);
+            }
+
+            unsigned int remaining = static_cast<unsigned int>(length);
+            for (struct nlmsghdr* msg = reinterpret_cast<struct nlmsghdr*>(&m_buffer[0]);
+                 NLMSG_OK(msg, remaining);
+                 msg = NLMSG_NEXT(msg, remaining))
+            {
+                if (msg->nlmsg_seq != m_seq)
+                {
+                    continue;
+                }
+                if (0 != (msg->nlmsg_flags & cDumpInterrupted))
+                {
+                    interrupted = true;
+                }
+                if (NLMSG_DONE == msg->nlmsg_type)
+                {
+                    return ! interrupted;
+                }
+                if (NLMSG_ERROR == msg->nlmsg_type)
+                {
+                    int err = EIO;
+                    if (msg->nlmsg_len >= NLMSG_LENGTH(sizeof(struct nlmsgerr)))
+                    {
+                        err = -static_cast<struct nlmsgerr*>(NLMSG_DATA(msg))->error;
+                    }
+                    Close();
+                    messages.clear();
+                    throw SCXErrnoException(L"Netlink dump", err, SCXSRCLOCATION);
+                }
+
+                size_t size = NLMSG_ALIGN(msg->nlmsg_len) < remaining ? NLMSG_ALIGN(msg->nlmsg_len) : remaining;
+                const char* data = reinterpret_cast<const char*>(msg);
+                messages.insert(messages.end(), data, data + size);
+            }
+        }
+#else
+        (void) type;
+        (void) family;
+        throw SCXNotSupportedException(L"Netlink", SCXSRCLOCATION);
+#endif
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Close the socket, if open.
+    */
+    void NetlinkRouteSocket::Close()
+    {
+#if defined(linux)
+        if (m_fd >= 0)
+        {
+            ::close(m_fd);
+        }
+#endif
+        m_fd = -1;
+    }
+}
+
+/*----------------------------E-N-D---O-F---F-I-L-E---------------------------*/
@@ -21,6 +21,7 @@
 #include <scxcorelib/scxfile.h>
 #include <scxcorelib/scxfilepath.h>
 #include <scxcorelib/stringaid.h>
+#include <scxcorelib/stringspan.h>
 
 #include <scxsystemlib/cpuenumeration.h>
 #include <scxsystemlib/cpuinstance.h>
@@ -36,6 +37,10 @@
 # include <errno.h>
 #endif
 
+#if defined(linux)
+# include <string.h>
+#endif
+
 // System-specific includes
 
 #if defined(hpux)
@@ -70,16 +75,27 @@ using namespace SCXCoreLib;
 namespace SCXSystemLib
 {
     /**
-       Returns a stream for reading from /proc/stat
+       Read the whole of /proc/stat into a buffer.
+
+       \param[in,out] buffer  Buffer to read into; grown if the file does not fit.
+       \returns       Number of bytes read.
+       \throws        SCXErrnoException if the file cannot be opened or read.
     */
-    SCXHandle<std::wistream> CPUPALDependencies::OpenStatFile() const
+    size_t CPUPALDependencies::ReadStatFile(std::vector<char>& buffer) const
     {
-#if defined(WIN32)
-        return SCXFile::OpenWFstream(SCXFilePath(L"C:\\stat.txt"), ios::in);
-#elif defined(linux)
-        return SCXFile::OpenWFstream(SCXFilePath(L"/proc/stat"), ios::in);
+#if defined(linux)
+        return SCXFile::ReadAllBytes(SCXFilePath(L"/proc/stat"), buffer);
+#elif defined(WIN32)
+        std::ifstream statFile("C:\\stat.txt", std::ios::in | std::ios::binary);
+        if ( ! statFile)
+        {
+            throw SCXFilePathNotFoundException(SCXFilePath(L"C:\\stat.txt"), SCXSRCLOCATION);
+        }
+        buffer.assign(std::istreambuf_iterator<char>(statFile), std::istreambuf_iterator<char>());
+        return buffer.size();
 #else
-        return SCXHandle<std::wistream>(0);
+        (void) buffer;
+        return 0;
 #endif
     }
 
@@ -240,9 +256,9 @@ namespace SCXSystemLib
 
     /*----------------------------------------------------------------------------*/
     /**
-       Class that represents values passed between the threads of the memory instance.
+       Class that represents values passed to the sampler of the CPU enumeration.
 
-       Representation of values passed between the threads of the memory instance.
+       Representation of values passed to the sampler of the CPU enumeration.
     */
     class CPUEnumerationThreadParam : public SCXThreadParam
     {
@@ -251,7 +267,7 @@ namespace SCXSystemLib
         /**
          Constructor
 
-         \param[in]     cpuenum  Pointer to CPU enumeration associated with the thread.
+         \param[in]     cpuenum  Pointer to CPU enumeration associated with the sampler.
         */
         CPUEnumerationThreadParam(CPUEnumeration *cpuenum)
             : SCXThreadParam(), m_cpuenum(cpuenum)
@@ -261,14 +277,14 @@ namespace SCXSystemLib
         /**
          Retrieves the CPU enumeration parameter.
 
-         \returns  Pointer to CPU enumeration associated with the thread.
+         \returns  Pointer to CPU enumeration associated with the sampler.
         */
         CPUEnumeration* GetCPUEnumeration()
         {
             return m_cpuenum;
         }
     private:
-        CPUEnumeration* m_cpuenum; //!< Pointer to CPU enumeration associated with the thread.
+        CPUEnumeration* m_cpuenum; //!< Pointer to CPU enumeration associated with the sampler.
     };
 
     /*----------------------------------------------------------------------------*/
@@ -286,7 +302,10 @@ namespace SCXSystemLib
         m_lock(SCXCoreLib::ThreadLockHandleGet()),
         m_sampleSecs(sampleSecs),
         m_sampleSize(sampleSize),
-        m_dataAquisitionThread(NULL)
+        m_samplerId(0)
+#if defined(linux) || defined(WIN32)
+        , m_statBufferLock(SCXCoreLib::ThreadLockHandleGet())
+#endif
 #if defined(aix)
         , m_dataarea(deps->sysconf(_SC_NPROCESSORS_CONF))
 #endif /* aix */
@@ -311,13 +330,9 @@ namespace SCXSystemLib
     CPUEnumeration::~CPUEnumeration()
     {
         SCX_LOGTRACE(m_log, L"CPUEnumeration destructor");
-        if (NULL != m_dataAquisitionThread)
+        if (0 != m_samplerId)
         {
-            if (m_dataAquisitionThread->IsAlive())
-            {
-                CleanUp();
-            }
-            m_dataAquisitionThread = NULL;
+            CleanUp();
         }
     }
     /*----------------------------------------------------------------------------*/
@@ -332,10 +347,11 @@ namespace SCXSystemLib
 
         Update(false);
 
-        if (NULL == m_dataAquisitionThread)
+        if (0 == m_samplerId)
         {
-            CPUEnumerationThreadParam* params = new CPUEnumerationThreadParam(this);
-            m_dataAquisitionThread = new SCXCoreLib::SCXThread(CPUEnumeration::DataAquisitionThreadBody, params);
+            SCXCoreLib::SCXThreadParamHandle params(new CPUEnumerationThreadParam(this));
+            m_samplerId = SCXCoreLib::SCXSampleScheduler::Instance().Register(
+                CPUEnumeration::DataAquisitionSampleBody, params, static_cast<scxulong>(m_sampleSecs) * 1000);
         }
     }
 
@@ -458,27 +474,28 @@ namespace SCXSystemLib
             SCXCoreLib::SCXStream::IsGood(*statFile);
             SCXCoreLib::SCXStream::ReadLine(*statFile, line, nlf))
         {
-            vector<wstring> tokens;
-
             SCX_LOGHYSTERICAL(logH, wstring(L"CPUEnumeration ProcessorCountPhysical - Read line: ").append(line));
 
-            StrTokenize(line, tokens, L":");
+            WStrSpanTokenizer tokenizer(line, L":");
+            WStrSpan tokens[2];
+            size_t count = tokenizer.Next(tokens, 2);
+
+            // See example of stat file at the end of this source code file
+            //
+            // Count the unique "physical id" lines in the cpuinfo file.
+            // Note that physical IDs need not be monotonically increasing
+            // (see WI 44326 for more information on this).
 
-            if (tokens.size() > 0)
+            if (count > 0 && tokens[0].Equals(L"physical id"))
             {
-                // See example of stat file at the end of this source code file
-                //
-                // Count the unique "physical id" lines in the cpuinfo file.
-                // Note that physical IDs need not be monotonically increasing
-                // (see WI 44326 for more information on this).
+                SCX_LOGHYSTERICAL(logH, L"CPUEnumeration ProcessorCountPhysical - Found \"physical id\" row");
 
-                if (0 == tokens[0].compare(L"physical id"))
+                scxulong thisID = 0;
+                if (count < 2 || ! StrSpanToULong(tokens[1], thisID))
                 {
-                    SCX_LOGHYSTERICAL(logH, L"CPUEnumeration ProcessorCountPhysical - Found \"physical id\" row");
-
-                    size_t thisID = StrToUInt(tokens[1]);
-                    uniquePhysicalIDs.insert(thisID);
+                    throw SCXNotSupportedException(L"Cannot parse physical id in: '" + line + L"'", SCXSRCLOCATION);
                 }
+                uniquePhysicalIDs.insert(static_cast<size_t>(thisID));
             }
         }
 
@@ -659,6 +676,11 @@ namespace SCXSystemLib
     */
     void CPUEnumeration::Update(bool updateInstances)
     {
+#if !defined(hpux)
+        // Counted before locking; the lock is only needed to change the collection
+        size_t count = ProcessorCountLogical(m_deps);
+#endif
+
         SCXCoreLib::SCXThreadLock lock(m_lock);
 
 #if defined(hpux)
@@ -683,8 +705,6 @@ namespace SCXSystemLib
         {
             throw SCXInternalErrorException(L"pstat_getprocessor() failed", SCXSRCLOCATION);
         }
-#else
-        size_t count = ProcessorCountLogical(m_deps);
 #endif // defined(hpux)
 
         SCX_LOGTRACE(m_log, StrAppend(StrAppend(L"CPUEnumeration Update() - ", updateInstances).append(L" - "), count));
@@ -861,8 +881,8 @@ namespace SCXSystemLib
     void CPUEnumeration::CleanUp()
     {
         SCX_LOGTRACE(m_log, L"CPUEnumeration CleanUp()");
-        m_dataAquisitionThread->RequestTerminate();
-        m_dataAquisitionThread->Wait();
+        SCXCoreLib::SCXSampleScheduler::Instance().Unregister(m_samplerId);
+        m_samplerId = 0;
     }
 
     /*----------------------------------------------------------------------------*/
@@ -884,6 +904,15 @@ namespace SCXSystemLib
 #endif
 
         SCX_LOGTRACE(m_log, L"CPUEnumeration - Start SampleData");
+
+#if defined(linux) || defined(WIN32)
+        // The stat file is read without holding the enumeration lock so that a
+        // slow read never holds up Update(); only storing the counters in the
+        // instances is done with the lock held.
+        SCXHandle<const CPUStatSnapshot> snapshot = ReadStatSnapshot();
+        m_statSnapshot.Publish(snapshot);
+#endif
+
         SCX_LOGHYSTERICAL(m_log, L"CPUEnumeration SampleData - Acquire lock ");
 
         SCXCoreLib::SCXThreadLock lock(m_lock);
@@ -892,122 +921,7 @@ namespace SCXSystemLib
 
 #if defined(linux) || defined(WIN32)
 
-        SCXHandle<std::wistream> statFile = m_deps->OpenStatFile();
-        wstring line;
-        SCXCoreLib::SCXStream::NLF nlf;
-
-        for (SCXCoreLib::SCXStream::ReadLine(*statFile, line, nlf);
-         SCXCoreLib::SCXStream::IsGood(*statFile);
-         SCXCoreLib::SCXStream::ReadLine(*statFile, line, nlf))
-        {
-            vector<wstring> tokens;
-            SCXCoreLib::SCXHandle<CPUInstance> inst(0);
-
-            SCX_LOGHYSTERICAL(m_log, wstring(L"CPUEnumeration SampleData - Read line: ").append(line));
-
-            StrTokenize(line, tokens);
-
-            if (tokens.size() > 0)
-            {
-                // See example of stat file at the end of this source code file
-                if (StrIsPrefix(tokens[0], L"cpu"))
-                {
-                    if (tokens[0].compare(L"cpu") == 0)
-                    {
-                        inst = GetTotalInstance();
-                        SCX_LOGHYSTERICAL(m_log, L"CPUEnumeration SampleData - Found total row");
-                    }
-
-                    for (size_t i = 0; inst == NULL && i < Size(); i++)
-                    {
-                        SCXCoreLib::SCXHandle<CPUInstance> tmp_inst = GetInstance(i);
-
-                        // Concatinate a string to match representing a specific CPU
-                        if (tokens[0].compare(wstring(L"cpu").append(tmp_inst->GetProcName())) == 0)
-                        {
-                            inst = tmp_inst;
-                            SCX_LOGHYSTERICAL(m_log, StrAppend(L"CPUEnumeration SampleData - Found instance row - ", inst->GetProcNumber()));
-                        }
-                    }
-
-                    if (inst != NULL)
-                    {
-                        scxulong user = 0;
-                        scxulong nice = 0;
-                        scxulong system = 0;
-                        scxulong idle = 0;
-                        scxulong iowait = 0;
-                        scxulong irq = 0;
-                        scxulong softirq = 0;
-
-                        if (tokens.size() >= 5)
-                        {
-                            try
-                            {
-                                user = StrToULong(tokens[1]);
-                                SCX_LOGHYSTERICAL(m_log, StrAppend(L"    Read user = ", user));
-                                nice = StrToULong(tokens[2]);
-                                SCX_LOGHYSTERICAL(m_log, StrAppend(L"    Read nice = ", nice));
-                                system = StrToULong(tokens[3]);
-                                SCX_LOGHYSTERICAL(m_log, StrAppend(L"    Read system = ", system));
-                                idle = StrToULong(tokens[4]);
-                                SCX_LOGHYSTERICAL(m_log, StrAppend(L"    Read idle = ", idle));
-                            }
-                            catch (const SCXNotSupportedException& e)
-                            {
-                                SCX_LOGWARNING(m_log, wstring(L"Could not parse line from stat file: ").append(line).append(L" - ").append(e.What()));
-                            }
-                            if (tokens.size() >= 8)
-                            {
-                                try
-                                {
-                                    iowait = StrToULong(tokens[5]);
-                                    SCX_LOGHYSTERICAL(m_log, StrAppend(L"    Read iowait = ", iowait));
-                                    irq = StrToULong(tokens[6]);
-                                    SCX_LOGHYSTERICAL(m_log, StrAppend(L"    Read irq = ", irq));
-                                    softirq = StrToULong(tokens[7]);
-                                    SCX_LOGHYSTERICAL(m_log, StrAppend(L"    Read softirq = ", softirq));
-                                }
-                                catch (const SCXNotSupportedException& e)
-                                {
-                                    SCX_LOGWARNING(m_log, wstring(L"Could not parse line from stat file: ").append(line).append(L" - ").append(e.What()));
-                                }
-                            }
-                            else
-                            {
-                                iowait = irq = softirq = 0;
-                            }
-
-                            scxulong total_tics = user + nice + system + iowait + irq + softirq + idle;
-
-                            SCX_LOGHYSTERICAL(m_log, StrAppend(L"    Calculate total = ", total_tics));
-
-                            // Add new values using friendship declared on the
-                            // instance class (the m_*_tics properties are private)
-                            inst->m_UserCPU_tics.AddSample(user);
-                            inst->m_NiceCPU_tics.AddSample(nice);
-                            inst->m_SystemCPUTime_tics.AddSample(system);
-                            inst->m_IdleCPU_tics.AddSample(idle);
-                            inst->m_IOWaitTime_tics.AddSample(iowait);
-                            inst->m_IRQTime_tics.AddSample(irq);
-                            inst->m_SoftIRQTime_tics.AddSample(softirq);
-                            inst->m_Total_tics.AddSample(total_tics);
-
-                            SCX_LOGHYSTERICAL(m_log, L"CPUEnumeration SampleData - All Values stored");
-
-                        }
-                        else
-                        {
-                            SCX_LOGERROR(m_log, StrAppend(L"CPUEnumeration SampleData - Too few column in data file - ", tokens.size()));
-                        }
-                    }
-                    else
-                    {
-                        SCX_LOGERROR(m_log, wstring(L"CPUEnumeration SampleData - No CPU in list found that match row in data file - ").append(tokens[0]));
-                    }
-                }
-            }
-        }
+        ApplyStatSnapshot(*snapshot);
 
 #elif defined(sun) || defined(hpux)
 
@@ -1179,30 +1093,293 @@ namespace SCXSystemLib
         SCX_LOGTRACE(m_log, L"CPUEnumeration - End SampleData");
     }
 
+#if defined(linux) || defined(WIN32)
     /*----------------------------------------------------------------------------*/
     /**
-     Thread body that updates all values
+     Read the stat file.
+
+     \returns      New snapshot holding the counters read.
+
+     Does not touch any instance, so the enumeration lock need not be held.
+     The file is read into a buffer that is kept between samples.
+    */
+    SCXHandle<const CPUStatSnapshot> CPUEnumeration::ReadStatSnapshot()
+    {
+        SCXCoreLib::SCXThreadLock lock(m_statBufferLock);
+        size_t size = m_deps->ReadStatFile(m_statBuffer);
+
+        return ParseStatFile(0 == size ? "" : &m_statBuffer[0], size, m_log);
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+     Parse the contents of the stat file.
+
+     \param[in]     data  Contents of the stat file.
+     \param[in]     size  Number of bytes in data.
+     \param[in]     logH  Log handle (for logging purposes).
+     \returns      New snapshot holding the counters read.
+
+     Every line is scanned once, in place; the only allocations made are for
+     the snapshot and its rows. Rows of the file that are not needed are
+     skipped after looking at their first word.
+    */
+    SCXHandle<const CPUStatSnapshot> CPUEnumeration::ParseStatFile(
+        const char* data,
+        size_t size,
+        const SCXCoreLib::SCXLogHandle& logH)
+    {
+        // Columns read from a "cpu" row: the name, 7 tick counters and any number of ignored ones
+        const size_t c_ticksColumns = 7;
+
+        std::vector<CPUStatRow> rows;
+        CPUStatSystemCounters counters;
+        const char* pos = data;
+        const char* end = data + size;
+
+        while (pos < end)
+        {
+            const char* eol = static_cast<const char*>(memchr(pos, '\n', static_cast<size_t>(end - pos)));
+            if (NULL == eol)
+            {
+                eol = end;
+            }
+            const char* line = pos;
+            pos = eol + 1;
+
+            const char* word = line;
+            while (word < eol && ' ' != *word && '\t' != *word)
+            {
+                ++word;
+            }
+            size_t wordLength = static_cast<size_t>(word - line);
+
+            // See example of stat file at the end of this source code file
+            scxulong* counter = NULL;
+            if (4 == wordLength && 0 == memcmp(line, "ctxt", 4))
+            {
+                counter = &counters.contextSwitches;
+            }
+            else if (4 == wordLength && 0 == memcmp(line, "intr", 4))
+            {
+                counter = &counters.interrupts;
+            }
+            else if (13 == wordLength && 0 == memcmp(line, "procs_running", 13))
+            {
+                counter = &counters.procsRunning;
+            }
+            if (NULL != counter)
+            {
+                while (word < eol && (' ' == *word || '\t' == *word))
+                {
+                    ++word;
+                }
+                for (*counter = 0; word < eol && *word >= '0' && *word <= '9'; ++word)
+                {
+                    *counter = *counter * 10 + static_cast<scxulong>(*word - '0');
+                }
+                continue;
+            }
+
+            if (wordLength < 3 || 0 != memcmp(line, "cpu", 3))
+            {
+                continue;
+            }
+
+            CPUStatRow row;
+            row.isTotal = (3 == wordLength);
+            row.cpu = 0;
+            bool validName = true;
+            for (const char* p = line + 3; p < line + wordLength; ++p)
+            {
+                if (*p < '0' || *p > '9')
+                {
+                    validName = false;
+                    break;
+                }
+                row.cpu = row.cpu * 10 + static_cast<unsigned int>(*p - '0');
+            }
+            if ( ! validName)
+            {
+                SCX_LOGERROR(logH, StrAppend(L"CPUEnumeration SampleData - Unexpected row in data file - ",
+                                             StrFromUTF8(std::string(line, wordLength))));
+                continue;
+            }
+
+            scxulong ticks[c_ticksColumns] = { 0, 0, 0, 0, 0, 0, 0 };
+            size_t columns = 0;
+            bool validNumbers = true;
+            const char* p = word;
+            while (p < eol)
+            {
+                while (p < eol && (' ' == *p || '\t' == *p || '\r' == *p))
+                {
+                    ++p;
+                }
+                if (p == eol)
+                {
+                    break;
+                }
+                scxulong value = 0;
+                const char* token = p;
+                for ( ; p < eol && *p >= '0' && *p <= '9'; ++p)
+                {
+                    value = value * 10 + static_cast<scxulong>(*p - '0');
+                }
+                if (p == token || (p < eol && ' ' != *p && '\t' != *p && '\r' != *p))
+                {
+                    validNumbers = false;
+                    while (p < eol && ' ' != *p && '\t' != *p)
+                    {
+                        ++p;
+                    }
+                }
+                if (columns < c_ticksColumns)
+                {
+                    ticks[columns] = value;
+                }
+                ++columns;
+            }
+
+            if (columns < 4)
+            {
+                SCX_LOGERROR(logH, StrAppend(L"CPUEnumeration SampleData - Too few column in data file - ", columns + 1));
+                continue;
+            }
+            if ( ! validNumbers)
+            {
+                SCX_LOGWARNING(logH, StrAppend(L"Could not parse line from stat file: ",
+                                               StrFromUTF8(std::string(line, static_cast<size_t>(eol - line)))));
+            }
+
+            row.user = ticks[0];
+            row.nice = ticks[1];
+            row.system = ticks[2];
+            row.idle = ticks[3];
+
+            // Older kernels have only the first four counters
+            if (columns >= c_ticksColumns)
+            {
+                row.iowait = ticks[4];
+                row.irq = ticks[5];
+                row.softirq = ticks[6];
+            }
+            else
+            {
+                row.iowait = row.irq = row.softirq = 0;
+            }
+
+            row.total = row.user + row.nice + row.system + row.iowait + row.irq + row.softirq + row.idle;
+
+            rows.push_back(row);
+        }
+
+        return SCXHandle<const CPUStatSnapshot>(new CPUStatSnapshot(rows, counters));
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+     Store the counters of a snapshot in the matching instances.
+
+     \param[in]     snapshot  Counters read by ReadStatSnapshot().
+
+     Must be called with the enumeration lock held.
+
+     Update() keeps the instance of CPU N at position N of the collection, so
+     a row finds its instance directly; the collection is only searched if
+     that ever does not hold.
+    */
+    void CPUEnumeration::ApplyStatSnapshot(const CPUStatSnapshot& snapshot)
+    {
+        const std::vector<CPUStatRow>& rows = snapshot.GetRows();
+
+        for (std::vector<CPUStatRow>::const_iterator row = rows.begin(); row != rows.end(); ++row)
+        {
+            SCXCoreLib::SCXHandle<CPUInstance> inst(0);
+
+            if (row->isTotal)
+            {
+                inst = GetTotalInstance();
+                SCX_LOGHYSTERICAL(m_log, L"CPUEnumeration SampleData - Found total row");
+            }
+            else
+            {
+                if (row->cpu < Size())
+                {
+                    inst = GetInstance(row->cpu);
+                }
+
+                if (inst == NULL || inst->GetProcNumber() != row->cpu)
+                {
+                    inst = 0;
+                    for (size_t i = 0; inst == NULL && i < Size(); i++)
+                    {
+                        if (GetInstance(i)->GetProcNumber() == row->cpu)
+                        {
+                            inst = GetInstance(i);
+                        }
+                    }
+                }
+            }
+
+            if (inst == NULL)
+            {
+                SCX_LOGERROR(m_log, StrAppend(L"CPUEnumeration SampleData - No CPU in list found that match row in data file - cpu", row->cpu));
+                continue;
+            }
+
+            // Add new values using friendship declared on the
+            // instance class (the m_*_tics properties are private)
+            inst->m_UserCPU_tics.AddSample(row->user);
+            inst->m_NiceCPU_tics.AddSample(row->nice);
+            inst->m_SystemCPUTime_tics.AddSample(row->system);
+            inst->m_IdleCPU_tics.AddSample(row->idle);
+            inst->m_IOWaitTime_tics.AddSample(row->iowait);
+            inst->m_IRQTime_tics.AddSample(row->irq);
+            inst->m_SoftIRQTime_tics.AddSample(row->softirq);
+            inst->m_Total_tics.AddSample(row->total);
+        }
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+     Get the counters read by the most recent sample.
+
+     \returns      Snapshot of the counters, NULL if nothing has been sampled yet.
+
+     Never waits for a sample in progress.
+    */
+    SCXHandle<const CPUStatSnapshot> CPUEnumeration::GetStatSnapshot() const
+    {
+        return m_statSnapshot.Get();
+    }
+#endif
+
+    /*----------------------------------------------------------------------------*/
+    /**
+     Sampler body that updates all values
 
      \param[in]     param  Must contain a parameter named "ParamValues" of type CPUEnumerationThreadParam*
 
-     The thread stores new values in all instances once every 10 seconds.
+     Run by the sample scheduler once every m_sampleSecs seconds (generally
+     CPU_SECONDS_PER_SAMPLE, unless using 'real time' provider instance).
 
     */
-    void CPUEnumeration::DataAquisitionThreadBody(SCXCoreLib::SCXThreadParamHandle& param)
+    void CPUEnumeration::DataAquisitionSampleBody(SCXCoreLib::SCXThreadParamHandle& param)
     {
         SCXLogHandle log = SCXLogHandleFactory::GetLogHandle(L"scx.core.common.pal.system.cpu.cpuenumeration");
-        SCX_LOGTRACE(log, L"CPUEnumeration::DataAquisitionThreadBody()");
+        SCX_LOGHYSTERICAL(log, L"CPUEnumeration::DataAquisitionSampleBody()");
 
         if (0 == param)
         {
-            SCXASSERT( ! "No parameters to DataAquisitionThreadBody");
+            SCXASSERT( ! "No parameters to DataAquisitionSampleBody");
             return;
         }
 
         CPUEnumerationThreadParam* params = static_cast<CPUEnumerationThreadParam*>(param.GetData());
         if (0 == params)
         {
-            SCXASSERT( ! "Invalid parameters to DataAquisitionThreadBody");
+            SCXASSERT( ! "Invalid parameters to DataAquisitionSampleBody");
             return;
         }
 
@@ -1213,31 +1390,7 @@ namespace SCXSystemLib
             return;
         }
 
-        bool bUpdate = true;
-        // Sleep for sample seconds (generally CPU_SECONDS_PER_SAMPLE,
-        // unless using 'real time' provider instance)
-        params->m_cond.SetSleep(cpuenum->m_sampleSecs * 1000);
-        {
-            SCXConditionHandle h(params->m_cond);
-
-            while ( ! params->GetTerminateFlag())
-            {
-                if (bUpdate)
-                {
-                    cpuenum->SampleData();
-                    bUpdate = false;
-                }
-
-                SCX_LOGHYSTERICAL(log, L"CPUEnumeration DataAquisition - Sleep ");
-                enum SCXCondition::eConditionResult r = h.Wait();
-                if (SCXCondition::eCondTimeout == r)
-                {
-                    bUpdate = true;
-                }
-            }
-        }
-
-        SCX_LOGHYSTERICAL(log, L"CPUEnumeration DataAquisition - Ending ");
+        cpuenum->SampleData();
     }
 
 #if defined(sun) || defined(hpux)
@@ -16,11 +16,13 @@
 #include <scxcorelib/scxdirectoryinfo.h>
 #include <scxcorelib/scxfile.h>
 #include <scxcorelib/stringaid.h>
+#include <scxcorelib/stringspan.h>
 #include <scxcorelib/scxregex.h>
 #include <scxsystemlib/diskdepend.h>
 #include <scxsystemlib/scxsysteminfo.h>
 #include <scxsystemlib/scxproductdependencies.h>
 #include <stdlib.h>
+#include <string.h>
 
 #if defined(aix)
 #include <sys/vmount.h>
@@ -42,6 +44,11 @@ namespace SCXSystemLib
         m_log(log),
         m_pLvmTab(0),
         m_pRaid(0),
+        m_MntTabAllValid(false),
+        m_MntTabIsAll(false),
+        m_MntTabGeneration(0),
+        m_MountWatcher(0),
+        m_ProcDiskStatsRowCount(0),
         m_fd(CLOSED_DESCRIPTOR),
         m_OpenFlags(O_RDONLY)
     {
@@ -57,6 +64,11 @@ namespace SCXSystemLib
         m_log(SCXCoreLib::SCXLogHandleFactory::GetLogHandle(L"scx.core.common.pal.system.disk.diskdepend")),
         m_pLvmTab(0),
         m_pRaid(0),
+        m_MntTabAllValid(false),
+        m_MntTabIsAll(false),
+        m_MntTabGeneration(0),
+        m_MountWatcher(0),
+        m_ProcDiskStatsRowCount(0),
         m_fd(CLOSED_DESCRIPTOR)
     {
         m_PathName[0] = '\0';
@@ -364,38 +376,176 @@ namespace SCXSystemLib
         return m_ProcDiskStatsPath;
     }
 
+    /*----------------------------------------------------------------------------*/
+    /**
+       Parse a counter of /proc/diskstats.
+
+       \param[in]  begin First character of the counter
+       \param[in]  end   Character after the counter
+       \param[out] value The counter
+       \returns    true if the whole range is an unsigned number that fits in an scxulong
+    */
+    static bool ParseProcDiskStatsCounter(const char* begin, const char* end, scxulong& value)
+    {
+        static const scxulong maxValue = ~static_cast<scxulong>(0);
+
+        value = 0;
+        if (begin == end)
+        {
+            return false;
+        }
+        for (const char* p = begin; p < end; ++p)
+        {
+            if (*p < '0' || *p > '9')
+            {
+                return false;
+            }
+            scxulong digit = static_cast<scxulong>(*p - '0');
+            if (value > (maxValue - digit) / 10)
+            {
+                return false;
+            }
+            value = value * 10 + digit;
+        }
+        return true;
+    }
+
     /*----------------------------------------------------------------------------*/
     /**
        \copydoc SCXSystemLib::DiskDepend::RefreshProcDiskStats
+
+       The file is read with a single pass over a narrow buffer that is kept
+       between refreshes, and the counters are stored as numbers. Rows are kept
+       in file order; the device name index is only rebuilt when the set of
+       devices (or their order) changes, so a steady state refresh does not
+       allocate.
     */
     void DiskDependDefault::RefreshProcDiskStats()
     {
-        m_ProcDiskStats.clear();
+        size_t used = 0;
+        try
+        {
+            used = SCXCoreLib::SCXFile::ReadAllBytes(LocateProcDiskStats(), m_ProcDiskStatsBuffer);
+        }
+        catch (SCXCoreLib::SCXException&)
+        {
+            m_ProcDiskStatsRowCount = 0;
+            m_ProcDiskStatsIndex.clear();
+            throw;
+        }
 
-        SCXCoreLib::SCXHandle<std::wfstream> fsDiskStats(SCXCoreLib::SCXFile::OpenWFstream(LocateProcDiskStats(), std::ios::in));
-        fsDiskStats.SetOwner();
-        std::wstring line;
-        int counter = 0;
-        while ( fsDiskStats->good() && fsDiskStats->is_open() )
+        ParseProcDiskStats(&m_ProcDiskStatsBuffer[0], used);
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+       Parse the contents of /proc/diskstats into m_ProcDiskStatsRows.
+
+       \param buffer Contents of the file
+       \param length Number of bytes in buffer
+
+       Rows with fewer than 3 columns are skipped. Numeric columns past
+       ProcDiskStatsRow::MAX_COLUMNS are counted but not stored. A row with a
+       counter that is not a whole unsigned number is logged and skipped, as
+       the counters of a malformed row cannot be trusted.
+    */
+    void DiskDependDefault::ParseProcDiskStats(const char* buffer, size_t length)
+    {
+        const char* pos = buffer;
+        const char* end = buffer + length;
+        size_t row = 0;
+        bool namesChanged = false;
+
+        while (pos < end)
         {
-            getline( *fsDiskStats, line );
-            counter = line.size() ? 0 : counter + 1;
+            const char* eol = static_cast<const char*>(memchr(pos, '\n', static_cast<size_t>(end - pos)));
+            if (NULL == eol)
+            {
+                eol = end;
+            }
 
-            if ( counter >= 10 )
+            if (row == m_ProcDiskStatsRows.size())
             {
-                SCX_LOGERROR(m_log, L"Error while refreshing diskstats with errno = " + SCXCoreLib::StrFrom(errno));
-                break;
+                m_ProcDiskStatsRows.resize(row + 1);
             }
+            ProcDiskStatsRow& r = m_ProcDiskStatsRows[row];
+            size_t column = 0;
+            const char* badToken = NULL;
+            const char* badTokenEnd = NULL;
+            while (pos < eol)
+            {
+                while (pos < eol && (' ' == *pos || '\t' == *pos))
+                {
+                    ++pos;
+                }
+                if (pos == eol)
+                {
+                    break;
+                }
+                const char* token = pos;
+                while (pos < eol && ' ' != *pos && '\t' != *pos)
+                {
+                    ++pos;
+                }
 
-            std::vector<std::wstring> parts;
-            SCXCoreLib::StrTokenize(line, parts, L" \n\t");
-            if (parts.size() < 3)
+                if (2 == column)
+                {
+                    size_t len = static_cast<size_t>(pos - token);
+                    if (r.name.size() != len || 0 != r.name.compare(0, len, token, len))
+                    {
+                        r.name.assign(token, len);
+                        namesChanged = true;
+                    }
+                    r.counters[column] = 0;
+                }
+                else if (NULL == badToken)
+                {
+                    scxulong value = 0;
+                    if (!ParseProcDiskStatsCounter(token, pos, value))
+                    {
+                        badToken = token;
+                        badTokenEnd = pos;
+                    }
+                    else if (column < ProcDiskStatsRow::MAX_COLUMNS)
+                    {
+                        r.counters[column] = value;
+                    }
+                }
+                ++column;
+            }
+            pos = eol + 1;
+
+            if (column < 3)
+            {
+                continue;
+            }
+            if (NULL != badToken)
             {
+                // Widened byte by byte; a malformed line need not be valid UTF-8
+                SCX_LOGWARNING(m_log, L"Could not parse line from diskstats for device \"" +
+                               std::wstring(r.name.begin(), r.name.end()) + L"\" - cannot parse scxulong in: '" +
+                               std::wstring(badToken, badTokenEnd) + L"'");
                 continue;
             }
-            m_ProcDiskStats[parts[2]] = parts;
+            r.columns = column;
+            ++row;
+        }
+
+        if (row != m_ProcDiskStatsRowCount)
+        {
+            namesChanged = true;
+        }
+        m_ProcDiskStatsRowCount = row;
+
+        if (namesChanged)
+        {
+            m_ProcDiskStatsIndex.clear();
+            for (size_t i = 0; i < m_ProcDiskStatsRowCount; ++i)
+            {
+                // Like the map that was used before, a later row replaces an earlier one with the same name
+                m_ProcDiskStatsIndex[m_ProcDiskStatsRows[i].name] = i;
+            }
         }
-        fsDiskStats->close();
     }
 
     /*----------------------------------------------------------------------------*/
@@ -409,37 +559,70 @@ namespace SCXSystemLib
 
     /*----------------------------------------------------------------------------*/
     /**
-       \copydoc SCXSystemLib::DiskDepend::GetProcDiskStats
+       \copydoc SCXSystemLib::DiskDepend::GetProcDiskStatsRow
     */
-    const std::vector<std::wstring>& DiskDependDefault::GetProcDiskStats(const std::wstring& device)
+    const ProcDiskStatsRow* DiskDependDefault::GetProcDiskStatsRow(const std::wstring& device)
     {
         static SCXCoreLib::LogSuppressor suppressor(SCXCoreLib::eWarning, SCXCoreLib::eTrace);
         const std::wstring slashdevslash(L"/dev/");
-        std::wstring tailstr;
 
         // We assume device path is all of the device name after '/dev/'
         if(device.find(slashdevslash) == 0)
-            tailstr = device.substr(slashdevslash.length());
+        {
+            m_ProcDiskStatsKey = SCXCoreLib::StrToUTF8(device.substr(slashdevslash.length()));
+        }
         else
         {
             // This is the former way of doing the lookup ... do not find leading '/dev/'
             SCXCoreLib::SCXFilePath dev(device);
-            tailstr = dev.GetFilename();
+            m_ProcDiskStatsKey = SCXCoreLib::StrToUTF8(dev.GetFilename());
         }
 
-        std::map<std::wstring, std::vector<std::wstring> >::const_iterator it =
-        m_ProcDiskStats.find(tailstr);
+        std::map<std::string, size_t>::const_iterator it = m_ProcDiskStatsIndex.find(m_ProcDiskStatsKey);
 
-        if (it == m_ProcDiskStats.end())
+        if (it == m_ProcDiskStatsIndex.end())
         {
             SCXCoreLib::SCXLogSeverity severity(suppressor.GetSeverity(device));
             std::wstringstream out ;
-            out << L"Did not find key '" << tailstr << L"' in proc_disk_stats map, device name was '" << device << L"'.";
+            out << L"Did not find key '" << SCXCoreLib::StrFromUTF8(m_ProcDiskStatsKey) << L"' in proc_disk_stats map, device name was '" << device << L"'.";
             SCX_LOG(m_log, severity, out.str());
-            static std::vector<std::wstring> empty;
-            return empty;
+            return 0;
         }
-        return it->second;
+        return &m_ProcDiskStatsRows[it->second];
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+       \copydoc SCXSystemLib::DiskDepend::GetProcDiskStats
+
+       Kept for compatibility; formats the row returned by GetProcDiskStatsRow().
+       The returned vector is only valid until the next call.
+    */
+    const std::vector<std::wstring>& DiskDependDefault::GetProcDiskStats(const std::wstring& device)
+    {
+        m_ProcDiskStatsParts.clear();
+        const ProcDiskStatsRow* row = GetProcDiskStatsRow(device);
+        if (0 == row)
+        {
+            return m_ProcDiskStatsParts;
+        }
+
+        for (size_t i = 0; i < row->columns; ++i)
+        {
+            if (2 == i)
+            {
+                m_ProcDiskStatsParts.push_back(SCXCoreLib::StrFromUTF8(row->name));
+            }
+            else if (i < ProcDiskStatsRow::MAX_COLUMNS)
+            {
+                m_ProcDiskStatsParts.push_back(SCXCoreLib::StrFrom(row->counters[i]));
+            }
+            else
+            {
+                m_ProcDiskStatsParts.push_back(L"0");
+            }
+        }
+        return m_ProcDiskStatsParts;
     }
 
     /*----------------------------------------------------------------------------*/
@@ -495,19 +678,21 @@ namespace SCXSystemLib
     /**
        \copydoc SCXSystemLib::DiskDepend::RefreshMNTTab
 
+       On Linux the system mount table is only read again when the kernel reports
+       that something has been mounted or unmounted; otherwise the entries parsed
+       before are used.
+
        \note Not thread safe.
     */
     void DiskDependDefault::RefreshMNTTab(RefreshMNTTabParam *param)
     {
-        static SCXCoreLib::LogSuppressor suppressor(SCXCoreLib::eWarning, SCXCoreLib::eTrace);
-        bool isTestEnv = FileExists(L"/etc/opt/omi/conf/SCX_TESTRUN_ACTIVE");
+#if defined(aix)
         SCX_LOGTRACE(m_log, L"RefreshMNTTab: mnttab file being read");
         if (0 < m_MntTab.size())
         {
             SCX_LOGTRACE(m_log, L"RefreshMNTTab: Clearing m_MntTab");
             m_MntTab.clear();
         }
-#if defined(aix)
         int needed = 0;
         // Get the number of bytes needed for all mntctl data.
         int r = mntctl(MCTL_QUERY, sizeof(needed), reinterpret_cast<char*>(&needed));
@@ -565,14 +750,75 @@ namespace SCXSystemLib
             SCX_LOGERROR(m_log, L"mntctl(MCTL_QUERY) failed with errno = " + SCXCoreLib::StrFrom(errno));
         }
 #else
+        if (MNTTabChanged())
+        {
+            SCX_LOGTRACE(m_log, L"RefreshMNTTab: mnttab file being read");
+            m_MntTabAllValid = false;
+            m_MntTabIsAll = false;
+            m_MntTabAll.clear();
+            ParseMNTTab(m_MntTabAll);
+            m_MntTabAllValid = true;
+            ++m_MntTabGeneration;
+        }
+
+        FilterMNTTab(param);
+        SCX_LOGTRACE(m_log, L"RefreshMNTTab: Done writing m_MntTab");
+#endif
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+       \copydoc SCXSystemLib::DiskDepend::GetMNTTabGeneration
+    */
+    scxulong DiskDependDefault::GetMNTTabGeneration()
+    {
+        return m_MntTabGeneration;
+    }
+
+#if !defined(aix)
+    /*----------------------------------------------------------------------------*/
+    /**
+       Check if the mount tab must be parsed again.
+
+       \returns true unless the mount tab parsed last is known to be current.
+
+       Only the system mount tab is watched; a mount tab at any other location
+       (like one given by a unit test) is parsed on every refresh.
+    */
+    bool DiskDependDefault::MNTTabChanged()
+    {
+        bool changed = true;
+#if defined(linux)
+        if (LocateMountTab().Get() == L"/etc/mtab")
+        {
+            if (0 == m_MountWatcher)
+            {
+                m_MountWatcher = new SCXMountWatcher();
+            }
+            // Always ask, so that the change is consumed
+            changed = m_MountWatcher->HasChanged();
+        }
+#endif
+        return changed || ! m_MntTabAllValid;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+       Parse the mount tab.
+
+       \param[out] entries  Receives one entry per file system of interest.
+    */
+    void DiskDependDefault::ParseMNTTab(std::vector<MntTabEntry>& entries)
+    {
+        static SCXCoreLib::LogSuppressor suppressor(SCXCoreLib::eWarning, SCXCoreLib::eTrace);
+        bool isTestEnv = FileExists(L"/etc/opt/omi/conf/SCX_TESTRUN_ACTIVE");
         SCXCoreLib::SCXHandle<std::wfstream> fs(SCXCoreLib::SCXFile::OpenWFstream(
                                                     LocateMountTab(), std::ios::in));
         fs.SetOwner();
         int counter = 0;
+        std::wstring line;
         while ( fs->good() && fs->is_open() )
         {
-            std::wstring line;
-            std::vector<std::wstring> parts;
             getline( *fs, line );
             counter = line.size() ? 0 : counter + 1;
             if ( counter >= 10 )
@@ -587,10 +833,12 @@ namespace SCXSystemLib
                 if (!isTestEnv) continue;
             }
 #endif
-            SCXCoreLib::StrTokenize(line, parts, L" \n\t");
-            if (parts.size() > 3)
+            // Only the first four fields are needed; they point into line
+            SCXCoreLib::WStrSpanTokenizer tokenizer(line, L" \n\t");
+            SCXCoreLib::WStrSpan parts[4];
+            if (tokenizer.Next(parts, 4) == 4)
             {
-                if (std::wstring::npos != parts[0].find('#')) // Comment
+                if (parts[0].Contains(L'#')) // Comment
                 {
                     continue;
                 }
@@ -602,10 +850,13 @@ namespace SCXSystemLib
                 // and need to have subsequent release to fix the issue.
                 // The fix here is based on fundamental property of pseudo FS that it is not associated with any block device, hence not associated with any path.
 
-                if (parts[0].find(L"/") == std::wstring::npos)
+                if ( ! parts[0].Contains(L'/'))
                 {
                     continue;
                 }
+#endif
+                std::wstring device(parts[0].ToString());
+#if defined(linux)
                 // WI 574703:
                 //
                 // On Debian 7 systems, the system disk may come in with a device like:
@@ -614,14 +865,14 @@ namespace SCXSystemLib
                 // device).  Since the path in /dev/disk/by-uuid is actually a soft link
                 // to the physical device, just resolve it if that's what we've got.
 
-                if (parts[0].find(L"/dev/disk/by-uuid/") == 0)
+                if (device.find(L"/dev/disk/by-uuid/") == 0)
                 {
                     char buf[1024];
                     memset(buf, 0, sizeof(buf));
-                    if (-1 == readlink(SCXCoreLib::StrToUTF8(parts[0]).c_str(), buf, sizeof(buf)))
+                    if (-1 == readlink(SCXCoreLib::StrToUTF8(device).c_str(), buf, sizeof(buf)))
                     {
                         std::wstringstream message;
-                        message << L"readlink(file='" << parts[0] << "',...)";
+                        message << L"readlink(file='" << device << "',...)";
 
                         SCXCoreLib::SCXErrnoException e(message.str(), errno, SCXSRCLOCATION);
                         SCXCoreLib::SCXLogSeverity severity(suppressor.GetSeverity(message.str()));
@@ -636,13 +887,13 @@ namespace SCXSystemLib
                         size_t pos;
                         if ( (pos = link.rfind(L"/")) != std::wstring::npos )
                         {
-                            parts[0] = L"/dev/" + link.substr(pos+1);
+                            device = L"/dev/" + link.substr(pos+1);
                         }
                         else
                         {
                             std::wstringstream message;
                             message << L"RefreshMNTTab: Unable to find physical define in link: " << link
-                                    << " (Original file: " << parts[0] << ")";
+                                    << " (Original file: " << device << ")";
 
                             SCXCoreLib::SCXLogSeverity severity(suppressor.GetSeverity(message.str()));
                             SCX_LOG(m_log, severity, message.str());
@@ -650,30 +901,14 @@ namespace SCXSystemLib
                     }
                 }
 #endif
-               if ( param != NULL && param->getValue() != L"" )
-               {
-                   bool isContinue=false;
-                   switch ( param->getType() ) {
-                       case MOUNTPOINT:
-                            if ( parts[1] != param->getValue() ) isContinue=true;
-                            break;
-                       case DEVICE:
-                            if ( parts[0].find(param->getValue()) == std::wstring::npos ) isContinue=true;
-                            break;
-                       case NOPARAM:
-                            break;
-                   }
-
-                   if(isContinue) continue;
-                }
-
                 MntTabEntry entry;
-                entry.device = parts[0];
-                entry.mountPoint = parts[1];
-                entry.fileSystem = parts[2];
-                if (parts[3].find(L"dev=") != std::wstring::npos)
+                entry.device = device;
+                entry.mountPoint = parts[1].ToString();
+                entry.fileSystem = parts[2].ToString();
+                std::wstring options(parts[3].ToString());
+                if (options.find(L"dev=") != std::wstring::npos)
                 {
-                    entry.devAttribute = parts[3].substr(parts[3].find(L"dev="));
+                    entry.devAttribute = options.substr(options.find(L"dev="));
                     if (entry.devAttribute.length() > 0)
                     {
                         entry.devAttribute = entry.devAttribute.substr(4); // Removing "dev="
@@ -686,16 +921,57 @@ namespace SCXSystemLib
                              + L"', mountpoint '" + entry.mountPoint
                              + L"', filesysstem '" + entry.fileSystem + L"'" );
 
-                m_MntTab.push_back(entry);
+                entries.push_back(entry);
+            }
+        }
+        fs->close();
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+       Fill m_MntTab with the entries of m_MntTabAll that match a refresh request.
 
-                if ( param != NULL ) break;
+       \param[in] param  Request; NULL or an empty value for all entries. Only
+                         the first matching entry is kept if param is not NULL.
+    */
+    void DiskDependDefault::FilterMNTTab(RefreshMNTTabParam *param)
+    {
+        if (NULL == param)
+        {
+            if ( ! m_MntTabIsAll)
+            {
+                m_MntTab = m_MntTabAll;
+                m_MntTabIsAll = true;
+            }
+            return;
+        }
 
+        m_MntTab.clear();
+        m_MntTabIsAll = false;
+        for (std::vector<MntTabEntry>::const_iterator it = m_MntTabAll.begin(); it != m_MntTabAll.end(); ++it)
+        {
+            if ( param->getValue() != L"" )
+            {
+                bool isContinue=false;
+                switch ( param->getType() ) {
+                    case RefreshMNTTabParam::MOUNTPOINT:
+                        if ( it->mountPoint != param->getValue() ) isContinue=true;
+                        break;
+                    case RefreshMNTTabParam::DEVICE:
+                        if ( it->device.find(param->getValue()) == std::wstring::npos ) isContinue=true;
+                        break;
+                    case RefreshMNTTabParam::NOPARAM:
+                        break;
+                }
+
+                if(isContinue) continue;
             }
+
+            m_MntTab.push_back(*it);
+            break;
         }
-        fs->close();
-        SCX_LOGTRACE(m_log, L"RefreshMNTTab: Done writing m_MntTab");
-#endif
     }
+#endif
 
     /**
        Helper function for FileSystemIgnored.  Inserts each string from arr into newSet.
@@ -1843,10 +2119,9 @@ namespace SCXSystemLib
                                                     LocateMountTab(), std::ios::in));
         fs.SetOwner();
         int counter = 0;
+        std::wstring line;
         while ( fs->good() && fs->is_open() )
         {
-            std::wstring line;
-            std::vector<std::wstring> parts;
             getline( *fs, line );
             counter = line.size() ? 0 : counter + 1;
             if ( counter >= 10 )
@@ -1855,14 +2130,15 @@ namespace SCXSystemLib
                 break;
             }
 
-            SCXCoreLib::StrTokenize(line, parts, L" \n\t");
-            if (parts.size() > 3)
+            SCXCoreLib::WStrSpanTokenizer tokenizer(line, L" \n\t");
+            SCXCoreLib::WStrSpan parts[4];
+            if (tokenizer.Next(parts, 4) == 4)
             {
-                if (std::wstring::npos != parts[0].find('#')) // Comment
+                if (parts[0].Contains(L'#')) // Comment
                 {
                     continue;
                 }
-                mntOptions.push_back(parts[3]);
+                mntOptions.push_back(parts[3].ToString());
             }
         }
         fs->close();
@@ -0,0 +1,106 @@
+/*--------------------------------------------------------------------------------
+  Copyright (c) Microsoft Corporation. All rights reserved. See license.txt for license information.
+
+*/
+/**
+   \file
+
+   \brief       Detects changes to the mount table
+
+   \date        2026-10-16 18:00:00
+
+*/
+/*----------------------------------------------------------------------------*/
+
+#include <scxcorelib/scxcmn.h>
+#include <scxsystemlib/scxmountwatcher.h>
+
+#include <errno.h>
+#if defined(linux)
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace SCXSystemLib
+{
+    /*----------------------------------------------------------------------------*/
+    /**
+       Constructor
+
+       \param[in] path  File to watch; only used on Linux.
+
+       If the file cannot be opened, the watcher reports a change on every call.
+    */
+    SCXMountWatcher::SCXMountWatcher(const std::string& path)
+        : m_fd(-1),
+          m_isFirst(true)
+    {
+#if defined(linux)
+        m_fd = ::open(path.c_str(), O_RDONLY);
+#else
+        (void) path;
+#endif
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+       Destructor
+    */
+    SCXMountWatcher::~SCXMountWatcher()
+    {
+#if defined(linux)
+        if (m_fd >= 0)
+        {
+            ::close(m_fd);
+        }
+#endif
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+       Check for changes to the mount table.
+
+       \returns  true if the mount table may have changed since the previous
+                 call; always true for the first call and when not watching.
+    */
+    bool SCXMountWatcher::HasChanged()
+    {
+        if (m_isFirst || m_fd < 0)
+        {
+            m_isFirst = false;
+            return true;
+        }
+
+#if defined(linux)
+        struct pollfd pfd;
+        pfd.fd = m_fd;
+        pfd.events = POLLPRI;
+        pfd.revents = 0;
+
+        int r;
+        do
+        {
+            r = ::poll(&pfd, 1, 0);
+        } while (r < 0 && EINTR == errno);
+
+        // If the poll fails, do not risk missing a change
+        return r < 0 || 0 != (pfd.revents & (POLLPRI | POLLERR));
+#else
+        return true;
+#endif
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+       Check if changes are actually detected.
+
+       \returns  false if every call to HasChanged() reports a change.
+    */
+    bool SCXMountWatcher::IsWatching() const
+    {
+        return m_fd >= 0;
+    }
+}
+
+/*----------------------------E-N-D---O-F---F-I-L-E---------------------------*/
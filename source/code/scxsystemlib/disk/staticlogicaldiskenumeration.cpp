@@ -23,11 +23,15 @@ namespace SCXSystemLib
 
     \param       deps A StaticDiscDepend object which can be used.
 
+    The instances are updated in parallel, so a hung file system only delays
+    its own instance.
 */
-    StaticLogicalDiskEnumeration::StaticLogicalDiskEnumeration(SCXCoreLib::SCXHandle<DiskDepend> deps) : m_deps(0)
+    StaticLogicalDiskEnumeration::StaticLogicalDiskEnumeration(SCXCoreLib::SCXHandle<DiskDepend> deps) : m_deps(0),
+        m_mntTabGeneration(0), m_mntTabSize(0)
     {
         m_log = SCXCoreLib::SCXLogHandleFactory::GetLogHandle(L"scx.core.common.pal.system.disk.staticlogicaldiskenumeration");
         m_deps = deps;
+        SetParallelUpdate(EntityUpdater::GetSharedPool(), EntityUpdater::c_DefaultDeadlineMs);
     }
 
     /*----------------------------------------------------------------------------*/
@@ -60,6 +64,7 @@ namespace SCXSystemLib
     */
     void StaticLogicalDiskEnumeration::CleanUp()
     {
+        m_mntTabGeneration = 0;
         EntityEnumeration<StaticLogicalDiskInstance>::CleanUp();
     }
 
@@ -74,33 +79,42 @@ namespace SCXSystemLib
     void StaticLogicalDiskEnumeration::Update(bool updateInstances/*=true*/)
     {
         SCX_LOGTRACE(m_log, SCXCoreLib::StrAppend(L"Size of enumeration: ", this->Size()));
-        for (EntityIterator iter=Begin(); iter!=End(); ++iter)
-        {
-            SCXCoreLib::SCXHandle<StaticLogicalDiskInstance> disk = *iter;
-            SCX_LOGTRACE(m_log, SCXCoreLib::StrAppend(L"Device being set to OFFLINE, disk: ", disk->m_mountPoint));
-            disk->m_online = false;
-        }
-
         m_deps->RefreshMNTTab();
-        for (std::vector<MntTabEntry>::const_iterator it = m_deps->GetMNTTab().begin();
-             it != m_deps->GetMNTTab().end(); ++it)
+
+        // Unless something was mounted or unmounted since the last update, the instances are as they were
+        scxulong generation = m_deps->GetMNTTabGeneration();
+        if (0 == generation || generation != m_mntTabGeneration || Size() != m_mntTabSize)
         {
-            if ( ! m_deps->FileSystemIgnored(it->fileSystem) && ! m_deps->DeviceIgnored(it->device))
+            for (EntityIterator iter=Begin(); iter!=End(); ++iter)
             {
-                SCXCoreLib::SCXHandle<StaticLogicalDiskInstance> disk = GetInstance(it->mountPoint);
-                if (0 == disk)
+                SCXCoreLib::SCXHandle<StaticLogicalDiskInstance> disk = *iter;
+                SCX_LOGTRACE(m_log, SCXCoreLib::StrAppend(L"Device being set to OFFLINE, disk: ", disk->m_mountPoint));
+                disk->m_online = false;
+            }
+
+            for (std::vector<MntTabEntry>::const_iterator it = m_deps->GetMNTTab().begin();
+                 it != m_deps->GetMNTTab().end(); ++it)
+            {
+                if ( ! m_deps->FileSystemIgnored(it->fileSystem) && ! m_deps->DeviceIgnored(it->device))
                 {
-                    disk = new StaticLogicalDiskInstance(m_deps);
-                    disk->m_device = it->device;
-                    disk->m_mountPoint = it->mountPoint;
-                    disk->SetId(disk->m_mountPoint);
-                    disk->m_fileSystemType = it->fileSystem;
-                    disk->m_diskRemovability = GetDiskRemovability(it->device);
-                    AddInstance(disk);
+                    SCXCoreLib::SCXHandle<StaticLogicalDiskInstance> disk = GetInstance(it->mountPoint);
+                    if (0 == disk)
+                    {
+                        disk = new StaticLogicalDiskInstance(m_deps);
+                        disk->m_device = it->device;
+                        disk->m_mountPoint = it->mountPoint;
+                        disk->SetId(disk->m_mountPoint);
+                        disk->m_fileSystemType = it->fileSystem;
+                        disk->m_diskRemovability = GetDiskRemovability(it->device);
+                        AddInstance(disk);
+                    }
+                    SCX_LOGTRACE(m_log, SCXCoreLib::StrAppend(L"Device being set to ONLINE, disk: ", disk->m_mountPoint));
+                    disk->m_online = true;
                 }
-                SCX_LOGTRACE(m_log, SCXCoreLib::StrAppend(L"Device being set to ONLINE, disk: ", disk->m_mountPoint));
-                disk->m_online = true;
             }
+
+            m_mntTabGeneration = generation;
+            m_mntTabSize = Size();
         }
 
         if (updateInstances)
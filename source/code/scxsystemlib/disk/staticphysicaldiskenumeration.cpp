@@ -25,12 +25,18 @@ namespace SCXSystemLib
        Constructor.
     
        \param       deps A StaticDiscDepend object which can be used.
-        
+
+       The instances are updated in parallel if the dependencies can give each
+       of them device access of its own (see DiskDepend::CreateDeviceDepend()).
     */
     StaticPhysicalDiskEnumeration::StaticPhysicalDiskEnumeration(SCXCoreLib::SCXHandle<DiskDepend> deps) : m_deps(0)
     {
         m_log = SCXCoreLib::SCXLogHandleFactory::GetLogHandle(L"scx.core.common.pal.system.disk.staticphysicaldiskenumeration");
         m_deps = deps;
+        if (m_deps->CreateDeviceDepend() != 0)
+        {
+            SetParallelUpdate(EntityUpdater::GetSharedPool(), EntityUpdater::c_DefaultDeadlineMs);
+        }
     }
 
     /*----------------------------------------------------------------------------*/
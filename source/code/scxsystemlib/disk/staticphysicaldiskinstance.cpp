@@ -64,8 +64,8 @@ using namespace std;
 
 namespace SCXSystemLib
 {
-    size_t StaticPhysicalDiskInstance::m_currentInstancesCount = 0;
-    size_t StaticPhysicalDiskInstance::m_instancesCountSinceModuleStart = 0;
+    scx_atomic_t StaticPhysicalDiskInstance::m_currentInstancesCount = 0;
+    scx_atomic_t StaticPhysicalDiskInstance::m_instancesCountSinceModuleStart = 0;
 
 /*----------------------------------------------------------------------------*/
 /**
@@ -80,8 +80,8 @@ namespace SCXSystemLib
         , m_cdDrive(false)
 #endif
     {
-        m_currentInstancesCount++;
-        m_instancesCountSinceModuleStart++;
+        scx_atomic_increment(&m_currentInstancesCount);
+        scx_atomic_increment(&m_instancesCountSinceModuleStart);
         m_log = SCXCoreLib::SCXLogHandleFactory::GetLogHandle(
                 L"scx.core.common.pal.system.disk.staticphysicaldiskinstance");
 
@@ -95,13 +95,78 @@ namespace SCXSystemLib
         Clear();
     }
 
+/*----------------------------------------------------------------------------*/
+/**
+   Copy constructor.
+
+   \param       source Instance to copy.
+
+   The copy gets a DiskDepend of its own (see DiskDepend::CreateDeviceDepend()),
+   so it can be updated concurrently with the source and with other copies.
+*/
+    StaticPhysicalDiskInstance::StaticPhysicalDiskInstance(const StaticPhysicalDiskInstance& source)
+        : EntityInstance(source), m_deps(source.m_deps->CreateDeviceDepend())
+    {
+        scx_atomic_increment(&m_currentInstancesCount);
+        scx_atomic_increment(&m_instancesCountSinceModuleStart);
+        Assign(source);
+    }
+
 /*----------------------------------------------------------------------------*/
 /**
    Virtual destructor.
 */
     StaticPhysicalDiskInstance::~StaticPhysicalDiskInstance()
     {
-        m_currentInstancesCount--;
+        scx_atomic_decrement_test(&m_currentInstancesCount);
+    }
+
+/*----------------------------------------------------------------------------*/
+/**
+   Assignment operator. Copies the disk properties, but keeps the DiskDepend of
+   this instance.
+
+   \param       source Instance to copy.
+   \returns     This instance.
+*/
+    StaticPhysicalDiskInstance& StaticPhysicalDiskInstance::operator=(const StaticPhysicalDiskInstance& source)
+    {
+        if (this != &source)
+        {
+            EntityInstance::operator=(source);
+            Assign(source);
+        }
+        return *this;
+    }
+
+/*----------------------------------------------------------------------------*/
+/**
+   Copies all members except the DiskDepend from another instance.
+
+   \param       source Instance to copy.
+*/
+    void StaticPhysicalDiskInstance::Assign(const StaticPhysicalDiskInstance& source)
+    {
+        m_log = source.m_log;
+        m_online = source.m_online;
+        m_device = source.m_device;
+        m_rawDevice = source.m_rawDevice;
+#if defined(linux)
+        m_cdDrive = source.m_cdDrive;
+#endif
+        m_isMBR = source.m_isMBR;
+        m_intType = source.m_intType;
+        m_manufacturer = source.m_manufacturer;
+        m_model = source.m_model;
+        m_sizeInBytes = source.m_sizeInBytes;
+        m_totalCylinders = source.m_totalCylinders;
+        m_totalHeads = source.m_totalHeads;
+        m_totalSectors = source.m_totalSectors;
+        m_totalTracks = source.m_totalTracks;
+        m_trackSize = source.m_trackSize;
+        m_tracksPerCylinder = source.m_tracksPerCylinder;
+        m_sectorSize = source.m_sectorSize;
+        m_Properties = source.m_Properties;
     }
 
 /*----------------------------------------------------------------------------*/
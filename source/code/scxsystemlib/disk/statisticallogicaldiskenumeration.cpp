@@ -40,7 +40,7 @@ namespace SCXSystemLib
         \param       deps - dependencies
 
     */
-    StatisticalLogicalDiskEnumeration::StatisticalLogicalDiskEnumeration(SCXCoreLib::SCXHandle<DiskDepend> deps) : m_deps(0), m_sampler(0)
+    StatisticalLogicalDiskEnumeration::StatisticalLogicalDiskEnumeration(SCXCoreLib::SCXHandle<DiskDepend> deps) : m_deps(0), m_samplerId(0)
     {
         m_log = SCXCoreLib::SCXLogHandleFactory::GetLogHandle(L"scx.core.common.pal.system.disk.statisticallogicaldiskenumeration");
         m_lock = SCXCoreLib::ThreadLockHandleGet();
@@ -65,18 +65,14 @@ namespace SCXSystemLib
     /**
        Destructor
 
-       Kills the sampler thread hard if not shut down gracefully (by using CleanUp).
+       Stops the sampling if not shut down gracefully (by using CleanUp).
 
     */
     StatisticalLogicalDiskEnumeration::~StatisticalLogicalDiskEnumeration()
     {
-        if (0 != m_sampler)
+        if (0 != m_samplerId)
         {
-            if (m_sampler->IsAlive())
-            {
-                CleanUp();
-            }
-            m_sampler = 0;
+            CleanUp();
         }
     }
 
@@ -136,16 +132,20 @@ namespace SCXSystemLib
 
     /*----------------------------------------------------------------------------*/
     /**
-       Initializes the disk collection and starts the sampler thread.
+       Initializes the disk collection and starts the sampling.
 
     */
     void StatisticalLogicalDiskEnumeration::Init()
     {
         InitInstances();
 
-        StatisticalLogicalDiskSamplerParam* p = new StatisticalLogicalDiskSamplerParam();
-        p->m_diskEnum = this;
-        m_sampler = new SCXCoreLib::SCXThread(DiskSampler, p);
+        if (0 == m_samplerId)
+        {
+            StatisticalLogicalDiskSamplerParam* p = new StatisticalLogicalDiskSamplerParam();
+            p->m_diskEnum = this;
+            m_samplerId = SCXCoreLib::SCXSampleScheduler::Instance().Register(
+                DiskSampler, SCXCoreLib::SCXThreadParamHandle(p), DISK_SECONDS_PER_SAMPLE * 1000);
+        }
     }
 
     /*----------------------------------------------------------------------------*/
@@ -153,7 +153,7 @@ namespace SCXSystemLib
        Initializes the disk instances.
 
        \note This method is a helper to the Init method and can be used directly
-       if the sampler thread is not needed.
+       if the sampling is not needed.
 
     */
     void StatisticalLogicalDiskEnumeration::InitInstances()
@@ -168,16 +168,16 @@ namespace SCXSystemLib
     /**
        Release the resources allocated.
 
-       Must be called before deallocating this object. Will wait when stopping
-       the sampler thread.
+       Must be called before deallocating this object. Will wait for a sample
+       in progress to finish.
 
     */
     void StatisticalLogicalDiskEnumeration::CleanUp()
     {
-        if (0 != m_sampler)
+        if (0 != m_samplerId)
         {
-            m_sampler->RequestTerminate();
-            m_sampler->Wait();
+            SCXCoreLib::SCXSampleScheduler::Instance().Unregister(m_samplerId);
+            m_samplerId = 0;
         }
     }
 
@@ -357,10 +357,12 @@ namespace SCXSystemLib
     */
     void StatisticalLogicalDiskEnumeration::SampleDisks()
     {
-        SCXCoreLib::SCXThreadLock lock(m_lock);
 #if defined(linux)
+        // Only the sampler reads the diskstats file; do it before locking so
+        // a slow read does not hold up Update()
         m_deps->RefreshProcDiskStats();
 #endif
+        SCXCoreLib::SCXThreadLock lock(m_lock);
         for (EntityIterator iter = Begin(); iter != End(); ++iter)
         {
             SCXCoreLib::SCXHandle<StatisticalLogicalDiskInstance> disk = *iter;
@@ -380,7 +382,7 @@ namespace SCXSystemLib
 
     /*----------------------------------------------------------------------------*/
     /**
-       The disk sampler thread body.
+       The disk sampler body, run by the sample scheduler.
 
        \param       param - thread parameters.
 
@@ -391,32 +393,14 @@ namespace SCXSystemLib
         SCXASSERT(0 != p);
         SCXASSERT(0 != p->m_diskEnum);
 
-        bool bUpdate = true;
-        p->m_cond.SetSleep(DISK_SECONDS_PER_SAMPLE * 1000);
+        try
         {
-            SCXCoreLib::SCXConditionHandle h(p->m_cond);
-            while( ! p->GetTerminateFlag())
-            {
-                if (bUpdate)
-                {
-                    try
-                    {
-                        p->m_diskEnum->SampleDisks();
-                    }
-                    catch (const SCXCoreLib::SCXException& e)
-                    {
-                        SCX_LOGERROR(p->m_diskEnum->m_log,
-                                     std::wstring(L"StatisticalLogicalDiskEnumeration::DiskSampler() - Unexpected exception caught: ").append(e.What()).append(L" - ").append(e.Where()));
-                    }
-                    bUpdate = false;
-                }
-
-                enum SCXCoreLib::SCXCondition::eConditionResult r = h.Wait();
-                if (SCXCoreLib::SCXCondition::eCondTimeout == r)
-                {
-                    bUpdate = true;
-                }
-            }
+            p->m_diskEnum->SampleDisks();
+        }
+        catch (const SCXCoreLib::SCXException& e)
+        {
+            SCX_LOGERROR(p->m_diskEnum->m_log,
+                         std::wstring(L"StatisticalLogicalDiskEnumeration::DiskSampler() - Unexpected exception caught: ").append(e.What()).append(L" - ").append(e.Where()));
         }
     }
 
@@ -196,7 +196,6 @@ namespace SCXSystemLib
         m_tBytes.AddSample(m_rBytes[0] + m_wBytes[0]);
 #elif defined(linux)
         std::wstring device = m_device;
-        std::vector<std::wstring> parts;
         std::wstringstream out;
 
         if (!m_samplerDevices.empty())
@@ -212,49 +211,30 @@ namespace SCXSystemLib
             device = m_samplerDevices[0];
         }
 
-        parts = m_deps->GetProcDiskStats(device);
+        const ProcDiskStatsRow* row = m_deps->GetProcDiskStatsRow(device);
+        size_t columns = (0 == row) ? 0 : row->columns;
 
         m_timeStamp.AddSample(time(0));
 
-        if (parts.size() >= eNumberOfDiskColumns) // > condition for handling additional fields in kernel 4.18+ and 5.5+
+        if (columns >= eNumberOfDiskColumns) // > condition for handling additional fields in kernel 4.18+ and 5.5+
         {
             // this looks like a diskstats entry for a disk-type device
-            try
-            {
-                m_reads.AddSample(SCXCoreLib::StrToULong(parts[eNumberOfReadsCompleted]));
-                m_writes.AddSample(SCXCoreLib::StrToULong(parts[eNumberOfWritesCompleted]));
-                m_rBytes.AddSample(SCXCoreLib::StrToULong(parts[eNumberOfSectorsRead])*m_sectorSize);
-                m_wBytes.AddSample(SCXCoreLib::StrToULong(parts[eNumberOfSectorsWritten])*m_sectorSize);
-                m_transfers.AddSample(m_reads[0] + m_writes[0]);
-                m_tBytes.AddSample(m_rBytes[0] + m_wBytes[0]);
-            }
-            catch (const SCXCoreLib::SCXNotSupportedException& e)
-        {
-                out.str(L"");
-
-                out << L"Could not parse disk device line from diskstats for device \"" << device << L"\" - " << e.What();
-                SCX_LOGWARNING(m_log, out.str());
-            }
+            m_reads.AddSample(row->counters[eNumberOfReadsCompleted]);
+            m_writes.AddSample(row->counters[eNumberOfWritesCompleted]);
+            m_rBytes.AddSample(row->counters[eNumberOfSectorsRead]*m_sectorSize);
+            m_wBytes.AddSample(row->counters[eNumberOfSectorsWritten]*m_sectorSize);
+            m_transfers.AddSample(m_reads[0] + m_writes[0]);
+            m_tBytes.AddSample(m_rBytes[0] + m_wBytes[0]);
         }
-        else if (parts.size() == eNumberOfPartitionColumns)
+        else if (columns == eNumberOfPartitionColumns)
         {
             // this looks like a diskstats entry for a partition-type device
-            try
-            {
-                m_reads.AddSample(SCXCoreLib::StrToULong(parts[eNumberOfReadsIssued]));
-                m_writes.AddSample(SCXCoreLib::StrToULong(parts[eNumberOfWritesIssued]));
-                m_rBytes.AddSample(SCXCoreLib::StrToULong(parts[eNumberOfReadSectorRequests])*m_sectorSize);
-                m_wBytes.AddSample(SCXCoreLib::StrToULong(parts[eNumberOfWriteSectorRequests])*m_sectorSize);
-                m_transfers.AddSample(m_reads[0] + m_writes[0]);
-                m_tBytes.AddSample(m_rBytes[0] + m_wBytes[0]);
-            }
-            catch (const SCXCoreLib::SCXNotSupportedException& e)
-            {
-                out.str(L"");
-
-                out << L"Could not parse partition device line from diskstats for device \"" << device << L"\" - " << e.What();
-                SCX_LOGWARNING(m_log, out.str());
-            }
+            m_reads.AddSample(row->counters[eNumberOfReadsIssued]);
+            m_writes.AddSample(row->counters[eNumberOfWritesIssued]);
+            m_rBytes.AddSample(row->counters[eNumberOfReadSectorRequests]*m_sectorSize);
+            m_wBytes.AddSample(row->counters[eNumberOfWriteSectorRequests]*m_sectorSize);
+            m_transfers.AddSample(m_reads[0] + m_writes[0]);
+            m_tBytes.AddSample(m_rBytes[0] + m_wBytes[0]);
         }
         else
         {
@@ -266,7 +246,7 @@ namespace SCXSystemLib
             //       shouldn't even be getting enumerated, then maybe the device
             //       type needs to be added to the list of ignored device types in
             //       diskdepend (see WI 33450).
-            out << L"The diskstats map does not contain a key matching the device named \"" << device << L"\", or only " << parts.size() << L" columns were found";
+            out << L"The diskstats map does not contain a key matching the device named \"" << device << L"\", or only " << columns << L" columns were found";
             SCX_LOG(m_log, suppressor.GetSeverity(out.str()), out.str());
         }
 #elif defined(sun)
@@ -39,7 +39,7 @@ namespace SCXSystemLib
         \param       deps - dependencies
 
     */
-    StatisticalPhysicalDiskEnumeration::StatisticalPhysicalDiskEnumeration(SCXCoreLib::SCXHandle<DiskDepend> deps) : m_deps(0), m_sampler(0)
+    StatisticalPhysicalDiskEnumeration::StatisticalPhysicalDiskEnumeration(SCXCoreLib::SCXHandle<DiskDepend> deps) : m_deps(0), m_samplerId(0)
     { 
         m_log = SCXCoreLib::SCXLogHandleFactory::GetLogHandle(L"scx.core.common.pal.system.disk.statisticalphysicaldiskenumeration");
         m_lock = SCXCoreLib::ThreadLockHandleGet();
@@ -64,18 +64,14 @@ namespace SCXSystemLib
     /**
        Destructor
     
-       Kills the sampler thread hard if not shut down gracefully (by using CleanUp).
+       Stops the sampling if not shut down gracefully (by using CleanUp).
 
     */
     StatisticalPhysicalDiskEnumeration::~StatisticalPhysicalDiskEnumeration()
     {
-        if (0 != m_sampler)
+        if (0 != m_samplerId)
         {
-            if (m_sampler->IsAlive())
-            {
-                CleanUp();
-            }
-            m_sampler = 0;
+            CleanUp();
         }
     }
 
@@ -137,16 +133,20 @@ namespace SCXSystemLib
 
     /*----------------------------------------------------------------------------*/
     /**
-       Initializes the disk collection and starts the sampler thread.
+       Initializes the disk collection and starts the sampling.
     
     */
     void StatisticalPhysicalDiskEnumeration::Init()
     {
         InitInstances();
 
-        StatisticalPhysicalDiskSamplerParam* p = new StatisticalPhysicalDiskSamplerParam();
-        p->m_diskEnum = this;
-        m_sampler = new SCXCoreLib::SCXThread(DiskSampler, p);
+        if (0 == m_samplerId)
+        {
+            StatisticalPhysicalDiskSamplerParam* p = new StatisticalPhysicalDiskSamplerParam();
+            p->m_diskEnum = this;
+            m_samplerId = SCXCoreLib::SCXSampleScheduler::Instance().Register(
+                DiskSampler, SCXCoreLib::SCXThreadParamHandle(p), DISK_SECONDS_PER_SAMPLE * 1000);
+        }
     }
 
     /*----------------------------------------------------------------------------*/
@@ -154,7 +154,7 @@ namespace SCXSystemLib
        Initializes the disk instances.
     
        \note This method is a helper to the Init method and can be used directly
-       if the sampler thread is not needed.
+       if the sampling is not needed.
     
     */
     void StatisticalPhysicalDiskEnumeration::InitInstances()
@@ -167,16 +167,16 @@ namespace SCXSystemLib
     /**
        Release the resources allocated.
     
-       Must be called before deallocating this object. Will wait when stopping 
-       the sampler thread.
+       Must be called before deallocating this object. Will wait for a sample
+       in progress to finish.
     
     */
     void StatisticalPhysicalDiskEnumeration::CleanUp()
     {
-        if (0 != m_sampler)
+        if (0 != m_samplerId)
         {
-            m_sampler->RequestTerminate();
-            m_sampler->Wait();
+            SCXCoreLib::SCXSampleScheduler::Instance().Unregister(m_samplerId);
+            m_samplerId = 0;
         }
     }
 
@@ -315,10 +315,12 @@ namespace SCXSystemLib
     */
     void StatisticalPhysicalDiskEnumeration::SampleDisks()
     {
-        SCXCoreLib::SCXThreadLock lock(m_lock);
 #if defined(linux)
+        // Only the sampler reads the diskstats file; do it before locking so
+        // a slow read does not hold up Update()
         m_deps->RefreshProcDiskStats();
 #endif
+        SCXCoreLib::SCXThreadLock lock(m_lock);
         for (EntityIterator iter = Begin(); iter != End(); iter++)
         {
             SCXCoreLib::SCXHandle<StatisticalPhysicalDiskInstance> disk = *iter;
@@ -329,7 +331,7 @@ namespace SCXSystemLib
 
     /*----------------------------------------------------------------------------*/
     /**
-       The disk sampler thread body.
+       The disk sampler body, run by the sample scheduler.
     
        \param       param - thread parameters.
 
@@ -340,32 +342,14 @@ namespace SCXSystemLib
         SCXASSERT(0 != p);
         SCXASSERT(0 != p->m_diskEnum);
 
-        bool bUpdate = true;
-        p->m_cond.SetSleep(DISK_SECONDS_PER_SAMPLE * 1000);
+        try
         {
-            SCXCoreLib::SCXConditionHandle h(p->m_cond);
-            while( ! p->GetTerminateFlag())
-            {
-                if (bUpdate)
-                {
-                    try
-                    {
-                        p->m_diskEnum->SampleDisks();
-                    }
-                    catch (const SCXCoreLib::SCXException& e)
-                    {
-                        SCX_LOGERROR(p->m_diskEnum->m_log,
-                                     std::wstring(L"StatisticalPhysicalDiskEnumeration::DiskSampler() - Unexpected exception caught: ").append(e.What()).append(L" - ").append(e.Where()));
-                    }
-                    bUpdate = false;
-                }
-
-                enum SCXCoreLib::SCXCondition::eConditionResult r = h.Wait();
-                if (SCXCoreLib::SCXCondition::eCondTimeout == r)
-                {
-                    bUpdate = true;
-                }
-            }
+            p->m_diskEnum->SampleDisks();
+        }
+        catch (const SCXCoreLib::SCXException& e)
+        {
+            SCX_LOGERROR(p->m_diskEnum->m_log,
+                         std::wstring(L"StatisticalPhysicalDiskEnumeration::DiskSampler() - Unexpected exception caught: ").append(e.What()).append(L" - ").append(e.Where()));
         }
     }
 
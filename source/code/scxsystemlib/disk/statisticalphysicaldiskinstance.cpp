@@ -193,30 +193,23 @@ namespace SCXSystemLib
         m_waitTimes.AddSample(diski.psd_dkwait.pst_sec * 1000 + diski.psd_dkwait.pst_usec / 1000);
         m_qLengths.AddSample(diski.psd_dkqlen_curr);
 #elif defined(linux)
-        std::vector<std::wstring> parts = m_deps->GetProcDiskStats(m_device);
-        for (size_t i=0; parts.size() == 0 && i < m_samplerDevices.size(); ++i)
+        const ProcDiskStatsRow* row = m_deps->GetProcDiskStatsRow(m_device);
+        for (size_t i=0; 0 == row && i < m_samplerDevices.size(); ++i)
         {
-            parts = m_deps->GetProcDiskStats(m_samplerDevices[i]);
+            row = m_deps->GetProcDiskStatsRow(m_samplerDevices[i]);
         }
         m_timeStamp.AddSample(time(0));
-        if (parts.size() > 11)
+        if (0 != row && row->columns > 11)
         {
-            try
-            {
-                m_reads.AddSample(SCXCoreLib::StrToULong(parts[3]));
-                m_writes.AddSample(SCXCoreLib::StrToULong(parts[7]));
-                m_rBytes.AddSample(SCXCoreLib::StrToULong(parts[5])*m_sectorSize);
-                m_wBytes.AddSample(SCXCoreLib::StrToULong(parts[9])*m_sectorSize);
-                m_rTimes.AddSample(SCXCoreLib::StrToULong(parts[6]));
-                m_wTimes.AddSample(SCXCoreLib::StrToULong(parts[10]));
-                m_transfers.AddSample(m_reads[0] + m_writes[0]);
-                m_tBytes.AddSample(m_rBytes[0] + m_wBytes[0]);
-                m_qLengths.AddSample(SCXCoreLib::StrToULong(parts[11]));
-            }
-            catch (const SCXCoreLib::SCXNotSupportedException& e)
-            {
-                SCX_LOGWARNING(m_log, std::wstring(L"Could not parse line from diskstats: ").append(L" - ").append(e.What()));
-            }
+            m_reads.AddSample(row->counters[3]);
+            m_writes.AddSample(row->counters[7]);
+            m_rBytes.AddSample(row->counters[5]*m_sectorSize);
+            m_wBytes.AddSample(row->counters[9]*m_sectorSize);
+            m_rTimes.AddSample(row->counters[6]);
+            m_wTimes.AddSample(row->counters[10]);
+            m_transfers.AddSample(m_reads[0] + m_writes[0]);
+            m_tBytes.AddSample(m_rBytes[0] + m_wBytes[0]);
+            m_qLengths.AddSample(row->counters[11]);
         }
 #elif defined(sun)
         std::wstringstream out;
@@ -17,6 +17,7 @@
 #include <scxcorelib/scxexception.h>
 #include <scxcorelib/scxfile.h>
 #include <scxcorelib/stringaid.h>
+#include <scxcorelib/stringspan.h>
 #include <scxcorelib/scxmath.h>
 #include <scxsystemlib/memoryinstance.h>
 #include <scxsystemlib/scxsysteminfo.h>
@@ -417,9 +418,9 @@ namespace SCXSystemLib
 
     /*----------------------------------------------------------------------------*/
     /**
-        Class that represents values passed between the threads of the memory instance.
+        Class that represents values passed to the sampler of the memory instance.
 
-        Representation of values passed between the threads of the memory instance.
+        Representation of values passed to the sampler of the memory instance.
 
     */
     class MemoryInstanceThreadParam : public SCXThreadParam
@@ -528,7 +529,7 @@ namespace SCXSystemLib
 #else
         m_reservedMemoryIsSupported(false),
 #endif
-        m_dataAquisitionThread(0)
+        m_samplerId(0)
 #if defined(linux)
         , m_foundTotalPhysMem(false)
         , m_foundAvailMem(false)
@@ -545,8 +546,9 @@ namespace SCXSystemLib
 
         if (startThread)
         {
-            MemoryInstanceThreadParam* params = new MemoryInstanceThreadParam(&m_pageReads, &m_pageWrites, m_deps, this);
-            m_dataAquisitionThread = new SCXCoreLib::SCXThread(MemoryInstance::DataAquisitionThreadBody, params);
+            SCXCoreLib::SCXThreadParamHandle params(new MemoryInstanceThreadParam(&m_pageReads, &m_pageWrites, m_deps, this));
+            m_samplerId = SCXCoreLib::SCXSampleScheduler::Instance().Register(
+                MemoryInstance::DataAquisitionSampleBody, params, MEMORY_SECONDS_PER_SAMPLE * 1000);
         }
     }
 
@@ -559,12 +561,9 @@ namespace SCXSystemLib
     MemoryInstance::~MemoryInstance()
     {
         SCX_LOGTRACE(m_log, L"MemoryInstance destructor");
-        if (NULL != m_dataAquisitionThread) {
-            if (m_dataAquisitionThread->IsAlive())
-            {
-                CleanUp();
-            }
-            m_dataAquisitionThread = NULL;
+        if (0 != m_samplerId)
+        {
+            CleanUp();
         }
     }
 
@@ -908,104 +907,79 @@ namespace SCXSystemLib
 
         for (size_t i = 0; i < lines.size(); i++)
         {
-            std::wstring line = lines[i];
+            const std::wstring& line = lines[i];
 
             SCX_LOGHYSTERICAL(m_log, std::wstring(L"UpdateFromMemInfo() - Read line: ").append(line));
 
-            std::vector<std::wstring> tokens;
-            StrTokenize(line, tokens);
-            if (tokens.size() >= 2)
+            WStrSpanTokenizer tokenizer(line, L" \n");
+            WStrSpan tokens[2];
+            if (tokenizer.Next(tokens, 2) < 2)
             {
-                if (L"MemTotal:" == tokens[0])
-                {
-                    try
-                    {
-                        m_totalPhysicalMemory = StrToULong(tokens[1]) * 1024;  // Resulting units: bytes
-                        m_foundTotalPhysMem = true;
-                        SCX_LOGHYSTERICAL(m_log, StrAppend(L"    totalPhysicalMemory = ", m_totalPhysicalMemory));
-                    }
-                    catch (const SCXNotSupportedException& e)
-                    {
-                        SCX_LOGWARNING(m_log, std::wstring(L"Could not read m_totalPhysicalMemory from :").append(line).append(L" - ").append(e.What()));
-                    }
-                }
-                if (L"MemAvailable:" == tokens[0])
-                {
-                    try
-                    {
-                        reportedAvailableMemory = StrToULong(tokens[1]) * 1024;  // Resulting units: bytes
-                        m_foundAvailMem = true;
-                        SCX_LOGHYSTERICAL(m_log, StrAppend(L"    availableMemory = ", m_availableMemory));
-                    }
-                    catch (const SCXNotSupportedException& e)
-                    {
-                        SCX_LOGWARNING(m_log, std::wstring(L"Could not read m_availableMemory from: ").append(line).append(L" - ").append(e.What()));
-                    }
-                }
-                if (L"MemFree:" == tokens[0])
-                {
-                    try
-                    {
-                        m_availableMemory = StrToULong(tokens[1]) * 1024;  // Resulting units: bytes
-                        m_foundAvailMem = true;
-                        SCX_LOGHYSTERICAL(m_log, StrAppend(L"    availableMemory = ", m_availableMemory));
-                    }
-                    catch (const SCXNotSupportedException& e)
-                    {
-                        SCX_LOGWARNING(m_log, std::wstring(L"Could not read m_availableMemory from: ").append(line).append(L" - ").append(e.What()));
-                    }
-                }
-                if (L"Buffers:" == tokens[0])
-                {
-                    try
-                    {
-                        buffers = StrToULong(tokens[1]) * 1024;  // Resulting units: bytes
-                        SCX_LOGHYSTERICAL(m_log, StrAppend(L"    buffers = ", buffers));
-                    }
-                    catch (const SCXNotSupportedException& e)
-                    {
-                        SCX_LOGWARNING(m_log, std::wstring(L"Could not read buffers from: ").append(line).append(L" - ").append(e.What()));
-                    }
-                }
-                if (L"Cached:" == tokens[0])
-                {
-                    try
-                    {
-                        cached = StrToULong(tokens[1]) * 1024;  // Resulting units: bytes
-                        SCX_LOGHYSTERICAL(m_log, StrAppend(L"    Cached = ", cached));
-                    }
-                    catch (const SCXNotSupportedException& e)
-                    {
-                        SCX_LOGWARNING(m_log, std::wstring(L"Could not read buffers from: ").append(line).append(L" - ").append(e.What()));
-                    }
-                }
-                if (L"SwapTotal:" == tokens[0])
-                {
-                    try
-                    {
-                        m_totalSwap = StrToULong(tokens[1]) * 1024; // Resulting units: bytes
-                        m_foundTotalSwap = true;
-                        SCX_LOGHYSTERICAL(m_log, StrAppend(L"    totalSwap = ", m_totalSwap));
-                    }
-                    catch (const SCXNotSupportedException& e)
-                    {
-                        SCX_LOGWARNING(m_log, std::wstring(L"Could not read m_totalSwap from: ").append(line).append(L" - ").append(e.What()));
-                    }
-                }
-                if (L"SwapFree:" == tokens[0])
-                {
-                    try
-                    {
-                        m_availableSwap = StrToULong(tokens[1]) * 1024; // Resulting units: bytes
-                        m_foundAvailSwap = true;
-                        SCX_LOGHYSTERICAL(m_log, StrAppend(L"    availableSwap = ", m_availableSwap));
-                    }
-                    catch (const SCXNotSupportedException& e)
-                    {
-                        SCX_LOGWARNING(m_log, std::wstring(L"Could not read m_availableSwap from: ").append(line).append(L" - ").append(e.What()));
-                    }
-                }
+                continue;
+            }
+
+            scxulong* value = NULL;
+            bool* found = NULL;
+            const wchar_t* name = NULL;
+            if (tokens[0].Equals(L"MemTotal:"))
+            {
+                value = &m_totalPhysicalMemory;
+                found = &m_foundTotalPhysMem;
+                name = L"totalPhysicalMemory";
+            }
+            else if (tokens[0].Equals(L"MemAvailable:"))
+            {
+                value = &reportedAvailableMemory;
+                found = &m_foundAvailMem;
+                name = L"availableMemory";
+            }
+            else if (tokens[0].Equals(L"MemFree:"))
+            {
+                value = &m_availableMemory;
+                found = &m_foundAvailMem;
+                name = L"availableMemory";
+            }
+            else if (tokens[0].Equals(L"Buffers:"))
+            {
+                value = &buffers;
+                name = L"buffers";
+            }
+            else if (tokens[0].Equals(L"Cached:"))
+            {
+                value = &cached;
+                name = L"cached";
+            }
+            else if (tokens[0].Equals(L"SwapTotal:"))
+            {
+                value = &m_totalSwap;
+                found = &m_foundTotalSwap;
+                name = L"totalSwap";
+            }
+            else if (tokens[0].Equals(L"SwapFree:"))
+            {
+                value = &m_availableSwap;
+                found = &m_foundAvailSwap;
+                name = L"availableSwap";
+            }
+            else
+            {
+                continue;
+            }
+
+            // The unit may follow the number with or without a blank
+            scxulong kiloBytes = 0;
+            WStrSpan unit;
+            if ( ! StrSpanToULong(tokens[1], kiloBytes, &unit))
+            {
+                SCX_LOGWARNING(m_log, std::wstring(L"Could not read ").append(name).append(L" from: ").append(line));
+                continue;
+            }
+            *value = kiloBytes * 1024;  // Resulting units: bytes
+            if (NULL != found)
+            {
+                *found = true;
             }
+            SCX_LOGHYSTERICAL(m_log, StrAppend(std::wstring(L"    ").append(name).append(L" = "), *value));
         }
 
         // perform some adjustments and calculations. Resulting units: bytes.
@@ -1121,16 +1095,16 @@ namespace SCXSystemLib
 
     /*----------------------------------------------------------------------------*/
     /**
-        Clean up the instance. Closes the thread.
+        Clean up the instance. Stops the sampling.
 
     */
     void MemoryInstance::CleanUp()
     {
         SCX_LOGTRACE(m_log, L"MemoryInstance CleanUp()");
-        if (NULL != m_dataAquisitionThread) {
-        m_dataAquisitionThread->RequestTerminate();
-        m_dataAquisitionThread->Wait();
-            m_dataAquisitionThread = NULL;
+        if (0 != m_samplerId)
+        {
+            SCXCoreLib::SCXSampleScheduler::Instance().Unregister(m_samplerId);
+            m_samplerId = 0;
         }
     }
 
@@ -1241,39 +1215,39 @@ namespace SCXSystemLib
     
             for (size_t i=0; (!foundPgpgin || !foundPgpgout) && i<lines.size(); i++)
             {
-                std::wstring line = lines[i];
+                const std::wstring& line = lines[i];
 
-                SCX_LOGHYSTERICAL(log, std::wstring(L"DataAquisitionThreadBody() - Read line: ").append(line));
-    
-                std::vector<std::wstring> tokens;
-                StrTokenize(line, tokens);
-                if (tokens.size() >= 2)
+                SCX_LOGHYSTERICAL(log, std::wstring(L"DataAquisitionSampleBody() - Read line: ").append(line));
+
+                WStrSpanTokenizer tokenizer(line, L" \n");
+                WStrSpan tokens[2];
+                if (tokenizer.Next(tokens, 2) < 2)
+                {
+                    continue;
+                }
+
+                if (tokens[0].Equals(L"pgpgin"))
+                {
+                    if (StrSpanToULong(tokens[1], pageReads))
+                    {
+                        foundPgpgin = true;
+                        SCX_LOGHYSTERICAL(log, StrAppend(L"    pageReads = ", pageReads));
+                    }
+                    else
+                    {
+                        SCX_LOGWARNING(log, std::wstring(L"Could not read pageReads from: ").append(line));
+                    }
+                }
+                else if (tokens[0].Equals(L"pgpgout"))
                 {
-                    if (L"pgpgin" == tokens[0])
+                    if (StrSpanToULong(tokens[1], pageWrites))
                     {
-                        try
-                        {
-                            pageReads = StrToULong(tokens[1]);
-                            foundPgpgin = true;
-                            SCX_LOGHYSTERICAL(log, StrAppend(L"    pageReads = ", pageReads));
-                        }
-                        catch (const SCXNotSupportedException& e)
-                        {
-                            SCX_LOGWARNING(log, std::wstring(L"Could not read pageReads from: ").append(line).append(L" - ").append(e.What()));
-                        }
+                        foundPgpgout = true;
+                        SCX_LOGHYSTERICAL(log, StrAppend(L"    pageWrites = ", pageWrites));
                     }
-                    if (L"pgpgout" == tokens[0])
+                    else
                     {
-                        try
-                        {
-                            pageWrites = StrToULong(tokens[1]);
-                            foundPgpgout = true;
-                            SCX_LOGHYSTERICAL(log, StrAppend(L"    pageWrites = ", pageWrites));
-                        }
-                        catch (const SCXNotSupportedException& e)
-                        {
-                            SCX_LOGWARNING(log, std::wstring(L"Could not read pageWrites from: ").append(line).append(L" - ").append(e.What()));
-                        }
+                        SCX_LOGWARNING(log, std::wstring(L"Could not read pageWrites from: ").append(line));
                     }
                 }
             }
@@ -1348,29 +1322,30 @@ namespace SCXSystemLib
 
     /*----------------------------------------------------------------------------*/
     /**
-        Thread body that updates values that are time dependent.
+        Sampler body that updates values that are time dependent.
 
         \param param Must contain a parameter named "ParamValues" of type MemoryInstanceThreadParam*
 
-        The thread updates all members that are time dependent. Like for example
-        page reads per second.
+        Run by the sample scheduler every MEMORY_SECONDS_PER_SAMPLE seconds to
+        update all members that are time dependent. Like for example page reads
+        per second. Sampling stops if the paging counters can not be read.
 
     */
-    void MemoryInstance::DataAquisitionThreadBody(SCXCoreLib::SCXThreadParamHandle& param)
+    void MemoryInstance::DataAquisitionSampleBody(SCXCoreLib::SCXThreadParamHandle& param)
     {
         SCXLogHandle log = SCXLogHandleFactory::GetLogHandle(L"scx.core.common.pal.system.memory.memoryinstance");
-        SCX_LOGTRACE(log, L"MemoryInstance::DataAquisitionThreadBody()");
+        SCX_LOGHYSTERICAL(log, L"MemoryInstance::DataAquisitionSampleBody()");
 
         if (0 == param.GetData())
         {
-            SCXASSERT( ! "No parameters to DataAquisitionThreadBody");
+            SCXASSERT( ! "No parameters to DataAquisitionSampleBody");
             return;
         }
         MemoryInstanceThreadParam* params = static_cast<MemoryInstanceThreadParam*>(param.GetData());
 
         if (0 == params)
         {
-            SCXASSERT( ! "Parameters to DagaAquisitionThreadBody not instance of MemoryInstanceThreadParam");
+            SCXASSERT( ! "Parameters to DataAquisitionSampleBody not instance of MemoryInstanceThreadParam");
             return;
         }
 
@@ -1389,34 +1364,18 @@ namespace SCXSystemLib
 
         SCXCoreLib::SCXHandle<MemoryDependencies> deps = params->GetDeps();
 
-        bool bUpdate = true;
-        params->m_cond.SetSleep(MEMORY_SECONDS_PER_SAMPLE * 1000);
-        {
-            SCXConditionHandle h(params->m_cond);
-            while ( ! params->GetTerminateFlag())
-            {
-                if (bUpdate)
-                {
-                    scxulong pageReads = 0;
-                    scxulong pageWrites = 0;
-
-                    if ( ! GetPagingSinceBoot(pageReads, pageWrites, params->GetInst(), deps))
-                    {
-                        return;
-                    }
-
-                    pageReadsParam->AddSample(pageReads);
-                    pageWritesParam->AddSample(pageWrites);
-                    bUpdate = false;
-                }
+        scxulong pageReads = 0;
+        scxulong pageWrites = 0;
 
-                enum SCXCondition::eConditionResult r = h.Wait();
-                if (SCXCondition::eCondTimeout == r)
-                {
-                    bUpdate = true;
-                }
-            }
+        if ( ! GetPagingSinceBoot(pageReads, pageWrites, params->GetInst(), deps))
+        {
+            // Tell the scheduler not to sample again
+            params->SetTerminateFlag();
+            return;
         }
+
+        pageReadsParam->AddSample(pageReads);
+        pageWritesParam->AddSample(pageWrites);
     }
 }
 
@@ -97,6 +97,10 @@ extern "C" int getkerninfo(int, char *, int *, int32long64_t);
 #define u8 __u8
 #endif
 #include <linux/ethtool.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <stdio.h>
+#include <sys/utsname.h>
 #endif
 
 #if defined(sun)
@@ -595,6 +599,8 @@ std::vector<wstring> NetworkInterfaceInfo::s_validInterfaces;
             .Scalar("errorsSending", m_errorsSending)
             .Scalar("errorsReceiving", m_errorsReceiving)
             .Scalar("collisions", m_collisions)
+            .Scalar("dropsReceiving", m_dropsReceiving)
+            .Scalar("dropsSending", m_dropsSending)
             .Scalar("up", m_up)
             .Scalar("running", m_running);
     }
@@ -791,16 +797,46 @@ static bool isFileExist(const string FileName)
     return access(FileName.c_str(),0)==0;
 }
 #endif
+
 /*----------------------------------------------------------------------------*/
-//! Find all network interfaces using the KStat API
+//! Does the running kernel keep the counters of /proc/net/dev in 32 bits
+//! \returns true iff the counters wrap at 2^32
+//! Kernels before 2.6.35 print the counters as unsigned long, which is only
+//! 64 bits wide on 64-bit platforms. Later kernels always print 64 bits.
+static bool AreProcNetDevCounters32Bit()
+{
+    if (sizeof(unsigned long) >= sizeof(scxulong)) {
+        return false;
+    }
+    struct utsname name;
+    unsigned int major = 0, minor = 0, patch = 0;
+    if (uname(&name) < 0 || sscanf(name.release, "%u.%u.%u", &major, &minor, &patch) < 2) {
+        return false;
+    }
+    return major < 2 || (2 == major && (minor < 6 || (6 == minor && patch < 35)));
+}
+
+/*----------------------------------------------------------------------------*/
+//! Find all network interfaces listed in the interface statistics file
 //! \param[out]    interfaces          To be populated
 //! \param[in]     deps                Dependencies to rely on
-//! \throws        SCXErrnoException   KStat problems
+//! \param[in]     interface           Name of the only interface to find, empty for all
+//! \param[in,out] counters            Counts the system calls issued
 void NetworkInterfaceInfo::FindAllInFile(std::vector<NetworkInterfaceInfo> &interfaces,
-                                         SCXHandle<NetworkInterfaceDependencies> deps, wstring interface) {
+                                         SCXHandle<NetworkInterfaceDependencies> deps, wstring interface,
+                                         NetworkInterfaceRefreshCounters &counters) {
     std::vector<wstring> lines;
     SCXStream::NLFs foundNlfs;
     SCXFile::ReadAllLines(deps->GetDynamicInfoFile(), lines, foundNlfs);
+    counters.fileReads++;
+#if !defined(ppc)
+    bool skipVirtual = SystemInfo::getScxConfMapValueofKey("enumvif") == "false";
+    string virtualDir = skipVirtual ? StrToUTF8(deps->GetVirtualInterfaceDirectory()) : string();
+#endif
+    static const bool counters32Bit = AreProcNetDevCounters32Bit();
+    // One socket serves the flag lookups of all interfaces
+    FileDescriptor fd = socket(AF_INET, SOCK_DGRAM, 0);
+    counters.sockets++;
     for (size_t nr = 2; nr < lines.size(); nr++) {
         wistringstream infostream(lines[nr]);
         infostream.exceptions(std::ios::failbit | std::ios::badbit);
@@ -809,15 +845,15 @@ void NetworkInterfaceInfo::FindAllInFile(std::vector<NetworkInterfaceInfo> &inte
         if (interface != L"" && interface_name != interface ) continue;
 
 #if !defined(ppc)
-        if(SystemInfo::getScxConfMapValueofKey("enumvif") == "false" && isFileExist(StrToUTF8(deps->GetVirtualInterfaceDirectory())+StrToUTF8(interface_name))) continue;
+        if(skipVirtual && isFileExist(virtualDir+StrToUTF8(interface_name))) continue;
 #endif
         // Skip the loopback interface (WI 463810)
-        FileDescriptor fd = socket(AF_INET, SOCK_DGRAM, 0);
         struct ifreq ifr;
         memset(&ifr, 0, sizeof(ifr));
         strcpy(ifr.ifr_name, StrToUTF8(interface_name).c_str());
 
         // if not found with ioctl, don't add an instance and continue the loop
+        counters.ioctls++;
         if (deps->ioctl(fd, SIOCGIFFLAGS, &ifr) >= 0)
         {
             if (ifr.ifr_ifru.ifru_flags & IFF_LOOPBACK)
@@ -832,7 +868,8 @@ void NetworkInterfaceInfo::FindAllInFile(std::vector<NetworkInterfaceInfo> &inte
             instance.m_knownAttributesMask |= ePacketsReceived;
             infostream >> instance.m_errorsReceiving;
             instance.m_knownAttributesMask |= eErrorsReceiving;
-            infostream >> skip;
+            infostream >> instance.m_dropsReceiving;
+            instance.m_knownAttributesMask |= eDropsReceiving;
             infostream >> skip;
             infostream >> skip;
             infostream >> skip;
@@ -843,16 +880,236 @@ void NetworkInterfaceInfo::FindAllInFile(std::vector<NetworkInterfaceInfo> &inte
             instance.m_knownAttributesMask |= ePacketsSent;
             infostream >> instance.m_errorsSending;
             instance.m_knownAttributesMask |= eErrorsSending;
-            infostream >> skip;
+            infostream >> instance.m_dropsSending;
+            instance.m_knownAttributesMask |= eDropsSending;
             infostream >> skip;
             infostream >> instance.m_collisions;
             instance.m_knownAttributesMask |= eCollisions;
+            instance.m_counters32Bit = counters32Bit;
 
             interfaces.push_back(instance);
         } 
     }
 
 }
+
+//! Netlink attribute with 64-bit link statistics (IFLA_STATS64), which old kernel headers lack
+static const unsigned short cIflaStats64 = 23;
+
+//! Link statistics in the order of struct rtnl_link_stats and rtnl_link_stats64
+enum LinkStatistic {
+    eLinkRxPackets, eLinkTxPackets, eLinkRxBytes, eLinkTxBytes,
+    eLinkRxErrors, eLinkTxErrors, eLinkRxDropped, eLinkTxDropped,
+    eLinkMulticast, eLinkCollisions,
+    eLinkStatisticCount
+};
+
+/*----------------------------------------------------------------------------*/
+//! Find all network interfaces with one netlink dump of the links and one of
+//! their addresses, instead of reading a file and issuing ioctl() calls for
+//! each interface.
+//! \param[out]    interfaces          To be populated
+//! \param[in]     deps                Dependencies to rely on
+//! \param[in]     interface           Name of the only interface to find, empty for all
+//! \param[in,out] counters            Counts the system calls issued
+//! \param[in]     withAddresses       Also look up the addresses of the interfaces?
+//! \returns       false if netlink is not to be used or the dumps failed; interfaces is then untouched
+bool NetworkInterfaceInfo::FindAllUsingNetlink(std::vector<NetworkInterfaceInfo> &interfaces,
+                                               SCXHandle<NetworkInterfaceDependencies> deps, wstring interface,
+                                               NetworkInterfaceRefreshCounters &counters, bool withAddresses) {
+    SCXHandle<NetlinkRouteSocket> netlink = deps->GetNetlinkRouteSocket();
+    if (NULL == netlink) {
+        return false;
+    }
+
+    std::vector<char> links;
+    std::vector<char> addresses;
+    try {
+        counters.netlinkDumps++;
+        netlink->Dump(RTM_GETLINK, AF_UNSPEC, links);
+        if (withAddresses) {
+            counters.netlinkDumps++;
+            netlink->Dump(RTM_GETADDR, AF_UNSPEC, addresses);
+        }
+    } catch (SCXException &e) {
+        static SCXCoreLib::LogSuppressor suppressor(SCXCoreLib::eWarning, SCXCoreLib::eTrace);
+        wstring msg = L"Netlink lookup of network interfaces failed, using " +
+                      deps->GetDynamicInfoFile().Get() + L" instead: " + e.What() + L" " + e.Where();
+        SCX_LOG(SCXLogHandleFactory::GetLogHandle(L"scx.core.common.pal.system.networkinterface"),
+                suppressor.GetSeverity(msg), msg);
+        return false;
+    }
+
+#if !defined(ppc)
+    bool skipVirtual = SystemInfo::getScxConfMapValueofKey("enumvif") == "false";
+    string virtualDir = skipVirtual ? StrToUTF8(deps->GetVirtualInterfaceDirectory()) : string();
+#endif
+    std::vector<NetworkInterfaceInfo> found;
+    std::map<int, size_t> foundByIndex;
+
+    unsigned int remaining = static_cast<unsigned int>(links.size());
+    for (struct nlmsghdr *msg = reinterpret_cast<struct nlmsghdr *>(links.empty() ? NULL : &links[0]);
+         NLMSG_OK(msg, remaining); msg = NLMSG_NEXT(msg, remaining)) {
+        if (RTM_NEWLINK != msg->nlmsg_type || msg->nlmsg_len < NLMSG_LENGTH(sizeof(struct ifinfomsg))) {
+            continue;
+        }
+        struct ifinfomsg *ifi = static_cast<struct ifinfomsg *>(NLMSG_DATA(msg));
+
+        // Skip the loopback interface (WI 463810)
+        if (ifi->ifi_flags & IFF_LOOPBACK) {
+            continue;
+        }
+
+        NetworkInterfaceInfo instance(deps);
+        unsigned char hwAddr[6] = { 0, 0, 0, 0, 0, 0 };
+        scxulong stats[eLinkStatisticCount];
+        bool hasStats = false;
+        bool hasStats64 = false;
+
+        int attrLength = static_cast<int>(IFLA_PAYLOAD(msg));
+        for (struct rtattr *attr = IFLA_RTA(ifi); RTA_OK(attr, attrLength); attr = RTA_NEXT(attr, attrLength)) {
+            const char *data = static_cast<const char *>(RTA_DATA(attr));
+            size_t size = RTA_PAYLOAD(attr);
+            switch (attr->rta_type) {
+            case IFLA_IFNAME:
+                instance.m_name = StrFromUTF8(string(data, strnlen(data, size)));
+                break;
+            case IFLA_MTU:
+                if (size >= sizeof(__u32)) {
+                    __u32 mtu;
+                    memcpy(&mtu, data, sizeof(mtu));
+                    instance.m_mtu = mtu;
+                    instance.m_knownAttributesMask |= eMTU;
+                }
+                break;
+            case IFLA_ADDRESS:
+                memcpy(hwAddr, data, std::min(size, sizeof(hwAddr)));
+                break;
+            case IFLA_STATS:
+                if (!hasStats64 && size >= eLinkStatisticCount * sizeof(__u32)) {
+                    __u32 stats32[eLinkStatisticCount];
+                    memcpy(stats32, data, sizeof(stats32));
+                    std::copy(stats32, stats32 + eLinkStatisticCount, stats);
+                    hasStats = true;
+                }
+                break;
+            case cIflaStats64:
+                if (size >= eLinkStatisticCount * sizeof(__u64)) {
+                    __u64 stats64[eLinkStatisticCount];
+                    memcpy(stats64, data, sizeof(stats64));
+                    std::copy(stats64, stats64 + eLinkStatisticCount, stats);
+                    hasStats = hasStats64 = true;
+                }
+                break;
+            default:
+                break;
+            }
+        }
+
+        if (instance.m_name.empty() || (interface != L"" && instance.m_name != interface)) {
+            continue;
+        }
+#if !defined(ppc)
+        if (skipVirtual && isFileExist(virtualDir + StrToUTF8(instance.m_name))) {
+            continue;
+        }
+#endif
+
+        instance.m_interfaceIndex = ifi->ifi_index;
+        instance.m_knownAttributesMask |= eInterfaceIndex;
+        instance.SetUpAndRunning((ifi->ifi_flags & IFF_UP) != 0, (ifi->ifi_flags & IFF_RUNNING) != 0);
+        instance.SetHwAddr(ifi->ifi_type, hwAddr);
+        if (hasStats) {
+            instance.m_bytesReceived = stats[eLinkRxBytes];
+            instance.m_packetsReceived = stats[eLinkRxPackets];
+            instance.m_errorsReceiving = stats[eLinkRxErrors];
+            instance.m_bytesSent = stats[eLinkTxBytes];
+            instance.m_packetsSent = stats[eLinkTxPackets];
+            instance.m_errorsSending = stats[eLinkTxErrors];
+            instance.m_collisions = stats[eLinkCollisions];
+            instance.m_dropsReceiving = stats[eLinkRxDropped];
+            instance.m_dropsSending = stats[eLinkTxDropped];
+            instance.m_knownAttributesMask |= eBytesReceived | ePacketsReceived | eErrorsReceiving |
+                                              eBytesSent | ePacketsSent | eErrorsSending | eCollisions |
+                                              eDropsReceiving | eDropsSending;
+            instance.m_counters32Bit = !hasStats64;
+        }
+
+        foundByIndex[ifi->ifi_index] = found.size();
+        found.push_back(instance);
+    }
+
+    remaining = static_cast<unsigned int>(addresses.size());
+    for (struct nlmsghdr *msg = reinterpret_cast<struct nlmsghdr *>(addresses.empty() ? NULL : &addresses[0]);
+         NLMSG_OK(msg, remaining); msg = NLMSG_NEXT(msg, remaining)) {
+        if (RTM_NEWADDR != msg->nlmsg_type || msg->nlmsg_len < NLMSG_LENGTH(sizeof(struct ifaddrmsg))) {
+            continue;
+        }
+        struct ifaddrmsg *ifa = static_cast<struct ifaddrmsg *>(NLMSG_DATA(msg));
+        std::map<int, size_t>::const_iterator pos = foundByIndex.find(static_cast<int>(ifa->ifa_index));
+        if (pos == foundByIndex.end()) {
+            continue;
+        }
+        NetworkInterfaceInfo &instance = found[pos->second];
+
+        size_t addrSize = AF_INET == ifa->ifa_family ? sizeof(struct in_addr) : sizeof(struct in6_addr);
+        const void *address = NULL;
+        const void *local = NULL;
+        const void *broadcast = NULL;
+        string label;
+        int attrLength = static_cast<int>(IFA_PAYLOAD(msg));
+        for (struct rtattr *attr = IFA_RTA(ifa); RTA_OK(attr, attrLength); attr = RTA_NEXT(attr, attrLength)) {
+            const char *data = static_cast<const char *>(RTA_DATA(attr));
+            size_t size = RTA_PAYLOAD(attr);
+            if (IFA_LABEL == attr->rta_type) {
+                label.assign(data, strnlen(data, size));
+            } else if (size < addrSize) {
+                continue;
+            } else if (IFA_ADDRESS == attr->rta_type) {
+                address = data;
+            } else if (IFA_LOCAL == attr->rta_type) {
+                local = data;
+            } else if (IFA_BROADCAST == attr->rta_type) {
+                broadcast = data;
+            }
+        }
+        // The local address differs from the address only on point-to-point links
+        if (NULL != local) {
+            address = local;
+        }
+        if (NULL == address) {
+            continue;
+        }
+
+        char addrStr[INET6_ADDRSTRLEN];
+        if (AF_INET == ifa->ifa_family) {
+            // Like SIOCGIFADDR, take the first address not labelled as an alias
+            if (instance.IsValueKnown(eIPAddress) || (!label.empty() && StrFromUTF8(label) != instance.m_name)) {
+                continue;
+            }
+            instance.m_ipAddress = StrFromUTF8(inet_ntop(AF_INET, address, addrStr, sizeof(addrStr)));
+            instance.m_knownAttributesMask |= eIPAddress;
+
+            struct in_addr netmask;
+            netmask.s_addr = ifa->ifa_prefixlen == 0 ? 0 :
+                htonl(0xffffffffU << (32 - std::min(static_cast<int>(ifa->ifa_prefixlen), 32)));
+            instance.m_netmask = StrFromUTF8(inet_ntop(AF_INET, &netmask, addrStr, sizeof(addrStr)));
+            instance.m_knownAttributesMask |= eNetmask;
+
+            // SIOCGIFBRDADDR reports 0.0.0.0 for an address without a broadcast address
+            struct in_addr noBroadcast;
+            noBroadcast.s_addr = 0;
+            instance.m_broadcastAddress = StrFromUTF8(inet_ntop(AF_INET, NULL != broadcast ? broadcast : &noBroadcast,
+                                                                addrStr, sizeof(addrStr)));
+            instance.m_knownAttributesMask |= eBroadcastAddress;
+        } else if (AF_INET6 == ifa->ifa_family) {
+            instance.m_ipv6Address.push_back(StrFromUTF8(inet_ntop(AF_INET6, address, addrStr, sizeof(addrStr))));
+        }
+    }
+
+    interfaces.swap(found);
+    return true;
+}
 #endif
 
 #if defined(aix)
@@ -1088,6 +1345,14 @@ SCXCoreLib::SCXHandle<SCXKstat> NetworkInterfaceDependencies::CreateKstat()
 SCXCoreLib::SCXFilePath NetworkInterfaceDependencies::GetDynamicInfoFile() const {
     return L"/proc/net/dev";
 }
+
+/*----------------------------------------------------------------------------*/
+//! Retrieves the netlink socket to look up network interfaces with
+//! \returns    Socket kept open between lookups if netlink was asked for when
+//!             constructing, otherwise NULL to read the dynamic info file
+SCXCoreLib::SCXHandle<NetlinkRouteSocket> NetworkInterfaceDependencies::GetNetlinkRouteSocket() {
+    return m_netlinkRoute;
+}
 #if !defined(ppc)
 /*----------------------------------------------------------------------------*/
 //! Retrieves the name of the directory containing virtual network interfaces
@@ -1181,7 +1446,8 @@ int NetworkInterfaceDependencies::putmsg(int fildes, const struct ::strbuf * ctl
 /*----------------------------------------------------------------------------*/
 //! Make the information correspond to the current state of the system
 void NetworkInterfaceInfo::Refresh() {
-    vector<NetworkInterfaceInfo> latestInterfaces(FindAll(m_deps));
+    // Only this interface is looked up, not all of them
+    vector<NetworkInterfaceInfo> latestInterfaces(FindAll(m_deps, false, GetName()));
     for (size_t nr = 0; nr < latestInterfaces.size(); nr++) {
         if (latestInterfaces[nr].GetName() == GetName()) {
             *this = latestInterfaces[nr];
@@ -1198,8 +1464,10 @@ void NetworkInterfaceInfo::Refresh() {
     //!
     //! \param fd file descriptor
     //! \param deps dependency
+    //! \param counters counts the ioctl() call
     //!
-    void NetworkInterfaceInfo::ParseHwAddr(int fd, SCXHandle<NetworkInterfaceDependencies> deps)
+    void NetworkInterfaceInfo::ParseHwAddr(int fd, SCXHandle<NetworkInterfaceDependencies> deps,
+                                           NetworkInterfaceRefreshCounters &counters)
     {
         struct ifreq ifr;
 
@@ -1209,67 +1477,9 @@ void NetworkInterfaceInfo::Refresh() {
         memset(&ifr, 0, sizeof(ifr));
         ifr.ifr_addr.sa_family = AF_INET;
         strncpy(ifr.ifr_name, SCXCoreLib::StrToUTF8(m_name).c_str(), IFNAMSIZ - 1);
+        counters.ioctls++;
         if (deps->ioctl(fd, SIOCGIFHWADDR, &ifr) >= 0) {
-            switch(ifr.ifr_hwaddr.sa_family)
-            {
-            case ARPHRD_ETHER:
-                m_adapterTypeID = eNetworkAdapterTypeEthernet8023;
-                break;
-            case ARPHRD_FDDI:
-                m_adapterTypeID = eNetworkAdapterTypeFDDI;
-                break;
-            case ARPHRD_LOCALTLK:
-                m_adapterTypeID = eNetworkAdapterTypeLocalTalk;
-                break;
-            case ARPHRD_ARCNET:
-                m_adapterTypeID = eNetworkAdapterTypeARCNET;
-                break;
-            case ARPHRD_ATM:
-                m_adapterTypeID = eNetworkAdapterTypeATM;
-                break;
-            case ARPHRD_IEEE80211:
-                m_adapterTypeID = eNetworkAdapterTypeWireless;
-                break;
-            case ARPHRD_IEEE1394:
-                m_adapterTypeID = eNetworkAdapterType1394;
-                break;
-            default:
-                // other values do not have correspond values defined in Win32_NetworkAdapter.
-                static SCXCoreLib::LogSuppressor suppressor(SCXCoreLib::eInfo, SCXCoreLib::eTrace);
-                std::wstringstream errMsg;
-
-                errMsg << L"For net device " << m_name << L", can not map sa_family to AdapterType, sa_family is: " << ifr.ifr_hwaddr.sa_family;
-                SCXCoreLib::SCXLogSeverity severity(suppressor.GetSeverity(errMsg.str()));
-                SCX_LOG(m_log, severity, errMsg.str());
-
-                m_adapterTypeID = eNetworkAdapterTypeInvalid;
-            }
-            if (eNetworkAdapterTypeInvalid == m_adapterTypeID)
-            {
-                m_adapterType = L"";
-            }
-            else
-            {
-                m_adapterType = AdapterTypeNames[m_adapterTypeID];
-            }
-            /* in <linux/if_arp.h>, Dummy types for non ARP hardware start
-             * at ARPHRD_SLIP, which is 256 */
-            if (ifr.ifr_hwaddr.sa_family >= ARPHRD_SLIP)
-            {
-                m_physicalAdapter = false;
-            }
-            else
-            {
-                m_physicalAdapter = true;
-            }
-            m_knownAttributesMask |= ePhysicalAdapter;
-
-            m_macAddress = FormatMacAddress((unsigned int)(unsigned char)ifr.ifr_hwaddr.sa_data[0],
-                                            (unsigned int)(unsigned char)ifr.ifr_hwaddr.sa_data[1],
-                                            (unsigned int)(unsigned char)ifr.ifr_hwaddr.sa_data[2],
-                                            (unsigned int)(unsigned char)ifr.ifr_hwaddr.sa_data[3],
-                                            (unsigned int)(unsigned char)ifr.ifr_hwaddr.sa_data[4],
-                                            (unsigned int)(unsigned char)ifr.ifr_hwaddr.sa_data[5]);
+            SetHwAddr(ifr.ifr_hwaddr.sa_family, reinterpret_cast<const unsigned char*>(ifr.ifr_hwaddr.sa_data));
         }
         else
         {
@@ -1278,13 +1488,85 @@ void NetworkInterfaceInfo::Refresh() {
         }
     }
     /*----------------------------------------------------------------------------*/
+    //! set AdapterTypeID, AdapterType, PhysicalAdapter, MACAddress from
+    //! the hardware type and address of the interface.
+    //!
+    //! \param family ARPHRD_* hardware type
+    //! \param addr first six bytes of the hardware address
+    //!
+    void NetworkInterfaceInfo::SetHwAddr(unsigned short family, const unsigned char addr[6])
+    {
+        switch(family)
+        {
+        case ARPHRD_ETHER:
+            m_adapterTypeID = eNetworkAdapterTypeEthernet8023;
+            break;
+        case ARPHRD_FDDI:
+            m_adapterTypeID = eNetworkAdapterTypeFDDI;
+            break;
+        case ARPHRD_LOCALTLK:
+            m_adapterTypeID = eNetworkAdapterTypeLocalTalk;
+            break;
+        case ARPHRD_ARCNET:
+            m_adapterTypeID = eNetworkAdapterTypeARCNET;
+            break;
+        case ARPHRD_ATM:
+            m_adapterTypeID = eNetworkAdapterTypeATM;
+            break;
+        case ARPHRD_IEEE80211:
+            m_adapterTypeID = eNetworkAdapterTypeWireless;
+            break;
+        case ARPHRD_IEEE1394:
+            m_adapterTypeID = eNetworkAdapterType1394;
+            break;
+        default:
+            // other values do not have correspond values defined in Win32_NetworkAdapter.
+            static SCXCoreLib::LogSuppressor suppressor(SCXCoreLib::eInfo, SCXCoreLib::eTrace);
+            std::wstringstream errMsg;
+
+            errMsg << L"For net device " << m_name << L", can not map sa_family to AdapterType, sa_family is: " << family;
+            SCXCoreLib::SCXLogSeverity severity(suppressor.GetSeverity(errMsg.str()));
+            SCX_LOG(m_log, severity, errMsg.str());
+
+            m_adapterTypeID = eNetworkAdapterTypeInvalid;
+        }
+        if (eNetworkAdapterTypeInvalid == m_adapterTypeID)
+        {
+            m_adapterType = L"";
+        }
+        else
+        {
+            m_adapterType = AdapterTypeNames[m_adapterTypeID];
+        }
+        /* in <linux/if_arp.h>, Dummy types for non ARP hardware start
+         * at ARPHRD_SLIP, which is 256 */
+        if (family >= ARPHRD_SLIP)
+        {
+            m_physicalAdapter = false;
+        }
+        else
+        {
+            m_physicalAdapter = true;
+        }
+        m_knownAttributesMask |= ePhysicalAdapter;
+
+        m_macAddress = FormatMacAddress((unsigned int)addr[0],
+                                        (unsigned int)addr[1],
+                                        (unsigned int)addr[2],
+                                        (unsigned int)addr[3],
+                                        (unsigned int)addr[4],
+                                        (unsigned int)addr[5]);
+    }
+    /*----------------------------------------------------------------------------*/
     //! parse data get by ioctl(fd, SIOETHTOOL, ), will get attribute
     //! AutoSense, MaxSpeed, Speed
     //!
     //! \param fd file descriptor
     //! \param deps dependency
+    //! \param counters counts the ioctl() call
     //!
-    void NetworkInterfaceInfo::ParseEthtool(int fd, SCXHandle<NetworkInterfaceDependencies> deps)
+    void NetworkInterfaceInfo::ParseEthtool(int fd, SCXHandle<NetworkInterfaceDependencies> deps,
+                                            NetworkInterfaceRefreshCounters &counters)
     {
         struct ifreq       ifr;
         struct ethtool_cmd ecmd;
@@ -1295,6 +1577,7 @@ void NetworkInterfaceInfo::Refresh() {
         ifr.ifr_data = (caddr_t) &ecmd;
 
         m_autoSense = false;
+        counters.ioctls++;
         if (deps->ioctl(fd, SIOCETHTOOL, &ifr) >= 0)
         {
             /* macros defined in file <linux/ethtool.h> */
@@ -1778,14 +2061,17 @@ static SCXCoreLib::LogSuppressor suppressor(SCXCoreLib::eError, SCXCoreLib::eTra
     //!
     //! \param fd file descriptor
     //! \param deps dependency
+    //! \param counters counts the ioctl() call
     //!
-    void NetworkInterfaceInfo::ParseIndex(int fd, SCXHandle<NetworkInterfaceDependencies> deps)
+    void NetworkInterfaceInfo::ParseIndex(int fd, SCXHandle<NetworkInterfaceDependencies> deps,
+                                          NetworkInterfaceRefreshCounters &counters)
     {
         struct ifreq ifr;
 
         memset(&ifr, 0, sizeof(ifr));
         strncpy(ifr.ifr_name, SCXCoreLib::StrToUTF8(m_name).c_str(), IFNAMSIZ - 1);
         ifr.ifr_addr.sa_family = AF_INET;
+        counters.ioctls++;
         if (deps->ioctl(fd, SIOCGIFINDEX, &ifr) >= 0)
         {
 #if defined(linux)
@@ -1802,12 +2088,15 @@ static SCXCoreLib::LogSuppressor suppressor(SCXCoreLib::eError, SCXCoreLib::eTra
     }
 #endif
 
+#if defined(linux)
 /*----------------------------------------------------------------------------*/
-//! Finds IPv6 addresses. 
-//! \param[in]  deps    What this PAL depends on.
-    void NetworkInterfaceInfo::ParseIPv6Addr(SCXCoreLib::SCXHandle<NetworkInterfaceDependencies> deps)
+//! Finds the IPv6 addresses of all interfaces with a single getifaddrs() call.
+//! \param[in]  deps        What this PAL depends on.
+//! \param[out] addresses   IPv6 addresses by interface name.
+//! \param[in]  log         Log handle.
+    void NetworkInterfaceInfo::FindAllIPv6Addr(SCXCoreLib::SCXHandle<NetworkInterfaceDependencies> deps,
+                                               IPv6AddressMap &addresses, SCXCoreLib::SCXLogHandle &log)
     {
-#if defined(linux)
         class AutoIFAddr
         {
             struct ifaddrs * m_ifAddr;
@@ -1833,24 +2122,40 @@ static SCXCoreLib::LogSuppressor suppressor(SCXCoreLib::eError, SCXCoreLib::eTra
         struct ifaddrs *ifAddrPtr;
         if (deps->getifaddrs(&ifAddrPtr) != 0)
         {
-            SCX_LOGTRACE(m_log, L"For net device " + m_name + L" getifaddrs() failed, errno : " + wstrerror(errno) + L'.');
+            SCX_LOGTRACE(log, L"getifaddrs() failed, errno : " + wstrerror(errno) + L'.');
             return;
         }
-        AutoIFAddr ifAddr(ifAddrPtr, m_deps);
+        AutoIFAddr ifAddr(ifAddrPtr, deps);
 
         struct ifaddrs * ifa = NULL;
         void * pTmpAddr = NULL;
 
         for (ifa = ifAddr.GetIFAddr(); ifa != NULL; ifa = ifa->ifa_next)
         {
-            if (ifa->ifa_addr && ifa->ifa_addr->sa_family == AF_INET6 && strcmp(ifa->ifa_name, StrToUTF8(m_name).c_str()) == 0)
+            if (ifa->ifa_addr && ifa->ifa_addr->sa_family == AF_INET6)
             { 
                 pTmpAddr = &((struct sockaddr_in6 *)ifa->ifa_addr)->sin6_addr;
                 char addrStr[INET6_ADDRSTRLEN];
                 inet_ntop(AF_INET6, pTmpAddr, addrStr, INET6_ADDRSTRLEN);
-                m_ipv6Address.push_back(StrFromUTF8(addrStr));
+                addresses[StrFromUTF8(ifa->ifa_name)].push_back(StrFromUTF8(addrStr));
             }
         }
+    }
+#endif
+
+/*----------------------------------------------------------------------------*/
+//! Finds IPv6 addresses. 
+//! \param[in]  deps    What this PAL depends on.
+    void NetworkInterfaceInfo::ParseIPv6Addr(SCXCoreLib::SCXHandle<NetworkInterfaceDependencies> deps)
+    {
+#if defined(linux)
+        IPv6AddressMap addresses;
+        FindAllIPv6Addr(deps, addresses, m_log);
+        IPv6AddressMap::const_iterator pos = addresses.find(m_name);
+        if (pos != addresses.end())
+        {
+            m_ipv6Address.insert(m_ipv6Address.end(), pos->second.begin(), pos->second.end());
+        }
 #endif
 #if defined(sun) || defined(hpux) || defined(aix)
         class AutoSocket
@@ -2044,19 +2349,52 @@ static SCXCoreLib::LogSuppressor suppressor(SCXCoreLib::eError, SCXCoreLib::eTra
 #endif// defined(sun) || defined(hpux) || defined(aix)
 }
 
+/*----------------------------------------------------------------------------*/
+//! Set up, running and the availability and connection status they imply
+//! \param[in]  up       Is the interface up
+//! \param[in]  running  Is the interface running
+void NetworkInterfaceInfo::SetUpAndRunning(bool up, bool running)
+{
+    m_up = up;
+    m_running = running;
+    m_knownAttributesMask |= eUp;
+    m_knownAttributesMask |= eRunning;
+    if (true == m_running) {
+        m_availability = eAvailabilityRunningOrFullPower;
+        m_netConnectionStatus=eNetConnectionStatusConnected;
+    }
+    else{
+        m_availability = eAvailabilityUnknown;
+        if (true == m_up) {
+            m_netConnectionStatus=eNetConnectionStatusMediaDisconnected;
+        }
+        else {
+            m_netConnectionStatus=eNetConnectionStatusDisconnected;
+        }
+    }
+}
+
 /*----------------------------------------------------------------------------*/
 //! Find all network interfaces on the machine
 //! \param[in]  deps    What this PAL depends on
 //! \param[in]  includeNonRunning    If false find only interfaces that are up and running
+//! \param[in]  interface   Name of the only interface to find, empty for all
+//! \param[out] counters    If not NULL, receives the number of system calls issued (where counted)
 //! \returns    Information on the network instances
 std::vector<NetworkInterfaceInfo> NetworkInterfaceInfo::FindAll(SCXHandle<NetworkInterfaceDependencies> deps,
-                                                                bool includeNonRunning /*= false*/, wstring interface) {
+                                                                bool includeNonRunning /*= false*/, wstring interface,
+                                                                NetworkInterfaceRefreshCounters *counters /*= NULL*/) {
     SCXCoreLib::SCXLogHandle m_log = SCXLogHandleFactory::GetLogHandle(wstring(L"scx.core.common.pal.system.networkinterface"));
 
     SCX_LOGTRACE(m_log, L"NetworkInterfaceInfo::FindAll entry");
     std::vector<NetworkInterfaceInfo> interfaces;
+    NetworkInterfaceRefreshCounters issued;
 #if defined(linux)
-    FindAllInFile(interfaces, deps, interface);
+    bool fromNetlink = FindAllUsingNetlink(interfaces, deps, interface, issued);
+    if ( ! fromNetlink)
+    {
+        FindAllInFile(interfaces, deps, interface, issued);
+    }
 #elif defined(sun)
     FindAllUsingKStat(interfaces, deps, interface);
 #elif defined(hpux)
@@ -2069,29 +2407,51 @@ std::vector<NetworkInterfaceInfo> NetworkInterfaceInfo::FindAll(SCXHandle<Networ
 #endif
     SCX_LOGTRACE(m_log, L"NetworkInterfaceInfo::FindAll Getting attributes for instance");
     FileDescriptor fd = socket(AF_INET, SOCK_DGRAM, 0);
+    issued.sockets++;
     struct ifreq ifr;
     memset(&ifr, 0, sizeof(ifr));
+#if defined(linux)
+    // The addresses of all interfaces come with one lookup
+    IPv6AddressMap ipv6Addresses;
+    if ( ! fromNetlink && ! interfaces.empty())
+    {
+        FindAllIPv6Addr(deps, ipv6Addresses, m_log);
+        issued.addressLookups++;
+    }
+#endif
     for (size_t nr = 0; nr < interfaces.size(); nr++) {
         NetworkInterfaceInfo &instance = interfaces[nr];
         strcpy(ifr.ifr_name, StrToUTF8(instance.m_name).c_str());
         SCX_LOGTRACE(m_log, wstring(L"NetworkInterfaceInfo::FindAll working on interface ") + instance.m_name);
 
+#if defined(linux)
+        if (fromNetlink)
+        {
+            // All but the link settings came with the netlink dumps
+            instance.ParseEthtool(fd, deps, issued);
+            continue;
+        }
+#endif
         SCX_LOGTRACE(m_log, L"NetworkInterfaceInfo::FindAll Attribute SIOCGIFADDR");
+        issued.ioctls++;
         if (deps->ioctl(fd, SIOCGIFADDR, &ifr) >= 0) {
             instance.m_ipAddress = ToString(ifr.ifr_addr);
             instance.m_knownAttributesMask |= eIPAddress;
         }
         SCX_LOGTRACE(m_log, L"NetworkInterfaceInfo::FindAll Attribute SIOCGIFNETMASK");
+        issued.ioctls++;
         if (deps->ioctl(fd, SIOCGIFNETMASK, &ifr) >= 0) {
             instance.m_netmask = ToString(ifr.ifr_addr);
             instance.m_knownAttributesMask |= eNetmask;
         }
         SCX_LOGTRACE(m_log, L"NetworkInterfaceInfo::FindAll Attribute SIOCGIFBRDADDR");
+        issued.ioctls++;
         if (deps->ioctl(fd, SIOCGIFBRDADDR, &ifr) >= 0) {
             instance.m_broadcastAddress = ToString(ifr.ifr_addr);
             instance.m_knownAttributesMask |= eBroadcastAddress;
         }
         SCX_LOGTRACE(m_log, L"NetworkInterfaceInfo::FindAll Attribute SIOCGIFMTU");
+        issued.ioctls++;
         if (deps->ioctl(fd, SIOCGIFMTU, &ifr) >=0)
         {
 #if defined(hpux) && PF_MAJOR == 11 && PF_MINOR <= 23 || defined(sun) && PF_MAJOR == 5 && PF_MINOR <= 10
@@ -2103,31 +2463,25 @@ std::vector<NetworkInterfaceInfo> NetworkInterfaceInfo::FindAll(SCXHandle<Networ
             instance.m_knownAttributesMask |= eMTU;
         }
         SCX_LOGTRACE(m_log, L"NetworkInterfaceInfo::FindAll Attribute SIOCGIFFLAGS");
+        issued.ioctls++;
         if (deps->ioctl(fd, SIOCGIFFLAGS, &ifr) >= 0) {
-            instance.m_up = (ifr.ifr_flags & IFF_UP) != 0;
-            instance.m_running = (ifr.ifr_flags & IFF_RUNNING) != 0;
-            instance.m_knownAttributesMask |= eUp;
-            instance.m_knownAttributesMask |= eRunning;
-            if (true == instance.m_running) {
-                instance.m_availability = eAvailabilityRunningOrFullPower;
-                instance.m_netConnectionStatus=eNetConnectionStatusConnected;
-            }
-            else{
-                instance.m_availability = eAvailabilityUnknown;
-                if (true == instance.m_up) {
-                    instance.m_netConnectionStatus=eNetConnectionStatusMediaDisconnected;
-                }
-                else {
-                    instance.m_netConnectionStatus=eNetConnectionStatusDisconnected;
-                }
-            }
+            instance.SetUpAndRunning((ifr.ifr_flags & IFF_UP) != 0, (ifr.ifr_flags & IFF_RUNNING) != 0);
         }
 #if defined(sun) || defined(linux)
-        instance.ParseIndex(fd, deps);
+        instance.ParseIndex(fd, deps, issued);
 #endif
 
+#if defined(linux)
+        IPv6AddressMap::const_iterator ipv6Pos = ipv6Addresses.find(instance.m_name);
+        if (ipv6Pos != ipv6Addresses.end())
+        {
+            instance.m_ipv6Address = ipv6Pos->second;
+        }
+#else
         SCX_LOGTRACE(m_log, L"NetworkInterfaceInfo::FindAll ParseIPv6Addr");
         instance.ParseIPv6Addr(deps);
+        issued.addressLookups++;
+#endif
 
 #if defined(sun)
         instance.ParseMacAddr(fd, deps);
@@ -2142,8 +2496,8 @@ std::vector<NetworkInterfaceInfo> NetworkInterfaceInfo::FindAll(SCXHandle<Networ
 #endif
 
 #if defined(linux)
-        instance.ParseHwAddr(fd, deps);
-        instance.ParseEthtool(fd, deps);
+        instance.ParseHwAddr(fd, deps, issued);
+        instance.ParseEthtool(fd, deps, issued);
 #endif
 
 #if defined(hpux)
@@ -2151,7 +2505,11 @@ std::vector<NetworkInterfaceInfo> NetworkInterfaceInfo::FindAll(SCXHandle<Networ
 #endif
 
     }
-    close(fd);
+
+    if (NULL != counters)
+    {
+        *counters = issued;
+    }
 
     SCX_LOGTRACE(m_log, L"NetworkInterfaceInfo::FindAll Setting up result list");
     std::vector<NetworkInterfaceInfo> resultList;
@@ -2178,6 +2536,29 @@ std::vector<NetworkInterfaceInfo> NetworkInterfaceInfo::FindAll(SCXHandle<Networ
     return resultList;
 }
 
+/*----------------------------------------------------------------------------*/
+//! Find the traffic statistics of all network interfaces on the machine
+//! \param[in]  deps        What this PAL depends on
+//! \param[out] counters    If not NULL, receives the number of system calls issued (where counted)
+//! \returns    Information on all interfaces but loopback, running or not; at least the name,
+//!             the traffic counters and, where available, the interface index are known
+//! \note       On Linux this is a single netlink dump, without the per-interface lookups of
+//!             FindAll(); elsewhere, or if netlink fails, it is the same as FindAll(deps, true)
+std::vector<NetworkInterfaceInfo> NetworkInterfaceInfo::FindAllStatistics(SCXHandle<NetworkInterfaceDependencies> deps,
+                                                                          NetworkInterfaceRefreshCounters *counters /*= NULL*/) {
+#if defined(linux)
+    std::vector<NetworkInterfaceInfo> interfaces;
+    NetworkInterfaceRefreshCounters issued;
+    if (FindAllUsingNetlink(interfaces, deps, L"", issued, false)) {
+        if (NULL != counters) {
+            *counters = issued;
+        }
+        return interfaces;
+    }
+#endif
+    return FindAll(deps, true, L"", counters);
+}
+
 /*----------------------------------------------------------------------------*/
 //! Construct an instance out of known information
 //! \param[in]  name    Name that identifies an interface
@@ -2246,6 +2627,9 @@ void NetworkInterfaceInfo::init()
     m_physicalAdapter     = true;
     m_speed               = 0;
     m_mtu                 = 0;
+    m_dropsReceiving      = 0;
+    m_dropsSending        = 0;
+    m_counters32Bit       = false;
 }
 }
 
@@ -28,13 +28,17 @@ namespace SCXSystemLib {
 
    \param includeNonRunning - flag determines if all of the interfaces are to be returned or only interfaces that are
                               UP or RUNNING.
+
+   The instances are updated in parallel, so an interface whose driver is slow
+   to answer only delays its own instance.
 */
 NetworkInterfaceEnumeration::NetworkInterfaceEnumeration(bool includeNonRunning)
         : m_log(SCXLogHandleFactory::GetLogHandle(
                 L"scx.core.common.pal.system.networkinterface.networkinterfaceenumeration")),
-          m_deps(new NetworkInterfaceDependencies()),
+          m_deps(new NetworkInterfaceDependencies(true)),
           m_includeNonRunning(includeNonRunning)
 {    
+    SetParallelUpdate(EntityUpdater::GetSharedPool(), EntityUpdater::c_DefaultDeadlineMs);
 }
 
 /*----------------------------------------------------------------------------*/
@@ -99,15 +103,24 @@ void NetworkInterfaceEnumeration::UpdateSpecific(wstring interface, size_t *pos)
 //! Run the Update() method on all instances in the colletion, including the
 //! Total instance if any.
 //! \note Optimized implementation that recreates the same result as running update on
-//!       each instance, but does not actually do so
+//!       each instance, but does not actually do so: all interfaces are looked up
+//!       once, and each instance picks its own information from that lookup.
+//!       With parallel update enabled, each instance looks up its own interface
+//!       instead, and GetLastUpdateCounters() keeps the counts of the latest
+//!       enumeration update.
 void NetworkInterfaceEnumeration::UpdateInstances() {
-    vector<NetworkInterfaceInfo> latestInterfaces = NetworkInterfaceInfo::FindAll(m_deps);
+    if (GetParallelUpdater() != 0) {
+        EntityEnumeration<NetworkInterfaceInstance>::UpdateInstances();
+        return;
+    }
+
+    vector<NetworkInterfaceInfo> latestInterfaces = NetworkInterfaceInfo::FindAll(m_deps, false, L"", &m_lastUpdateCounters);
     typedef map<wstring, size_t> IndexByStrMap;
     IndexByStrMap latestInterfaceById;
 
-    // Create an index of the latest instances by their id
+    // Create an index of the latest instances by their id (the id of an instance is the interface name)
     for (size_t nr = 0; nr < latestInterfaces.size(); nr++) {
-        latestInterfaceById.insert(IndexByStrMap::value_type(NetworkInterfaceInstance(latestInterfaces[nr]).GetId(), nr));
+        latestInterfaceById.insert(IndexByStrMap::value_type(latestInterfaces[nr].GetName(), nr));
     }    
     
     for (EntityIterator oldIter = Begin(); oldIter != End(); oldIter++) {
@@ -126,14 +139,14 @@ void NetworkInterfaceEnumeration::UpdateEnumeration() {
     SCX_LOGTRACE(m_log, L"SCXSystemLib::NetworkInterfaceEnumeration::UpdateEnumeration entry");
 
     SCX_LOGTRACE(m_log, L"SCXSystemLib::NetworkInterfaceEnumeration::UpdateEnumeration FindAll");
-    vector<NetworkInterfaceInfo> latestInterfaces = NetworkInterfaceInfo::FindAll(m_deps, m_includeNonRunning);
+    vector<NetworkInterfaceInfo> latestInterfaces = NetworkInterfaceInfo::FindAll(m_deps, m_includeNonRunning, L"", &m_lastUpdateCounters);
     typedef map<wstring, size_t> IndexByStrMap;
     IndexByStrMap newInterfaceById;
 
     // Prepare an index of new instances by their id
     SCX_LOGTRACE(m_log, L"SCXSystemLib::NetworkInterfaceEnumeration::UpdateEnumeration Preparing indexes");
     for (size_t nr = 0; nr < latestInterfaces.size(); nr++) {
-        newInterfaceById.insert(IndexByStrMap::value_type(NetworkInterfaceInstance(latestInterfaces[nr]).GetId(), nr));
+        newInterfaceById.insert(IndexByStrMap::value_type(latestInterfaces[nr].GetName(), nr));
     }    
     
     SCX_LOGTRACE(m_log, L"SCXSystemLib::NetworkInterfaceEnumeration::UpdateEnumeration Beginning loop");
@@ -175,7 +188,7 @@ void NetworkInterfaceEnumeration::UpdateSpecificEnumeration(wstring interface, s
 
     SCX_LOGTRACE(m_log, StrAppend(L"SCXSystemLib::NetworkInterfaceEnumeration::UpdateSpecificEnumeration Find: ", interface));
 
-    vector<NetworkInterfaceInfo> latestInterface = NetworkInterfaceInfo::FindAll(m_deps, m_includeNonRunning, interface);
+    vector<NetworkInterfaceInfo> latestInterface = NetworkInterfaceInfo::FindAll(m_deps, m_includeNonRunning, interface, &m_lastUpdateCounters);
 
     if ( latestInterface.size() >= 1 )
         GetInstance(NetworkInterfaceInstance(latestInterface[0]).GetId(), pos)->Update(latestInterface[0]);
@@ -30,11 +30,32 @@ NetworkInterfaceInstance::NetworkInterfaceInstance(const NetworkInterfaceInfo &i
     
 }
 
+/*----------------------------------------------------------------------------*/
+//! Copy constructor; the copy gets information of its own, so it can be updated
+//! while the source is read
+//! \param[in] source    Instance to copy
+NetworkInterfaceInstance::NetworkInterfaceInstance(const NetworkInterfaceInstance &source)
+        : EntityInstance(source), m_log(source.m_log), m_info(new NetworkInterfaceInfo(*source.m_info)) {
+}
+
 /*----------------------------------------------------------------------------*/
 //! Destructor
 NetworkInterfaceInstance::~NetworkInterfaceInstance() {
 }
 
+/*----------------------------------------------------------------------------*/
+//! Assignment operator; copies the information, rather than sharing it
+//! \param[in] source    Instance to copy
+//! \returns   This instance
+NetworkInterfaceInstance &NetworkInterfaceInstance::operator=(const NetworkInterfaceInstance &source) {
+    if (this != &source) {
+        EntityInstance::operator=(source);
+        m_log = source.m_log;
+        *m_info = *source.m_info;
+    }
+    return *this;
+}
+
 /*----------------------------------------------------------------------------*/
 //! Name of interface
 //! \returns Name
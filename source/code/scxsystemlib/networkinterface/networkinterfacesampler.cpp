@@ -0,0 +1,349 @@
+/*--------------------------------------------------------------------------------
+    Copyright (c) Microsoft Corporation. All rights reserved. See license.txt for license information.
+
+*/
+/**
+    \file
+
+    \brief       Background sampling of network interface traffic rates
+
+    \date        2026-10-16 20:00:00
+
+*/
+/*----------------------------------------------------------------------------*/
+
+#include <scxcorelib/scxcmn.h>
+#include <scxcorelib/scxexception.h>
+#include <scxsystemlib/networkinterfacesampler.h>
+
+#include <sys/time.h>
+#include <time.h>
+
+using namespace SCXCoreLib;
+
+namespace SCXSystemLib
+{
+    /*----------------------------------------------------------------------------*/
+    /**
+        Get a timestamp in milliseconds from a clock that is not set back or
+        forward with the time of day.
+
+        \returns   Milliseconds since some fixed point in time.
+    */
+    static scxulong GetMillisecondTimeStamp()
+    {
+#if defined(CLOCK_MONOTONIC)
+        struct timespec ts;
+        if (0 == clock_gettime(CLOCK_MONOTONIC, &ts))
+        {
+            return static_cast<scxulong>(ts.tv_sec) * 1000 + static_cast<scxulong>(ts.tv_nsec) / 1000000;
+        }
+#endif
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        return static_cast<scxulong>(tv.tv_sec) * 1000 + static_cast<scxulong>(tv.tv_usec) / 1000;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Constructor
+
+        \param[in] interfaceIndex  Index of the interface, 0 if not known.
+        \param[in] maxSamples      Samples to keep.
+    */
+    NetworkInterfaceSampler::SampledInterface::SampledInterface(unsigned int interfaceIndex, size_t maxSamples)
+        : index(interfaceIndex),
+          lastSeen(0),
+          samples(eSampledCounterCount, maxSamples)
+    {
+        for (size_t c = 0; c < eTimeStamp; c++)
+        {
+            last[c] = 0;
+            totals[c] = 0;
+        }
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Constructor
+
+        \param[in] deps        Dependencies to rely on.
+        \param[in] periodMs    Milliseconds between samples.
+        \param[in] maxSamples  Samples kept per interface; rates can be computed
+                               over at most (maxSamples - 1) * periodMs.
+    */
+    NetworkInterfaceSampler::NetworkInterfaceSampler(SCXHandle<NetworkInterfaceDependencies> deps,
+                                                     scxulong periodMs, size_t maxSamples)
+        : m_log(SCXLogHandleFactory::GetLogHandle(L"scx.core.common.pal.system.networkinterface.networkinterfacesampler")),
+          m_deps(deps),
+          m_periodMs(periodMs),
+          m_maxSamples(maxSamples),
+          m_samplerId(0),
+          m_lock(ThreadLockHandleGet()),
+          m_sampleCount(0)
+    {
+        if (0 == m_periodMs)
+        {
+            throw SCXInvalidArgumentException(L"periodMs", L"Sample period must not be zero", SCXSRCLOCATION);
+        }
+        if (m_maxSamples < 2)
+        {
+            throw SCXInvalidArgumentException(L"maxSamples", L"At least two samples are needed for a rate", SCXSRCLOCATION);
+        }
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Destructor
+
+        Stops the sampling if not shut down gracefully (by using CleanUp).
+    */
+    NetworkInterfaceSampler::~NetworkInterfaceSampler()
+    {
+        if (0 != m_samplerId)
+        {
+            CleanUp();
+        }
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Starts the sampling; the first sample is taken right away.
+    */
+    void NetworkInterfaceSampler::Init()
+    {
+        if (0 == m_samplerId)
+        {
+            NetworkInterfaceSamplerParam* p = new NetworkInterfaceSamplerParam();
+            p->m_sampler = this;
+            m_samplerId = SCXSampleScheduler::Instance().Register(
+                InterfaceSampler, SCXThreadParamHandle(p), m_periodMs);
+        }
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Stops the sampling.
+
+        Must be called before deallocating this object. Will wait for a sample
+        in progress to finish.
+    */
+    void NetworkInterfaceSampler::CleanUp()
+    {
+        if (0 != m_samplerId)
+        {
+            SCXSampleScheduler::Instance().Unregister(m_samplerId);
+            m_samplerId = 0;
+        }
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Sample the counters of all interfaces now.
+    */
+    void NetworkInterfaceSampler::Sample()
+    {
+        Sample(GetMillisecondTimeStamp());
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Sample the counters of all interfaces.
+
+        \param[in] timestampMs  Time of the sample in milliseconds; must not be
+                                earlier than that of the previous sample.
+    */
+    void NetworkInterfaceSampler::Sample(scxulong timestampMs)
+    {
+        // Look the interfaces up before locking, so a slow lookup does not hold up readers
+        NetworkInterfaceRefreshCounters counters;
+        std::vector<NetworkInterfaceInfo> interfaces = NetworkInterfaceInfo::FindAllStatistics(m_deps, &counters);
+
+        SCXThreadLock lock(m_lock);
+        m_lastSampleCounters = counters;
+        ++m_sampleCount;
+
+        for (size_t nr = 0; nr < interfaces.size(); nr++)
+        {
+            const NetworkInterfaceInfo& info = interfaces[nr];
+
+            unsigned int index = 0;
+            info.GetInterfaceIndex(index);
+
+            SCXHandle<SampledInterface>& history = m_interfaces[info.GetName()];
+            if (NULL == history || history->index != index)
+            {
+                // New, or re-created since the previous sample
+                history = SCXHandle<SampledInterface>(new SampledInterface(index, m_maxSamples));
+            }
+            history->lastSeen = m_sampleCount;
+
+            scxulong current[eTimeStamp];
+            current[eBytesReceived] = info.IsBytesReceivedKnown() ? info.GetBytesReceived() : 0;
+            current[eBytesSent] = info.IsBytesSentKnown() ? info.GetBytesSent() : 0;
+            current[ePacketsReceived] = info.IsPacketsReceivedKnown() ? info.GetPacketsReceived() : 0;
+            current[ePacketsSent] = info.IsPacketsSentKnown() ? info.GetPacketsSent() : 0;
+            current[eErrorsReceiving] = info.IsKnownIfReceiveErrors() ? info.GetErrorsReceiving() : 0;
+            current[eErrorsSending] = info.IsKnownIfSendErrors() ? info.GetErrorsSending() : 0;
+            current[eDropsReceiving] = info.IsKnownIfReceiveDrops() ? info.GetDropsReceiving() : 0;
+            current[eDropsSending] = info.IsKnownIfSendDrops() ? info.GetDropsSending() : 0;
+
+            scxulong row[eSampledCounterCount];
+            bool isFirst = 0 == history->samples.GetNumberOfSamples();
+            for (size_t c = 0; c < eTimeStamp; c++)
+            {
+                if ( ! isFirst)
+                {
+                    history->totals[c] += Advance(history->last[c], current[c], info.AreCounters32Bit());
+                }
+                history->last[c] = current[c];
+                row[c] = history->totals[c];
+            }
+            row[eTimeStamp] = timestampMs;
+            history->samples.AddSamples(row);
+        }
+
+        // Interfaces not seen in this sample are forgotten
+        for (InterfaceMap::iterator pos = m_interfaces.begin(); pos != m_interfaces.end(); )
+        {
+            if (pos->second->lastSeen != m_sampleCount)
+            {
+                m_interfaces.erase(pos++);
+            }
+            else
+            {
+                ++pos;
+            }
+        }
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Get the traffic rates of an interface.
+
+        \param[in]  name      Name of the interface.
+        \param[in]  windowMs  Time to compute the rates over. The rates cover
+                              the latest samples spanning the window, or all
+                              samples if there are not that many yet.
+        \param[out] rates     Receives the rates.
+        \returns    false if the interface has not been sampled at least twice.
+    */
+    bool NetworkInterfaceSampler::GetRates(const std::wstring& name, scxulong windowMs, NetworkInterfaceRates& rates) const
+    {
+        SCXThreadLock lock(m_lock);
+        InterfaceMap::const_iterator pos = m_interfaces.find(name);
+        if (pos == m_interfaces.end())
+        {
+            return false;
+        }
+
+        const DataSamplerArray<scxulong>& samples = pos->second->samples;
+        // A window of n periods spans n + 1 samples, and a rate needs at least two
+        size_t count = static_cast<size_t>(windowMs / m_periodMs) + 1;
+        if (count < 2)
+        {
+            count = 2;
+        }
+        scxulong elapsed = samples.GetDelta(eTimeStamp, count);
+        if (0 == elapsed)
+        {
+            return false;
+        }
+
+        double perSecond = 1000.0 / static_cast<double>(elapsed);
+        rates.windowMs = elapsed;
+        rates.bytesReceivedPerSecond = static_cast<double>(samples.GetDelta(eBytesReceived, count)) * perSecond;
+        rates.bytesSentPerSecond = static_cast<double>(samples.GetDelta(eBytesSent, count)) * perSecond;
+        rates.packetsReceivedPerSecond = static_cast<double>(samples.GetDelta(ePacketsReceived, count)) * perSecond;
+        rates.packetsSentPerSecond = static_cast<double>(samples.GetDelta(ePacketsSent, count)) * perSecond;
+        rates.errorsReceivingPerSecond = static_cast<double>(samples.GetDelta(eErrorsReceiving, count)) * perSecond;
+        rates.errorsSendingPerSecond = static_cast<double>(samples.GetDelta(eErrorsSending, count)) * perSecond;
+        rates.dropsReceivingPerSecond = static_cast<double>(samples.GetDelta(eDropsReceiving, count)) * perSecond;
+        rates.dropsSendingPerSecond = static_cast<double>(samples.GetDelta(eDropsSending, count)) * perSecond;
+        return true;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Get the names of the interfaces in the latest sample.
+
+        \returns   Interface names, in alphabetical order.
+    */
+    std::vector<std::wstring> NetworkInterfaceSampler::GetInterfaceNames() const
+    {
+        SCXThreadLock lock(m_lock);
+        std::vector<std::wstring> names;
+        names.reserve(m_interfaces.size());
+        for (InterfaceMap::const_iterator pos = m_interfaces.begin(); pos != m_interfaces.end(); ++pos)
+        {
+            names.push_back(pos->first);
+        }
+        return names;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Get the system calls issued by the latest sample.
+
+        \returns   Counters of the latest sample.
+    */
+    NetworkInterfaceRefreshCounters NetworkInterfaceSampler::GetLastSampleCounters() const
+    {
+        SCXThreadLock lock(m_lock);
+        return m_lastSampleCounters;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        The sampler body, run by the sample scheduler.
+
+        \param[in] param   NetworkInterfaceSamplerParam of the sampler.
+    */
+    void NetworkInterfaceSampler::InterfaceSampler(SCXThreadParamHandle& param)
+    {
+        NetworkInterfaceSamplerParam* p = static_cast<NetworkInterfaceSamplerParam*>(param.GetData());
+        SCXASSERT(0 != p);
+        SCXASSERT(0 != p->m_sampler);
+
+        try
+        {
+            p->m_sampler->Sample();
+        }
+        catch (const SCXException& e)
+        {
+            SCX_LOGERROR(p->m_sampler->m_log,
+                         std::wstring(L"NetworkInterfaceSampler::InterfaceSampler() - Unexpected exception caught: ").append(e.What()).append(L" - ").append(e.Where()));
+        }
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Get how much a counter has advanced since the previous sample.
+
+        \param[in] last       Previous value of the counter.
+        \param[in] current    Current value of the counter.
+        \param[in] counter32  Does the source keep the counter in 32 bits only?
+        \returns   Increase of the counter.
+
+        A counter that decreases has either wrapped or been reset (by a driver,
+        say). Only a 32-bit counter can wrap in practice, going from the upper
+        half of its range to a small value; anything else is taken as a reset,
+        after which the counter starts over from zero.
+    */
+    scxulong NetworkInterfaceSampler::Advance(scxulong last, scxulong current, bool counter32)
+    {
+        static const scxulong wrap32 = static_cast<scxulong>(1) << 32;
+
+        if (current >= last)
+        {
+            return current - last;
+        }
+        if (counter32 && last < wrap32 && last >= wrap32 / 2 && current < wrap32 / 2)
+        {
+            return wrap32 - last + current;
+        }
+        return current;
+    }
+}
+
+/*----------------------------E-N-D---O-F---F-I-L-E---------------------------*/
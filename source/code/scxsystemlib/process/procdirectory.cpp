@@ -0,0 +1,228 @@
+/*--------------------------------------------------------------------------------
+    Copyright (c) Microsoft Corporation. All rights reserved. See license.txt for license information.
+
+*/
+/**
+    \file
+
+    \brief       Reads of per-process files relative to an open /proc directory
+
+    \date        2026-10-17 00:30:00
+
+*/
+/*----------------------------------------------------------------------------*/
+
+#include <scxcorelib/scxcmn.h>
+#include <scxsystemlib/procdirectory.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#if !defined(O_CLOEXEC)
+#define O_CLOEXEC 0
+#endif
+
+using namespace SCXCoreLib;
+
+namespace SCXSystemLib
+{
+    //! Most descriptors kept open by default, however high the descriptor limit is
+    static const size_t cMaxDefaultKeptFiles = 16384;
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Constructor
+
+        Keeps at most GetDefaultMaxKeptFiles() descriptors open.
+    */
+    ProcDirectory::ProcDirectory()
+        : m_lock(ThreadLockHandleGet()),
+          m_fd(-1),
+          m_maxKeptFiles(GetDefaultMaxKeptFiles()),
+          m_keptFiles(0)
+    {
+        OpenProc();
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Constructor
+
+        \param[in] maxKeptFiles  Most descriptors to keep open; 0 to keep none.
+    */
+    ProcDirectory::ProcDirectory(size_t maxKeptFiles)
+        : m_lock(ThreadLockHandleGet()),
+          m_fd(-1),
+          m_maxKeptFiles(maxKeptFiles),
+          m_keptFiles(0)
+    {
+        OpenProc();
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Destructor
+
+        Descriptors kept open must have been released with ReleaseKeptFile().
+    */
+    ProcDirectory::~ProcDirectory()
+    {
+        if (m_fd >= 0)
+        {
+            ::close(m_fd);
+        }
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Open a file.
+
+        \param[in] dirFd  Directory to look name up in; -1 for /proc.
+        \param[in] name   Relative name of the file, such as "stat" or "1234/stat".
+        \param[in] flags  Flags besides O_RDONLY, such as O_DIRECTORY.
+        \returns   The descriptor, or -1 with errno set.
+    */
+    int ProcDirectory::Open(int dirFd, const char* name, int flags)
+    {
+        ++m_counters.opens;
+        if (dirFd < 0 && m_fd < 0)
+        {
+            // Without /proc open, fall back on the full path
+            char path[64];
+            snprintf(path, sizeof(path), "/proc/%s", name);
+            return ::open(path, O_RDONLY | O_CLOEXEC | flags);
+        }
+        return ::openat(dirFd < 0 ? m_fd : dirFd, name, O_RDONLY | O_CLOEXEC | flags);
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Read a file from its start.
+
+        \param[in]  fd      Descriptor of the file.
+        \param[out] buffer  Buffer to read into.
+        \param[in]  size    Size of the buffer.
+        \returns    Number of bytes read, or -1 with errno set.
+    */
+    ssize_t ProcDirectory::Read(int fd, char* buffer, size_t size)
+    {
+        ssize_t bytes;
+        do
+        {
+            ++m_counters.reads;
+            bytes = ::pread(fd, buffer, size, 0);
+        } while (bytes < 0 && EINTR == errno);
+        return bytes;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Close a descriptor returned by Open() that was not kept open.
+
+        \param[in] fd  The descriptor.
+    */
+    void ProcDirectory::Close(int fd)
+    {
+        ++m_counters.closes;
+        ::close(fd);
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Get the status of a file.
+
+        \param[in]  dirFd  Directory to look name up in; -1 for /proc.
+        \param[in]  name   Relative name of the file; empty for dirFd itself.
+        \param[out] st     Receives the status.
+        \returns    0, or -1 with errno set.
+    */
+    int ProcDirectory::Stat(int dirFd, const char* name, struct stat* st)
+    {
+        ++m_counters.stats;
+        if ('\0' == name[0] && dirFd >= 0)
+        {
+            return ::fstat(dirFd, st);
+        }
+        if (dirFd < 0 && m_fd < 0)
+        {
+            char path[64];
+            snprintf(path, sizeof(path), "/proc/%s", name);
+            return ::stat(path, st);
+        }
+        return ::fstatat(dirFd < 0 ? m_fd : dirFd, name, st, 0);
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Reserve room in the budget for a descriptor to keep open.
+
+        \returns   false if the budget is used up.
+    */
+    bool ProcDirectory::ReserveKeptFile()
+    {
+        SCXThreadLock lock(m_lock);
+        if (m_keptFiles >= m_maxKeptFiles)
+        {
+            return false;
+        }
+        ++m_keptFiles;
+        return true;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Give back room reserved with ReserveKeptFile(), closing the
+        descriptor kept open in it.
+
+        \param[in] fd  The descriptor; -1 if none was opened.
+
+        The close is not counted, since descriptors are closed from whatever
+        thread drops the last reference to a process.
+    */
+    void ProcDirectory::ReleaseKeptFile(int fd)
+    {
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+        SCXThreadLock lock(m_lock);
+        --m_keptFiles;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Get the default budget of descriptors kept open.
+
+        \returns   A quarter of the soft RLIMIT_NOFILE limit, but no more than
+                   cMaxDefaultKeptFiles.
+    */
+    size_t ProcDirectory::GetDefaultMaxKeptFiles()
+    {
+        struct rlimit limit;
+        if (getrlimit(RLIMIT_NOFILE, &limit) != 0)
+        {
+            // Assume the usual limit of 1024
+            return 256;
+        }
+        if (RLIM_INFINITY == limit.rlim_cur || limit.rlim_cur / 4 >= cMaxDefaultKeptFiles)
+        {
+            return cMaxDefaultKeptFiles;
+        }
+        return static_cast<size_t>(limit.rlim_cur / 4);
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Open /proc. If it cannot be opened, files are looked up by full path.
+    */
+    void ProcDirectory::OpenProc()
+    {
+        m_fd = ::open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    }
+}
+
+/*----------------------------E-N-D---O-F---F-I-L-E---------------------------*/
@@ -0,0 +1,176 @@
+/*--------------------------------------------------------------------------------
+    Copyright (c) Microsoft Corporation. All rights reserved. See license.txt for license information.
+
+*/
+/**
+    \file
+
+    \brief       Shared pool of process command lines
+
+    \date        2026-10-16 23:00:00
+
+*/
+/*----------------------------------------------------------------------------*/
+
+#include <scxcorelib/scxcmn.h>
+#include <scxcorelib/scxassert.h>
+#include <scxcorelib/scxdumpstring.h>
+#include <scxsystemlib/processcommandlinepool.h>
+
+#include <string.h>
+
+using namespace SCXCoreLib;
+
+namespace SCXCoreLib
+{
+    SCXSingleton_Allocate(SCXSystemLib::ProcessCommandLinePool);
+}
+
+namespace SCXSystemLib
+{
+    /*----------------------------------------------------------------------------*/
+    /**
+        Default constructor.
+
+        Normally the pool is used through Instance(); separate instances are
+        allowed for unit tests.
+    */
+    ProcessCommandLinePool::ProcessCommandLinePool()
+        : m_lock(ThreadLockHandleGet()),
+          m_userCount(0)
+    {
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Virtual destructor.
+    */
+    ProcessCommandLinePool::~ProcessCommandLinePool()
+    {
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Dump object as string (for logging).
+
+        \returns     The object represented as a string suitable for logging.
+    */
+    const std::wstring ProcessCommandLinePool::DumpString() const
+    {
+        SCXThreadLock lock(m_lock);
+        return SCXDumpStringBuilder("ProcessCommandLinePool")
+            .Scalar("CommandLines", m_entries.size())
+            .Scalar("Users", m_userCount);
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Get the shared copy of a command line in the format of /proc/#/cmdline.
+
+        \param[in] data    The arguments, separated by NULs.
+        \param[in] length  Number of bytes of data.
+        \returns   The interned command line, or NULL if there are no arguments.
+                   Must be given back with Release() when no longer used.
+
+        An empty argument after the first one ends the command line, as does
+        the end of data; the last argument need not be terminated.
+    */
+    const ProcessCommandLinePool::CommandLine* ProcessCommandLinePool::Acquire(const char* data, size_t length)
+    {
+        CommandLine args;
+        const char* pos = data;
+        const char* end = data + length;
+        while (pos < end)
+        {
+            const char* nul = static_cast<const char*>(memchr(pos, '\0', static_cast<size_t>(end - pos)));
+            const char* argEnd = NULL != nul ? nul : end;
+            if (argEnd == pos && !args.empty())
+            {
+                break;
+            }
+            args.push_back(std::string(pos, argEnd));
+            pos = NULL != nul ? nul + 1 : end;
+        }
+        return Acquire(args);
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Get the shared copy of a command line.
+
+        \param[in] args  Arguments of the command line.
+        \returns   The interned command line, or NULL if there are no arguments.
+                   Must be given back with Release() when no longer used.
+    */
+    const ProcessCommandLinePool::CommandLine* ProcessCommandLinePool::Acquire(const CommandLine& args)
+    {
+        if (args.empty())
+        {
+            return NULL;
+        }
+
+        // Each distinct command line is stored once, as the key of its entry
+        SCXThreadLock lock(m_lock);
+        EntryMap::iterator pos = m_entries.find(args);
+        if (pos == m_entries.end())
+        {
+            pos = m_entries.insert(EntryMap::value_type(args, 0)).first;
+        }
+        ++pos->second;
+        ++m_userCount;
+        return &pos->first;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Give back a command line returned by Acquire().
+
+        \param[in] cmdLine  The command line; NULL is ignored.
+    */
+    void ProcessCommandLinePool::Release(const CommandLine* cmdLine)
+    {
+        if (NULL == cmdLine)
+        {
+            return;
+        }
+
+        // The entry cannot go away while we are one of its users
+        SCXThreadLock lock(m_lock);
+        EntryMap::iterator pos = m_entries.find(*cmdLine);
+        SCXASSERT(pos != m_entries.end() && &pos->first == cmdLine);
+        if (pos != m_entries.end())
+        {
+            --m_userCount;
+            if (0 == --pos->second)
+            {
+                m_entries.erase(pos);
+            }
+        }
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Get the number of distinct command lines in the pool.
+
+        \returns    Number of interned command lines.
+    */
+    size_t ProcessCommandLinePool::GetCount() const
+    {
+        SCXThreadLock lock(m_lock);
+        return m_entries.size();
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Get the number of command lines handed out and not yet released.
+
+        \returns    Number of users of the interned command lines.
+    */
+    size_t ProcessCommandLinePool::GetUserCount() const
+    {
+        SCXThreadLock lock(m_lock);
+        return m_userCount;
+    }
+}
+
+/*----------------------------E-N-D---O-F---F-I-L-E---------------------------*/
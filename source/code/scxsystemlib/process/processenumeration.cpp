@@ -22,6 +22,7 @@
 #include <scxsystemlib/processenumeration.h>
 #include <scxsystemlib/processinstance.h>
 
+#include <algorithm>
 #include <unistd.h>
 #include <vector>
 
@@ -36,12 +37,10 @@ namespace SCXSystemLib
 
     /*----------------------------------------------------------------------------*/
     /**
-       Class that represents values passed between the threads of the process instance.
+       Class that represents values passed to the sampler of the process enumeration.
 
-       Representation of values passed between the threads of the process instance.
-
-       I really don't know why we have this class, but all our pals have it so we'd
-       better have it too or be outcasts.
+       Besides the enumeration, it keeps the state used to throttle error logging
+       across consecutive samples.
     */
     class ProcessEnumerationThreadParam : public SCXThreadParam
     {
@@ -50,26 +49,114 @@ namespace SCXSystemLib
         /**
            Constructor
 
-           \param[in] processenum Pointer to process enumeration associated with the thread.
+           \param[in] processenum Pointer to process enumeration associated with the sampler.
         */
         ProcessEnumerationThreadParam(ProcessEnumeration *processenum)
-            : SCXThreadParam(), m_processEnum(processenum)
+            : SCXThreadParam(), m_processEnum(processenum),
+              m_countup(0), m_countdown(3), m_logsev(eError)
         {}
 
         /*----------------------------------------------------------------------------*/
         /**
            Retrieves the process enumeration parameter.
 
-           \returns Pointer to process enumeration associated with the thread.
+           \returns Pointer to process enumeration associated with the sampler.
         */
         ProcessEnumeration* GetProcessEnumeration()
         {
             return m_processEnum;
         }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+           Records a sample that succeeded.
+
+           After 10 consecutive good samples, errors are logged as errors again.
+        */
+        void SampleSucceeded()
+        {
+            if (m_countup > 9)
+            {
+                m_countdown = 3;
+                m_logsev = eError;
+            }
+            else
+            {
+                m_countup++;
+            }
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+           Records a sample that failed.
+
+           \returns Log level to use when logging the failure.
+
+           After 3 consecutive failures, further failures are only traced.
+        */
+        SCXLogSeverity SampleFailed()
+        {
+            m_countup = 0;
+            if (m_countdown > 0)
+            {
+                --m_countdown;
+            }
+            else
+            {
+                m_logsev = eTrace;
+            }
+            return m_logsev;
+        }
+
+    private:
+        ProcessEnumeration* m_processEnum; //!< Pointer to process enumeration associated with the sampler.
+        int m_countup;          //!< Consequtive number of good enumerations
+        int m_countdown;        //!< Consequtive number of exceptions before stop logging errors
+        SCXLogSeverity m_logsev; //!< Log level to use when logging sampling exceptions
+    };
+
+    /*----------------------------------------------------------------------------*/
+    /**
+       Orders process metrics for the bounded heap of ProcessEnumeration::TopN().
+    */
+    class ProcessMetricsRanking
+    {
+    public:
+        /**
+           Constructor
+
+           \param[in] key What to rank by.
+        */
+        ProcessMetricsRanking(ProcessRankKey key) : m_key(key) {}
+
+        /**
+           \returns true if a ranks higher than b
+        */
+        bool operator()(const ProcessMetrics& a, const ProcessMetrics& b) const
+        {
+            return ProcessEnumeration::RanksHigher(a, b, m_key);
+        }
+
     private:
-        ProcessEnumeration* m_processEnum; //!< Pointer to process enumeration associated with the thread.
+        ProcessRankKey m_key;   //!< What to rank by
     };
 
+    /**
+       Compares two rates given as counts over intervals, without dividing.
+
+       \returns Negative, zero or positive as the first rate is lower than,
+                equal to or higher than the second. A rate over an empty
+                interval is zero.
+    */
+    static int CompareRates(scxulong aCount, scxulong aInterval, scxulong bCount, scxulong bInterval)
+    {
+        if (0 == aInterval) { aCount = 0; aInterval = 1; }
+        if (0 == bInterval) { bCount = 0; bInterval = 1; }
+        scxulong a = aCount * bInterval;
+        scxulong b = bCount * aInterval;
+        return a < b ? -1 : (a > b ? 1 : 0);
+    }
+
     /*==================================================================================*/
 
     /**
@@ -78,7 +165,14 @@ namespace SCXSystemLib
     ProcessEnumeration::ProcessEnumeration()
         : EntityEnumeration<ProcessInstance>(),
           m_lock(SCXCoreLib::ThreadLockHandleGet()),
-          m_dataAquisitionThread(0),
+          m_samplerId(0),
+          m_incrementalSampling(false),
+          m_ioStatistics(false),
+          m_staticRefreshCount(0),
+          m_replacedCount(0),
+#if defined(linux)
+          m_procDir(new ProcDirectory()),
+#endif
           m_EnumErrorCount(0),
           m_EnumGoodCount(0),
           m_EnumLogLevel(eError)
@@ -91,20 +185,16 @@ namespace SCXSystemLib
     /*----------------------------------------------------------------------------*/
     /**
        Destructor. This destructor must remove the elements from various
-       containers that have elements that are pointers to classes. Also kills
-       the sampler thread hard if not shut down gracefully (by using CleanUp).
+       containers that have elements that are pointers to classes. Also stops
+       the sampling if not shut down gracefully (by using CleanUp).
     */
     ProcessEnumeration::~ProcessEnumeration()
     {
         SCX_LOGTRACE(m_log, L"ProcessEnumeration::~ProcessEnumeration()");
 
-        if (0 != m_dataAquisitionThread)
+        if (0 != m_samplerId)
         {
-            if (m_dataAquisitionThread->IsAlive())
-            {
-                CleanUp();
-            }
-            m_dataAquisitionThread = 0;
+            CleanUp();
         }
 
         // Remove these pointers so that we don't try to delete them twice
@@ -115,7 +205,7 @@ namespace SCXSystemLib
 
     /*----------------------------------------------------------------------------*/
     /**
-       Starts collection thread which creates process instances.
+       Starts periodic collection which creates process instances.
     */
     void ProcessEnumeration::Init()
     {
@@ -124,11 +214,12 @@ namespace SCXSystemLib
         // There is no total instance
         SetTotalInstance(SCXCoreLib::SCXHandle<ProcessInstance>(0));
 
-        // Start collection thread.
-        if (NULL == m_dataAquisitionThread)
+        // Start periodic collection.
+        if (0 == m_samplerId)
         {
-            ProcessEnumerationThreadParam* params = new ProcessEnumerationThreadParam(this);
-            m_dataAquisitionThread = new SCXCoreLib::SCXThread(ProcessEnumeration::DataAquisitionThreadBody, params);
+            SCXCoreLib::SCXThreadParamHandle params(new ProcessEnumerationThreadParam(this));
+            m_samplerId = SCXCoreLib::SCXSampleScheduler::Instance().Register(
+                ProcessEnumeration::DataAquisitionSampleBody, params, PROCESS_SECONDS_PER_SAMPLE * 1000);
         }
         SCXCoreLib::SCXThread::Sleep(500);      // Give us some time to start up
     }
@@ -137,16 +228,16 @@ namespace SCXSystemLib
     /**
        Release the resources allocated.
 
-       Must be called before deallocating this object. Will wait when stopping
-       the sampler thread.
+       Must be called before deallocating this object. Will wait for a sample
+       in progress to finish.
 
     */
     void ProcessEnumeration::CleanUp()
     {
-        if (0 != m_dataAquisitionThread)
+        if (0 != m_samplerId)
         {
-            m_dataAquisitionThread->RequestTerminate();
-            m_dataAquisitionThread->Wait();
+            SCXCoreLib::SCXSampleScheduler::Instance().Unregister(m_samplerId);
+            m_samplerId = 0;
         }
     }
     /*----------------------------------------------------------------------------*/
@@ -266,25 +357,25 @@ namespace SCXSystemLib
     }
 
     /*=============================================================================*/
-    /* Only code that run in local thread beyond this point.                       */
+    /* Only code that run in the sampler beyond this point.                        */
     /*=============================================================================*/
 
     /**
-       Thread body for local updater thread.
+       Sampler body, run by the sample scheduler.
 
        \param  param Must contain a parameter named "ParamValues" of type ProcessEnumerationThreadParam*
 
-       This is a loop that runs continiously until the process enumeration
-       goes out of scope.  It lists the processes at a regular interval,
-       tests if these processes correspond to those we already know about.
+       This runs at a regular interval until the process enumeration is
+       cleaned up.  It lists the processes, tests if these processes
+       correspond to those we already know about.
        If a new process is found it's added to the list. If there exists an
        old process in out internal list that doesen't exists in the system
        list, that process is moved to a special list of dead processes.
     */
-    void ProcessEnumeration::DataAquisitionThreadBody(SCXCoreLib::SCXThreadParamHandle& param)
+    void ProcessEnumeration::DataAquisitionSampleBody(SCXCoreLib::SCXThreadParamHandle& param)
     {
         SCXLogHandle log = SCXLogHandleFactory::GetLogHandle(moduleIdentifier);
-        SCX_LOGTRACE(log, L"ProcessEnumeration::DataAquisitionThreadBody()");
+        SCX_LOGHYSTERICAL(log, L"ProcessEnumeration::DataAquisitionSampleBody()");
 
         ProcessEnumerationThreadParam* p = static_cast<ProcessEnumerationThreadParam*>(param.GetData());
         SCXASSERT(0 != p);
@@ -292,58 +383,12 @@ namespace SCXSystemLib
         ProcessEnumeration *processEnum = p->GetProcessEnumeration();
         SCXASSERT(0 != processEnum);
 
-        int countup = 0;        // Consequtive number of good enumerations
-        int countdown = 3;      // Consequtive number of exceptions before stop logging errors
-        bool bUpdate = true;
-        SCXLogSeverity logsev = eError;
-
-        p->m_cond.SetSleep(PROCESS_SECONDS_PER_SAMPLE * 1000);
-        {
-            SCXConditionHandle h(p->m_cond);
-            while( ! p->GetTerminateFlag() )
-            {
-                // Be sure to update the first time through
-                if ( bUpdate )
-                {
-                    try {
-                        processEnum->SampleData();
-                        SCX_LOGHYSTERICAL(log, L"ProcessEnumeration DataAquisition - Sleep ");
-                        // If we have had 10 consecutive enumerations without problems, reset 
-                        // number of allowed consecutive error logs and set log severity to Error
-                        if (countup > 9)
-                        {
-                            countdown = 3;
-                            logsev = eError;
-                        }
-                        else
-                        {
-                            countup++;
-                        }
-                    } catch (SCXException& e) {
-                        countup = 0;
-                        // If we have had all allowed consecutive error logs set log severity to Trace
-                        if (countdown > 0)
-                        {
-                            --countdown;
-                        }
-                        else
-                        {
-                            logsev = eTrace;
-                        }
-                        SCX_LOG(log, logsev, e.Where() + L" : " + e.What());
-                    }
-                    bUpdate = false;
-                }
-
-                enum SCXCondition::eConditionResult r = h.Wait();
-                if (SCXCondition::eCondTimeout == r)
-                {
-                    bUpdate = true;
-                }
-            }
+        try {
+            processEnum->SampleData();
+            p->SampleSucceeded();
+        } catch (SCXException& e) {
+            SCX_LOG(log, p->SampleFailed(), e.Where() + L" : " + e.What());
         }
-
-        SCX_LOGHYSTERICAL(log, L"ProcessEnumeration DataAquisition - Ending ");
     }
 
     /**
@@ -351,6 +396,10 @@ namespace SCXSystemLib
        This method is run at a regular interval and updates existing process instances
        according to the system view. Newly created processes are added to the list
        of instances.
+
+       In incremental mode (see SetIncrementalSampling()), processes that were
+       seen in the previous sample only have their counters re-read; static
+       attributes are re-read when the process appears to have changed.
     */
     void ProcessEnumeration::SampleData()
     {
@@ -367,28 +416,55 @@ namespace SCXSystemLib
 
         /* Compute real time once to save some time. */
         gettimeofday(&realtime, 0);
+#if defined(linux)
+        m_procDir->ResetCounters();
+#endif
+
+        /* Processes are usually listed in pid order, so the entry following the
+           previous one is tried before searching the map. It is also where a
+           new process goes. */
+        ProcMap::iterator next = m_procs.begin();
 
         /* Walk through process iterator to see all live processes */
         while (pl.nextProc()) {
 
             pid = pl.getPid();
             /* Look for pid in process map */
-            pos = m_procs.find(pid);
+            if (next == m_procs.end() || next->first != pid) {
+                next = m_procs.lower_bound(pid);
+            }
+            pos = m_procs.end();
+            if (next != m_procs.end() && next->first == pid) {
+                pos = next++;
+            }
 
             try 
             {
                 if (pos != m_procs.end()) {
                     /* If it was found, update it and mark it as found. */
-                    bool stillExists = pos->second->UpdateInstance(pl.getHandle(), false);
-                    if (!stillExists) { continue; } // Died before or during UpdateInstance()
-                    pos->second->UpdateDataSampler(realtime);
-                } else {
+                    bool stillExists = UpdateKnownInstance(pos, pl.getHandle());
+                    if (!stillExists) { continue; } // Died before or during update
+                    if (pos != m_procs.end()) {
+                        pos->second->UpdateDataSampler(realtime);
+#if defined(linux)
+                        pos->second->UpdateIoSampler(realtime, m_ioStatistics);
+#endif
+                    }
+                }
+                if (pos == m_procs.end()) {
                     /* If it wasn't found, add it. */
+#if defined(linux)
+                    SCXCoreLib::SCXHandle<ProcessInstance> inst( new ProcessInstance(pid, pl.getHandle(), m_procDir) );
+#else
                     SCXCoreLib::SCXHandle<ProcessInstance> inst( new ProcessInstance(pid, pl.getHandle()) );
+#endif
                     bool stillExists = inst->UpdateInstance(pl.getHandle(), true);
                     if (!stillExists) { continue; } // Already gone. Not added.
                     inst->UpdateDataSampler(realtime);
-                    m_procs.insert(std::make_pair(pid, inst));
+#if defined(linux)
+                    inst->UpdateIoSampler(realtime, m_ioStatistics);
+#endif
+                    m_procs.insert(next, std::make_pair(pid, inst));
                 }
             } catch (SCXException& e) {
                 goterror = true;
@@ -436,8 +512,131 @@ namespace SCXSystemLib
                 ++pi;
             }
         }
+#if defined(linux)
+        m_lastSampleCounters = m_procDir->GetCounters();
+#endif
     }
 
+    /**
+       Updates an instance that was present in the previous sample.
+
+       \param[in,out] pos      Position of the instance in the process map. Set to
+                               the end of the map if the instance was discarded
+                               because its pid now belongs to another process.
+       \param[in]     handle   Platform specific handle from the process lister
+       \returns       false if the process died before or during the update
+    */
+#if defined(linux) || defined(sun)
+    bool ProcessEnumeration::UpdateKnownInstance(ProcMap::iterator& pos, const char* handle)
+#elif defined(aix)
+    bool ProcessEnumeration::UpdateKnownInstance(ProcMap::iterator& pos, struct procentry64* handle)
+#elif defined(hpux)
+    bool ProcessEnumeration::UpdateKnownInstance(ProcMap::iterator& pos, struct pst_status* handle)
+#endif
+    {
+#if defined(linux)
+        if (m_incrementalSampling)
+        {
+            switch (pos->second->UpdateInstanceIncremental())
+            {
+            case ProcessInstance::eProcessGone:
+                return false;
+            case ProcessInstance::eProcessReplaced:
+                // Same pid, different process; start over with a new instance
+                SCX_LOGHYSTERICAL(m_log, StrAppend(L"Pid reused: ", pos->first));
+                ++m_replacedCount;
+                m_procs.erase(pos);
+                pos = m_procs.end();
+                return true;
+            case ProcessInstance::eStaticAttributesUpdated:
+                ++m_staticRefreshCount;
+                return true;
+            case ProcessInstance::eCountersUpdated:
+                return true;
+            }
+        }
+#endif
+        return pos->second->UpdateInstance(handle, false);
+    }
+
+    /**
+       Selects incremental sampling of processes.
+
+       \param[in] incremental  true to re-read only counters of known processes
+
+       In incremental mode, a process that was seen in the previous sample only
+       has its counters (/proc/#/stat and /proc/#/statm) re-read. The real UID
+       and the command line are re-read when the command name or the owner of
+       /proc/# changes, or every PROCESS_STATIC_REFRESH_SAMPLES samples. Reuse
+       of a pid is detected through the process start time.
+
+       Only Linux supports incremental sampling; on other platforms the mode
+       is recorded but every process is fully re-read.
+    */
+    void ProcessEnumeration::SetIncrementalSampling(bool incremental)
+    {
+        SCXCoreLib::SCXThreadLock lock(m_lock);
+        m_incrementalSampling = incremental;
+    }
+
+    /**
+       Tests if incremental sampling is selected.
+
+       \returns true if incremental sampling is selected
+    */
+    bool ProcessEnumeration::GetIncrementalSampling() const
+    {
+        return m_incrementalSampling;
+    }
+
+    /**
+       Selects sampling of I/O and scheduler statistics of processes.
+
+       \param[in] sample  true to sample the statistics
+
+       When selected, each sample also reads /proc/#/io and /proc/#/schedstat
+       of every process, which makes ProcessInstance::GetBlockReadsPerSecond()
+       and related methods known. When not selected (the default), these files
+       are not read and no memory is kept for their samples; turning sampling
+       off releases the samples already taken.
+
+       Only Linux supports these statistics; on other platforms the mode is
+       recorded but has no effect.
+    */
+    void ProcessEnumeration::SetIoStatistics(bool sample)
+    {
+        SCXCoreLib::SCXThreadLock lock(m_lock);
+        m_ioStatistics = sample;
+    }
+
+    /**
+       Tests if I/O and scheduler statistics are sampled.
+
+       \returns true if the statistics are sampled
+    */
+    bool ProcessEnumeration::GetIoStatistics() const
+    {
+        SCXCoreLib::SCXThreadLock lock(m_lock);
+        return m_ioStatistics;
+    }
+
+#if defined(linux)
+    /**
+       Gets the system calls issued to read files under /proc by the latest
+       SampleData(), not counting the listing of /proc itself.
+
+       \returns Counters of the latest sample
+
+       Divided by the number of processes, this is the cost of sampling a
+       process. Files that are kept open make it smaller; see ProcDirectory.
+    */
+    ProcReadCounters ProcessEnumeration::GetLastSampleCounters() const
+    {
+        SCXCoreLib::SCXThreadLock lock(m_lock);
+        return m_lastSampleCounters;
+    }
+#endif
+
     /**
        Finds a process based on its pid.
 
@@ -490,6 +689,87 @@ namespace SCXSystemLib
         return retval;
     }
 
+    /**
+       Finds the processes that rank highest by some measure.
+
+       \param   n       Number of processes to return
+       \param   key     What to rank by
+       \returns Up to n process instances, highest ranking first. Ties are
+                broken by lowest pid.
+
+       Only the compact ProcessMetrics of each process are looked at, and only
+       the n best are kept, in a heap, so this takes O(p log n) for p
+       processes. The instance list of the enumeration is left alone; only
+       the returned instances have UpdateTimedValues() run, so their getters
+       are ready for use.
+
+       \note The returned process instances are guaranteed to be valid only
+       until the next time that SampleData() runs; see Find().
+     */
+    std::vector<SCXCoreLib::SCXHandle<ProcessInstance> > ProcessEnumeration::TopN(size_t n, ProcessRankKey key)
+    {
+        SCXCoreLib::SCXThreadLock lock(m_lock);
+
+        ProcessMetricsRanking ranking(key);
+        std::vector<ProcessMetrics> heap;
+        heap.reserve(std::min(n, m_procs.size()));
+
+        // The front of the heap is the lowest ranking of the processes kept
+        ProcessMetrics metrics;
+        for (ProcMap::const_iterator pi = m_procs.begin(); pi != m_procs.end() && 0 != n; ++pi)
+        {
+            pi->second->GetMetrics(metrics);
+            if (heap.size() < n)
+            {
+                heap.push_back(metrics);
+                std::push_heap(heap.begin(), heap.end(), ranking);
+            }
+            else if (ranking(metrics, heap.front()))
+            {
+                std::pop_heap(heap.begin(), heap.end(), ranking);
+                heap.back() = metrics;
+                std::push_heap(heap.begin(), heap.end(), ranking);
+            }
+        }
+        std::sort_heap(heap.begin(), heap.end(), ranking);
+
+        std::vector<SCXCoreLib::SCXHandle<ProcessInstance> > top;
+        top.reserve(heap.size());
+        for (size_t i = 0; i < heap.size(); i++)
+        {
+            SCXCoreLib::SCXHandle<ProcessInstance> inst = m_procs.find(heap[i].pid)->second;
+            inst->UpdateTimedValues();
+            top.push_back(inst);
+        }
+        return top;
+    }
+
+    /**
+       Tests if a process ranks higher than another.
+
+       \param   a       Metrics of a process
+       \param   b       Metrics of another process
+       \param   key     What to rank by
+       \returns true if a ranks higher than b by key, or the same with a lower pid
+     */
+    bool ProcessEnumeration::RanksHigher(const ProcessMetrics& a, const ProcessMetrics& b, ProcessRankKey key)
+    {
+        int order = 0;
+        switch (key)
+        {
+        case eRankByCPUTime:
+            order = CompareRates(a.cpuTime, a.interval, b.cpuTime, b.interval);
+            break;
+        case eRankByUsedMemory:
+            order = a.usedMemory < b.usedMemory ? -1 : (a.usedMemory > b.usedMemory ? 1 : 0);
+            break;
+        case eRankByHardPageFaults:
+            order = CompareRates(a.hardPageFaults, a.interval, b.hardPageFaults, b.interval);
+            break;
+        }
+        return order > 0 || (0 == order && a.pid < b.pid);
+    }
+
     /**
        Sends a signal (i.e. the POSIX kill() call) to one or more processes
        that has a certain name.
@@ -22,6 +22,7 @@
 #if defined(linux)
 #include <stdio.h>
 #include <sys/stat.h>
+#include <fcntl.h>
 #include <pwd.h>
 #endif
 
@@ -46,6 +47,7 @@
 #include <scxcorelib/scxfile.h>
 #include <scxcorelib/logsuppressor.h>
 #include <scxcorelib/stringaid.h>
+#include <scxcorelib/scxusercache.h>
 
 #include <scxsystemlib/processinstance.h>
 #include <scxsystemlib/scxsysteminfo.h>
@@ -72,6 +74,18 @@ namespace SCXSystemLib
 {
     const wchar_t *ProcessInstance::moduleIdentifier = L"scx.core.common.pal.system.process.processinstance";
 
+    /**
+       Gets the log handle of process instances.
+
+       \returns Log handle shared by all instances, so that each instance
+                does not make its own copy of the module name.
+    */
+    const SCXLogHandle& ProcessInstance::GetInstanceLogHandle()
+    {
+        static SCXLogHandle s_log = SCXLogHandleFactory::GetLogHandle(moduleIdentifier);
+        return s_log;
+    }
+
     /** Semi-secret flag to bypass checking for root access.
         It enables us to call functions that would otherwise cast an
         exception, but will on the other hand make them return dummy values.
@@ -139,132 +153,245 @@ namespace SCXSystemLib
         }
     }
 
-    /** Format for scanf() when reading /proc/#/stat. */
-    const char *LinuxProcStat::scanstring =
-    " %c %d %d %d %d %d %lu %lu "                        // 3 to 10
-    "%lu %lu %lu %lu %lu %ld %ld %ld %ld %*ld "         // 11 to 20
-    "%ld %lu %lu %ld %lu %lu %lu %lu %lu %lu "          // 21 to 30
-    "%lu %lu %lu %lu %lu %lu %lu %d %d %lu %lu";        // 31 to 41
-
     /**
-     * Reads the /proc/#/stat file.
-     *
-     * \param filePointer File pointer to an open file.
-     * \param filename    Name of the file
-     * \returns true if the file was successfully read, or false if it was deleted already
-     *
-     */
-    bool LinuxProcStat::ReadStatFile(FILE *filePointer, const char* filename)
+       Sequential reader of the whitespace separated numeric fields in a
+       /proc/# file.
+
+       Works directly on the narrow buffer the file was read into; parsing
+       never allocates. Numbers follow the scanf() conventions that were
+       used previously: optional sign, decimal digits, unsigned values wrap
+       if negative.
+    */
+    class ProcFieldParser
     {
-        // We used to parse by reading bytes, but this can be problematic if
-        // process names contain "(" or ")" (which was found on SuSE 12).
-        //
-        // Read the entire thing into a buffer and use sscanf to parse it.
-        // This allows us to search for "(" (start of process name), and
-        // reverse search for ")" (end of process name), and not care what
-        // is in the middle.
+    public:
+        /**
+           Constructor
 
-        char buffer[1024];
-        int nscanned = (int) fread(&buffer[0], 1, sizeof(buffer), filePointer);
-
-        // Test if the file was deleted before we had a chance to read it.
-        // This can happen on RedHat, but not on Suse10.
-        // On Suse10 the fscanf will return normally, but all values are 0.
-        if (ferror(filePointer)) {
-            if (errno == ESRCH) {
-              // Race condition. This is ok.
-              return false;
+           \param begin Start of the text to parse
+           \param end   One past the end of the text to parse
+        */
+        ProcFieldParser(const char* begin, const char* end) : m_pos(begin), m_end(end), m_parsed(0) {}
+
+        /** \returns Number of fields successfully parsed so far */
+        int Parsed() const { return m_parsed; }
+
+        /**
+           Parses a single non-blank character.
+           \param[out] value Character read
+           \returns true if a field was found
+        */
+        bool Next(char& value)
+        {
+            SkipBlanks();
+            if (m_pos == m_end)
+            {
+                return false;
             }
-            int eno = errno;
-            throw SCXErrnoException(L"fread", eno, SCXSRCLOCATION);
+            value = *m_pos++;
+            ++m_parsed;
+            return true;
         }
 
-        // Less than 32 bytes read; that's not possible unless something is really wrong
-        if (nscanned < 32) {
-            int eno = errno;
+        /**
+           Parses a signed decimal field.
+           \param[out] value Value read
+           \returns true if a field was found
+        */
+        bool Next(long& value)
+        {
+            bool negative = false;
+            unsigned long magnitude = 0;
+            if (!ParseNumber(negative, magnitude))
+            {
+                return false;
+            }
+            value = negative ? -static_cast<long>(magnitude) : static_cast<long>(magnitude);
+            return true;
+        }
+
+        /**
+           Parses an unsigned decimal field.
+           \param[out] value Value read
+           \returns true if a field was found
+        */
+        bool Next(unsigned long& value)
+        {
+            bool negative = false;
+            unsigned long magnitude = 0;
+            if (!ParseNumber(negative, magnitude))
+            {
+                return false;
+            }
+            value = negative ? 0 - magnitude : magnitude;
+            return true;
+        }
+
+        /**
+           Parses a signed decimal field into an int.
+           \param[out] value Value read
+           \returns true if a field was found
+        */
+        bool Next(int& value)
+        {
+            long l = 0;
+            if (!Next(l))
+            {
+                return false;
+            }
+            value = static_cast<int>(l);
+            return true;
+        }
+
+        /**
+           Skips a field without storing it (and without counting it).
+           \returns true if a field was found
+        */
+        bool Skip()
+        {
+            long dummy = 0;
+            if (!Next(dummy))
+            {
+                return false;
+            }
+            --m_parsed;
+            return true;
+        }
+
+    private:
+        void SkipBlanks()
+        {
+            while (m_pos != m_end && (*m_pos == ' ' || *m_pos == '\t' || *m_pos == '\n'))
+            {
+                ++m_pos;
+            }
+        }
 
+        bool ParseNumber(bool& negative, unsigned long& magnitude)
+        {
+            SkipBlanks();
+            negative = false;
+            if (m_pos != m_end && (*m_pos == '-' || *m_pos == '+'))
+            {
+                negative = (*m_pos == '-');
+                ++m_pos;
+            }
+            const char* digits = m_pos;
+            magnitude = 0;
+            while (m_pos != m_end && *m_pos >= '0' && *m_pos <= '9')
+            {
+                magnitude = magnitude * 10 + static_cast<unsigned long>(*m_pos - '0');
+                ++m_pos;
+            }
+            if (m_pos == digits)
+            {
+                return false;
+            }
+            ++m_parsed;
+            return true;
+        }
+
+        const char* m_pos;      //!< Current parse position
+        const char* m_end;      //!< End of the text
+        int m_parsed;           //!< Number of fields parsed
+    };
+
+    /**
+     * Parses the contents of a /proc/#/stat file.
+     *
+     * \param buffer   Contents of the file (need not be NUL terminated)
+     * \param length   Number of bytes in buffer
+     * \param filename Name of the file (for error messages)
+     * \returns true if the contents was successfully parsed
+     * \throws SCXInternalErrorException if the contents are not as expected
+     *
+     */
+    bool LinuxProcStat::ParseStatBuffer(const char* buffer, size_t length, const char* filename)
+    {
+        // Less than 32 bytes read; that's not possible unless something is really wrong
+        if (length < 32) {
             wostringstream errtxt;
             errtxt << L"Getting very short contents reading " << StrFromUTF8(filename) << L" file. "
-                   << L"Expecting minimum of 32 bytes but got " << nscanned << L" bytes (errno="
-                   << eno << L").";
+                   << L"Expecting minimum of 32 bytes but got " << length << L" bytes.";
             throw SCXInternalErrorException(errtxt.str(), SCXSRCLOCATION);
         }
-        buffer[nscanned] = '\0';
-
-        nscanned = sscanf(buffer, "%d", &processId);
+        const char* end = buffer + length;
 
-        if (nscanned != 1) {
+        ProcFieldParser pid(buffer, end);
+        if (!pid.Next(processId)) {
             wostringstream errtxt;
             errtxt << L"Getting wrong number of parameters from " << StrFromUTF8(filename) << L" file. "
-                   << L"Expecting 1 but getting " << nscanned << '.';
+                   << L"Expecting 1 but getting 0.";
             throw SCXInternalErrorException(errtxt.str(), SCXSRCLOCATION);
         }
 
         // Now go for the process name "(processname)", but search for starting
         // "(" and last ")" to handle processes that contain "(" or ")" bytes.
-        const char* procStart = strchr(buffer, '(');
-        const char* procEnd = strrchr(buffer, ')');
+        const char* procStart = static_cast<const char*>(memchr(buffer, '(', length));
+        const char* procEnd = NULL;
+        for (const char* p = end; p != buffer; --p)
+        {
+            if (')' == p[-1])
+            {
+                procEnd = p - 1;
+                break;
+            }
+        }
         if (NULL == procStart || NULL == procEnd || procStart > procEnd || (procEnd - procStart) > 56)
         {
             wostringstream errtxt;
-            errtxt << L"Unexpected error parsing " << StrFromUTF8(filename) << L", file contents: " << StrFromUTF8(buffer);
+            errtxt << L"Unexpected error parsing " << StrFromUTF8(filename) << L", file contents: "
+                   << StrFromUTF8(std::string(buffer, length));
             throw SCXInternalErrorException(errtxt.str(), SCXSRCLOCATION);
         }
 
         size_t endByte = procEnd - procStart - 1;
-        const char* remainingPtr = procEnd + 1;
         memcpy(command, procStart + 1, endByte);
         command[endByte] = '\0';
 
-        nscanned = sscanf(remainingPtr, scanstring,
-                          &state, &parentProcessId, &processGroupId,
-                          &sessionId, &controllingTty, &terminalProcessId, &flags, &minorFaults,
-                          &childMinorFaults, &majorFaults, &childMajorFaults, &userTime, &systemTime,
-                          &childUserTime, &childSystemTime, &priority, &nice, &intervalTimerValue,
-                          &startTime, &virtualMemSizeBytes, &residentSetSize, &residentSetSizeLimit,
-                          &startAddress, &endAddress, &startStackAddress, &kernelStackPointer, 
-                          &kernelInstructionPointer, &signal, &blocked, &sigignore, &sigcatch, 
-                          &waitChannel, &numPagesSwapped, &cumNumPagesSwapped, &exitSignal, 
-                          &processorNum, &realTimePriority, &schedulingPolicy);
+        ProcFieldParser fp(procEnd + 1, end);
+        fp.Next(state) && fp.Next(parentProcessId) && fp.Next(processGroupId) &&
+            fp.Next(sessionId) && fp.Next(controllingTty) && fp.Next(terminalProcessId) &&
+            fp.Next(flags) && fp.Next(minorFaults) && fp.Next(childMinorFaults) &&
+            fp.Next(majorFaults) && fp.Next(childMajorFaults) && fp.Next(userTime) &&
+            fp.Next(systemTime) && fp.Next(childUserTime) && fp.Next(childSystemTime) &&
+            fp.Next(priority) && fp.Next(nice) && fp.Skip() && fp.Next(intervalTimerValue) &&
+            fp.Next(startTime) && fp.Next(virtualMemSizeBytes) && fp.Next(residentSetSize) &&
+            fp.Next(residentSetSizeLimit) && fp.Next(startAddress) && fp.Next(endAddress) &&
+            fp.Next(startStackAddress) && fp.Next(kernelStackPointer) &&
+            fp.Next(kernelInstructionPointer) && fp.Next(signal) && fp.Next(blocked) &&
+            fp.Next(sigignore) && fp.Next(sigcatch) && fp.Next(waitChannel) &&
+            fp.Next(numPagesSwapped) && fp.Next(cumNumPagesSwapped) && fp.Next(exitSignal) &&
+            fp.Next(processorNum) && fp.Next(realTimePriority) && fp.Next(schedulingPolicy);
 
         // -2 since we read pid and name separatly
-        if (nscanned != procstat_len-2) {
+        if (fp.Parsed() != procstat_len-2) {
             wostringstream errtxt;
             errtxt << L"Getting wrong number of parameters from " << StrFromUTF8(filename) << L" file. "
-                   << L"Expecting " << procstat_len-2 << " but getting " << nscanned << '.';
+                   << L"Expecting " << procstat_len-2 << " but getting " << fp.Parsed() << '.';
             throw SCXInternalErrorException(errtxt.str(), SCXSRCLOCATION);
         }
 
         return true;
     }
 
-    /** Format for scanf() when reading /proc/#/statm. */
-    const char *LinuxProcStatM::scanstring = "%lu %lu %lu %lu %lu %lu";
-
     /**
-     * Reads the /proc/#/stat file.
+     * Parses the contents of a /proc/#/statm file.
      *
-     * \param filePointer File pointer to an open file.
-     * \param filename    Name of the file
-     * \returns true if the file was successfully read, or false if it was deleted already
+     * \param buffer   Contents of the file (need not be NUL terminated)
+     * \param length   Number of bytes in buffer
+     * \param filename Name of the file (for error messages)
+     * \returns true if the contents was successfully parsed, or false if the process has died
+     * \throws SCXInternalErrorException if the contents are not as expected
      *
      */
-    bool LinuxProcStatM::ReadStatMFile(FILE *filePointer, const char* filename)
-    {
-        int nscanned = fscanf(filePointer, scanstring,
-                              &size, &resident, &share, &text, &lib, &data);
-
-        // Test if the file was deleted before we had a chance to read it.
-        // This can happen on RedHat, but not on Suse10.
-        // On Suse10 the fscanf will return normally, but all values are 0.
-        if (ferror(filePointer)) {
-            if (errno == ESRCH) {
-              // Race condition. This is ok.
-              return false;
-            }
-            int eno = errno;
-            throw SCXErrnoException(L"fscanf", eno, SCXSRCLOCATION);
-        }
+    bool LinuxProcStatM::ParseStatMBuffer(const char* buffer, size_t length, const char* filename)
+    {
+        size = resident = share = text = lib = data = 0;
+
+        ProcFieldParser fp(buffer, buffer + length);
+        fp.Next(size) && fp.Next(resident) && fp.Next(share) &&
+            fp.Next(text) && fp.Next(lib) && fp.Next(data);
 
         // If ALL values are zero then assume that the process has died.
         // This is very ad-hoc, but this behaviour has been observed on Suse10,
@@ -274,47 +401,214 @@ namespace SCXSystemLib
             return false; 
         }
 
-        if (nscanned != procstat_len) {
+        if (fp.Parsed() != procstat_len) {
             wostringstream errtxt;
             errtxt << L"Getting wrong number of parameters from " << StrFromUTF8(filename) << L" file. "
-                   << L"Expecting " << procstat_len << " but getting " << nscanned << '.';
+                   << L"Expecting " << procstat_len << " but getting " << fp.Parsed() << '.';
             throw SCXInternalErrorException(errtxt.str(), SCXSRCLOCATION);
         }
         return true;
     }
 
+    /**
+     * Keeps the fields of /proc/#/stat that are used between samples.
+     *
+     * \param stat Parsed contents of the file
+     */
+    void LinuxProcInfo::Assign(const LinuxProcStat& stat)
+    {
+        processId = stat.processId;
+        memcpy(command, stat.command, sizeof(command));
+        state = stat.state;
+        parentProcessId = stat.parentProcessId;
+        processGroupId = stat.processGroupId;
+        sessionId = stat.sessionId;
+        majorFaults = stat.majorFaults;
+        userTime = stat.userTime;
+        systemTime = stat.systemTime;
+        childUserTime = stat.childUserTime;
+        childSystemTime = stat.childSystemTime;
+        priority = stat.priority;
+        nice = stat.nice;
+        startTime = stat.startTime;
+        virtualMemSizeBytes = stat.virtualMemSizeBytes;
+        residentSetSize = stat.residentSetSize;
+    }
+
+    /**
+     * Keeps the fields of /proc/#/statm that are used between samples.
+     *
+     * \param statm Parsed contents of the file
+     */
+    void LinuxProcInfo::Assign(const LinuxProcStatM& statm)
+    {
+        share = statm.share;
+        text = statm.text;
+        data = statm.data;
+    }
+
+    /**
+     * Parses the contents of a /proc/#/status file.
+     *
+     * Only the "Uid:" line is of interest. It is near the start of the file,
+     * so a truncated read of the file is fine.
+     *
+     * \param buffer   Contents of the file (need not be NUL terminated)
+     * \param length   Number of bytes in buffer
+     * \returns true if the real user ID was found
+     *
+     */
+    bool LinuxProcStatus::ParseStatusBuffer(const char* buffer, size_t length)
+    {
+        static const char uidTag[] = "Uid:";
+        const size_t uidTagLen = sizeof(uidTag) - 1;
+        const char* end = buffer + length;
+
+        for (const char* line = buffer; line < end; )
+        {
+            if (static_cast<size_t>(end - line) > uidTagLen && 0 == memcmp(line, uidTag, uidTagLen))
+            {
+                unsigned long uid = 0;
+                ProcFieldParser fp(line + uidTagLen, end);
+                if (!fp.Next(uid))
+                {
+                    return false;
+                }
+                realUid = static_cast<uid_t>(uid);
+                return true;
+            }
+
+            const char* eol = static_cast<const char*>(memchr(line, '\n', end - line));
+            if (NULL == eol)
+            {
+                break;
+            }
+            line = eol + 1;
+        }
+        return false;
+    }
+
+    /**
+     * Parses an unsigned decimal number of up to 64 bits, after optional blanks.
+     *
+     * \param pos   Start of the text to parse
+     * \param end   One past the end of the text to parse
+     * \param value Value read
+     * \returns Position after the number, or NULL if there was no number
+     */
+    static const char* ParseCounter64(const char* pos, const char* end, scxulong& value)
+    {
+        while (pos != end && (' ' == *pos || '\t' == *pos))
+        {
+            ++pos;
+        }
+        const char* digits = pos;
+        value = 0;
+        while (pos != end && *pos >= '0' && *pos <= '9')
+        {
+            value = value * 10 + static_cast<scxulong>(*pos - '0');
+            ++pos;
+        }
+        return pos == digits ? NULL : pos;
+    }
+
+    /**
+     * Parses the contents of a /proc/#/io file.
+     *
+     * \param buffer   Contents of the file (need not be NUL terminated)
+     * \param length   Number of bytes in buffer
+     * \returns true if the system call and storage counters were all found
+     *
+     */
+    bool LinuxProcIo::ParseIoBuffer(const char* buffer, size_t length)
+    {
+        static const struct {
+            const char* tag;
+            size_t length;
+            scxulong LinuxProcIo::* field;
+        } fields[] = {
+            { "syscr:", 6, &LinuxProcIo::readCalls },
+            { "syscw:", 6, &LinuxProcIo::writeCalls },
+            { "read_bytes:", 11, &LinuxProcIo::readBytes },
+            { "write_bytes:", 12, &LinuxProcIo::writeBytes }
+        };
+        const size_t fieldCount = sizeof(fields) / sizeof(fields[0]);
+        size_t found = 0;
+        const char* end = buffer + length;
+
+        for (const char* line = buffer; line < end; )
+        {
+            for (size_t f = 0; f < fieldCount; f++)
+            {
+                if (static_cast<size_t>(end - line) > fields[f].length &&
+                    0 == memcmp(line, fields[f].tag, fields[f].length))
+                {
+                    if (NULL != ParseCounter64(line + fields[f].length, end, this->*fields[f].field))
+                    {
+                        ++found;
+                    }
+                    break;
+                }
+            }
+
+            const char* eol = static_cast<const char*>(memchr(line, '\n', end - line));
+            if (NULL == eol)
+            {
+                break;
+            }
+            line = eol + 1;
+        }
+        return found == fieldCount;
+    }
+
+    /**
+     * Parses the contents of a /proc/#/schedstat file.
+     *
+     * The file holds the time spent on a CPU, the time spent waiting on a run
+     * queue (both in nanoseconds) and the number of time slices run. Only the
+     * run delay is kept.
+     *
+     * \param buffer   Contents of the file (need not be NUL terminated)
+     * \param length   Number of bytes in buffer
+     * \returns true if the run delay was found
+     *
+     */
+    bool LinuxProcIo::ParseSchedStatBuffer(const char* buffer, size_t length)
+    {
+        const char* end = buffer + length;
+        scxulong runTime = 0;
+        const char* pos = ParseCounter64(buffer, end, runTime);
+        return NULL != pos && NULL != ParseCounter64(pos, end, runDelay);
+    }
+
     /**
      * Constructor for Linux.
      *
      * \param pid Process number for this process
-     * \param basename Directory name in /proc where this instance resides
+     * \param basename Directory name in /proc where this instance resides;
+     *                 not kept, the names of the files are built from pid
+     * \param procDir  /proc, shared by all instances of the enumeration
      *
      * Creates a new process instance without any content.
      * This constructor is declared private since it can only be used by
      * the ProcessEnumerator class.
      */
-    ProcessInstance::ProcessInstance(scxpid_t pid, const char* basename) :
+    ProcessInstance::ProcessInstance(scxpid_t pid, const char*, SCXHandle<ProcDirectory> procDir) :
         EntityInstance(false), m_pid(pid), m_found(true), m_accessViolationEncountered(false),
         m_scxPriorityValid(false), m_scxPriority(0), m_uid(0), m_gid(0),
-        m_RealTime_tics(MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES),
-        m_UserTime_tics(MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES),
-        m_SystemTime_tics(MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES),
-        m_HardPageFaults_tics(MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES),
-        m_delta_UserTime(0), m_delta_SystemTime(0), m_delta_HardPageFaults(0)
+        m_procDirUid(0), m_procDirGid(0), m_samplesSinceStaticRefresh(0),
+        m_procDir(procDir), m_procDirFd(-1), m_statFd(-1), m_statmFd(-1),
+        m_cmdLineLock(ThreadLockHandleGet()), m_cmdLine(NULL), m_cmdLineRead(false),
+        m_delta_UserTime(0), m_delta_SystemTime(0), m_delta_HardPageFaults(0), m_delta_IoKnown(0)
     {
-        m_log = SCXLogHandleFactory::GetLogHandle(moduleIdentifier);
+        m_log = GetInstanceLogHandle();
         SCX_LOGHYSTERICAL(m_log, L"ProcessInstance constructor");
 
-        /* Rememeber files that we read regularly */
-        snprintf(m_procStatName,  sizeof(m_procStatName),  "/proc/%s/stat",  basename);
-        snprintf(m_procStatMName, sizeof(m_procStatMName), "/proc/%s/statm", basename);
-
         // The instance id m_Id is of type wstring. (Old relic, I'm told)
         SetId(StrFrom(m_pid));
 
-        // Nullify process name and pid
-        m.command[0] = '\0';
-        m.processId = 0;
+        // Nullify process name, pid and the rest
+        memset(&m, 0, sizeof(m));
 
         /* Set clock frequency to proper value.
            "Jiffies" is a measure of frequency that many times reported by the system
@@ -337,6 +631,157 @@ namespace SCXSystemLib
 
         m_timeOfDeath.tv_sec = 0; m_timeOfDeath.tv_usec = 0;
         m_delta_RealTime.tv_sec = 0; m_delta_RealTime.tv_usec = 0;
+        memset(m_delta_Io, 0, sizeof(m_delta_Io));
+    }
+
+    /**
+     * Opens /proc/# and keeps it open, if the budget allows.
+     *
+     * Failure is not an error; files are then looked up relative to /proc.
+     * Only done once the process has been sampled, so that processes that
+     * are never kept, such as kernel threads, cost no extra system calls.
+     */
+    void ProcessInstance::OpenProcessDirectory(void)
+    {
+        if (m_procDirFd >= 0 || !m_procDir->ReserveKeptFile())
+        {
+            return;
+        }
+        m_procDirFd = OpenProcessFile("", O_DIRECTORY);
+        if (m_procDirFd < 0)
+        {
+            m_procDir->ReleaseKeptFile(-1);
+        }
+    }
+
+    /**
+     * Closes the files of the process that are kept open.
+     */
+    void ProcessInstance::CloseProcessFiles(void)
+    {
+        int* fds[] = { &m_statmFd, &m_statFd, &m_procDirFd };
+        for (size_t i = 0; i < sizeof(fds) / sizeof(fds[0]); i++)
+        {
+            if (*fds[i] >= 0)
+            {
+                m_procDir->ReleaseKeptFile(*fds[i]);
+                *fds[i] = -1;
+            }
+        }
+    }
+
+    /**
+     * Opens a file of the process.
+     *
+     * \param name  Name of the file under /proc/#; empty for /proc/# itself
+     * \param flags Flags besides O_RDONLY
+     * \returns The descriptor, or -1 with errno set
+     */
+    int ProcessInstance::OpenProcessFile(const char* name, int flags)
+    {
+        if (m_procDirFd >= 0)
+        {
+            return m_procDir->Open(m_procDirFd, '\0' == name[0] ? "." : name, flags);
+        }
+        char relative[48];
+        int length = snprintf(relative, sizeof(relative), "%d", static_cast<int>(m_pid));
+        if ('\0' != name[0])
+        {
+            snprintf(relative + length, sizeof(relative) - static_cast<size_t>(length), "/%s", name);
+        }
+        return m_procDir->Open(-1, relative, flags);
+    }
+
+    /**
+     * Gets the status of a file of the process.
+     *
+     * \param name  Name of the file under /proc/#; empty for /proc/# itself
+     * \param st    Receives the status
+     * \returns 0, or -1 with errno set
+     */
+    int ProcessInstance::StatProcessFile(const char* name, struct stat* st)
+    {
+        if (m_procDirFd >= 0)
+        {
+            return m_procDir->Stat(m_procDirFd, name, st);
+        }
+        char relative[48];
+        int length = snprintf(relative, sizeof(relative), "%d", static_cast<int>(m_pid));
+        if ('\0' != name[0])
+        {
+            snprintf(relative + length, sizeof(relative) - static_cast<size_t>(length), "/%s", name);
+        }
+        return m_procDir->Stat(-1, relative, st);
+    }
+
+    /**
+     * Reads a (small) file of the process into a caller supplied buffer.
+     *
+     * The file is read from its start with a single pread() into the fixed
+     * size buffer; nothing is allocated. The content is NUL terminated.
+     *
+     * \param name     Name of the file under /proc/#
+     * \param keptFd   Where the file is kept open, or NULL if it is not to
+     *                 be kept open. A file not yet open is kept open after
+     *                 it has been read if /proc/# is kept open and the
+     *                 budget allows.
+     * \param buffer   Buffer to read into
+     * \param size     Size of the buffer, including room for the terminating NUL
+     * \param mayBeDenied true if the file may be unreadable for us (like
+     *                    /proc/#/io of another user's process)
+     * \returns Number of bytes read, or -1 if the process has gone away
+     *          (or access was denied, if allowed)
+     * \throws SCXErrnoException for unexpected errors
+     */
+    ssize_t ProcessInstance::ReadProcessFile(const char* name, int* keptFd, char* buffer, size_t size, bool mayBeDenied)
+    {
+        bool kept = NULL != keptFd && *keptFd >= 0;
+        int fd = kept ? *keptFd : OpenProcessFile(name, 0);
+        if (fd < 0)
+        {
+            // If process is currently being removed, we can get spurious EBADF/EINVAL errors
+            if (ENOENT == errno || ESRCH == errno || EBADF == errno || EINVAL == errno)
+            {
+                return -1;
+            }
+            if (mayBeDenied && (EACCES == errno || EPERM == errno))
+            {
+                return -1;
+            }
+            throw SCXErrnoException(L"openat", errno, SCXSRCLOCATION);
+        }
+
+        ssize_t bytes = m_procDir->Read(fd, buffer, size - 1);
+        int eno = errno;
+        if (kept)
+        {
+            if (bytes < 0)
+            {
+                // Stays bound to the process, so nothing more can be read from it
+                m_procDir->ReleaseKeptFile(fd);
+                *keptFd = -1;
+            }
+        }
+        else if (bytes >= 0 && NULL != keptFd && m_procDirFd >= 0 && m_procDir->ReserveKeptFile())
+        {
+            *keptFd = fd;
+        }
+        else
+        {
+            m_procDir->Close(fd);
+        }
+
+        if (bytes < 0)
+        {
+            // Race condition, the process went away while we were reading. This is ok.
+            if (ESRCH == eno || ENOENT == eno)
+            {
+                return -1;
+            }
+            throw SCXErrnoException(L"pread", eno, SCXSRCLOCATION);
+        }
+        buffer[bytes] = '\0';
+        return bytes;
     }
 
     /**
@@ -355,117 +800,277 @@ namespace SCXSystemLib
      */
     bool ProcessInstance::LinuxProcessPriority2SCXProcessPriority(long linuxPriority, unsigned int &scxPriority)
     {
-        scxPriority = 0;
-        // According to documentation for /proc/[pid]/stat.priority, the priority field can have values -100 to -2 for
-        // real time threads and 0 to 39 for non real time threads. Apparently value of -1 is not used. Lower value means
-        // higher priority.
-        if((linuxPriority < -100) || (linuxPriority > 39) || (linuxPriority == -1))
+        scxPriority = 0;
+        // According to documentation for /proc/[pid]/stat.priority, the priority field can have values -100 to -2 for
+        // real time threads and 0 to 39 for non real time threads. Apparently value of -1 is not used. Lower value means
+        // higher priority.
+        if((linuxPriority < -100) || (linuxPriority > 39) || (linuxPriority == -1))
+        {
+            // Priority is out of the expected range.
+            PriorityOutOfRangeError(linuxPriority);
+            return false;
+        }        
+        else if(linuxPriority < -1)
+        {
+            // Real time priority. Values -2 to -100 need to be mapped to 16 to 31 range.
+
+            // (-linuxPriority -2) gives 0 to 98 that needs to be scaled to 0 to 15.
+            scxPriority = static_cast<unsigned int>(((-linuxPriority -2) * 15) / 98);
+            // add 16 to have real time range of 16 -31.
+            scxPriority += 16;
+            return true;
+        }
+        else
+        {
+            // Non real time priority. Values 39 to 0 need to be mapped to 0 to 15 range.
+
+            // (-linuxPriority + 39) gives 0 to 39 that needs to be scaled to 0 to 15.
+            scxPriority = static_cast<unsigned int>(((-linuxPriority + 39) * 15) / 39);
+            return true;        
+        }
+    }
+
+    /**
+     * Updates instance to reflect current status.
+     *
+     * \param basename Not needed but yet required
+     * \param initial If this is a newly discovered process
+     *
+     * \returns true If successful, or false if it was deleted during update
+     *
+     * This is a private method that does the low-level updating of the
+     * system specific data structure from an external source. In the Linux
+     * case this is various files under /proc/#/.
+     *
+     */
+    bool ProcessInstance::UpdateInstance(const char*, bool initial)
+    {
+        if (!ReadCounterFiles() || !ReadStaticAttributes())
+        {
+            m_found = false; return false;
+        }
+        InvalidateCommandLine();
+
+        if (initial) {
+            SetBootTime();                      // Executed only once
+            OpenProcessDirectory();
+        }
+
+        m_found = true;
+        return m_found;
+    }
+
+    /**
+     * Updates instance of a process that has been seen before.
+     *
+     * \returns Outcome of the update
+     *
+     * The counters in /proc/#/stat and /proc/#/statm are re-read every time.
+     * The attributes that normally stay fixed for the lifetime of a process,
+     * the real UID and the identity of the executable, are only re-read when
+     * the process seems to have changed: the command name changed (exec) or
+     * the owner of /proc/# changed (credentials). As a safety net they are
+     * also re-read every PROCESS_STATIC_REFRESH_SAMPLES samples. The command
+     * line is read again on demand after every update, since a process may
+     * rewrite its arguments at any time without exec.
+     *
+     * If the start time differs from the previous sample, the pid has been
+     * reused by a new process and eProcessReplaced is returned. The instance
+     * must then be discarded since its samples belong to the old process.
+     */
+    ProcessInstance::IncrementalUpdateResult ProcessInstance::UpdateInstanceIncremental(void)
+    {
+        unsigned long startTime = m.startTime;
+        char command[sizeof(m.command)];
+        memcpy(command, m.command, sizeof(command));
+
+        if (!ReadCounterFiles())
+        {
+            m_found = false; return eProcessGone;
+        }
+        m_found = true;
+
+        if (m.startTime != startTime)
+        {
+            return eProcessReplaced;
+        }
+        InvalidateCommandLine();
+
+        struct stat st;
+        if (StatProcessFile("", &st) != 0)
+        {
+            m_found = false; return eProcessGone;
+        }
+
+        if (++m_samplesSinceStaticRefresh < PROCESS_STATIC_REFRESH_SAMPLES &&
+            st.st_uid == m_procDirUid && st.st_gid == m_procDirGid &&
+            0 == strncmp(command, m.command, sizeof(command)))
+        {
+            return eCountersUpdated;
+        }
+
+        if (!ReadStaticAttributes())
+        {
+            m_found = false; return eProcessGone;
+        }
+        return eStaticAttributesUpdated;
+    }
+
+    /**
+     * Reads the files under /proc/# that hold the sampled counters.
+     *
+     * \returns false if the process died before or while the files were read
+     *
+     * These are /proc/#/stat and, unless the process is a zombie, /proc/#/statm.
+     * Both are kept open if the budget allows.
+     *
+     * Descriptors kept open stay bound to the process they were opened for.
+     * If that process is gone, they are closed and the files are looked up
+     * again, since the pid may have been reused by a new process.
+     */
+    bool ProcessInstance::ReadCounterFiles(void)
+    {
+        // Fixed size buffers on the stack; the files are read through raw file
+        // descriptors and parsed in place, so nothing here allocates memory
+        char buffer[1024];
+        char filename[32];
+
+        snprintf(filename, sizeof(filename), "/proc/%d/stat", static_cast<int>(m_pid));
+        bool wasKept = m_procDirFd >= 0 || m_statFd >= 0;
+        ssize_t bytes = ReadProcessFile("stat", &m_statFd, buffer, sizeof(buffer));
+        if (bytes < 0 && wasKept)
+        {
+            CloseProcessFiles();
+            OpenProcessDirectory();
+            bytes = ReadProcessFile("stat", &m_statFd, buffer, sizeof(buffer));
+        }
+        // test if file was deleted before we had a chance to read it
+        if (bytes < 0) { return false; }
+        LinuxProcStat stat;
+        stat.ParseStatBuffer(buffer, static_cast<size_t>(bytes), filename);
+        m.Assign(stat);
+
+        m_scxPriorityValid = LinuxProcessPriority2SCXProcessPriority(m.priority, m_scxPriority);
+
+        if (m.state != 'Z')
+        {
+            snprintf(filename, sizeof(filename), "/proc/%d/statm", static_cast<int>(m_pid));
+            bytes = ReadProcessFile("statm", &m_statmFd, buffer, sizeof(buffer));
+            // test if file was deleted before we had a chance to read it
+            LinuxProcStatM statm;
+            if (bytes < 0 || !statm.ParseStatMBuffer(buffer, static_cast<size_t>(bytes), filename))
+            { 
+                return false;
+            }
+            m.Assign(statm);
+        }
+        return true;
+    }
+
+    /**
+     * Reads the attributes that normally stay fixed for the lifetime of a process.
+     *
+     * \returns false if the process died before the attributes were read
+     *
+     * This is the real UID from /proc/#/status. The owner of /proc/# is
+     * remembered so that UpdateInstanceIncremental() can tell when the
+     * credentials of the process change.
+     */
+    bool ProcessInstance::ReadStaticAttributes(void)
+    {
+        struct stat st;
+        if (StatProcessFile("", &st) != 0)
         {
-            // Priority is out of the expected range.
-            PriorityOutOfRangeError(linuxPriority);
-            return false;
-        }        
-        else if(linuxPriority < -1)
+            if (ENOENT == errno || ESRCH == errno) { return false; }
+        }
+        else
         {
-            // Real time priority. Values -2 to -100 need to be mapped to 16 to 31 range.
+            m_procDirUid = st.st_uid;
+            m_procDirGid = st.st_gid;
+        }
+        m_samplesSinceStaticRefresh = 0;
 
-            // (-linuxPriority -2) gives 0 to 98 that needs to be scaled to 0 to 15.
-            scxPriority = static_cast<unsigned int>(((-linuxPriority -2) * 15) / 98);
-            // add 16 to have real time range of 16 -31.
-            scxPriority += 16;
-            return true;
+        // The real UID is all we need from /proc/#/status
+        char buffer[1024];
+        ssize_t bytes = ReadProcessFile("status", NULL, buffer, sizeof(buffer));
+        LinuxProcStatus status;
+        if (bytes < 0)
+        {
+            SCX_LOGWARNING(m_log, L"Proc status reader failed to load.");
+        }
+        else if (!status.ParseStatusBuffer(buffer, static_cast<size_t>(bytes)))
+        {
+            SCX_LOGWARNING(m_log, L"Proc status reader failed to read status.");
         }
         else
         {
-            // Non real time priority. Values 39 to 0 need to be mapped to 0 to 15 range.
-
-            // (-linuxPriority + 39) gives 0 to 39 that needs to be scaled to 0 to 15.
-            scxPriority = static_cast<unsigned int>(((-linuxPriority + 39) * 15) / 39);
-            return true;        
+            m_uid = status.realUid;
         }
+
+        return true;
     }
 
     /**
-     * Updates instance to reflect current status.
+     * Marks the command line as outdated, so that the next GetParameters()
+     * reads it again.
      *
-     * \param basename Not needed but yet required
-     * \param initial If this is a newly discovered process
-     *
-     * \returns true If successful, or false if it was deleted during update
+     * Called on every update: processes such as nginx or postgres rewrite
+     * their arguments (setproctitle) without calling exec, and nothing else
+     * under /proc/# tells when they did.
+     */
+    void ProcessInstance::InvalidateCommandLine(void)
+    {
+        SCXThreadLock lock(m_cmdLineLock);
+        m_cmdLineRead = false;
+    }
+
+    /**
+     * Reads the command line from /proc/#/cmdline.
      *
-     * This is a private method that does the low-level updating of the
-     * system specific data structure from an external source. In the Linux
-     * case this is various files under /proc/#/.
+     * \returns Command line acquired from the ProcessCommandLinePool, to be
+     *          released by the caller; NULL if the process has no command
+     *          line (kernel threads, zombies) or has gone away.
      *
+     * Touches no members, so it may run without holding m_cmdLineLock.
      */
-    bool ProcessInstance::UpdateInstance(const char*, bool initial)
+    const ProcessCommandLinePool::CommandLine* ProcessInstance::ReadCommandLine(void) const
     {
-        bool found = false;
-        ProcfsProcStatusReader procfsReader;  // Linux specific /proc/[pid]/status reader.
-
-        SCXFileHandle f(fopen(m_procStatName, "r"));
-        if (!f.GetFile()) {
-            // If process is currently being removed, we can get spurious EBADF/EINVAL errors
-            if (ENOENT == errno || EBADF == errno || EINVAL == errno) { m_found = false; return false; }
-            throw SCXErrnoException(L"fopen", errno, SCXSRCLOCATION);
+        char cmdLineName[32];
+        snprintf(cmdLineName, sizeof(cmdLineName), "/proc/%d/cmdline", static_cast<int>(m_pid));
+        int fd = open(cmdLineName, O_RDONLY);
+        if (fd < 0)
+        {
+            return NULL;
         }
 
-        if (procfsReader.Load(m_pid))
+        // Most command lines fit in the buffer; longer ones are collected in data
+        char buffer[4096];
+        std::string data;
+        ssize_t bytes;
+        while (true)
         {
-            ProcfsProcStatusReader::const_iterator cit = procfsReader.begin();
-            if (cit == procfsReader.end())
+            bytes = read(fd, buffer, sizeof(buffer));
+            if (bytes < 0 && EINTR == errno)
             {
-                SCX_LOGWARNING(m_log, L"Proc status reader failed to read status.");
+                continue;
             }
-            else
+            if (bytes <= 0 || (data.empty() && static_cast<size_t>(bytes) < sizeof(buffer)))
             {
-                 uid_t real       = 0;
-                 uid_t effective  = 0;
-                 uid_t saved      = 0;
-                 uid_t filesystem = 0;
-                 if (cit->Uid(real, effective, saved, filesystem))
-                 {
-                     m_uid = real;
-                 }
+                break;
             }
+            data.append(buffer, static_cast<size_t>(bytes));
         }
-        else
-        {
-            SCX_LOGWARNING(m_log, L"Proc status reader failed to load.");
-        }
+        close(fd);
 
-        found = m.ReadStatFile(f.GetFile(), m_procStatName);
-
-        // test if file was deleted before we had a chance to read it
-        if (!found) { m_found = false; return false; }
-
-        m_scxPriorityValid = LinuxProcessPriority2SCXProcessPriority(m.priority, m_scxPriority);
-
-        if (m.state != 'Z')
+        if (!data.empty())
         {
-            SCXFileHandle f2(fopen(m_procStatMName, "r"));
-            if (!f2.GetFile()) {
-                // If process is currently being removed, we can get spurious EBADF/EINVAL errors
-                if (ENOENT == errno || EBADF == errno || EINVAL == errno) { m_found = false; return false; }
-                throw SCXErrnoException(L"fopen", errno, SCXSRCLOCATION);
-            }
-
-            found = n.ReadStatMFile(f2.GetFile(), m_procStatMName);
-            
-            // test if file was deleted before we had a chance to read it
-            if (!found) 
-            { 
-                m_found = false; return false; 
-            }
+            return ProcessCommandLinePool::Instance().Acquire(data.data(), data.size());
         }
-
-        if (initial) {
-            SetBootTime();                      // Executed only once
+        if (bytes > 0)
+        {
+            return ProcessCommandLinePool::Instance().Acquire(buffer, static_cast<size_t>(bytes));
         }
-
-        UpdateParameters();
-        m_found = true;
-        return m_found;
+        return NULL;
     }
 
     /**
@@ -482,15 +1087,77 @@ namespace SCXSystemLib
      */
     void ProcessInstance::UpdateDataSampler(struct timeval& realtime)
     {
-        m_RealTime_tics.AddSample(realtime);
-        m_UserTime_tics.AddSample(m.userTime);             // Data sampler for user time.
-        m_SystemTime_tics.AddSample(m.systemTime);         // Data sampler for system time.
-        m_HardPageFaults_tics.AddSample(m.majorFaults);    // Data sampler for hard page faults.
+        scxulong row[eSampledCounterCount];
+        row[eRealTime] = static_cast<scxulong>(realtime.tv_sec) * 1000000 + static_cast<scxulong>(realtime.tv_usec);
+        row[eUserTime] = m.userTime;
+        row[eSystemTime] = m.systemTime;
+        row[eHardPageFaults] = m.majorFaults;
+        m_samples.AddSamples(row);
 
         /* If process has become a zombie, record time of death. */
         if (m_timeOfDeath.tv_sec == 0 && m.state == 'Z') { m_timeOfDeath = realtime; }
     }
 
+    /**
+     * Samples the I/O and scheduler statistics, or drops them.
+     *
+     * \param realtime Current time
+     * \param enabled  Should the statistics be sampled? If not, any samples
+     *                 kept are released.
+     *
+     * /proc/#/io can only be read for our own processes unless we run as
+     * root; counters that cannot be read are not known. If the set of known
+     * counters changes, the history starts over, since deltas between read
+     * and unread values would be meaningless.
+     *
+     * \note /proc/#/io covers all threads of the process, but
+     * /proc/#/schedstat only the main thread.
+     */
+    void ProcessInstance::UpdateIoSampler(const struct timeval& realtime, bool enabled)
+    {
+        if (!enabled)
+        {
+            m_ioSamples = SCXHandle<IoSamples>(0);
+            return;
+        }
+
+        LinuxProcIo io;
+        memset(&io, 0, sizeof(io));
+        unsigned int known = 0;
+
+        char buffer[1024];
+        ssize_t bytes = ReadProcessFile("io", NULL, buffer, sizeof(buffer), true);
+        if (bytes >= 0 && io.ParseIoBuffer(buffer, static_cast<size_t>(bytes)))
+        {
+            known |= (1 << IoSamples::eReadBytes) | (1 << IoSamples::eWriteBytes) |
+                     (1 << IoSamples::eReadCalls) | (1 << IoSamples::eWriteCalls);
+        }
+        bytes = ReadProcessFile("schedstat", NULL, buffer, sizeof(buffer), true);
+        if (bytes >= 0 && io.ParseSchedStatBuffer(buffer, static_cast<size_t>(bytes)))
+        {
+            known |= 1 << IoSamples::eRunDelay;
+        }
+
+        if (NULL == m_ioSamples)
+        {
+            m_ioSamples = SCXHandle<IoSamples>(new IoSamples());
+        }
+        else if (m_ioSamples->known != known)
+        {
+            m_ioSamples->samples.Clear();
+        }
+        m_ioSamples->known = known;
+
+        scxulong row[IoSamples::eCounterCount];
+        row[IoSamples::eReadBytes] = io.readBytes;
+        row[IoSamples::eWriteBytes] = io.writeBytes;
+        row[IoSamples::eReadCalls] = io.readCalls;
+        row[IoSamples::eWriteCalls] = io.writeCalls;
+        row[IoSamples::eRunDelay] = io.runDelay;
+        row[IoSamples::eTimeStamp] = static_cast<scxulong>(realtime.tv_sec) * 1000 + static_cast<scxulong>(realtime.tv_usec) / 1000;
+        m_ioSamples->samples.AddSamples(row);
+    }
+
     /**
      *  Compute percentage values.
      *
@@ -503,10 +1170,42 @@ namespace SCXSystemLib
         // How far we go back for measurement (all the way)
         const size_t go_back = MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES;
 
-        m_delta_RealTime = m_RealTime_tics.GetDelta(go_back);
-        m_delta_UserTime = m_UserTime_tics.GetDelta(go_back);
-        m_delta_SystemTime = m_SystemTime_tics.GetDelta(go_back);
-        m_delta_HardPageFaults = m_HardPageFaults_tics.GetDelta(go_back);
+        scxulong realTime = m_samples.GetDelta(eRealTime, go_back);
+        m_delta_RealTime.tv_sec = static_cast<time_t>(realTime / 1000000);
+        m_delta_RealTime.tv_usec = static_cast<suseconds_t>(realTime % 1000000);
+        m_delta_UserTime = m_samples.GetDelta(eUserTime, go_back);
+        m_delta_SystemTime = m_samples.GetDelta(eSystemTime, go_back);
+        m_delta_HardPageFaults = m_samples.GetDelta(eHardPageFaults, go_back);
+
+        // The getters read only these copies, never m_ioSamples, which the sampler may drop
+        m_delta_IoKnown = (NULL == m_ioSamples) ? 0 : m_ioSamples->known;
+        for (size_t c = 0; c < IoSamples::eCounterCount; c++)
+        {
+            m_delta_Io[c] = (NULL == m_ioSamples) ? 0 : m_ioSamples->samples.GetDelta(c, go_back);
+        }
+    }
+
+    /**
+     * Computes the recent rate of a sampled I/O or scheduler counter.
+     *
+     * \param counter Counter to use
+     * \param value   Return parameter for the number of items per second
+     * \returns true if the counter was sampled and could be read at the
+     *          latest UpdateTimedValues()
+     */
+    bool ProcessInstance::GetIoItemsPerSecond(IoSamples::Counter counter, scxulong& value) const
+    {
+        value = 0;
+        if (0 == (m_delta_IoKnown & (1 << counter)))
+        {
+            return false;
+        }
+        scxulong elapsed = m_delta_Io[IoSamples::eTimeStamp];
+        if (elapsed != 0)       // Avoid divide by zero
+        {
+            value = 1000 * m_delta_Io[counter] / elapsed;
+        }
+        return true;
     }
 
 #endif /* linux */
@@ -525,15 +1224,9 @@ namespace SCXSystemLib
     ProcessInstance::ProcessInstance(scxpid_t pid, const char* basename) :
         EntityInstance(false), m_pid(pid), m_found(true), m_accessViolationEncountered(false),
         m_scxPriorityValid(false), m_scxPriority(0), m_logged64BitError(false), m_delta_BlockOut(0),
-        m_delta_BlockInp(0), m_delta_HardPageFaults(0),
-        m_RealTime_tics(MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES),
-        m_UserTime_tics(MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES),
-        m_SystemTime_tics(MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES),
-        m_BlockOut_tics(MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES),
-        m_BlockInp_tics(MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES),
-        m_HardPageFaults_tics(MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES)
-    {
-        m_log = SCXLogHandleFactory::GetLogHandle(moduleIdentifier);
+        m_delta_BlockInp(0), m_delta_HardPageFaults(0)
+    {
+        m_log = GetInstanceLogHandle();
         SCX_LOGTRACE(m_log, L"ProcessInstance constructor");
 
         snprintf(m_procPsinfoName, sizeof(m_procPsinfoName), "/proc/%s/psinfo", basename);
@@ -830,13 +1523,14 @@ namespace SCXSystemLib
         // Note2: The total CPU time is also available in m_psinfo.pr_time.tv_sec,
         //  but we sum system and user time instead.
 
-        m_RealTime_tics.AddSample(realtime);
-        m_UserTime_tics.AddSample(m_puse.pr_utime);     // User time
-        m_SystemTime_tics.AddSample(m_puse.pr_stime);   // System time
-
-        m_BlockOut_tics.AddSample(m_puse.pr_oublk);     // Written blocks
-        m_BlockInp_tics.AddSample(m_puse.pr_inblk);     // Read blocks
-        m_HardPageFaults_tics.AddSample(m_puse.pr_majf);// Data sampler for hard page faults.
+        scxulong row[eSampledCounterCount];
+        row[eRealTime] = TimevalToMicroseconds(realtime);
+        row[eUserTime] = TimespecToNanoseconds(m_puse.pr_utime);
+        row[eSystemTime] = TimespecToNanoseconds(m_puse.pr_stime);
+        row[eBlockOut] = m_puse.pr_oublk;               // Written blocks
+        row[eBlockInp] = m_puse.pr_inblk;               // Read blocks
+        row[eHardPageFaults] = m_puse.pr_majf;
+        m_samples.AddSamples(row);
 
         /* If process has become a zombie, record time of death.
            On Sun, there is a better resoltion termination time of available in
@@ -860,13 +1554,13 @@ namespace SCXSystemLib
         // How far we go back for measurement (all the way)
         const size_t go_back = MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES;
 
-        m_delta_RealTime = m_RealTime_tics.GetDelta(go_back);
-        m_delta_UserTime = m_UserTime_tics.GetDelta(go_back);
-        m_delta_SystemTime = m_SystemTime_tics.GetDelta(go_back);
+        m_delta_RealTime = MicrosecondsToTimeval<struct timeval>(m_samples.GetDelta(eRealTime, go_back));
+        m_delta_UserTime = NanosecondsToTimespec<scx_timestruc_t>(m_samples.GetDelta(eUserTime, go_back));
+        m_delta_SystemTime = NanosecondsToTimespec<scx_timestruc_t>(m_samples.GetDelta(eSystemTime, go_back));
 
-        m_delta_BlockOut = m_BlockOut_tics.GetDelta(go_back);
-        m_delta_BlockInp = m_BlockInp_tics.GetDelta(go_back);
-        m_delta_HardPageFaults = m_HardPageFaults_tics.GetDelta(go_back);
+        m_delta_BlockOut = m_samples.GetDelta(eBlockOut, go_back);
+        m_delta_BlockInp = m_samples.GetDelta(eBlockInp, go_back);
+        m_delta_HardPageFaults = m_samples.GetDelta(eHardPageFaults, go_back);
     }
 
 #endif /* sun */
@@ -885,15 +1579,9 @@ namespace SCXSystemLib
     ProcessInstance::ProcessInstance(scxpid_t pid, struct pst_status *) :
         EntityInstance(false), m_pid(pid), m_found(true), m_accessViolationEncountered(false),
         m_scxPriorityValid(false), m_scxPriority(0), m_delta_UserTime(0), m_delta_SystemTime(0), m_delta_BlockOut(0),
-        m_delta_BlockInp(0), m_delta_HardPageFaults(0),
-        m_RealTime_tics(MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES),
-        m_UserTime_tics(MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES),
-        m_SystemTime_tics(MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES),
-        m_BlockOut_tics(MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES),
-        m_BlockInp_tics(MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES),
-        m_HardPageFaults_tics(MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES)
-    {
-        m_log = SCXLogHandleFactory::GetLogHandle(moduleIdentifier);
+        m_delta_BlockInp(0), m_delta_HardPageFaults(0)
+    {
+        m_log = GetInstanceLogHandle();
         SCX_LOGTRACE(m_log, L"ProcessInstance constructor");
 
         // The instance id m_Id is of type wstring.
@@ -990,17 +1678,18 @@ namespace SCXSystemLib
      */
     void ProcessInstance::UpdateDataSampler(struct timeval& realtime)
     {
-        m_RealTime_tics.AddSample(realtime);
-        m_UserTime_tics.AddSample(m_pstatus.pst_utime);            // User time (seconds).
-        m_SystemTime_tics.AddSample(m_pstatus.pst_stime);          // System time (seconds).
+        scxulong row[eSampledCounterCount];
+        row[eRealTime] = TimevalToMicroseconds(realtime);
+        row[eUserTime] = m_pstatus.pst_utime;               // User time (seconds).
+        row[eSystemTime] = m_pstatus.pst_stime;             // System time (seconds).
 
-        // Alt. implementation. May be used in the future
-        //m_CPUTime_tics.AddSample(m_pstatus.pst_cpticks);           // Ticks of Cpu time
-        //m_CPUTime_total_tics.AddSample(m_pstatus.pst_cptickstotal);// Total Cpu ticks (Not entirely sure what this is)
+        // Alt. implementation. May be used in the future: sample
+        // pst_cpticks (ticks of Cpu time) and pst_cptickstotal (total Cpu ticks)
 
-        m_BlockOut_tics.AddSample(m_pstatus.pst_oublock);          // Written blocks
-        m_BlockInp_tics.AddSample(m_pstatus.pst_inblock);          // Read blocks
-        m_HardPageFaults_tics.AddSample(m_pstatus.pst_majorfaults);// Hard page faults.
+        row[eBlockOut] = m_pstatus.pst_oublock;             // Written blocks
+        row[eBlockInp] = m_pstatus.pst_inblock;             // Read blocks
+        row[eHardPageFaults] = m_pstatus.pst_majorfaults;   // Hard page faults.
+        m_samples.AddSamples(row);
 
         /* If process has become a zombie, record time of death. */
         if (m_timeOfDeath.tv_sec == 0 && m_pstatus.pst_stat == PS_ZOMBIE) { m_timeOfDeath = realtime; }
@@ -1018,17 +1707,13 @@ namespace SCXSystemLib
         // How far we go back for measurement (all the way)
         const size_t go_back = MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES;
 
-        m_delta_RealTime = m_RealTime_tics.GetDelta(go_back);
-        m_delta_UserTime = m_UserTime_tics.GetDelta(go_back);
-        m_delta_SystemTime = m_SystemTime_tics.GetDelta(go_back);
-
-        // Alt. implementation. May be used in the future
-        //m_delta_CPUTime_total = m_CPUTime_total_tics.GetDelta(go_back);
-        //m_delta_CPUTime = m_CPUTime_tics.GetDelta(go_back);
+        m_delta_RealTime = MicrosecondsToTimeval<struct timeval>(m_samples.GetDelta(eRealTime, go_back));
+        m_delta_UserTime = m_samples.GetDelta(eUserTime, go_back);
+        m_delta_SystemTime = m_samples.GetDelta(eSystemTime, go_back);
 
-        m_delta_BlockOut = m_BlockOut_tics.GetDelta(go_back);
-        m_delta_BlockInp = m_BlockInp_tics.GetDelta(go_back);
-        m_delta_HardPageFaults = m_HardPageFaults_tics.GetDelta(go_back);
+        m_delta_BlockOut = m_samples.GetDelta(eBlockOut, go_back);
+        m_delta_BlockInp = m_samples.GetDelta(eBlockInp, go_back);
+        m_delta_HardPageFaults = m_samples.GetDelta(eHardPageFaults, go_back);
     }
 
 #endif /* hpux */
@@ -1061,12 +1746,9 @@ namespace SCXSystemLib
      */
     ProcessInstance::ProcessInstance(scxpid_t pid, struct procentry64 *procInfo) :
         EntityInstance(false), m_pid(pid), m_found(true), m_accessViolationEncountered(false),
-        m_scxPriorityValid(false), m_scxPriority(0),
-        m_RealTime_tics(MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES),
-        m_UserTime_tics(MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES),
-        m_SystemTime_tics(MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES)
+        m_scxPriorityValid(false), m_scxPriority(0)
     {
-        m_log = SCXLogHandleFactory::GetLogHandle(moduleIdentifier);
+        m_log = GetInstanceLogHandle();
         SCX_LOGTRACE(m_log, L"ProcessInstance constructor");
 
         snprintf(m_procPsinfoName, sizeof(m_procPsinfoName), "/proc/%d/psinfo", procInfo->pi_pid);
@@ -1279,13 +1961,14 @@ namespace SCXSystemLib
      */
     void ProcessInstance::UpdateDataSampler(struct timeval& realtime)
     {
-        m_RealTime_tics.AddSample(realtime);
+        scxulong row[eSampledCounterCount];
+        row[eRealTime] = TimevalToMicroseconds(realtime);
         /* Please note: Reading these times requires root access on AIX. */
-        m_UserTime_tics.AddSample(m_pstat.pr_utime);     // User time
-        m_SystemTime_tics.AddSample(m_pstat.pr_stime);   // System time
+        row[eUserTime] = TimespecToNanoseconds(m_pstat.pr_utime);
+        row[eSystemTime] = TimespecToNanoseconds(m_pstat.pr_stime);
+        m_samples.AddSamples(row);
 
-        // This is the total time but we can skip it since it's just the u+s sum
-        //m_TotalTime_tics.AddSample(m_pbuf.pr_time);   // System time
+        // The total time (m_pbuf.pr_time) is skipped since it's just the u+s sum
 
         /* If process has become a zombie, record time of death. */
         if (m_timeOfDeath.tv_sec == 0 && IsZombie(m_psinfo) ) { m_timeOfDeath = realtime; }
@@ -1303,12 +1986,9 @@ namespace SCXSystemLib
         // How far we go back for measurement (all the way)
         const size_t go_back = MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES;
 
-        m_delta_RealTime = m_RealTime_tics.GetDelta(go_back);
-        m_delta_UserTime = m_UserTime_tics.GetDelta(go_back);
-        m_delta_SystemTime = m_SystemTime_tics.GetDelta(go_back);
-
-        // This is the total time but we can skip it since it's just the u+s sum
-        //m_delta_TotalTime = m_TotalTime_tics.GetDelta(go_back);
+        m_delta_RealTime = MicrosecondsToTimeval<struct timeval>(m_samples.GetDelta(eRealTime, go_back));
+        m_delta_UserTime = NanosecondsToTimespec<scx_timestruc_t>(m_samples.GetDelta(eUserTime, go_back));
+        m_delta_SystemTime = NanosecondsToTimespec<scx_timestruc_t>(m_samples.GetDelta(eSystemTime, go_back));
     }
 
 #endif /* aix */
@@ -1320,6 +2000,13 @@ namespace SCXSystemLib
      */
     ProcessInstance::~ProcessInstance()
     {
+#if defined(linux)
+        ProcessCommandLinePool::Instance().Release(m_cmdLine);
+        if (NULL != m_procDir)
+        {
+            CloseProcessFiles();
+        }
+#endif
     }
 
     /**
@@ -1550,8 +2237,6 @@ namespace SCXSystemLib
     */
     bool ProcessInstance::GetUserName(wstring& username) const
     {
-        bool fRet = false;
-        register struct passwd *pw;
         uid_t startuid;
 
 #if defined(linux)
@@ -1563,38 +2248,9 @@ namespace SCXSystemLib
 #else
 #error Implementation for ProcessInstanc::GetUserName() method not provided.
 #endif
-        struct passwd pwd;
-        struct passwd *ppwd = NULL;
-        long bufSize = sysconf(_SC_GETPW_R_SIZE_MAX);
-
-        // Sanity check - all platforms have this, but never hurts to be certain
-        if (bufSize < 1024)
-        {
-            bufSize = 1024;
-        }
-
-        std::vector<char> buf(bufSize);
-
-        // Use reentrant form of getpwuid (it's reentrant, and it pacifies purify)
-#if !defined(sun)
-#if defined(linux)
-        __attribute__((__unused__))
-#endif // defined(linux)
-        int rc = 0;
-        rc = getpwuid_r(startuid, &pwd, &buf[0], buf.size(), &ppwd);
-        SCXASSERT( (0 == rc && NULL != ppwd) || (0 != rc && NULL == ppwd) );
-#else
-        ppwd = getpwuid_r(startuid, &pwd, &buf[0], buf.size());
-#endif
-
-        pw = ppwd;
-        if (pw)
-        {
-            username.assign(StrFromUTF8(pw->pw_name));
-            fRet = true;
-        }
 
-        return fRet;
+        // Processes share a handful of owners; avoid a passwd lookup per process
+        return SCXUserCache::Instance().GetUserName(startuid, username);
     }
 
     /**
@@ -2234,22 +2890,59 @@ namespace SCXSystemLib
        \param[out]  params The command line parameters
        \returns     true if this value is supported by the implementation
 
-       Copies member m_params as is to output argument.
+       Copies member m_params as is to output argument. On Linux the command
+       line is read from /proc/#/cmdline on first use after each update;
+       see m_cmdLine.
     */
     bool ProcessInstance::GetParameters(std::vector<std::string>& params) const
     {
         bool fRet = false;
 
+#if defined(linux)
+        {
+            SCXThreadLock lock(m_cmdLineLock);
+            if (m_cmdLineRead)
+            {
+                if (NULL != m_cmdLine)
+                {
+                    params.assign(m_cmdLine->begin(), m_cmdLine->end());
+                    fRet = true;
+                }
+                return fRet;
+            }
+        }
+
+        // Read without holding the lock; if another caller got there first, its command line is kept
+        const ProcessCommandLinePool::CommandLine* cmdLine = ReadCommandLine();
+        SCXThreadLock lock(m_cmdLineLock);
+        if (m_cmdLineRead)
+        {
+            ProcessCommandLinePool::Instance().Release(cmdLine);
+        }
+        else
+        {
+            ProcessCommandLinePool::Instance().Release(m_cmdLine);
+            m_cmdLine = cmdLine;
+            m_cmdLineRead = true;
+        }
+        if (NULL != m_cmdLine)
+        {
+            params.assign(m_cmdLine->begin(), m_cmdLine->end());
+            fRet = true;
+        }
+#else
         if (m_params.size() != 0)
         {
             params.assign(m_params.begin(), m_params.end());
             fRet = true;
         }
+#endif
 
         return fRet;
 
     }
 
+#if !defined(linux)
     /**
        Assigns module and args to m_params.
        \param[in]   module The command line module.
@@ -2284,26 +2977,7 @@ namespace SCXSystemLib
     */
     bool ProcessInstance::UpdateParameters(void)
     {
-#if defined(linux)
-        char procCmdName[MAXPATHLEN];
-        std::string parambuf;
-        bool bFirstParam = true;
-        snprintf(procCmdName, sizeof(procCmdName), "/proc/%u/cmdline", static_cast<unsigned int>(m_pid));
-        ifstream file(procCmdName);
-        if (!file) { return false; } // Process has died, or does no support this
-        m_params.clear();
-        while(getline(file, parambuf, '\0')) {
-            // Interface says two consecutive null bytes ends list; honor that
-            // (We use flag to tell if we've read at least one parameter)
-            if (0 == parambuf.length() && !bFirstParam)
-            {
-                break;
-            }
-            m_params.push_back(parambuf);
-            bFirstParam = false;
-        }
-        return true;
-#elif defined(sun)
+#if defined(sun)
         bool fRet = true;
         std::string psinfoModule;
         std::string psinfoArgs;
@@ -2555,7 +3229,7 @@ namespace SCXSystemLib
 
         return true;
 #elif defined(hpux)
-        m_log = SCXLogHandleFactory::GetLogHandle(moduleIdentifier);
+        m_log = GetInstanceLogHandle();
         bool fRet = false;
         char cmdbuf[1024];
         int cmdlen = 0;
@@ -2731,6 +3405,7 @@ namespace SCXSystemLib
         return false;
 #endif
     }
+#endif // !defined(linux)
 
 #if defined(aix) || defined(hpux)
     /**
@@ -2948,12 +3623,19 @@ namespace SCXSystemLib
        This is an approximation of file writing activity per process.
        Those platforms that support this parameter report an cumulative
        number of block writes. We sample that number and divide by
-       the interval.
+       the interval. On Linux, the bytes written to storage are sampled from
+       /proc/#/io and reported in blocks of PROCESS_IO_BLOCK_SIZE bytes, if
+       ProcessEnumeration::SetIoStatistics() is selected.
     */
     bool ProcessInstance::GetBlockWritesPerSecond(scxulong &bws) const
     {
-#if defined(linux) || defined(aix)
-        /* This is not available on Linux or AIX */
+#if defined(linux)
+        /* Only known if I/O statistics are sampled; blocks of PROCESS_IO_BLOCK_SIZE bytes */
+        bool known = GetIoItemsPerSecond(IoSamples::eWriteBytes, bws);
+        bws /= PROCESS_IO_BLOCK_SIZE;
+        return known;
+#elif defined(aix)
+        /* This is not available on AIX */
         bws = 0;
         return false;
 #elif defined(sun) || defined(hpux)
@@ -2975,12 +3657,19 @@ namespace SCXSystemLib
        This is an approximation of file read activity per process.
        Those platforms that support this parameter report an cumulative
        number of block reads. We sample that number and divide by
-       the interval.
+       the interval. On Linux, the bytes read from storage are sampled from
+       /proc/#/io and reported in blocks of PROCESS_IO_BLOCK_SIZE bytes, if
+       ProcessEnumeration::SetIoStatistics() is selected.
     */
     bool ProcessInstance::GetBlockReadsPerSecond(scxulong &bwr) const
     {
-#if defined(linux) || defined(aix)
-        /* This is not available on Linux or AIX */
+#if defined(linux)
+        /* Only known if I/O statistics are sampled; blocks of PROCESS_IO_BLOCK_SIZE bytes */
+        bool known = GetIoItemsPerSecond(IoSamples::eReadBytes, bwr);
+        bwr /= PROCESS_IO_BLOCK_SIZE;
+        return known;
+#elif defined(aix)
+        /* This is not available on AIX */
         bwr = 0;
         return false;
 #elif defined(sun) || defined(hpux)
@@ -3008,8 +3697,15 @@ namespace SCXSystemLib
     */
     bool ProcessInstance::GetBlockTransfersPerSecond(scxulong &bts) const
     {
-#if defined(linux) || defined(aix)
-        /* This is not available on Linux or AIX */
+#if defined(linux)
+        /* Only known if I/O statistics are sampled; blocks of PROCESS_IO_BLOCK_SIZE bytes */
+        scxulong bwr = 0;
+        bool known = GetIoItemsPerSecond(IoSamples::eReadBytes, bwr) &&
+                     GetIoItemsPerSecond(IoSamples::eWriteBytes, bts);
+        bts = known ? (bwr + bts) / PROCESS_IO_BLOCK_SIZE : 0;
+        return known;
+#elif defined(aix)
+        /* This is not available on AIX */
         bts = 0;
         return false;
 #elif defined(sun) || defined(hpux)
@@ -3155,6 +3851,107 @@ namespace SCXSystemLib
 #endif
     }
 
+    /*====================================================================================*/
+    /* I/O and scheduler statistics                                                       */
+    /*====================================================================================*/
+
+    /**
+       Gets the number of bytes per second recently read from storage by this process.
+
+       \param[out]  rbs Return parameter for the number of bytes
+       \returns     true if a value is supported by the implementation
+
+       Only Linux implements this, from "read_bytes" of /proc/#/io, and only if
+       ProcessEnumeration::SetIoStatistics() is selected. Unless running as
+       root, the value is only known for processes of the same user.
+    */
+    bool ProcessInstance::GetIOReadBytesPerSecond(scxulong &rbs) const
+    {
+#if defined(linux)
+        return GetIoItemsPerSecond(IoSamples::eReadBytes, rbs);
+#else
+        rbs = 0;
+        return false;
+#endif
+    }
+
+    /**
+       Gets the number of bytes per second recently written to storage by this process.
+
+       \param[out]  wbs Return parameter for the number of bytes
+       \returns     true if a value is supported by the implementation
+
+       See GetIOReadBytesPerSecond(); this is "write_bytes" of /proc/#/io.
+    */
+    bool ProcessInstance::GetIOWriteBytesPerSecond(scxulong &wbs) const
+    {
+#if defined(linux)
+        return GetIoItemsPerSecond(IoSamples::eWriteBytes, wbs);
+#else
+        wbs = 0;
+        return false;
+#endif
+    }
+
+    /**
+       Gets the number of read system calls per second recently made by this process.
+
+       \param[out]  rcs Return parameter for the number of calls
+       \returns     true if a value is supported by the implementation
+
+       See GetIOReadBytesPerSecond(); this is "syscr" of /proc/#/io.
+    */
+    bool ProcessInstance::GetIOReadCallsPerSecond(scxulong &rcs) const
+    {
+#if defined(linux)
+        return GetIoItemsPerSecond(IoSamples::eReadCalls, rcs);
+#else
+        rcs = 0;
+        return false;
+#endif
+    }
+
+    /**
+       Gets the number of write system calls per second recently made by this process.
+
+       \param[out]  wcs Return parameter for the number of calls
+       \returns     true if a value is supported by the implementation
+
+       See GetIOReadBytesPerSecond(); this is "syscw" of /proc/#/io.
+    */
+    bool ProcessInstance::GetIOWriteCallsPerSecond(scxulong &wcs) const
+    {
+#if defined(linux)
+        return GetIoItemsPerSecond(IoSamples::eWriteCalls, wcs);
+#else
+        wcs = 0;
+        return false;
+#endif
+    }
+
+    /**
+       Gets how long this process recently waited for a CPU while runnable.
+
+       \param[out]  rds Return parameter for milliseconds of waiting per second
+       \returns     true if a value is supported by the implementation
+
+       Only Linux implements this, from the run delay in /proc/#/schedstat,
+       and only if ProcessEnumeration::SetIoStatistics() is selected. The
+       kernel reports it for the main thread of the process only.
+    */
+    bool ProcessInstance::GetRunDelayPerSecond(scxulong &rds) const
+    {
+#if defined(linux)
+        // Nanoseconds per second, scaled down to milliseconds per second
+        bool known = GetIoItemsPerSecond(IoSamples::eRunDelay, rds);
+        rds /= 1000000;
+        return known;
+#else
+        rds = 0;
+        return false;
+#endif
+    }
+
     /*====================================================================================*/
     /* Properties of SCX_UnixProcessStatisticalInformation, Phase 2                       */
     /*====================================================================================*/
@@ -3263,7 +4060,7 @@ namespace SCXSystemLib
     bool ProcessInstance::GetVirtualText(scxulong &vt) const
     {
 #if defined(linux)
-        vt = n.text * m_pageSize * 1024;
+        vt = m.text * m_pageSize * 1024;
         return true;
 #elif defined(sun)
         CheckRootAccess();
@@ -3308,7 +4105,7 @@ namespace SCXSystemLib
         //
         // Strictly speaking, we could read the 'maps' file in /proc, but
         // given the overhead, it's hardly worth it just for this.
-        vd = n.data * m_pageSize * 1024;
+        vd = m.data * m_pageSize * 1024;
         return true;
 #elif defined(sun) || defined(aix)
         CheckRootAccess();
@@ -3410,7 +4207,7 @@ namespace SCXSystemLib
     bool ProcessInstance::GetVirtualSharedMemory(scxulong &vsm) const
     {
 #if defined(linux)
-        vsm = n.share * m_pageSize;
+        vsm = m.share * m_pageSize;
         return true;
 #elif defined(sun)
         vsm = vsm;
@@ -3535,6 +4332,50 @@ namespace SCXSystemLib
 
     /**************************************************************************/
 
+    /**
+       Gets a compact summary of the process for ranking.
+
+       \param[out]  metrics Return parameter for the summary
+
+       Reads the samples directly, so UpdateTimedValues() need not have been
+       run. Values the platform does not support are zero.
+
+       \note The samples are written by the sampler thread, so the caller
+       must hold the lock of the enumeration that owns this instance, as
+       ProcessEnumeration::TopN() does.
+    */
+    void ProcessInstance::GetMetrics(ProcessMetrics& metrics) const
+    {
+        // How far we go back for measurement (all the way), as UpdateTimedValues()
+        const size_t go_back = MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES;
+
+        metrics.pid = m_pid;
+        metrics.cpuTime = 0;
+        metrics.hardPageFaults = 0;
+        metrics.usedMemory = 0;
+        GetUsedMemory(metrics.usedMemory);
+
+        metrics.interval = m_samples.GetDelta(eRealTime, go_back) / 1000;
+        if (0 == metrics.interval)
+        {
+            return;
+        }
+
+#if defined(linux)
+        metrics.cpuTime = (m_samples.GetDelta(eUserTime, go_back) + m_samples.GetDelta(eSystemTime, go_back)) * 1000000 / m_jiffies_per_second;
+        metrics.hardPageFaults = m_samples.GetDelta(eHardPageFaults, go_back);
+#elif defined(sun) || defined(aix)
+        metrics.cpuTime = (m_samples.GetDelta(eUserTime, go_back) + m_samples.GetDelta(eSystemTime, go_back)) / 1000;
+#if defined(sun)
+        metrics.hardPageFaults = m_samples.GetDelta(eHardPageFaults, go_back);
+#endif
+#elif defined(hpux)
+        // Seconds, see ComputePercentageOfTime()
+        metrics.cpuTime = (m_samples.GetDelta(eUserTime, go_back) + m_samples.GetDelta(eSystemTime, go_back)) * 1000000;
+        metrics.hardPageFaults = m_samples.GetDelta(eHardPageFaults, go_back);
+#endif
+    }
+
     /**
        Sends a signal to the process. 
        This is the normal POSIX signal(2) call applied to the current instance.
@@ -0,0 +1,398 @@
+/*--------------------------------------------------------------------------------
+    Copyright (c) Microsoft Corporation. All rights reserved. See license.txt for license information.
+
+*/
+/**
+    \file
+
+    \brief       Memory-mapped parser of the dpkg status file
+
+    \date        2026-10-17 02:00:00
+
+*/
+/*----------------------------------------------------------------------------*/
+
+#include <scxcorelib/scxcmn.h>
+#include <scxcorelib/scxlog.h>
+#include <scxcorelib/stringaid.h>
+#include <scxsystemlib/dpkgstatus.h>
+
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if !defined(O_CLOEXEC)
+#define O_CLOEXEC 0
+#endif
+
+using namespace SCXCoreLib;
+
+namespace SCXSystemLib
+{
+    /*----------------------------------------------------------------------------*/
+    /**
+        Compare a field with a string, byte by byte.
+
+        \param[in] field  The field.
+        \param[in] str    The string.
+        \param[in] size   Number of bytes of str.
+        \returns   Less than, equal to or greater than 0 as field sorts before,
+                   equal to or after str.
+    */
+    static int Compare(const DPKGStatus::Field& field, const char* str, size_t size)
+    {
+        int diff = memcmp(field.data, str, std::min(field.size, size));
+        if (0 != diff)
+        {
+            return diff;
+        }
+        return field.size < size ? -1 : (field.size > size ? 1 : 0);
+    }
+
+    /** Orders packages by name. */
+    struct PackageNameLess
+    {
+        //! \returns true if a sorts before b
+        bool operator()(const DPKGStatus::Package& a, const DPKGStatus::Package& b) const
+        {
+            return Compare(a.name, b.name.data, b.name.size) < 0;
+        }
+    };
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Make a field of a range, leading and trailing blanks removed.
+
+        \param[in] begin  First byte of the range.
+        \param[in] end    Byte after the range.
+        \returns   The field.
+    */
+    static DPKGStatus::Field MakeField(const char* begin, const char* end)
+    {
+        while (begin < end && (' ' == *begin || '\t' == *begin))
+        {
+            ++begin;
+        }
+        while (end > begin && (' ' == end[-1] || '\t' == end[-1] || '\r' == end[-1]))
+        {
+            --end;
+        }
+        DPKGStatus::Field field;
+        field.data = begin;
+        field.size = static_cast<size_t>(end - begin);
+        return field;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Tell if a key is a given field name.
+
+        \param[in] key   The key.
+        \param[in] size  Number of bytes of key.
+        \param[in] name  The field name.
+        \returns   true if key is name.
+    */
+    static bool IsKey(const char* key, size_t size, const char* name)
+    {
+        return size == strlen(name) && 0 == memcmp(key, name, size);
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Tell if "installed" is one of the space separated words of a status.
+
+        \param[in] status  Value of a "Status" field.
+        \returns   true if the package is installed.
+    */
+    static bool IsInstalled(const DPKGStatus::Field& status)
+    {
+        static const char installed[] = "installed";
+        const size_t size = sizeof(installed) - 1;
+        const char* end = status.data + status.size;
+        for (const char* word = status.data; word < end; )
+        {
+            const char* wordEnd = static_cast<const char*>(memchr(word, ' ', static_cast<size_t>(end - word)));
+            if (NULL == wordEnd)
+            {
+                wordEnd = end;
+            }
+            if (static_cast<size_t>(wordEnd - word) == size && 0 == memcmp(word, installed, size))
+            {
+                return true;
+            }
+            word = wordEnd + 1;
+        }
+        return false;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Constructor
+    */
+    DPKGStatus::DPKGStatus()
+        : m_map(NULL),
+          m_mapSize(0),
+          m_exists(false),
+          m_dev(0),
+          m_ino(0),
+          m_size(0),
+          m_mtime(0),
+          m_mtimeNsec(0),
+          m_parseCount(0)
+    {
+        m_log = SCXLogHandleFactory::GetLogHandle(L"scx.core.common.pal.system.software.dpkgstatus");
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Destructor
+    */
+    DPKGStatus::~DPKGStatus()
+    {
+        Unmap();
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Parse the status file again if it changed since it was last parsed.
+
+        \param[in] path  Path of the status file.
+        \returns   true if the packages changed; false if the file is unchanged,
+                   or still missing.
+
+        A file that is missing or cannot be read holds no packages. A file
+        that cannot be mapped is logged and not stamped, so that it is not
+        taken as parsed; the next refresh tries again.
+    */
+    bool DPKGStatus::Refresh(const std::string& path)
+    {
+        struct stat st;
+        if (0 == stat(path.c_str(), &st) && m_exists &&
+            st.st_dev == m_dev && st.st_ino == m_ino && st.st_size == m_size &&
+            st.st_mtime == m_mtime && st.st_mtim.tv_nsec == m_mtimeNsec)
+        {
+            return false;
+        }
+
+        bool existed = m_exists;
+        Unmap();
+        m_packages.clear();
+        m_exists = false;
+
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return existed;
+        }
+        // Stamp the file actually mapped, in case it was replaced since the stat()
+        if (0 != fstat(fd, &st))
+        {
+            int err = errno;
+            close(fd);
+            SCX_LOGWARNING(m_log, L"Cannot stat " + StrFromUTF8(path) + L": " + StrFrom(err));
+            return existed;
+        }
+        if (st.st_size > 0)
+        {
+            void* map = this->mmap(NULL, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (MAP_FAILED == map)
+            {
+                // Leave the file unstamped, so that the next refresh tries again
+                int err = errno;
+                close(fd);
+                SCX_LOGWARNING(m_log, L"Cannot map " + StrFromUTF8(path) + L": " + StrFrom(err) +
+                               L"; no installed packages until the next refresh");
+                return existed;
+            }
+            m_map = map;
+            m_mapSize = static_cast<size_t>(st.st_size);
+        }
+        close(fd);
+
+        m_exists = true;
+        m_dev = st.st_dev;
+        m_ino = st.st_ino;
+        m_size = st.st_size;
+        m_mtime = st.st_mtime;
+        m_mtimeNsec = st.st_mtim.tv_nsec;
+
+        Parse();
+        return true;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Map a file into memory; see mmap(2).
+    */
+    void* DPKGStatus::mmap(void* addr, size_t length, int prot, int flags, int fd, off_t offset)
+    {
+        return ::mmap(addr, length, prot, flags, fd, offset);
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Find an installed package.
+
+        \param[in] name  Name of the package.
+        \returns   The package, or NULL if it is not installed.
+    */
+    const DPKGStatus::Package* DPKGStatus::Find(const std::string& name) const
+    {
+        size_t low = 0;
+        size_t high = m_packages.size();
+        while (low < high)
+        {
+            size_t mid = low + (high - low) / 2;
+            int diff = Compare(m_packages[mid].name, name.data(), name.size());
+            if (0 == diff)
+            {
+                return &m_packages[mid];
+            }
+            if (diff < 0)
+            {
+                low = mid + 1;
+            }
+            else
+            {
+                high = mid;
+            }
+        }
+        return NULL;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Convert a field to a string.
+
+        \param[in] field  The field.
+        \returns   The field, decoded from UTF-8; empty if the field is missing.
+        \throws    SCXStringConversionException if the field is not valid UTF-8.
+    */
+    std::wstring DPKGStatus::ToString(const Field& field)
+    {
+        if (0 == field.size)
+        {
+            return std::wstring();
+        }
+        return StrFromUTF8(std::string(field.data, field.size));
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Unmap the file, if it is mapped.
+    */
+    void DPKGStatus::Unmap()
+    {
+        if (NULL != m_map)
+        {
+            munmap(m_map, m_mapSize);
+            m_map = NULL;
+            m_mapSize = 0;
+        }
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Scan the mapped file for installed packages.
+
+        Stanzas are separated by empty lines; each line of a stanza is
+        "Key: value", or the continuation of the field before it.
+    */
+    void DPKGStatus::Parse()
+    {
+        ++m_parseCount;
+
+        const char* pos = static_cast<const char*>(m_map);
+        const char* end = pos + m_mapSize;
+        Package package;
+        bool installed = false;
+        for (;;)
+        {
+            const char* lineEnd = pos < end ? static_cast<const char*>(memchr(pos, '\n', static_cast<size_t>(end - pos))) : NULL;
+            if (NULL == lineEnd)
+            {
+                lineEnd = end;
+            }
+
+            if (lineEnd == pos)
+            {
+                // End of the stanza, or of the file
+                if (installed && package.name.size > 0)
+                {
+                    m_packages.push_back(package);
+                }
+                package = Package();
+                installed = false;
+            }
+            else if (' ' != *pos && '\t' != *pos)
+            {
+                const char* colon = static_cast<const char*>(memchr(pos, ':', static_cast<size_t>(lineEnd - pos)));
+                if (NULL != colon)
+                {
+                    size_t keySize = static_cast<size_t>(colon - pos);
+                    Field value = MakeField(colon + 1, lineEnd);
+                    if (IsKey(pos, keySize, "Package"))
+                    {
+                        package.name = value;
+                    }
+                    else if (IsKey(pos, keySize, "Status"))
+                    {
+                        installed = IsInstalled(value);
+                    }
+                    else if (IsKey(pos, keySize, "Version"))
+                    {
+                        package.version = value;
+                    }
+                    else if (IsKey(pos, keySize, "Maintainer"))
+                    {
+                        package.maintainer = value;
+                    }
+                    else if (IsKey(pos, keySize, "Section"))
+                    {
+                        package.section = value;
+                    }
+                    else if (IsKey(pos, keySize, "Homepage"))
+                    {
+                        package.homepage = value;
+                    }
+                    else if (IsKey(pos, keySize, "Description"))
+                    {
+                        package.description = value;
+                    }
+                }
+            }
+
+            if (lineEnd == end)
+            {
+                if (lineEnd == pos)
+                {
+                    break;
+                }
+                // Last line without a newline; end the stanza next round
+                pos = end;
+                continue;
+            }
+            pos = lineEnd + 1;
+        }
+
+        // Of packages given twice, keep the last
+        std::stable_sort(m_packages.begin(), m_packages.end(), PackageNameLess());
+        size_t kept = 0;
+        for (size_t i = 0; i < m_packages.size(); i++)
+        {
+            if (i + 1 < m_packages.size() &&
+                0 == Compare(m_packages[i].name, m_packages[i + 1].name.data, m_packages[i + 1].name.size))
+            {
+                continue;
+            }
+            m_packages[kept++] = m_packages[i];
+        }
+        m_packages.resize(kept);
+    }
+}
+
+/*----------------------------E-N-D---O-F---F-I-L-E---------------------------*/
@@ -39,6 +39,12 @@ Copyright (c) Microsoft Corporation. All rights reserved. See license.txt for li
 
 #if defined(linux)
 #define MAGIC_RPM_SEP "_/=/_"
+
+// Key of the id heading each package of the inventory query
+#define RPM_ID_KEY "NVRA:"
+
+// "Key:value" fields queried for each package
+#define RPM_QUERY_FIELDS "Name:%{Name}" MAGIC_RPM_SEP "Version:%{Version}" MAGIC_RPM_SEP "Vendor:%{Vendor}" MAGIC_RPM_SEP "Release:%{Release}" MAGIC_RPM_SEP "BuildTime:%{BuildTime}" MAGIC_RPM_SEP "InstallTime:%{InstallTime}" MAGIC_RPM_SEP "BuildHost:%{BuildHost}" MAGIC_RPM_SEP "Group:%{Group}" MAGIC_RPM_SEP "SourceRPM:%{SourceRPM}" MAGIC_RPM_SEP "License:%{License}" MAGIC_RPM_SEP "Packager:%{Packager}" MAGIC_RPM_SEP "URL:%{URL}" MAGIC_RPM_SEP "Summary:%{Summary}" MAGIC_RPM_SEP
 #endif
 
 
@@ -62,7 +68,16 @@ namespace SCXSystemLib
         Constructor
     */
     InstalledSoftwareDependencies::InstalledSoftwareDependencies(SCXCoreLib::SCXHandle<SoftwareDependencies> deps)
-        : m_deps(deps)
+        :
+#if defined(linux)
+          m_rpmLock(ThreadLockHandleGet()),
+          m_rpmInventoryRead(false),
+          m_rpmQueryCount(0),
+#endif
+#if defined(linux) && defined(PF_DISTRO_ULINUX)
+          m_dpkgLock(ThreadLockHandleGet()),
+#endif
+          m_deps(deps)
     {
         m_log = SCXLogHandleFactory::GetLogHandle(L"scx.core.common.pal.system.software.installedsoftwaredepencies");
         Init();
@@ -83,183 +98,9 @@ namespace SCXSystemLib
     void InstalledSoftwareDependencies::Init()
     {
 #if defined(linux) && defined(PF_DISTRO_ULINUX)
-        // The librpm functions and the container for the dynamic library symbol handles are not thread safe.
-        SCXThreadLock rpmLock(ThreadLockHandleGet(L"RPMLock"));
-        
-        /**
-           A dpkg status file will have entries similar to this:
-
-Package: testDPKGpackage
-Status: install ok installed
-Priority: important
-Section: net
-Installed-Size: 212
-Maintainer: Marco d'Itri <md@linux.it>
-Architecture: i386
-Source: tcp-wrappers
-Version: 8.6.q-16
-Replaces: libwrap0 (<< 7.6-8)
-Depends: libc6 (>= 2.7-1), libwrap0 (>= 7.6-4~), debconf (>= 0.5) | debconf-2.0
-Description: Wietse Venema's TCP wrapper utilities
- Wietse Venema's network logger, also known as TCPD or LOG_TCP.
- .
- These programs log the client host name of incoming telnet,
- ftp, rsh, rlogin, finger etc. requests.
- .
- Security options are:
-  - access control per host, domain and/or service;
-  - detection of host name spoofing or host address spoofing;
-  - security traps to implement an early-warning system.
-
-Package: nfs-common
-Status: install ok installed
-Priority: standard
-Section: net
-Installed-Size: 504
-Maintainer: Debian kernel team <debian-kernel@lists.debian.org>
-Architecture: i386
-Source: nfs-utils
-Version: 1:1.1.2-6lenny2
-Replaces: mount (<< 2.13~), nfs-client, nfs-kernel-server (<< 1:1.0.7-5)
-Provides: nfs-client
-Depends: portmap | rpcbind, adduser, ucf, lsb-base (>= 1.3-9ubuntu3), netbase (>= 4.24), initscripts (>= 2.86.ds1-38.1), libc6 (>= 2.7-1), libcomerr2 (>= 1.01), libevent1 (>= 1.3e), libgssglue1, libkrb53 (>= 1.6.dfsg.2), libnfsidmap2, librpcsecgss3, libwrap0 (>= 7.6-4~)
-Conflicts: nfs-client
-Conffiles:
- /etc/init.d/nfs-common 2a8ec2053cd94daa29f2c8644c268dd4
-Description: NFS support files common to client and server
- Use this package on any machine that uses NFS, either as client or
- server.  Programs included: lockd, statd, showmount, nfsstat, gssd
- and idmapd.
- .
- Upstream: SourceForge project "nfs", CVS module nfs-utils.
-Homepage: http://nfs.sourceforge.net/
-
-        */
-        /*
-            Notes about my assumptions:
-            1. New packages begin after a newline with nothing on that line
-            2. Lines that begin with a space are part of the description: they can be safely ignored
-            3. Values can be gathered be taking everything following the first colon on a line. (Where the key is everything before the first colon)
-        */
-
-        // parse dpkg "status", if exists, and persist data into DPKGMap
-        // test if the file exists, if not, then return
-        const wstring dpkg_location = m_deps->GetDPKGStatusLocation();
-        if (!SCXFile::Exists(dpkg_location))
-        {
-            return;
-        }
-
-        // read in file /var/lib/dpkg/status
-        vector<wstring> localLines;
-        SCXStream::NLFs nlfs;
-        SCXFile::ReadAllLinesAsUTF8(dpkg_location, localLines, nlfs);
-
-        map<wstring, wstring> keyvalues;
-
-        for (vector<wstring>::iterator line = localLines.begin(); line != localLines.end(); line++)
-        {
-            wstring curStr = *line;
-            if (curStr == L"")
-            {
-                // end this package block and insert all keyvalues into vectorKeyValues
-                if (keyvalues.size() > 0)
-                {
-                    // if "installed" is one of the space separated tokens in the Status: line, insert this into the DPKG map
-                    wstring status = keyvalues[L"Status"];
-                    vector<wstring> statusTokens;
-                    StrTokenize(status, statusTokens, L" ");
-                    
-                    if (find(statusTokens.begin(), statusTokens.end(), L"installed") != statusTokens.end())
-                    {
-                        PackageInfo pkginfo;                    
-                        wstring package = keyvalues[L"Package"];
-                        wstring version = keyvalues[L"Version"];
-                        wstring maintainer = keyvalues[L"Maintainer"];
-                        wstring section = keyvalues[L"Section"];
-                        wstring homepage = keyvalues[L"Homepage"];
-                        wstring description = keyvalues[L"Description"];
-
-                        pkginfo.Name = StrTrim(package);
-                        pkginfo.Version = StrTrim(version);
-                        pkginfo.Vendor = StrTrim(maintainer);
-                        pkginfo.Release = L"";
-                        pkginfo.BuildTime = L"";
-                        pkginfo.InstallTime = L"";
-                        pkginfo.BuildHost = L"";
-                        pkginfo.Group = StrTrim(section);
-                        pkginfo.SourceRPM = L"";
-                        pkginfo.License = L"";
-                        pkginfo.Packager = L"";
-                        pkginfo.URL = StrTrim(homepage);
-                        pkginfo.Summary = StrTrim(description);
-                        DPKGMap[pkginfo.Name] = pkginfo;   
-                    }
-                    
-                    keyvalues.clear();
-                }
-                continue;
-            }
-            
-            if (curStr.substr(0,1) == L" ")
-            {
-                // ignore this line, go to next line
-                continue;
-            }
-            
-            wstring::size_type colonPos;
-            if ( (colonPos = curStr.find_first_of(L":")) == wstring::npos )
-            {
-                // not a valid line, ignore this and include a warning log message
-                
-                
-                
-                continue;
-            }
-            
-            // now this is a valid line, add it to the keyvalues map
-            wstring key = curStr.substr(0, colonPos);
-            wstring value = curStr.substr(colonPos+1);
-            
-            keyvalues[key] = value;
-        }
-        
-        if (keyvalues.size() > 0)
-        {
-            // if "installed" is one of the space separated tokens in the Status: line, insert this into the DPKG map
-            wstring status = keyvalues[L"Status"];
-            vector<wstring> statusTokens;
-            StrTokenize(status, statusTokens, L" ");
-            
-            if (find(statusTokens.begin(), statusTokens.end(), L"installed") != statusTokens.end())
-            {
-                PackageInfo pkginfo;                    
-                wstring package = keyvalues[L"Package"];
-                wstring version = keyvalues[L"Version"];
-                wstring maintainer = keyvalues[L"Maintainer"];
-                wstring section = keyvalues[L"Section"];
-                wstring homepage = keyvalues[L"Homepage"];
-                wstring description = keyvalues[L"Description"];
-                
-                pkginfo.Name = StrTrim(package);
-                pkginfo.Version = StrTrim(version);
-                pkginfo.Vendor = StrTrim(maintainer);
-                pkginfo.Release = L"";
-                pkginfo.BuildTime = L"";
-                pkginfo.InstallTime = L"";
-                pkginfo.BuildHost = L"";
-                pkginfo.Group = StrTrim(section);
-                pkginfo.SourceRPM = L"";
-                pkginfo.License = L"";
-                pkginfo.Packager = L"";
-                pkginfo.URL = StrTrim(homepage);
-                pkginfo.Summary = StrTrim(description);
-                DPKGMap[pkginfo.Name] = pkginfo;   
-            }
-
-            keyvalues.clear();
-        }
-        
+        // Parse the dpkg status file, if it exists; it is parsed again only when it changes
+        SCXThreadLock lock(m_dpkgLock);
+        m_dpkgStatus.Refresh(StrToUTF8(m_deps->GetDPKGStatusLocation()));
 #endif
     }
 
@@ -281,13 +122,11 @@ Homepage: http://nfs.sourceforge.net/
     void InstalledSoftwareDependencies::GetInstalledSoftwareIds(vector<wstring>& ids)
     {
 #if defined(linux)
-        const std::string rpmCommandName = "";
-        const std::string rpmCommandType = "-qa";
-        int argc = 2;
-        char * argv[] = {const_cast<char*>(rpmCommandName.c_str()),
-            const_cast<char*>(rpmCommandType.c_str())};
-
-        GetRPMQueryResult(argc, argv, ids);
+        {
+            SCXThreadLock lock(m_rpmLock);
+            UpdateRPMInventory();
+            ids.insert(ids.end(), m_rpmIds.begin(), m_rpmIds.end());
+        }
 #if defined(PF_DISTRO_ULINUX)
         GetDPKGList(ids);
 #endif
@@ -331,12 +170,13 @@ Homepage: http://nfs.sourceforge.net/
     \param argc : count of arguments of argv.
     \param argv : points to all arguments
     \param result : RPM query result
+    \returns false if there is no rpm executable or the query failed
     \throws SCXErrnoException if popen or pclose fails
     */
-    void InstalledSoftwareDependencies::GetRPMQueryResult(int argc, char * argv[], std::vector<wstring>& result)
+    bool InstalledSoftwareDependencies::GetRPMQueryResult(int argc, char * argv[], std::vector<wstring>& result)
     {
         // We need to redirect stdout to a file so we can capture the result of InvokeRPMQuery() call.
-	std::wstring rpmPath = L"/bin/rpm";
+	std::wstring rpmPath = m_deps->GetRPMLocation();
 	std::wstringstream commandToRun;
 
 	static LogSuppressor warningSuppressor(SCXCoreLib::eWarning, SCXCoreLib::eTrace);
@@ -344,8 +184,8 @@ Homepage: http://nfs.sourceforge.net/
 
 	if (!SCXFile::Exists(SCXFilePath(rpmPath)))
 	{
-	    SCX_LOG(m_log, infoSuppressor.GetSeverity(L"/bin/rpm lookup"), L"No rpm executable at /bin/rpm, therefore skipping rpm package enumeration.");
-	    return;
+	    SCX_LOG(m_log, infoSuppressor.GetSeverity(L"/bin/rpm lookup"), L"No rpm executable at " + rpmPath + L", therefore skipping rpm package enumeration.");
+	    return false;
 	}
 
 	commandToRun << rpmPath;
@@ -363,62 +203,178 @@ Homepage: http://nfs.sourceforge.net/
 	if (returnCode != 0)
 	{
 	    SCX_LOG(m_log, warningSuppressor.GetSeverity(commandToRun.str()), std::wstring(L"RPM command returned nonzero value.  Return value: ") + StrFrom(returnCode) + std::wstring(L", exact command ran: ") + commandToRun.str());
-	    return;
+	    return false;
 	}
 
 	std::wstring wcontent = StrFrom(output.str().c_str());
 	StrReplaceAll(wcontent, StrFrom(MAGIC_RPM_SEP), L"\n");
 	StrTokenize(wcontent, result, L"\n");
-	
+	return true;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+    Tells if the rpm database is unchanged since the inventory was read.
+    Costs one stat() of the database file, or of each candidate file if
+    none existed when the inventory was read.
+    \returns true if the cached inventory is current
+    */
+    bool InstalledSoftwareDependencies::IsRPMInventoryCurrent()
+    {
+        if (!m_rpmInventoryRead)
+        {
+            return false;
+        }
+
+        if (m_rpmDatabaseFile.empty())
+        {
+            // No database before; current as long as there still is none
+            vector<wstring> files = m_deps->GetRPMDatabaseFiles();
+            for (vector<wstring>::const_iterator file = files.begin(); file != files.end(); ++file)
+            {
+                struct stat st;
+                if (0 == stat(StrToUTF8(*file).c_str(), &st))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        struct stat st;
+        if (0 != stat(StrToUTF8(m_rpmDatabaseFile).c_str(), &st))
+        {
+            return false;
+        }
+        return st.st_dev == m_rpmDatabaseStat.st_dev &&
+            st.st_ino == m_rpmDatabaseStat.st_ino &&
+            st.st_size == m_rpmDatabaseStat.st_size &&
+            st.st_mtime == m_rpmDatabaseStat.st_mtime &&
+            st.st_ctime == m_rpmDatabaseStat.st_ctime;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+    Read the RPM inventory again if the rpm database changed since it was read.
+
+    All packages are read by one run of the RPM cli, each record headed by
+    its id (name-version-release.arch, as "rpm -qa" lists it) and followed by
+    the fields GetSoftwareInfoRawData() returns. The database file is looked
+    at before the query runs, so that a change made while it runs is seen
+    the next time. If the query fails, it is run again the next time.
+    Must be called with m_rpmLock held.
+    */
+    void InstalledSoftwareDependencies::UpdateRPMInventory()
+    {
+        if (IsRPMInventoryCurrent())
+        {
+            return;
+        }
+
+        m_rpmInventoryRead = false;
+        m_rpmDatabaseFile.clear();
+        m_rpmIds.clear();
+        m_rpmPackages.clear();
+
+        vector<wstring> files = m_deps->GetRPMDatabaseFiles();
+        for (vector<wstring>::const_iterator file = files.begin(); file != files.end(); ++file)
+        {
+            if (0 == stat(StrToUTF8(*file).c_str(), &m_rpmDatabaseStat))
+            {
+                m_rpmDatabaseFile = *file;
+                break;
+            }
+        }
+
+        const std::string rpmCommandName = "";
+        const std::string rpmCommandType = "-qa";
+        const std::string rpmQueryFormat = "--qf=" RPM_ID_KEY "%{Name}-%{Version}-%{Release}%|Arch?{.%{Arch}}|" MAGIC_RPM_SEP RPM_QUERY_FIELDS;
+        int argc = 3;
+        char * argv[] = {const_cast<char*>(rpmCommandName.c_str()),
+            const_cast<char*>(rpmCommandType.c_str()),
+            const_cast<char*>(rpmQueryFormat.c_str())};
+
+        vector<wstring> lines;
+        ++m_rpmQueryCount;
+        if (!GetRPMQueryResult(argc, argv, lines))
+        {
+            // Without an rpm executable there is nothing to list until the database changes
+            m_rpmInventoryRead = !SCXFile::Exists(SCXFilePath(m_deps->GetRPMLocation()));
+            return;
+        }
+
+        const wstring idKey = StrFrom(RPM_ID_KEY);
+        vector<wstring>* contents = NULL;
+        for (vector<wstring>::const_iterator line = lines.begin(); line != lines.end(); ++line)
+        {
+            if (0 == line->compare(0, idKey.size(), idKey))
+            {
+                wstring id = line->substr(idKey.size());
+                if (m_rpmPackages.find(id) == m_rpmPackages.end())
+                {
+                    m_rpmIds.push_back(id);
+                }
+                contents = &m_rpmPackages[id];
+                contents->clear();
+            }
+            else if (NULL != contents)
+            {
+                contents->push_back(*line);
+            }
+        }
+        m_rpmInventoryRead = true;
+        SCX_LOGTRACE(m_log, L"Read RPM inventory of " + StrFrom(m_rpmIds.size()) + L" packages");
     }
     
 #if defined(PF_DISTRO_ULINUX)
     void InstalledSoftwareDependencies::GetDPKGInfo(const wstring & searchedPackage, vector<wstring>& result)
     {
-        std::map<wstring, PackageInfo>::iterator it = DPKGMap.find(searchedPackage);
-        if (it == DPKGMap.end())
+        SCXThreadLock lock(m_dpkgLock);
+        m_dpkgStatus.Refresh(StrToUTF8(m_deps->GetDPKGStatusLocation()));
+        const DPKGStatus::Package* package = m_dpkgStatus.Find(StrToUTF8(searchedPackage));
+        if (NULL == package)
         {
-            // unable to find package in DPKGMap
+            // unable to find package in the installed DPKGs
             return;
         }
 
-        PackageInfo temppi = it->second;
-        result.push_back(L"Name:" + temppi.Name);
-        result.push_back(L"Version:" + temppi.Version);
-        result.push_back(L"Group:" + temppi.Group);
-        result.push_back(L"URL:" + temppi.URL);
-        result.push_back(L"Summary:" + temppi.Summary);
+        result.push_back(L"Name:" + DPKGStatus::ToString(package->name));
+        result.push_back(L"Version:" + DPKGStatus::ToString(package->version));
+        result.push_back(L"Group:" + DPKGStatus::ToString(package->section));
+        result.push_back(L"URL:" + DPKGStatus::ToString(package->homepage));
+        result.push_back(L"Summary:" + DPKGStatus::ToString(package->description));
     }
 
     void InstalledSoftwareDependencies::GetDPKGList(vector<wstring>& result)
     {
-        for (std::map<wstring, PackageInfo>::iterator it = DPKGMap.begin(); it != DPKGMap.end(); it++)
+        SCXThreadLock lock(m_dpkgLock);
+        m_dpkgStatus.Refresh(StrToUTF8(m_deps->GetDPKGStatusLocation()));
+        const vector<DPKGStatus::Package>& packages = m_dpkgStatus.GetPackages();
+        for (vector<DPKGStatus::Package>::const_iterator it = packages.begin(); it != packages.end(); it++)
         {
-            result.push_back(it->first);
+            result.push_back(DPKGStatus::ToString(it->name));
         }
     }
 #endif
 
     /*----------------------------------------------------------------------------*/
     /**
-    pass "-qi softwareName" params to RPM cli and retrun the raw data about the software.
-    \param softwareName : the productName or displayName of softwareName
+    Get the raw data about the software from the RPM inventory, which is only
+    read again if the rpm database changed.
+    \param softwareName : the id of the software, as returned by GetInstalledSoftwareIds()
     \param contents : Software information date retured by RPM cli
     */
     void InstalledSoftwareDependencies::GetSoftwareInfoRawData(const wstring& softwareName, std::vector<wstring>& contents)
     {
-        const std::string rpmCommandName = "";
-        const std::string rpmCommandType = "-q";
-        const std::string rpmQueryFormat = "--qf=Name:%{Name}" MAGIC_RPM_SEP "Version:%{Version}" MAGIC_RPM_SEP "Vendor:%{Vendor}" MAGIC_RPM_SEP "Release:%{Release}" MAGIC_RPM_SEP "BuildTime:%{BuildTime}" MAGIC_RPM_SEP "InstallTime:%{InstallTime}" MAGIC_RPM_SEP "BuildHost:%{BuildHost}" MAGIC_RPM_SEP "Group:%{Group}" MAGIC_RPM_SEP "SourceRPM:%{SourceRPM}" MAGIC_RPM_SEP "License:%{License}" MAGIC_RPM_SEP "Packager:%{Packager}" MAGIC_RPM_SEP "URL:%{URL}" MAGIC_RPM_SEP "Summary:%{Summary}" MAGIC_RPM_SEP;
-
-        int argc = 4;
-        std::string nSoftwareName = SCXCoreLib::StrToUTF8(StrTrim(softwareName));
-        char * argv[] = {const_cast<char*>(rpmCommandName.c_str()),
-            const_cast<char*>(rpmCommandType.c_str()),
-            const_cast<char*>(rpmQueryFormat.c_str()),
-            const_cast<char*>(nSoftwareName.c_str())};
-
-        GetRPMQueryResult(argc, argv, contents);
+        {
+            SCXThreadLock lock(m_rpmLock);
+            UpdateRPMInventory();
+            map<wstring, vector<wstring> >::const_iterator package = m_rpmPackages.find(StrTrim(softwareName));
+            if (package != m_rpmPackages.end())
+            {
+                contents.insert(contents.end(), package->second.begin(), package->second.end());
+            }
+        }
 
 #if defined(PF_DISTRO_ULINUX)
         // is it ok to make an assumption that RPM and DPKGs are mutually exclusive on the same machine? 
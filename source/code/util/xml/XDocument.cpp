@@ -13,6 +13,8 @@
 /*----------------------------------------------------------------------------*/
 
 #include <stddef.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include <string>
 #include <fstream> 
@@ -22,6 +24,10 @@
 #include <util/XElement.h>
 #include <util/XDocument.h>
 
+#if !defined(O_CLOEXEC)
+#define O_CLOEXEC 0
+#endif
+
 using namespace SCX::Util;
 using namespace SCX::Util::Xml;
 
@@ -114,14 +120,7 @@ void XDocument::Load(const std::string& XmlString, XDocument& doc)
         i++;
     }
 
-    if (i != 0)
-    {
-        XElement::Load(XmlString.substr(i), doc.m_RootElement);
-    }
-    else
-    {
-        XElement::Load(XmlString, doc.m_RootElement);
-    }
+    XElement::Load(XmlString.data() + i, XmlString.size() - i, doc.m_RootElement);
 
     return;
 }
@@ -166,59 +165,25 @@ void XDocument::Load(const std::vector<char>& XMLVector, XDocument& doc)
 */
 void XDocument::LoadFile(const std::string& File, XDocument& doc)
 {
-    std::vector<char> XMLSourceData;
+    // The file is parsed as it is read, so it is never held in memory whole.
+    // A byte order mark is skipped by the reader.
+    int fd = open(File.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        throw XmlException(XDocument::EXCEPTION_FILE_READ_ERROR, File);
+    }
 
-    std::ifstream ClassFile(File.c_str());
-    if (ClassFile.is_open())
+    try
     {
-        // get length of file:
-        ClassFile.seekg (0, std::ios::end);
-        unsigned int Length = static_cast<unsigned int>(ClassFile.tellg());
-
-        // Go back to the beginning
-        ClassFile.seekg (0, std::ios::beg);
-
-        // allocate memory to hold the file.  Here's the trick -- The member
-        // XMLSourceData is a vector, and it needs to be for the rest of the code to
-        // work right.  If you just do a loop and push_back onto the vector, that little
-        // guy is going to resize lots and lots and lots, and that's not a good thing.  So,
-        // instead, we know how many bytes there are in the file from above.  Resize the vector
-        // to get contiguous memory, then do a bulk load.  If I ever see anyone else pulling
-        // clever tricks like this, they'd better explain it at least this well.  Magic isn't cool.
-        //
-        // Yes, vectors are guaranteed to be contiguous memory.
-        // http://herbsutter.com/2008/04/07/cringe-not-vectors-are-guaranteed-to-be-contiguous/
-        XMLSourceData.clear();
-        XMLSourceData.resize(Length+1, '\0');
-
-        // read data as a block:
-        ClassFile.read (&XMLSourceData[0], Length);
-        ClassFile.close();
-
-        // We have to NULL terminate the vector so the parsing routines know where the end of the
-        // data is.  If we don't do this, the parser will continue reading memory until it finds a NULL,
-        // or until it aborts.
-        if (XMLSourceData.size() > 0)
-        {
-	    // If there's a BOM, skip past.  Either way, pass the rest to the Load method.
-            if (XMLSourceData.size() >= 3 &&
-                XMLSourceData[0] == '\xEF' &&
-                XMLSourceData[1] == '\xBB' &&
-                XMLSourceData[2] == '\xBF')
-            {
-                XMLSourceData.erase(XMLSourceData.begin(), XMLSourceData.begin() + 3);
-            }
-
-            Load(&XMLSourceData[0], doc);
-        }
-
-        XMLSourceData.clear();
+        XElement::Load(fd, doc.m_RootElement);
     }
-    else
+    catch (...)
     {
-        throw XmlException(XDocument::EXCEPTION_FILE_READ_ERROR, File);
+        close(fd);
+        throw;
     }
-    
+    close(fd);
+
     return;
 }
 
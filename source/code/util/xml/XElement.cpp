@@ -5,13 +5,17 @@
 
 #include "scxcorelib/scxcmn.h"
 #include <util/XElement.h>
+#include <util/XMLStreamReader.h>
 #include <stack>
+#include <sstream>
 #include <assert.h>
 #include <cctype>
+#include <string.h>
 #include <algorithm>
 
 using namespace SCX::Util;
 using namespace SCX::Util::Xml;
+using SCXCoreLib::StrSpan;
 
 const std::string XElement::EXCEPTION_MESSAGE_EMPTY_NAME            = "The Element name is empty";
 const std::string XElement::EXCEPTION_MESSAGE_NULL_CHILD            = "The child is null";
@@ -430,110 +434,176 @@ void XElement::ToString(Utf8String& xmlString, bool enableLineSeperators)
     m_writer = NULL;
 }
 
-void XElement::Load(const Utf8String& xmlString, XElementPtr& rootElement, bool stripNamespaces /* = true */)
+namespace
 {
-    SCXCoreLib::SCXThreadLock Lock(XElementLoadLock);
-
-    // Create a stack of ElementPtr
-    std::stack<XElementPtr> elementStack;
-    
-    if (xmlString.Empty())
+/*----------------------------------------------------------------------------*/
+/**
+    Builds the tree of XElements for XElement::Load from the events of an
+    XMLStreamReader.
+
+    Names and text are treated as XMLReader treated them: namespace prefixes
+    are stripped if asked for, namespace declarations are not kept as
+    attributes, leading white space of text is dropped, and text that is
+    all white space is ignored. If an element has several runs of text, the
+    last is its content.
+*/
+class XElementBuilder : public XMLEventHandler
+{
+public:
+    /*----------------------------------------------------------------------------*/
+    /**
+        Constructor
+
+        \param [in] stripNamespaces Strip namespace prefixes from names
+    */
+    explicit XElementBuilder(bool stripNamespaces) :
+        m_stripNamespaces(stripNamespaces)
     {
-        throw XmlException(XElement::EXCEPTION_MESSAGE_INPUT_EMPTY, xmlString);
     }
-    
-    XMLReader* reader = new XMLReader();
-    pCXElement parseElement(new CXElement());
 
-    reader->XML_Init(stripNamespaces);
-    reader->XML_SetText(xmlString);
-    
-    XElementPtr currentElement(NULL);
-    int stat;
-    while(1)
+    virtual void OnStartElement(const StrSpan& name)
     {
-        stat = reader->XML_Next(parseElement);
-
-        if (stat != 0)
+        // If current element is not NULL, then this is a child element
+        if (m_current != NULL)
         {
-            break;
+            m_stack.push(m_current);
         }
+        m_current = new XElement(ToUtf8String(LocalName(name)));
+    }
 
-        XML_Type elemType = parseElement->GetType();
+    virtual void OnAttribute(const StrSpan& name, const StrSpan& value)
+    {
+        if (name.Size() >= 5 && memcmp(name.Data(), "xmlns", 5) == 0)
+        {
+            return;
+        }
+        m_current->SetAttributeValue(ToUtf8String(LocalName(name)), ToUtf8String(value));
+    }
 
-        if (elemType ==  XML_START /* || elemType == XML_INSTRUCTION -- JWF -- NOT YET */)
+    virtual void OnText(const StrSpan& text)
+    {
+        size_t start = 0;
+        while (start < text.Size() && IsXmlSpace(text[start]))
         {
-            size_t attributeCount;
-    
-            // if current element is not NULL, then this is a child element
-            // push the current element to the stack
-            if (currentElement != NULL)
-            {
-                elementStack.push(currentElement);
-            }
-  
-            // Create the ElementPtr
-            Utf8String parseElementName = parseElement->GetName();
-            currentElement = new XElement(parseElementName);
-            
-            attributeCount = parseElement->GetAttributeCount();
-            
-            // Loop through the attributes and add them
-            for (size_t i = 0; i < attributeCount; ++i)
-            {
-                currentElement->SetAttributeValue(parseElement->GetAttributeName(static_cast<int>(i)),
-                                                  parseElement->GetAttributeValue(static_cast<int>(i)));
-            }
+            start++;
+        }
+        if (start < text.Size())
+        {
+            m_current->SetContent(ToUtf8String(StrSpan(text.Data() + start, text.Size() - start)));
+        }
+    }
 
-            if (elemType == XML_INSTRUCTION)
-            {
-                currentElement->m_IsProcessingInstruction = true;
-            }
-        } 
-        else if (elemType ==  XML_CHARS)
+    virtual void OnEndElement(const StrSpan& /* name */)
+    {
+        // The current element is complete. The top of the stack contains the parent
+        // If the stack is empty then the current element is the root
+        if (!m_stack.empty())
         {
-            // If Chars was found add it as content to the current element
-            currentElement->SetContent(parseElement->GetText());
+            XElementPtr parentElement = m_stack.top();
+            m_stack.pop();
+            parentElement->AddChild(m_current);
+            m_current = parentElement;
         }
-        else if (elemType ==  XML_END)
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Get the root element
+
+        \return The root element once the whole document has been read
+    */
+    XElementPtr GetRoot() const
+    {
+        return m_current;
+    }
+
+private:
+    /** Is c white space to XML? */
+    static bool IsXmlSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    /** Convert a span of UTF-8 */
+    static Utf8String ToUtf8String(const StrSpan& span)
+    {
+        Utf8String result;
+        result.Utf16String::Assign(reinterpret_cast<const Utf8Char*>(span.Data()), span.Size());
+        return result;
+    }
+
+    /** The name with its namespace prefix stripped, if asked for */
+    StrSpan LocalName(const StrSpan& name) const
+    {
+        if (m_stripNamespaces)
         {
-            // The end tag should match to the current tag. The error condition should
-            // have been caught by the reader. In case it is not, it would be a bug on that
-            // library. So setting an assert
-            Utf8String currentName = currentElement->GetName();
-            Utf8String parseName = parseElement->GetName();
-            assert(currentName == parseName);
-            
-            // The current element is complete. The top of the stack contains the parent
-            // If the stack is empty then the current element is the root
-            if (!elementStack.empty())
+            const char* colon = static_cast<const char*>(memchr(name.Data(), ':', name.Size()));
+            if (colon != NULL)
             {
-                // Get the parent Element
-                XElementPtr parentElement = elementStack.top();
-                
-                // Pop the stack to remove the parent element
-                elementStack.pop();
-                
-                // Add the current element as a child 
-                parentElement->AddChild(currentElement);
-                
-                // Set the current element as the parent
-                currentElement = parentElement;
+                return StrSpan(colon + 1, name.Size() - static_cast<size_t>(colon + 1 - name.Data()));
             }
         }
+        return name;
     }
-    
-    //Check for errors if any throw exception
-    if (reader->XML_GetError())
+
+    /** Strip namespace prefixes from names */
+    bool m_stripNamespaces;
+
+    /** The element being built */
+    XElementPtr m_current;
+
+    /** The ancestors of the element being built */
+    std::stack<XElementPtr> m_stack;
+};
+}
+
+void XElement::Load(const Utf8String& xmlString, XElementPtr& rootElement, bool stripNamespaces /* = true */)
+{
+    if (xmlString.Empty())
     {
-        std::string errorMsg(reader->XML_GetErrorMessage());
-        delete reader;
-        throw XmlException(errorMsg, xmlString);
+        throw XmlException(XElement::EXCEPTION_MESSAGE_INPUT_EMPTY, xmlString);
+    }
+
+    std::string utf8String(xmlString.Str());
+    XElementBuilder builder(stripNamespaces);
+    XMLStreamReader reader(builder);
+    if (!reader.Parse(utf8String.data(), utf8String.size()))
+    {
+        throw XmlException(reader.GetErrorMessage(), xmlString);
+    }
+
+    rootElement = builder.GetRoot();
+}
+
+void XElement::Load(const char* data, size_t size, XElementPtr& rootElement, bool stripNamespaces /* = true */)
+{
+    if (size == 0)
+    {
+        throw XmlException(XElement::EXCEPTION_MESSAGE_INPUT_EMPTY, "");
     }
 
-    delete reader;
+    XElementBuilder builder(stripNamespaces);
+    XMLStreamReader reader(builder);
+    if (!reader.Parse(data, size))
+    {
+        throw XmlException(reader.GetErrorMessage(), std::string(data, size));
+    }
+
+    rootElement = builder.GetRoot();
+}
+
+void XElement::Load(int fd, XElementPtr& rootElement, bool stripNamespaces /* = true */)
+{
+    XElementBuilder builder(stripNamespaces);
+    XMLStreamReader reader(builder);
+    if (!reader.Parse(fd))
+    {
+        std::ostringstream source;
+        source << "file descriptor " << fd;
+        throw XmlException(reader.GetErrorMessage(), source.str());
+    }
 
-    rootElement = currentElement;
+    rootElement = builder.GetRoot();
 }
 
 
@@ -0,0 +1,812 @@
+/*--------------------------------------------------------------------------------
+    Copyright (c) Microsoft Corporation. All rights reserved. See license.txt for license information.
+
+*/
+/**
+    \file        XMLStreamReader.cpp
+
+    \brief       Implementation of the event driven XML reader
+
+    \date        2026-10-17 05:00:00
+
+*/
+/*----------------------------------------------------------------------------*/
+
+#include <scxcorelib/scxcmn.h>
+#include <util/XMLStreamReader.h>
+
+#include <algorithm>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+using namespace SCX::Util::Xml;
+using SCXCoreLib::StrSpan;
+
+const size_t XMLStreamReader::MAX_NESTED;
+const size_t XMLStreamReader::DEFAULT_CHUNK_SIZE;
+
+namespace
+{
+    const size_t npos = static_cast<size_t>(-1);
+
+    //! \returns true if c is XML white space
+    inline bool IsSpace(char c)
+    {
+        return ' ' == c || '\t' == c || '\n' == c || '\r' == c;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Tell if a byte may start a name.
+
+        \param[in] c  The byte.
+        \returns   true for letters, '_', ':' and any byte of a multibyte character.
+
+        Multibyte characters are not decoded, so names are checked less strictly
+        beyond ASCII than XMLReader checks them.
+    */
+    inline bool IsNameStart(char c)
+    {
+        unsigned char u = static_cast<unsigned char>(c);
+        return u >= 0x80 || (u >= 'a' && u <= 'z') || (u >= 'A' && u <= 'Z') || '_' == u || ':' == u;
+    }
+
+    //! \returns true if c may be in a name after its first character
+    inline bool IsNameChar(char c)
+    {
+        return IsNameStart(c) || (c >= '0' && c <= '9') || '-' == c || '.' == c;
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Append a character as UTF-8.
+
+        \param[in,out] result  Receives the bytes.
+        \param[in]     cp      Code point of the character.
+    */
+    void AppendUTF8(std::string& result, unsigned long cp)
+    {
+        if (cp < 0x80)
+        {
+            result += static_cast<char>(cp);
+        }
+        else if (cp < 0x800)
+        {
+            result += static_cast<char>(0xC0 | (cp >> 6));
+            result += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+        else if (cp < 0x10000)
+        {
+            result += static_cast<char>(0xE0 | (cp >> 12));
+            result += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            result += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+        else
+        {
+            result += static_cast<char>(0xF0 | (cp >> 18));
+            result += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            result += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            result += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    }
+
+    /*----------------------------------------------------------------------------*/
+    /**
+        Find the character a character reference stands for.
+
+        \param[in]  ref  What is between "&#" and ';'.
+        \param[out] cp   Receives the code point.
+        \returns    false if ref is not a number, or not that of a character.
+    */
+    bool ParseCharRef(const StrSpan& ref, unsigned long& cp)
+    {
+        size_t i = 0;
+        unsigned long base = 10;
+        if (ref.Size() > 0 && 'x' == ref[0])
+        {
+            base = 16;
+            i = 1;
+        }
+        if (i == ref.Size())
+        {
+            return false;
+        }
+        unsigned long value = 0;
+        for ( ; i < ref.Size(); i++)
+        {
+            char c = ref[i];
+            unsigned long digit;
+            if (c >= '0' && c <= '9')
+            {
+                digit = static_cast<unsigned long>(c - '0');
+            }
+            else if (16 == base && c >= 'a' && c <= 'f')
+            {
+                digit = static_cast<unsigned long>(c - 'a' + 10);
+            }
+            else if (16 == base && c >= 'A' && c <= 'F')
+            {
+                digit = static_cast<unsigned long>(c - 'A' + 10);
+            }
+            else
+            {
+                return false;
+            }
+            value = value * base + digit;
+            if (value > 0x10FFFF)
+            {
+                return false;
+            }
+        }
+        if (0 == value || (value >= 0xD800 && value <= 0xDFFF))
+        {
+            return false;
+        }
+        cp = value;
+        return true;
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+/**
+   Constructor
+
+   \param [in] handler Receives the events; must outlive the reader
+*/
+XMLStreamReader::XMLStreamReader(XMLEventHandler& handler)
+    : m_handler(handler),
+      m_data(NULL),
+      m_pos(0),
+      m_end(0),
+      m_fd(-1),
+      m_chunkSize(DEFAULT_CHUNK_SIZE),
+      m_rootDone(false)
+{
+}
+
+/*----------------------------------------------------------------------------*/
+/**
+   Parse a document in a buffer
+
+   \param [in] data First byte of the document
+   \param [in] size Number of bytes of the document
+   \returns    false if the document is not well formed; see GetErrorMessage()
+*/
+bool XMLStreamReader::Parse(const char* data, size_t size)
+{
+    m_data = data;
+    m_pos = 0;
+    m_end = size;
+    m_fd = -1;
+    return Run();
+}
+
+/*----------------------------------------------------------------------------*/
+/**
+   Parse a document read from a file descriptor
+
+   \param [in] fd Descriptor to read from; it is not closed
+   \param [in] chunkSize Bytes to read at a time
+   \returns    false if the document is not well formed or cannot be read;
+               see GetErrorMessage()
+*/
+bool XMLStreamReader::Parse(int fd, size_t chunkSize)
+{
+    m_data = NULL;
+    m_pos = 0;
+    m_end = 0;
+    m_fd = fd;
+    m_chunkSize = chunkSize > 0 ? chunkSize : DEFAULT_CHUNK_SIZE;
+
+    bool result = Run();
+
+    m_fd = -1;
+    m_data = NULL;
+    std::vector<char>().swap(m_buffer);
+    return result;
+}
+
+/*----------------------------------------------------------------------------*/
+/**
+   Parse the document from the start up to the end of its root element
+
+   \returns    false if the document is not well formed or cannot be read
+*/
+bool XMLStreamReader::Run()
+{
+    m_message.clear();
+    m_openNames.clear();
+    m_openOffsets.clear();
+    m_rootDone = false;
+
+    // Skip a UTF-8 byte order mark
+    if (Need(3) && 0 == memcmp(m_data + m_pos, "\xEF\xBB\xBF", 3))
+    {
+        m_pos += 3;
+    }
+
+    while ( ! m_rootDone)
+    {
+        size_t textSize = FindChar(0, '<');
+        if (npos == textSize)
+        {
+            return Raise(m_openOffsets.empty() ? "no root element" : "premature end of input");
+        }
+        if (textSize > 0 && ! ParseText(textSize))
+        {
+            return false;
+        }
+        m_pos += textSize;
+        if ( ! ParseMarkup())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+/**
+   Read more of the document
+
+   \returns    false if there is no more to read, or reading failed
+
+   What has not been parsed yet is moved to the start of the buffer first,
+   so offsets from m_pos stay valid across a refill while m_pos itself
+   becomes 0.
+*/
+bool XMLStreamReader::Refill()
+{
+    if (m_fd < 0)
+    {
+        return false;
+    }
+
+    size_t kept = m_end - m_pos;
+    if (m_pos > 0 && kept > 0)
+    {
+        memmove(&m_buffer[0], &m_buffer[m_pos], kept);
+    }
+    m_pos = 0;
+    m_end = kept;
+
+    // Grow with what is kept, so a long tag is not read a chunk at a time
+    size_t wanted = std::max(m_chunkSize, kept);
+    if (m_buffer.size() < kept + wanted)
+    {
+        m_buffer.resize(kept + wanted);
+    }
+    m_data = &m_buffer[0];
+
+    ssize_t count;
+    do
+    {
+        count = read(m_fd, &m_buffer[kept], wanted);
+    } while (count < 0 && EINTR == errno);
+
+    if (count < 0)
+    {
+        Raise(std::string("error reading input: ") + strerror(errno));
+        m_fd = -1;
+        return false;
+    }
+    if (0 == count)
+    {
+        m_fd = -1;
+        return false;
+    }
+    m_end += static_cast<size_t>(count);
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+/**
+   Make sure there are some bytes to parse
+
+   \param [in] size Number of bytes needed from m_pos on
+   \returns    false if the document ends before that
+*/
+bool XMLStreamReader::Need(size_t size)
+{
+    while (m_end - m_pos < size)
+    {
+        if ( ! Refill())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+/**
+   Find a byte, reading more of the document as needed
+
+   \param [in] from Offset from m_pos to start looking at
+   \param [in] c The byte
+   \returns    Offset of c from m_pos; npos if the document ends first
+*/
+size_t XMLStreamReader::FindChar(size_t from, char c)
+{
+    for (;;)
+    {
+        size_t avail = m_end - m_pos;
+        if (from < avail)
+        {
+            const char* start = m_data + m_pos;
+            const char* found = static_cast<const char*>(memchr(start + from, c, avail - from));
+            if (NULL != found)
+            {
+                return static_cast<size_t>(found - start);
+            }
+            from = avail;
+        }
+        if ( ! Refill())
+        {
+            return npos;
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+/**
+   Find a string, reading more of the document as needed
+
+   \param [in] from Offset from m_pos to start looking at
+   \param [in] str The string
+   \param [in] size Number of bytes of str
+   \returns    Offset of str from m_pos; npos if the document ends first
+*/
+size_t XMLStreamReader::FindString(size_t from, const char* str, size_t size)
+{
+    for (;;)
+    {
+        size_t avail = m_end - m_pos;
+        const char* start = m_data + m_pos;
+        while (from + size <= avail)
+        {
+            const char* found = static_cast<const char*>(memchr(start + from, str[0], avail - from - size + 1));
+            if (NULL == found)
+            {
+                from = avail - size + 1;
+                break;
+            }
+            from = static_cast<size_t>(found - start);
+            if (0 == memcmp(found, str, size))
+            {
+                return from;
+            }
+            ++from;
+        }
+        if ( ! Refill())
+        {
+            return npos;
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+/**
+   Find the '>' that ends a tag, reading more of the document as needed
+
+   \param [in] from Offset from m_pos to start looking at
+   \returns    Offset of the '>' from m_pos; npos if the document ends first
+
+   A '>' in a quoted attribute value does not end the tag.
+*/
+size_t XMLStreamReader::FindTagEnd(size_t from)
+{
+    char quote = '\0';
+    for (;;)
+    {
+        size_t avail = m_end - m_pos;
+        const char* start = m_data + m_pos;
+        for ( ; from < avail; ++from)
+        {
+            char c = start[from];
+            if ('\0' != quote)
+            {
+                if (c == quote)
+                {
+                    quote = '\0';
+                }
+            }
+            else if ('"' == c || '\'' == c)
+            {
+                quote = c;
+            }
+            else if ('>' == c)
+            {
+                return from;
+            }
+        }
+        if ( ! Refill())
+        {
+            return npos;
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+/**
+   Hand over the text in front of the next tag
+
+   \param [in] size Number of bytes of the text, from m_pos on
+   \returns    false if the text is not allowed
+*/
+bool XMLStreamReader::ParseText(size_t size)
+{
+    const char* text = m_data + m_pos;
+    if (m_openOffsets.empty())
+    {
+        // Only white space may surround the root element
+        for (size_t i = 0; i < size; i++)
+        {
+            if ( ! IsSpace(text[i]))
+            {
+                return Raise("character data outside root element");
+            }
+        }
+        return true;
+    }
+
+    if (NULL == memchr(text, '&', size))
+    {
+        m_handler.OnText(StrSpan(text, size));
+        return true;
+    }
+    if ( ! Decode(text, size, m_decoded))
+    {
+        return false;
+    }
+    m_handler.OnText(StrSpan(m_decoded.data(), m_decoded.size()));
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+/**
+   Parse what starts with the '<' at m_pos
+
+   \returns    false if it is not well formed
+*/
+bool XMLStreamReader::ParseMarkup()
+{
+    if ( ! Need(2))
+    {
+        return Raise("premature end of input");
+    }
+
+    size_t end;
+    switch (m_data[m_pos + 1])
+    {
+    case '/':
+        end = FindChar(2, '>');
+        if (npos == end)
+        {
+            return Raise("premature end of input");
+        }
+        return ParseEndTag(end);
+
+    case '?':
+        // Processing instructions, such as the XML declaration, are skipped
+        end = FindString(2, "?>", 2);
+        if (npos == end)
+        {
+            return Raise("unterminated processing instruction");
+        }
+        m_pos += end + 2;
+        return true;
+
+    case '!':
+        if (Need(4) && 0 == memcmp(m_data + m_pos + 2, "--", 2))
+        {
+            end = FindString(4, "-->", 3);
+            if (npos == end)
+            {
+                return Raise("malformed comment");
+            }
+            m_pos += end + 3;
+            return true;
+        }
+        if (Need(9) && 0 == memcmp(m_data + m_pos + 2, "[CDATA[", 7))
+        {
+            end = FindString(9, "]]>", 3);
+            if (npos == end)
+            {
+                return Raise("unterminated CDATA section");
+            }
+            if (m_openOffsets.empty())
+            {
+                return Raise("character data outside root element");
+            }
+            m_handler.OnText(StrSpan(m_data + m_pos + 9, end - 9));
+            m_pos += end + 3;
+            return true;
+        }
+        if (Need(9) && 0 == memcmp(m_data + m_pos + 2, "DOCTYPE", 7))
+        {
+            end = FindChar(9, '>');
+            if (npos == end)
+            {
+                return Raise("unterminated DOCTYPE element");
+            }
+            m_pos += end + 1;
+            return true;
+        }
+        return Raise("expected comment, CDATA, or DOCTYPE");
+
+    default:
+        end = FindTagEnd(1);
+        if (npos == end)
+        {
+            return Raise("premature end of input");
+        }
+        return ParseStartTag(end);
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+/**
+   Parse a start tag or an empty element tag
+
+   \param [in] end Offset from m_pos of the '>' ending the tag
+   \returns    false if the tag is not well formed
+*/
+bool XMLStreamReader::ParseStartTag(size_t end)
+{
+    const char* pos = m_data + m_pos + 1;
+    const char* tagEnd = m_data + m_pos + end;
+
+    while (pos < tagEnd && IsSpace(*pos))
+    {
+        ++pos;
+    }
+    if (pos == tagEnd || ! IsNameStart(*pos))
+    {
+        return Raise("expected element name");
+    }
+    const char* name = pos;
+    while (pos < tagEnd && IsNameChar(*pos))
+    {
+        ++pos;
+    }
+    StrSpan elementName(name, static_cast<size_t>(pos - name));
+
+    if (m_openOffsets.size() == MAX_NESTED)
+    {
+        return Raise("element stack overflow");
+    }
+    m_handler.OnStartElement(elementName);
+
+    for (;;)
+    {
+        while (pos < tagEnd && IsSpace(*pos))
+        {
+            ++pos;
+        }
+        if (pos == tagEnd || '/' == *pos)
+        {
+            break;
+        }
+
+        if ( ! IsNameStart(*pos))
+        {
+            return Raise("expected attribute name");
+        }
+        name = pos;
+        while (pos < tagEnd && IsNameChar(*pos))
+        {
+            ++pos;
+        }
+        StrSpan attributeName(name, static_cast<size_t>(pos - name));
+
+        while (pos < tagEnd && IsSpace(*pos))
+        {
+            ++pos;
+        }
+        if (pos == tagEnd || '=' != *pos)
+        {
+            return Raise("expected = character");
+        }
+        ++pos;
+        while (pos < tagEnd && IsSpace(*pos))
+        {
+            ++pos;
+        }
+        if (pos == tagEnd || ('"' != *pos && '\'' != *pos))
+        {
+            return Raise("expected opening quote");
+        }
+
+        // FindTagEnd() saw the closing quote before the end of the tag
+        const char* value = pos + 1;
+        pos = static_cast<const char*>(memchr(value, *pos, static_cast<size_t>(tagEnd - value)));
+        size_t valueSize = static_cast<size_t>(pos - value);
+        ++pos;
+
+        if (NULL == memchr(value, '&', valueSize))
+        {
+            m_handler.OnAttribute(attributeName, StrSpan(value, valueSize));
+        }
+        else
+        {
+            if ( ! Decode(value, valueSize, m_decoded))
+            {
+                return false;
+            }
+            m_handler.OnAttribute(attributeName, StrSpan(m_decoded.data(), m_decoded.size()));
+        }
+    }
+
+    bool empty = false;
+    if (pos < tagEnd)
+    {
+        // Empty element tag: only white space may follow the '/'
+        for (++pos; pos < tagEnd && IsSpace(*pos); ++pos)
+        {
+        }
+        if (pos != tagEnd)
+        {
+            return Raise("expected closing angle bracket");
+        }
+        empty = true;
+    }
+    m_pos += end + 1;
+
+    if (empty)
+    {
+        m_handler.OnEndElement(elementName);
+        m_rootDone = m_openOffsets.empty();
+    }
+    else
+    {
+        m_openOffsets.push_back(m_openNames.size());
+        m_openNames.append(elementName.Data(), elementName.Size());
+    }
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+/**
+   Parse an end tag
+
+   \param [in] end Offset from m_pos of the '>' ending the tag
+   \returns    false if the tag is not well formed or does not end the open element
+*/
+bool XMLStreamReader::ParseEndTag(size_t end)
+{
+    const char* pos = m_data + m_pos + 2;
+    const char* tagEnd = m_data + m_pos + end;
+
+    while (pos < tagEnd && IsSpace(*pos))
+    {
+        ++pos;
+    }
+    if (pos == tagEnd || ! IsNameStart(*pos))
+    {
+        return Raise("expected element name");
+    }
+    const char* name = pos;
+    while (pos < tagEnd && IsNameChar(*pos))
+    {
+        ++pos;
+    }
+    StrSpan elementName(name, static_cast<size_t>(pos - name));
+    while (pos < tagEnd && IsSpace(*pos))
+    {
+        ++pos;
+    }
+    if (pos != tagEnd)
+    {
+        return Raise("expected closing angle bracket");
+    }
+
+    if (m_openOffsets.empty())
+    {
+        return Raise("too many closing tags: " + elementName.ToString());
+    }
+    size_t offset = m_openOffsets.back();
+    size_t openSize = m_openNames.size() - offset;
+    if (openSize != elementName.Size() || 0 != memcmp(m_openNames.data() + offset, elementName.Data(), openSize))
+    {
+        return Raise("open/close tag mismatch: " + m_openNames.substr(offset) + "/" + elementName.ToString());
+    }
+    m_openNames.resize(offset);
+    m_openOffsets.pop_back();
+    m_pos += end + 1;
+
+    m_handler.OnEndElement(elementName);
+    m_rootDone = m_openOffsets.empty();
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+/**
+   Replace the entity and character references of text or an attribute value
+
+   \param [in] data First byte of the text
+   \param [in] size Number of bytes of the text
+   \param [out] result Receives the text with its references replaced
+   \returns    false if there is a reference that is not known or not well formed
+
+   Only the entities predefined by XML are known.
+*/
+bool XMLStreamReader::Decode(const char* data, size_t size, std::string& result)
+{
+    result.clear();
+    const char* end = data + size;
+    while (data < end)
+    {
+        const char* amp = static_cast<const char*>(memchr(data, '&', static_cast<size_t>(end - data)));
+        if (NULL == amp)
+        {
+            result.append(data, static_cast<size_t>(end - data));
+            break;
+        }
+        result.append(data, static_cast<size_t>(amp - data));
+
+        const char* semicolon = static_cast<const char*>(memchr(amp + 1, ';', static_cast<size_t>(end - amp - 1)));
+        if (NULL == semicolon)
+        {
+            return Raise("bad entity reference");
+        }
+        StrSpan ref(amp + 1, static_cast<size_t>(semicolon - amp - 1));
+        if (ref.Size() > 0 && '#' == ref[0])
+        {
+            unsigned long cp;
+            if ( ! ParseCharRef(StrSpan(ref.Data() + 1, ref.Size() - 1), cp))
+            {
+                return Raise("bad character reference");
+            }
+            AppendUTF8(result, cp);
+        }
+        else if (ref.Equals("lt"))
+        {
+            result += '<';
+        }
+        else if (ref.Equals("gt"))
+        {
+            result += '>';
+        }
+        else if (ref.Equals("amp"))
+        {
+            result += '&';
+        }
+        else if (ref.Equals("quot"))
+        {
+            result += '"';
+        }
+        else if (ref.Equals("apos"))
+        {
+            result += '\'';
+        }
+        else
+        {
+            return Raise("bad entity reference");
+        }
+        data = semicolon + 1;
+    }
+    return true;
+}
+
+/*----------------------------------------------------------------------------*/
+/**
+   Note why the parse failed
+
+   \param [in] message The reason
+   \returns    false, so a failing parse can return Raise(...)
+
+   The first reason is kept, so an error reading the input is not hidden
+   by the parse error it leads to.
+*/
+bool XMLStreamReader::Raise(const std::string& message)
+{
+    if (m_message.empty())
+    {
+        m_message = message;
+    }
+    return false;
+}
+
+/*----------------------------E-N-D---O-F---F-I-L-E---------------------------*/
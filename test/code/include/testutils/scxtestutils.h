@@ -18,8 +18,12 @@
 
 #if defined(SCX_UNIX)
 #include <unistd.h>
+#include <sys/time.h>
+#include <time.h>
 #endif
+#include <string>
 #include <scxcorelib/scxfile.h>
+#include <scxcorelib/scxlog.h>
 
 namespace
 {
@@ -128,6 +132,78 @@ namespace SCXCoreLib
             SCXFile::Delete(*this);
         }
     };
+
+#if defined(SCX_UNIX)
+    /*----------------------------------------------------------------------------*/
+    /**
+        Measures elapsed time in benchmark style tests.
+
+        Uses a monotonic clock where there is one. Results are meant to be
+        written with Report(), which logs them instead of cluttering the test
+        output; tests should assert on what they measure where they can.
+    */
+    class TestStopwatch
+    {
+    public:
+        /** Constructor; starts the stopwatch */
+        TestStopwatch()
+        {
+            Restart();
+        }
+
+        /** Starts the stopwatch over */
+        void Restart()
+        {
+            m_start = Now();
+        }
+
+        /**
+            Get the time since the stopwatch was started
+            \returns Elapsed microseconds
+        */
+        double GetElapsedMicroseconds() const
+        {
+            return Now() - m_start;
+        }
+
+        /**
+            Get the average time of a number of operations timed together
+            \param[in] count  Number of operations since the stopwatch was started
+            \returns Elapsed nanoseconds per operation
+        */
+        double GetNanosecondsPer(size_t count) const
+        {
+            return GetElapsedMicroseconds() * 1000.0 / static_cast<double>(count);
+        }
+
+        /**
+            Report a measurement
+            \param[in] what  Description of the measurement
+        */
+        static void Report(const std::wstring& what)
+        {
+            SCX_LOGINFO(SCXLogHandleFactory::GetLogHandle(L"scx.test.benchmark"), what);
+        }
+
+    private:
+        /** Current time in microseconds since some fixed point in time */
+        static double Now()
+        {
+#if defined(CLOCK_MONOTONIC)
+            struct timespec ts;
+            if (0 == clock_gettime(CLOCK_MONOTONIC, &ts))
+            {
+                return static_cast<double>(ts.tv_sec) * 1000000.0 + static_cast<double>(ts.tv_nsec) / 1000.0;
+            }
+#endif
+            struct timeval tv;
+            gettimeofday(&tv, NULL);
+            return static_cast<double>(tv.tv_sec) * 1000000.0 + static_cast<double>(tv.tv_usec);
+        }
+
+        double m_start;     //!< Time the stopwatch was started, in microseconds
+    };
+#endif
 }
 
 
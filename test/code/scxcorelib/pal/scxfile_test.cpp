@@ -60,6 +60,8 @@ class SCXFileTest : public CPPUNIT_NS::TestFixture {
     CPPUNIT_TEST( TestNonBlockingReadNonExistingFile );
     CPPUNIT_TEST( TestNonBlockingReadFileLarger );
     CPPUNIT_TEST( TestNonBlockingReadFileSmaller );
+    CPPUNIT_TEST( TestReadAllBytes );
+    CPPUNIT_TEST( TestReadAllBytesNonExistingFile );
     CPPUNIT_TEST( TestNonBlockingReadOfRandom );
     CPPUNIT_TEST( TestSCXFileHandle );
 #endif
@@ -723,6 +725,34 @@ class SCXFileTest : public CPPUNIT_NS::TestFixture {
         CPPUNIT_ASSERT_MESSAGE("Read data not the expected data",0 == strncmp("ABC123",buf,6));
     }
 
+    void TestReadAllBytes() {
+        vector<wstring> lines;
+        lines.push_back(L"ABC123");
+        SCXFile::WriteAllLinesAsUTF8(m_path1, lines, ios_base::out | ios_base::trunc);
+
+        // A buffer that is too small is grown until all of the file fits
+        vector<char> buf(2);
+        size_t bytesRead = SCXFile::ReadAllBytes(m_path1, buf);
+        CPPUNIT_ASSERT(6 <= bytesRead && bytesRead <= buf.size());
+        CPPUNIT_ASSERT_MESSAGE("Read data not the expected data",0 == strncmp("ABC123",&buf[0],6));
+
+        // A buffer that is large enough is kept as it is
+        size_t size = buf.size();
+        CPPUNIT_ASSERT_EQUAL(bytesRead, SCXFile::ReadAllBytes(m_path1, buf));
+        CPPUNIT_ASSERT_EQUAL(size, buf.size());
+
+#if defined(linux)
+        // procfs files have no size until read
+        vector<char> stat;
+        CPPUNIT_ASSERT(0 < SCXFile::ReadAllBytes(L"/proc/self/stat", stat));
+#endif
+    }
+
+    void TestReadAllBytesNonExistingFile() {
+        vector<char> buf;
+        CPPUNIT_ASSERT_THROW(SCXFile::ReadAllBytes(m_path2, buf), SCXFilePathNotFoundException);
+    }
+
     void verifyIsClosed_FILE(FILE *fp, const char* msg) {
         /*
           Behavior of fileno() varies by system.  On some systems, it actually verifies the file (even if
@@ -0,0 +1,289 @@
+/*--------------------------------------------------------------------------------
+    Copyright (c) Microsoft Corporation.  All rights reserved.
+
+    Created date    2026-10-16 09:00:00
+
+    Test class for SCXSampleScheduler PAL.
+
+*/
+/*----------------------------------------------------------------------------*/
+#include <scxcorelib/scxcmn.h>
+#include <scxcorelib/scxatomic.h>
+#include <scxcorelib/scxsamplescheduler.h>
+
+#include <testutils/scxunit.h>
+
+#include <unistd.h>
+
+using namespace SCXCoreLib;
+
+namespace
+{
+    class TestSamplerParam : public SCXThreadParam
+    {
+    public:
+        TestSamplerParam(int stopAfter = 0, useconds_t sleepFor = 0)
+            : SCXThreadParam(),
+              m_count(0),
+              m_stopAfter(stopAfter),
+              m_sleepFor(sleepFor),
+              m_inCallback(false)
+        {
+        }
+
+        scx_atomic_t m_count;
+        int m_stopAfter;
+        useconds_t m_sleepFor;
+        volatile bool m_inCallback;
+    };
+
+    void TestSampler(SCXThreadParamHandle& param)
+    {
+        TestSamplerParam* p = static_cast<TestSamplerParam*>(param.GetData());
+        p->m_inCallback = true;
+        if (p->m_sleepFor)
+        {
+            usleep(p->m_sleepFor);
+        }
+        scx_atomic_increment(&p->m_count);
+        if (p->m_stopAfter && p->m_count >= p->m_stopAfter)
+        {
+            p->SetTerminateFlag();
+        }
+        p->m_inCallback = false;
+    }
+
+    void ThrowingSampler(SCXThreadParamHandle& param)
+    {
+        TestSamplerParam* p = static_cast<TestSamplerParam*>(param.GetData());
+        scx_atomic_increment(&p->m_count);
+        throw SCXInternalErrorException(L"Sampler failure", SCXSRCLOCATION);
+    }
+
+    // Waits for a sampler to run at least count times. The bound only
+    // keeps a broken scheduler from hanging the test.
+    bool WaitForCount(TestSamplerParam* p, int count)
+    {
+        for (int i = 0; i < 10000 && p->m_count < count; i++)
+        {
+            usleep(1000);
+        }
+        return p->m_count >= count;
+    }
+}
+
+/**
+    Scheduler driven by a clock that only moves when the test says so.
+ */
+class TestClockScheduler : public SCXSampleScheduler
+{
+public:
+    TestClockScheduler() : m_lock(ThreadLockHandleGet()), m_now(3600 * 1000) {}
+
+    void Advance(scxulong ms)
+    {
+        {
+            SCXThreadLock lock(m_lock);
+            m_now += ms;
+        }
+        ClockChanged();
+    }
+
+    // Waits for the scheduler to have run at least count callbacks. A
+    // callback is counted once its next deadline is set, so the clock can be
+    // advanced safely afterwards.
+    bool WaitForSamples(scxulong count)
+    {
+        for (int i = 0; i < 10000 && GetSampleCount() < count; i++)
+        {
+            usleep(1000);
+        }
+        return GetSampleCount() >= count;
+    }
+
+protected:
+    virtual scxulong GetTime() const
+    {
+        SCXThreadLock lock(m_lock);
+        return m_now;
+    }
+
+private:
+    SCXThreadLockHandle m_lock;
+    scxulong m_now;
+};
+
+class SCXSampleSchedulerTest : public CPPUNIT_NS::TestFixture
+{
+    CPPUNIT_TEST_SUITE( SCXSampleSchedulerTest );
+    CPPUNIT_TEST( TestDumpString );
+    CPPUNIT_TEST( TestInvalidRegistration );
+    CPPUNIT_TEST( TestFirstSampleIsImmediate );
+    CPPUNIT_TEST( TestPeriodicSampling );
+    CPPUNIT_TEST( TestSamePeriodSharesWakeups );
+    CPPUNIT_TEST( TestUnregisterWaitsForCallback );
+    CPPUNIT_TEST( TestTerminateFlagDropsSampler );
+    CPPUNIT_TEST( TestExceptionDoesNotStopSampling );
+    CPPUNIT_TEST( TestRestartAfterLastUnregister );
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void TestDumpString()
+    {
+        SCXSampleScheduler scheduler;
+        std::wstring str = scheduler.DumpString();
+        CPPUNIT_ASSERT(str.find(L"SCXSampleScheduler") != std::wstring::npos);
+        CPPUNIT_ASSERT(str.find(L"WakeupCount") != std::wstring::npos);
+    }
+
+    void TestInvalidRegistration()
+    {
+        SCXSampleScheduler scheduler;
+        SCXThreadParamHandle param(new TestSamplerParam());
+        CPPUNIT_ASSERT_THROW(scheduler.Register(NULL, param, 100), SCXInvalidArgumentException);
+        CPPUNIT_ASSERT_THROW(scheduler.Register(TestSampler, param, 0), SCXInvalidArgumentException);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), scheduler.GetSamplerCount());
+    }
+
+    void TestFirstSampleIsImmediate()
+    {
+        SCXSampleScheduler scheduler;
+        TestSamplerParam* p = new TestSamplerParam();
+        SCXThreadParamHandle param(p);
+
+        // With a one hour period, only the initial sample can have run
+        SCXSampleScheduler::SamplerId id = scheduler.Register(TestSampler, param, 3600 * 1000);
+        CPPUNIT_ASSERT(0 != id);
+        CPPUNIT_ASSERT(WaitForCount(p, 1));
+        scheduler.Unregister(id);
+        CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(p->m_count));
+    }
+
+    void TestPeriodicSampling()
+    {
+        TestClockScheduler scheduler;
+        TestSamplerParam* p = new TestSamplerParam();
+        SCXThreadParamHandle param(p);
+
+        SCXSampleScheduler::SamplerId id = scheduler.Register(TestSampler, param, 50);
+        CPPUNIT_ASSERT(scheduler.WaitForSamples(1));
+
+        // Less than a period does not make the sampler due
+        scheduler.Advance(49);
+        CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(p->m_count));
+        scheduler.Advance(1);
+        CPPUNIT_ASSERT(scheduler.WaitForSamples(2));
+
+        for (scxulong i = 3; i <= 4; i++)
+        {
+            scheduler.Advance(50);
+            CPPUNIT_ASSERT(scheduler.WaitForSamples(i));
+        }
+        scheduler.Unregister(id);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), scheduler.GetSamplerCount());
+
+        // No more samples once unregistered
+        scheduler.Advance(200);
+        CPPUNIT_ASSERT_EQUAL(4, static_cast<int>(p->m_count));
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(4), scheduler.GetSampleCount());
+    }
+
+    void TestSamePeriodSharesWakeups()
+    {
+        TestClockScheduler scheduler;
+        TestSamplerParam* p1 = new TestSamplerParam();
+        TestSamplerParam* p2 = new TestSamplerParam();
+        SCXThreadParamHandle param1(p1);
+        SCXThreadParamHandle param2(p2);
+
+        SCXSampleScheduler::SamplerId id1 = scheduler.Register(TestSampler, param1, 50);
+        SCXSampleScheduler::SamplerId id2 = scheduler.Register(TestSampler, param2, 50);
+        CPPUNIT_ASSERT(scheduler.WaitForSamples(2));
+        scxulong initialWakeups = scheduler.GetWakeupCount();
+
+        // Both samplers are on the same grid, so after the initial samples
+        // each wakeup services both of them
+        for (scxulong i = 1; i <= 5; i++)
+        {
+            scheduler.Advance(50);
+            CPPUNIT_ASSERT(scheduler.WaitForSamples(2 + 2 * i));
+        }
+        scheduler.Unregister(id1);
+        scheduler.Unregister(id2);
+
+        CPPUNIT_ASSERT_EQUAL(6, static_cast<int>(p1->m_count));
+        CPPUNIT_ASSERT_EQUAL(6, static_cast<int>(p2->m_count));
+        CPPUNIT_ASSERT_EQUAL_MESSAGE(StrToUTF8(scheduler.DumpString()),
+                                     initialWakeups + 5, scheduler.GetWakeupCount());
+    }
+
+    void TestUnregisterWaitsForCallback()
+    {
+        SCXSampleScheduler scheduler;
+        TestSamplerParam* p = new TestSamplerParam(0, 300000);
+        SCXThreadParamHandle param(p);
+
+        SCXSampleScheduler::SamplerId id = scheduler.Register(TestSampler, param, 3600 * 1000);
+        for (int i = 0; i < 10000 && !p->m_inCallback; i++)
+        {
+            usleep(1000);
+        }
+        CPPUNIT_ASSERT(p->m_inCallback);
+
+        scheduler.Unregister(id);
+        CPPUNIT_ASSERT(!p->m_inCallback);
+        CPPUNIT_ASSERT_EQUAL(1, static_cast<int>(p->m_count));
+    }
+
+    void TestTerminateFlagDropsSampler()
+    {
+        TestClockScheduler scheduler;
+        TestSamplerParam* p = new TestSamplerParam(2);
+        SCXThreadParamHandle param(p);
+
+        scheduler.Register(TestSampler, param, 50);
+        CPPUNIT_ASSERT(scheduler.WaitForSamples(1));
+        scheduler.Advance(50);
+        CPPUNIT_ASSERT(scheduler.WaitForSamples(2));
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), scheduler.GetSamplerCount());
+
+        scheduler.Advance(200);
+        CPPUNIT_ASSERT_EQUAL(2, static_cast<int>(p->m_count));
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(2), scheduler.GetSampleCount());
+    }
+
+    void TestExceptionDoesNotStopSampling()
+    {
+        TestClockScheduler scheduler;
+        TestSamplerParam* p = new TestSamplerParam();
+        SCXThreadParamHandle param(p);
+
+        SCXSampleScheduler::SamplerId id = scheduler.Register(ThrowingSampler, param, 50);
+        for (scxulong i = 1; i <= 3; i++)
+        {
+            CPPUNIT_ASSERT(scheduler.WaitForSamples(i));
+            scheduler.Advance(50);
+        }
+        scheduler.Unregister(id);
+        CPPUNIT_ASSERT(p->m_count >= 3);
+    }
+
+    void TestRestartAfterLastUnregister()
+    {
+        TestClockScheduler scheduler;
+        TestSamplerParam* p1 = new TestSamplerParam();
+        TestSamplerParam* p2 = new TestSamplerParam();
+        SCXThreadParamHandle param1(p1);
+        SCXThreadParamHandle param2(p2);
+
+        scheduler.Unregister(scheduler.Register(TestSampler, param1, 50));
+        SCXSampleScheduler::SamplerId id = scheduler.Register(TestSampler, param2, 50);
+        CPPUNIT_ASSERT(WaitForCount(p2, 1));
+        CPPUNIT_ASSERT(scheduler.WaitForSamples(static_cast<scxulong>(p1->m_count) + 1));
+        scheduler.Advance(50);
+        CPPUNIT_ASSERT(WaitForCount(p2, 2));
+        scheduler.Unregister(id);
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( SCXSampleSchedulerTest );
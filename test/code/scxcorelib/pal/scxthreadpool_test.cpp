@@ -94,6 +94,17 @@ class SCXThreadPoolTest : public CPPUNIT_NS::TestFixture
     CPPUNIT_TEST( TestWorkerThreadThrottleDown );
     CPPUNIT_TEST( TestLockRetention );
     CPPUNIT_TEST( TestWorkerStackSize );
+    CPPUNIT_TEST( TestSchedulerModeGetSet );
+    CPPUNIT_TEST( TestWorkStealingQueueItem );
+    CPPUNIT_TEST( TestWorkStealingThrottleUp );
+    CPPUNIT_TEST( TestWorkStealingThrottleDown );
+    CPPUNIT_TEST( TestWorkStealingLockRetention );
+    CPPUNIT_TEST( TestWorkStealingStealsFromOtherQueues );
+    CPPUNIT_TEST( TestQueueTasks );
+    CPPUNIT_TEST( TestWorkStealingQueueTasks );
+    CPPUNIT_TEST( TestStatistics );
+    CPPUNIT_TEST( TestWorkStealingStatistics );
+    CPPUNIT_TEST( TestQueueBurst );
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -181,8 +192,14 @@ public:
     }
 
     void TestWorkerThreadQueueItem()
+    {
+        QueueItem( SCXThreadPool::eSharedQueue );
+    }
+
+    void QueueItem(SCXThreadPool::SchedulerMode mode)
     {
         SCXThreadPool tp;
+        tp.SetSchedulerMode( mode );
         tp.Start();
         VerifyPoolIsRunning( tp, 1 );
 
@@ -205,7 +222,8 @@ public:
 
     // Queue a bunch of work items, make sure they all run, and verify threads are added
     // ThrottleUpThreads is a helper class to be called from elsewhere ...
-    void ThrottleUpThreads(TestableThreadPool* tp, SCXHandle<TestThreadPoolDependencies> deps)
+    void ThrottleUpThreads(TestableThreadPool* tp, SCXHandle<TestThreadPoolDependencies> deps,
+                           SCXThreadPool::SchedulerMode mode = SCXThreadPool::eSharedQueue)
     {
         const long ThreadsToRun = 8;
         const long ItemsToQueue = 128;
@@ -213,6 +231,7 @@ public:
         // Test function - delay worker task execution
         deps->BeginWorkerTaskExecutionDelay();
 
+        tp->SetSchedulerMode( mode );
         tp->SetThreadLimit( ThreadsToRun );
         tp->Start();
         VerifyPoolIsRunning( *tp, 1 );
@@ -268,10 +287,15 @@ public:
     // the reduction actually happened.
 
     void TestWorkerThreadThrottleDown()
+    {
+        ThrottleDown( SCXThreadPool::eSharedQueue );
+    }
+
+    void ThrottleDown(SCXThreadPool::SchedulerMode mode)
     {
         SCXHandle<TestThreadPoolDependencies> deps(new TestThreadPoolDependencies());
         TestableThreadPool tp(deps);
-        ThrottleUpThreads( &tp, deps );
+        ThrottleUpThreads( &tp, deps, mode );
 
         long newThreadCount = tp.GetThreadLimit() / 2;
         CPPUNIT_ASSERT_MESSAGE( "(ThreadLimit / 2) is not > 0!",
@@ -302,8 +326,14 @@ public:
     }
 
     void TestLockRetention()
+    {
+        LockRetention( SCXThreadPool::eSharedQueue );
+    }
+
+    void LockRetention(SCXThreadPool::SchedulerMode mode)
     {
         SCXThreadPool tp;
+        tp.SetSchedulerMode( mode );
         tp.Start();
         VerifyPoolIsRunning( tp, 1 );
 
@@ -390,6 +420,220 @@ public:
         stream << "Worker thread did not run properly, s_executionCount == " << s_executionCount;
         CPPUNIT_ASSERT_MESSAGE( stream.str(), s_executionCount == 1 );
     }
+
+    void TestSchedulerModeGetSet()
+    {
+        SCXThreadPool tp;
+        CPPUNIT_ASSERT_EQUAL( SCXThreadPool::eSharedQueue, tp.GetSchedulerMode() );   // Default mode
+
+        tp.SetSchedulerMode( SCXThreadPool::eWorkStealing );
+        CPPUNIT_ASSERT_EQUAL( SCXThreadPool::eWorkStealing, tp.GetSchedulerMode() );
+
+        // Mode can't be changed while running
+        tp.Start();
+        CPPUNIT_ASSERT_THROW( tp.SetSchedulerMode( SCXThreadPool::eSharedQueue ), SCXInvalidStateException );
+        CPPUNIT_ASSERT( tp.DumpString().find(L"WorkStealing") != std::wstring::npos );
+    }
+
+    void TestWorkStealingQueueItem()
+    {
+        QueueItem( SCXThreadPool::eWorkStealing );
+    }
+
+    void TestWorkStealingThrottleUp()
+    {
+        SCXHandle<TestThreadPoolDependencies> deps(new TestThreadPoolDependencies());
+        TestableThreadPool tp(deps);
+        ThrottleUpThreads( &tp, deps, SCXThreadPool::eWorkStealing );
+    }
+
+    void TestWorkStealingThrottleDown()
+    {
+        ThrottleDown( SCXThreadPool::eWorkStealing );
+    }
+
+    void TestWorkStealingLockRetention()
+    {
+        LockRetention( SCXThreadPool::eWorkStealing );
+    }
+
+    // With only one worker thread left, the tasks spread over the other
+    // worker queues can only run if that worker steals them
+
+    void TestWorkStealingStealsFromOtherQueues()
+    {
+        const long ItemsToQueue = 64;
+
+        SCXThreadPool tp;
+        tp.SetSchedulerMode( SCXThreadPool::eWorkStealing );
+        tp.SetThreadLimit( 4 );         // Four worker queues
+        tp.Start();
+        VerifyPoolIsRunning( tp, 1 );
+        tp.SetThreadLimit( 1 );         // ... but only one worker thread
+
+        s_executionCount = 0;
+        for (int i = 0; i < ItemsToQueue; i++)
+        {
+            SCXThreadParamHandle testParamHandle (new TestParam(&tp));
+            SCXThreadPoolTaskHandle task ( new SCXThreadPoolTask(&TestWorkerThreadQueueItemWorker, testParamHandle) );
+            tp.QueueTask(task);
+        }
+
+        int count = 0;
+        while ( s_executionCount != ItemsToQueue && ++count <= 40 )
+            usleep( 50000 );
+
+        CPPUNIT_ASSERT_EQUAL( static_cast<int>(ItemsToQueue), static_cast<int>(s_executionCount) );
+        CPPUNIT_ASSERT_EQUAL( static_cast<long>(1), tp.GetThreadCount() );
+        CPPUNIT_ASSERT( tp.GetStatistics().tasksStolen > 0 );
+    }
+
+    // Queue a batch of tasks, make sure they all run
+    void QueueTasks(SCXThreadPool::SchedulerMode mode)
+    {
+        const long ItemsToQueue = 1000;
+
+        SCXThreadPool tp;
+        tp.SetSchedulerMode( mode );
+        tp.Start();
+        VerifyPoolIsRunning( tp, 1 );
+
+        s_executionCount = 0;
+        std::vector<SCXThreadPoolTaskHandle> tasks;
+        for (int i = 0; i < ItemsToQueue; i++)
+        {
+            SCXThreadParamHandle testParamHandle (new TestParam(&tp));
+            tasks.push_back( SCXThreadPoolTaskHandle(new SCXThreadPoolTask(&TestWorkerThreadQueueItemWorker, testParamHandle)) );
+        }
+        tp.QueueTasks( tasks );
+
+        int count = 0;
+        while ( s_executionCount != ItemsToQueue && ++count <= 40 )
+            usleep( 50000 );
+
+        CPPUNIT_ASSERT_EQUAL( static_cast<int>(ItemsToQueue), static_cast<int>(s_executionCount) );
+        CPPUNIT_ASSERT_EQUAL( static_cast<scxulong>(ItemsToQueue), tp.GetStatistics().tasksQueued );
+        CPPUNIT_ASSERT( tp.GetThreadCount() > 1 );
+    }
+
+    void TestQueueTasks()
+    {
+        QueueTasks( SCXThreadPool::eSharedQueue );
+    }
+
+    void TestWorkStealingQueueTasks()
+    {
+        QueueTasks( SCXThreadPool::eWorkStealing );
+    }
+
+    // Verify queue depth and task counts while execution is held back, and after
+    void Statistics(SCXThreadPool::SchedulerMode mode)
+    {
+        const long ItemsToQueue = 16;
+
+        SCXHandle<TestThreadPoolDependencies> deps(new TestThreadPoolDependencies());
+        TestableThreadPool tp(deps);
+        deps->BeginWorkerTaskExecutionDelay();
+        tp.SetSchedulerMode( mode );
+        tp.Start();
+        VerifyPoolIsRunning( tp, 1 );
+
+        s_executionCount = 0;
+        for (int i = 0; i < ItemsToQueue; i++)
+        {
+            SCXThreadParamHandle testParamHandle (new TestParam(&tp));
+            SCXThreadPoolTaskHandle task ( new SCXThreadPoolTask(&TestWorkerThreadQueueItemWorker, testParamHandle) );
+            tp.QueueTask(task);
+        }
+
+        SCXThreadPoolStatistics stats = tp.GetStatistics();
+        CPPUNIT_ASSERT_EQUAL( static_cast<scxulong>(ItemsToQueue), stats.queueDepth );
+        CPPUNIT_ASSERT_EQUAL( static_cast<scxulong>(ItemsToQueue), stats.tasksQueued );
+        CPPUNIT_ASSERT_EQUAL( static_cast<scxulong>(0), stats.tasksStarted );
+        CPPUNIT_ASSERT( stats.maxQueueDepth > 0 );
+
+        usleep( 10000 );
+        deps->EndWorkerTaskExecutionDelay( &tp );
+
+        int count = 0;
+        while ( s_executionCount != ItemsToQueue && ++count <= 40 )
+            usleep( 50000 );
+        CPPUNIT_ASSERT_EQUAL( static_cast<int>(ItemsToQueue), static_cast<int>(s_executionCount) );
+
+        stats = tp.GetStatistics();
+        CPPUNIT_ASSERT_EQUAL( static_cast<scxulong>(0), stats.queueDepth );
+        CPPUNIT_ASSERT_EQUAL( static_cast<scxulong>(ItemsToQueue), stats.tasksStarted );
+        CPPUNIT_ASSERT( stats.maxWaitTime >= 10000 );
+        CPPUNIT_ASSERT( stats.totalWaitTime >= stats.maxWaitTime );
+
+        std::wstring dumpString = tp.DumpString();
+        CPPUNIT_ASSERT( dumpString.find(L"QueueDepth") != std::wstring::npos );
+        CPPUNIT_ASSERT( dumpString.find(L"MaxWaitTime") != std::wstring::npos );
+    }
+
+    void TestStatistics()
+    {
+        Statistics( SCXThreadPool::eSharedQueue );
+    }
+
+    void TestWorkStealingStatistics()
+    {
+        Statistics( SCXThreadPool::eWorkStealing );
+    }
+
+    // Queues a burst of trivial tasks and checks that every one is run and accounted for
+    void QueueBurst(SCXThreadPool::SchedulerMode mode, bool batched)
+    {
+        const long ItemsToQueue = 20000;
+
+        SCXThreadPool tp;
+        tp.SetSchedulerMode( mode );
+        tp.Start();
+        VerifyPoolIsRunning( tp, 1 );
+
+        s_executionCount = 0;
+        std::vector<SCXThreadPoolTaskHandle> tasks;
+        for (int i = 0; i < ItemsToQueue; i++)
+        {
+            SCXThreadParamHandle testParamHandle (new TestParam(&tp));
+            tasks.push_back( SCXThreadPoolTaskHandle(new SCXThreadPoolTask(&TestWorkerThreadQueueItemWorker, testParamHandle)) );
+        }
+
+        if ( batched )
+        {
+            tp.QueueTasks( tasks );
+        }
+        else
+        {
+            for (std::vector<SCXThreadPoolTaskHandle>::iterator it = tasks.begin(); it != tasks.end(); ++it)
+                tp.QueueTask( *it );
+        }
+
+        // Wait up to a minute, so that a lost task fails the test instead of hanging it
+        int count = 0;
+        while ( s_executionCount != ItemsToQueue && ++count <= 60000 )
+            usleep( 1000 );
+        CPPUNIT_ASSERT_EQUAL( ItemsToQueue, static_cast<long>(s_executionCount) );
+
+        SCXThreadPoolStatistics stats = tp.GetStatistics();
+        CPPUNIT_ASSERT_EQUAL( static_cast<scxulong>(ItemsToQueue), stats.tasksQueued );
+        CPPUNIT_ASSERT_EQUAL( static_cast<scxulong>(ItemsToQueue), stats.tasksStarted );
+        CPPUNIT_ASSERT_EQUAL( static_cast<scxulong>(0), stats.queueDepth );
+        CPPUNIT_ASSERT( stats.maxQueueDepth >= 1 );
+        CPPUNIT_ASSERT( stats.maxQueueDepth <= static_cast<scxulong>(ItemsToQueue) );
+        if ( SCXThreadPool::eSharedQueue == mode )
+        {
+            CPPUNIT_ASSERT_EQUAL( static_cast<scxulong>(0), stats.tasksStolen );
+        }
+    }
+
+    void TestQueueBurst()
+    {
+        QueueBurst( SCXThreadPool::eSharedQueue, false );
+        QueueBurst( SCXThreadPool::eSharedQueue, true );
+        QueueBurst( SCXThreadPool::eWorkStealing, false );
+        QueueBurst( SCXThreadPool::eWorkStealing, true );
+    }
 };
 
-CPPUNIT_TEST_SUITE_REGISTRATION( SCXThreadPoolTest );
+CPPUNIT_TEST_SUITE_REGISTRATION( SCXThreadPoolTest );
\ No newline at end of file
@@ -0,0 +1,175 @@
+/*--------------------------------------------------------------------------------
+    Copyright (c) Microsoft Corporation.  All rights reserved.
+
+*/
+/**
+    \file
+
+    \brief       Test for the user and group name cache
+
+    \date        2026-10-16 16:00:00
+
+*/
+/*----------------------------------------------------------------------------*/
+#include <scxcorelib/scxcmn.h>
+#include <scxcorelib/scxusercache.h>
+#include <testutils/scxunit.h>
+
+using namespace SCXCoreLib;
+
+/**
+    Cache with fake passwd and group databases and a settable clock.
+ */
+class TestUserCache : public SCXUserCache
+{
+public:
+    TestUserCache() : m_now(1000), m_lookupCount(0) {}
+
+    void SetTime(time_t now) { m_now = now; }
+    size_t GetLookupCount() const { return m_lookupCount; }
+
+protected:
+    virtual bool LookupUserName(SCXUserID uid, std::wstring& name)
+    {
+        ++m_lookupCount;
+        if (uid >= 100)
+        {
+            return false;
+        }
+        name = L"user" + StrFrom(uid);
+        return true;
+    }
+
+    virtual bool LookupGroupName(SCXGroupID gid, std::wstring& name)
+    {
+        ++m_lookupCount;
+        if (gid >= 100)
+        {
+            return false;
+        }
+        name = L"group" + StrFrom(gid);
+        return true;
+    }
+
+    virtual time_t GetTime() const { return m_now; }
+
+private:
+    time_t m_now;
+    size_t m_lookupCount;
+};
+
+class SCXUserCacheTest : public CPPUNIT_NS::TestFixture
+{
+    CPPUNIT_TEST_SUITE( SCXUserCacheTest );
+    CPPUNIT_TEST( callDumpStringForCoverage );
+    CPPUNIT_TEST( TestRootUserName );
+    CPPUNIT_TEST( TestRepeatedLookupIsCached );
+    CPPUNIT_TEST( TestUnknownIdIsNegativelyCached );
+    CPPUNIT_TEST( TestEntriesExpire );
+    CPPUNIT_TEST( TestClockSetBackExpiresEntries );
+    CPPUNIT_TEST( TestUsersAndGroupsAreSeparate );
+    CPPUNIT_TEST( TestClear );
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void callDumpStringForCoverage()
+    {
+        CPPUNIT_ASSERT(SCXUserCache::Instance().DumpString().find(L"SCXUserCache") != std::wstring::npos);
+    }
+
+    void TestRootUserName()
+    {
+        SCXUserCache cache;
+        std::wstring name;
+        CPPUNIT_ASSERT(cache.GetUserName(0, name));
+        CPPUNIT_ASSERT(L"root" == name);
+        CPPUNIT_ASSERT(cache.GetGroupName(0, name));
+        CPPUNIT_ASSERT(L"root" == name);
+    }
+
+    void TestRepeatedLookupIsCached()
+    {
+        TestUserCache cache;
+        std::wstring name;
+
+        for (int i = 0; i < 10; ++i)
+        {
+            CPPUNIT_ASSERT(cache.GetUserName(5, name));
+            CPPUNIT_ASSERT(L"user5" == name);
+        }
+
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), cache.GetLookupCount());
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(9), cache.GetHitCount());
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(1), cache.GetMissCount());
+    }
+
+    void TestUnknownIdIsNegativelyCached()
+    {
+        TestUserCache cache;
+        std::wstring name(L"unchanged");
+
+        CPPUNIT_ASSERT( ! cache.GetUserName(500, name));
+        CPPUNIT_ASSERT( ! cache.GetUserName(500, name));
+        CPPUNIT_ASSERT(L"unchanged" == name);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), cache.GetLookupCount());
+    }
+
+    void TestEntriesExpire()
+    {
+        TestUserCache cache;
+        cache.SetTimeToLive(100, 10);
+        std::wstring name;
+
+        cache.GetUserName(5, name);
+        cache.GetUserName(500, name);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), cache.GetLookupCount());
+
+        // Only the failed lookup has expired
+        cache.SetTime(1010);
+        cache.GetUserName(5, name);
+        cache.GetUserName(500, name);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(3), cache.GetLookupCount());
+
+        // Now both have
+        cache.SetTime(1100);
+        cache.GetUserName(5, name);
+        cache.GetUserName(500, name);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(5), cache.GetLookupCount());
+    }
+
+    void TestClockSetBackExpiresEntries()
+    {
+        TestUserCache cache;
+        std::wstring name;
+
+        cache.GetUserName(5, name);
+        cache.SetTime(500);
+        cache.GetUserName(5, name);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), cache.GetLookupCount());
+    }
+
+    void TestUsersAndGroupsAreSeparate()
+    {
+        TestUserCache cache;
+        std::wstring name;
+
+        CPPUNIT_ASSERT(cache.GetUserName(7, name));
+        CPPUNIT_ASSERT(L"user7" == name);
+        CPPUNIT_ASSERT(cache.GetGroupName(7, name));
+        CPPUNIT_ASSERT(L"group7" == name);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), cache.GetLookupCount());
+    }
+
+    void TestClear()
+    {
+        TestUserCache cache;
+        std::wstring name;
+
+        cache.GetUserName(5, name);
+        cache.Clear();
+        cache.GetUserName(5, name);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), cache.GetLookupCount());
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( SCXUserCacheTest );
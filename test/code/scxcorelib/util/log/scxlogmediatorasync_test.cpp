@@ -0,0 +1,314 @@
+/*--------------------------------------------------------------------------------
+    Copyright (c) Microsoft Corporation.  All rights reserved.
+
+*/
+/**
+    \file
+
+    \brief       Contains tests of the asynchronous log mediator.
+
+    \date        2026-10-16 14:00:00
+
+*/
+/*----------------------------------------------------------------------------*/
+
+#include "scxcorelib/util/log/scxlogmediatorasync.h"
+#include <scxcorelib/scxlogitem.h>
+#include <scxcorelib/scxexception.h>
+#include <scxcorelib/stringaid.h>
+#include "scxcorelib/util/log/scxlogbackend.h"
+#include <testutils/scxunit.h>
+
+#include <scxcorelib/testlogbackend.h>
+
+using namespace SCXCoreLib;
+
+/**
+    Backend that counts what it receives and can be made to block, so that
+    the queue of the mediator fills up.
+ */
+class CountingLogBackend : public TestLogBackend
+{
+public:
+    CountingLogBackend() :
+        m_itemCount(0),
+        m_rotateCount(0),
+        m_itemsAtRotate(0),
+        m_blocked(false)
+    {
+        SetSeverityThreshold(L"", eWarning);
+    }
+
+    void HandleLogRotate()
+    {
+        SCXConditionHandle h(m_cond);
+        m_itemsAtRotate = m_itemCount;
+        ++m_rotateCount;
+    }
+
+    void Block()
+    {
+        SCXConditionHandle h(m_cond);
+        m_blocked = true;
+    }
+
+    void Unblock()
+    {
+        SCXConditionHandle h(m_cond);
+        m_blocked = false;
+        h.Broadcast();
+    }
+
+    scxulong GetItemCount() const { SCXConditionHandle h(m_cond); return m_itemCount; }
+    scxulong GetRotateCount() const { SCXConditionHandle h(m_cond); return m_rotateCount; }
+    scxulong GetItemsAtRotate() const { SCXConditionHandle h(m_cond); return m_itemsAtRotate; }
+
+protected:
+    void DoLogItem(const SCXLogItem& item)
+    {
+        TestLogBackend::DoLogItem(item);
+        SCXConditionHandle h(m_cond);
+        ++m_itemCount;
+        while (m_blocked)
+        {
+            h.Wait();
+        }
+    }
+
+private:
+    mutable SCXCondition m_cond;
+    scxulong m_itemCount;
+    scxulong m_rotateCount;
+    scxulong m_itemsAtRotate;
+    bool m_blocked;
+};
+
+/**
+    Backend that throws on every item and on rotation.
+ */
+class ThrowingLogBackend : public TestLogBackend
+{
+public:
+    ThrowingLogBackend()
+    {
+        SetSeverityThreshold(L"", eWarning);
+    }
+
+    void HandleLogRotate()
+    {
+        throw SCXInternalErrorException(L"Rotation failed", SCXSRCLOCATION);
+    }
+
+protected:
+    void DoLogItem(const SCXLogItem&)
+    {
+        throw SCXInternalErrorException(L"Write failed", SCXSRCLOCATION);
+    }
+};
+
+class SCXLogMediatorAsyncTest : public CPPUNIT_NS::TestFixture
+{
+    CPPUNIT_TEST_SUITE( SCXLogMediatorAsyncTest );
+    CPPUNIT_TEST( TestNoConsumers );
+    CPPUNIT_TEST( TestZeroQueueSizeThrows );
+    CPPUNIT_TEST( TestRegisterConsumer );
+    CPPUNIT_TEST( TestUnregisterConsumer );
+    CPPUNIT_TEST( TestGetEffectiveSeverity );
+    CPPUNIT_TEST( TestItemsKeepOrder );
+    CPPUNIT_TEST( TestFullQueueDropsAndReports );
+    CPPUNIT_TEST( TestRotateFlushesQueuedItems );
+    CPPUNIT_TEST( TestDestructorWritesQueuedItems );
+    CPPUNIT_TEST( TestThrowingConsumerDoesNotStopOthers );
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    SCXLogItem MakeItem(const std::wstring& message)
+    {
+        return SCXLogItem(L"scxcore.something", eWarning, message, SCXSRCLOCATION, 0);
+    }
+
+public:
+
+    void setUp(void)
+    {
+    }
+
+    void tearDown(void)
+    {
+    }
+
+    void TestNoConsumers()
+    {
+        SCXLogMediatorAsync mediator;
+        CPPUNIT_ASSERT_NO_THROW(mediator.LogThisItem(MakeItem(L"cowabunga")));
+        mediator.Flush();
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(1), mediator.GetWrittenCount());
+    }
+
+    void TestZeroQueueSizeThrows()
+    {
+        CPPUNIT_ASSERT_THROW(SCXLogMediatorAsync mediator(0), SCXInvalidArgumentException);
+    }
+
+    void TestRegisterConsumer(void)
+    {
+        SCXLogMediatorAsync mediator;
+        SCXHandle<TestLogBackend> b1( new TestLogBackend() );
+        SCXHandle<TestLogBackend> b2( new TestLogBackend() );
+        b1->SetSeverityThreshold(L"", eWarning);
+        b2->SetSeverityThreshold(L"", eWarning);
+        CPPUNIT_ASSERT( true == mediator.RegisterConsumer(b1) );
+        CPPUNIT_ASSERT( true == mediator.RegisterConsumer(b2) );
+
+        mediator.LogThisItem(MakeItem(L"TestRegisterConsumer"));
+        mediator.Flush();
+
+        CPPUNIT_ASSERT(b1->GetLastLogItem().GetMessage() == L"TestRegisterConsumer");
+        CPPUNIT_ASSERT(b2->GetLastLogItem().GetMessage() == L"TestRegisterConsumer");
+    }
+
+    void TestUnregisterConsumer(void)
+    {
+        SCXLogMediatorAsync mediator;
+        SCXHandle<TestLogBackend> b1( new TestLogBackend() );
+        SCXHandle<TestLogBackend> b2( new TestLogBackend() );
+        b1->SetSeverityThreshold(L"", eWarning);
+        b2->SetSeverityThreshold(L"", eWarning);
+        CPPUNIT_ASSERT( true == mediator.RegisterConsumer(b1) );
+        CPPUNIT_ASSERT( false == mediator.DeRegisterConsumer(b2) );
+        CPPUNIT_ASSERT( true == mediator.RegisterConsumer(b2) );
+
+        mediator.LogThisItem(MakeItem(L"TestUnregisterConsumer"));
+        mediator.Flush();
+        CPPUNIT_ASSERT(b1->GetLastLogItem().GetMessage() == L"TestUnregisterConsumer");
+        CPPUNIT_ASSERT(b2->GetLastLogItem().GetMessage() == L"TestUnregisterConsumer");
+
+        CPPUNIT_ASSERT( true == mediator.DeRegisterConsumer(b1) );
+        mediator.LogThisItem(MakeItem(L"TestUnregisterConsumer2"));
+        mediator.Flush();
+        CPPUNIT_ASSERT(b1->GetLastLogItem().GetMessage() == L"TestUnregisterConsumer");
+        CPPUNIT_ASSERT(b2->GetLastLogItem().GetMessage() == L"TestUnregisterConsumer2");
+    }
+
+    void TestGetEffectiveSeverity(void)
+    {
+        SCXLogMediatorAsync mediator;
+        SCXHandle<TestLogBackend> b1( new TestLogBackend() );
+        SCXHandle<TestLogBackend> b2( new TestLogBackend() );
+
+        b1->SetSeverityThreshold(L"", eWarning);
+        b2->SetSeverityThreshold(L"", eTrace);
+        CPPUNIT_ASSERT( true == mediator.RegisterConsumer(b1) );
+        CPPUNIT_ASSERT( true == mediator.RegisterConsumer(b2) );
+
+        CPPUNIT_ASSERT( eTrace == mediator.GetEffectiveSeverity(L"doesnt.matter") );
+    }
+
+    void TestItemsKeepOrder()
+    {
+        SCXLogMediatorAsync mediator(16);
+        SCXHandle<CountingLogBackend> b( new CountingLogBackend() );
+        mediator.RegisterConsumer(b);
+
+        for (int i = 0; i < 100; ++i)
+        {
+            mediator.LogThisItem(MakeItem(StrFrom(i)));
+            if (0 == i % 10)
+            {
+                mediator.Flush();
+            }
+        }
+        mediator.Flush();
+
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(0), mediator.GetDroppedCount());
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(100), b->GetItemCount());
+        CPPUNIT_ASSERT(b->GetLastLogItem().GetMessage() == L"99");
+    }
+
+    void TestFullQueueDropsAndReports()
+    {
+        SCXLogMediatorAsync mediator(4);
+        SCXHandle<CountingLogBackend> b( new CountingLogBackend() );
+        mediator.RegisterConsumer(b);
+
+        // Make the writer get stuck on the first item
+        b->Block();
+        mediator.LogThisItem(MakeItem(L"first"));
+        while (0 == b->GetItemCount())
+        {
+            SCXThread::Sleep(10);
+        }
+
+        // Fill the queue, then overflow it
+        for (int i = 0; i < 10; ++i)
+        {
+            mediator.LogThisItem(MakeItem(L"queued"));
+        }
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(6), mediator.GetDroppedCount());
+
+        b->Unblock();
+        mediator.Flush();
+
+        // first + 4 queued + the drop report
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(6), b->GetItemCount());
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(5), mediator.GetWrittenCount());
+        CPPUNIT_ASSERT(std::wstring::npos != b->GetLastLogItem().GetMessage().find(L"dropped: 6"));
+    }
+
+    void TestRotateFlushesQueuedItems()
+    {
+        SCXLogMediatorAsync mediator;
+        SCXHandle<CountingLogBackend> b( new CountingLogBackend() );
+        mediator.RegisterConsumer(b);
+
+        for (int i = 0; i < 20; ++i)
+        {
+            mediator.LogThisItem(MakeItem(L"before rotate"));
+        }
+        mediator.HandleLogRotate();
+        mediator.Flush();
+
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(1), b->GetRotateCount());
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(20), b->GetItemsAtRotate());
+    }
+
+    void TestDestructorWritesQueuedItems()
+    {
+        SCXHandle<CountingLogBackend> b( new CountingLogBackend() );
+        {
+            SCXLogMediatorAsync mediator;
+            mediator.RegisterConsumer(b);
+            for (int i = 0; i < 50; ++i)
+            {
+                mediator.LogThisItem(MakeItem(L"queued"));
+            }
+        }
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(50), b->GetItemCount());
+    }
+
+    void TestThrowingConsumerDoesNotStopOthers()
+    {
+        SCXLogMediatorAsync mediator;
+        SCXHandle<CountingLogBackend> b( new CountingLogBackend() );
+        mediator.RegisterConsumer(b);
+        mediator.RegisterConsumer(SCXHandle<ThrowingLogBackend>( new ThrowingLogBackend() ));
+
+        for (int i = 0; i < 10; ++i)
+        {
+            mediator.LogThisItem(MakeItem(L"before rotate"));
+        }
+        mediator.HandleLogRotate();
+        mediator.Flush();
+
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(10), b->GetItemCount());
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(1), b->GetRotateCount());
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(10), b->GetItemsAtRotate());
+
+        // The writer thread survived
+        mediator.LogThisItem(MakeItem(L"after rotate"));
+        mediator.Flush();
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(11), b->GetItemCount());
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( SCXLogMediatorAsyncTest );
@@ -0,0 +1,146 @@
+/*--------------------------------------------------------------------------------
+    Copyright (c) Microsoft Corporation.  All rights reserved.
+
+    Created date    2026-10-16 15:00:00
+
+    Tests for snapshot publication template class.
+
+*/
+/*----------------------------------------------------------------------------*/
+#include <scxcorelib/scxsnapshot.h>
+#include <testutils/scxunit.h>
+#include <scxcorelib/scxthread.h>
+
+using namespace SCXCoreLib;
+
+/**
+    Snapshot data; the two values must always be consistent.
+ */
+class SnapshotTestData
+{
+public:
+    SnapshotTestData(scxulong value, int* pDtorCounter = 0) :
+        m_value(value),
+        m_double(2 * value),
+        m_pDtorCounter(pDtorCounter)
+    {
+    }
+
+    ~SnapshotTestData()
+    {
+        if (0 != m_pDtorCounter)
+        {
+            (*m_pDtorCounter)++;
+        }
+    }
+
+    scxulong m_value;       //!< Some value.
+    scxulong m_double;      //!< Always twice m_value.
+    int* m_pDtorCounter;    //!< Counts destructor calls if not zero.
+};
+
+/**
+    Parameters of the publishing thread.
+ */
+class SnapshotPublisherParam : public SCXThreadParam
+{
+public:
+    SnapshotPublisherParam(SCXSnapshot<const SnapshotTestData>* pSnapshot, scxulong count) :
+        m_pSnapshot(pSnapshot),
+        m_count(count)
+    {
+    }
+
+    SCXSnapshot<const SnapshotTestData>* m_pSnapshot; //!< Where to publish.
+    scxulong m_count;                                  //!< Number of snapshots to publish.
+};
+
+class SCXSnapshotTest : public CPPUNIT_NS::TestFixture
+{
+    CPPUNIT_TEST_SUITE( SCXSnapshotTest );
+    CPPUNIT_TEST( TestNothingPublished );
+    CPPUNIT_TEST( TestPublishReplacesSnapshot );
+    CPPUNIT_TEST( TestReaderKeepsOldSnapshot );
+    CPPUNIT_TEST( TestConcurrentPublishAndGet );
+    SCXUNIT_TEST_ATTRIBUTE(TestConcurrentPublishAndGet, SLOW);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    static void PublisherThreadBody(SCXThreadParamHandle& param)
+    {
+        SnapshotPublisherParam* p = static_cast<SnapshotPublisherParam*>(param.GetData());
+
+        for (scxulong i = 1; i <= p->m_count; ++i)
+        {
+            p->m_pSnapshot->Publish(SCXHandle<const SnapshotTestData>(new SnapshotTestData(i)));
+        }
+    }
+
+public:
+    void TestNothingPublished()
+    {
+        SCXSnapshot<const SnapshotTestData> snapshot;
+
+        CPPUNIT_ASSERT(NULL == snapshot.Get());
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(0), snapshot.GetGeneration());
+    }
+
+    void TestPublishReplacesSnapshot()
+    {
+        SCXSnapshot<const SnapshotTestData> snapshot;
+
+        snapshot.Publish(SCXHandle<const SnapshotTestData>(new SnapshotTestData(1)));
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(1), snapshot.Get()->m_value);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(1), snapshot.GetGeneration());
+
+        snapshot.Publish(SCXHandle<const SnapshotTestData>(new SnapshotTestData(2)));
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(2), snapshot.Get()->m_value);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(2), snapshot.GetGeneration());
+    }
+
+    void TestReaderKeepsOldSnapshot()
+    {
+        int nDtorCount = 0;
+        SCXSnapshot<const SnapshotTestData> snapshot;
+
+        snapshot.Publish(SCXHandle<const SnapshotTestData>(new SnapshotTestData(1, &nDtorCount)));
+        SCXHandle<const SnapshotTestData> old = snapshot.Get();
+
+        snapshot.Publish(SCXHandle<const SnapshotTestData>(new SnapshotTestData(2, &nDtorCount)));
+        CPPUNIT_ASSERT_EQUAL(0, nDtorCount);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(1), old->m_value);
+
+        // The old snapshot goes away with the last reference to it
+        old = 0;
+        CPPUNIT_ASSERT_EQUAL(1, nDtorCount);
+
+        snapshot.Publish(SCXHandle<const SnapshotTestData>(new SnapshotTestData(3)));
+        CPPUNIT_ASSERT_EQUAL(2, nDtorCount);
+    }
+
+    void TestConcurrentPublishAndGet()
+    {
+        const scxulong c_count = 100000;
+        SCXSnapshot<const SnapshotTestData> snapshot;
+
+        SCXThread publisher(SCXSnapshotTest::PublisherThreadBody,
+                            new SnapshotPublisherParam(&snapshot, c_count));
+
+        scxulong last = 0;
+        while (last < c_count)
+        {
+            SCXHandle<const SnapshotTestData> current = snapshot.Get();
+            if (NULL != current)
+            {
+                CPPUNIT_ASSERT_EQUAL(2 * current->m_value, current->m_double);
+                CPPUNIT_ASSERT(current->m_value >= last);
+                last = current->m_value;
+            }
+        }
+
+        publisher.Wait();
+        CPPUNIT_ASSERT_EQUAL(c_count, snapshot.GetGeneration());
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( SCXSnapshotTest );
@@ -9,12 +9,16 @@
 /*----------------------------------------------------------------------------*/
 #include <scxcorelib/scxcmn.h>
 #include <scxcorelib/stringaid.h>
+#include <scxcorelib/stringspan.h>
 #include <scxcorelib/scxexception.h>
 #include <scxcorelib/scxmath.h>
 #include <scxcorelib/scxdumpstring.h>
 #include <scxcorelib/scxlocale.h>
+#include <scxcorelib/scxstream.h>
+#include <scxcorelib/scxutf8.h>
 
 #include <testutils/scxunit.h>
+#include <testutils/scxtestutils.h>
 
 #include <string>
 #include <vector>
@@ -26,6 +30,7 @@
 #include <string.h>
 
 #include <langinfo.h> // To look up codepage (locale)
+#include <sstream>
 
 
 using namespace SCXCoreLib;
@@ -117,8 +122,17 @@ class SCXStringAid_Test : public CPPUNIT_NS::TestFixture
     CPPUNIT_TEST( testFrom );
     CPPUNIT_TEST( testUTF8Conversion );
     CPPUNIT_TEST( testUTF8ConversionFails );
+#if !defined(sun)
+    CPPUNIT_TEST( testUTF8DecodeMatchesStream );
+    CPPUNIT_TEST( testUTF8EncodeMatchesStream );
+    CPPUNIT_TEST( testUTF8Performance );
+#endif
     CPPUNIT_TEST( testMergeTokens );
     CPPUNIT_TEST( testTokenizeWithDelimiters );
+    CPPUNIT_TEST( testSpanTokenizeMatchesStrTokenize );
+    CPPUNIT_TEST( testSpanTokenizeFixedCount );
+    CPPUNIT_TEST( testSpanToNumber );
+    CPPUNIT_TEST( testSpanTokenizePerformance );
     CPPUNIT_TEST( testFromMultibyte );
     CPPUNIT_TEST( testFromMultibyteNoThrow );
     CPPUNIT_TEST( testDumpStringException );
@@ -144,6 +158,11 @@ class SCXStringAid_Test : public CPPUNIT_NS::TestFixture
     CPPUNIT_TEST( test_Quoted_SingleQuotedElement );
     CPPUNIT_TEST( test_Quoted_UnterminatedQuote );
 
+#if !defined(sun)
+    SCXUNIT_TEST_ATTRIBUTE( testUTF8Performance, SLOW );
+#endif
+    SCXUNIT_TEST_ATTRIBUTE( testSpanTokenizePerformance, SLOW );
+
     CPPUNIT_TEST_SUITE_END();
 
 protected:
@@ -496,6 +515,207 @@ protected:
         SCXUNIT_ASSERT_THROWN_EXCEPTION(SCXCoreLib::StrFromUTF8(utf8), SCXCoreLib::SCXStringConversionException, L"Multibyte");
     }
 
+#if !defined(sun)
+    /** Decode as StrFromUTF8() did before, a character at a time from a stream */
+    static bool StreamDecode(const std::string& utf8, std::wstring& result)
+    {
+        try
+        {
+            std::istringstream source(utf8);
+            std::wostringstream target;
+            while (source.peek() != EOF && source.good())
+            {
+                target.put(SCXStream::ReadCharAsUTF8(source));
+            }
+            result = target.str();
+            return true;
+        }
+        catch (SCXLineStreamContentException &)
+        {
+            return false;
+        }
+    }
+
+    /** Encode as StrToUTF8() did before, a character at a time to a stream */
+    static std::string StreamEncode(const std::wstring& str)
+    {
+        std::ostringstream target;
+        SCXStream::WriteAsUTF8(target, str);
+        return target.str();
+    }
+
+    /** Check that StrFromUTF8() decodes, or rejects, as the stream decoder does */
+    static void CheckDecode(const std::string& utf8, UTF8SimdLevel level, size_t offset)
+    {
+        std::ostringstream where;
+        where << "level " << level << ", offset " << offset;
+        std::wstring expected;
+        if (StreamDecode(utf8, expected))
+        {
+            CPPUNIT_ASSERT_MESSAGE(where.str(), expected == SCXCoreLib::StrFromUTF8(utf8));
+        }
+        else
+        {
+            bool thrown = false;
+            try
+            {
+                SCXCoreLib::StrFromUTF8(utf8);
+            }
+            catch (SCXStringConversionException &)
+            {
+                thrown = true;
+            }
+            CPPUNIT_ASSERT_MESSAGE(where.str(), thrown);
+        }
+    }
+
+    /**
+       Sequences, valid and not, are decoded at every offset into a run of
+       ASCII, so that they fall on every position of a vector, with every
+       instruction set.
+    */
+    void testUTF8DecodeMatchesStream()
+    {
+        const char* sequences[] = {
+            "\xC3\xA5",                   // U+00E5, two bytes
+            "\xE3\x82\xB3",              // U+30B3, three bytes
+            "\xF0\x9F\x98\x80",         // U+1F600, four bytes
+            "\xF8\x88\x80\x80\x80",    // U+200000, five bytes
+            "\xFD\xBF\xBF\xBF\xBF\xBF", // U+7FFFFFFF, six bytes
+            "\xC0\x80",                   // Overlong NUL
+            "\xED\xA0\x80",              // Surrogate
+            "\x80",                        // Continuation byte without a lead byte
+            "\xE3\x82",                   // Truncated
+            "\xE3\x41\xB3",              // ASCII instead of a continuation byte
+            "\xFE\x80\x80\x80\x80\x80\x80", // Seven bytes
+            "\xFF",
+        };
+        const size_t sequenceCount = sizeof(sequences) / sizeof(sequences[0]);
+        const std::string ascii(100, 'a');
+
+        UTF8SimdLevel supported = GetUTF8SupportedSimdLevel();
+        for (int level = eUTF8Scalar; level <= supported; level++)
+        {
+            CPPUNIT_ASSERT_EQUAL(static_cast<int>(level), static_cast<int>(SetUTF8SimdLevel(static_cast<UTF8SimdLevel>(level))));
+            for (size_t i = 0; i < sequenceCount; i++)
+            {
+                for (size_t offset = 0; offset <= 70; offset++)
+                {
+                    std::string utf8 = ascii.substr(0, offset) + sequences[i] + ascii.substr(offset);
+                    CheckDecode(utf8, static_cast<UTF8SimdLevel>(level), offset);
+                    // At the very end, truncated sequences lack bytes instead of being followed by ASCII
+                    CheckDecode(ascii.substr(0, offset) + sequences[i], static_cast<UTF8SimdLevel>(level), offset);
+                }
+            }
+            CheckDecode(std::string("ab\0cd", 5), static_cast<UTF8SimdLevel>(level), 2);
+        }
+        SetUTF8SimdLevel(supported);
+    }
+
+    /** Characters of every encoded length are encoded as the stream encoder does */
+    void testUTF8EncodeMatchesStream()
+    {
+        const wchar_t characters[] = {
+            0x7F, 0x80, 0x7FF, 0x800, 0xFFFF, 0x10000, 0x10FFFF,
+            static_cast<wchar_t>(0x3FFFFFF), static_cast<wchar_t>(0x4000000), static_cast<wchar_t>(0x7FFFFFFF), 0
+        };
+        const size_t characterCount = sizeof(characters) / sizeof(characters[0]);
+        const std::wstring ascii(100, L'a');
+
+        UTF8SimdLevel supported = GetUTF8SupportedSimdLevel();
+        for (int level = eUTF8Scalar; level <= supported; level++)
+        {
+            SetUTF8SimdLevel(static_cast<UTF8SimdLevel>(level));
+            for (size_t i = 0; i < characterCount; i++)
+            {
+                for (size_t offset = 0; offset <= 70; offset++)
+                {
+                    std::wstring str = ascii.substr(0, offset) + characters[i] + ascii.substr(offset);
+                    CPPUNIT_ASSERT(StreamEncode(str) == SCXCoreLib::StrToUTF8(str));
+                    CPPUNIT_ASSERT(str == SCXCoreLib::StrFromUTF8(SCXCoreLib::StrToUTF8(str)));
+                }
+            }
+        }
+        SetUTF8SimdLevel(supported);
+    }
+
+    /**
+       Benchmark: transcoding ASCII-heavy and mixed text with the stream
+       based conversion StrFromUTF8() and StrToUTF8() used before, and with
+       each instruction set.
+    */
+    void testUTF8Performance()
+    {
+        std::wstring asciiHeavy;
+        while (asciiHeavy.size() < 64 * 1024)
+        {
+            asciiHeavy += L"/proc/1234/stat: 1234 (bash) S 1 1234 1234 34816 -1 4194560 2093 1 0 0 3 1 0 0 20 0 1 0\n";
+            asciiHeavy += L"/home/user/documents/r\x00E9sum\x00E9.txt\n";
+        }
+        std::wstring mixed;
+        while (mixed.size() < 64 * 1024)
+        {
+            mixed += L"Hello world, \x039A\x03B1\x03BB\x03B7\x03BC\x03AD\x03C1\x03B1 \x03BA\x03CC\x03C3\x03BC\x03B5, "
+                     L"\x30B3\x30F3\x30CB\x30C1\x30CF, \x00E5\x00E4\x00F6\x00C5\x00C4\x00D6\n";
+        }
+
+        const std::wstring* texts[] = { &asciiHeavy, &mixed };
+        const char* names[] = { "ASCII-heavy", "mixed" };
+        const char* levelNames[] = { "scalar", "SSE2", "AVX2" };
+        const int rounds = 20;
+        UTF8SimdLevel supported = GetUTF8SupportedSimdLevel();
+
+        for (int t = 0; t < 2; t++)
+        {
+            std::string utf8 = StreamEncode(*texts[t]);
+            double mb = static_cast<double>(utf8.size()) * rounds / (1024.0 * 1024.0);
+            std::wostringstream report;
+
+            std::wstring decoded;
+            SCXCoreLib::TestStopwatch stopwatch;
+            for (int i = 0; i < rounds; i++)
+            {
+                StreamDecode(utf8, decoded);
+            }
+            double decodeSecs = stopwatch.GetElapsedMicroseconds() / 1000000.0;
+            stopwatch.Restart();
+            for (int i = 0; i < rounds; i++)
+            {
+                StreamEncode(*texts[t]);
+            }
+            double encodeSecs = stopwatch.GetElapsedMicroseconds() / 1000000.0;
+            report << names[t] << L" (" << utf8.size() << L" bytes) stream: decode " << mb / decodeSecs
+                   << L" MB/s, encode " << mb / encodeSecs << L" MB/s";
+            SCXCoreLib::TestStopwatch::Report(report.str());
+
+            for (int level = eUTF8Scalar; level <= supported; level++)
+            {
+                SetUTF8SimdLevel(static_cast<UTF8SimdLevel>(level));
+                stopwatch.Restart();
+                for (int i = 0; i < rounds * 10; i++)
+                {
+                    decoded = SCXCoreLib::StrFromUTF8(utf8);
+                }
+                decodeSecs = stopwatch.GetElapsedMicroseconds() / 1000000.0 / 10;
+                CPPUNIT_ASSERT(decoded == *texts[t]);
+                std::string encoded;
+                stopwatch.Restart();
+                for (int i = 0; i < rounds * 10; i++)
+                {
+                    encoded = SCXCoreLib::StrToUTF8(*texts[t]);
+                }
+                encodeSecs = stopwatch.GetElapsedMicroseconds() / 1000000.0 / 10;
+                CPPUNIT_ASSERT(encoded == utf8);
+                report.str(L"");
+                report << names[t] << L" " << levelNames[level] << L": decode " << mb / decodeSecs
+                       << L" MB/s, encode " << mb / encodeSecs << L" MB/s";
+                SCXCoreLib::TestStopwatch::Report(report.str());
+            }
+            SetUTF8SimdLevel(supported);
+        }
+    }
+#endif
+
     void testMergeTokens()
     {
         std::wstring s = L"this 'is' \"a string\" with (lot's  (sic!) of) ' variants ' 'for you'";
@@ -543,6 +763,231 @@ protected:
         CPPUNIT_ASSERT(L"c" == tokens[5]);
     }
 
+    /** Tokens of a string, found with a span tokenizer. */
+    template <typename C>
+    static std::vector<std::basic_string<C> > SpanTokens(const std::basic_string<C>& str, const C* delimiters, bool trim, bool emptyTokens)
+    {
+        std::vector<std::basic_string<C> > tokens;
+        SCXCoreLib::BasicStrSpanTokenizer<C> tokenizer(str, delimiters, trim, emptyTokens);
+        SCXCoreLib::BasicStrSpan<C> token;
+        while (tokenizer.Next(token))
+        {
+            tokens.push_back(token.ToString());
+        }
+        return tokens;
+    }
+
+    void testSpanTokenizeMatchesStrTokenize()
+    {
+        const char* strings[] = {
+            "", " ", ";;", "abc", " abc ", "a small  test\nstring", "a x smally x test zstring",
+            "MemTotal:        3915332 kB", "physical id\t: 0", "\t leading and trailing \n",
+            "/dev/sda1 / ext4 rw,relatime 0 0"
+        };
+        const char* delimiters[] = { " \n", "xyz", ";", ":", " \n\t", "" };
+
+        for (size_t i = 0; i < sizeof(strings) / sizeof(strings[0]); i++)
+        {
+            for (size_t d = 0; d < sizeof(delimiters) / sizeof(delimiters[0]); d++)
+            {
+                for (int flags = 0; flags < 4; flags++)
+                {
+                    bool trim = 0 != (flags & 1);
+                    bool emptyTokens = 0 != (flags & 2);
+                    std::string narrow(strings[i]);
+                    std::wstring wide(StrFromUTF8(narrow));
+                    std::wstring wideDelimiters(StrFromUTF8(delimiters[d]));
+
+                    std::vector<std::wstring> expected;
+                    SCXCoreLib::StrTokenize(wide, expected, wideDelimiters, trim, emptyTokens);
+
+                    std::ostringstream where;
+                    where << "string " << i << ", delimiters " << d << ", trim " << trim << ", emptyTokens " << emptyTokens;
+                    CPPUNIT_ASSERT_MESSAGE(where.str(), expected == SpanTokens(wide, wideDelimiters.c_str(), trim, emptyTokens));
+
+                    std::vector<std::string> narrowTokens(SpanTokens(narrow, delimiters[d], trim, emptyTokens));
+                    CPPUNIT_ASSERT_EQUAL_MESSAGE(where.str(), expected.size(), narrowTokens.size());
+                    for (size_t t = 0; t < expected.size(); t++)
+                    {
+                        CPPUNIT_ASSERT_MESSAGE(where.str(), expected[t] == StrFromUTF8(narrowTokens[t]));
+                    }
+                }
+            }
+        }
+    }
+
+    void testSpanTokenizeFixedCount()
+    {
+        std::string line("/dev/sda1 /boot ext4 rw,relatime 0 0");
+        SCXCoreLib::StrSpanTokenizer tokenizer(line, " \n\t");
+        SCXCoreLib::StrSpan parts[4];
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(4), tokenizer.Next(parts, 4));
+        CPPUNIT_ASSERT(parts[0].Equals("/dev/sda1"));
+        CPPUNIT_ASSERT(parts[1].Equals("/boot"));
+        CPPUNIT_ASSERT( ! parts[1].Equals("/boo"));
+        CPPUNIT_ASSERT( ! parts[1].Equals("/boots"));
+        CPPUNIT_ASSERT(parts[2].Equals("ext4"));
+        CPPUNIT_ASSERT(parts[3].Contains(','));
+        CPPUNIT_ASSERT( ! parts[3].Contains('='));
+        // Spans point into the string tokenized
+        CPPUNIT_ASSERT(line.data() + 10 == parts[1].Data());
+
+        // The rest is still there
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), tokenizer.Next(parts, 4));
+        CPPUNIT_ASSERT(parts[0].Equals("0"));
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), tokenizer.Next(parts, 4));
+
+        std::wstring word(L"nr_free_pages");
+        SCXCoreLib::WStrSpanTokenizer shortLine(word, L" \n");
+        SCXCoreLib::WStrSpan tokens[2];
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), shortLine.Next(tokens, 2));
+        CPPUNIT_ASSERT(tokens[0].Equals(L"nr_free_pages"));
+        CPPUNIT_ASSERT(SCXCoreLib::WStrSpan().Equals(L""));
+        CPPUNIT_ASSERT(SCXCoreLib::WStrSpan().Empty());
+    }
+
+    void testSpanToNumber()
+    {
+        scxulong u = 17;
+        CPPUNIT_ASSERT(SCXCoreLib::StrSpanToULong(SCXCoreLib::StrSpan("4711", 4), u));
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(4711), u);
+        CPPUNIT_ASSERT(SCXCoreLib::StrSpanToULong(SCXCoreLib::WStrSpan(L"+0", 2), u));
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(0), u);
+        CPPUNIT_ASSERT(SCXCoreLib::StrSpanToULong(SCXCoreLib::StrSpan(std::string("18446744073709551615")), u));
+        CPPUNIT_ASSERT_EQUAL(~static_cast<scxulong>(0), u);
+        // Only part of a buffer
+        CPPUNIT_ASSERT(SCXCoreLib::StrSpanToULong(SCXCoreLib::StrSpan("123456", 3), u));
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(123), u);
+
+        u = 17;
+        CPPUNIT_ASSERT( ! SCXCoreLib::StrSpanToULong(SCXCoreLib::StrSpan(std::string("18446744073709551616")), u));
+        CPPUNIT_ASSERT( ! SCXCoreLib::StrSpanToULong(SCXCoreLib::StrSpan(std::string("99999999999999999999")), u));
+        CPPUNIT_ASSERT( ! SCXCoreLib::StrSpanToULong(SCXCoreLib::StrSpan(), u));
+        CPPUNIT_ASSERT( ! SCXCoreLib::StrSpanToULong(SCXCoreLib::StrSpan("+", 1), u));
+        CPPUNIT_ASSERT( ! SCXCoreLib::StrSpanToULong(SCXCoreLib::StrSpan("-42", 3), u));
+        CPPUNIT_ASSERT( ! SCXCoreLib::StrSpanToULong(SCXCoreLib::WStrSpan(L" 42", 3), u));
+        CPPUNIT_ASSERT( ! SCXCoreLib::StrSpanToULong(SCXCoreLib::WStrSpan(L"42kB", 4), u));
+        CPPUNIT_ASSERT( ! SCXCoreLib::StrSpanToULong(SCXCoreLib::WStrSpan(L"Not a number", 12), u));
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(17), u);
+
+        // What follows the number, if asked for
+        SCXCoreLib::WStrSpan rest;
+        CPPUNIT_ASSERT(SCXCoreLib::StrSpanToULong(SCXCoreLib::WStrSpan(L"42kB", 4), u, &rest));
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(42), u);
+        CPPUNIT_ASSERT(rest.Equals(L"kB"));
+        CPPUNIT_ASSERT(SCXCoreLib::StrSpanToULong(SCXCoreLib::WStrSpan(L"42", 2), u, &rest));
+        CPPUNIT_ASSERT(rest.Empty());
+        CPPUNIT_ASSERT( ! SCXCoreLib::StrSpanToULong(SCXCoreLib::WStrSpan(L"kB", 2), u, &rest));
+
+        scxlong l = 17;
+        CPPUNIT_ASSERT(SCXCoreLib::StrSpanToLong(SCXCoreLib::StrSpan("-42", 3), l));
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxlong>(-42), l);
+        CPPUNIT_ASSERT(SCXCoreLib::StrSpanToLong(SCXCoreLib::WStrSpan(L"+4711", 5), l));
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxlong>(4711), l);
+        CPPUNIT_ASSERT(SCXCoreLib::StrSpanToLong(SCXCoreLib::StrSpan(std::string("9223372036854775807")), l));
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxlong>(~static_cast<scxulong>(0) >> 1), l);
+        CPPUNIT_ASSERT(SCXCoreLib::StrSpanToLong(SCXCoreLib::StrSpan(std::string("-9223372036854775808")), l));
+        // The smallest scxlong is one below the negated largest
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxlong>(-1), l + static_cast<scxlong>(~static_cast<scxulong>(0) >> 1));
+
+        l = 17;
+        CPPUNIT_ASSERT( ! SCXCoreLib::StrSpanToLong(SCXCoreLib::StrSpan(std::string("9223372036854775808")), l));
+        CPPUNIT_ASSERT( ! SCXCoreLib::StrSpanToLong(SCXCoreLib::StrSpan(std::string("-9223372036854775809")), l));
+        CPPUNIT_ASSERT( ! SCXCoreLib::StrSpanToLong(SCXCoreLib::StrSpan("-", 1), l));
+        CPPUNIT_ASSERT( ! SCXCoreLib::StrSpanToLong(SCXCoreLib::WStrSpan(L"--1", 3), l));
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxlong>(17), l);
+
+        SCXCoreLib::StrSpan narrowRest;
+        CPPUNIT_ASSERT(SCXCoreLib::StrSpanToLong(SCXCoreLib::StrSpan("-7 C", 4), l, &narrowRest));
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxlong>(-7), l);
+        CPPUNIT_ASSERT(narrowRest.Equals(" C"));
+    }
+
+    /**
+       Lines shaped like those of /proc/meminfo, /proc/cpuinfo and the mount
+       table are split, and their numbers parsed, the way the callers did
+       with StrTokenize() and the way they do with spans.
+    */
+    void testSpanTokenizePerformance()
+    {
+        const wchar_t* meminfo[] = {
+            L"MemTotal:        3915332 kB", L"MemFree:          153424 kB", L"Buffers:              36 kB",
+            L"Cached:           289148 kB", L"SwapTotal:       6655996 kB", L"Committed_AS:    1004816 kB",
+            L"HugePages_Total:       0", L"DirectMap2M:     3575808 kB"
+        };
+        const wchar_t* cpuinfo[] = {
+            L"processor\t: 0", L"vendor_id\t: GenuineIntel", L"model name\t: Intel(R) Xeon(R) CPU E5-2673 v4 @ 2.30GHz",
+            L"physical id\t: 0", L"flags\t\t: fpu vme de pse tsc msr pae mce cx8 apic sep mtrr pge mca cmov pat pse36 clflush mmx fxsr sse sse2"
+        };
+        const wchar_t* mounts[] = {
+            L"/dev/sda1 / ext4 rw,relatime,errors=remount-ro 0 0", L"proc /proc proc rw,nosuid,nodev,noexec,relatime 0 0",
+            L"cgroup /sys/fs/cgroup/memory cgroup rw,nosuid,nodev,noexec,relatime,memory 0 0",
+            L"/dev/sdb1 /mnt/resource ext4 rw,relatime 0 0"
+        };
+        const wchar_t** sets[] = { meminfo, cpuinfo, mounts };
+        const size_t sizes[] = { sizeof(meminfo) / sizeof(meminfo[0]), sizeof(cpuinfo) / sizeof(cpuinfo[0]), sizeof(mounts) / sizeof(mounts[0]) };
+        const wchar_t* delimiters[] = { L" \n", L":", L" \n\t" };
+        // Rows the number of which is parsed; NULL for all
+        const wchar_t* numberKeys[] = { NULL, L"physical id", L"" };
+        const char* names[] = { "meminfo", "cpuinfo", "mounts" };
+        const int rounds = 100000;
+
+        for (size_t set = 0; set < 3; set++)
+        {
+            std::vector<std::wstring> lines(sets[set], sets[set] + sizes[set]);
+            scxulong oldSum = 0, newSum = 0;
+
+            SCXCoreLib::TestStopwatch stopwatch;
+            for (int r = 0; r < rounds; r++)
+            {
+                for (size_t i = 0; i < lines.size(); i++)
+                {
+                    std::vector<std::wstring> tokens;
+                    SCXCoreLib::StrTokenize(lines[i], tokens, delimiters[set]);
+                    if (tokens.size() >= 2 && (NULL == numberKeys[set] || tokens[0] == numberKeys[set]))
+                    {
+                        oldSum += tokens[0].size();
+                        try
+                        {
+                            oldSum += SCXCoreLib::StrToULong(tokens[1]);
+                        }
+                        catch (SCXCoreLib::SCXNotSupportedException&)
+                        {
+                        }
+                    }
+                }
+            }
+            double oldSecs = stopwatch.GetElapsedMicroseconds() / 1000000.0;
+
+            stopwatch.Restart();
+            for (int r = 0; r < rounds * 10; r++)
+            {
+                for (size_t i = 0; i < lines.size(); i++)
+                {
+                    SCXCoreLib::WStrSpanTokenizer tokenizer(lines[i], delimiters[set]);
+                    SCXCoreLib::WStrSpan tokens[4];
+                    if (tokenizer.Next(tokens, 4) >= 2 && (NULL == numberKeys[set] || tokens[0].Equals(numberKeys[set])))
+                    {
+                        newSum += tokens[0].Size();
+                        scxulong value = 0;
+                        if (SCXCoreLib::StrSpanToULong(tokens[1], value))
+                        {
+                            newSum += value;
+                        }
+                    }
+                }
+            }
+            double newSecs = stopwatch.GetElapsedMicroseconds() / 1000000.0 / 10;
+
+            CPPUNIT_ASSERT_EQUAL(oldSum * 10, newSum);
+            double linesParsed = static_cast<double>(rounds) * static_cast<double>(lines.size());
+            std::wostringstream report;
+            report << names[set] << L": StrTokenize " << oldSecs * 1e9 / linesParsed
+                   << L" ns/line, spans " << newSecs * 1e9 / linesParsed << L" ns/line";
+            SCXCoreLib::TestStopwatch::Report(report.str());
+        }
+    }
+
     void testFromMultibyte()
     {
         CPPUNIT_ASSERT(SCXCoreLib::StrFromUTF8("abc") == L"abc");
@@ -23,6 +23,9 @@
 #include <scxcorelib/scxmath.h>
 #include <scxsystemlib/entityinstance.h>
 #include <scxsystemlib/entityenumeration.h>
+#include <scxcorelib/scxthread.h>
+#include <scxcorelib/scxthreadpool.h>
+#include <scxcorelib/scxcondition.h>
 
 using namespace std;
 using namespace SCXSystemLib;
@@ -61,13 +64,124 @@ public:
 
 int TestInst::c_Nonce = 0;
 
+/** Holds instance updates on the worker threads until enough of them have
+    entered, or until the test opens it. */
+class UpdateGate {
+public:
+    UpdateGate() : m_entered(0), m_open(false) {
+        m_cond.SetSleep(100);
+    }
+
+    /** Called by an update: wait until count updates have entered or the gate is
+        opened. Gives up after about 10 seconds, so a failing test does not hang.
+        \returns true unless it gave up. */
+    bool Enter(int count) {
+        SCXConditionHandle h(m_cond);
+        ++m_entered;
+        h.Broadcast();
+        return WaitFor(h, count);
+    }
+
+    /** Wait until count updates have entered.
+        \returns true unless it gave up. */
+    bool WaitForEntered(int count) {
+        SCXConditionHandle h(m_cond);
+        return WaitFor(h, count);
+    }
+
+    /** Let all updates through */
+    void Open() {
+        SCXConditionHandle h(m_cond);
+        m_open = true;
+        h.Broadcast();
+    }
+
+private:
+    bool WaitFor(SCXConditionHandle& h, int count) {
+        for (int i = 0; i < 100 && !m_open && m_entered < count; i++) {
+            h.Wait();
+        }
+        return m_open || m_entered >= count;
+    }
+
+    SCXCondition m_cond;
+    int m_entered;
+    bool m_open;
+};
+
+/** Instance whose update may be held at a gate, like one reading a slow device. */
+class GateInst : public EntityInstance {
+public:
+    GateInst( const wstring& id, SCXCoreLib::SCXHandle<UpdateGate> gate, int count )
+        : EntityInstance( id, false ), m_gate(gate), m_count(count), m_passed(false), m_value(0){}
+
+    virtual void            Update() {
+        if ( m_gate != 0 ){
+            m_passed = m_gate->Enter( m_count );
+        }
+        m_value = c_Generation;
+    }
+
+    SCXCoreLib::SCXHandle<UpdateGate> m_gate;   //!< Gate to pass, NULL for none
+    int m_count;                                //!< Updates the gate waits for
+    bool m_passed;                              //!< Did the latest update pass the gate?
+    int m_value;                                //!< c_Generation of the latest update
+
+    static int c_Generation;
+};
+
+int GateInst::c_Generation = 0;
+
+class GateEnum : public EntityEnumeration<GateInst> {
+public:
+    virtual void Init(){
+    }
+
+    void Add( const wstring& id, SCXCoreLib::SCXHandle<UpdateGate> gate, int count ){
+        AddInstance( SCXCoreLib::SCXHandle<GateInst>(new GateInst( id, gate, count )) );
+    }
+};
+
 class SCXEntityInstanceTest : public CPPUNIT_NS::TestFixture
 {
     CPPUNIT_TEST_SUITE( SCXEntityInstanceTest );
     CPPUNIT_TEST( testUpdateInstanceThrows );
+    CPPUNIT_TEST( testParallelUpdateInstanceThrows );
+    CPPUNIT_TEST( testParallelUpdateRunsConcurrently );
+    CPPUNIT_TEST( testParallelUpdateDropsAbandonedUpdate );
     CPPUNIT_TEST_SUITE_END();
 
 private:
+    SCXCoreLib::SCXHandle<SCXThreadPool> StartPool(long threads)
+    {
+        SCXCoreLib::SCXHandle<SCXThreadPool> pool(new SCXThreadPool());
+        pool->SetThreadLimit(threads);
+        pool->Start();
+        return pool;
+    }
+
+    void VerifyUpdatedExceptInstance2(TestEnum& tstEnum)
+    {
+        for ( TestEnum::EntityIterator it = tstEnum.Begin(); it != tstEnum.End(); it++ ){
+            SCXCoreLib::SCXHandle<TestInst> inst = *it;
+
+            // note: instance with id '2' throws exception and is not updated;
+            // others must be updated
+            if ( inst->GetId() == L"2" ){
+                CPPUNIT_ASSERT ( inst->m_nonce != TestInst::c_Nonce);
+                
+                // verify that exception-caught flag is set
+                CPPUNIT_ASSERT ( inst->IsUnexpectedExceptionSet() );
+                //wcout << inst->GetUnexpectedExceptionText() << endl;
+                
+            } else {
+                CPPUNIT_ASSERT ( inst->m_nonce == TestInst::c_Nonce);
+
+                // verify that exception-caught flag is not set
+                CPPUNIT_ASSERT ( !inst->IsUnexpectedExceptionSet() );
+            }
+        }
+    }
 
 public:
 
@@ -97,26 +211,98 @@ public:
         // UpdateInstance has to deal with exceptions
         CPPUNIT_ASSERT_NO_THROW( tstEnum.UpdateInstances() );
 
-        for ( TestEnum::EntityIterator it = tstEnum.Begin(); it != tstEnum.End(); it++ ){
-            SCXCoreLib::SCXHandle<TestInst> inst = *it;
+        VerifyUpdatedExceptInstance2(tstEnum);
+    }
 
-            // note: instance with id '2' throws exception and is not updated;
-            // others must be updated
-            if ( inst->GetId() == L"2" ){
-                CPPUNIT_ASSERT ( inst->m_nonce != TestInst::c_Nonce);
-                
-                // verify that exception-caught flag is set
-                CPPUNIT_ASSERT ( inst->IsUnexpectedExceptionSet() );
-                //wcout << inst->GetUnexpectedExceptionText() << endl;
-                
-            } else {
-                CPPUNIT_ASSERT ( inst->m_nonce == TestInst::c_Nonce);
+    void testParallelUpdateInstanceThrows()
+    {
+        SCXCoreLib::SCXLogHandle log = SCXCoreLib::SCXLogHandleFactory::Instance().GetLogHandle(L"scx.core.common.pal.system.common");
+        SCX_LOGINFO(log, L"This test raises exceptions; the following log message is normal");
 
-                // verify that exception-caught flag is not set
-                CPPUNIT_ASSERT ( !inst->IsUnexpectedExceptionSet() );
-            }
+        SCXCoreLib::SCXHandle<SCXThreadPool> pool = StartPool(2);
+        TestEnum tstEnum;
+        tstEnum.Init();
+        tstEnum.SetParallelUpdate(pool, 0);
+        CPPUNIT_ASSERT(0 != tstEnum.GetParallelUpdater());
+
+        TestInst::c_Nonce++;
+        CPPUNIT_ASSERT_NO_THROW( tstEnum.UpdateInstances() );
+        VerifyUpdatedExceptInstance2(tstEnum);
+
+        tstEnum.SetParallelUpdate(SCXCoreLib::SCXHandle<SCXThreadPool>(0), 0);
+        CPPUNIT_ASSERT(0 == tstEnum.GetParallelUpdater());
+        pool->Shutdown();
+    }
+
+    void testParallelUpdateRunsConcurrently()
+    {
+        // Every update waits at the gate until all of them have entered,
+        // which they only can if they run at the same time
+        SCXCoreLib::SCXHandle<SCXThreadPool> pool = StartPool(4);
+        SCXCoreLib::SCXHandle<UpdateGate> gate(new UpdateGate());
+        GateEnum gateEnum;
+        for (int i = 0; i < 4; i++)
+        {
+            gateEnum.Add(StrFrom(i), gate, 4);
         }
+        gateEnum.SetParallelUpdate(pool, 0);
 
+        GateInst::c_Generation++;
+        gateEnum.UpdateInstances();
+
+        for (GateEnum::EntityIterator it = gateEnum.Begin(); it != gateEnum.End(); it++)
+        {
+            CPPUNIT_ASSERT((*it)->m_passed);
+            CPPUNIT_ASSERT_EQUAL(GateInst::c_Generation, (*it)->m_value);
+        }
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(0), gateEnum.GetParallelUpdater()->GetTimeoutCount());
+        pool->Shutdown();
+    }
+
+    void testParallelUpdateDropsAbandonedUpdate()
+    {
+        SCXCoreLib::SCXHandle<SCXThreadPool> pool = StartPool(2);
+        SCXCoreLib::SCXHandle<UpdateGate> gate(new UpdateGate());
+        GateEnum gateEnum;
+        gateEnum.Add(L"fast", SCXCoreLib::SCXHandle<UpdateGate>(0), 0);
+        gateEnum.Add(L"stuck", gate, 2);
+        gateEnum.SetParallelUpdate(pool, 500);
+        SCXCoreLib::SCXHandle<EntityUpdater> updater = gateEnum.GetParallelUpdater();
+        SCXCoreLib::SCXHandle<GateInst> fast = gateEnum.GetInstance(0);
+        SCXCoreLib::SCXHandle<GateInst> stuck = gateEnum.GetInstance(1);
+
+        // The stuck instance is abandoned at its deadline and keeps its values
+        GateInst::c_Generation = 1;
+        gateEnum.UpdateInstances();
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(1), updater->GetTimeoutCount());
+        CPPUNIT_ASSERT_EQUAL(1, fast->m_value);
+        CPPUNIT_ASSERT_EQUAL(0, stuck->m_value);
+
+        // While its update is still running, the stuck instance is skipped
+        CPPUNIT_ASSERT(gate->WaitForEntered(1));
+        GateInst::c_Generation = 2;
+        gateEnum.UpdateInstances();
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(1), updater->GetSkipCount());
+        CPPUNIT_ASSERT_EQUAL(2, fast->m_value);
+        CPPUNIT_ASSERT_EQUAL(0, stuck->m_value);
+
+        // When the abandoned update returns, its result is dropped;
+        // shutting the pool down waits for it
+        gate->Open();
+        pool->Shutdown();
+        CPPUNIT_ASSERT_EQUAL(0, stuck->m_value);
+        CPPUNIT_ASSERT( ! stuck->m_passed);
+
+        // Once it has returned, the instance is updated again
+        pool->Start();
+        GateInst::c_Generation = 3;
+        gateEnum.UpdateInstances();
+        CPPUNIT_ASSERT_EQUAL(3, fast->m_value);
+        CPPUNIT_ASSERT_EQUAL(3, stuck->m_value);
+        CPPUNIT_ASSERT(stuck->m_passed);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(1), updater->GetTimeoutCount());
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(1), updater->GetSkipCount());
+        pool->Shutdown();
     }
 
 };
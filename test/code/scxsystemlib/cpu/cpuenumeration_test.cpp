@@ -25,6 +25,7 @@
 #endif // defined(sun)
 
 #include <testutils/scxunit.h>
+#include <testutils/scxtestutils.h>
 #include <string>
 #include <vector>
 #include <sstream>
@@ -145,6 +146,13 @@ protected:
 // actually chaining of kstat values (ks_next).  Instead, we overload the
 // existing iterators to make things work.
 
+/** Copy the contents of a mocked stat file to the buffer given to ReadStatFile(). */
+static size_t CopyToBuffer(const std::string& contents, std::vector<char>& buffer)
+{
+    buffer.assign(contents.begin(), contents.end());
+    return buffer.size();
+}
+
 class CPUPALTestDependencies : public CPUPALDependencies
 {
 public:
@@ -161,36 +169,36 @@ public:
         m_cpuInfoFileType(-1)
     {}
 
-    virtual SCXHandle<std::wistream> OpenStatFile() const
+    virtual size_t ReadStatFile(std::vector<char>& buffer) const
     {
-        SCXHandle<std::wstringstream> statfilecontent( new std::wstringstream );
-        *statfilecontent << L"cpu  " << m_numProcs * m_user
-                         << L" " << m_numProcs * m_nice
-                         << L" " << m_numProcs * m_system
-                         << L" " << m_numProcs * m_idle
-                         << L" " << m_numProcs * m_iowait
-                         << L" " << m_numProcs * m_irq
-                         << L" " << m_numProcs * m_softirq << L" 0" << endl;
+        std::ostringstream statfilecontent;
+        statfilecontent << "cpu  " << m_numProcs * m_user
+                         << " " << m_numProcs * m_nice
+                         << " " << m_numProcs * m_system
+                         << " " << m_numProcs * m_idle
+                         << " " << m_numProcs * m_iowait
+                         << " " << m_numProcs * m_irq
+                         << " " << m_numProcs * m_softirq << " 0" << endl;
         for (int i = 0; i < m_numProcs; ++i)
         {
             // In this simple mock every cpu is equal.
-            *statfilecontent << L"cpu" << i
-                             << L" " << m_user
-                             << L" " << m_nice
-                             << L" " << m_system
-                             << L" " << m_idle
-                             << L" " << m_iowait
-                             << L" " << m_irq
-                             << L" " << m_softirq << L" 0" << endl;
+            statfilecontent << "cpu" << i
+                             << " " << m_user
+                             << " " << m_nice
+                             << " " << m_system
+                             << " " << m_idle
+                             << " " << m_iowait
+                             << " " << m_irq
+                             << " " << m_softirq << " 0" << endl;
         }
-        *statfilecontent << L"intr 925622655 892108154 78 0 2 2 0 4 0 2 0 0 0 1057 0 0 28275035 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 1852436 0 0 0 0 0 0 0 3385885 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0" << endl
-                         << L"ctxt 168393795" << endl
-                         << L"btime 1208301855" << endl
-                         << L"processes 343202" << endl
-                         << L"procs_running 2" << endl
-                         << L"procs_blocked 0" << endl;
-
-        return statfilecontent;
+        statfilecontent << "intr 925622655 892108154 78 0 2 2 0 4 0 2 0 0 0 1057 0 0 28275035 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 1852436 0 0 0 0 0 0 0 3385885 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0" << endl
+                         << "ctxt 168393795" << endl
+                         << "btime 1208301855" << endl
+                         << "processes 343202" << endl
+                         << "procs_running 2" << endl
+                         << "procs_blocked 0" << endl;
+
+        return CopyToBuffer(statfilecontent.str(), buffer);
     }
 
 #if defined(linux)
@@ -734,30 +742,130 @@ public:
         SetNumProcs(8);
     }
 
-    virtual SCXHandle<std::wistream> OpenStatFile() const
+    virtual size_t ReadStatFile(std::vector<char>& buffer) const
+    {
+        std::ostringstream statfilecontent;
+        statfilecontent <<
+        "cpu  91932320 79411 2311540 7259234600 323686 19333 79380 0" << endl <<
+        "cpu0 1521515 1067 270995 906917730 113406 8908 71567 0" << endl <<
+        "cpu1 1608830 15162 285905 906949703 42217 2131 1179 0" << endl <<
+        "cpu2 505780 872 253619 908093644 42759 4229 4234 0" << endl <<
+        "cpu3 1727636 31344 374383 906755767 11595 4063 349 0" << endl <<
+        "cpu4 480444 628 276461 908133093 14284 0 233 0" << endl <<
+        "cpu5 1528135 3999 327597 907034134 10952 0 325 0" << endl <<
+        "cpu6 432151 481 201196 908238460 32373 0 480 0" << endl <<
+        "cpu7 1388738 25853 321378 907112065 56097 0 1009 0" << endl <<
+        "intr 9532421188 500146530 3 0 3 3 0 0 0 3 0 0 0 4 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 26209011 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 94619924 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 142848381 0 0 0 0 0 0 0 178662734 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0" << endl <<
+        "ctxt 39309945745" << endl <<
+        "btime 1225989933" << endl <<
+        "processes 8223456" << endl <<
+        "procs_running 1" << endl <<
+        "procs_blocked 0";
+
+        return CopyToBuffer(statfilecontent.str(), buffer);
+    }
+};
+
+#if defined(linux)
+/**
+   Stat file of a large machine. It is built once, so that reading it costs
+   next to nothing compared to parsing it.
+*/
+class CPUPALLargeStatDependencies : public CPUPALTestDependencies
+{
+public:
+    CPUPALLargeStatDependencies(int numProcs) : m_largeNumProcs(numProcs)
+    {
+        SetNumProcs(numProcs);
+        SetGeneration(0);
+    }
+
+    /**
+       Build the stat file of a later sample.
+
+       \param[in] generation  Number of 100 tick periods since the first sample;
+                              CPU N is busy (N % 50) + 1 percent of the time.
+    */
+    void SetGeneration(int generation)
     {
-        SCXHandle<std::wstringstream> statfilecontent( new std::wstringstream );
-        *statfilecontent <<
-        L"cpu  91932320 79411 2311540 7259234600 323686 19333 79380 0" << endl <<
-        L"cpu0 1521515 1067 270995 906917730 113406 8908 71567 0" << endl <<
-        L"cpu1 1608830 15162 285905 906949703 42217 2131 1179 0" << endl <<
-        L"cpu2 505780 872 253619 908093644 42759 4229 4234 0" << endl <<
-        L"cpu3 1727636 31344 374383 906755767 11595 4063 349 0" << endl <<
-        L"cpu4 480444 628 276461 908133093 14284 0 233 0" << endl <<
-        L"cpu5 1528135 3999 327597 907034134 10952 0 325 0" << endl <<
-        L"cpu6 432151 481 201196 908238460 32373 0 480 0" << endl <<
-        L"cpu7 1388738 25853 321378 907112065 56097 0 1009 0" << endl <<
-        L"intr 9532421188 500146530 3 0 3 3 0 0 0 3 0 0 0 4 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 26209011 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 94619924 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 142848381 0 0 0 0 0 0 0 178662734 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0" << endl <<
-        L"ctxt 39309945745" << endl <<
-        L"btime 1225989933" << endl <<
-        L"processes 8223456" << endl <<
-        L"procs_running 1" << endl <<
-        L"procs_blocked 0";
-
-        return statfilecontent;
+        std::ostringstream statfilecontent;
+        statfilecontent << "cpu  " << m_largeNumProcs * 1000 << " 0 " << m_largeNumProcs * 200 << " " << m_largeNumProcs * 900000
+                        << " 0 0 0 0 0 0" << endl;
+        for (int i = 0; i < m_largeNumProcs; ++i)
+        {
+            int busy = i % 50 + 1;
+            statfilecontent << "cpu" << i << " " << 1000 + generation * busy << " 0 " << 200 + i << " "
+                            << 900000 + generation * (100 - busy) << " 17 0 " << i % 5 << " 0 0 0" << endl;
+        }
+        statfilecontent << "intr 925622655";
+        for (int i = 0; i < 512; ++i)
+        {
+            statfilecontent << " " << i % 3;
+        }
+        statfilecontent << endl
+                        << "ctxt 168393795" << endl
+                        << "btime 1208301855" << endl
+                        << "processes 343202" << endl
+                        << "procs_running 2" << endl
+                        << "procs_blocked 0" << endl;
+        m_contents = statfilecontent.str();
     }
+
+    virtual size_t ReadStatFile(std::vector<char>& buffer) const
+    {
+        buffer.assign(m_contents.begin(), m_contents.end());
+        return buffer.size();
+    }
+
+    const std::string& GetContents() const { return m_contents; }
+
+private:
+    int m_largeNumProcs;        //!< Number of CPUs in the stat file
+    std::string m_contents;     //!< Contents of the stat file
 };
 
+/**
+   How the stat file used to be parsed: one line at a time from a wide stream,
+   split into strings, and matched against every CPU by name.
+
+   \returns Sum of the user ticks of the rows that matched a CPU.
+*/
+static scxulong ParseStatFileLineByLine(std::wistream& statFile, const std::vector<std::wstring>& procNames)
+{
+    scxulong sum = 0;
+    wstring line;
+    SCXCoreLib::SCXStream::NLF nlf;
+
+    for (SCXCoreLib::SCXStream::ReadLine(statFile, line, nlf);
+         SCXCoreLib::SCXStream::IsGood(statFile);
+         SCXCoreLib::SCXStream::ReadLine(statFile, line, nlf))
+    {
+        vector<wstring> tokens;
+        StrTokenize(line, tokens);
+        if (tokens.size() < 8 || ! StrIsPrefix(tokens[0], L"cpu"))
+        {
+            continue;
+        }
+
+        scxulong ticks[7];
+        for (size_t i = 0; i < 7; ++i)
+        {
+            ticks[i] = StrToULong(tokens[i + 1]);
+        }
+
+        for (size_t i = 0; i < procNames.size(); ++i)
+        {
+            if (tokens[0].compare(wstring(L"cpu").append(procNames[i])) == 0)
+            {
+                sum += ticks[0];
+                break;
+            }
+        }
+    }
+    return sum;
+}
+#endif
+
 
 #if defined(sun)
 
@@ -833,10 +941,19 @@ class CPUEnumeration_Test : public CPPUNIT_NS::TestFixture
     CPPUNIT_TEST( testPhysicalProcCountWithMassiveProcessors );
     CPPUNIT_TEST( testPhysicalLogicalProcCountsWithDynamicCPUs );
     CPPUNIT_TEST( TestNoProcessorsOnlineDuringUpdate );
+#if defined(linux)
+    CPPUNIT_TEST( testStatSnapshot );
+    CPPUNIT_TEST( testParseStatFile );
+    CPPUNIT_TEST( testLargeStatFile );
+    CPPUNIT_TEST( testSampleDataPerformance );
+#endif
 
     SCXUNIT_TEST_ATTRIBUTE(testMockedValues,SLOW);
     SCXUNIT_TEST_ATTRIBUTE(testRemoveProc,SLOW);
     SCXUNIT_TEST_ATTRIBUTE(testRealValues,SLOW);
+#if defined(linux)
+    SCXUNIT_TEST_ATTRIBUTE(testSampleDataPerformance,SLOW);
+#endif
 
     CPPUNIT_TEST_SUITE_END();
 
@@ -882,6 +999,153 @@ public:
 #endif
     }
 
+#if defined(linux)
+    void testStatSnapshot()
+    {
+        SCXHandle<CPUPALTestDependencies> deps(new CPUPALTestDependencies());
+        deps->SetNumProcs(2);
+        deps->SetUser(100);
+        deps->SetIdle(1000);
+
+        m_pEnum = new CPUEnumeration(deps);
+        m_pEnum->Init();
+
+        m_pEnum->SampleData();
+        SCXHandle<const CPUStatSnapshot> first = m_pEnum->GetStatSnapshot();
+        CPPUNIT_ASSERT(NULL != first);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(3), first->GetRows().size());
+        CPPUNIT_ASSERT(first->GetRows()[0].isTotal);
+        CPPUNIT_ASSERT( ! first->GetRows()[2].isTotal);
+        CPPUNIT_ASSERT_EQUAL(1u, first->GetRows()[2].cpu);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(168393795), first->GetSystemCounters().contextSwitches);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(200), first->GetRows()[0].user);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(1100), first->GetRows()[1].total);
+
+        // A new sample publishes a new snapshot; the old one is left untouched
+        deps->SetUser(150);
+        m_pEnum->SampleData();
+        SCXHandle<const CPUStatSnapshot> second = m_pEnum->GetStatSnapshot();
+        CPPUNIT_ASSERT(first.GetData() != second.GetData());
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(100), first->GetRows()[1].user);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(150), second->GetRows()[1].user);
+
+        m_pEnum->Update();
+        scxulong data;
+        CPPUNIT_ASSERT(m_pEnum->GetInstance(1)->GetUserTime(data));
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(100), data);
+    }
+
+    void testParseStatFile()
+    {
+        std::string contents =
+            "cpu  10 20 30 40 50 60 70 0 0 0\n"
+            "cpu0 1 2 3 4\n"
+            "cpu1\t5 6 7 8 9 10 11\r\n"
+            "cpu2 1 2\n"
+            "cpufreq 1 2 3 4 5 6 7\n"
+            "intr 12345 1 2 3\n"
+            "ctxt 67890\n"
+            "procs_running 3\n"
+            "procs_blocked 1";
+        SCXLogHandle log = SCXLogHandleFactory::GetLogHandle(L"scx.core.common.pal.system.cpu.cpuenumeration");
+
+        SCXHandle<const CPUStatSnapshot> snapshot = CPUEnumeration::ParseStatFile(contents.c_str(), contents.size(), log);
+
+        // Rows with too few columns and rows that are not for a cpu are skipped
+        const std::vector<CPUStatRow>& rows = snapshot->GetRows();
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(3), rows.size());
+
+        CPPUNIT_ASSERT(rows[0].isTotal);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(10), rows[0].user);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(70), rows[0].softirq);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(280), rows[0].total);
+
+        // Older kernels have only four counters
+        CPPUNIT_ASSERT( ! rows[1].isTotal);
+        CPPUNIT_ASSERT_EQUAL(0u, rows[1].cpu);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(4), rows[1].idle);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(0), rows[1].iowait);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(10), rows[1].total);
+
+        CPPUNIT_ASSERT_EQUAL(1u, rows[2].cpu);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(5), rows[2].user);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(11), rows[2].softirq);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(56), rows[2].total);
+
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(67890), snapshot->GetSystemCounters().contextSwitches);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(12345), snapshot->GetSystemCounters().interrupts);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(3), snapshot->GetSystemCounters().procsRunning);
+    }
+
+    void testLargeStatFile()
+    {
+        SCXHandle<CPUPALLargeStatDependencies> deps(new CPUPALLargeStatDependencies(1024));
+        m_pEnum = new CPUEnumeration(deps);
+        m_pEnum->Init();
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1024), m_pEnum->Size());
+
+        m_pEnum->SampleData();
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1025), m_pEnum->GetStatSnapshot()->GetRows().size());
+
+        // Every row ends up in the instance of its own CPU
+        deps->SetGeneration(1);
+        m_pEnum->SampleData();
+        m_pEnum->Update();
+        for (size_t i = 0; i < m_pEnum->Size(); i++)
+        {
+            SCXHandle<CPUInstance> inst = m_pEnum->GetInstance(i);
+            scxulong data;
+            CPPUNIT_ASSERT(inst->GetUserTime(data));
+            CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(inst->GetProcNumber() % 50 + 1), data);
+        }
+    }
+
+    void testSampleDataPerformance()
+    {
+        const int numProcs = 1024;
+        const int samples = 20;
+
+        SCXHandle<CPUPALLargeStatDependencies> deps(new CPUPALLargeStatDependencies(numProcs));
+        std::vector<std::wstring> procNames;
+        for (int i = 0; i < numProcs; ++i)
+        {
+            procNames.push_back(StrFrom(i));
+        }
+        std::wstring wideContents = StrFromUTF8(deps->GetContents());
+
+        scxulong lineByLineSum = 0;
+        TestStopwatch stopwatch;
+        for (int i = 0; i < samples; ++i)
+        {
+            std::wistringstream statFile(wideContents);
+            lineByLineSum = ParseStatFileLineByLine(statFile, procNames);
+        }
+        double lineByLineMs = stopwatch.GetElapsedMicroseconds() / 1000.0 / samples;
+
+        m_pEnum = new CPUEnumeration(deps);
+        m_pEnum->Init();
+        stopwatch.Restart();
+        for (int i = 0; i < samples; ++i)
+        {
+            m_pEnum->SampleData();
+        }
+        double sampleDataMs = stopwatch.GetElapsedMicroseconds() / 1000.0 / samples;
+
+        scxulong sum = 0;
+        const std::vector<CPUStatRow>& rows = m_pEnum->GetStatSnapshot()->GetRows();
+        for (size_t i = 0; i < rows.size(); ++i)
+        {
+            sum += rows[i].isTotal ? 0 : rows[i].user;
+        }
+        CPPUNIT_ASSERT_EQUAL(lineByLineSum, sum);
+
+        std::wostringstream report;
+        report << L"Sample of " << numProcs << L" CPU stat file: line by line "
+               << lineByLineMs << L" msec, SampleData " << sampleDataMs << L" msec";
+        TestStopwatch::Report(report.str());
+    }
+#endif
+
     void testMockedValues()
     {
         // Set up some values to use for testing
@@ -11,14 +11,48 @@
 
 #include <scxsystemlib/datasampler.h>
 #include <testutils/scxunit.h>
+#include <testutils/scxtestutils.h>
 
 #include <cppunit/extensions/HelperMacros.h>
 
 #include <iomanip>
+#include <sstream>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
 
 using namespace SCXCoreLib;
 using namespace SCXSystemLib;
 
+/**
+    The sample history used by DataSampler before it became a ring: every
+    insert moves the whole history one step. Kept here as a benchmark baseline.
+ */
+template<class T> class MemmoveSamples
+{
+public:
+    MemmoveSamples(size_t maxSize) : m_data(new T[maxSize]), m_maxSize(maxSize), m_size(0) {}
+    ~MemmoveSamples() { delete [] m_data; }
+
+    void Add(const T& x)
+    {
+        if (m_size == m_maxSize)
+        {
+            m_size--;
+        }
+        memmove(m_data + 1, m_data, sizeof(T) * m_size);
+        m_data[0] = x;
+        m_size++;
+    }
+
+    T operator[](size_t i) const { return m_data[i]; }
+
+private:
+    T* m_data;
+    size_t m_maxSize;
+    size_t m_size;
+};
+
 class DataSampler_Test : public CPPUNIT_NS::TestFixture
 {
     CPPUNIT_TEST_SUITE( DataSampler_Test  );
@@ -30,6 +64,16 @@ class DataSampler_Test : public CPPUNIT_NS::TestFixture
     CPPUNIT_TEST( testGetDelta );
     CPPUNIT_TEST( testGetAt );
     CPPUNIT_TEST( testClear );
+    CPPUNIT_TEST( testRingWrapsAround );
+    CPPUNIT_TEST( testRingCopyKeepsNewest );
+    CPPUNIT_TEST( testSamplerArray );
+    CPPUNIT_TEST( testSamplerArrayGetSample );
+    CPPUNIT_TEST( testFixedSamplerArray );
+    CPPUNIT_TEST( testTimevalConversions );
+    CPPUNIT_TEST( testTimespecConversions );
+    CPPUNIT_TEST( testSampledTimeDelta );
+    CPPUNIT_TEST( testAddSamplePerformance );
+    SCXUNIT_TEST_ATTRIBUTE(testAddSamplePerformance, SLOW);
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -189,6 +233,251 @@ public:
         test.Clear();
         CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), test.GetNumberOfSamples());
     }
+
+    void testRingWrapsAround()
+    {
+        SampleRing<int> ring(3);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(3), ring.capacity());
+        for (int i = 1; i <= 10; i++)
+        {
+            ring.push_front(i);
+            CPPUNIT_ASSERT_EQUAL(i, ring[0]);
+        }
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(3), ring.size());
+        CPPUNIT_ASSERT_EQUAL(9, ring[1]);
+        CPPUNIT_ASSERT_EQUAL(8, ring[2]);
+
+        SampleRing<int> empty(0);
+        empty.push_front(1);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), empty.size());
+    }
+
+    void testRingCopyKeepsNewest()
+    {
+        SampleRing<int> ring(4);
+        for (int i = 1; i <= 6; i++)
+        {
+            ring.push_front(i);
+        }
+
+        SampleRing<int> copy(ring);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(4), copy.size());
+        CPPUNIT_ASSERT_EQUAL(6, copy[0]);
+        CPPUNIT_ASSERT_EQUAL(3, copy[3]);
+
+        SampleRing<int> smaller(2);
+        smaller = ring;
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), smaller.size());
+        CPPUNIT_ASSERT_EQUAL(6, smaller[0]);
+        CPPUNIT_ASSERT_EQUAL(5, smaller[1]);
+    }
+
+    void testSamplerArray()
+    {
+        DataSamplerArray<int> test(3, 5);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(3), test.GetNumberOfCounters());
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), test.GetNumberOfSamples());
+        CPPUNIT_ASSERT_EQUAL(0, test.GetDelta(0, 5));
+
+        // Counter c gets the value (c + 1) * i in sample i
+        for (int i = 1; i <= 8; i++)
+        {
+            int samples[3] = { i, 2 * i, 3 * i };
+            test.AddSamples(samples);
+        }
+
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(5), test.GetNumberOfSamples());
+        CPPUNIT_ASSERT_EQUAL(4, test.GetDelta(0, 5));
+        CPPUNIT_ASSERT_EQUAL(8, test.GetDelta(1, 10));
+        CPPUNIT_ASSERT_EQUAL(3, test.GetDelta(2, 2));
+        CPPUNIT_ASSERT_EQUAL(3, test.GetAverageDelta(2, 5));
+        CPPUNIT_ASSERT_EQUAL(20, test.GetAverageDeltaFactored(1, 5, 10));
+        CPPUNIT_ASSERT( ! test.HasWrapped(0, 5));
+
+        int wrapped[3] = { 0, 0, 0 };
+        test.AddSamples(wrapped);
+        CPPUNIT_ASSERT(test.HasWrapped(1, 5));
+
+        test.Clear();
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), test.GetNumberOfSamples());
+    }
+
+    void testSamplerArrayGetSample()
+    {
+        DataSamplerArray<int> test(2, 3);
+        int first[2] = { 1, 10 };
+        int second[2] = { 2, 20 };
+        test.AddSamples(first);
+        test.AddSamples(second);
+
+        CPPUNIT_ASSERT_EQUAL(2, test.GetSample(0, 0));
+        CPPUNIT_ASSERT_EQUAL(10, test.GetSample(1, 1));
+        CPPUNIT_ASSERT_THROW(test.GetSample(0, 2), SCXCoreLib::SCXIllegalIndexException<size_t>);
+        CPPUNIT_ASSERT_THROW(test.GetSample(2, 0), SCXCoreLib::SCXIllegalIndexException<size_t>);
+        SCXUNIT_ASSERTIONS_FAILED_ANY();
+    }
+
+    void testFixedSamplerArray()
+    {
+        FixedDataSamplerArray<int, 3, 5> test;
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), test.GetNumberOfSamples());
+        CPPUNIT_ASSERT_EQUAL(0, test.GetDelta(0, 5));
+
+        // Same samples as in testSamplerArray, same results
+        for (int i = 1; i <= 8; i++)
+        {
+            int samples[3] = { i, 2 * i, 3 * i };
+            test.AddSamples(samples);
+        }
+
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(5), test.GetNumberOfSamples());
+        CPPUNIT_ASSERT_EQUAL(4, test.GetDelta(0, 5));
+        CPPUNIT_ASSERT_EQUAL(8, test.GetDelta(1, 10));
+        CPPUNIT_ASSERT_EQUAL(3, test.GetDelta(2, 2));
+        CPPUNIT_ASSERT_EQUAL(0, test.GetDelta(2, 1));
+        CPPUNIT_ASSERT_EQUAL(8, test.GetSample(0, 0));
+        CPPUNIT_ASSERT_EQUAL(12, test.GetSample(2, 4));
+        CPPUNIT_ASSERT_THROW(test.GetSample(0, 5), SCXCoreLib::SCXIllegalIndexException<size_t>);
+        CPPUNIT_ASSERT_THROW(test.GetSample(3, 0), SCXCoreLib::SCXIllegalIndexException<size_t>);
+        SCXUNIT_ASSERTIONS_FAILED_ANY();
+
+        // Copies are independent
+        FixedDataSamplerArray<int, 3, 5> copy(test);
+        test.Clear();
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), test.GetNumberOfSamples());
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(5), copy.GetNumberOfSamples());
+        CPPUNIT_ASSERT_EQUAL(4, copy.GetDelta(0, 5));
+    }
+
+    void testTimevalConversions()
+    {
+        struct timeval tv;
+        tv.tv_sec = 12;
+        tv.tv_usec = 999999;
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(12999999), TimevalToMicroseconds(tv));
+
+        // The fraction is the remainder, not rounded into the seconds
+        tv = MicrosecondsToTimeval<struct timeval>(1999999);
+        CPPUNIT_ASSERT_EQUAL(static_cast<time_t>(1), tv.tv_sec);
+        CPPUNIT_ASSERT_EQUAL(static_cast<suseconds_t>(999999), tv.tv_usec);
+        tv = MicrosecondsToTimeval<struct timeval>(999999);
+        CPPUNIT_ASSERT_EQUAL(static_cast<time_t>(0), tv.tv_sec);
+        CPPUNIT_ASSERT_EQUAL(static_cast<suseconds_t>(999999), tv.tv_usec);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(1234567890123ULL),
+                             TimevalToMicroseconds(MicrosecondsToTimeval<struct timeval>(1234567890123ULL)));
+
+        // Negative times give 0; too large ones saturate
+        tv.tv_sec = -1;
+        tv.tv_usec = 500000;
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(0), TimevalToMicroseconds(tv));
+        tv.tv_sec = std::numeric_limits<time_t>::max();
+        tv.tv_usec = 0;
+        CPPUNIT_ASSERT_EQUAL(std::numeric_limits<scxulong>::max(), TimevalToMicroseconds(tv));
+        tv.tv_sec = static_cast<time_t>(std::numeric_limits<scxulong>::max() / 1000000);
+        tv.tv_usec = 999999;
+        CPPUNIT_ASSERT_EQUAL(std::numeric_limits<scxulong>::max(), TimevalToMicroseconds(tv));
+        tv.tv_usec = static_cast<suseconds_t>(std::numeric_limits<scxulong>::max() % 1000000);
+        CPPUNIT_ASSERT_EQUAL(std::numeric_limits<scxulong>::max(), TimevalToMicroseconds(tv));
+        CPPUNIT_ASSERT_EQUAL(std::numeric_limits<scxulong>::max() - 1000000, TimevalToMicroseconds(
+                                 MicrosecondsToTimeval<struct timeval>(std::numeric_limits<scxulong>::max() - 1000000)));
+    }
+
+    /** A time type whose seconds hold less than a scxulong, as timeval is on 32 bit platforms */
+    struct NarrowTimespec
+    {
+        int tv_sec;         //!< Seconds
+        long tv_nsec;       //!< Nanoseconds
+    };
+
+    void testTimespecConversions()
+    {
+        struct timespec ts;
+        ts.tv_sec = 3;
+        ts.tv_nsec = 5;
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(3000000005ULL), TimespecToNanoseconds(ts));
+
+        ts = NanosecondsToTimespec<struct timespec>(2999999999ULL);
+        CPPUNIT_ASSERT_EQUAL(static_cast<time_t>(2), ts.tv_sec);
+        CPPUNIT_ASSERT_EQUAL(999999999L, static_cast<long>(ts.tv_nsec));
+
+        // 2^64 - 1 nanoseconds are about 584 years
+        ts = NanosecondsToTimespec<struct timespec>(std::numeric_limits<scxulong>::max());
+        CPPUNIT_ASSERT_EQUAL(static_cast<time_t>(18446744073LL), ts.tv_sec);
+        CPPUNIT_ASSERT_EQUAL(709551615L, static_cast<long>(ts.tv_nsec));
+        CPPUNIT_ASSERT_EQUAL(std::numeric_limits<scxulong>::max(), TimespecToNanoseconds(ts));
+        ts.tv_nsec++;
+        CPPUNIT_ASSERT_EQUAL(std::numeric_limits<scxulong>::max(), TimespecToNanoseconds(ts));
+
+        // Seconds that do not fit give the largest time that does
+        NarrowTimespec narrow = NanosecondsToTimespec<NarrowTimespec>(std::numeric_limits<scxulong>::max());
+        CPPUNIT_ASSERT_EQUAL(std::numeric_limits<int>::max(), narrow.tv_sec);
+        CPPUNIT_ASSERT_EQUAL(999999999L, narrow.tv_nsec);
+        narrow = NanosecondsToTimespec<NarrowTimespec>(static_cast<scxulong>(std::numeric_limits<int>::max()) * 1000000000 + 7);
+        CPPUNIT_ASSERT_EQUAL(std::numeric_limits<int>::max(), narrow.tv_sec);
+        CPPUNIT_ASSERT_EQUAL(7L, narrow.tv_nsec);
+    }
+
+    /** Times sampled as counters give the same deltas as the times themselves */
+    void testSampledTimeDelta()
+    {
+        FixedDataSamplerArray<scxulong, 1, 3> test;
+        struct timeval times[3] = { { 10, 900000 }, { 11, 100000 }, { 12, 50000 } };
+        for (size_t i = 0; i < 3; i++)
+        {
+            scxulong row[1] = { TimevalToMicroseconds(times[i]) };
+            test.AddSamples(row);
+        }
+
+        // A borrow from the seconds, as the timeval subtraction did
+        struct timeval delta = MicrosecondsToTimeval<struct timeval>(test.GetDelta(0, 2));
+        CPPUNIT_ASSERT_EQUAL(static_cast<time_t>(0), delta.tv_sec);
+        CPPUNIT_ASSERT_EQUAL(static_cast<suseconds_t>(950000), delta.tv_usec);
+        delta = MicrosecondsToTimeval<struct timeval>(test.GetDelta(0, 3));
+        CPPUNIT_ASSERT_EQUAL(static_cast<time_t>(1), delta.tv_sec);
+        CPPUNIT_ASSERT_EQUAL(static_cast<suseconds_t>(150000), delta.tv_usec);
+    }
+
+    void testAddSamplePerformance()
+    {
+        const size_t history = 60;
+        const size_t inserts = 2000000;
+        scxulong check = 0;
+
+        MemmoveSamples<scxulong> baseline(history);
+        TestStopwatch stopwatch;
+        for (size_t i = 0; i < inserts; i++)
+        {
+            baseline.Add(i);
+        }
+        double memmoveNs = stopwatch.GetNanosecondsPer(inserts);
+        check += baseline[0];
+
+        SampleRing<scxulong> ring(history);
+        stopwatch.Restart();
+        for (size_t i = 0; i < inserts; i++)
+        {
+            ring.push_front(i);
+        }
+        double ringNs = stopwatch.GetNanosecondsPer(inserts);
+        check += ring[0];
+
+        DataSampler<scxulong> sampler(history);
+        stopwatch.Restart();
+        for (size_t i = 0; i < inserts; i++)
+        {
+            sampler.AddSample(i);
+        }
+        double samplerNs = stopwatch.GetNanosecondsPer(inserts);
+        check += sampler[0];
+
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(3 * (inserts - 1)), check);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(history - 1), sampler.GetDelta(history));
+
+        std::wostringstream report;
+        report << L"Insert into " << history << L" sample history: memmove " << memmoveNs
+               << L" nsec, ring " << ringNs << L" nsec, DataSampler (locked) " << samplerNs << L" nsec";
+        TestStopwatch::Report(report.str());
+    }
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION( DataSampler_Test );
@@ -80,6 +80,16 @@ namespace
 
         }
 
+        DiskDependTest(const SCXCoreLib::SCXLogHandle& log)
+            : SCXSystemLib::DiskDependDefault(log)
+#if defined(linux)
+            , m_WI_479079_TestNumber(-1)
+#elif defined(hpux)
+            , m_pDiskInfo(NULL), m_pDiskInfoCount(0)
+#endif
+        {
+        }
+
         void SetOpenErrno(const std::string path, int e)
         {
             m_openErrno[path] = e;
@@ -90,10 +100,10 @@ namespace
             m_MntTabPath = path;
         }
 
-        //void SetProcDiskStatsPath(const SCXCoreLib::SCXFilePath& path)
-        //{
-        //    m_ProcDiskStatsPath = path;
-        //}
+        void SetProcDiskStatsPath(const SCXCoreLib::SCXFilePath& path)
+        {
+            m_ProcDiskStatsPath = path;
+        }
         
         void SetLvmTab(SCXCoreLib::SCXHandle<SCXSystemLib::SCXLvmTab> lvmTab)
         {
@@ -147,6 +157,12 @@ namespace
             return SCXSystemLib::DiskDependDefault::close();
         }
 
+        // The mocked device access is set up on this object only, so disks using it are updated one after another.
+        virtual SCXCoreLib::SCXHandle<SCXSystemLib::DiskDepend> CreateDeviceDepend()
+        {
+            return SCXCoreLib::SCXHandle<SCXSystemLib::DiskDepend>(0);
+        }
+
         // If a file has been mocked for open we use that info to return if  a file exists or not.
         // Otherwise we fall back to the default behavior.
         virtual bool FileExists(const std::wstring& path)
@@ -1480,6 +1496,13 @@ namespace
             m_fd = CLOSED_DESCRIPTOR;
             return 0;
         }
+        // Device access to the same mock physical disks, with a file descriptor of its own.
+        virtual SCXCoreLib::SCXHandle<SCXSystemLib::DiskDepend> CreateDeviceDepend()
+        {
+            PhysicalDiskSimulationDepend* deps = new PhysicalDiskSimulationDepend();
+            deps->SetupMockOS(m_Tests);
+            return SCXCoreLib::SCXHandle<SCXSystemLib::DiskDepend>(deps);
+        }
         // This function simulates the ioctl on a mock operating system with mock physical disks. Each disk has it's own
         // file descriptor.
         virtual int ioctl(unsigned long int request, void* data)
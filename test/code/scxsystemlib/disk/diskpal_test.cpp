@@ -29,6 +29,8 @@
 #include <scxsystemlib/statisticallogicaldiskenumeration.h>
 #if defined(linux)
 #include <scxsystemlib/scxlvmutils.h>
+#include <scxsystemlib/scxmountwatcher.h>
+#include <scxsystemlib/staticlogicaldiskenumeration.h>
 #endif
 #include <cppunit/extensions/HelperMacros.h>
 #include <testutils/scxunit.h>
@@ -916,6 +918,21 @@ loop1      0      0       0       0      0      0       0       0      0      0
     std::map<std::wstring,std::wstring> dev2lv;
 };
 
+#if defined(linux)
+/**
+   Reports the same mount tab generation until told otherwise, as if no file
+   system was mounted or unmounted.
+*/
+class FixedGenerationDiskDepend : public DiskDependTest
+{
+public:
+    FixedGenerationDiskDepend() : m_generation(1) {}
+    virtual scxulong GetMNTTabGeneration() { return m_generation; }
+
+    scxulong m_generation;      //!< Generation reported
+};
+#endif // defined(linux)
+
 class SCXStatisticalDiskPalSanityTest : public CPPUNIT_NS::TestFixture
 {
     CPPUNIT_TEST_SUITE( SCXStatisticalDiskPalSanityTest );
@@ -929,6 +946,18 @@ class SCXStatisticalDiskPalSanityTest : public CPPUNIT_NS::TestFixture
     CPPUNIT_TEST( LinkToPhysicalExistsLogsWhenReturningFalseFirstTime );
     CPPUNIT_TEST( LinkToPhysicalExistsLogsTraceWhenReturningFalseSecondTime );
     CPPUNIT_TEST( TestFindByDevice );
+#if defined(linux)
+    CPPUNIT_TEST( TestProcDiskStatsRows );
+    CPPUNIT_TEST( TestProcDiskStatsCompatibility );
+    CPPUNIT_TEST( TestProcDiskStatsDeviceChanges );
+    CPPUNIT_TEST( TestProcDiskStatsMalformedRow );
+    CPPUNIT_TEST( TestMountWatcher );
+    CPPUNIT_TEST( TestMountWatcherWithoutFile );
+    CPPUNIT_TEST( TestMNTTabGenerationUnchanged );
+    CPPUNIT_TEST( TestMNTTabFilterThenAll );
+    CPPUNIT_TEST( TestMNTTabGenerationOtherPath );
+    CPPUNIT_TEST( TestLogicalDiskEnumerationSkipsUnchangedMNTTab );
+#endif // defined(linux)
 #if defined(aix)
     CPPUNIT_TEST( Test_perfstat_disk_Regarding_Devices_Inside_Subdirectories_In_slashdev_Directory_RFC_483999 );
 #endif // defined(aix)
@@ -1078,6 +1107,52 @@ public:
         m_fBlockedHost = (bool)((0 == hostname.find(L"scxrrhpr13")) || (0 == hostname.find(L"scxbld-sol10-05")));
 #endif
     }
+#if defined(linux)
+    // Writes a diskstats file for the tests and returns a dependency object reading it.
+    SCXCoreLib::SCXHandle<DiskDependTest> MakeProcDiskStatsDeps(const std::string& contents)
+    {
+        return MakeProcDiskStatsDeps(contents, SCXCoreLib::SCXHandle<DiskDependTest>(new DiskDependTest()));
+    }
+
+    // Writes a diskstats file for the tests and points a dependency object at it.
+    SCXCoreLib::SCXHandle<DiskDependTest> MakeProcDiskStatsDeps(const std::string& contents,
+                                                                SCXCoreLib::SCXHandle<DiskDependTest> deps)
+    {
+        FILE* fp = fopen(PROC_DISKSTATS_TEST_FILE, "w");
+        CPPUNIT_ASSERT(NULL != fp);
+        CPPUNIT_ASSERT_EQUAL(contents.size(), fwrite(contents.data(), 1, contents.size(), fp));
+        fclose(fp);
+
+        deps->SetProcDiskStatsPath(SCXCoreLib::SCXFilePath(SCXCoreLib::StrFromUTF8(PROC_DISKSTATS_TEST_FILE)));
+        return deps;
+    }
+
+    static const char* PROC_DISKSTATS_TEST_FILE;
+
+    // Writes a mount tab file for the tests and points a dependency object at it.
+    void WriteMountTab(SCXCoreLib::SCXHandle<DiskDependTest> deps, const std::string& contents)
+    {
+        FILE* fp = fopen(MNTTAB_TEST_FILE, "w");
+        CPPUNIT_ASSERT(NULL != fp);
+        CPPUNIT_ASSERT_EQUAL(contents.size(), fwrite(contents.data(), 1, contents.size(), fp));
+        fclose(fp);
+
+        deps->SetMountTabPath(SCXCoreLib::SCXFilePath(SCXCoreLib::StrFromUTF8(MNTTAB_TEST_FILE)));
+    }
+
+    static const char* MNTTAB_TEST_FILE;
+
+    // Tells if the disk mounted at a mount point is online.
+    bool IsOnline(const SCXSystemLib::StaticLogicalDiskEnumeration& disks, const std::wstring& mountPoint)
+    {
+        SCXCoreLib::SCXHandle<SCXSystemLib::StaticLogicalDiskInstance> disk = disks.GetInstance(mountPoint);
+        CPPUNIT_ASSERT(0 != disk);
+        bool healthy = false;
+        CPPUNIT_ASSERT(disk->GetHealthState(healthy));
+        return healthy;
+    }
+#endif
+
     void setUp(void)
     {
         m_diskEnumPhysical = 0;
@@ -1088,6 +1163,9 @@ public:
 
     void tearDown(void)
     {
+#if defined(linux)
+        unlink(PROC_DISKSTATS_TEST_FILE);
+#endif
         if (0 != m_diskEnumPhysical)
         {
             m_diskEnumPhysical->CleanUp();
@@ -1335,6 +1413,191 @@ public:
         return ss.str();
     }
 
+#if defined(linux)
+    void TestProcDiskStatsRows()
+    {
+        SCXCoreLib::SCXHandle<DiskDependTest> deps = MakeProcDiskStatsDeps(
+            "   8       0 sda 1001 2 3003 4 5005 6 7007 8 9 10 11 12 13 14 15 16 17\n"
+            "   8       1 sda1 21 22 23 24\n"
+            " 253       0 dm-0 18446744073709551615 0 0 0 0 0 0 0 0 0 0\n");
+        deps->RefreshProcDiskStats();
+
+        const SCXSystemLib::ProcDiskStatsRow* row = deps->GetProcDiskStatsRow(L"/dev/sda");
+        CPPUNIT_ASSERT(0 != row);
+        CPPUNIT_ASSERT_EQUAL(std::string("sda"), row->name);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(20), row->columns);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(8), row->counters[0]);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(1001), row->counters[3]);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(7007), row->counters[9]);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(17), row->counters[19]);
+
+        // Short names are accepted as well
+        row = deps->GetProcDiskStatsRow(L"sda1");
+        CPPUNIT_ASSERT(0 != row);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(7), row->columns);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(24), row->counters[6]);
+
+        row = deps->GetProcDiskStatsRow(L"/dev/dm-0");
+        CPPUNIT_ASSERT(0 != row);
+        CPPUNIT_ASSERT_EQUAL(~static_cast<scxulong>(0), row->counters[3]);
+
+        CPPUNIT_ASSERT(0 == deps->GetProcDiskStatsRow(L"/dev/sdb"));
+    }
+
+    void TestProcDiskStatsCompatibility()
+    {
+        SCXCoreLib::SCXHandle<DiskDependTest> deps = MakeProcDiskStatsDeps(
+            "   8       0 sda 1001 2 3003 4 5005 6 7007 8 9 10 11\n"
+            "\n"
+            "   8       1 sda1 21 22 23 24\n");
+        deps->RefreshProcDiskStats();
+
+        std::vector<std::wstring> parts = deps->GetProcDiskStats(L"/dev/sda");
+        std::vector<std::wstring> expected;
+        SCXCoreLib::StrTokenize(L"8 0 sda 1001 2 3003 4 5005 6 7007 8 9 10 11", expected, L" ");
+        CPPUNIT_ASSERT(expected == parts);
+
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(7), deps->GetProcDiskStats(L"/dev/sda1").size());
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), deps->GetProcDiskStats(L"/dev/sdb").size());
+    }
+
+    void TestProcDiskStatsDeviceChanges()
+    {
+        SCXCoreLib::SCXHandle<DiskDependTest> deps = MakeProcDiskStatsDeps(
+            "   8       0 sda 1 2 3 4 5 6 7 8 9 10 11\n"
+            "   8      16 sdb 1 2 3 4 5 6 7 8 9 10 11\n");
+        deps->RefreshProcDiskStats();
+        CPPUNIT_ASSERT(0 != deps->GetProcDiskStatsRow(L"/dev/sdb"));
+
+        MakeProcDiskStatsDeps(
+            "   8       0 sda 100 2 3 4 5 6 7 8 9 10 11\n"
+            "   8      32 sdc 1 2 3 4 5 6 7 8 9 10 11\n");
+        deps->RefreshProcDiskStats();
+        CPPUNIT_ASSERT(0 == deps->GetProcDiskStatsRow(L"/dev/sdb"));
+        CPPUNIT_ASSERT(0 != deps->GetProcDiskStatsRow(L"/dev/sdc"));
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(100), deps->GetProcDiskStatsRow(L"/dev/sda")->counters[3]);
+
+        MakeProcDiskStatsDeps("");
+        deps->RefreshProcDiskStats();
+        CPPUNIT_ASSERT(0 == deps->GetProcDiskStatsRow(L"/dev/sda"));
+    }
+
+    void TestProcDiskStatsMalformedRow()
+    {
+        TestLogFrameworkHelper logframework;
+        SCXCoreLib::SCXHandle<DiskDependTest> deps = MakeProcDiskStatsDeps(
+            "   8       0 sda 1001 2 3003 4 5005 6 7007 8 9 10 11\n"
+            "   8      16 sdb 1 2 3x03 4 5 6 7 8 9 10 11\n"
+            "   8      32 sdc 1 2 3 4 5 6 7 8 9 10 18446744073709551616\n"
+            "   8      48 sdd 1 2 -3 4 5 6 7 8 9 10 11\n"
+            "   8      64 sde 1 2 3 4 5 6 7 8 9 10 11\n",
+            SCXCoreLib::SCXHandle<DiskDependTest>(new DiskDependTest(logframework.GetHandle())));
+        deps->RefreshProcDiskStats();
+
+        SCXCoreLib::SCXLogItem item = logframework.GetLastLogItem();
+        CPPUNIT_ASSERT_EQUAL(SCXCoreLib::eWarning, item.GetSeverity());
+        CPPUNIT_ASSERT_EQUAL(std::string("Could not parse line from diskstats for device \"sdd\" - cannot parse scxulong in: '-3'"),
+                             SCXCoreLib::StrToUTF8(item.GetMessage()));
+
+        // Malformed rows are skipped, not truncated to the digits they start with
+        CPPUNIT_ASSERT(0 == deps->GetProcDiskStatsRow(L"/dev/sdb"));
+        CPPUNIT_ASSERT(0 == deps->GetProcDiskStatsRow(L"/dev/sdc"));
+        CPPUNIT_ASSERT(0 == deps->GetProcDiskStatsRow(L"/dev/sdd"));
+        CPPUNIT_ASSERT(0 != deps->GetProcDiskStatsRow(L"/dev/sda"));
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(3003), deps->GetProcDiskStatsRow(L"/dev/sda")->counters[5]);
+        CPPUNIT_ASSERT(0 != deps->GetProcDiskStatsRow(L"/dev/sde"));
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(64), deps->GetProcDiskStatsRow(L"/dev/sde")->counters[1]);
+    }
+
+    void TestMountWatcher()
+    {
+        SCXSystemLib::SCXMountWatcher watcher;
+        CPPUNIT_ASSERT(watcher.IsWatching());
+        CPPUNIT_ASSERT(watcher.HasChanged());
+        // Nothing is mounted while the test runs
+        CPPUNIT_ASSERT( ! watcher.HasChanged());
+        CPPUNIT_ASSERT( ! watcher.HasChanged());
+    }
+
+    void TestMountWatcherWithoutFile()
+    {
+        SCXSystemLib::SCXMountWatcher watcher("/proc/self/this-file-does-not-exist");
+        CPPUNIT_ASSERT( ! watcher.IsWatching());
+        CPPUNIT_ASSERT(watcher.HasChanged());
+        CPPUNIT_ASSERT(watcher.HasChanged());
+    }
+
+    void TestMNTTabGenerationUnchanged()
+    {
+        SCXSystemLib::DiskDependDefault deps;
+        deps.RefreshMNTTab();
+        scxulong generation = deps.GetMNTTabGeneration();
+        size_t size = deps.GetMNTTab().size();
+        CPPUNIT_ASSERT(0 != generation);
+
+        deps.RefreshMNTTab();
+        CPPUNIT_ASSERT_EQUAL(generation, deps.GetMNTTabGeneration());
+        CPPUNIT_ASSERT_EQUAL(size, deps.GetMNTTab().size());
+    }
+
+    void TestMNTTabFilterThenAll()
+    {
+        SCXSystemLib::DiskDependDefault deps;
+        deps.RefreshMNTTab();
+        std::vector<SCXSystemLib::MntTabEntry> all = deps.GetMNTTab();
+        if (all.empty())
+        {
+            SCXUNIT_WARNING(L"No file systems in the mount tab, skipping test");
+            return;
+        }
+
+        SCXSystemLib::RefreshMNTTabParam param(SCXSystemLib::RefreshMNTTabParam::MOUNTPOINT, all.back().mountPoint);
+        deps.RefreshMNTTab(&param);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), deps.GetMNTTab().size());
+        CPPUNIT_ASSERT(all.back().mountPoint == deps.GetMNTTab()[0].mountPoint);
+
+        // The cached table is still complete after a filtered refresh
+        deps.RefreshMNTTab();
+        CPPUNIT_ASSERT_EQUAL(all.size(), deps.GetMNTTab().size());
+    }
+
+    void TestMNTTabGenerationOtherPath()
+    {
+        SCXCoreLib::SCXHandle<DiskDependTest> deps(new DiskDependTest());
+        WriteMountTab(deps, "/dev/sda1 / ext4 rw 0 0\n");
+        deps->RefreshMNTTab();
+        scxulong generation = deps->GetMNTTabGeneration();
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), deps->GetMNTTab().size());
+
+        // A mount tab that is not watched is read on every refresh
+        WriteMountTab(deps, "/dev/sda1 / ext4 rw 0 0\n/dev/sdb1 /data ext4 rw 0 0\n");
+        deps->RefreshMNTTab();
+        CPPUNIT_ASSERT(generation != deps->GetMNTTabGeneration());
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), deps->GetMNTTab().size());
+    }
+
+    void TestLogicalDiskEnumerationSkipsUnchangedMNTTab()
+    {
+        SCXCoreLib::SCXHandle<FixedGenerationDiskDepend> deps(new FixedGenerationDiskDepend());
+        WriteMountTab(deps, "/dev/sda1 / ext4 rw 0 0\n/dev/sdb1 /data ext4 rw 0 0\n");
+        SCXSystemLib::StaticLogicalDiskEnumeration disks(deps);
+        disks.Update(false);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), disks.Size());
+        CPPUNIT_ASSERT(IsOnline(disks, L"/data"));
+
+        // Same generation: the mount tab is taken as unchanged
+        WriteMountTab(deps, "/dev/sda1 / ext4 rw 0 0\n");
+        disks.Update(false);
+        CPPUNIT_ASSERT(IsOnline(disks, L"/data"));
+
+        deps->m_generation++;
+        disks.Update(false);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), disks.Size());
+        CPPUNIT_ASSERT( ! IsOnline(disks, L"/data"));
+        CPPUNIT_ASSERT(IsOnline(disks, L"/"));
+    }
+#endif // defined(linux)
+
     void TestFindByDevice()
     {
 #if defined(RESOLVE_HOSTNAME_FORBLOCKINGTESTS)
@@ -2367,5 +2630,10 @@ public:
 #endif // defined(aix)
 };
 
+#if defined(linux)
+const char* SCXStatisticalDiskPalSanityTest::PROC_DISKSTATS_TEST_FILE = "diskstats.test";
+const char* SCXStatisticalDiskPalSanityTest::MNTTAB_TEST_FILE = "mnttab.test";
+#endif
+
 CPPUNIT_TEST_SUITE_REGISTRATION( SCXStatisticalDiskPalSanityTest );
 
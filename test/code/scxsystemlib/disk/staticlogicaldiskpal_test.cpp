@@ -673,6 +673,7 @@ public:
 
         deps->SetMountTabPath(fauxMntTab);
         CPPUNIT_ASSERT_NO_THROW(m_diskEnum = new SCXSystemLib::StaticLogicalDiskEnumeration(deps));
+        CPPUNIT_ASSERT(0 != m_diskEnum->GetParallelUpdater());
         CPPUNIT_ASSERT_NO_THROW(m_diskEnum->Init());
         CPPUNIT_ASSERT_NO_THROW(m_diskEnum->Update(true));
 
@@ -1116,6 +1116,8 @@ public:
         SCXCoreLib::SCXHandle<PhysicalDiskSimulationDepend> deps( new PhysicalDiskSimulationDepend() );
         deps->SetupMockOS(Tests);
         CPPUNIT_ASSERT_NO_THROW(m_diskEnum = new SCXSystemLib::StaticPhysicalDiskEnumeration(deps));
+        // Each simulated disk gets a device descriptor of its own, so they are updated in parallel
+        CPPUNIT_ASSERT(0 != m_diskEnum->GetParallelUpdater());
         CPPUNIT_ASSERT_NO_THROW(m_diskEnum->Init());
         CPPUNIT_ASSERT_NO_THROW(m_diskEnum->Update(true));
         CPPUNIT_ASSERT_EQUAL(Tests.size(), m_diskEnum->Size());
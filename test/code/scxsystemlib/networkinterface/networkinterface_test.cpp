@@ -21,9 +21,11 @@
 
 #include <scxsystemlib/networkinterface.h>
 #include <scxsystemlib/networkinterfaceenumeration.h>
+#include <scxsystemlib/networkinterfacesampler.h>
 #include <scxsystemlib/scxsysteminfo.h>
 #include <scxcorelib/stringaid.h>
 #include <scxcorelib/scxthread.h>
+#include <scxcorelib/scxthreadpool.h>
 #include <scxcorelib/scxexception.h> /* CUSTOMIZE: Only needed if you want to test exception throwing */
 #include <scxcorelib/scxprocess.h>
 #include <testutils/scxunit.h>
@@ -39,6 +41,14 @@
 #include <sys/sockio.h>
 #endif
 
+#if defined(linux)
+#include <linux/types.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <net/if_arp.h>
+#include <fcntl.h>
+#endif
+
 #if defined (hpux)
 #include <sys/dlpi.h>
 #include <sys/dlpi_ext.h>
@@ -47,6 +57,8 @@
 #include <vector>
 #endif
 
+#include <fstream>
+#include <map>
 #include <queue>
 
 using namespace SCXSystemLib;
@@ -873,6 +885,208 @@ public:
     }; 
 #endif // #if defined(hpux) || defined(aix)
 
+#if defined(linux)
+/**
+   Writes a statistics file with a given number of interfaces and counts the ioctl()
+   calls made for each of them. Every interface is up and running; all other ioctl()
+   requests fail.
+*/
+class CountingNetworkInterfaceDependencies : public NetworkInterfaceDependencies {
+public:
+    CountingNetworkInterfaceDependencies(size_t interfaces) : m_file(L"./procnetdev_many.txt"), m_lock(ThreadLockHandleGet()) {
+        Write(interfaces, 0);
+    }
+
+    //! Write the statistics file; interface vethN has received N + bytesOffset bytes
+    void Write(size_t interfaces, scxulong bytesOffset) {
+        std::ofstream out(StrToUTF8(m_file.Get()).c_str());
+        out << "Inter-|   Receive                                                |  Transmit" << std::endl
+            << " face |bytes    packets errs drop fifo frame compressed multicast|bytes    packets errs drop fifo colls carrier compressed" << std::endl;
+        for (size_t nr = 0; nr < interfaces; nr++) {
+            out << " veth" << nr << ": " << nr + bytesOffset << " 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16" << std::endl;
+        }
+    }
+
+    virtual SCXFilePath GetDynamicInfoFile() const {
+        return m_file;
+    }
+
+    virtual int ioctl(int /*fildes*/, int request, void *ifreqptr) {
+        ifreq &ifr = *static_cast<ifreq *>(ifreqptr);
+        {
+            SCXThreadLock lock(m_lock);
+            m_ioctlsByName[ifr.ifr_name]++;
+        }
+        if (SIOCGIFFLAGS == request) {
+            ifr.ifr_flags = IFF_UP | IFF_RUNNING;
+            return 0;
+        }
+        errno = EINVAL;
+        return -1;
+    }
+
+    //! Total number of ioctl() calls
+    size_t GetIoctlCount() const {
+        size_t count = 0;
+        for (std::map<std::string, size_t>::const_iterator it = m_ioctlsByName.begin(); it != m_ioctlsByName.end(); ++it) {
+            count += it->second;
+        }
+        return count;
+    }
+
+    SCXFilePath m_file;                                 //!< Interface statistics file
+    std::map<std::string, size_t> m_ioctlsByName;       //!< ioctl() calls by interface name
+    SCXThreadLockHandle m_lock;                         //!< Protects m_ioctlsByName during parallel updates
+};
+
+/**
+   Netlink socket whose dumps return prepared replies, or fail.
+*/
+class FakeNetlinkRouteSocket : public NetlinkRouteSocket {
+public:
+    FakeNetlinkRouteSocket() : m_fail(false) { }
+
+    virtual void Dump(unsigned short type, unsigned char /*family*/, std::vector<char>& messages) {
+        if (m_fail) {
+            throw SCXErrnoException(L"recv(PF_NETLINK)", EAGAIN, SCXSRCLOCATION);
+        }
+        messages = RTM_GETLINK == type ? m_links : m_addresses;
+    }
+
+    //! Append a message to a reply
+    //! \returns Offset of the message in the reply
+    static size_t AddMessage(std::vector<char>& reply, unsigned short type, const void *header, size_t size) {
+        size_t start = reply.size();
+        struct nlmsghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.nlmsg_type = type;
+        msg.nlmsg_len = static_cast<__u32>(NLMSG_LENGTH(size));
+        reply.insert(reply.end(), reinterpret_cast<const char *>(&msg), reinterpret_cast<const char *>(&msg) + sizeof(msg));
+        reply.insert(reply.end(), static_cast<const char *>(header), static_cast<const char *>(header) + size);
+        reply.resize(start + NLMSG_ALIGN(reply.size() - start));
+        return start;
+    }
+
+    //! Append an attribute to the message at a given offset, the last one of the reply
+    static void AddAttribute(std::vector<char>& reply, size_t start, unsigned short type, const void *data, size_t size) {
+        struct rtattr attr;
+        attr.rta_len = static_cast<unsigned short>(RTA_LENGTH(size));
+        attr.rta_type = type;
+        reply.insert(reply.end(), reinterpret_cast<const char *>(&attr), reinterpret_cast<const char *>(&attr) + sizeof(attr));
+        reply.insert(reply.end(), static_cast<const char *>(data), static_cast<const char *>(data) + size);
+        reply.resize(start + RTA_ALIGN(reply.size() - start));
+        reinterpret_cast<struct nlmsghdr *>(&reply[start])->nlmsg_len = static_cast<__u32>(reply.size() - start);
+    }
+
+    bool m_fail;                        //!< Should dumps fail?
+    std::vector<char> m_links;          //!< Reply to RTM_GETLINK
+    std::vector<char> m_addresses;      //!< Reply to RTM_GETADDR
+};
+
+/**
+   Looks up interfaces over a fake netlink socket and counts the ioctl() calls, which all fail.
+*/
+class NetlinkNetworkInterfaceDependencies : public NetworkInterfaceDependencies {
+public:
+    NetlinkNetworkInterfaceDependencies() : m_netlink(new FakeNetlinkRouteSocket()), m_ioctls(0) { }
+
+    virtual SCXHandle<NetlinkRouteSocket> GetNetlinkRouteSocket() {
+        return m_netlink;
+    }
+
+    virtual int ioctl(int /*fildes*/, int /*request*/, void * /*ifreqptr*/) {
+        m_ioctls++;
+        errno = EOPNOTSUPP;
+        return -1;
+    }
+
+    SCXHandle<FakeNetlinkRouteSocket> m_netlink;    //!< Replies to the dumps
+    size_t m_ioctls;                                //!< Number of ioctl() calls
+};
+
+/**
+   Writes a statistics file like CountingNetworkInterfaceDependencies, but first tries a netlink socket that fails.
+*/
+class FailingNetlinkNetworkInterfaceDependencies : public CountingNetworkInterfaceDependencies {
+public:
+    FailingNetlinkNetworkInterfaceDependencies(size_t interfaces) :
+        CountingNetworkInterfaceDependencies(interfaces), m_netlink(new FakeNetlinkRouteSocket()) {
+        m_netlink->m_fail = true;
+    }
+
+    virtual SCXHandle<NetlinkRouteSocket> GetNetlinkRouteSocket() {
+        return m_netlink;
+    }
+
+    SCXHandle<FakeNetlinkRouteSocket> m_netlink;    //!< Fails every dump
+};
+
+/**
+   Looks up the interfaces of the system in the statistics file and with ioctl() calls, never with netlink.
+*/
+class FileNetworkInterfaceDependencies : public NetworkInterfaceDependencies {
+public:
+    virtual SCXHandle<NetlinkRouteSocket> GetNetlinkRouteSocket() {
+        return SCXHandle<NetlinkRouteSocket>(0);
+    }
+};
+
+/**
+   Netlink socket whose kernel answers each dump request with one link and marks
+   the first replies as interrupted, as when the table changes during the dump.
+*/
+class InterruptedNetlinkRouteSocket : public NetlinkRouteSocket {
+public:
+    InterruptedNetlinkRouteSocket(size_t interruptions) : m_interruptions(interruptions), m_requests(0), m_seq(0) { }
+
+protected:
+    //! A descriptor that is not a socket, so that setsockopt() fails and close() works
+    virtual int socket(int /*domain*/, int /*type*/, int /*protocol*/) {
+        return ::open("/dev/null", O_RDONLY);
+    }
+
+    virtual ssize_t send(int /*sockfd*/, const void *buf, size_t len, int /*flags*/) {
+        m_seq = static_cast<const struct nlmsghdr *>(buf)->nlmsg_seq;
+        m_requests++;
+        return static_cast<ssize_t>(len);
+    }
+
+    virtual ssize_t recv(int /*sockfd*/, void *buf, size_t len, int /*flags*/) {
+        std::vector<char> reply;
+        struct ifinfomsg ifi;
+        memset(&ifi, 0, sizeof(ifi));
+        ifi.ifi_index = static_cast<int>(m_requests);
+        AddMessage(reply, RTM_NEWLINK, &ifi, sizeof(ifi));
+        AddMessage(reply, NLMSG_DONE, &ifi, sizeof(ifi));
+        CPPUNIT_ASSERT(reply.size() <= len);
+        memcpy(buf, &reply[0], reply.size());
+        return static_cast<ssize_t>(reply.size());
+    }
+
+private:
+    void AddMessage(std::vector<char>& reply, unsigned short type, const void *header, size_t size) {
+        size_t start = reply.size();
+        struct nlmsghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.nlmsg_type = type;
+        msg.nlmsg_len = static_cast<__u32>(NLMSG_LENGTH(size));
+        msg.nlmsg_seq = m_seq;
+        msg.nlmsg_flags = NLM_F_MULTI;
+        if (m_requests <= m_interruptions) {
+            msg.nlmsg_flags |= 0x10; // NLM_F_DUMP_INTR
+        }
+        reply.insert(reply.end(), reinterpret_cast<const char *>(&msg), reinterpret_cast<const char *>(&msg) + sizeof(msg));
+        reply.insert(reply.end(), static_cast<const char *>(header), static_cast<const char *>(header) + size);
+        reply.resize(start + NLMSG_ALIGN(reply.size() - start));
+    }
+
+public:
+    size_t m_interruptions;     //!< Number of dump requests answered with an interrupted dump
+    size_t m_requests;          //!< Number of dump requests sent
+    __u32 m_seq;                //!< Sequence number of the latest request
+};
+#endif
+
 // Tests the network interface PAL
 class SCXNetworkInterfaceTest : public CPPUNIT_NS::TestFixture /* CUSTOMIZE: use a class name with relevant name */
 {
@@ -887,6 +1101,22 @@ class SCXNetworkInterfaceTest : public CPPUNIT_NS::TestFixture /* CUSTOMIZE: use
     CPPUNIT_TEST( TestEnumerationSoundness );
     CPPUNIT_TEST( TestBug5175_IgnoreNetDevicesNotInterfaces );
     CPPUNIT_TEST( TestMTU );
+#if defined(linux)
+    CPPUNIT_TEST( TestFindAllCountsSystemCalls );
+    CPPUNIT_TEST( TestEnumerationUpdateReadsOnce );
+    CPPUNIT_TEST( TestInstanceUpdateLooksUpOnlyItself );
+    CPPUNIT_TEST( TestParallelUpdateLooksUpEachInstance );
+    CPPUNIT_TEST( TestFindAllUsingNetlink );
+    CPPUNIT_TEST( TestNetlinkFailureReadsFile );
+    CPPUNIT_TEST( TestNetlinkMatchesFile );
+    CPPUNIT_TEST( TestFindAllStatisticsTakesOneDump );
+    CPPUNIT_TEST( TestNetlinkRetriesInterruptedDump );
+    CPPUNIT_TEST( TestFileDrops );
+    CPPUNIT_TEST( TestSamplerRates );
+    CPPUNIT_TEST( TestSamplerWrapsAndResets );
+    CPPUNIT_TEST( TestSamplerForgetsInterfaces );
+    CPPUNIT_TEST( TestSamplerScheduled );
+#endif
 #if defined(hpux)
     CPPUNIT_TEST( TestHP_FindAllInDLPI_AtLeastOneInterface );
     CPPUNIT_TEST( TestHP_FindAllInDLPI_ComparedToLanscan );
@@ -1895,6 +2125,560 @@ public:
 #endif
     }
 
+#if defined(linux)
+    void TestFindAllCountsSystemCalls()
+    {
+        SCXHandle<CountingNetworkInterfaceDependencies> deps(new CountingNetworkInterfaceDependencies(50));
+        NetworkInterfaceRefreshCounters counters;
+        std::vector<NetworkInterfaceInfo> interfaces = NetworkInterfaceInfo::FindAll(deps, true, L"", &counters);
+
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(50), interfaces.size());
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(1), counters.fileReads);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(2), counters.sockets);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(1), counters.addressLookups);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(deps->GetIoctlCount()), counters.ioctls);
+        // Flags while reading the file, then eight attribute lookups for each interface
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(50 * 9), counters.ioctls);
+    }
+
+    void TestEnumerationUpdateReadsOnce()
+    {
+        SCXHandle<CountingNetworkInterfaceDependencies> deps(new CountingNetworkInterfaceDependencies(50));
+        NetworkInterfaceEnumeration interfaces(deps);
+        interfaces.Init();
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(50), interfaces.Size());
+
+        deps->m_ioctlsByName.clear();
+        interfaces.Update(true);
+        const NetworkInterfaceRefreshCounters& counters = interfaces.GetLastUpdateCounters();
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(1), counters.fileReads);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(1), counters.addressLookups);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(50 * 9), counters.ioctls);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(50 * 9), deps->GetIoctlCount());
+
+        scxulong value = 0;
+        CPPUNIT_ASSERT(interfaces.GetInstance(L"veth42")->GetBytesReceived(value));
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(42), value);
+    }
+
+    void TestInstanceUpdateLooksUpOnlyItself()
+    {
+        SCXHandle<CountingNetworkInterfaceDependencies> deps(new CountingNetworkInterfaceDependencies(50));
+        NetworkInterfaceEnumeration interfaces(deps);
+        interfaces.Init();
+
+        deps->m_ioctlsByName.clear();
+        SCXHandle<NetworkInterfaceInstance> instance = interfaces.GetInstance(L"veth7");
+        CPPUNIT_ASSERT(0 != instance);
+        instance->Update();
+
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), deps->m_ioctlsByName.size());
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(9), deps->m_ioctlsByName["veth7"]);
+        scxulong value = 0;
+        CPPUNIT_ASSERT(instance->GetBytesReceived(value));
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(7), value);
+    }
+
+    void TestParallelUpdateLooksUpEachInstance()
+    {
+        SCXHandle<CountingNetworkInterfaceDependencies> deps(new CountingNetworkInterfaceDependencies(50));
+        NetworkInterfaceEnumeration interfaces(deps);
+        interfaces.Init();
+        CPPUNIT_ASSERT(0 == interfaces.GetParallelUpdater());
+        SCXHandle<SCXThreadPool> pool(new SCXThreadPool());
+        pool->Start();
+        interfaces.SetParallelUpdate(pool, 0);
+
+        deps->m_ioctlsByName.clear();
+        deps->Write(50, 1000);
+        interfaces.Update(true);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(50), pool->GetStatistics().tasksStarted);
+        pool->Shutdown();
+
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(50), deps->m_ioctlsByName.size());
+        for (size_t nr = 0; nr < 50; nr++) {
+            std::string name = "veth" + StrToUTF8(StrFrom(nr));
+            CPPUNIT_ASSERT_EQUAL_MESSAGE(name, static_cast<size_t>(9), deps->m_ioctlsByName[name]);
+            scxulong value = 0;
+            CPPUNIT_ASSERT(interfaces.GetInstance(StrFromUTF8(name))->GetBytesReceived(value));
+            CPPUNIT_ASSERT_EQUAL_MESSAGE(name, static_cast<scxulong>(1000 + nr), value);
+        }
+    }
+
+    void TestFindAllUsingNetlink()
+    {
+        SCXHandle<NetlinkNetworkInterfaceDependencies> deps(new NetlinkNetworkInterfaceDependencies());
+        std::vector<char>& links = deps->m_netlink->m_links;
+        std::vector<char>& addresses = deps->m_netlink->m_addresses;
+
+        struct ifinfomsg ifi;
+        memset(&ifi, 0, sizeof(ifi));
+        size_t msg;
+
+        // Loopback, to be skipped
+        ifi.ifi_index = 1;
+        ifi.ifi_type = ARPHRD_LOOPBACK;
+        ifi.ifi_flags = IFF_LOOPBACK | IFF_UP | IFF_RUNNING;
+        msg = FakeNetlinkRouteSocket::AddMessage(links, RTM_NEWLINK, &ifi, sizeof(ifi));
+        FakeNetlinkRouteSocket::AddAttribute(links, msg, IFLA_IFNAME, "lo", 3);
+
+        // Running, with 32-bit statistics followed by 64-bit ones
+        ifi.ifi_index = 7;
+        ifi.ifi_type = ARPHRD_ETHER;
+        ifi.ifi_flags = IFF_UP | IFF_RUNNING;
+        msg = FakeNetlinkRouteSocket::AddMessage(links, RTM_NEWLINK, &ifi, sizeof(ifi));
+        FakeNetlinkRouteSocket::AddAttribute(links, msg, IFLA_IFNAME, "eth7", 5);
+        __u32 mtu = 9000;
+        FakeNetlinkRouteSocket::AddAttribute(links, msg, IFLA_MTU, &mtu, sizeof(mtu));
+        const unsigned char mac[6] = { 0x00, 0x15, 0x5d, 0x01, 0x02, 0x03 };
+        FakeNetlinkRouteSocket::AddAttribute(links, msg, IFLA_ADDRESS, mac, sizeof(mac));
+        __u32 stats32[10] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+        FakeNetlinkRouteSocket::AddAttribute(links, msg, IFLA_STATS, stats32, sizeof(stats32));
+        // More bytes received than fit in 32 bits
+        const __u64 manyBytes = static_cast<__u64>(5) * 1000 * 1000 * 1000;
+        __u64 stats64[10] = { 11, 12, manyBytes, 14, 15, 16, 17, 18, 19, 20 };
+        FakeNetlinkRouteSocket::AddAttribute(links, msg, 23 /* IFLA_STATS64 */, stats64, sizeof(stats64));
+
+        // Up, but not running, and without statistics
+        ifi.ifi_index = 8;
+        ifi.ifi_flags = IFF_UP;
+        msg = FakeNetlinkRouteSocket::AddMessage(links, RTM_NEWLINK, &ifi, sizeof(ifi));
+        FakeNetlinkRouteSocket::AddAttribute(links, msg, IFLA_IFNAME, "eth8", 5);
+
+        // Only 32-bit statistics
+        ifi.ifi_index = 9;
+        ifi.ifi_flags = IFF_UP | IFF_RUNNING;
+        msg = FakeNetlinkRouteSocket::AddMessage(links, RTM_NEWLINK, &ifi, sizeof(ifi));
+        FakeNetlinkRouteSocket::AddAttribute(links, msg, IFLA_IFNAME, "veth9", 6);
+        FakeNetlinkRouteSocket::AddAttribute(links, msg, IFLA_STATS, stats32, sizeof(stats32));
+
+        struct ifaddrmsg ifa;
+        memset(&ifa, 0, sizeof(ifa));
+        struct in_addr addr4;
+        struct in6_addr addr6;
+
+        ifa.ifa_family = AF_INET;
+        ifa.ifa_prefixlen = 24;
+        ifa.ifa_index = 7;
+        msg = FakeNetlinkRouteSocket::AddMessage(addresses, RTM_NEWADDR, &ifa, sizeof(ifa));
+        inet_pton(AF_INET, "10.1.2.3", &addr4);
+        FakeNetlinkRouteSocket::AddAttribute(addresses, msg, IFA_ADDRESS, &addr4, sizeof(addr4));
+        FakeNetlinkRouteSocket::AddAttribute(addresses, msg, IFA_LOCAL, &addr4, sizeof(addr4));
+        inet_pton(AF_INET, "10.1.2.255", &addr4);
+        FakeNetlinkRouteSocket::AddAttribute(addresses, msg, IFA_BROADCAST, &addr4, sizeof(addr4));
+        FakeNetlinkRouteSocket::AddAttribute(addresses, msg, IFA_LABEL, "eth7", 5);
+
+        // Alias, not reported as the address of the interface
+        ifa.ifa_prefixlen = 16;
+        msg = FakeNetlinkRouteSocket::AddMessage(addresses, RTM_NEWADDR, &ifa, sizeof(ifa));
+        inet_pton(AF_INET, "10.9.0.1", &addr4);
+        FakeNetlinkRouteSocket::AddAttribute(addresses, msg, IFA_LOCAL, &addr4, sizeof(addr4));
+        FakeNetlinkRouteSocket::AddAttribute(addresses, msg, IFA_LABEL, "eth7:1", 7);
+
+        ifa.ifa_family = AF_INET6;
+        ifa.ifa_prefixlen = 64;
+        msg = FakeNetlinkRouteSocket::AddMessage(addresses, RTM_NEWADDR, &ifa, sizeof(ifa));
+        inet_pton(AF_INET6, "fe80::1", &addr6);
+        FakeNetlinkRouteSocket::AddAttribute(addresses, msg, IFA_ADDRESS, &addr6, sizeof(addr6));
+
+        // Loopback address, of an interface not found
+        ifa.ifa_family = AF_INET;
+        ifa.ifa_prefixlen = 8;
+        ifa.ifa_index = 1;
+        msg = FakeNetlinkRouteSocket::AddMessage(addresses, RTM_NEWADDR, &ifa, sizeof(ifa));
+        inet_pton(AF_INET, "127.0.0.1", &addr4);
+        FakeNetlinkRouteSocket::AddAttribute(addresses, msg, IFA_LOCAL, &addr4, sizeof(addr4));
+
+        // Host address without a broadcast address
+        ifa.ifa_prefixlen = 32;
+        ifa.ifa_index = 8;
+        msg = FakeNetlinkRouteSocket::AddMessage(addresses, RTM_NEWADDR, &ifa, sizeof(ifa));
+        inet_pton(AF_INET, "192.168.5.5", &addr4);
+        FakeNetlinkRouteSocket::AddAttribute(addresses, msg, IFA_LOCAL, &addr4, sizeof(addr4));
+
+        NetworkInterfaceRefreshCounters counters;
+        std::vector<NetworkInterfaceInfo> interfaces = NetworkInterfaceInfo::FindAll(deps, true, L"", &counters);
+
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(3), interfaces.size());
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(2), counters.netlinkDumps);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(0), counters.fileReads);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(0), counters.addressLookups);
+        // Only the link settings, with ethtool
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(3), counters.ioctls);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(3), deps->m_ioctls);
+
+        const NetworkInterfaceInfo &eth7 = interfaces[0];
+        CPPUNIT_ASSERT(L"eth7" == eth7.GetName());
+        CPPUNIT_ASSERT(eth7.IsUp());
+        CPPUNIT_ASSERT(eth7.IsRunning());
+        scxulong value = 0;
+        CPPUNIT_ASSERT(eth7.GetMTU(value));
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(9000), value);
+        unsigned int index = 0;
+        CPPUNIT_ASSERT(eth7.GetInterfaceIndex(index));
+        CPPUNIT_ASSERT_EQUAL(7u, index);
+        wstring text;
+        CPPUNIT_ASSERT(eth7.GetMACAddressRAW(text));
+        CPPUNIT_ASSERT(L"00155d010203" == text);
+        CPPUNIT_ASSERT(eth7.GetAdapterType(text));
+        CPPUNIT_ASSERT(L"Ethernet 802.3" == text);
+        CPPUNIT_ASSERT(L"10.1.2.3" == eth7.GetIPAddress());
+        CPPUNIT_ASSERT(L"255.255.255.0" == eth7.GetNetmask());
+        CPPUNIT_ASSERT(L"10.1.2.255" == eth7.GetBroadcastAddress());
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), eth7.GetIPV6Address().size());
+        CPPUNIT_ASSERT(L"fe80::1" == eth7.GetIPV6Address()[0]);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(11), eth7.GetPacketsReceived());
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(12), eth7.GetPacketsSent());
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(manyBytes), eth7.GetBytesReceived());
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(14), eth7.GetBytesSent());
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(15), eth7.GetErrorsReceiving());
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(16), eth7.GetErrorsSending());
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(20), eth7.GetCollisions());
+
+        const NetworkInterfaceInfo &eth8 = interfaces[1];
+        CPPUNIT_ASSERT(L"eth8" == eth8.GetName());
+        CPPUNIT_ASSERT(eth8.IsUp());
+        CPPUNIT_ASSERT( ! eth8.IsRunning());
+        CPPUNIT_ASSERT( ! eth8.IsBytesReceivedKnown());
+        CPPUNIT_ASSERT( ! eth8.GetMTU(value));
+        CPPUNIT_ASSERT(L"192.168.5.5" == eth8.GetIPAddress());
+        CPPUNIT_ASSERT(L"255.255.255.255" == eth8.GetNetmask());
+        CPPUNIT_ASSERT(L"0.0.0.0" == eth8.GetBroadcastAddress());
+        CPPUNIT_ASSERT(eth8.GetMACAddressRAW(text));
+        CPPUNIT_ASSERT(L"000000000000" == text);
+
+        const NetworkInterfaceInfo &veth9 = interfaces[2];
+        CPPUNIT_ASSERT(L"veth9" == veth9.GetName());
+        CPPUNIT_ASSERT( ! veth9.IsIPAddressKnown());
+        CPPUNIT_ASSERT(veth9.GetIPV6Address().empty());
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(3), veth9.GetBytesReceived());
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(10), veth9.GetCollisions());
+
+        // Looking up one interface takes the same two dumps
+        interfaces = NetworkInterfaceInfo::FindAll(deps, true, L"veth9", &counters);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), interfaces.size());
+        CPPUNIT_ASSERT(L"veth9" == interfaces[0].GetName());
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(2), counters.netlinkDumps);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(1), counters.ioctls);
+    }
+
+    void TestNetlinkFailureReadsFile()
+    {
+        SCXHandle<FailingNetlinkNetworkInterfaceDependencies> deps(new FailingNetlinkNetworkInterfaceDependencies(5));
+        NetworkInterfaceRefreshCounters counters;
+        std::vector<NetworkInterfaceInfo> interfaces = NetworkInterfaceInfo::FindAll(deps, true, L"", &counters);
+
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(5), interfaces.size());
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(1), counters.netlinkDumps);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(1), counters.fileReads);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(5 * 9), counters.ioctls);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(deps->GetIoctlCount()), counters.ioctls);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(4), interfaces[4].GetBytesReceived());
+    }
+
+    void TestNetlinkRetriesInterruptedDump()
+    {
+        std::vector<char> messages;
+
+        // The dump is requested again, and only the consistent one is returned
+        InterruptedNetlinkRouteSocket once(1);
+        once.Dump(RTM_GETLINK, AF_UNSPEC, messages);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), once.m_requests);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(NLMSG_SPACE(sizeof(struct ifinfomsg))), messages.size());
+        const struct nlmsghdr *msg = reinterpret_cast<const struct nlmsghdr *>(&messages[0]);
+        CPPUNIT_ASSERT_EQUAL(2, static_cast<const struct ifinfomsg *>(NLMSG_DATA(msg))->ifi_index);
+
+        // A dump that keeps being interrupted fails, so that the caller reads the file instead
+        InterruptedNetlinkRouteSocket always(1000);
+        CPPUNIT_ASSERT_THROW(always.Dump(RTM_GETLINK, AF_UNSPEC, messages), SCXInternalErrorException);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(3), always.m_requests);
+        CPPUNIT_ASSERT(messages.empty());
+    }
+
+    void TestNetlinkMatchesFile()
+    {
+        SCXHandle<NetworkInterfaceDependencies> deps(new NetworkInterfaceDependencies(true));
+        NetworkInterfaceRefreshCounters counters;
+        std::vector<NetworkInterfaceInfo> fromNetlink = NetworkInterfaceInfo::FindAll(deps, true, L"", &counters);
+        if (0 != counters.fileReads)
+        {
+            SCXUNIT_WARNING(L"Netlink lookup of network interfaces not available, TestNetlinkMatchesFile skipped");
+            return;
+        }
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(2), counters.netlinkDumps);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(0), counters.addressLookups);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(fromNetlink.size()), counters.ioctls);
+
+        SCXHandle<NetworkInterfaceDependencies> fileDeps(new FileNetworkInterfaceDependencies());
+        std::vector<NetworkInterfaceInfo> fromFile = NetworkInterfaceInfo::FindAll(fileDeps, true);
+        CPPUNIT_ASSERT_EQUAL(fromFile.size(), fromNetlink.size());
+
+        for (size_t nr = 0; nr < fromFile.size(); nr++)
+        {
+            const NetworkInterfaceInfo &expected = fromFile[nr];
+            size_t found = 0;
+            while (found < fromNetlink.size() && fromNetlink[found].GetName() != expected.GetName())
+            {
+                found++;
+            }
+            std::string name = StrToUTF8(expected.GetName());
+            CPPUNIT_ASSERT_MESSAGE("Not found with netlink: " + name, found < fromNetlink.size());
+            const NetworkInterfaceInfo &actual = fromNetlink[found];
+
+            CPPUNIT_ASSERT_EQUAL_MESSAGE(name, expected.IsUp(), actual.IsUp());
+            CPPUNIT_ASSERT_EQUAL_MESSAGE(name, expected.IsRunning(), actual.IsRunning());
+            CPPUNIT_ASSERT_EQUAL_MESSAGE(name, expected.IsBytesReceivedKnown(), actual.IsBytesReceivedKnown());
+            CPPUNIT_ASSERT_EQUAL_MESSAGE(name, expected.IsIPAddressKnown(), actual.IsIPAddressKnown());
+            if (expected.IsIPAddressKnown())
+            {
+                CPPUNIT_ASSERT_EQUAL_MESSAGE(name, StrToUTF8(expected.GetIPAddress()), StrToUTF8(actual.GetIPAddress()));
+                CPPUNIT_ASSERT_EQUAL_MESSAGE(name, StrToUTF8(expected.GetNetmask()), StrToUTF8(actual.GetNetmask()));
+                CPPUNIT_ASSERT_EQUAL_MESSAGE(name, StrToUTF8(expected.GetBroadcastAddress()), StrToUTF8(actual.GetBroadcastAddress()));
+            }
+            CPPUNIT_ASSERT_MESSAGE(name, expected.GetIPV6Address() == actual.GetIPV6Address());
+
+            scxulong expectedMTU = 0, actualMTU = 0;
+            CPPUNIT_ASSERT_EQUAL_MESSAGE(name, expected.GetMTU(expectedMTU), actual.GetMTU(actualMTU));
+            CPPUNIT_ASSERT_EQUAL_MESSAGE(name, expectedMTU, actualMTU);
+            unsigned int expectedIndex = 0, actualIndex = 0;
+            CPPUNIT_ASSERT_EQUAL_MESSAGE(name, expected.GetInterfaceIndex(expectedIndex), actual.GetInterfaceIndex(actualIndex));
+            CPPUNIT_ASSERT_EQUAL_MESSAGE(name, expectedIndex, actualIndex);
+            wstring expectedMAC, actualMAC;
+            CPPUNIT_ASSERT_EQUAL_MESSAGE(name, expected.GetMACAddressRAW(expectedMAC), actual.GetMACAddressRAW(actualMAC));
+            CPPUNIT_ASSERT_EQUAL_MESSAGE(name, StrToUTF8(expectedMAC), StrToUTF8(actualMAC));
+            unsigned short expectedStatus = 0, actualStatus = 0;
+            CPPUNIT_ASSERT_EQUAL_MESSAGE(name, expected.GetNetConnectionStatus(expectedStatus), actual.GetNetConnectionStatus(actualStatus));
+            CPPUNIT_ASSERT_EQUAL_MESSAGE(name, expectedStatus, actualStatus);
+        }
+    }
+
+    //! Append a running interface to a link dump
+    //! \param[in]  stats   rx/tx packets, rx/tx bytes, rx/tx errors, rx/tx dropped
+    //! \param[in]  is64Bit Report 64-bit statistics (IFLA_STATS64) rather than 32-bit ones (IFLA_STATS)
+    void AddSampledLink(std::vector<char> &links, const char *name, int index, const __u64 stats[8], bool is64Bit = true)
+    {
+        struct ifinfomsg ifi;
+        memset(&ifi, 0, sizeof(ifi));
+        ifi.ifi_index = index;
+        ifi.ifi_type = ARPHRD_ETHER;
+        ifi.ifi_flags = IFF_UP | IFF_RUNNING;
+        size_t msg = FakeNetlinkRouteSocket::AddMessage(links, RTM_NEWLINK, &ifi, sizeof(ifi));
+        FakeNetlinkRouteSocket::AddAttribute(links, msg, IFLA_IFNAME, name, strlen(name) + 1);
+        if (is64Bit)
+        {
+            __u64 stats64[10] = { 0 };
+            memcpy(stats64, stats, 8 * sizeof(__u64));
+            FakeNetlinkRouteSocket::AddAttribute(links, msg, 23 /* IFLA_STATS64 */, stats64, sizeof(stats64));
+        }
+        else
+        {
+            __u32 stats32[23] = { 0 };
+            std::copy(stats, stats + 8, stats32);
+            FakeNetlinkRouteSocket::AddAttribute(links, msg, IFLA_STATS, stats32, sizeof(stats32));
+        }
+    }
+
+    void TestFindAllStatisticsTakesOneDump()
+    {
+        SCXHandle<NetlinkNetworkInterfaceDependencies> deps(new NetlinkNetworkInterfaceDependencies());
+        const __u64 stats[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+        for (int nr = 0; nr < 500; nr++)
+        {
+            AddSampledLink(deps->m_netlink->m_links, ("veth" + StrToUTF8(StrFrom(nr))).c_str(), nr + 2, stats);
+        }
+
+        NetworkInterfaceRefreshCounters counters;
+        std::vector<NetworkInterfaceInfo> interfaces = NetworkInterfaceInfo::FindAllStatistics(deps, &counters);
+
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(500), interfaces.size());
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(1), counters.netlinkDumps);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(0), counters.ioctls);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(0), counters.fileReads);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), deps->m_ioctls);
+
+        const NetworkInterfaceInfo &info = interfaces[0];
+        unsigned int index = 0;
+        CPPUNIT_ASSERT(info.GetInterfaceIndex(index));
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(3), info.GetBytesReceived());
+        CPPUNIT_ASSERT(info.IsKnownIfReceiveDrops());
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(7), info.GetDropsReceiving());
+        CPPUNIT_ASSERT(info.IsKnownIfSendDrops());
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(8), info.GetDropsSending());
+    }
+
+    void TestFileDrops()
+    {
+        SCXHandle<FailingNetlinkNetworkInterfaceDependencies> deps(new FailingNetlinkNetworkInterfaceDependencies(2));
+        std::vector<NetworkInterfaceInfo> interfaces = NetworkInterfaceInfo::FindAllStatistics(deps);
+
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), interfaces.size());
+        CPPUNIT_ASSERT(interfaces[1].IsKnownIfReceiveDrops());
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(4), interfaces[1].GetDropsReceiving());
+        CPPUNIT_ASSERT(interfaces[1].IsKnownIfSendDrops());
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(12), interfaces[1].GetDropsSending());
+    }
+
+    void TestSamplerRates()
+    {
+        SCXHandle<NetlinkNetworkInterfaceDependencies> deps(new NetlinkNetworkInterfaceDependencies());
+        NetworkInterfaceSampler sampler(deps, 1000, 5);
+        NetworkInterfaceRates rates;
+
+        __u64 stats[8] = { 10, 20, 1000, 2000, 0, 0, 0, 0 };
+        for (int nr = 0; nr < 6; nr++)
+        {
+            deps->m_netlink->m_links.clear();
+            AddSampledLink(deps->m_netlink->m_links, "eth0", 2, stats);
+            sampler.Sample(100000 + static_cast<scxulong>(nr) * 1000);
+            if (0 == nr)
+            {
+                CPPUNIT_ASSERT( ! sampler.GetRates(L"eth0", 1000, rates));
+            }
+
+            // Every second there is a thousand more traffic than the second before
+            for (size_t c = 0; c < 8; c++)
+            {
+                stats[c] += 1000 * static_cast<__u64>(1 + nr) * (1 + c % 2);
+            }
+        }
+
+        NetworkInterfaceRefreshCounters counters = sampler.GetLastSampleCounters();
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(1), counters.netlinkDumps);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(0), counters.ioctls);
+
+        // Latest second: 5000 received, 10000 sent
+        CPPUNIT_ASSERT(sampler.GetRates(L"eth0", 1000, rates));
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(1000), rates.windowMs);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(5000.0, rates.bytesReceivedPerSecond, 0.001);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(10000.0, rates.bytesSentPerSecond, 0.001);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(5000.0, rates.packetsReceivedPerSecond, 0.001);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(10000.0, rates.dropsSendingPerSecond, 0.001);
+
+        // Latest three seconds: 3000 + 4000 + 5000 received
+        CPPUNIT_ASSERT(sampler.GetRates(L"eth0", 3000, rates));
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(3000), rates.windowMs);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(4000.0, rates.bytesReceivedPerSecond, 0.001);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(8000.0, rates.errorsSendingPerSecond, 0.001);
+
+        // Longer than the history: limited to the five samples kept
+        CPPUNIT_ASSERT(sampler.GetRates(L"eth0", 60000, rates));
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(4000), rates.windowMs);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(3500.0, rates.bytesReceivedPerSecond, 0.001);
+
+        CPPUNIT_ASSERT( ! sampler.GetRates(L"eth1", 1000, rates));
+    }
+
+    void TestSamplerWrapsAndResets()
+    {
+        SCXHandle<NetlinkNetworkInterfaceDependencies> deps(new NetlinkNetworkInterfaceDependencies());
+        NetworkInterfaceSampler sampler(deps, 1000, 5);
+        NetworkInterfaceRates rates;
+        const __u64 wrap32 = static_cast<__u64>(1) << 32;
+
+        // eth0 reports 32-bit counters, eth1 64-bit ones; bytes received are about to wrap on both
+        __u64 stats32[8] = { 0, 0, wrap32 - 100, 1000, 0, 0, 0, 0 };
+        __u64 stats64[8] = { 0, 0, wrap32 - 100, 1000, 0, 0, 0, 0 };
+        AddSampledLink(deps->m_netlink->m_links, "eth0", 2, stats32, false);
+        AddSampledLink(deps->m_netlink->m_links, "eth1", 3, stats64);
+        sampler.Sample(1000);
+
+        // The 32-bit counter wraps after 300 bytes, the 64-bit one is reset and counts 200;
+        // bytes sent are reset on both and count 50
+        stats32[2] = 200;
+        stats32[3] = 50;
+        stats64[2] = 200;
+        stats64[3] = 50;
+        deps->m_netlink->m_links.clear();
+        AddSampledLink(deps->m_netlink->m_links, "eth0", 2, stats32, false);
+        AddSampledLink(deps->m_netlink->m_links, "eth1", 3, stats64);
+        sampler.Sample(2000);
+
+        CPPUNIT_ASSERT(sampler.GetRates(L"eth0", 1000, rates));
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(300.0, rates.bytesReceivedPerSecond, 0.001);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(50.0, rates.bytesSentPerSecond, 0.001);
+        CPPUNIT_ASSERT(sampler.GetRates(L"eth1", 1000, rates));
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(200.0, rates.bytesReceivedPerSecond, 0.001);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(50.0, rates.bytesSentPerSecond, 0.001);
+
+        // Counting on from there
+        stats32[2] = 400;
+        stats32[3] = 150;
+        stats64[2] = 400;
+        stats64[3] = 150;
+        deps->m_netlink->m_links.clear();
+        AddSampledLink(deps->m_netlink->m_links, "eth0", 2, stats32, false);
+        AddSampledLink(deps->m_netlink->m_links, "eth1", 3, stats64);
+        sampler.Sample(3000);
+
+        CPPUNIT_ASSERT(sampler.GetRates(L"eth0", 2000, rates));
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(250.0, rates.bytesReceivedPerSecond, 0.001);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(75.0, rates.bytesSentPerSecond, 0.001);
+        CPPUNIT_ASSERT(sampler.GetRates(L"eth1", 2000, rates));
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(200.0, rates.bytesReceivedPerSecond, 0.001);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(75.0, rates.bytesSentPerSecond, 0.001);
+    }
+
+    void TestSamplerForgetsInterfaces()
+    {
+        SCXHandle<NetlinkNetworkInterfaceDependencies> deps(new NetlinkNetworkInterfaceDependencies());
+        NetworkInterfaceSampler sampler(deps, 1000, 5);
+        NetworkInterfaceRates rates;
+        const __u64 stats[8] = { 1000, 1000, 1000, 1000, 0, 0, 0, 0 };
+
+        AddSampledLink(deps->m_netlink->m_links, "eth0", 2, stats);
+        AddSampledLink(deps->m_netlink->m_links, "veth0", 3, stats);
+        sampler.Sample(1000);
+        sampler.Sample(2000);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), sampler.GetInterfaceNames().size());
+        CPPUNIT_ASSERT(sampler.GetRates(L"veth0", 1000, rates));
+
+        // veth0 is deleted and created again with another index and smaller counters
+        const __u64 fresh[8] = { 1, 1, 1, 1, 0, 0, 0, 0 };
+        deps->m_netlink->m_links.clear();
+        AddSampledLink(deps->m_netlink->m_links, "eth0", 2, stats);
+        AddSampledLink(deps->m_netlink->m_links, "veth0", 4, fresh);
+        sampler.Sample(3000);
+        CPPUNIT_ASSERT(sampler.GetRates(L"eth0", 1000, rates));
+        CPPUNIT_ASSERT( ! sampler.GetRates(L"veth0", 1000, rates));
+
+        // veth0 is gone
+        deps->m_netlink->m_links.clear();
+        AddSampledLink(deps->m_netlink->m_links, "eth0", 2, stats);
+        sampler.Sample(4000);
+        std::vector<wstring> names = sampler.GetInterfaceNames();
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), names.size());
+        CPPUNIT_ASSERT(L"eth0" == names[0]);
+        CPPUNIT_ASSERT( ! sampler.GetRates(L"veth0", 1000, rates));
+
+        // Back again, it starts over
+        AddSampledLink(deps->m_netlink->m_links, "veth0", 4, fresh);
+        sampler.Sample(5000);
+        CPPUNIT_ASSERT( ! sampler.GetRates(L"veth0", 1000, rates));
+        CPPUNIT_ASSERT(sampler.GetRates(L"eth0", 4000, rates));
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, rates.bytesReceivedPerSecond, 0.001);
+
+        SCXUNIT_ASSERT_THROWN_EXCEPTION(NetworkInterfaceSampler(deps, 0, 5), SCXInvalidArgumentException, L"periodMs");
+        SCXUNIT_ASSERT_THROWN_EXCEPTION(NetworkInterfaceSampler(deps, 1000, 1), SCXInvalidArgumentException, L"maxSamples");
+    }
+
+    void TestSamplerScheduled()
+    {
+        SCXHandle<NetlinkNetworkInterfaceDependencies> deps(new NetlinkNetworkInterfaceDependencies());
+        const __u64 stats[8] = { 0 };
+        AddSampledLink(deps->m_netlink->m_links, "eth0", 2, stats);
+
+        NetworkInterfaceSampler sampler(deps, 50, 5);
+        sampler.Init();
+        for (int wait = 0; wait < 100 && sampler.GetInterfaceNames().empty(); wait++)
+        {
+            SCXThread::Sleep(20);
+        }
+        sampler.CleanUp();
+
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), sampler.GetInterfaceNames().size());
+    }
+#endif
+
     void TestMTU()
     {
         SCXHandle<NetworkInterfaceDependencies> deps(new NetworkInterfaceDependencies());
@@ -8,8 +8,16 @@
 */
 /*----------------------------------------------------------------------------*/
 #include <errno.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/wait.h>
+#include <fcntl.h>
+#if defined(linux)
+#include <malloc.h>
+#endif
+#include <algorithm>
 #include <iostream>
+#include <sstream>
 #include <unistd.h>
 
 // The following two are required by kill(2)
@@ -25,6 +33,7 @@
 
 #include <scxsystemlib/processenumeration.h>
 #include <scxsystemlib/processinstance.h>
+#include <scxsystemlib/processcommandlinepool.h>
 
 #include <scxsystemlib/osenumeration.h>
 #include <scxsystemlib/osinstance.h>
@@ -56,6 +65,18 @@ protected:
     SCXCoreLib::SCXHandle<ProcessEnumeration> m_procEnum;
 };
 
+class ProcessParameters_ThreadParam : public SCXThreadParam
+{
+public:
+    ProcessParameters_ThreadParam(SCXCoreLib::SCXHandle<ProcessInstance> inst)
+        : m_inst(inst), m_ok(false)
+    {
+    }
+
+    SCXCoreLib::SCXHandle<ProcessInstance> m_inst;  //!< Instance to read the parameters of
+    bool m_ok;                                      //!< Were the parameters read?
+};
+
 class TestProcessEnumeration : public ProcessEnumeration
 {
 public:
@@ -151,6 +172,26 @@ class ProcessPAL_Test : public CPPUNIT_NS::TestFixture
     CPPUNIT_TEST( testProcNameWithSpace );
     CPPUNIT_TEST( testSymbolicLinksReturnSymbolicName );
     CPPUNIT_TEST( testProcLister );
+    CPPUNIT_TEST( testTopN );
+    CPPUNIT_TEST( testCommandLinePool );
+#if defined(linux)
+    CPPUNIT_TEST( testParseProcStatBuffer );
+    CPPUNIT_TEST( testParseProcStatBufferRejectsShortContents );
+    CPPUNIT_TEST( testParseProcStatMBuffer );
+    CPPUNIT_TEST( testParseProcStatusBuffer );
+    CPPUNIT_TEST( testParseProcIoBuffer );
+    CPPUNIT_TEST( testParseProcSchedStatBuffer );
+    CPPUNIT_TEST( testSampleDataPerformance );
+    CPPUNIT_TEST( testMemoryFootprint );
+    CPPUNIT_TEST( testIncrementalSampling );
+    CPPUNIT_TEST( testIncrementalSamplingSeesExec );
+    CPPUNIT_TEST( testIoStatistics );
+    CPPUNIT_TEST( testParametersReadOnDemand );
+    CPPUNIT_TEST( testParametersReadConcurrently );
+    CPPUNIT_TEST( testParametersFollowArgumentRewrite );
+    CPPUNIT_TEST( testKeptProcFilesSeeFreshData );
+    CPPUNIT_TEST( testProcReadSyscallsPerSample );
+#endif // defined(linux)
 #if defined(sun) && ((PF_MAJOR > 5) || (PF_MAJOR == 5 && PF_MINOR >= 10))
     CPPUNIT_TEST( testSolaris10_GlobalZone_ProcessInGlobalZone );
     CPPUNIT_TEST( testSolaris10_GlobalZone_ProcessInNonGlobalZone );
@@ -179,6 +220,11 @@ class ProcessPAL_Test : public CPPUNIT_NS::TestFixture
 #endif
     SCXUNIT_TEST_ATTRIBUTE(testProcNameWithSpace, SLOW);
     SCXUNIT_TEST_ATTRIBUTE(testSymbolicLinksReturnSymbolicName, SLOW);
+    SCXUNIT_TEST_ATTRIBUTE(testTopN, SLOW);
+#if defined(linux)
+    SCXUNIT_TEST_ATTRIBUTE(testSampleDataPerformance, SLOW);
+    SCXUNIT_TEST_ATTRIBUTE(testIncrementalSamplingSeesExec, SLOW);
+#endif // defined(linux)
     CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -1454,6 +1500,703 @@ public:
         CPPUNIT_ASSERT(system(cmd.c_str()) == 0);
     }
 
+#if defined(linux)
+    void testParseProcStatBuffer()
+    {
+        // Process name containing parentheses and a space, as seen on SuSE 12
+        const char stat[] =
+            "1234 (my (odd) name) S 1 1234 1234 0 -1 4202752 1500 0 12 0 "
+            "250 75 3 4 20 0 1 0 98765 123456789 345 18446744073709551615 "
+            "4194304 4202500 140736000000000 0 0 0 0 4096 16384 0 0 0 17 3 0 0 "
+            "0 0 0\n";
+
+        LinuxProcStat st;
+        CPPUNIT_ASSERT(st.ParseStatBuffer(stat, sizeof(stat) - 1, "/proc/1234/stat"));
+        CPPUNIT_ASSERT_EQUAL(1234, st.processId);
+        CPPUNIT_ASSERT_EQUAL(string("my (odd) name"), string(st.command));
+        CPPUNIT_ASSERT_EQUAL('S', st.state);
+        CPPUNIT_ASSERT_EQUAL(1, st.parentProcessId);
+        CPPUNIT_ASSERT_EQUAL(-1, st.terminalProcessId);
+        CPPUNIT_ASSERT_EQUAL(12UL, st.majorFaults);
+        CPPUNIT_ASSERT_EQUAL(250UL, st.userTime);
+        CPPUNIT_ASSERT_EQUAL(75UL, st.systemTime);
+        CPPUNIT_ASSERT_EQUAL(20L, st.priority);
+        CPPUNIT_ASSERT_EQUAL(0L, st.nice);
+        CPPUNIT_ASSERT_EQUAL(98765UL, st.startTime);
+        CPPUNIT_ASSERT_EQUAL(123456789UL, st.virtualMemSizeBytes);
+        CPPUNIT_ASSERT_EQUAL(345L, st.residentSetSize);
+        CPPUNIT_ASSERT_EQUAL(17, st.exitSignal);
+        CPPUNIT_ASSERT_EQUAL(3, st.processorNum);
+        CPPUNIT_ASSERT_EQUAL(0UL, st.schedulingPolicy);
+    }
+
+    void testParseProcStatBufferRejectsShortContents()
+    {
+        const char truncated[] = "1234 (name) S 1 1234 1234 0 -1 4202752 1500";
+        LinuxProcStat st;
+        CPPUNIT_ASSERT_THROW(st.ParseStatBuffer(truncated, sizeof(truncated) - 1, "/proc/1234/stat"),
+                             SCXInternalErrorException);
+
+        const char noName[] = "1234 name S 1 1234 1234 0 -1 4202752 1500 0 12 0 250 75";
+        CPPUNIT_ASSERT_THROW(st.ParseStatBuffer(noName, sizeof(noName) - 1, "/proc/1234/stat"),
+                             SCXInternalErrorException);
+    }
+
+    void testParseProcStatMBuffer()
+    {
+        const char statm[] = "5000 345 200 10 0 1200 0\n";
+        LinuxProcStatM sm;
+        CPPUNIT_ASSERT(sm.ParseStatMBuffer(statm, sizeof(statm) - 1, "/proc/1234/statm"));
+        CPPUNIT_ASSERT_EQUAL(5000UL, sm.size);
+        CPPUNIT_ASSERT_EQUAL(345UL, sm.resident);
+        CPPUNIT_ASSERT_EQUAL(200UL, sm.share);
+        CPPUNIT_ASSERT_EQUAL(10UL, sm.text);
+        CPPUNIT_ASSERT_EQUAL(0UL, sm.lib);
+        CPPUNIT_ASSERT_EQUAL(1200UL, sm.data);
+
+        // All zeroes means the process has died
+        const char dead[] = "0 0 0 0 0 0 0\n";
+        CPPUNIT_ASSERT(!sm.ParseStatMBuffer(dead, sizeof(dead) - 1, "/proc/1234/statm"));
+
+        const char shortStatm[] = "5000 345 200\n";
+        CPPUNIT_ASSERT_THROW(sm.ParseStatMBuffer(shortStatm, sizeof(shortStatm) - 1, "/proc/1234/statm"),
+                             SCXInternalErrorException);
+    }
+
+    void testParseProcStatusBuffer()
+    {
+        const char status[] =
+            "Name:\tsshd\n"
+            "State:\tS (sleeping)\n"
+            "Tgid:\t1234\n"
+            "PPid:\t1\n"
+            "TracerPid:\t0\n"
+            "Uid:\t1001\t1002\t1003\t1004\n"
+            "Gid:\t100\t100\t100\t100\n";
+        LinuxProcStatus ps;
+        CPPUNIT_ASSERT(ps.ParseStatusBuffer(status, sizeof(status) - 1));
+        CPPUNIT_ASSERT_EQUAL(static_cast<uid_t>(1001), ps.realUid);
+
+        // Truncated before the Uid line
+        CPPUNIT_ASSERT(!ps.ParseStatusBuffer(status, 30));
+    }
+
+    void testParseProcIoBuffer()
+    {
+        const char io[] =
+            "rchar: 323934931\n"
+            "wchar: 323929600\n"
+            "syscr: 632687\n"
+            "syscw: 632675\n"
+            "read_bytes: 8192\n"
+            "write_bytes: 6000000000\n"
+            "cancelled_write_bytes: 4096\n";
+        LinuxProcIo pio;
+        CPPUNIT_ASSERT(pio.ParseIoBuffer(io, sizeof(io) - 1));
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(632687), pio.readCalls);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(632675), pio.writeCalls);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(8192), pio.readBytes);
+        // More than fits in 32 bits
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(6000) * 1000 * 1000, pio.writeBytes);
+
+        // Truncated before write_bytes
+        CPPUNIT_ASSERT(!pio.ParseIoBuffer(io, 60));
+    }
+
+    void testParseProcSchedStatBuffer()
+    {
+        const char schedstat[] = "1234567890 98765432 4321\n";
+        LinuxProcIo pio;
+        CPPUNIT_ASSERT(pio.ParseSchedStatBuffer(schedstat, sizeof(schedstat) - 1));
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(98765432), pio.runDelay);
+
+        const char shortSchedstat[] = "1234567890\n";
+        CPPUNIT_ASSERT(!pio.ParseSchedStatBuffer(shortSchedstat, sizeof(shortSchedstat) - 1));
+    }
+
+    /**
+       Benchmark: average cost of sampling one process (reading and parsing
+       /proc/#/stat, statm and status), and of parsing a stat buffer alone.
+    */
+    void testSampleDataPerformance()
+    {
+        const int rounds = 20;
+
+        m_procEnum = new ProcessEnumeration();
+        m_procEnum->SampleData();
+
+        SCXCoreLib::TestStopwatch stopwatch;
+        for (int i = 0; i < rounds; i++)
+        {
+            m_procEnum->SampleData();
+        }
+        double usecs = stopwatch.GetElapsedMicroseconds();
+
+        m_procEnum->Update(true);
+        size_t procs = m_procEnum->Size();
+        CPPUNIT_ASSERT(procs > 0);
+        double perProcess = usecs / (static_cast<double>(rounds) * static_cast<double>(procs));
+
+        char stat[1024];
+        int len = snprintf(stat, sizeof(stat),
+                           "1234 (benchmark) S 1 1234 1234 0 -1 4202752 1500 0 12 0 "
+                           "250 75 3 4 20 0 1 0 98765 123456789 345 18446744073709551615 "
+                           "4194304 4202500 140736000000000 0 0 0 0 4096 16384 0 0 0 17 3 0 0 0 0 0\n");
+        const size_t parses = 100000;
+        LinuxProcStat st;
+        stopwatch.Restart();
+        for (size_t i = 0; i < parses; i++)
+        {
+            CPPUNIT_ASSERT(st.ParseStatBuffer(stat, static_cast<size_t>(len), "/proc/1234/stat"));
+        }
+        double parseNs = stopwatch.GetNanosecondsPer(parses);
+
+        std::wostringstream report;
+        report << L"SampleData: " << procs << L" processes, " << perProcess
+               << L" usec per process; stat parse: " << parseNs << L" nsec";
+        SCXCoreLib::TestStopwatch::Report(report.str());
+
+        m_procEnum->SetIncrementalSampling(true);
+        m_procEnum->SampleData();
+        stopwatch.Restart();
+        for (int i = 0; i < rounds; i++)
+        {
+            m_procEnum->SampleData();
+        }
+        double perProcessIncremental = stopwatch.GetElapsedMicroseconds() / (static_cast<double>(rounds) * static_cast<double>(procs));
+
+        report.str(L"");
+        report << L"SampleData: " << perProcessIncremental << L" usec per process incremental";
+        SCXCoreLib::TestStopwatch::Report(report.str());
+    }
+
+    void testMemoryFootprint()
+    {
+        m_procEnum = new ProcessEnumeration();
+        /* No Init(), we do manual updates. */
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+        struct mallinfo2 before = mallinfo2();
+#endif
+        // Fill the sample history of every process
+        for (size_t i = 0; i < MAX_PROCESSINSTANCE_DATASAMPER_SAMPLES; i++)
+        {
+            m_procEnum->SampleData();
+        }
+        m_procEnum->Update(true);
+        size_t procs = m_procEnum->Size();
+        CPPUNIT_ASSERT(procs > 0);
+
+        // No path buffers or per-sampler allocations in the instance
+        CPPUNIT_ASSERT(sizeof(ProcessInstance) < 1024);
+
+        std::wostringstream report;
+        report << L"ProcessInstance: " << sizeof(ProcessInstance) << L" bytes";
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+        // Everything allocated for the processes, the instances and the map included
+        struct mallinfo2 after = mallinfo2();
+        size_t perProcess = (after.uordblks - before.uordblks) / procs;
+        report << L", " << perProcess << L" bytes of heap per process (" << procs << L" processes)";
+#endif
+        SCXCoreLib::TestStopwatch::Report(report.str());
+    }
+
+    void testIncrementalSampling()
+    {
+        m_procEnum = new ProcessEnumeration();
+        /* No Init(), we do manual updates. */
+        CPPUNIT_ASSERT( ! m_procEnum->GetIncrementalSampling());
+        m_procEnum->SetIncrementalSampling(true);
+        CPPUNIT_ASSERT(m_procEnum->GetIncrementalSampling());
+
+        m_procEnum->SampleData();
+        m_procEnum->Update(true);
+        SCXCoreLib::SCXHandle<ProcessInstance> first = FindProcessInstanceFromPID(SCXCoreLib::SCXProcess::GetCurrentProcessID());
+        CPPUNIT_ASSERT(0 != first);
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(0), m_procEnum->m_staticRefreshCount);
+
+        m_procEnum->SampleData();
+        m_procEnum->Update(true);
+        SCXCoreLib::SCXHandle<ProcessInstance> second = FindProcessInstanceFromPID(SCXCoreLib::SCXProcess::GetCurrentProcessID());
+        CPPUNIT_ASSERT(0 != second);
+
+        // A long-lived process keeps its instance and static attributes
+        CPPUNIT_ASSERT(first.GetData() == second.GetData());
+        std::string name;
+        CPPUNIT_ASSERT(second->GetName(name));
+        CPPUNIT_ASSERT_EQUAL(std::string("testrunner"), name);
+        std::vector<std::string> params;
+        CPPUNIT_ASSERT(second->GetParameters(params));
+        scxulong uid = 0;
+        CPPUNIT_ASSERT(second->GetRealUserID(uid));
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(getuid()), uid);
+
+        // Only processes that changed since the first sample re-read their static attributes
+        CPPUNIT_ASSERT(m_procEnum->m_staticRefreshCount < m_procEnum->m_procs.size());
+    }
+
+    void testIncrementalSamplingSeesExec()
+    {
+        m_procEnum = new ProcessEnumeration();
+        /* No Init(), we do manual updates. */
+        m_procEnum->SetIncrementalSampling(true);
+
+        pid_t pid = fork();
+        CPPUNIT_ASSERT(-1 != pid);
+        if (0 == pid) {
+            usleep(500000);
+            execl("/bin/sleep", "sleep", "15", static_cast<char*>(0));
+            exit(0);            // Only reached if exec failed
+        }
+
+        m_procEnum->SampleData();
+        m_procEnum->Update(true);
+        // The command line of the child before the exec is that of the testrunner
+        SCXCoreLib::SCXHandle<ProcessInstance> inst = FindProcessInstanceFromPID(pid);
+        std::vector<std::string> params;
+        CPPUNIT_ASSERT(0 != inst);
+        CPPUNIT_ASSERT(inst->GetParameters(params));
+        CPPUNIT_ASSERT(std::string("sleep") != params[0]);
+
+        SCXCoreLib::SCXThread::Sleep(1500);
+        m_procEnum->SampleData();
+        m_procEnum->Update(true);
+
+        // The command line is read when asked for, so ask while the process is alive
+        inst = FindProcessInstanceFromPID(pid);
+        bool gotParameters = 0 != inst && inst->GetParameters(params);
+        kill(pid, SIGKILL);     // Dispose of test subject
+        waitpid(pid, NULL, 0);
+
+        CPPUNIT_ASSERT(0 != inst);
+        CPPUNIT_ASSERT(gotParameters);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), params.size());
+        CPPUNIT_ASSERT_EQUAL(std::string("sleep"), params[0]);
+        CPPUNIT_ASSERT_EQUAL(std::string("15"), params[1]);
+        CPPUNIT_ASSERT(m_procEnum->m_staticRefreshCount > 0);
+    }
+
+    void testIoStatistics()
+    {
+        m_procEnum = new ProcessEnumeration();
+        /* No Init(), we do manual updates. */
+        CPPUNIT_ASSERT( ! m_procEnum->GetIoStatistics());
+
+        // Not sampled unless selected
+        m_procEnum->SampleData();
+        SCXCoreLib::SCXThread::Sleep(50);
+        m_procEnum->SampleData();
+        m_procEnum->Update(true);
+        SCXCoreLib::SCXHandle<ProcessInstance> inst = FindProcessInstanceFromPID(SCXCoreLib::SCXProcess::GetCurrentProcessID());
+        CPPUNIT_ASSERT(0 != inst);
+        scxulong value = 0;
+        CPPUNIT_ASSERT( ! inst->GetIOWriteCallsPerSecond(value));
+        CPPUNIT_ASSERT( ! inst->GetBlockWritesPerSecond(value));
+        CPPUNIT_ASSERT( ! inst->GetRunDelayPerSecond(value));
+
+        m_procEnum->SetIoStatistics(true);
+        CPPUNIT_ASSERT(m_procEnum->GetIoStatistics());
+        m_procEnum->SampleData();
+        int fd = open("/dev/null", O_WRONLY);
+        CPPUNIT_ASSERT(fd >= 0);
+        for (int i = 0; i < 1000; i++)
+        {
+            CPPUNIT_ASSERT_EQUAL(static_cast<ssize_t>(1), write(fd, "x", 1));
+        }
+        close(fd);
+        SCXCoreLib::SCXThread::Sleep(100);
+        m_procEnum->SampleData();
+        m_procEnum->Update(true);
+
+        // Our own /proc/#/io is always readable
+        CPPUNIT_ASSERT(inst->GetIOWriteCallsPerSecond(value));
+        CPPUNIT_ASSERT(value >= 1000);
+        CPPUNIT_ASSERT(inst->GetIOReadCallsPerSecond(value));
+        CPPUNIT_ASSERT(inst->GetIOReadBytesPerSecond(value));
+        CPPUNIT_ASSERT(inst->GetIOWriteBytesPerSecond(value));
+        CPPUNIT_ASSERT(inst->GetBlockTransfersPerSecond(value));
+        if (0 == access("/proc/self/schedstat", R_OK))
+        {
+            CPPUNIT_ASSERT(inst->GetRunDelayPerSecond(value));
+        }
+
+        // Turning sampling off releases the samples; the getters keep the
+        // values of the latest update until the next one
+        m_procEnum->SetIoStatistics(false);
+        m_procEnum->SampleData();
+        CPPUNIT_ASSERT(inst->GetIOWriteCallsPerSecond(value));
+        CPPUNIT_ASSERT(value >= 1000);
+        m_procEnum->Update(true);
+        CPPUNIT_ASSERT( ! inst->GetIOWriteCallsPerSecond(value));
+    }
+
+    void testParametersReadOnDemand()
+    {
+        ProcessCommandLinePool& pool = ProcessCommandLinePool::Instance();
+        size_t users = pool.GetUserCount();
+
+        m_procEnum = new ProcessEnumeration();
+        /* No Init(), we do manual updates. */
+        m_procEnum->SampleData();
+        m_procEnum->Update(true);
+
+        // Sampling reads no command lines
+        CPPUNIT_ASSERT_EQUAL(users, pool.GetUserCount());
+
+        SCXCoreLib::SCXHandle<ProcessInstance> inst = FindProcessInstanceFromPID(SCXCoreLib::SCXProcess::GetCurrentProcessID());
+        CPPUNIT_ASSERT(0 != inst);
+        std::vector<std::string> params;
+        CPPUNIT_ASSERT(inst->GetParameters(params));
+        CPPUNIT_ASSERT(params[0].find("testrunner") != std::string::npos);
+        CPPUNIT_ASSERT_EQUAL(users + 1, pool.GetUserCount());
+
+        // Read once, however often asked for
+        std::vector<std::string> again;
+        CPPUNIT_ASSERT(inst->GetParameters(again));
+        CPPUNIT_ASSERT(params == again);
+        CPPUNIT_ASSERT_EQUAL(users + 1, pool.GetUserCount());
+
+        // Released with the instances
+        inst = NULL;
+        m_procEnum->CleanUp();
+        m_procEnum = NULL;
+        CPPUNIT_ASSERT_EQUAL(users, pool.GetUserCount());
+    }
+
+    static void readParametersThreadBody(SCXThreadParamHandle& param)
+    {
+        ProcessParameters_ThreadParam* p = static_cast<ProcessParameters_ThreadParam*>(param.GetData());
+        std::vector<std::string> params;
+        p->m_ok = p->m_inst->GetParameters(params) && !params.empty();
+    }
+
+    void testParametersReadConcurrently()
+    {
+        ProcessCommandLinePool& pool = ProcessCommandLinePool::Instance();
+        size_t users = pool.GetUserCount();
+
+        for (int round = 0; round < 20; round++)
+        {
+            m_procEnum = new ProcessEnumeration();
+            /* No Init(), we do manual updates. */
+            m_procEnum->SampleData();
+            m_procEnum->Update(true);
+            SCXCoreLib::SCXHandle<ProcessInstance> inst = FindProcessInstanceFromPID(SCXCoreLib::SCXProcess::GetCurrentProcessID());
+            CPPUNIT_ASSERT(0 != inst);
+
+            // The first reads race; only one command line is kept
+            const size_t cThreads = 4;
+            std::vector<SCXThreadParamHandle> params;
+            std::vector<SCXCoreLib::SCXHandle<SCXThread> > readers;
+            for (size_t nr = 0; nr < cThreads; nr++)
+            {
+                params.push_back(SCXThreadParamHandle(new ProcessParameters_ThreadParam(inst)));
+                readers.push_back(SCXCoreLib::SCXHandle<SCXThread>(new SCXThread(readParametersThreadBody, params.back())));
+            }
+            for (size_t nr = 0; nr < cThreads; nr++)
+            {
+                readers[nr]->Wait();
+                CPPUNIT_ASSERT(static_cast<ProcessParameters_ThreadParam*>(params[nr].GetData())->m_ok);
+            }
+            CPPUNIT_ASSERT_EQUAL(users + 1, pool.GetUserCount());
+
+            inst = NULL;
+            readers.clear();
+            params.clear();
+            m_procEnum->CleanUp();
+            m_procEnum = NULL;
+            CPPUNIT_ASSERT_EQUAL(users, pool.GetUserCount());
+        }
+    }
+
+    /**
+       Overwrites the arguments of the calling process in place, the way
+       setproctitle() does, without calling exec.
+       \param[in] title  The new command line, a single argument
+       \returns    false if the argument area could not be found or is too small
+    */
+    static bool rewriteOwnArguments(const char* title)
+    {
+        char buffer[4096];
+        int fd = open("/proc/self/stat", O_RDONLY);
+        if (fd < 0)
+        {
+            return false;
+        }
+        ssize_t bytes = read(fd, buffer, sizeof(buffer) - 1);
+        close(fd);
+        if (bytes <= 0)
+        {
+            return false;
+        }
+        buffer[bytes] = '\0';
+
+        // arg_start and arg_end are fields 48 and 49; field 3, the state, follows the command name
+        char* pos = strrchr(buffer, ')');
+        if (NULL == pos || strlen(pos) < 4)
+        {
+            return false;
+        }
+        pos += 3;
+        unsigned long argStart = 0;
+        unsigned long argEnd = 0;
+        for (int field = 4; field <= 49; field++)
+        {
+            char* next = NULL;
+            unsigned long value = strtoul(pos, &next, 10);
+            if (next == pos)
+            {
+                return false;
+            }
+            if (48 == field) { argStart = value; }
+            if (49 == field) { argEnd = value; }
+            pos = next;
+        }
+        size_t length = strlen(title) + 1;
+        if (0 == argStart || argEnd < argStart + length)
+        {
+            return false;
+        }
+        char* args = reinterpret_cast<char*>(argStart);
+        memset(args, 0, argEnd - argStart);
+        memcpy(args, title, length);
+        return true;
+    }
+
+    void testParametersFollowArgumentRewrite()
+    {
+        int toChild[2];
+        int toParent[2];
+        CPPUNIT_ASSERT(0 == pipe(toChild));
+        CPPUNIT_ASSERT(0 == pipe(toParent));
+
+        pid_t pid = fork();
+        CPPUNIT_ASSERT(-1 != pid);
+        if (0 == pid) {
+            char c;
+            if (1 == read(toChild[0], &c, 1) && rewriteOwnArguments("worker: idle"))
+            {
+                ssize_t written = write(toParent[1], "x", 1);
+                (void) written;
+                sleep(15);
+            }
+            _exit(0);
+        }
+        close(toChild[0]);
+        close(toParent[1]);
+
+        m_procEnum = new ProcessEnumeration();
+        /* No Init(), we do manual updates. */
+        m_procEnum->SetIncrementalSampling(true);
+        m_procEnum->SampleData();
+        m_procEnum->Update(true);
+        SCXCoreLib::SCXHandle<ProcessInstance> inst = FindProcessInstanceFromPID(pid);
+        std::vector<std::string> before;
+        bool gotBefore = 0 != inst && inst->GetParameters(before);
+
+        // Neither the executable nor the command name changes
+        char c = 'x';
+        bool rewritten = 1 == write(toChild[1], &c, 1) && 1 == read(toParent[0], &c, 1);
+        m_procEnum->SampleData();
+        m_procEnum->Update(true);
+        std::vector<std::string> after;
+        bool gotAfter = 0 != inst && inst->GetParameters(after);
+
+        kill(pid, SIGKILL);     // Dispose of test subject
+        waitpid(pid, NULL, 0);
+        close(toChild[1]);
+        close(toParent[0]);
+
+        CPPUNIT_ASSERT(gotBefore);
+        CPPUNIT_ASSERT(before[0].find("testrunner") != std::string::npos);
+        CPPUNIT_ASSERT(rewritten);
+        CPPUNIT_ASSERT(gotAfter);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), after.size());
+        CPPUNIT_ASSERT_EQUAL(std::string("worker: idle"), after[0]);
+    }
+
+    void testKeptProcFilesSeeFreshData()
+    {
+        m_procEnum = new ProcessEnumeration();
+        /* No Init(), we do manual updates. */
+        m_procEnum->SetIncrementalSampling(true);
+        m_procEnum->SampleData();
+        m_procEnum->Update(true);
+        CPPUNIT_ASSERT(m_procEnum->m_procDir->GetKeptFileCount() > 0);
+
+        SCXCoreLib::SCXHandle<ProcessInstance> inst = FindProcessInstanceFromPID(SCXCoreLib::SCXProcess::GetCurrentProcessID());
+        CPPUNIT_ASSERT(0 != inst);
+        scxulong userBefore = 0, kernelBefore = 0;
+        CPPUNIT_ASSERT(inst->GetUserModeTime(userBefore));
+        CPPUNIT_ASSERT(inst->GetKernelModeTime(kernelBefore));
+
+        // Use some CPU time, more than a few clock ticks
+        SCXCoreLib::TestStopwatch stopwatch;
+        volatile unsigned int spin = 0;
+        do
+        {
+            for (int i = 0; i < 100000; i++) { spin = spin + 1; }
+        } while (stopwatch.GetElapsedMicroseconds() < 200000);
+
+        // Read again through the descriptors kept open
+        m_procEnum->SampleData();
+        m_procEnum->Update(true);
+        scxulong userAfter = 0, kernelAfter = 0;
+        CPPUNIT_ASSERT(inst->GetUserModeTime(userAfter));
+        CPPUNIT_ASSERT(inst->GetKernelModeTime(kernelAfter));
+        CPPUNIT_ASSERT(userAfter + kernelAfter > userBefore + kernelBefore);
+
+        // Given back with the instances
+        m_procEnum->CleanUp();
+        inst = NULL;
+        SCXCoreLib::SCXHandle<ProcDirectory> procDir = m_procEnum->m_procDir;
+        m_procEnum = NULL;
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), procDir->GetKeptFileCount());
+    }
+
+    /** Samples all processes three times, incrementally after the first, and returns the counters of the last sample */
+    ProcReadCounters SampleThreeTimes(size_t maxKeptFiles, size_t& procs)
+    {
+        m_procEnum = new ProcessEnumeration();
+        /* No Init(), we do manual updates. */
+        m_procEnum->m_procDir->SetMaxKeptFiles(maxKeptFiles);
+        m_procEnum->SetIncrementalSampling(true);
+        m_procEnum->SampleData();   // Discovers the processes
+        m_procEnum->SampleData();   // Opens the files to keep open
+        m_procEnum->SampleData();
+        procs = m_procEnum->m_procs.size();
+        ProcReadCounters counters = m_procEnum->GetLastSampleCounters();
+        m_procEnum->CleanUp();
+        m_procEnum = NULL;
+        return counters;
+    }
+
+    void testProcReadSyscallsPerSample()
+    {
+        size_t procs = 0;
+        ProcReadCounters keptOpen = SampleThreeTimes(static_cast<size_t>(-1), procs);
+        CPPUNIT_ASSERT(procs > 0);
+
+        ProcReadCounters lookedUp = SampleThreeTimes(0, procs);
+        CPPUNIT_ASSERT(procs > 0);
+
+        // Looked up each time: openat, pread and close of stat and statm, and fstatat of /proc/#
+        CPPUNIT_ASSERT(lookedUp.opens >= 2 * procs);
+        CPPUNIT_ASSERT_EQUAL(lookedUp.opens, lookedUp.closes);
+        // Kept open: pread of stat and statm, and fstat of /proc/#, plus the occasional static refresh
+        CPPUNIT_ASSERT(keptOpen.reads >= 2 * procs);
+        CPPUNIT_ASSERT(keptOpen.opens < lookedUp.opens);
+        CPPUNIT_ASSERT(keptOpen.GetTotal() < lookedUp.GetTotal());
+
+        // The totals include processes that are never kept, like kernel threads
+        double saved = static_cast<double>(lookedUp.GetTotal() - keptOpen.GetTotal()) / static_cast<double>(procs);
+        std::wostringstream report;
+        report << L"System calls per sample: " << keptOpen.GetTotal()
+               << L" with files kept open, " << lookedUp.GetTotal() << L" otherwise; "
+               << saved << L" fewer per process (" << procs << L" processes)";
+        SCXCoreLib::TestStopwatch::Report(report.str());
+    }
+#endif // defined(linux)
+
+    /** Orders process metrics as ProcessEnumeration::TopN() does */
+    struct RankBy
+    {
+        RankBy(ProcessRankKey key) : m_key(key) {}
+        bool operator()(const ProcessMetrics& a, const ProcessMetrics& b) const
+        {
+            return ProcessEnumeration::RanksHigher(a, b, m_key);
+        }
+        ProcessRankKey m_key;
+    };
+
+    void testTopN()
+    {
+        m_procEnum = new ProcessEnumeration();
+        /* No Init(), we do manual updates. */
+        m_procEnum->SampleData();
+        // Use some CPU, so that there is something to rank by
+        SCXCoreLib::TestStopwatch stopwatch;
+        while (stopwatch.GetElapsedMicroseconds() < 200000)
+        {
+        }
+        m_procEnum->SampleData();
+
+        // The same ranking, by sorting the metrics of every process
+        m_procEnum->Update(true);
+        std::vector<ProcessMetrics> all(m_procEnum->Size());
+        {
+            // GetMetrics() reads the samples, which the enumeration lock protects
+            SCXCoreLib::SCXThreadLock lock(m_procEnum->GetLockHandle());
+            for (size_t i = 0; i < all.size(); i++)
+            {
+                m_procEnum->GetInstance(i)->GetMetrics(all[i]);
+            }
+        }
+
+        const ProcessRankKey keys[] = { eRankByCPUTime, eRankByUsedMemory, eRankByHardPageFaults };
+        for (size_t k = 0; k < sizeof(keys) / sizeof(keys[0]); k++)
+        {
+            std::sort(all.begin(), all.end(), RankBy(keys[k]));
+            std::vector<SCXCoreLib::SCXHandle<ProcessInstance> > top = m_procEnum->TopN(5, keys[k]);
+            CPPUNIT_ASSERT_EQUAL(std::min(static_cast<size_t>(5), all.size()), top.size());
+            for (size_t i = 0; i < top.size(); i++)
+            {
+                CPPUNIT_ASSERT_EQUAL(all[i].pid, top[i]->getpid());
+            }
+        }
+
+        // Ready for use
+        std::vector<SCXCoreLib::SCXHandle<ProcessInstance> > top = m_procEnum->TopN(1, eRankByCPUTime);
+        unsigned int cpu = 0;
+        CPPUNIT_ASSERT(top[0]->GetCPUTime(cpu));
+        CPPUNIT_ASSERT(cpu > 0);
+
+        CPPUNIT_ASSERT(m_procEnum->TopN(0, eRankByUsedMemory).empty());
+        CPPUNIT_ASSERT_EQUAL(all.size(), m_procEnum->TopN(all.size() + 10, eRankByUsedMemory).size());
+    }
+
+    void testCommandLinePool()
+    {
+        ProcessCommandLinePool pool;
+        static const char worker[] = "php-fpm: pool www\0--nodaemonize\0";
+
+        const ProcessCommandLinePool::CommandLine* first = pool.Acquire(worker, sizeof(worker) - 1);
+        CPPUNIT_ASSERT(NULL != first);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), first->size());
+        CPPUNIT_ASSERT_EQUAL(std::string("php-fpm: pool www"), (*first)[0]);
+        CPPUNIT_ASSERT_EQUAL(std::string("--nodaemonize"), (*first)[1]);
+
+        // Identical command lines share one copy, however they are given
+        const ProcessCommandLinePool::CommandLine* unterminated = pool.Acquire(worker, sizeof(worker) - 2);
+        const ProcessCommandLinePool::CommandLine* padded = pool.Acquire("php-fpm: pool www\0--nodaemonize\0\0junk", 37);
+        const ProcessCommandLinePool::CommandLine* copy = pool.Acquire(*first);
+        CPPUNIT_ASSERT(first == unterminated);
+        CPPUNIT_ASSERT(first == padded);
+        CPPUNIT_ASSERT(first == copy);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), pool.GetCount());
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(4), pool.GetUserCount());
+
+        const ProcessCommandLinePool::CommandLine* other = pool.Acquire("nginx: worker process", 21);
+        CPPUNIT_ASSERT(NULL != other && first != other);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), other->size());
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), pool.GetCount());
+
+        // No arguments, nothing to share
+        CPPUNIT_ASSERT(NULL == pool.Acquire("", 0));
+        CPPUNIT_ASSERT(NULL == pool.Acquire(ProcessCommandLinePool::CommandLine()));
+        pool.Release(NULL);
+
+        // Kept until the last user lets go
+        pool.Release(first);
+        pool.Release(unterminated);
+        pool.Release(padded);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), pool.GetCount());
+        CPPUNIT_ASSERT_EQUAL(std::string("--nodaemonize"), (*copy)[1]);
+        pool.Release(copy);
+        pool.Release(other);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), pool.GetCount());
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), pool.GetUserCount());
+    }
+
     // Verify that ProcLister interface returns values close to what 'ps' returns
     void testProcLister()
     {
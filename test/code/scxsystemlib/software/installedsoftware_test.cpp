@@ -13,7 +13,7 @@
 /*----------------------------------------------------------------------------*/
 #include <scxcorelib/scxcmn.h>
 #include <scxcorelib/scxfile.h>
-#if defined(hpux)
+#if defined(hpux) || defined(linux)
 #include <scxcorelib/scxdirectoryinfo.h>
 #endif
 
@@ -24,6 +24,15 @@
 
 #include <stdio.h>
 #include <vector>
+#if defined(linux)
+#include <scxsystemlib/dpkgstatus.h>
+#include <testutils/scxtestutils.h>
+#include <errno.h>
+#include <fstream>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 #include <iostream>
 
@@ -46,6 +55,133 @@ public:
 };
 #endif
 
+#if defined(linux)
+/**
+   Class for injecting a fake rpm executable and database to test the RPM inventory.
+   The fake rpm lists two packages and records each run in a file.
+ */
+class TestRPMSoftwareDependencies : public SoftwareDependencies
+{
+public:
+    TestRPMSoftwareDependencies()
+    {
+        // The full path names the directory as a file; make it a directory path
+        m_dir.SetDirectory(SCXDirectory::CreateTempDirectory().GetFullPath().Get());
+
+        vector<wstring> lines;
+        lines.push_back(L"#!/bin/sh");
+        lines.push_back(L"[ \"$1\" = \"-qa\" ] || exit 1");
+        lines.push_back(L"echo run >> " + GetRunsFile());
+        lines.push_back(L"printf '%s' 'NVRA:foo-1.0-1.x86_64_/=/_Name:foo_/=/_Version:1.0_/=/_Vendor:Foo, Inc._/=/_"
+                        L"Release:1_/=/_InstallTime:1000000000_/=/_SourceRPM:foo-1.0-1.src.rpm_/=/_Summary:The foo tool._/=/_'");
+        lines.push_back(L"printf '%s' 'NVRA:gpg-pubkey-1-2_/=/_Name:gpg-pubkey_/=/_Version:1_/=/_Release:2_/=/_'");
+        SCXFile::WriteAllLines(GetRPMLocation(), lines, ios_base::out);
+        chmod(StrToUTF8(GetRPMLocation()).c_str(), 0755);
+
+        TouchDatabase();
+    }
+
+    ~TestRPMSoftwareDependencies()
+    {
+        SCXDirectory::Delete(m_dir, true);
+    }
+
+    virtual std::wstring GetDPKGStatusLocation()
+    {
+        return m_dir.Get() + L"dpkg_status_none";
+    }
+
+    virtual std::wstring GetRPMLocation()
+    {
+        return m_dir.Get() + L"rpm";
+    }
+
+    virtual std::vector<std::wstring> GetRPMDatabaseFiles()
+    {
+        std::vector<std::wstring> files;
+        files.push_back(m_dir.Get() + L"rpmdb.sqlite");
+        files.push_back(m_dir.Get() + L"Packages");
+        return files;
+    }
+
+    /** Change the database, as installing a package would */
+    void TouchDatabase()
+    {
+        vector<wstring> lines(1, L"package");
+        SCXFile::WriteAllLines(m_dir.Get() + L"Packages", lines, ios_base::out | ios_base::app);
+    }
+
+    /** \returns Number of times the fake rpm ran */
+    size_t GetRunCount()
+    {
+        if (!SCXFile::Exists(GetRunsFile()))
+        {
+            return 0;
+        }
+        vector<wstring> lines;
+        SCXStream::NLFs nlfs;
+        SCXFile::ReadAllLines(GetRunsFile(), lines, nlfs);
+        return lines.size();
+    }
+
+private:
+    wstring GetRunsFile()
+    {
+        return m_dir.Get() + L"runs";
+    }
+
+    SCXFilePath m_dir;
+};
+
+/**
+   dpkg status parser whose first mappings fail
+ */
+class FailingMapDPKGStatus : public DPKGStatus
+{
+public:
+    FailingMapDPKGStatus(size_t failures) : m_failures(failures) { }
+
+protected:
+    virtual void* mmap(void* addr, size_t length, int prot, int flags, int fd, off_t offset)
+    {
+        if (m_failures > 0)
+        {
+            --m_failures;
+            errno = ENOMEM;
+            return MAP_FAILED;
+        }
+        return DPKGStatus::mmap(addr, length, prot, flags, fd, offset);
+    }
+
+private:
+    size_t m_failures;
+};
+#endif
+
+#if defined(PF_DISTRO_ULINUX)
+/**
+   Class for injecting a dpkg status file that a test writes and changes
+ */
+class TestDPKGStatusFileDependencies : public SoftwareDependencies
+{
+public:
+    TestDPKGStatusFileDependencies(const wstring& path) : m_path(path) { }
+
+    virtual std::wstring GetDPKGStatusLocation()
+    {
+        return m_path;
+    }
+
+    virtual std::wstring GetRPMLocation()
+    {
+        return m_path + L"-no-rpm";
+    }
+
+private:
+    wstring m_path;
+};
+#endif
+
 /**
     Class for injecting test behavior into the InstalledSoftware.
  */
@@ -244,14 +380,29 @@ class InstalledSoftware_test : public CPPUNIT_NS::TestFixture
     CPPUNIT_TEST(testDPKGParser_UTF);
 #else
     CPPUNIT_TEST(testInstallDate);
+#endif
+#if defined(linux)
+    CPPUNIT_TEST(testRPMInventoryReadOnceUntilDatabaseChanges);
+    CPPUNIT_TEST(testDPKGStatusStanzas);
+    CPPUNIT_TEST(testDPKGStatusMapFailureNotCached);
+    CPPUNIT_TEST(testDPKGStatusPerformance);
+#endif
+#if defined(PF_DISTRO_ULINUX)
+    CPPUNIT_TEST(testDPKGStatusParsedOnlyWhenChanged);
 #endif
     SCXUNIT_TEST_ATTRIBUTE(testGetSoftwareAttr,SLOW);
+#if defined(linux)
+    SCXUNIT_TEST_ATTRIBUTE(testDPKGStatusPerformance,SLOW);
+#endif
 
     CPPUNIT_TEST_SUITE_END();
 
 public:
 
     InstalledSoftwareEnumeration* m_pEnum;
+#if defined(linux)
+    SCXFilePath m_tempDir;
+#endif
 
     void setUp(void)
     {
@@ -266,8 +417,60 @@ public:
             delete m_pEnum;
             m_pEnum = 0;
         }
+#if defined(linux)
+        if (!m_tempDir.Get().empty())
+        {
+            SCXDirectory::Delete(m_tempDir, true);
+            m_tempDir = SCXFilePath();
+        }
+#endif
     }
 
+#if defined(linux)
+    /** Write a dpkg status file in a temporary directory, and return its path */
+    string WriteStatusFile(const string& contents)
+    {
+        if (m_tempDir.Get().empty())
+        {
+            m_tempDir.SetDirectory(SCXDirectory::CreateTempDirectory().GetFullPath().Get());
+        }
+        string path = StrToUTF8(m_tempDir.Get()) + "status";
+        // Replace the file as dpkg does, by renaming a new one over it
+        string newPath = path + "-new";
+        std::ofstream file(newPath.c_str(), std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+        file << contents;
+        file.close();
+        CPPUNIT_ASSERT_EQUAL(0, rename(newPath.c_str(), path.c_str()));
+        return path;
+    }
+
+    /** Make the contents of a dpkg status file listing some number of installed packages */
+    static string MakeStatusFile(size_t packages)
+    {
+        std::ostringstream contents;
+        for (size_t i = 0; i < packages; i++)
+        {
+            contents << "Package: package" << i << "\n"
+                     << "Status: install ok installed\n"
+                     << "Priority: optional\n"
+                     << "Section: libs\n"
+                     << "Installed-Size: " << 100 + i << "\n"
+                     << "Maintainer: Ubuntu Developers <ubuntu-devel-discuss@lists.ubuntu.com>\n"
+                     << "Architecture: amd64\n"
+                     << "Version: 1." << i << "-0ubuntu1\n"
+                     << "Depends: libc6 (>= 2.14), zlib1g (>= 1:1.1.4)\n"
+                     << "Description: benchmark package " << i << "\n"
+                     << " A package of a generated status file. It has a long description\n"
+                     << " spread over several lines, as most packages do.\n"
+                     << " .\n"
+                     << " The dpkg tools keep all these lines in the status file.\n"
+                     << "Homepage: http://example.com/package" << i << "\n"
+                     << "\n";
+        }
+        return contents.str();
+    }
+#endif
+
     void testGetSoftwareAttr()
     {
 #if defined(PF_DISTRO_REDHAT) || defined(PF_DISTRO_ULINUX) || defined(sun)
@@ -524,6 +727,197 @@ public:
         CPPUNIT_ASSERT_MESSAGE("Failed to retrieve install date of all instances", installDateFoundCount > 0);
     }
 #endif
+
+#if defined(linux)
+    /*
+      The whole RPM inventory is read by one run of rpm, and is read again
+      only when the rpm database changes.
+     */
+    void testRPMInventoryReadOnceUntilDatabaseChanges()
+    {
+        SCXCoreLib::SCXHandle<TestRPMSoftwareDependencies> deps(new TestRPMSoftwareDependencies());
+        InstalledSoftwareDependencies rpmSoftware(deps);
+
+        vector<wstring> ids;
+        rpmSoftware.GetInstalledSoftwareIds(ids);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), ids.size());
+        CPPUNIT_ASSERT_EQUAL(string("foo-1.0-1.x86_64"), StrToUTF8(ids[0]));
+        CPPUNIT_ASSERT_EQUAL(string("gpg-pubkey-1-2"), StrToUTF8(ids[1]));
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), deps->GetRunCount());
+
+        vector<wstring> contents;
+        rpmSoftware.GetSoftwareInfoRawData(ids[0], contents);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(7), contents.size());
+        CPPUNIT_ASSERT_EQUAL(string("Name:foo"), StrToUTF8(contents[0]));
+        CPPUNIT_ASSERT_EQUAL(string("Vendor:Foo, Inc."), StrToUTF8(contents[2]));
+        CPPUNIT_ASSERT_EQUAL(string("Summary:The foo tool."), StrToUTF8(contents[6]));
+
+        contents.clear();
+        rpmSoftware.GetSoftwareInfoRawData(ids[1], contents);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(3), contents.size());
+        CPPUNIT_ASSERT_EQUAL(string("Release:2"), StrToUTF8(contents[2]));
+
+        contents.clear();
+        rpmSoftware.GetSoftwareInfoRawData(L"bar-1.0-1.x86_64", contents);
+        CPPUNIT_ASSERT(contents.empty());
+
+        ids.clear();
+        rpmSoftware.GetInstalledSoftwareIds(ids);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), ids.size());
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), deps->GetRunCount());
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(1), rpmSoftware.GetRPMInventoryQueryCount());
+
+        deps->TouchDatabase();
+        ids.clear();
+        rpmSoftware.GetInstalledSoftwareIds(ids);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), ids.size());
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), deps->GetRunCount());
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(2), rpmSoftware.GetRPMInventoryQueryCount());
+    }
+
+    void testDPKGStatusStanzas()
+    {
+        string path = WriteStatusFile(
+            "Package: zlib1g\n"
+            "Status: install ok installed\n"
+            "Version: 1:1.2.11\n"
+            "Description: compression library\n"
+            " zlib is a library implementing the deflate compression method.\n"
+            "Homepage:   http://zlib.net/  \r\n"
+            "\n"
+            "Package: removed\n"
+            "Status: deinstall ok config-files\n"
+            "Version: 1.0\n"
+            "\n"
+            "Package: bash\n"
+            "Status: install ok installed\n"
+            "Version: 4.0\n"
+            "\n"
+            "Package: bash\n"
+            "Status: install ok installed\n"
+            "Version: 5.0\n"
+            "Section: shells\n"
+            "\n"
+            "Package: last\n"
+            "Status: install ok installed\n"
+            "Version: 2.0");
+
+        DPKGStatus status;
+        CPPUNIT_ASSERT(status.Refresh(path));
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(3), status.GetPackages().size());
+        CPPUNIT_ASSERT(NULL == status.Find("removed"));
+        CPPUNIT_ASSERT(NULL == status.Find("bas"));
+
+        const DPKGStatus::Package* package = status.Find("zlib1g");
+        CPPUNIT_ASSERT(NULL != package);
+        CPPUNIT_ASSERT_EQUAL(string("1:1.2.11"), StrToUTF8(DPKGStatus::ToString(package->version)));
+        CPPUNIT_ASSERT_EQUAL(string("compression library"), StrToUTF8(DPKGStatus::ToString(package->description)));
+        CPPUNIT_ASSERT_EQUAL(string("http://zlib.net/"), StrToUTF8(DPKGStatus::ToString(package->homepage)));
+        CPPUNIT_ASSERT_EQUAL(string(""), StrToUTF8(DPKGStatus::ToString(package->section)));
+
+        package = status.Find("bash");
+        CPPUNIT_ASSERT(NULL != package);
+        CPPUNIT_ASSERT_EQUAL(string("5.0"), StrToUTF8(DPKGStatus::ToString(package->version)));
+        CPPUNIT_ASSERT_EQUAL(string("shells"), StrToUTF8(DPKGStatus::ToString(package->section)));
+
+        package = status.Find("last");
+        CPPUNIT_ASSERT(NULL != package);
+        CPPUNIT_ASSERT_EQUAL(string("2.0"), StrToUTF8(DPKGStatus::ToString(package->version)));
+
+        CPPUNIT_ASSERT(!status.Refresh(path));
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(1), status.GetParseCount());
+
+        CPPUNIT_ASSERT_EQUAL(0, unlink(path.c_str()));
+        CPPUNIT_ASSERT(status.Refresh(path));
+        CPPUNIT_ASSERT(status.GetPackages().empty());
+        CPPUNIT_ASSERT(!status.Refresh(path));
+    }
+
+    /** A status file that cannot be mapped is not taken as parsed and empty */
+    void testDPKGStatusMapFailureNotCached()
+    {
+        string path = WriteStatusFile(MakeStatusFile(3));
+
+        FailingMapDPKGStatus status(2);
+        CPPUNIT_ASSERT(!status.Refresh(path));
+        CPPUNIT_ASSERT(status.GetPackages().empty());
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(0), status.GetParseCount());
+        CPPUNIT_ASSERT(!status.Refresh(path));
+        CPPUNIT_ASSERT(status.GetPackages().empty());
+
+        // The unchanged file is mapped again once mapping works
+        CPPUNIT_ASSERT(status.Refresh(path));
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(3), status.GetPackages().size());
+        CPPUNIT_ASSERT(NULL != status.Find("package1"));
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(1), status.GetParseCount());
+        CPPUNIT_ASSERT(!status.Refresh(path));
+    }
+
+    /**
+       Benchmark: parsing a status file of 10000 packages, refreshing it
+       unchanged, and, for comparison, reading it as wide lines as the
+       parser before did.
+    */
+    void testDPKGStatusPerformance()
+    {
+        const size_t packages = 10000;
+        string path = WriteStatusFile(MakeStatusFile(packages));
+
+        DPKGStatus status;
+        TestStopwatch stopwatch;
+        CPPUNIT_ASSERT(status.Refresh(path));
+        double parseMs = stopwatch.GetElapsedMicroseconds() / 1000.0;
+        CPPUNIT_ASSERT_EQUAL(packages, status.GetPackages().size());
+        CPPUNIT_ASSERT(NULL != status.Find("package9999"));
+
+        const int refreshes = 1000;
+        stopwatch.Restart();
+        for (int i = 0; i < refreshes; i++)
+        {
+            CPPUNIT_ASSERT(!status.Refresh(path));
+        }
+        double refreshUs = stopwatch.GetElapsedMicroseconds() / refreshes;
+
+        stopwatch.Restart();
+        vector<wstring> lines;
+        SCXStream::NLFs nlfs;
+        SCXFile::ReadAllLinesAsUTF8(StrFromUTF8(path), lines, nlfs);
+        double readLinesMs = stopwatch.GetElapsedMicroseconds() / 1000.0;
+        CPPUNIT_ASSERT(lines.size() > packages);
+
+        wostringstream report;
+        report << L"dpkg status of " << packages << L" packages: parse " << parseMs
+               << L" msec, unchanged refresh " << refreshUs << L" usec; reading it as wide lines "
+               << readLinesMs << L" msec";
+        TestStopwatch::Report(report.str());
+    }
+#endif
+
+#if defined(PF_DISTRO_ULINUX)
+    /** The dpkg status file is parsed again only when it changes */
+    void testDPKGStatusParsedOnlyWhenChanged()
+    {
+        SCXCoreLib::SCXHandle<TestDPKGStatusFileDependencies> deps(
+            new TestDPKGStatusFileDependencies(StrFromUTF8(WriteStatusFile(MakeStatusFile(3)))));
+        InstalledSoftwareDependencies dpkgSoftware(deps);
+
+        vector<wstring> ids;
+        dpkgSoftware.GetInstalledSoftwareIds(ids);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(3), ids.size());
+        vector<wstring> contents;
+        dpkgSoftware.GetSoftwareInfoRawData(L"package1", contents);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(5), contents.size());
+        CPPUNIT_ASSERT_EQUAL(string("Version:1.1-0ubuntu1"), StrToUTF8(contents[1]));
+        CPPUNIT_ASSERT_EQUAL(string("Summary:benchmark package 1"), StrToUTF8(contents[4]));
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(1), dpkgSoftware.GetDPKGParseCount());
+
+        WriteStatusFile(MakeStatusFile(4));
+        ids.clear();
+        dpkgSoftware.GetInstalledSoftwareIds(ids);
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(4), ids.size());
+        CPPUNIT_ASSERT_EQUAL(static_cast<scxulong>(2), dpkgSoftware.GetDPKGParseCount());
+    }
+#endif
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION( InstalledSoftware_test );
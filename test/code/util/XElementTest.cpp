@@ -1,5 +1,6 @@
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <unistd.h>
 
 #include <iostream>
 
@@ -51,6 +52,8 @@ class XElementTest : public CPPUNIT_NS::TestFixture
         CPPUNIT_TEST (LoadValidXmlWithCommentsTest);
         CPPUNIT_TEST (LoadXmlStringWithCDATATest);
         CPPUNIT_TEST (LoadXmlWithXmlEntities);
+        CPPUNIT_TEST (LoadAttributesBelongToTheirElement);
+        CPPUNIT_TEST (LoadFromFileDescriptorTest);
         CPPUNIT_TEST (SaveSimpleElementTest);
         CPPUNIT_TEST (SaveElementWithAttributeAndContent);
         CPPUNIT_TEST (ConstructWithInvalidName);
@@ -731,6 +734,42 @@ class XElementTest : public CPPUNIT_NS::TestFixture
             }
 
         }
+        // Each element gets its own attributes only, and namespace prefixes are stripped
+        void LoadAttributesBelongToTheirElement()
+        {
+            XElementPtr root, child;
+            XElement::Load("<a:Test xmlns:a=\"urn:test\" a:Name=\"val0\"><Child Value=\"val1\"/></a:Test>", root);
+
+            CPPUNIT_ASSERT(Utf8String("Test") == root->GetName());
+            NameValuePair rootvalues[1] = { {"Name", "val0"} };
+            ValidateAttributes(root, rootvalues, 1);
+
+            CPPUNIT_ASSERT(root->GetChild("Child", child));
+            std::map<Utf8String, Utf8String> attributes;
+            child->GetAttributeMap(attributes);
+            CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), attributes.size());
+            CPPUNIT_ASSERT(Utf8String("val1") == attributes[Utf8String("Value")]);
+        }
+
+        // Loading from a file descriptor reads the XML a chunk at a time
+        void LoadFromFileDescriptorTest()
+        {
+            std::string xmlString = "<Test Name0=\"val0\"><Test3 Name3=\"Jos\xC3\xA9\">  Content &amp; more</Test3></Test>";
+            int fds[2];
+            CPPUNIT_ASSERT_EQUAL(0, pipe(fds));
+            CPPUNIT_ASSERT_EQUAL(static_cast<ssize_t>(xmlString.size()), write(fds[1], xmlString.data(), xmlString.size()));
+            close(fds[1]);
+
+            XElementPtr root, test3;
+            XElement::Load(fds[0], root);
+            close(fds[0]);
+
+            CPPUNIT_ASSERT(root->GetChild("Test3", test3));
+            NameValuePair test3values[1] = { {"Name3", Utf8String("Jos\xC3\xA9")} };
+            ValidateAttributes(test3, test3values, 1);
+            CPPUNIT_ASSERT_EQUAL(Utf8String("Content & more"), test3->GetContent());
+        }
+
         void MultiThreadedLoadTest()
         {
         }
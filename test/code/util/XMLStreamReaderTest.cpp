@@ -0,0 +1,306 @@
+/*--------------------------------------------------------------------------------
+    Copyright (c) Microsoft Corporation.  All rights reserved.
+
+    Created date    2026-10-17 05:00:00
+
+    XMLStreamReader class unit tests.
+*/
+/*----------------------------------------------------------------------------*/
+
+#include <scxcorelib/scxcmn.h>
+#include <util/XElement.h>
+#include <util/XMLStreamReader.h>
+#include <testutils/scxunit.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using namespace SCX::Util;
+using namespace SCX::Util::Xml;
+using SCXCoreLib::StrSpan;
+
+namespace
+{
+    /** Records the events of a reader as strings */
+    class EventRecorder : public XMLEventHandler
+    {
+    public:
+        virtual void OnStartElement(const StrSpan& name)
+        {
+            m_events.push_back("start " + name.ToString());
+        }
+
+        virtual void OnAttribute(const StrSpan& name, const StrSpan& value)
+        {
+            m_events.push_back("attribute " + name.ToString() + "=" + value.ToString());
+        }
+
+        virtual void OnText(const StrSpan& text)
+        {
+            m_events.push_back("text " + text.ToString());
+        }
+
+        virtual void OnEndElement(const StrSpan& name)
+        {
+            m_events.push_back("end " + name.ToString());
+        }
+
+        std::vector<std::string> m_events;
+    };
+
+    /** Counts the events of a reader */
+    class EventCounter : public XMLEventHandler
+    {
+    public:
+        EventCounter() : m_count(0), m_bytes(0) { }
+
+        virtual void OnStartElement(const StrSpan& name) { m_count++; m_bytes += name.Size(); }
+        virtual void OnAttribute(const StrSpan& name, const StrSpan& value) { m_count++; m_bytes += name.Size() + value.Size(); }
+        virtual void OnText(const StrSpan& text) { m_count++; m_bytes += text.Size(); }
+        virtual void OnEndElement(const StrSpan& name) { m_count++; m_bytes += name.Size(); }
+
+        size_t m_count;
+        size_t m_bytes;
+    };
+
+    /**
+       Parse a document read from a pipe.
+
+       \param[in]  xml        The document; it must fit in the pipe.
+       \param[in]  chunkSize  Bytes to read at a time.
+       \param[out] recorder   Receives the events.
+       \returns    What the reader returned.
+    */
+    bool ParseFromPipe(const std::string& xml, size_t chunkSize, EventRecorder& recorder)
+    {
+        int fds[2];
+        CPPUNIT_ASSERT_EQUAL(0, pipe(fds));
+        CPPUNIT_ASSERT_EQUAL(static_cast<ssize_t>(xml.size()), write(fds[1], xml.data(), xml.size()));
+        close(fds[1]);
+
+        XMLStreamReader reader(recorder);
+        bool result = reader.Parse(fds[0], chunkSize);
+        close(fds[0]);
+        return result;
+    }
+}
+
+class XMLStreamReaderTest : public CPPUNIT_NS::TestFixture
+{
+    CPPUNIT_TEST_SUITE( XMLStreamReaderTest );
+    CPPUNIT_TEST( testEvents );
+    CPPUNIT_TEST( testReferences );
+    CPPUNIT_TEST( testStopsAtEndOfRoot );
+    CPPUNIT_TEST( testMalformed );
+    CPPUNIT_TEST( testChunksMatchBuffer );
+    CPPUNIT_TEST( testLargeDocument );
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    static const char* s_document;
+
+public:
+    void testEvents()
+    {
+        EventRecorder recorder;
+        XMLStreamReader reader(recorder);
+        CPPUNIT_ASSERT(reader.Parse(s_document, strlen(s_document)));
+        CPPUNIT_ASSERT(reader.GetErrorMessage().empty());
+
+        const char* expected[] = {
+            "start p:Root",
+            "attribute xmlns:p=urn:test",
+            "attribute p:Name=Root > 1",
+            "text \n  ",
+            "start Child",
+            "attribute Value=a \"b\"",
+            "end Child",
+            "text \n  ",
+            "text \n  ",
+            "start Text",
+            "text  Jos\xC3\xA9 <&> ",
+            "text <raw & data/>",
+            "end Text",
+            "text \n",
+            "end p:Root"
+        };
+        const size_t count = sizeof(expected) / sizeof(expected[0]);
+        CPPUNIT_ASSERT_EQUAL(count, recorder.m_events.size());
+        for (size_t i = 0; i < count; i++)
+        {
+            CPPUNIT_ASSERT_EQUAL(std::string(expected[i]), recorder.m_events[i]);
+        }
+    }
+
+    void testReferences()
+    {
+        const char* xml = "<a v=\"&#65;&#x42;&#xe9;&#x20AC;&#128512;\">&lt;&gt;&amp;&quot;&apos;&#13;&#x0A;</a>";
+        EventRecorder recorder;
+        XMLStreamReader reader(recorder);
+        CPPUNIT_ASSERT(reader.Parse(xml, strlen(xml)));
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(4), recorder.m_events.size());
+        CPPUNIT_ASSERT_EQUAL(std::string("attribute v=AB\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80"), recorder.m_events[1]);
+        CPPUNIT_ASSERT_EQUAL(std::string("text <>&\"'\r\n"), recorder.m_events[2]);
+    }
+
+    void testStopsAtEndOfRoot()
+    {
+        const char* xml = "\xEF\xBB\xBF <a/> anything <b>";
+        EventRecorder recorder;
+        XMLStreamReader reader(recorder);
+        CPPUNIT_ASSERT(reader.Parse(xml, strlen(xml)));
+        CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), recorder.m_events.size());
+        CPPUNIT_ASSERT_EQUAL(std::string("start a"), recorder.m_events[0]);
+        CPPUNIT_ASSERT_EQUAL(std::string("end a"), recorder.m_events[1]);
+    }
+
+    void testMalformed()
+    {
+        const char* documents[] = {
+            "",
+            "   ",
+            "THIS IS NOT A XML STRING",
+            "<!-- only a comment -->",
+            "<Test>",
+            "<Test",
+            "<Test ada=\"\"><Test1><Test2></Test3></Test1></Test>",
+            "</Test>",
+            "<Test a></Test>",
+            "<Test a=b></Test>",
+            "<Test a=\"b></Test>",
+            "<Test @=\"b\"></Test>",
+            "<Test/ x>",
+            "<Test>&unknown;</Test>",
+            "<Test>&amp</Test>",
+            "<Test>&#ZOO;</Test>",
+            "<Test>&#0;</Test>",
+            "<Test>&#xD800;</Test>",
+            "<Test>&#x110000;</Test>",
+            "<Test a=\"&bad;\"/>",
+            "<Test><!-- unterminated </Test>",
+            "<Test><![CDATA[ unterminated </Test>",
+            "<Test><!BOGUS></Test>",
+            "<![CDATA[x]]><Test/>",
+            "text<Test/>"
+        };
+        for (size_t i = 0; i < sizeof(documents) / sizeof(documents[0]); i++)
+        {
+            EventRecorder recorder;
+            XMLStreamReader reader(recorder);
+            CPPUNIT_ASSERT_MESSAGE(documents[i], ! reader.Parse(documents[i], strlen(documents[i])));
+            CPPUNIT_ASSERT_MESSAGE(documents[i], ! reader.GetErrorMessage().empty());
+
+            EventRecorder pipeRecorder;
+            CPPUNIT_ASSERT_MESSAGE(documents[i], ! ParseFromPipe(documents[i], 1, pipeRecorder));
+        }
+
+        std::string deep;
+        for (size_t i = 0; i <= XMLStreamReader::MAX_NESTED; i++)
+        {
+            deep += "<a>";
+        }
+        EventRecorder recorder;
+        XMLStreamReader reader(recorder);
+        CPPUNIT_ASSERT( ! reader.Parse(deep.data(), deep.size()));
+        CPPUNIT_ASSERT_EQUAL(XMLStreamReader::MAX_NESTED, recorder.m_events.size());
+    }
+
+    /** Every token must come out the same when it is split across reads */
+    void testChunksMatchBuffer()
+    {
+        std::string xml(s_document);
+        EventRecorder expected;
+        XMLStreamReader reader(expected);
+        CPPUNIT_ASSERT(reader.Parse(xml.data(), xml.size()));
+
+        for (size_t chunkSize = 1; chunkSize <= xml.size() + 1; chunkSize++)
+        {
+            EventRecorder recorder;
+            CPPUNIT_ASSERT(ParseFromPipe(xml, chunkSize, recorder));
+            CPPUNIT_ASSERT(expected.m_events == recorder.m_events);
+        }
+    }
+
+    /**
+       A document of many small elements must give the same elements with
+       XMLReader, the way XElement::Load read it, and with XMLStreamReader,
+       and must load into XElements as XElement::Load does now.
+    */
+    void testLargeDocument()
+    {
+        const size_t packages = 2000;
+        std::ostringstream xml;
+        xml << "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<Inventory xmlns:p=\"urn:test\">\n";
+        for (size_t i = 0; i < packages; i++)
+        {
+            xml << "  <p:Package Name=\"package" << i << "\" Version=\"1.0." << i << "\" Arch=\"x86_64\">"
+                << "<Description>Package number " << i << " &amp; friends</Description>"
+                << "<Installed/></p:Package>\n";
+        }
+        xml << "</Inventory>\n";
+        std::string utf8 = xml.str();
+
+        Utf8String text(utf8);
+        XMLReader oldReader;
+        oldReader.XML_Init(true);
+        oldReader.XML_SetText(text);
+        size_t oldStarts = 0;
+        for (;;)
+        {
+            // A new element each time, so attributes do not pile up
+            pCXElement element(new CXElement());
+            if (oldReader.XML_Next(element) != 0)
+            {
+                break;
+            }
+            if (element->GetType() == XML_START)
+            {
+                oldStarts++;
+            }
+        }
+        CPPUNIT_ASSERT( ! oldReader.XML_GetError());
+
+        EventRecorder recorder;
+        XMLStreamReader reader(recorder);
+        CPPUNIT_ASSERT(reader.Parse(utf8.data(), utf8.size()));
+        size_t starts = 0;
+        for (size_t i = 0; i < recorder.m_events.size(); i++)
+        {
+            if (recorder.m_events[i].compare(0, 6, "start ") == 0)
+            {
+                starts++;
+            }
+        }
+        CPPUNIT_ASSERT_EQUAL(1 + 3 * packages, starts);
+        CPPUNIT_ASSERT_EQUAL(oldStarts, starts);
+
+        XElementPtr root;
+        XElement::Load(utf8.data(), utf8.size(), root);
+        XElementList children;
+        root->GetChildren(children);
+        CPPUNIT_ASSERT_EQUAL(packages, children.size());
+
+        std::string value;
+        CPPUNIT_ASSERT(children[packages - 1]->GetAttributeValue("Name", value));
+        CPPUNIT_ASSERT_EQUAL(std::string("package1999"), value);
+        XElementPtr description;
+        CPPUNIT_ASSERT(children[packages - 1]->GetChild("Description", description));
+        std::string content;
+        description->GetContent(content);
+        CPPUNIT_ASSERT_EQUAL(std::string("Package number 1999 & friends"), content);
+    }
+};
+
+const char* XMLStreamReaderTest::s_document =
+    "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+    "<!DOCTYPE Root>\n"
+    "<!-- before the root -->\n"
+    "<p:Root xmlns:p=\"urn:test\" p:Name='Root > 1'>\n"
+    "  <Child Value=\"a &quot;b&quot;\" />\n"
+    "  <!-- a comment -->\n"
+    "  <Text> Jos\xC3\xA9 &lt;&amp;&gt; <![CDATA[<raw & data/>]]></Text>\n"
+    "</p:Root>\n";
+
+CPPUNIT_TEST_SUITE_REGISTRATION( XMLStreamReaderTest );